@@ -205,6 +205,12 @@ public:
    */
   virtual std::chrono::milliseconds fileFlushIntervalMsec() const PURE;
 
+  /**
+   * @return uint32_t the size in bytes of the per-thread access log ring buffers. Zero means
+   *         access log files use a single locked buffer and a flush thread per file.
+   */
+  virtual uint32_t fileFlushRingBufferBytes() const PURE;
+
   /**
    * @return const std::string& the server's cluster.
    */
@@ -94,6 +94,14 @@ public:
    * @return the max depth used when verifying the certificate-chain
    */
   virtual absl::optional<uint32_t> maxVerifyDepth() const PURE;
+
+  /**
+   * @return the configuration of the cache of successful certificate chain verifications, if
+   * enabled.
+   */
+  virtual const absl::optional<envoy::extensions::transport_sockets::tls::v3::
+                                   CertificateValidationContext::VerificationCache>&
+  verificationCache() const PURE;
 };
 
 using CertificateValidationContextConfigPtr = std::unique_ptr<CertificateValidationContextConfig>;
@@ -113,6 +113,12 @@ public:
    */
   virtual const std::string& tlsKeyLogPath() const PURE;
 
+  /**
+   * @return true if the record layer of connections should be offloaded to the kernel once their
+   *         handshake completes, when the kernel and the negotiated parameters allow it.
+   */
+  virtual bool kernelTlsEnabled() const PURE;
+
   /**
    * @return the access log manager object reference
    */
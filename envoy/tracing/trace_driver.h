@@ -73,6 +73,14 @@ public:
    */
   virtual void setSampled(bool sampled) PURE;
 
+  /**
+   * @return whether tags, logs and the operation set on this span will be reported. Callers may
+   *         skip building tags for a span that is not recording. Spans are recording unless the
+   *         implementation knows that they will not be reported, e.g. because they are not
+   *         sampled; a later call to setSampled() may change the answer.
+   */
+  virtual bool isRecording() const { return true; }
+
   /**
    * Retrieve a key's value from the span's baggage.
    * This baggage data could've been set by this span or any parent spans.
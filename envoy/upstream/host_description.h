@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -15,6 +16,8 @@
 #include "envoy/upstream/outlier_detection.h"
 #include "envoy/upstream/resource_manager.h"
 
+#include "source/common/common/sharded_counter.h"
+
 #include "absl/strings/string_view.h"
 
 namespace Envoy {
@@ -54,6 +57,40 @@ struct HostStats {
   std::vector<std::pair<absl::string_view, Stats::PrimitiveGaugeReference>> gauges() {
     return {ALL_HOST_STATS(IGNORE_PRIMITIVE_COUNTER, PRIMITIVE_GAUGE_NAME_AND_REFERENCE)};
   }
+
+  // Track an active request. Writers should use these rather than rq_active_ directly, so that
+  // the updates are sharded when rq_active_shards_ is set.
+  void incRqActive() { addRqActive(1); }
+  void decRqActive() { addRqActive(-1); }
+
+  // If set, updates of rq_active_ from all workers are accumulated in per-thread shards and only
+  // applied to the gauge in batches, so that rq_active_ lags the exact count by at most
+  // ShardedCounter::maxError().
+  std::unique_ptr<ShardedCounter> rq_active_shards_;
+
+private:
+  void addRqActive(int64_t delta) {
+    if (rq_active_shards_ == nullptr) {
+      if (delta > 0) {
+        rq_active_.add(delta);
+      } else {
+        rq_active_.sub(-delta);
+      }
+      return;
+    }
+    delta = rq_active_shards_->add(delta);
+    if (delta == 0) {
+      return;
+    }
+    // One worker may flush a request's completion before the worker that started it flushes the
+    // start, so the sum of the flushed batches can briefly be negative. It is kept apart from the
+    // gauge, which is set from it clamped at zero.
+    const int64_t flushed = rq_active_flushed_.fetch_add(delta) + delta;
+    rq_active_.set(flushed > 0 ? flushed : 0);
+  }
+
+  // The sum of the batches flushed from rq_active_shards_.
+  std::atomic<int64_t> rq_active_flushed_{0};
 };
 
 /**
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 
@@ -18,6 +19,36 @@ class ConnectionLifetimeCallbacks;
 } // namespace Http
 namespace Upstream {
 
+/**
+ * Receives the response times of requests sent to the hosts chosen by a load balancer, for load
+ * balancers which route on observed latency.
+ */
+class ResponseTimeObserver {
+public:
+  virtual ~ResponseTimeObserver() = default;
+
+  /**
+   * Called on the thread that chose the host once the response from the host is complete.
+   * @param host supplies the host the request was sent to.
+   * @param response_time supplies the time from sending the first byte of the request to receiving
+   *        the last byte of the response.
+   */
+  virtual void onResponseTime(const HostDescription& host,
+                              std::chrono::microseconds response_time) PURE;
+
+  /**
+   * Called on the thread that chose the host when the request to the host timed out or was reset
+   * before the response completed.
+   * @param host supplies the host the request was sent to.
+   * @param elapsed supplies the time from sending the first byte of the request to the failure, or
+   *        zero if nothing was sent.
+   */
+  virtual void onRequestFailure(const HostDescription& host,
+                                std::chrono::microseconds elapsed) PURE;
+};
+
+using ResponseTimeObserverSharedPtr = std::shared_ptr<ResponseTimeObserver>;
+
 /**
  * Context information passed to a load balancer to use when choosing a host. Not all load
  * balancers make use of all context information.
@@ -103,6 +134,14 @@ public:
    * and return the corresponding host directly.
    */
   virtual absl::optional<OverrideHost> overrideHostToSelect() const PURE;
+
+  /**
+   * Called by load balancers which route on observed latency when they choose a host, so that the
+   * response time of the request is reported back to them. Contexts which can not observe response
+   * times ignore this.
+   * @param observer supplies the observer to report the response time to.
+   */
+  virtual void setResponseTimeObserver(ResponseTimeObserverSharedPtr observer) PURE;
 };
 
 /**
@@ -120,6 +120,12 @@ public:
    * @return bool whether redundant key/value pairs is allowed in the request metadata.
    */
   virtual bool allowRedundantKeys() const PURE;
+
+  /*
+   * @return uint32_t the maximum number of subsets that are built on demand when they are first
+   * requested, or 0 if all subsets are built when hosts are updated.
+   */
+  virtual uint32_t maxLazySubsets() const PURE;
 };
 
 } // namespace Upstream
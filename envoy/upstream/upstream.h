@@ -665,6 +665,7 @@ public:
   COUNTER(assignment_timeout_received)                                                             \
   COUNTER(assignment_use_cached)                                                                   \
   COUNTER(update_attempt)                                                                          \
+  COUNTER(update_delta)                                                                            \
   COUNTER(update_empty)                                                                            \
   COUNTER(update_failure)                                                                          \
   COUNTER(update_no_rebuild)                                                                       \
@@ -1177,6 +1178,12 @@ public:
    */
   virtual bool perEndpointStatsEnabled() const PURE;
 
+  /**
+   * @return true if the active request counts of this cluster's hosts should be sharded across
+   *         workers and only read approximately.
+   */
+  virtual bool shardedEndpointRequestCountsEnabled() const PURE;
+
   /**
    * @return std::shared_ptr<UpstreamLocalAddressSelector> as upstream local address selector.
    */
@@ -1209,6 +1216,12 @@ public:
    */
   virtual bool connectionPoolPerDownstreamConnection() const PURE;
 
+  /**
+   * @return whether the workers share their HTTP/2 and HTTP/3 connections to each host, with the
+   *         connections to a host owned by a single worker.
+   */
+  virtual bool sharedHttpConnectionPool() const PURE;
+
   /**
    * @return true if this cluster is configured to ignore hosts for the purpose of load balancing
    * computations until they have been health checked for the first time.
@@ -9,6 +9,7 @@
 #include "source/common/common/lock_guard.h"
 
 #include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_map.h"
 
 namespace Envoy {
 namespace AccessLog {
@@ -34,6 +35,15 @@ AccessLogManagerImpl::createAccessLog(const Filesystem::FilePathAndType& file_in
   if (access_logs_.count(file_name)) {
     return access_logs_[file_name];
   }
+  if (file_flush_ring_buffer_bytes_ > 0) {
+    if (ring_flusher_ == nullptr) {
+      ring_flusher_ = std::make_unique<AccessLogRingFlusher>(
+          api_.threadFactory(), file_flush_interval_msec_, file_stats_);
+    }
+    access_logs_[file_name] = std::make_shared<RingBufferAccessLogFileImpl>(
+        std::move(file), *ring_flusher_, lock_, file_stats_, file_flush_ring_buffer_bytes_);
+    return access_logs_[file_name];
+  }
   access_logs_[file_name] =
       std::make_shared<AccessLogFileImpl>(std::move(file), dispatcher_, lock_, file_stats_,
                                           file_flush_interval_msec_, api_.threadFactory());
@@ -229,5 +239,196 @@ void AccessLogFileImpl::createFlushStructures() {
                                                Thread::Options{"AccessLogFlush"});
 }
 
+AccessLogRingFlusher::AccessLogRingFlusher(Thread::ThreadFactory& thread_factory,
+                                           std::chrono::milliseconds flush_interval_msec,
+                                           AccessLogFileStats& stats)
+    : flush_interval_msec_(flush_interval_msec), stats_(stats),
+      flush_thread_(thread_factory.createThread([this]() -> void { flushThreadFunc(); },
+                                                Thread::Options{"AccessLogFlush"})) {}
+
+AccessLogRingFlusher::~AccessLogRingFlusher() {
+  {
+    Thread::LockGuard lock(lock_);
+    flush_thread_exit_ = true;
+    flush_event_.notifyOne();
+  }
+  flush_thread_->join();
+}
+
+void AccessLogRingFlusher::registerFile(RingBufferAccessLogFileImpl& file) {
+  Thread::LockGuard lock(files_lock_);
+  files_.insert(&file);
+}
+
+void AccessLogRingFlusher::unregisterFile(RingBufferAccessLogFileImpl& file) {
+  // Files are only flushed while holding files_lock_, so once this returns the flush thread is
+  // no longer touching the file.
+  Thread::LockGuard lock(files_lock_);
+  files_.erase(&file);
+}
+
+void AccessLogRingFlusher::wakeUp() {
+  Thread::LockGuard lock(lock_);
+  flush_pending_ = true;
+  flush_event_.notifyOne();
+}
+
+void AccessLogRingFlusher::flushThreadFunc() {
+  while (true) {
+    {
+      Thread::LockGuard lock(lock_);
+      // A spurious wakeup only results in an early flush, so there is no need to loop here.
+      if (!flush_pending_ && !flush_thread_exit_ &&
+          flush_event_.waitFor(lock_, flush_interval_msec_) ==
+              Thread::CondVar::WaitStatus::Timeout) {
+        stats_.flushed_by_timer_.inc();
+      }
+      if (flush_thread_exit_) {
+        return;
+      }
+      flush_pending_ = false;
+    }
+
+    Thread::LockGuard files_lock(files_lock_);
+    for (RingBufferAccessLogFileImpl* file : files_) {
+      file->flushRings();
+    }
+  }
+}
+
+namespace {
+
+std::atomic<uint64_t> next_ring_buffer_file_id{0};
+
+// Matches the flush threshold of AccessLogFileImpl for rings that are large enough.
+constexpr uint64_t RingBufferMinFlushSize = 1024 * 64;
+
+} // namespace
+
+RingBufferAccessLogFileImpl::RingBufferAccessLogFileImpl(Filesystem::FilePtr&& file,
+                                                         AccessLogRingFlusher& flusher,
+                                                         Thread::BasicLockable& lock,
+                                                         AccessLogFileStats& stats,
+                                                         uint64_t ring_buffer_bytes)
+    : id_(next_ring_buffer_file_id++), file_(std::move(file)), flusher_(flusher), file_lock_(lock),
+      stats_(stats), ring_buffer_bytes_(ring_buffer_bytes),
+      wake_threshold_(std::min<uint64_t>(RingBufferMinFlushSize, ring_buffer_bytes / 2)) {
+  auto open_result = file_->open(AccessLogFileImpl::defaultFlags());
+  if (!open_result.return_value_) {
+    throwEnvoyExceptionOrPanic(fmt::format("unable to open file '{}': {}", file_->path(),
+                                           open_result.err_->getErrorDetails()));
+  }
+  flusher_.registerFile(*this);
+}
+
+RingBufferAccessLogFileImpl::~RingBufferAccessLogFileImpl() {
+  flusher_.unregisterFile(*this);
+  flushRings();
+  if (file_->isOpen()) {
+    const Api::IoCallBoolResult result = file_->close();
+    ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
+                                             result.err_->getErrorDetails()));
+  }
+}
+
+AccessLogRingBuffer& RingBufferAccessLogFileImpl::ringForCurrentThread() {
+  static thread_local absl::flat_hash_map<uint64_t, AccessLogRingBuffer*> thread_rings;
+  auto it = thread_rings.find(id_);
+  if (it != thread_rings.end()) {
+    return *it->second;
+  }
+
+  auto ring = std::make_unique<AccessLogRingBuffer>(ring_buffer_bytes_);
+  AccessLogRingBuffer* raw_ring = ring.get();
+  {
+    Thread::LockGuard lock(rings_lock_);
+    rings_.push_back(std::move(ring));
+  }
+  thread_rings.emplace(id_, raw_ring);
+  return *raw_ring;
+}
+
+void RingBufferAccessLogFileImpl::write(absl::string_view data) {
+  AccessLogRingBuffer& ring = ringForCurrentThread();
+  const uint64_t length_before = ring.length();
+  if (!ring.append(data)) {
+    // The flush thread is behind; make sure it is running rather than blocking the writer. Only
+    // the first drop since the last drain wakes it, so that a writer dropping every line under
+    // overload does not take the flusher lock each time. If that wakeup races with a drain the
+    // flush interval still bounds the delay.
+    if (ring.markFull()) {
+      flusher_.wakeUp();
+    }
+    return;
+  }
+  if (length_before < wake_threshold_ && length_before + data.size() >= wake_threshold_) {
+    flusher_.wakeUp();
+  }
+}
+
+void RingBufferAccessLogFileImpl::reopen() {
+  reopen_file_ = true;
+  flusher_.wakeUp();
+}
+
+void RingBufferAccessLogFileImpl::flush() { flushRings(); }
+
+void RingBufferAccessLogFileImpl::flushRings() {
+  Thread::LockGuard flush_lock(flush_lock_);
+
+  {
+    Thread::LockGuard rings_lock(rings_lock_);
+    reported_.resize(rings_.size());
+    for (size_t i = 0; i < rings_.size(); ++i) {
+      // Read the counters before draining so that every reported record has been drained.
+      const uint64_t appended = rings_[i]->recordsAppended();
+      const uint64_t dropped = rings_[i]->recordsDropped();
+      stats_.write_total_buffered_.add(rings_[i]->drain(about_to_write_buffer_));
+      stats_.write_buffered_.add(appended - reported_[i].first);
+      stats_.write_dropped_.add(dropped - reported_[i].second);
+      reported_[i] = {appended, dropped};
+    }
+  }
+
+  if (reopen_file_.exchange(false)) {
+    do_reopen_ = true;
+  }
+  if (do_reopen_) {
+    if (file_->isOpen()) {
+      const Api::IoCallBoolResult result = file_->close();
+      ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
+                                               result.err_->getErrorDetails()));
+    }
+    const Api::IoCallBoolResult open_result = file_->open(AccessLogFileImpl::defaultFlags());
+    if (!open_result.return_value_) {
+      stats_.reopen_failed_.inc();
+    } else {
+      do_reopen_ = false;
+    }
+  }
+
+  if (about_to_write_buffer_.length() > 0) {
+    doWrite(about_to_write_buffer_);
+  }
+}
+
+void RingBufferAccessLogFileImpl::doWrite(Buffer::Instance& buffer) {
+  {
+    Thread::LockGuard lock(file_lock_);
+    for (const Buffer::RawSlice& slice : buffer.getRawSlices()) {
+      absl::string_view data(static_cast<char*>(slice.mem_), slice.len_);
+      const Api::IoCallSizeResult result = file_->write(data);
+      if (result.ok() && result.return_value_ == static_cast<ssize_t>(slice.len_)) {
+        stats_.write_completed_.inc();
+      } else {
+        stats_.write_failed_.inc();
+      }
+    }
+  }
+
+  stats_.write_total_buffered_.sub(buffer.length());
+  buffer.drain(buffer.length());
+}
+
 } // namespace AccessLog
 } // namespace Envoy
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 #include "envoy/access_log/access_log.h"
 #include "envoy/api/api.h"
@@ -9,10 +11,12 @@
 #include "envoy/stats/stats_macros.h"
 #include "envoy/stats/store.h"
 
+#include "source/common/access_log/access_log_ring_buffer.h"
 #include "source/common/buffer/buffer_impl.h"
 #include "source/common/common/logger.h"
 #include "source/common/common/thread.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_map.h"
 
 namespace Envoy {
@@ -22,6 +26,7 @@ namespace Envoy {
   COUNTER(reopen_failed)                                                                           \
   COUNTER(write_buffered)                                                                          \
   COUNTER(write_completed)                                                                         \
+  COUNTER(write_dropped)                                                                           \
   COUNTER(write_failed)                                                                            \
   GAUGE(write_total_buffered, Accumulate)
 
@@ -31,15 +36,18 @@ struct AccessLogFileStats {
 
 namespace AccessLog {
 
+class AccessLogRingFlusher;
+
 class AccessLogManagerImpl : public AccessLogManager, Logger::Loggable<Logger::Id::main> {
 public:
   AccessLogManagerImpl(std::chrono::milliseconds file_flush_interval_msec, Api::Api& api,
                        Event::Dispatcher& dispatcher, Thread::BasicLockable& lock,
-                       Stats::Store& stats_store)
-      : file_flush_interval_msec_(file_flush_interval_msec), api_(api), dispatcher_(dispatcher),
-        lock_(lock), file_stats_{
-                         ACCESS_LOG_FILE_STATS(POOL_COUNTER_PREFIX(stats_store, "filesystem."),
-                                               POOL_GAUGE_PREFIX(stats_store, "filesystem."))} {}
+                       Stats::Store& stats_store, uint32_t file_flush_ring_buffer_bytes = 0)
+      : file_flush_interval_msec_(file_flush_interval_msec),
+        file_flush_ring_buffer_bytes_(file_flush_ring_buffer_bytes), api_(api),
+        dispatcher_(dispatcher), lock_(lock),
+        file_stats_{ACCESS_LOG_FILE_STATS(POOL_COUNTER_PREFIX(stats_store, "filesystem."),
+                                          POOL_GAUGE_PREFIX(stats_store, "filesystem."))} {}
   ~AccessLogManagerImpl() override;
 
   // AccessLog::AccessLogManager
@@ -48,10 +56,13 @@ public:
 
 private:
   const std::chrono::milliseconds file_flush_interval_msec_;
+  const uint32_t file_flush_ring_buffer_bytes_;
   Api::Api& api_;
   Event::Dispatcher& dispatcher_;
   Thread::BasicLockable& lock_;
   AccessLogFileStats file_stats_;
+  // Shared by all ring buffer backed files. Declared before access_logs_ so that it outlives them.
+  std::unique_ptr<AccessLogRingFlusher> ring_flusher_;
   absl::node_hash_map<std::string, AccessLogFileSharedPtr> access_logs_;
 };
 
@@ -81,15 +92,15 @@ public:
   void reopen() override;
   void flush() override;
 
+  // return default flags set which used by open
+  static Filesystem::FlagSet defaultFlags();
+
 private:
   void doWrite(Buffer::Instance& buffer);
   void flushThreadFunc();
   Api::IoCallBoolResult open();
   void createFlushStructures();
 
-  // return default flags set which used by open
-  static Filesystem::FlagSet defaultFlags();
-
   // Minimum size before the flush thread will be told to flush.
   static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
 
@@ -136,5 +147,94 @@ private:
   AccessLogFileStats& stats_;
 };
 
+class RingBufferAccessLogFileImpl;
+
+/**
+ * A single flush thread shared by every RingBufferAccessLogFileImpl of an AccessLogManagerImpl.
+ * The thread wakes up either when a writer's ring crosses the flush threshold or when the flush
+ * interval elapses, and then drains the rings of all registered files.
+ */
+class AccessLogRingFlusher {
+public:
+  AccessLogRingFlusher(Thread::ThreadFactory& thread_factory,
+                       std::chrono::milliseconds flush_interval_msec, AccessLogFileStats& stats);
+  ~AccessLogRingFlusher();
+
+  void registerFile(RingBufferAccessLogFileImpl& file);
+  void unregisterFile(RingBufferAccessLogFileImpl& file);
+
+  /**
+   * Ask the flush thread to drain all files as soon as possible.
+   */
+  void wakeUp();
+
+private:
+  void flushThreadFunc();
+
+  // Held while flushing so that a file cannot be unregistered while it is being drained. Writers
+  // never take it.
+  Thread::MutexBasicLockable files_lock_;
+  absl::flat_hash_set<RingBufferAccessLogFileImpl*> files_ ABSL_GUARDED_BY(files_lock_);
+  // Only held briefly to signal the flush thread.
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar flush_event_;
+  bool flush_pending_ ABSL_GUARDED_BY(lock_){false};
+  bool flush_thread_exit_ ABSL_GUARDED_BY(lock_){false};
+  const std::chrono::milliseconds flush_interval_msec_;
+  AccessLogFileStats& stats_;
+  Thread::ThreadPtr flush_thread_;
+};
+
+/**
+ * An access log file for high write rates from many threads. Each thread appends to its own
+ * lock-free ring buffer, so writers never contend with each other or with the flush thread, and
+ * the rings of all files are drained by one AccessLogRingFlusher instead of a thread per file.
+ * When a writer's ring is full the log line is dropped and counted in write_dropped rather than
+ * blocking the worker.
+ */
+class RingBufferAccessLogFileImpl : public AccessLogFile {
+public:
+  RingBufferAccessLogFileImpl(Filesystem::FilePtr&& file, AccessLogRingFlusher& flusher,
+                              Thread::BasicLockable& lock, AccessLogFileStats& stats,
+                              uint64_t ring_buffer_bytes);
+  ~RingBufferAccessLogFileImpl() override;
+
+  // AccessLog::AccessLogFile
+  void write(absl::string_view data) override;
+  void reopen() override;
+  void flush() override;
+
+  /**
+   * Drain every thread's ring and write the data to disk, reopening the file first if a reopen
+   * was requested. Called from the flush thread and from flush().
+   */
+  void flushRings();
+
+private:
+  AccessLogRingBuffer& ringForCurrentThread();
+  void doWrite(Buffer::Instance& buffer) ABSL_EXCLUSIVE_LOCKS_REQUIRED(flush_lock_);
+
+  // Never reused, so that the thread local ring lookup cannot match a destroyed file that
+  // happened to live at the same address.
+  const uint64_t id_;
+  Filesystem::FilePtr file_;
+  AccessLogRingFlusher& flusher_;
+  Thread::BasicLockable& file_lock_; // See AccessLogFileImpl::file_lock_.
+  AccessLogFileStats& stats_;
+  const uint64_t ring_buffer_bytes_;
+  // A writer wakes the flush thread when its ring grows past this many bytes.
+  const uint64_t wake_threshold_;
+  std::atomic<bool> reopen_file_{false};
+
+  // Acquired in the order flush_lock_, rings_lock_, file_lock_.
+  Thread::MutexBasicLockable flush_lock_; // Serializes consumers of the rings.
+  Thread::MutexBasicLockable rings_lock_; // Only contended when a new thread starts writing.
+  std::vector<AccessLogRingBufferPtr> rings_ ABSL_GUARDED_BY(rings_lock_);
+  // Per ring record counts already published to stats, indexed like rings_.
+  std::vector<std::pair<uint64_t, uint64_t>> reported_ ABSL_GUARDED_BY(flush_lock_);
+  Buffer::OwnedImpl about_to_write_buffer_ ABSL_GUARDED_BY(flush_lock_);
+  bool do_reopen_ ABSL_GUARDED_BY(flush_lock_){false};
+};
+
 } // namespace AccessLog
 } // namespace Envoy
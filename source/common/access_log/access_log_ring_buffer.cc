@@ -0,0 +1,67 @@
+#include "source/common/access_log/access_log_ring_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "source/common/common/assert.h"
+
+#include "absl/numeric/bits.h"
+
+namespace Envoy {
+namespace AccessLog {
+
+AccessLogRingBuffer::AccessLogRingBuffer(uint64_t capacity)
+    : capacity_(absl::bit_ceil(std::max<uint64_t>(capacity, 1))), mask_(capacity_ - 1),
+      data_(new char[capacity_]) {}
+
+bool AccessLogRingBuffer::append(absl::string_view data) {
+  const uint64_t write_pos = write_pos_.load(std::memory_order_relaxed);
+  const uint64_t read_pos = read_pos_.load(std::memory_order_acquire);
+  ASSERT(write_pos - read_pos <= capacity_);
+  if (data.size() > capacity_ - (write_pos - read_pos)) {
+    records_dropped_.store(records_dropped_.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+    return false;
+  }
+
+  const uint64_t offset = write_pos & mask_;
+  const uint64_t first = std::min<uint64_t>(data.size(), capacity_ - offset);
+  memcpy(data_.get() + offset, data.data(), first);
+  if (first < data.size()) {
+    memcpy(data_.get(), data.data() + first, data.size() - first);
+  }
+  write_pos_.store(write_pos + data.size(), std::memory_order_release);
+  records_appended_.store(records_appended_.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+  return true;
+}
+
+uint64_t AccessLogRingBuffer::drain(Buffer::Instance& output) {
+  const uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+  const uint64_t write_pos = write_pos_.load(std::memory_order_acquire);
+  const uint64_t length = write_pos - read_pos;
+  if (length == 0) {
+    return 0;
+  }
+
+  const uint64_t offset = read_pos & mask_;
+  const uint64_t first = std::min<uint64_t>(length, capacity_ - offset);
+  output.add(data_.get() + offset, first);
+  if (first < length) {
+    output.add(data_.get(), length - first);
+  }
+  read_pos_.store(write_pos, std::memory_order_release);
+  full_.store(false, std::memory_order_relaxed);
+  return length;
+}
+
+bool AccessLogRingBuffer::markFull() {
+  if (full_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  full_.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+} // namespace AccessLog
+} // namespace Envoy
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "envoy/buffer/buffer.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace AccessLog {
+
+/**
+ * A bounded single-producer single-consumer byte ring used to hand access log data from one
+ * writing thread to the flush thread without taking a lock. The producer only ever touches
+ * write_pos_ and the consumer only ever touches read_pos_; each side publishes its progress with
+ * release stores and observes the other side's with acquire loads. Records are either appended
+ * in full or not at all, so a full ring never results in a torn log line.
+ */
+class AccessLogRingBuffer {
+public:
+  /**
+   * @param capacity the ring size in bytes. Rounded up to the next power of two.
+   */
+  explicit AccessLogRingBuffer(uint64_t capacity);
+
+  /**
+   * Append data to the ring. Must only be called from the producing thread.
+   * @param data supplies the bytes to append.
+   * @return true if the data was appended, false if there was not enough room for all of it.
+   */
+  bool append(absl::string_view data);
+
+  /**
+   * Move everything currently in the ring into the output buffer. Must only be called by one
+   * consumer at a time.
+   * @param output supplies the buffer to append the ring contents to.
+   * @return uint64_t the number of bytes moved.
+   */
+  uint64_t drain(Buffer::Instance& output);
+
+  /**
+   * @return uint64_t the number of bytes currently in the ring. This is only a snapshot when
+   *         called concurrently with append() or drain().
+   */
+  uint64_t length() const {
+    return write_pos_.load(std::memory_order_acquire) - read_pos_.load(std::memory_order_acquire);
+  }
+
+  uint64_t capacity() const { return capacity_; }
+
+  /**
+   * @return uint64_t the total number of records appended to the ring since construction.
+   */
+  uint64_t recordsAppended() const { return records_appended_.load(std::memory_order_relaxed); }
+
+  /**
+   * @return uint64_t the total number of records rejected because the ring was full.
+   */
+  uint64_t recordsDropped() const { return records_dropped_.load(std::memory_order_relaxed); }
+
+  /**
+   * Mark the ring as full after a rejected append. Must only be called from the producing thread.
+   * The mark is cleared by the next drain().
+   * @return bool true if the ring was not already marked full, i.e. this is the first rejected
+   *         append since the last drain.
+   */
+  bool markFull();
+
+private:
+  static constexpr size_t CacheLineSize = 64;
+
+  const uint64_t capacity_;
+  const uint64_t mask_;
+  const std::unique_ptr<char[]> data_;
+  // Monotonically increasing positions; the ring offset is position & mask_. Kept on separate
+  // cache lines so that the producer and consumer do not false share.
+  alignas(CacheLineSize) std::atomic<uint64_t> write_pos_{0};
+  // Only written by the producer, so they share its cache line. The consumer reads them to
+  // publish stats without the producer touching any process-wide atomic.
+  std::atomic<uint64_t> records_appended_{0};
+  std::atomic<uint64_t> records_dropped_{0};
+  // Set by the producer on the first rejected append and cleared by the consumer on drain.
+  std::atomic<bool> full_{false};
+  alignas(CacheLineSize) std::atomic<uint64_t> read_pos_{0};
+};
+
+using AccessLogRingBufferPtr = std::unique_ptr<AccessLogRingBuffer>;
+
+} // namespace AccessLog
+} // namespace Envoy
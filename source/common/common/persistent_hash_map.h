@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "source/common/common/assert.h"
+
+#include "absl/hash/hash.h"
+#include "absl/numeric/bits.h"
+
+namespace Envoy {
+
+/**
+ * An immutable hash map whose copies share their storage: a hash array mapped trie (HAMT).
+ *
+ * Copying a map is O(1). insert() and erase() leave the map untouched and return a new map which
+ * shares everything but the O(log n) trie nodes on the path to the key with the original. This
+ * makes the map suitable for publishing snapshots of a large, incrementally updated map to other
+ * threads: the nodes of a map are never modified once built, so any number of threads may read a
+ * map while another thread derives new maps from it. Lookups are O(log n) too, with a fan-out of
+ * 32 per trie level.
+ *
+ * Example:
+ *
+ *   PersistentHashMap<std::string, int> a;
+ *   PersistentHashMap<std::string, int> b = a.insert("key", 1);
+ *   EXPECT_EQ(a.find("key"), nullptr);
+ *   EXPECT_EQ(*b.find("key"), 1);
+ */
+template <class Key, class Value, class Hash = absl::Hash<Key>, class KeyEqual = std::equal_to<Key>>
+class PersistentHashMap {
+public:
+  /**
+   * @return the number of entries in the map.
+   */
+  size_t size() const { return size_; }
+
+  /**
+   * @return whether the map has no entries.
+   */
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * @return the value for the key, or nullptr if the map has no entry for the key. The value is
+   *         valid for as long as any map sharing the entry exists.
+   */
+  const Value* find(const Key& key) const {
+    const size_t hash = Hash()(key);
+    const Node* node = root_.get();
+    for (uint32_t shift = 0; node != nullptr; shift += BitsPerLevel) {
+      const Slot* slot = node->slot(hash, shift);
+      if (slot == nullptr) {
+        return nullptr;
+      }
+      if (slot->leaf_ != nullptr) {
+        return slot->leaf_->hash_ == hash ? slot->leaf_->find(key) : nullptr;
+      }
+      node = slot->node_.get();
+    }
+    return nullptr;
+  }
+
+  /**
+   * @return a map with the entries of this map and an entry mapping the key to the value, which
+   *         replaces the entry of this map for the key if there is one.
+   */
+  PersistentHashMap insert(const Key& key, Value value) const {
+    const size_t hash = Hash()(key);
+    bool added = false;
+    PersistentHashMap map;
+    map.root_ = root_ == nullptr
+                    ? Node::create(Slot::leaf(std::make_shared<Leaf>(hash, key, std::move(value))),
+                                   hash, 0)
+                    : Node::insert(*root_, 0, hash, key, std::move(value), added);
+    map.size_ = root_ == nullptr || added ? size_ + 1 : size_;
+    return map;
+  }
+
+  /**
+   * @return a map with the entries of this map except the entry for the key.
+   */
+  PersistentHashMap erase(const Key& key) const {
+    if (root_ == nullptr) {
+      return *this;
+    }
+    bool erased = false;
+    NodeConstSharedPtr root = Node::erase(root_, 0, Hash()(key), key, erased);
+    if (!erased) {
+      return *this;
+    }
+    PersistentHashMap map;
+    map.root_ = std::move(root);
+    map.size_ = size_ - 1;
+    return map;
+  }
+
+  /**
+   * Invokes the callback with the key and the value of each entry of the map, in no particular
+   * order.
+   */
+  template <class Callback> void forEach(const Callback& callback) const {
+    if (root_ != nullptr) {
+      root_->forEach(callback);
+    }
+  }
+
+private:
+  static constexpr uint32_t BitsPerLevel = 5;
+  static constexpr uint32_t LevelMask = (1 << BitsPerLevel) - 1;
+  static constexpr uint32_t HashBits = std::numeric_limits<size_t>::digits;
+
+  // The entries whose keys have the same hash, which is almost always a single one.
+  struct Leaf {
+    Leaf(size_t hash, const Key& key, Value value) : hash_(hash) {
+      entries_.emplace_back(key, std::move(value));
+    }
+
+    const Value* find(const Key& key) const {
+      for (const auto& entry : entries_) {
+        if (KeyEqual()(entry.first, key)) {
+          return &entry.second;
+        }
+      }
+      return nullptr;
+    }
+
+    const size_t hash_;
+    std::vector<std::pair<Key, Value>> entries_;
+  };
+  using LeafConstSharedPtr = std::shared_ptr<const Leaf>;
+
+  struct Node;
+  using NodeConstSharedPtr = std::shared_ptr<const Node>;
+
+  // Either a leaf or a sub-trie.
+  struct Slot {
+    static Slot leaf(LeafConstSharedPtr leaf) { return {std::move(leaf), nullptr}; }
+    static Slot node(NodeConstSharedPtr node) { return {nullptr, std::move(node)}; }
+
+    LeafConstSharedPtr leaf_;
+    NodeConstSharedPtr node_;
+  };
+
+  struct Node {
+    static uint32_t bit(size_t hash, uint32_t shift) {
+      ASSERT(shift < HashBits);
+      return uint32_t(1) << ((hash >> shift) & LevelMask);
+    }
+    size_t index(uint32_t bit) const { return absl::popcount(bitmap_ & (bit - 1)); }
+
+    const Slot* slot(size_t hash, uint32_t shift) const {
+      const uint32_t bit = Node::bit(hash, shift);
+      return (bitmap_ & bit) != 0 ? &slots_[index(bit)] : nullptr;
+    }
+
+    // Creates a node holding a single slot, at the position of the hash.
+    static NodeConstSharedPtr create(Slot slot, size_t hash, uint32_t shift) {
+      auto node = std::make_shared<Node>();
+      node->bitmap_ = bit(hash, shift);
+      node->slots_.push_back(std::move(slot));
+      return node;
+    }
+
+    // Creates the sub-trie holding two leaves with different hashes.
+    static NodeConstSharedPtr split(LeafConstSharedPtr a, LeafConstSharedPtr b, uint32_t shift) {
+      ASSERT(a->hash_ != b->hash_);
+      const uint32_t bit_a = bit(a->hash_, shift);
+      const uint32_t bit_b = bit(b->hash_, shift);
+      if (bit_a == bit_b) {
+        // The hashes only differ at a deeper level. As they differ, this ends before the bits of
+        // the hashes run out.
+        const size_t hash = a->hash_;
+        return create(Slot::node(split(std::move(a), std::move(b), shift + BitsPerLevel)), hash,
+                      shift);
+      }
+      auto node = std::make_shared<Node>();
+      node->bitmap_ = bit_a | bit_b;
+      if (bit_a < bit_b) {
+        node->slots_.push_back(Slot::leaf(std::move(a)));
+        node->slots_.push_back(Slot::leaf(std::move(b)));
+      } else {
+        node->slots_.push_back(Slot::leaf(std::move(b)));
+        node->slots_.push_back(Slot::leaf(std::move(a)));
+      }
+      return node;
+    }
+
+    static NodeConstSharedPtr insert(const Node& node, uint32_t shift, size_t hash, const Key& key,
+                                     Value value, bool& added) {
+      const uint32_t bit = Node::bit(hash, shift);
+      const size_t index = node.index(bit);
+      auto copy = std::make_shared<Node>(node);
+      if ((node.bitmap_ & bit) == 0) {
+        copy->bitmap_ |= bit;
+        copy->slots_.insert(copy->slots_.begin() + index,
+                            Slot::leaf(std::make_shared<Leaf>(hash, key, std::move(value))));
+        added = true;
+        return copy;
+      }
+
+      Slot& slot = copy->slots_[index];
+      if (slot.node_ != nullptr) {
+        slot.node_ = insert(*slot.node_, shift + BitsPerLevel, hash, key, std::move(value), added);
+      } else if (slot.leaf_->hash_ == hash) {
+        auto leaf = std::make_shared<Leaf>(*slot.leaf_);
+        auto it = std::find_if(leaf->entries_.begin(), leaf->entries_.end(),
+                               [&key](const auto& entry) { return KeyEqual()(entry.first, key); });
+        if (it != leaf->entries_.end()) {
+          it->second = std::move(value);
+        } else {
+          leaf->entries_.emplace_back(key, std::move(value));
+          added = true;
+        }
+        slot.leaf_ = std::move(leaf);
+      } else {
+        slot = Slot::node(split(std::move(slot.leaf_),
+                                std::make_shared<Leaf>(hash, key, std::move(value)),
+                                shift + BitsPerLevel));
+        added = true;
+      }
+      return copy;
+    }
+
+    // Returns the node without the entry of the key, or nullptr if the node ends up empty.
+    static NodeConstSharedPtr erase(const NodeConstSharedPtr& node, uint32_t shift, size_t hash,
+                                    const Key& key, bool& erased) {
+      const uint32_t bit = Node::bit(hash, shift);
+      if ((node->bitmap_ & bit) == 0) {
+        return node;
+      }
+      const size_t index = node->index(bit);
+      const Slot& slot = node->slots_[index];
+
+      Slot replacement;
+      if (slot.node_ != nullptr) {
+        NodeConstSharedPtr child = erase(slot.node_, shift + BitsPerLevel, hash, key, erased);
+        if (!erased) {
+          return node;
+        }
+        if (child != nullptr && child->slots_.size() == 1 && child->slots_[0].leaf_ != nullptr) {
+          // Pull the last leaf of the sub-trie up, to keep the trie as shallow as its hashes
+          // allow.
+          replacement = child->slots_[0];
+        } else if (child != nullptr) {
+          replacement = Slot::node(std::move(child));
+        }
+      } else {
+        if (slot.leaf_->hash_ != hash || slot.leaf_->find(key) == nullptr) {
+          return node;
+        }
+        erased = true;
+        if (slot.leaf_->entries_.size() > 1) {
+          auto leaf = std::make_shared<Leaf>(*slot.leaf_);
+          leaf->entries_.erase(
+              std::find_if(leaf->entries_.begin(), leaf->entries_.end(),
+                           [&key](const auto& entry) { return KeyEqual()(entry.first, key); }));
+          replacement = Slot::leaf(std::move(leaf));
+        }
+      }
+
+      const bool remove_slot = replacement.leaf_ == nullptr && replacement.node_ == nullptr;
+      if (remove_slot && node->slots_.size() == 1) {
+        return nullptr;
+      }
+      auto copy = std::make_shared<Node>(*node);
+      if (remove_slot) {
+        copy->bitmap_ &= ~bit;
+        copy->slots_.erase(copy->slots_.begin() + index);
+      } else {
+        copy->slots_[index] = std::move(replacement);
+      }
+      return copy;
+    }
+
+    template <class Callback> void forEach(const Callback& callback) const {
+      for (const Slot& slot : slots_) {
+        if (slot.node_ != nullptr) {
+          slot.node_->forEach(callback);
+        } else {
+          for (const auto& entry : slot.leaf_->entries_) {
+            callback(entry.first, entry.second);
+          }
+        }
+      }
+    }
+
+    // One bit per possible slot of the node, set for the slots which are present.
+    uint32_t bitmap_{};
+    // The present slots, in the order of their bits.
+    std::vector<Slot> slots_;
+  };
+
+  NodeConstSharedPtr root_;
+  size_t size_{};
+};
+
+} // namespace Envoy
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "source/common/common/non_copyable.h"
+
+#include "absl/base/optimization.h"
+
+namespace Envoy {
+
+/**
+ * Accumulates deltas to a counter that is shared by all workers without having every update write
+ * the same cache line. Each thread adds to one of a fixed number of cache-line-aligned shards. Once
+ * the pending delta of a shard reaches the flush threshold, it is moved out of the shard and
+ * returned to the caller, which applies it to the aggregate value (e.g. a gauge or a resource
+ * count). Readers of the aggregate value therefore see an approximation which lags the exact value
+ * by at most maxError().
+ *
+ * For the aggregate value to never go negative, a thread should only remove what it previously
+ * added, which is the case for request and connection counts as they are released by the worker
+ * that acquired them.
+ */
+class ShardedCounter : NonCopyable {
+public:
+  static constexpr uint32_t NumShards = 16;
+
+  /**
+   * @param flush_threshold supplies the magnitude of the pending delta of a shard at which it is
+   *        flushed to the aggregate value. A threshold of 1 flushes every update.
+   */
+  explicit ShardedCounter(uint32_t flush_threshold)
+      : flush_threshold_(flush_threshold > 0 ? flush_threshold : 1) {}
+
+  /**
+   * Adds a delta to the shard of the calling thread.
+   * @return the delta which must be applied to the aggregate value, or 0 if the shard has not
+   *         reached the flush threshold.
+   */
+  int64_t add(int64_t delta) {
+    Shard& shard = shards_[shardIndex()];
+    const int64_t pending = shard.pending_.fetch_add(delta, std::memory_order_relaxed) + delta;
+    if (pending < flush_threshold_ && pending > -flush_threshold_) {
+      return 0;
+    }
+    // Another thread sharing this shard may have added to it in the meantime, in which case its
+    // delta is flushed along with ours.
+    return shard.pending_.exchange(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * @return the sum of the deltas which have not been flushed yet. This is only exact if no other
+   *         thread is adding concurrently, and is meant for tests and for reading the exact value
+   *         when it is needed.
+   */
+  int64_t pending() const {
+    int64_t sum = 0;
+    for (const Shard& shard : shards_) {
+      sum += shard.pending_.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  /**
+   * @return the maximum difference between the aggregate value and the exact value.
+   */
+  uint64_t maxError() const { return NumShards * static_cast<uint64_t>(flush_threshold_ - 1); }
+
+  uint32_t flushThreshold() const { return flush_threshold_; }
+
+  /**
+   * @return the shard used by the calling thread. Threads are assigned shards round robin, so
+   *         that workers do not share a shard unless there are more than NumShards of them.
+   */
+  static uint32_t shardIndex() {
+    static std::atomic<uint32_t> next_index{0};
+    static thread_local const uint32_t index =
+        next_index.fetch_add(1, std::memory_order_relaxed) % NumShards;
+    return index;
+  }
+
+private:
+  struct ABSL_CACHELINE_ALIGNED Shard {
+    std::atomic<int64_t> pending_{0};
+  };
+
+  const int64_t flush_threshold_;
+  std::array<Shard, NumShards> shards_;
+};
+
+} // namespace Envoy
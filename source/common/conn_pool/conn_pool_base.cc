@@ -202,7 +202,7 @@ void ConnPoolImplBase::attachStreamToClient(Envoy::ConnectionPool::ActiveClient&
   state_.incrActiveStreams(1);
   num_active_streams_++;
   host_->stats().rq_total_.inc();
-  host_->stats().rq_active_.inc();
+  host_->stats().incRqActive();
   traffic_stats.upstream_rq_total_.inc();
   traffic_stats.upstream_rq_active_.inc();
   host_->cluster().resourceManager(priority_).requests().inc();
@@ -216,7 +216,7 @@ void ConnPoolImplBase::onStreamClosed(Envoy::ConnectionPool::ActiveClient& clien
   ASSERT(num_active_streams_ > 0);
   state_.decrActiveStreams(1);
   num_active_streams_--;
-  host_->stats().rq_active_.dec();
+  host_->stats().decRqActive();
   host_->cluster().trafficStats()->upstream_rq_active_.dec();
   host_->cluster().resourceManager(priority_).requests().dec();
   // We don't update the capacity for HTTP/3 as the stream count should only
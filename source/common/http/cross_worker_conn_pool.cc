@@ -0,0 +1,538 @@
+#include "source/common/http/cross_worker_conn_pool.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/dump_state_utils.h"
+#include "source/common/http/header_map_impl.h"
+#include "source/common/http/header_utility.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+MetadataMapVector copyMetadataMapVector(const MetadataMapVector& metadata_map_vector) {
+  MetadataMapVector copy;
+  copy.reserve(metadata_map_vector.size());
+  for (const MetadataMapPtr& metadata_map : metadata_map_vector) {
+    copy.push_back(std::make_unique<MetadataMap>(*metadata_map));
+  }
+  return copy;
+}
+
+} // namespace
+
+CrossWorkerStream::CrossWorkerStream(CrossWorkerConnPool& pool, ResponseDecoder& response_decoder,
+                                     ConnectionPool::Callbacks& callbacks)
+    : pool_(&pool), client_dispatcher_(pool.dispatcher_),
+      owner_dispatcher_(pool.owner_dispatcher_), owner_pool_cb_(pool.owner_pool_cb_),
+      client_(*this, response_decoder, callbacks), owner_(*this) {}
+
+void CrossWorkerStream::start(const ConnectionPool::Instance::StreamOptions& options) {
+  postToOwner([options](OwnerStream& owner) { owner.start(options); });
+}
+
+void CrossWorkerStream::detach() {
+  pool_ = nullptr;
+  if (!client_.closed()) {
+    postToOwner([](OwnerStream& owner) { owner.resetStream(StreamResetReason::LocalReset); });
+    client_.close();
+  }
+}
+
+void CrossWorkerStream::postToClient(absl::AnyInvocable<void(ClientStream&)> fn) {
+  client_dispatcher_.post(
+      [self = shared_from_this(), fn = std::move(fn)]() mutable { fn(self->client_); });
+}
+
+void CrossWorkerStream::postToOwner(absl::AnyInvocable<void(OwnerStream&)> fn) {
+  owner_dispatcher_.post(
+      [self = shared_from_this(), fn = std::move(fn)]() mutable { fn(self->owner_); });
+}
+
+void CrossWorkerStream::onClientClosed() {
+  // This may release the last reference to this stream, so it must be the last thing done.
+  if (pool_ != nullptr) {
+    pool_->onStreamClosed(*this);
+  }
+}
+
+void CrossWorkerStream::ClientStream::cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy) {
+  ASSERT(!ready_ && !closed_);
+  parent_.postToOwner([cancel_policy](OwnerStream& owner) { owner.cancel(cancel_policy); });
+  close();
+}
+
+Status CrossWorkerStream::ClientStream::encodeHeaders(const RequestHeaderMap& headers,
+                                                      bool end_stream) {
+  ASSERT(ready_);
+#ifndef ENVOY_ENABLE_UHV
+  // The codec of the owner worker would reject these headers, but only once they get there, so
+  // they are checked here as well to fail the encode as the codec does.
+  RETURN_IF_ERROR(HeaderUtility::checkRequiredRequestHeaders(headers));
+  RETURN_IF_ERROR(HeaderUtility::checkValidRequestHeaders(headers));
+#endif
+  bytes_meter_->addHeaderBytesSent(headers.byteSize());
+  parent_.postToOwner(
+      [headers = createHeaderMap<RequestHeaderMapImpl>(headers), end_stream](OwnerStream& owner) {
+        owner.encodeHeaders(*headers, end_stream);
+      });
+  if (end_stream) {
+    onLocalEndStream();
+  }
+  return okStatus();
+}
+
+void CrossWorkerStream::ClientStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  ASSERT(ready_);
+  bytes_meter_->addWireBytesSent(data.length());
+  auto buffer = std::make_unique<Buffer::OwnedImpl>();
+  buffer->move(data);
+  parent_.postToOwner([buffer = std::move(buffer), end_stream](OwnerStream& owner) {
+    owner.encodeData(*buffer, end_stream);
+  });
+  if (end_stream) {
+    onLocalEndStream();
+  }
+}
+
+void CrossWorkerStream::ClientStream::encodeTrailers(const RequestTrailerMap& trailers) {
+  ASSERT(ready_);
+  parent_.postToOwner(
+      [trailers = createHeaderMap<RequestTrailerMapImpl>(trailers)](OwnerStream& owner) {
+        owner.encodeTrailers(*trailers);
+      });
+  onLocalEndStream();
+}
+
+void CrossWorkerStream::ClientStream::encodeMetadata(const MetadataMapVector& metadata_map_vector) {
+  ASSERT(ready_);
+  parent_.postToOwner(
+      [metadata_map_vector = copyMetadataMapVector(metadata_map_vector)](OwnerStream& owner) {
+        owner.encodeMetadata(metadata_map_vector);
+      });
+}
+
+void CrossWorkerStream::ClientStream::enableTcpTunneling() {
+  parent_.postToOwner([](OwnerStream& owner) { owner.enableTcpTunneling(); });
+}
+
+void CrossWorkerStream::ClientStream::resetStream(StreamResetReason reason) {
+  if (closed_) {
+    return;
+  }
+  parent_.postToOwner([reason](OwnerStream& owner) { owner.resetStream(reason); });
+  // As with the codecs, the reset callbacks run right away for a local reset.
+  closed_ = true;
+  runResetCallbacks(reason);
+  parent_.onClientClosed();
+}
+
+void CrossWorkerStream::ClientStream::readDisable(bool disable) {
+  parent_.postToOwner([disable](OwnerStream& owner) { owner.readDisable(disable); });
+}
+
+void CrossWorkerStream::ClientStream::setFlushTimeout(std::chrono::milliseconds timeout) {
+  parent_.postToOwner([timeout](OwnerStream& owner) { owner.setFlushTimeout(timeout); });
+}
+
+void CrossWorkerStream::ClientStream::onPoolReady(ConnectionSnapshot&& snapshot) {
+  if (closed_) {
+    // The stream was canceled after the owner's pool became ready. The owner resets its stream
+    // once the cancellation gets there.
+    return;
+  }
+  ready_ = true;
+  buffer_limit_ = snapshot.buffer_limit_;
+  connection_info_provider_ = std::make_shared<Network::ConnectionInfoSetterImpl>(
+      snapshot.local_address_, snapshot.remote_address_);
+  if (snapshot.connection_id_.has_value()) {
+    connection_info_provider_->setConnectionID(snapshot.connection_id_.value());
+  }
+  connection_stream_info_ = std::make_unique<StreamInfo::StreamInfoImpl>(
+      parent_.client_dispatcher_.timeSource(), connection_info_provider_);
+  if (snapshot.upstream_timing_.has_value()) {
+    auto upstream_info = std::make_shared<StreamInfo::UpstreamInfoImpl>();
+    upstream_info->upstreamTiming() = snapshot.upstream_timing_.value();
+    upstream_info->setUpstreamNumStreams(snapshot.upstream_num_streams_);
+    connection_stream_info_->setUpstreamInfo(std::move(upstream_info));
+  }
+  callbacks_.onPoolReady(*this, snapshot.host_, *connection_stream_info_, snapshot.protocol_);
+}
+
+void CrossWorkerStream::ClientStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                    absl::string_view failure_reason,
+                                                    Upstream::HostDescriptionConstSharedPtr host) {
+  if (closed_) {
+    return;
+  }
+  close();
+  callbacks_.onPoolFailure(reason, failure_reason, host);
+}
+
+void CrossWorkerStream::ClientStream::onResetStream(StreamResetReason reason,
+                                                    absl::string_view failure_reason) {
+  if (closed_) {
+    return;
+  }
+  response_details_ = std::string(failure_reason);
+  closed_ = true;
+  runResetCallbacks(reason);
+  parent_.onClientClosed();
+}
+
+void CrossWorkerStream::ClientStream::onAboveWriteBufferHighWatermark() {
+  if (!closed_) {
+    runHighWatermarkCallbacks();
+  }
+}
+
+void CrossWorkerStream::ClientStream::onBelowWriteBufferLowWatermark() {
+  if (!closed_) {
+    runLowWatermarkCallbacks();
+  }
+}
+
+void CrossWorkerStream::ClientStream::decode1xxHeaders(ResponseHeaderMapPtr&& headers) {
+  if (!closed_) {
+    response_decoder_.decode1xxHeaders(std::move(headers));
+  }
+}
+
+void CrossWorkerStream::ClientStream::decodeHeaders(ResponseHeaderMapPtr&& headers,
+                                                    bool end_stream) {
+  if (closed_) {
+    return;
+  }
+  bytes_meter_->addHeaderBytesReceived(headers->byteSize());
+  response_decoder_.decodeHeaders(std::move(headers), end_stream);
+  if (end_stream) {
+    onRemoteEndStream();
+  }
+}
+
+void CrossWorkerStream::ClientStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (closed_) {
+    return;
+  }
+  bytes_meter_->addWireBytesReceived(data.length());
+  response_decoder_.decodeData(data, end_stream);
+  if (end_stream) {
+    onRemoteEndStream();
+  }
+}
+
+void CrossWorkerStream::ClientStream::decodeTrailers(ResponseTrailerMapPtr&& trailers) {
+  if (closed_) {
+    return;
+  }
+  response_decoder_.decodeTrailers(std::move(trailers));
+  onRemoteEndStream();
+}
+
+void CrossWorkerStream::ClientStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  if (!closed_) {
+    response_decoder_.decodeMetadata(std::move(metadata_map));
+  }
+}
+
+void CrossWorkerStream::ClientStream::close() {
+  closed_ = true;
+  parent_.onClientClosed();
+}
+
+void CrossWorkerStream::ClientStream::onLocalEndStream() {
+  local_end_stream_ = true;
+  if (remote_end_stream_ && !closed_) {
+    close();
+  }
+}
+
+void CrossWorkerStream::ClientStream::onRemoteEndStream() {
+  // The response decoder may have reset the stream, e.g. if the response completed before the
+  // request did.
+  remote_end_stream_ = true;
+  if (local_end_stream_ && !closed_) {
+    close();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::start(const ConnectionPool::Instance::StreamOptions& options) {
+  self_ = parent_.shared_from_this();
+  ConnectionPool::Instance* pool = (*parent_.owner_pool_cb_)();
+  if (pool == nullptr) {
+    onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                  "no connection pool on the owner worker", nullptr);
+    return;
+  }
+  // The pool may invoke the callbacks inline, in which case it returns nullptr.
+  ConnectionPool::Cancellable* handle = pool->newStream(*this, *this, options);
+  if (handle != nullptr) {
+    handle_ = handle;
+  }
+}
+
+void CrossWorkerStream::OwnerStream::cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy) {
+  if (handle_ != nullptr) {
+    handle_->cancel(cancel_policy);
+    release();
+  } else {
+    // The pool became ready before the cancellation got here.
+    resetStream(StreamResetReason::LocalReset);
+  }
+}
+
+void CrossWorkerStream::OwnerStream::encodeHeaders(const RequestHeaderMap& headers,
+                                                   bool end_stream) {
+  if (encoder_ == nullptr) {
+    return;
+  }
+  const Status status = encoder_->encodeHeaders(headers, end_stream);
+  if (!status.ok()) {
+    ENVOY_LOG(debug, "handed off stream failed to encode headers: {}", status.message());
+    const std::string details(status.message());
+    parent_.postToClient([details](ClientStream& client) {
+      client.onResetStream(StreamResetReason::LocalReset, details);
+    });
+    resetStream(StreamResetReason::LocalReset);
+    return;
+  }
+  if (end_stream) {
+    onLocalEndStream();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (encoder_ == nullptr) {
+    return;
+  }
+  encoder_->encodeData(data, end_stream);
+  if (end_stream) {
+    onLocalEndStream();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::encodeTrailers(const RequestTrailerMap& trailers) {
+  if (encoder_ == nullptr) {
+    return;
+  }
+  encoder_->encodeTrailers(trailers);
+  onLocalEndStream();
+}
+
+void CrossWorkerStream::OwnerStream::encodeMetadata(const MetadataMapVector& metadata_map_vector) {
+  if (encoder_ != nullptr) {
+    encoder_->encodeMetadata(metadata_map_vector);
+  }
+}
+
+void CrossWorkerStream::OwnerStream::enableTcpTunneling() {
+  if (encoder_ != nullptr) {
+    encoder_->enableTcpTunneling();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::resetStream(StreamResetReason reason) {
+  if (handle_ != nullptr) {
+    handle_->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+    release();
+  } else if (encoder_ != nullptr) {
+    // The client has already run its reset callbacks, so the ones of this stream are not needed.
+    Stream& stream = encoder_->getStream();
+    stream.removeCallbacks(*this);
+    encoder_ = nullptr;
+    stream.resetStream(reason);
+    release();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::readDisable(bool disable) {
+  if (encoder_ != nullptr) {
+    encoder_->getStream().readDisable(disable);
+  }
+}
+
+void CrossWorkerStream::OwnerStream::setFlushTimeout(std::chrono::milliseconds timeout) {
+  if (encoder_ != nullptr) {
+    encoder_->getStream().setFlushTimeout(timeout);
+  }
+}
+
+void CrossWorkerStream::OwnerStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                   absl::string_view failure_reason,
+                                                   Upstream::HostDescriptionConstSharedPtr host) {
+  handle_ = nullptr;
+  parent_.postToClient([reason, failure_reason = std::string(failure_reason),
+                        host = std::move(host)](ClientStream& client) {
+    client.onPoolFailure(reason, failure_reason, host);
+  });
+  release();
+}
+
+void CrossWorkerStream::OwnerStream::onPoolReady(RequestEncoder& encoder,
+                                                 Upstream::HostDescriptionConstSharedPtr host,
+                                                 StreamInfo::StreamInfo& info,
+                                                 absl::optional<Protocol> protocol) {
+  handle_ = nullptr;
+  encoder_ = &encoder;
+  Stream& stream = encoder.getStream();
+  stream.addCallbacks(*this);
+
+  // Copies what the client needs, as the connection of this worker must not be touched by the
+  // client. The TLS connection information is left out, as it is not safe to read from another
+  // thread.
+  ConnectionSnapshot snapshot;
+  snapshot.host_ = std::move(host);
+  snapshot.protocol_ = protocol;
+  snapshot.local_address_ = stream.connectionInfoProvider().localAddress();
+  snapshot.remote_address_ = stream.connectionInfoProvider().remoteAddress();
+  snapshot.connection_id_ = info.downstreamAddressProvider().connectionID();
+  if (info.upstreamInfo() != nullptr) {
+    snapshot.upstream_timing_ = info.upstreamInfo()->upstreamTiming();
+    snapshot.upstream_num_streams_ = info.upstreamInfo()->upstreamNumStreams();
+  }
+  snapshot.buffer_limit_ = stream.bufferLimit();
+  parent_.postToClient([snapshot = std::move(snapshot)](ClientStream& client) mutable {
+    client.onPoolReady(std::move(snapshot));
+  });
+}
+
+void CrossWorkerStream::OwnerStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  auto buffer = std::make_unique<Buffer::OwnedImpl>();
+  buffer->move(data);
+  parent_.postToClient([buffer = std::move(buffer), end_stream](ClientStream& client) {
+    client.decodeData(*buffer, end_stream);
+  });
+  if (end_stream) {
+    onRemoteEndStream();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  parent_.postToClient([metadata_map = std::move(metadata_map)](ClientStream& client) mutable {
+    client.decodeMetadata(std::move(metadata_map));
+  });
+}
+
+void CrossWorkerStream::OwnerStream::decode1xxHeaders(ResponseHeaderMapPtr&& headers) {
+  parent_.postToClient([headers = std::move(headers)](ClientStream& client) mutable {
+    client.decode1xxHeaders(std::move(headers));
+  });
+}
+
+void CrossWorkerStream::OwnerStream::decodeHeaders(ResponseHeaderMapPtr&& headers,
+                                                   bool end_stream) {
+  parent_.postToClient([headers = std::move(headers), end_stream](ClientStream& client) mutable {
+    client.decodeHeaders(std::move(headers), end_stream);
+  });
+  if (end_stream) {
+    onRemoteEndStream();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::decodeTrailers(ResponseTrailerMapPtr&& trailers) {
+  parent_.postToClient([trailers = std::move(trailers)](ClientStream& client) mutable {
+    client.decodeTrailers(std::move(trailers));
+  });
+  onRemoteEndStream();
+}
+
+void CrossWorkerStream::OwnerStream::dumpState(std::ostream& os, int indent_level) const {
+  const char* spaces = spacesForLevel(indent_level);
+  os << spaces << "CrossWorkerStream::OwnerStream " << this << DUMP_MEMBER(local_end_stream_)
+     << DUMP_MEMBER(remote_end_stream_) << "\n";
+}
+
+void CrossWorkerStream::OwnerStream::onResetStream(StreamResetReason reason,
+                                                   absl::string_view failure_reason) {
+  // The stream of the pool is going away.
+  encoder_ = nullptr;
+  parent_.postToClient(
+      [reason, failure_reason = std::string(failure_reason)](ClientStream& client) {
+        client.onResetStream(reason, failure_reason);
+      });
+  release();
+}
+
+void CrossWorkerStream::OwnerStream::onAboveWriteBufferHighWatermark() {
+  parent_.postToClient([](ClientStream& client) { client.onAboveWriteBufferHighWatermark(); });
+}
+
+void CrossWorkerStream::OwnerStream::onBelowWriteBufferLowWatermark() {
+  parent_.postToClient([](ClientStream& client) { client.onBelowWriteBufferLowWatermark(); });
+}
+
+void CrossWorkerStream::OwnerStream::onLocalEndStream() {
+  local_end_stream_ = true;
+  if (remote_end_stream_) {
+    release();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::onRemoteEndStream() {
+  remote_end_stream_ = true;
+  if (local_end_stream_) {
+    release();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::release() {
+  if (encoder_ != nullptr) {
+    encoder_->getStream().removeCallbacks(*this);
+    encoder_ = nullptr;
+  }
+  handle_ = nullptr;
+  // This may release the last reference to the stream, so it must be the last thing done.
+  std::shared_ptr<CrossWorkerStream> self = std::move(self_);
+}
+
+CrossWorkerConnPool::CrossWorkerConnPool(Event::Dispatcher& dispatcher,
+                                         Event::Dispatcher& owner_dispatcher,
+                                         Upstream::HostConstSharedPtr host,
+                                         CrossWorkerStream::OwnerPoolCb owner_pool_cb)
+    : dispatcher_(dispatcher), owner_dispatcher_(owner_dispatcher), host_(std::move(host)),
+      owner_pool_cb_(
+          std::make_shared<const CrossWorkerStream::OwnerPoolCb>(std::move(owner_pool_cb))) {}
+
+CrossWorkerConnPool::~CrossWorkerConnPool() {
+  // Pools are only destroyed with active streams along with the thread local cluster manager, at
+  // which point nothing is waiting for the events of the streams anymore.
+  for (auto& stream : streams_) {
+    stream.second->detach();
+  }
+}
+
+void CrossWorkerConnPool::drainConnections(Envoy::ConnectionPool::DrainBehavior drain_behavior) {
+  // The connections are drained by the owner worker, whose cluster manager gets the same drain
+  // requests as this one.
+  if (drain_behavior == Envoy::ConnectionPool::DrainBehavior::DrainAndDelete) {
+    draining_for_deletion_ = true;
+    checkForIdleAndNotify();
+  }
+}
+
+ConnectionPool::Cancellable* CrossWorkerConnPool::newStream(ResponseDecoder& response_decoder,
+                                                            ConnectionPool::Callbacks& callbacks,
+                                                            const StreamOptions& options) {
+  ASSERT(!draining_for_deletion_);
+  auto stream = std::make_shared<CrossWorkerStream>(*this, response_decoder, callbacks);
+  stream->start(options);
+  ConnectionPool::Cancellable& cancellable = stream->cancellable();
+  streams_.emplace(stream.get(), std::move(stream));
+  return &cancellable;
+}
+
+void CrossWorkerConnPool::onStreamClosed(CrossWorkerStream& stream) {
+  streams_.erase(&stream);
+  checkForIdleAndNotify();
+}
+
+void CrossWorkerConnPool::checkForIdleAndNotify() {
+  if (draining_for_deletion_ && streams_.empty()) {
+    for (const IdleCb& cb : idle_callbacks_) {
+      cb();
+    }
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
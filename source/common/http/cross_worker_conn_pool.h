@@ -0,0 +1,285 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+#include "envoy/http/conn_pool.h"
+#include "envoy/stream_info/stream_info.h"
+#include "envoy/upstream/upstream.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/http/codec_helper.h"
+#include "source/common/network/socket_impl.h"
+#include "source/common/stream_info/stream_info_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+
+namespace Envoy {
+namespace Http {
+
+class CrossWorkerConnPool;
+
+/**
+ * A stream handed off by a worker to the connection pool of the worker which owns the connections
+ * to its host. The stream has two halves: the client half lives on the worker which created the
+ * stream and is what its router talks to, and the owner half lives on the owner worker and talks
+ * to the stream of the owner's connection pool. Each half is only touched on its own worker, and
+ * the halves post the events of the stream to each other's dispatcher. As posts to a dispatcher
+ * run in order, the events of the stream are delivered in the order they happened.
+ */
+class CrossWorkerStream : public std::enable_shared_from_this<CrossWorkerStream>,
+                          protected Logger::Loggable<Logger::Id::pool> {
+public:
+  // Invoked on the owner worker to get its connection pool for the host of the stream. Returns
+  // nullptr if the owner has no such pool, e.g. because the cluster was removed on it.
+  using OwnerPoolCb = std::function<ConnectionPool::Instance*()>;
+  using OwnerPoolCbSharedPtr = std::shared_ptr<const OwnerPoolCb>;
+
+  CrossWorkerStream(CrossWorkerConnPool& pool, ResponseDecoder& response_decoder,
+                    ConnectionPool::Callbacks& callbacks);
+
+  /**
+   * Starts the stream on the owner worker. Called on the client worker.
+   */
+  void start(const ConnectionPool::Instance::StreamOptions& options);
+
+  /**
+   * Resets the stream from the client worker when its pool is destroyed with the stream still
+   * active. The callbacks of the client are not invoked.
+   */
+  void detach();
+
+  ConnectionPool::Cancellable& cancellable() { return client_; }
+
+private:
+  // What the client worker needs to know about the upstream connection once the stream is ready.
+  struct ConnectionSnapshot {
+    Upstream::HostDescriptionConstSharedPtr host_;
+    absl::optional<Protocol> protocol_;
+    Network::Address::InstanceConstSharedPtr local_address_;
+    Network::Address::InstanceConstSharedPtr remote_address_;
+    absl::optional<uint64_t> connection_id_;
+    absl::optional<StreamInfo::UpstreamTiming> upstream_timing_;
+    uint64_t upstream_num_streams_{};
+    uint32_t buffer_limit_{};
+  };
+
+  /**
+   * The half of the stream on the worker which created it.
+   */
+  class ClientStream : public ConnectionPool::Cancellable,
+                       public RequestEncoder,
+                       public Stream,
+                       public StreamCallbackHelper {
+  public:
+    ClientStream(CrossWorkerStream& parent, ResponseDecoder& response_decoder,
+                 ConnectionPool::Callbacks& callbacks)
+        : parent_(parent), response_decoder_(response_decoder), callbacks_(callbacks) {}
+
+    // ConnectionPool::Cancellable
+    void cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy) override;
+
+    // Http::RequestEncoder
+    Status encodeHeaders(const RequestHeaderMap& headers, bool end_stream) override;
+    void encodeTrailers(const RequestTrailerMap& trailers) override;
+    void enableTcpTunneling() override;
+
+    // Http::StreamEncoder
+    void encodeData(Buffer::Instance& data, bool end_stream) override;
+    Stream& getStream() override { return *this; }
+    void encodeMetadata(const MetadataMapVector& metadata_map_vector) override;
+    Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override { return absl::nullopt; }
+
+    // Http::Stream
+    void addCallbacks(StreamCallbacks& callbacks) override { addCallbacksHelper(callbacks); }
+    void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacksHelper(callbacks); }
+    CodecEventCallbacks*
+    registerCodecEventCallbacks(CodecEventCallbacks* codec_callbacks) override {
+      std::swap(codec_callbacks, codec_callbacks_);
+      return codec_callbacks;
+    }
+    void resetStream(StreamResetReason reason) override;
+    void readDisable(bool disable) override;
+    uint32_t bufferLimit() const override { return buffer_limit_; }
+    absl::string_view responseDetails() override { return response_details_; }
+    const Network::ConnectionInfoProvider& connectionInfoProvider() override {
+      return *connection_info_provider_;
+    }
+    void setFlushTimeout(std::chrono::milliseconds timeout) override;
+    // The account of the client is not passed on to the buffers of the owner worker.
+    Buffer::BufferMemoryAccountSharedPtr account() const override { return account_; }
+    void setAccount(Buffer::BufferMemoryAccountSharedPtr account) override {
+      account_ = std::move(account);
+    }
+    const StreamInfo::BytesMeterSharedPtr& bytesMeter() override { return bytes_meter_; }
+
+    // Events posted by the owner half.
+    void onPoolReady(ConnectionSnapshot&& snapshot);
+    void onPoolFailure(ConnectionPool::PoolFailureReason reason, absl::string_view failure_reason,
+                       Upstream::HostDescriptionConstSharedPtr host);
+    void onResetStream(StreamResetReason reason, absl::string_view failure_reason);
+    void decode1xxHeaders(ResponseHeaderMapPtr&& headers);
+    void decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream);
+    void decodeData(Buffer::Instance& data, bool end_stream);
+    void decodeTrailers(ResponseTrailerMapPtr&& trailers);
+    void decodeMetadata(MetadataMapPtr&& metadata_map);
+    void onAboveWriteBufferHighWatermark();
+    void onBelowWriteBufferLowWatermark();
+
+    // Once closed, nothing is delivered to the callbacks or the response decoder anymore.
+    bool closed() const { return closed_; }
+    void close();
+
+  private:
+    void onLocalEndStream();
+    void onRemoteEndStream();
+
+    CrossWorkerStream& parent_;
+    ResponseDecoder& response_decoder_;
+    ConnectionPool::Callbacks& callbacks_;
+    // Set once the pool is ready.
+    Network::ConnectionInfoSetterSharedPtr connection_info_provider_;
+    std::unique_ptr<StreamInfo::StreamInfoImpl> connection_stream_info_;
+    const StreamInfo::BytesMeterSharedPtr bytes_meter_{std::make_shared<StreamInfo::BytesMeter>()};
+    Buffer::BufferMemoryAccountSharedPtr account_;
+    CodecEventCallbacks* codec_callbacks_{};
+    std::string response_details_;
+    uint32_t buffer_limit_{};
+    bool ready_{};
+    bool remote_end_stream_{};
+    bool closed_{};
+  };
+
+  /**
+   * The half of the stream on the owner worker.
+   */
+  class OwnerStream : public ResponseDecoder,
+                      public StreamCallbacks,
+                      public ConnectionPool::Callbacks {
+  public:
+    explicit OwnerStream(CrossWorkerStream& parent) : parent_(parent) {}
+
+    // Commands posted by the client half.
+    void start(const ConnectionPool::Instance::StreamOptions& options);
+    void cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy);
+    void encodeHeaders(const RequestHeaderMap& headers, bool end_stream);
+    void encodeData(Buffer::Instance& data, bool end_stream);
+    void encodeTrailers(const RequestTrailerMap& trailers);
+    void encodeMetadata(const MetadataMapVector& metadata_map_vector);
+    void enableTcpTunneling();
+    void resetStream(StreamResetReason reason);
+    void readDisable(bool disable);
+    void setFlushTimeout(std::chrono::milliseconds timeout);
+
+    // ConnectionPool::Callbacks
+    void onPoolFailure(ConnectionPool::PoolFailureReason reason, absl::string_view failure_reason,
+                       Upstream::HostDescriptionConstSharedPtr host) override;
+    void onPoolReady(RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr host,
+                     StreamInfo::StreamInfo& info, absl::optional<Protocol> protocol) override;
+
+    // Http::StreamDecoder
+    void decodeData(Buffer::Instance& data, bool end_stream) override;
+    void decodeMetadata(MetadataMapPtr&& metadata_map) override;
+
+    // Http::ResponseDecoder
+    void decode1xxHeaders(ResponseHeaderMapPtr&& headers) override;
+    void decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) override;
+    void decodeTrailers(ResponseTrailerMapPtr&& trailers) override;
+    void dumpState(std::ostream& os, int indent_level) const override;
+
+    // Http::StreamCallbacks
+    void onResetStream(StreamResetReason reason, absl::string_view failure_reason) override;
+    void onAboveWriteBufferHighWatermark() override;
+    void onBelowWriteBufferLowWatermark() override;
+
+  private:
+    void onLocalEndStream();
+    void onRemoteEndStream();
+    // Releases the stream of the owner's pool, which must not be touched anymore.
+    void release();
+
+    CrossWorkerStream& parent_;
+    // Keeps the stream alive while it is pending or active in the owner's pool.
+    std::shared_ptr<CrossWorkerStream> self_;
+    ConnectionPool::Cancellable* handle_{};
+    RequestEncoder* encoder_{};
+    bool local_end_stream_{};
+    bool remote_end_stream_{};
+  };
+
+  // Runs a function on the client half, on the client worker.
+  void postToClient(absl::AnyInvocable<void(ClientStream&)> fn);
+  // Runs a function on the owner half, on the owner worker.
+  void postToOwner(absl::AnyInvocable<void(OwnerStream&)> fn);
+  // Called on the client worker once the client half is closed.
+  void onClientClosed();
+
+  // Only touched on the client worker. Cleared when the pool is destroyed.
+  CrossWorkerConnPool* pool_;
+  Event::Dispatcher& client_dispatcher_;
+  Event::Dispatcher& owner_dispatcher_;
+  const OwnerPoolCbSharedPtr owner_pool_cb_;
+  ClientStream client_;
+  OwnerStream owner_;
+};
+
+using CrossWorkerStreamSharedPtr = std::shared_ptr<CrossWorkerStream>;
+
+/**
+ * A connection pool of a worker which does not own the connections to its host. Its streams are
+ * handed off to the connection pool of the owner worker, which multiplexes the streams of all the
+ * workers over its own HTTP/2 or HTTP/3 connections, @see CrossWorkerStream. This pool does not
+ * hold any connection, so it only becomes idle once it is drained for deletion and all of its
+ * streams are done.
+ */
+class CrossWorkerConnPool : public ConnectionPool::Instance,
+                            protected Logger::Loggable<Logger::Id::pool> {
+public:
+  /**
+   * @param dispatcher supplies the dispatcher of the worker of this pool.
+   * @param owner_dispatcher supplies the dispatcher of the worker which owns the connections.
+   * @param host supplies the host of the pool.
+   * @param owner_pool_cb supplies the callback invoked on the owner worker to get its connection
+   *        pool for the host.
+   */
+  CrossWorkerConnPool(Event::Dispatcher& dispatcher, Event::Dispatcher& owner_dispatcher,
+                      Upstream::HostConstSharedPtr host,
+                      CrossWorkerStream::OwnerPoolCb owner_pool_cb);
+  ~CrossWorkerConnPool() override;
+
+  // Envoy::ConnectionPool::Instance
+  void addIdleCallback(IdleCb cb) override { idle_callbacks_.push_back(cb); }
+  bool isIdle() const override { return streams_.empty(); }
+  void drainConnections(Envoy::ConnectionPool::DrainBehavior drain_behavior) override;
+  Upstream::HostDescriptionConstSharedPtr host() const override { return host_; }
+  bool maybePreconnect(float) override { return false; }
+
+  // Http::ConnectionPool::Instance
+  bool hasActiveConnections() const override { return !streams_.empty(); }
+  ConnectionPool::Cancellable* newStream(ResponseDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks,
+                                         const StreamOptions& options) override;
+  absl::string_view protocolDescription() const override { return "cross-worker"; }
+
+private:
+  friend class CrossWorkerStream;
+
+  void onStreamClosed(CrossWorkerStream& stream);
+  void checkForIdleAndNotify();
+
+  Event::Dispatcher& dispatcher_;
+  Event::Dispatcher& owner_dispatcher_;
+  const Upstream::HostConstSharedPtr host_;
+  const CrossWorkerStream::OwnerPoolCbSharedPtr owner_pool_cb_;
+  absl::flat_hash_map<CrossWorkerStream*, CrossWorkerStreamSharedPtr> streams_;
+  std::list<IdleCb> idle_callbacks_;
+  bool draining_for_deletion_{};
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,218 @@
+#include "source/common/network/dns_resolver/caching_dns_resolver.h"
+
+#include <algorithm>
+
+#include "source/common/protobuf/utility.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Network {
+
+SINGLETON_MANAGER_REGISTRATION(shared_caching_dns_resolvers);
+
+void CachingDnsResolver::PendingResolution::cancel(CancelReason reason) {
+  // This may delete the pending resolution.
+  parent_.onCancel(*this, reason);
+}
+
+CachingDnsResolver::CachingDnsResolver(DnsResolverSharedPtr resolver,
+                                       Event::Dispatcher& dispatcher, Stats::Scope& scope,
+                                       absl::string_view name)
+    : resolver_(std::move(resolver)), time_source_(dispatcher.timeSource()),
+      scope_(scope.createScope(absl::StrCat("dns_resolution_cache.", name, "."))),
+      stats_{ALL_CACHING_DNS_RESOLVER_STATS(POOL_COUNTER(*scope_), POOL_GAUGE(*scope_))},
+      purge_timer_(dispatcher.createTimer([this]() { purgeExpired(); })) {
+  purge_timer_->enableTimer(PurgeInterval);
+}
+
+CachingDnsResolver::~CachingDnsResolver() {
+  for (auto& [key, entry] : entries_) {
+    if (entry.query_ != nullptr) {
+      entry.query_->cancel(ActiveDnsQuery::CancelReason::QueryAbandoned);
+    }
+    uncache(entry);
+  }
+}
+
+ActiveDnsQuery* CachingDnsResolver::resolve(const std::string& dns_name,
+                                            DnsLookupFamily dns_lookup_family,
+                                            ResolveCb callback) {
+  const Key key{dns_name, dns_lookup_family};
+  Entry& entry = entries_[key];
+  const MonotonicTime now = time_source_.monotonicTime();
+  if (entry.cached_ && entry.expiry_ > now) {
+    stats_.hit_.inc();
+    callback(ResolutionStatus::Success, cachedResponses(entry, now));
+    return nullptr;
+  }
+
+  const bool in_flight = !entry.pending_.empty();
+  entry.pending_.push_back(std::make_unique<PendingResolution>(*this, key, std::move(callback)));
+  PendingResolution* pending = entry.pending_.back().get();
+  if (in_flight) {
+    stats_.coalesced_.inc();
+    return pending;
+  }
+
+  stats_.miss_.inc();
+  ENVOY_LOG(debug, "caching DNS resolver: resolving '{}'", dns_name);
+  ActiveDnsQuery* query = resolver_->resolve(
+      dns_name, dns_lookup_family,
+      [this, key](ResolutionStatus status, std::list<DnsResponse>&& responses) {
+        onResolution(key, status, std::move(responses));
+      });
+  if (query == nullptr) {
+    // The wrapped resolver completed inline, so the pending resolution has already been completed
+    // and destroyed.
+    return nullptr;
+  }
+  // The entry may have been moved by re-entrant resolutions, so look it up again.
+  entries_.find(key)->second.query_ = query;
+  return pending;
+}
+
+void CachingDnsResolver::resetNetworking() {
+  // The cached responses may not be reachable on the new network.
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    uncache(it->second);
+    if (it->second.pending_.empty()) {
+      entries_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  resolver_->resetNetworking();
+}
+
+void CachingDnsResolver::onResolution(const Key& key, ResolutionStatus status,
+                                      std::list<DnsResponse>&& responses) {
+  auto it = entries_.find(key);
+  ASSERT(it != entries_.end());
+  Entry& entry = it->second;
+  entry.query_ = nullptr;
+  std::list<PendingResolutionPtr> pending = std::move(entry.pending_);
+  entry.pending_.clear();
+
+  uncache(entry);
+  if (status == ResolutionStatus::Success && !responses.empty()) {
+    std::chrono::seconds ttl = std::chrono::seconds::max();
+    for (const auto& response : responses) {
+      ttl = std::min(ttl, response.addrInfo().ttl_);
+    }
+    if (ttl.count() > 0) {
+      entry.responses_ = responses;
+      entry.expiry_ = time_source_.monotonicTime() + ttl;
+      entry.cached_ = true;
+      stats_.cached_names_.inc();
+    }
+  }
+  if (!entry.cached_) {
+    entries_.erase(it);
+  }
+
+  ENVOY_LOG(debug, "caching DNS resolver: resolution of '{}' completed for {} callers", key.first,
+            pending.size());
+  for (auto& resolution : pending) {
+    resolution->completing_ = true;
+  }
+  // The callbacks may cancel the resolutions of other callers which have not been called yet.
+  for (auto& resolution : pending) {
+    if (!resolution->cancelled_) {
+      resolution->callback_(status, std::list<DnsResponse>(responses));
+    }
+  }
+}
+
+void CachingDnsResolver::onCancel(PendingResolution& pending,
+                                  ActiveDnsQuery::CancelReason reason) {
+  if (pending.completing_) {
+    pending.cancelled_ = true;
+    return;
+  }
+
+  auto it = entries_.find(pending.key_);
+  ASSERT(it != entries_.end());
+  Entry& entry = it->second;
+  entry.pending_.remove_if([&pending](const PendingResolutionPtr& resolution) {
+    return resolution.get() == &pending;
+  });
+  if (!entry.pending_.empty()) {
+    return;
+  }
+
+  // Nobody is waiting for the resolution anymore.
+  if (entry.query_ != nullptr) {
+    entry.query_->cancel(reason);
+    entry.query_ = nullptr;
+  }
+  if (!entry.cached_) {
+    entries_.erase(it);
+  }
+}
+
+void CachingDnsResolver::uncache(Entry& entry) {
+  if (entry.cached_) {
+    entry.cached_ = false;
+    entry.responses_.clear();
+    stats_.cached_names_.dec();
+  }
+}
+
+void CachingDnsResolver::purgeExpired() {
+  const MonotonicTime now = time_source_.monotonicTime();
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    Entry& entry = it->second;
+    if (entry.cached_ && entry.expiry_ <= now) {
+      uncache(entry);
+    }
+    if (!entry.cached_ && entry.pending_.empty()) {
+      entries_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  purge_timer_->enableTimer(PurgeInterval);
+}
+
+std::list<DnsResponse> CachingDnsResolver::cachedResponses(const Entry& entry,
+                                                           MonotonicTime now) const {
+  const auto ttl = std::chrono::ceil<std::chrono::seconds>(entry.expiry_ - now);
+  std::list<DnsResponse> responses;
+  for (const auto& response : entry.responses_) {
+    responses.emplace_back(response.addrInfo().address_, ttl);
+  }
+  return responses;
+}
+
+std::shared_ptr<SharedCachingDnsResolvers>
+SharedCachingDnsResolvers::create(Singleton::Manager& singleton_manager) {
+  return singleton_manager.getTyped<SharedCachingDnsResolvers>(
+      SINGLETON_MANAGER_REGISTERED_NAME(shared_caching_dns_resolvers),
+      [] { return std::make_shared<SharedCachingDnsResolvers>(); });
+}
+
+std::shared_ptr<SharedCachingDnsResolvers>
+SharedCachingDnsResolvers::find(Singleton::Manager& singleton_manager) {
+  return singleton_manager.getTyped<SharedCachingDnsResolvers>(
+      SINGLETON_MANAGER_REGISTERED_NAME(shared_caching_dns_resolvers));
+}
+
+DnsResolverSharedPtr SharedCachingDnsResolvers::get(
+    Event::Dispatcher& dispatcher, Stats::Scope& scope,
+    const envoy::config::core::v3::TypedExtensionConfig* typed_dns_resolver_config,
+    const std::function<DnsResolverSharedPtr()>& create_resolver) {
+  const std::string key = typed_dns_resolver_config == nullptr
+                              ? "default"
+                              : absl::StrCat(MessageUtil::hash(*typed_dns_resolver_config));
+  if (auto resolver = resolvers_[key].lock(); resolver != nullptr) {
+    return resolver;
+  }
+
+  auto resolver = std::make_shared<CachingDnsResolver>(create_resolver(), dispatcher, scope, key);
+  resolvers_[key] = resolver;
+  return resolver;
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/config/core/v3/extension.pb.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/dns.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/singleton/manager.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "source/common/common/logger.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * All stats of a shared DNS resolution cache, under dns_resolution_cache.<resolver>. @see
+ * stats_macros.h
+ */
+#define ALL_CACHING_DNS_RESOLVER_STATS(COUNTER, GAUGE)                                             \
+  COUNTER(coalesced)                                                                               \
+  COUNTER(hit)                                                                                     \
+  COUNTER(miss)                                                                                    \
+  GAUGE(cached_names, Accumulate)
+
+/**
+ * Struct definition for all stats of the shared DNS resolution cache. @see stats_macros.h
+ */
+struct CachingDnsResolverStats {
+  ALL_CACHING_DNS_RESOLVER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * A DNS resolver which caches the successful resolutions of another resolver for as long as their
+ * TTL allows, and coalesces concurrent resolutions of the same name and lookup family into a
+ * single query. Resolutions served from the cache complete inline, with the TTLs of the responses
+ * set to the time left until the cached entry expires, so that callers refreshing on TTL expiry
+ * come back once the entry is stale. Failures are not cached.
+ *
+ * Like the resolvers it wraps, this must only be used on the thread of its dispatcher.
+ */
+class CachingDnsResolver : public DnsResolver, protected Logger::Loggable<Logger::Id::dns> {
+public:
+  /**
+   * @param name supplies the name of the cache in its stats, which are scoped to
+   *        dns_resolution_cache.<name>. so that the caches of different resolvers do not merge.
+   */
+  CachingDnsResolver(DnsResolverSharedPtr resolver, Event::Dispatcher& dispatcher,
+                     Stats::Scope& scope, absl::string_view name);
+  ~CachingDnsResolver() override;
+
+  // Network::DnsResolver
+  ActiveDnsQuery* resolve(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                          ResolveCb callback) override;
+  void resetNetworking() override;
+
+  // How often the expired entries are removed from the cache.
+  static constexpr std::chrono::seconds PurgeInterval{60};
+
+private:
+  using Key = std::pair<std::string, DnsLookupFamily>;
+
+  // A caller waiting for the resolution of a name which is in flight.
+  class PendingResolution : public ActiveDnsQuery {
+  public:
+    PendingResolution(CachingDnsResolver& parent, const Key& key, ResolveCb callback)
+        : parent_(parent), key_(key), callback_(std::move(callback)) {}
+
+    // Network::ActiveDnsQuery
+    void cancel(CancelReason reason) override;
+
+    CachingDnsResolver& parent_;
+    const Key key_;
+    ResolveCb callback_;
+    // Set once the resolution completed and its callbacks are being invoked.
+    bool completing_{};
+    bool cancelled_{};
+  };
+  using PendingResolutionPtr = std::unique_ptr<PendingResolution>;
+
+  struct Entry {
+    // The responses of the last successful resolution, valid until expiry_.
+    std::list<DnsResponse> responses_;
+    MonotonicTime expiry_;
+    bool cached_{};
+    // The query of the wrapped resolver, if a resolution is in flight.
+    ActiveDnsQuery* query_{};
+    std::list<PendingResolutionPtr> pending_;
+  };
+
+  void onResolution(const Key& key, ResolutionStatus status, std::list<DnsResponse>&& responses);
+  void onCancel(PendingResolution& pending, ActiveDnsQuery::CancelReason reason);
+  void uncache(Entry& entry);
+  void purgeExpired();
+  std::list<DnsResponse> cachedResponses(const Entry& entry, MonotonicTime now) const;
+
+  const DnsResolverSharedPtr resolver_;
+  TimeSource& time_source_;
+  const Stats::ScopeSharedPtr scope_;
+  CachingDnsResolverStats stats_;
+  const Event::TimerPtr purge_timer_;
+  absl::flat_hash_map<Key, Entry> entries_;
+};
+
+using CachingDnsResolverSharedPtr = std::shared_ptr<CachingDnsResolver>;
+
+/**
+ * The caching DNS resolvers shared by all the DNS-based clusters and dynamic forward proxy DNS
+ * caches of the server, one per DNS resolver configuration, so that the users of the same resolver
+ * configuration share its cache. It is only registered with the singleton manager of the server
+ * when the shared DNS cache is enabled in the bootstrap. A resolver is destroyed once none of its
+ * users need it anymore.
+ */
+class SharedCachingDnsResolvers : public Singleton::Instance {
+public:
+  /**
+   * Registers the shared resolvers with the singleton manager. They are registered for as long as
+   * the returned pointer is held.
+   */
+  static std::shared_ptr<SharedCachingDnsResolvers> create(Singleton::Manager& singleton_manager);
+
+  /**
+   * @return the shared resolvers registered with the singleton manager, or nullptr if the shared
+   *         DNS cache is not enabled.
+   */
+  static std::shared_ptr<SharedCachingDnsResolvers> find(Singleton::Manager& singleton_manager);
+
+  /**
+   * @return the shared caching resolver for the given resolver configuration, which is created
+   *         with create_resolver if it does not exist yet. Must be called on the main thread.
+   * @param dispatcher supplies the main thread dispatcher.
+   * @param scope supplies the scope of the stats of the cache. The cache of the default resolver is
+   *        named "default" in its stats, and the other ones by the hash of their configuration.
+   * @param typed_dns_resolver_config supplies the resolver configuration, or nullptr for the
+   *        default resolver of the server.
+   * @param create_resolver supplies the function creating the wrapped resolver.
+   */
+  DnsResolverSharedPtr
+  get(Event::Dispatcher& dispatcher, Stats::Scope& scope,
+      const envoy::config::core::v3::TypedExtensionConfig* typed_dns_resolver_config,
+      const std::function<DnsResolverSharedPtr()>& create_resolver);
+
+private:
+  absl::flat_hash_map<std::string, std::weak_ptr<CachingDnsResolver>> resolvers_;
+};
+
+using SharedCachingDnsResolversSharedPtr = std::shared_ptr<SharedCachingDnsResolvers>;
+
+} // namespace Network
+} // namespace Envoy
@@ -1083,6 +1083,7 @@ void Filter::onResponseTimeout() {
     if (upstream_request->upstreamHost()) {
       upstream_request->upstreamHost()->stats().rq_timeout_.inc();
     }
+    reportRequestFailure(*upstream_request);
 
     if (upstream_request->awaitingHeaders()) {
       if (cluster_->timeoutBudgetStats().has_value()) {
@@ -1166,6 +1167,7 @@ void Filter::onPerTryTimeoutCommon(UpstreamRequest& upstream_request, Stats::Cou
   if (upstream_request.upstreamHost()) {
     upstream_request.upstreamHost()->stats().rq_timeout_.inc();
   }
+  reportRequestFailure(upstream_request);
 
   upstream_request.resetStream();
 
@@ -1216,6 +1218,21 @@ void Filter::updateOutlierDetection(Upstream::Outlier::Result result,
   }
 }
 
+void Filter::reportRequestFailure(UpstreamRequest& upstream_request) {
+  if (response_time_observer_ == nullptr || upstream_request.upstreamHost() == nullptr) {
+    return;
+  }
+  std::chrono::microseconds elapsed{0};
+  const StreamInfo::UpstreamTiming& upstream_timing =
+      upstream_request.streamInfo().upstreamInfo()->upstreamTiming();
+  if (upstream_timing.first_upstream_tx_byte_sent_.has_value()) {
+    elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        callbacks_->dispatcher().timeSource().monotonicTime() -
+        upstream_timing.first_upstream_tx_byte_sent_.value());
+  }
+  response_time_observer_->onRequestFailure(*upstream_request.upstreamHost(), elapsed);
+}
+
 void Filter::chargeUpstreamAbort(Http::Code code, bool dropped, UpstreamRequest& upstream_request) {
   if (downstream_response_started_) {
     if (upstream_request.grpcRqSuccessDeferred()) {
@@ -1340,6 +1357,7 @@ void Filter::onUpstreamReset(Http::StreamResetReason reset_reason,
     // config param set to true.
     updateOutlierDetection(Upstream::Outlier::Result::LocalOriginConnectFailed, upstream_request,
                            absl::nullopt);
+    reportRequestFailure(upstream_request);
   }
 
   if (maybeRetryReset(reset_reason, upstream_request, TimeoutRetry::No)) {
@@ -1701,6 +1719,19 @@ void Filter::onUpstreamComplete(UpstreamRequest& upstream_request) {
   std::chrono::milliseconds response_time = std::chrono::duration_cast<std::chrono::milliseconds>(
       dispatcher.timeSource().monotonicTime() - downstream_request_complete_time_);
 
+  if (response_time_observer_ != nullptr) {
+    const StreamInfo::UpstreamTiming& upstream_timing =
+        upstream_request.streamInfo().upstreamInfo()->upstreamTiming();
+    if (upstream_timing.first_upstream_tx_byte_sent_.has_value() &&
+        upstream_timing.last_upstream_rx_byte_received_.has_value()) {
+      response_time_observer_->onResponseTime(
+          *upstream_request.upstreamHost(),
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              upstream_timing.last_upstream_rx_byte_received_.value() -
+              upstream_timing.first_upstream_tx_byte_sent_.value()));
+    }
+  }
+
   Upstream::ClusterTimeoutBudgetStatsOptRef tb_stats = cluster()->timeoutBudgetStats();
   if (tb_stats.has_value()) {
     tb_stats->get().upstream_rq_timeout_budget_percent_used_.recordValue(
@@ -415,6 +415,10 @@ public:
     return callbacks_->upstreamOverrideHost();
   }
 
+  void setResponseTimeObserver(Upstream::ResponseTimeObserverSharedPtr observer) override {
+    response_time_observer_ = std::move(observer);
+  }
+
   /**
    * Set a computed cookie to be sent with the downstream headers.
    * @param key supplies the size of the cookie
@@ -540,6 +544,8 @@ private:
                                                 uint64_t status_code);
   void updateOutlierDetection(Upstream::Outlier::Result result, UpstreamRequest& upstream_request,
                               absl::optional<uint64_t> code);
+  // Reports a timed out or reset upstream request to the load balancer's response time observer.
+  void reportRequestFailure(UpstreamRequest& upstream_request);
   void doRetry(bool can_send_early_data, bool can_use_http3, TimeoutRetry is_timeout_retry);
   void runRetryOptionsPredicates(UpstreamRequest& retriable_request);
   // Called immediately after a non-5xx header is received from upstream, performs stats accounting
@@ -580,6 +586,8 @@ private:
 
   Network::TransportSocketOptionsConstSharedPtr transport_socket_options_;
   Network::Socket::OptionsSharedPtr upstream_options_;
+  // Set by load balancers which route on observed latency.
+  Upstream::ResponseTimeObserverSharedPtr response_time_observer_;
   // Set of ongoing shadow streams which have not yet received end stream.
   absl::flat_hash_set<Http::AsyncClient::OngoingRequest*> shadow_streams_;
 
@@ -58,6 +58,12 @@ public:
 
   absl::optional<uint32_t> maxVerifyDepth() const override { return max_verify_depth_; }
 
+  const absl::optional<envoy::extensions::transport_sockets::tls::v3::
+                           CertificateValidationContext::VerificationCache>&
+  verificationCache() const override {
+    return verification_cache_;
+  }
+
 protected:
   CertificateValidationContextConfigImpl(
       const envoy::extensions::transport_sockets::tls::v3::CertificateValidationContext& config,
@@ -82,6 +88,9 @@ private:
   Api::Api& api_;
   const bool only_verify_leaf_cert_crl_;
   absl::optional<uint32_t> max_verify_depth_;
+  const absl::optional<envoy::extensions::transport_sockets::tls::v3::
+                           CertificateValidationContext::VerificationCache>
+      verification_cache_;
 };
 
 } // namespace Ssl
@@ -31,6 +31,7 @@ public:
     return SpanPtr{new NullSpan()};
   }
   void setSampled(bool) override {}
+  bool isRecording() const override { return false; }
 };
 
 } // namespace Tracing
@@ -87,6 +87,12 @@ Decision TracerUtility::shouldTraceRequest(const StreamInfo::StreamInfo& stream_
 void TracerUtility::finalizeSpan(Span& span, const TraceContext& trace_context,
                                  const StreamInfo::StreamInfo& stream_info,
                                  const Config& tracing_config, bool upstream_span) {
+  // Tags of a span that will not be reported are never observed, so skip building them.
+  if (!span.isRecording()) {
+    span.finishSpan();
+    return;
+  }
+
   span.setTag(Tracing::Tags::get().Component, Tracing::Tags::get().Proxy);
 
   // Response flag.
@@ -153,7 +159,7 @@ SpanPtr TracerImpl::startSpan(const Config& config, TraceContext& trace_context,
       driver_->startSpan(config, trace_context, stream_info, span_name, tracing_decision);
 
   // Set tags related to the local environment
-  if (active_span) {
+  if (active_span && active_span->isRecording()) {
     active_span->setTag(Tracing::Tags::get().NodeId, local_info_.nodeName());
     active_span->setTag(Tracing::Tags::get().Zone, local_info_.zoneName());
   }
@@ -5,6 +5,7 @@
 
 #include "source/common/http/utility.h"
 #include "source/common/network/address_impl.h"
+#include "source/common/network/dns_resolver/caching_dns_resolver.h"
 #include "source/common/network/dns_resolver/dns_factory_util.h"
 #include "source/common/network/resolver_impl.h"
 #include "source/common/network/socket_option_factory.h"
@@ -74,6 +75,9 @@ ClusterFactoryImplBase::selectDnsResolver(const envoy::config::cluster::v3::Clus
   // where 'dns_resolvers' is specified, we have per-cluster DNS
   // resolvers that are created here but ownership resides with
   // StrictDnsClusterImpl/LogicalDnsCluster.
+  auto& server_context = context.serverFactoryContext();
+  Network::SharedCachingDnsResolversSharedPtr shared_resolvers =
+      Network::SharedCachingDnsResolvers::find(server_context.singletonManager());
   if ((cluster.has_typed_dns_resolver_config() &&
        !(cluster.typed_dns_resolver_config().typed_config().type_url().empty())) ||
       (cluster.has_dns_resolution_config() &&
@@ -83,11 +87,25 @@ ClusterFactoryImplBase::selectDnsResolver(const envoy::config::cluster::v3::Clus
     envoy::config::core::v3::TypedExtensionConfig typed_dns_resolver_config;
     Network::DnsResolverFactory& dns_resolver_factory =
         Network::createDnsResolverFactoryFromProto(cluster, typed_dns_resolver_config);
-    auto& server_context = context.serverFactoryContext();
-    return dns_resolver_factory.createDnsResolver(server_context.mainThreadDispatcher(),
-                                                  server_context.api(), typed_dns_resolver_config);
+    auto create_resolver = [&]() {
+      return dns_resolver_factory.createDnsResolver(server_context.mainThreadDispatcher(),
+                                                    server_context.api(),
+                                                    typed_dns_resolver_config);
+    };
+    if (shared_resolvers == nullptr) {
+      return create_resolver();
+    }
+    // Clusters with the same resolver configuration share a cache.
+    return shared_resolvers->get(server_context.mainThreadDispatcher(),
+                                 server_context.serverScope(), &typed_dns_resolver_config,
+                                 create_resolver);
   }
 
+  if (shared_resolvers != nullptr) {
+    return shared_resolvers->get(server_context.mainThreadDispatcher(),
+                                 server_context.serverScope(), nullptr,
+                                 [&context]() { return context.dnsResolver(); });
+  }
   return context.dnsResolver();
 }
 
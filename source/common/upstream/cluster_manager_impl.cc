@@ -1,5 +1,6 @@
 #include "source/common/upstream/cluster_manager_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -24,6 +25,7 @@
 #include "source/common/common/assert.h"
 #include "source/common/common/enum_to_int.h"
 #include "source/common/common/fmt.h"
+#include "source/common/common/hash.h"
 #include "source/common/common/utility.h"
 #include "source/common/config/custom_config_validators_impl.h"
 #include "source/common/config/null_grpc_mux_impl.h"
@@ -31,6 +33,7 @@
 #include "source/common/config/xds_resource.h"
 #include "source/common/grpc/async_client_manager_impl.h"
 #include "source/common/http/async_client_impl.h"
+#include "source/common/http/cross_worker_conn_pool.h"
 #include "source/common/http/http1/conn_pool.h"
 #include "source/common/http/http2/conn_pool.h"
 #include "source/common/http/mixed_conn_pool.h"
@@ -324,6 +327,10 @@ ClusterManagerImpl::ClusterManagerImpl(
               const envoy::config::cluster::v3::Cluster::CommonLbConfig, MessageUtil, MessageUtil>>(
               main_thread_dispatcher)),
       shutdown_(false) {
+  if (bootstrap.enable_shared_dns_cache()) {
+    // This must be registered before any cluster is created.
+    shared_dns_resolvers_ = Network::SharedCachingDnsResolvers::create(factory.singletonManager());
+  }
   if (admin.has_value()) {
     config_tracker_entry_ = admin->getConfigTracker().add(
         "clusters", [this](const Matchers::StringMatcher& name_matcher) {
@@ -505,11 +512,20 @@ void ClusterManagerImpl::init(const envoy::config::bootstrap::v3::Bootstrap& boo
     local_cluster->second->setAddedOrUpdated();
   }
 
+  if (cm_config.enable_batched_worker_updates()) {
+    worker_updates_flush_ =
+        dispatcher_.createSchedulableCallback([this]() { flushWorkerUpdates(); });
+  }
+
   // Once the initial set of static bootstrap clusters are created (including the local cluster),
   // we can instantiate the thread local cluster manager.
   tls_.set([this, local_cluster_params](Event::Dispatcher& dispatcher) {
     return std::make_shared<ThreadLocalClusterManagerImpl>(*this, dispatcher, local_cluster_params);
   });
+  // Every worker knows the owners of the shared connection pools once they all have created their
+  // thread local cluster manager.
+  tls_.runOnAllThreads([](OptRef<ThreadLocalClusterManagerImpl>) {},
+                       [owners = shared_http_conn_pool_owners_]() { owners->setComplete(); });
 
   // We can now potentially create the CDS API once the backing cluster exists.
   if (dyn_resources.has_cds_config() || !dyn_resources.cds_resources_locator().empty()) {
@@ -841,7 +857,7 @@ bool ClusterManagerImpl::removeCluster(const std::string& cluster_name) {
     active_clusters_.erase(existing_active_cluster);
 
     ENVOY_LOG(debug, "removing cluster {}", cluster_name);
-    tls_.runOnAllThreads([cluster_name](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
+    runOnAllThreadLocals([cluster_name](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
       ASSERT(cluster_manager->thread_local_clusters_.contains(cluster_name) ||
              cluster_manager->thread_local_deferred_clusters_.contains(cluster_name));
       ENVOY_LOG(debug, "removing TLS cluster {}", cluster_name);
@@ -1110,7 +1126,7 @@ void ClusterManagerImpl::drainConnections(const std::string& cluster,
                                           DrainConnectionsHostPredicate predicate) {
   ENVOY_LOG_EVENT(debug, "drain_connections_call", "drainConnections called for cluster {}",
                   cluster);
-  tls_.runOnAllThreads([cluster, predicate](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
+  runOnAllThreadLocals([cluster, predicate](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
     auto cluster_entry = cluster_manager->thread_local_clusters_.find(cluster);
     if (cluster_entry != cluster_manager->thread_local_clusters_.end()) {
       cluster_entry->second->drainConnPools(
@@ -1122,7 +1138,7 @@ void ClusterManagerImpl::drainConnections(const std::string& cluster,
 void ClusterManagerImpl::drainConnections(DrainConnectionsHostPredicate predicate) {
   ENVOY_LOG_EVENT(debug, "drain_connections_call_for_all_clusters",
                   "drainConnections called for all clusters");
-  tls_.runOnAllThreads([predicate](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
+  runOnAllThreadLocals([predicate](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
     for (const auto& cluster_entry : cluster_manager->thread_local_clusters_) {
       cluster_entry.second->drainConnPools(predicate,
                                            ConnectionPool::DrainBehavior::DrainExistingConnections);
@@ -1144,7 +1160,7 @@ void ClusterManagerImpl::postThreadLocalRemoveHosts(const Cluster& cluster,
                                                     const HostVector& hosts_removed) {
   // Drain the connection pools for the given hosts. For deferred clusters have
   // been created.
-  tls_.runOnAllThreads([name = cluster.info()->name(),
+  runOnAllThreadLocals([name = cluster.info()->name(),
                         hosts_removed](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
     cluster_manager->removeHosts(name, hosts_removed);
   });
@@ -1216,7 +1232,7 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(ClusterManagerCluster& cm_
       addOrUpdateClusterInitializationObjectIfSupported(params, cm_cluster.cluster().info(),
                                                         load_balancer_factory, host_map);
 
-  tls_.runOnAllThreads([info = cm_cluster.cluster().info(), params = std::move(params),
+  runOnAllThreadLocals([info = cm_cluster.cluster().info(), params = std::move(params),
                         add_or_update_cluster, load_balancer_factory, map = std::move(host_map),
                         cluster_initialization_object = std::move(cluster_initialization_object)](
                            OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
@@ -1452,8 +1468,43 @@ ClusterManagerImpl::ClusterInitializationObject::ClusterInitializationObject(
   }
 }
 
+void ClusterManagerImpl::runOnAllThreadLocals(
+    ThreadLocal::TypedSlot<ThreadLocalClusterManagerImpl>::UpdateCb update) {
+  if (worker_updates_flush_ == nullptr) {
+    tls_.runOnAllThreads(update);
+    return;
+  }
+
+  // Code on the main thread expects to find a cluster as soon as it has been added, so only the
+  // workers wait for the batch.
+  update(tls_.get());
+  pending_worker_updates_.push_back(std::move(update));
+  if (!worker_updates_flush_->enabled()) {
+    worker_updates_flush_->scheduleCallbackCurrentIteration();
+  }
+}
+
+void ClusterManagerImpl::flushWorkerUpdates() {
+  if (pending_worker_updates_.empty()) {
+    return;
+  }
+  cm_stats_.worker_update_batches_.inc();
+  auto updates = std::make_shared<const ThreadLocalUpdates>(std::move(pending_worker_updates_));
+  pending_worker_updates_.clear();
+  tls_.runOnAllThreads([updates, main_cluster_manager = tls_.get().ptr()](
+                           OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
+    // The main thread has been updated already.
+    if (cluster_manager.ptr() == main_cluster_manager) {
+      return;
+    }
+    for (const auto& update : *updates) {
+      update(cluster_manager);
+    }
+  });
+}
+
 void ClusterManagerImpl::postThreadLocalHealthFailure(const HostSharedPtr& host) {
-  tls_.runOnAllThreads([host](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
+  runOnAllThreadLocals([host](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
     cluster_manager->onHostHealthFailure(host);
   });
 }
@@ -1610,6 +1661,9 @@ ClusterManagerImpl::requestOnDemandClusterDiscovery(OdCdsApiSharedPtr odcds, std
           debug,
           "cm odcds: the requested cluster {} is already known, posting the callback back to {}",
           name, thread_local_dispatcher.name());
+      // With batched worker updates, the worker may not have been told about the cluster yet.
+      // Flush the pending updates first, so that they reach the worker before the callback does.
+      flushWorkerUpdates();
       thread_local_dispatcher.post([invoker = std::move(invoker)] {
         invoker.invokeCallback(ClusterDiscoveryStatus::Available);
       });
@@ -1660,7 +1714,7 @@ void ClusterManagerImpl::notifyClusterDiscoveryStatus(absl::string_view name,
     return;
   }
   // Let all the worker threads know that the discovery timed out.
-  tls_.runOnAllThreads(
+  runOnAllThreadLocals(
       [name = std::string(name), status](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
         ENVOY_LOG(
             trace,
@@ -1731,6 +1785,10 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
     const absl::optional<LocalClusterParams>& local_cluster_params)
     : parent_(parent), thread_local_dispatcher_(dispatcher), cdm_(dispatcher.name(), *this),
       local_stats_(generateStats(*parent.stats_.rootScope(), dispatcher.name())) {
+  if (&dispatcher != &parent.dispatcher_) {
+    shared_http_conn_pool_owner_ = std::make_shared<SharedHttpConnPoolOwner>(*this);
+    parent.shared_http_conn_pool_owners_->add(shared_http_conn_pool_owner_);
+  }
   // If local cluster is defined then we need to initialize it first.
   if (local_cluster_params.has_value()) {
     const auto& local_cluster_name = local_cluster_params->info_->name();
@@ -1749,6 +1807,11 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
   // member update callback registered with the local cluster.
   ENVOY_LOG(debug, "shutting down thread local cluster manager");
   destroying_ = true;
+  if (shared_http_conn_pool_owner_ != nullptr) {
+    // Streams handed off to this worker from now on fail to find a connection pool.
+    shared_http_conn_pool_owner_->cluster_manager_ = nullptr;
+    parent_.shared_http_conn_pool_owners_->remove(*shared_http_conn_pool_owner_);
+  }
   host_http_conn_pool_map_.clear();
   host_tcp_conn_pool_map_.clear();
   ASSERT(host_tcp_conn_map_.empty());
@@ -1988,7 +2051,32 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolImp
     }
     return nullptr;
   }
+  return httpConnPoolForHost(host, priority, downstream_protocol, context, true);
+}
+
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::sharedHttpConnPool(
+    const HostConstSharedPtr& host, ResourcePriority priority,
+    absl::optional<Http::Protocol> downstream_protocol) {
+  // The host may have been removed on this worker before the stream got here, in which case its
+  // pools were drained already.
+  const auto cross_priority_host_map = priority_set_.crossPriorityHostMap();
+  if (cross_priority_host_map == nullptr) {
+    return nullptr;
+  }
+  const auto host_iter = cross_priority_host_map->find(host->address()->asString());
+  if (host_iter == cross_priority_host_map->end() || host_iter->second != host) {
+    return nullptr;
+  }
+  // Streams handed off to this worker are never handed off again.
+  return httpConnPoolForHost(host, priority, downstream_protocol, nullptr, false);
+}
 
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolForHost(
+    const HostConstSharedPtr& host, ResourcePriority priority,
+    absl::optional<Http::Protocol> downstream_protocol, LoadBalancerContext* context,
+    bool allow_cross_worker) {
   // Right now, HTTP, HTTP/2 and ALPN pools are considered separate.
   // We could do better here, and always use the ALPN pool and simply make sure
   // we end up on a connection of the correct protocol, but for simplicity we're
@@ -2036,11 +2124,24 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolImp
   // function. Otherwise, we'd need to capture a few of these variables by value.
   ConnPoolsContainer::ConnPools::PoolOptRef pool =
       container.pools_->getPool(priority, hash_key, [&]() {
-        auto pool = parent_.parent_.factory_.allocateConnPool(
-            parent_.thread_local_dispatcher_, host, priority, upstream_protocols,
-            alternate_protocol_options, !upstream_options->empty() ? upstream_options : nullptr,
-            have_transport_socket_options ? context->upstreamTransportSocketOptions() : nullptr,
-            parent_.parent_.time_source_, parent_.cluster_manager_state_, quic_info_);
+        // Only streams without per stream connection settings can share the connections of
+        // another worker, so the hash key of their pool is the same on every worker.
+        Http::ConnectionPool::InstancePtr pool;
+        if (allow_cross_worker && cluster_info_->sharedHttpConnectionPool() &&
+            upstream_protocols.size() == 1 &&
+            upstream_protocols[0] != Http::Protocol::Http10 &&
+            upstream_protocols[0] != Http::Protocol::Http11 && upstream_options->empty() &&
+            !have_transport_socket_options &&
+            !cluster_info_->connectionPoolPerDownstreamConnection()) {
+          pool = maybeAllocateCrossWorkerConnPool(host, priority, downstream_protocol);
+        }
+        if (pool == nullptr) {
+          pool = parent_.parent_.factory_.allocateConnPool(
+              parent_.thread_local_dispatcher_, host, priority, upstream_protocols,
+              alternate_protocol_options, !upstream_options->empty() ? upstream_options : nullptr,
+              have_transport_socket_options ? context->upstreamTransportSocketOptions() : nullptr,
+              parent_.parent_.time_source_, parent_.cluster_manager_state_, quic_info_);
+        }
 
         pool->addIdleCallback([&parent = parent_, host, priority, hash_key]() {
           parent.httpConnPoolIsIdle(host, priority, hash_key);
@@ -2056,6 +2157,48 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolImp
   }
 }
 
+Http::ConnectionPool::InstancePtr
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::maybeAllocateCrossWorkerConnPool(
+    const HostConstSharedPtr& host, ResourcePriority priority,
+    absl::optional<Http::Protocol> downstream_protocol) {
+  if (parent_.shared_http_conn_pool_owner_ == nullptr) {
+    // The main thread always uses connections of its own.
+    return nullptr;
+  }
+  SharedHttpConnPoolOwnerSharedPtr owner = parent_.parent_.shared_http_conn_pool_owners_->owner(
+      *host, *parent_.shared_http_conn_pool_owner_);
+  if (owner == nullptr) {
+    return nullptr;
+  }
+  ENVOY_LOG(debug, "handing off the streams of {} to worker {}", *host, owner->dispatcher_.name());
+  Event::Dispatcher& owner_dispatcher = owner->dispatcher_;
+  return std::make_unique<Http::CrossWorkerConnPool>(
+      parent_.thread_local_dispatcher_, owner_dispatcher, host,
+      [owner = std::move(owner), cluster_name = cluster_info_->name(), host, priority,
+       downstream_protocol]() -> Http::ConnectionPool::Instance* {
+        // Runs on the owner worker, which is the only one to clear its cluster manager.
+        if (owner->cluster_manager_ == nullptr) {
+          return nullptr;
+        }
+        return owner->cluster_manager_->sharedHttpConnPool(cluster_name, host, priority,
+                                                           downstream_protocol);
+      });
+}
+
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::sharedHttpConnPool(
+    const std::string& cluster_name, const HostConstSharedPtr& host, ResourcePriority priority,
+    absl::optional<Http::Protocol> downstream_protocol) {
+  auto cluster = thread_local_clusters_.find(cluster_name);
+  ClusterEntry* entry = cluster != thread_local_clusters_.end()
+                            ? cluster->second.get()
+                            : initializeClusterInlineIfExists(cluster_name);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+  return entry->sharedHttpConnPool(host, priority, downstream_protocol);
+}
+
 void ClusterManagerImpl::ThreadLocalClusterManagerImpl::httpConnPoolIsIdle(
     HostConstSharedPtr host, ResourcePriority priority, const std::vector<uint8_t>& hash_key) {
   if (destroying_) {
@@ -2084,6 +2227,47 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::httpConnPoolIsIdle(
   }
 }
 
+ClusterManagerImpl::SharedHttpConnPoolOwner::SharedHttpConnPoolOwner(
+    ThreadLocalClusterManagerImpl& cluster_manager)
+    : dispatcher_(cluster_manager.thread_local_dispatcher_), cluster_manager_(&cluster_manager) {}
+
+void ClusterManagerImpl::SharedHttpConnPoolOwners::add(
+    const SharedHttpConnPoolOwnerSharedPtr& worker) {
+  absl::MutexLock lock(&mutex_);
+  ASSERT(!complete_);
+  workers_.push_back(worker);
+}
+
+void ClusterManagerImpl::SharedHttpConnPoolOwners::remove(const SharedHttpConnPoolOwner& worker) {
+  absl::MutexLock lock(&mutex_);
+  auto it = std::find_if(workers_.begin(), workers_.end(),
+                         [&worker](const SharedHttpConnPoolOwnerSharedPtr& registered) {
+                           return registered.get() == &worker;
+                         });
+  if (it != workers_.end()) {
+    workers_.erase(it);
+    // The owners of the hosts would change, so no more streams are handed off.
+    shutting_down_ = complete_;
+  }
+}
+
+void ClusterManagerImpl::SharedHttpConnPoolOwners::setComplete() {
+  absl::MutexLock lock(&mutex_);
+  complete_ = true;
+}
+
+ClusterManagerImpl::SharedHttpConnPoolOwnerSharedPtr
+ClusterManagerImpl::SharedHttpConnPoolOwners::owner(const Host& host,
+                                                    const SharedHttpConnPoolOwner& caller) const {
+  absl::MutexLock lock(&mutex_);
+  if (!complete_ || shutting_down_ || workers_.size() < 2) {
+    return nullptr;
+  }
+  const SharedHttpConnPoolOwnerSharedPtr& owner =
+      workers_[HashUtil::xxHash64(host.address()->asString()) % workers_.size()];
+  return owner.get() != &caller ? owner : nullptr;
+}
+
 HostConstSharedPtr ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::chooseHost(
     LoadBalancerContext* context) {
   auto cross_priority_host_map = priority_set_.crossPriorityHostMap();
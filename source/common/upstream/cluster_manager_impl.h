@@ -33,6 +33,7 @@
 #include "source/common/http/async_client_impl.h"
 #include "source/common/http/http_server_properties_cache_impl.h"
 #include "source/common/http/http_server_properties_cache_manager_impl.h"
+#include "source/common/network/dns_resolver/caching_dns_resolver.h"
 #include "source/common/quic/quic_stat_names.h"
 #include "source/common/tcp/async_tcp_client_impl.h"
 #include "source/common/upstream/cluster_discovery_manager.h"
@@ -43,6 +44,8 @@
 #include "source/common/upstream/upstream_impl.h"
 #include "source/server/factory_context_base_impl.h"
 
+#include "absl/synchronization/mutex.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -216,6 +219,7 @@ private:
   COUNTER(cluster_updated_via_merge)                                                               \
   COUNTER(update_merge_cancelled)                                                                  \
   COUNTER(update_out_of_merge_window)                                                              \
+  COUNTER(worker_update_batches)                                                                   \
   GAUGE(active_clusters, NeverImport)                                                              \
   GAUGE(warming_clusters, NeverImport)
 
@@ -301,6 +305,9 @@ public:
   bool removeCluster(const std::string& cluster) override;
   void shutdown() override {
     shutdown_ = true;
+    // The workers are going away along with their clusters.
+    worker_updates_flush_.reset();
+    pending_worker_updates_.clear();
     if (resume_cds_ != nullptr) {
       resume_cds_->cancel();
     }
@@ -508,6 +515,22 @@ private:
   // To enable access to the protected constructor.
   friend ProdClusterManagerFactory;
 
+  struct ThreadLocalClusterManagerImpl;
+
+  /**
+   * The thread local cluster manager of a worker, as handed to the cross worker connection pools of
+   * the other workers. The worker clears it when its thread local cluster manager is destroyed.
+   * The cluster manager is only read and cleared on that worker, so the pools look it up for each
+   * stream without any lock.
+   */
+  struct SharedHttpConnPoolOwner {
+    explicit SharedHttpConnPoolOwner(ThreadLocalClusterManagerImpl& cluster_manager);
+
+    Event::Dispatcher& dispatcher_;
+    ThreadLocalClusterManagerImpl* cluster_manager_;
+  };
+  using SharedHttpConnPoolOwnerSharedPtr = std::shared_ptr<SharedHttpConnPoolOwner>;
+
   /**
    * Thread local cached cluster data. Each thread local cluster gets updates from the parent
    * central dynamic cluster (if applicable). It maintains load balancer state and any created
@@ -615,11 +638,26 @@ private:
       void drainConnPools(DrainConnectionsHostPredicate predicate,
                           ConnectionPool::DrainBehavior behavior);
 
+      // Returns the connection pool for a stream handed off to this worker by the cross worker
+      // pool of another worker, or nullptr if the host is not part of this cluster anymore.
+      Http::ConnectionPool::Instance*
+      sharedHttpConnPool(const HostConstSharedPtr& host, ResourcePriority priority,
+                         absl::optional<Http::Protocol> downstream_protocol);
+
     private:
       Http::ConnectionPool::Instance*
       httpConnPoolImpl(ResourcePriority priority,
                        absl::optional<Http::Protocol> downstream_protocol,
                        LoadBalancerContext* context, bool peek);
+      Http::ConnectionPool::Instance*
+      httpConnPoolForHost(const HostConstSharedPtr& host, ResourcePriority priority,
+                          absl::optional<Http::Protocol> downstream_protocol,
+                          LoadBalancerContext* context, bool allow_cross_worker);
+      // Creates a pool handing off its streams to the worker owning the connections to the host
+      // if the cluster shares its connection pools and the host is owned by another worker.
+      Http::ConnectionPool::InstancePtr
+      maybeAllocateCrossWorkerConnPool(const HostConstSharedPtr& host, ResourcePriority priority,
+                                       absl::optional<Http::Protocol> downstream_protocol);
 
       Tcp::ConnectionPool::Instance* tcpConnPoolImpl(ResourcePriority priority,
                                                      LoadBalancerContext* context, bool peek);
@@ -703,8 +741,17 @@ private:
      */
     ClusterEntry* initializeClusterInlineIfExists(absl::string_view cluster);
 
+    // Returns the connection pool of the given cluster for a stream handed off to this worker by
+    // the cross worker pool of another worker, or nullptr if there is no such pool.
+    Http::ConnectionPool::Instance*
+    sharedHttpConnPool(const std::string& cluster_name, const HostConstSharedPtr& host,
+                       ResourcePriority priority,
+                       absl::optional<Http::Protocol> downstream_protocol);
+
     ClusterManagerImpl& parent_;
     Event::Dispatcher& thread_local_dispatcher_;
+    // Only set on workers.
+    SharedHttpConnPoolOwnerSharedPtr shared_http_conn_pool_owner_;
     // Known clusters will exclusively exist in either `thread_local_clusters_`
     // or `thread_local_deferred_clusters_`.
     absl::flat_hash_map<std::string, ClusterEntryPtr> thread_local_clusters_;
@@ -730,6 +777,34 @@ private:
                                                         const std::string& thread_name);
   };
 
+  /**
+   * The thread local cluster managers of the workers, which own the connections of the clusters
+   * with shared_http_connection_pool set. Each host is owned by a single worker, and the other
+   * workers hand off their streams to it. This is shared with the callback completing it, which may
+   * run after the cluster manager is gone.
+   */
+  class SharedHttpConnPoolOwners {
+  public:
+    void add(const SharedHttpConnPoolOwnerSharedPtr& worker);
+    void remove(const SharedHttpConnPoolOwner& worker);
+    // Called once every worker has created its thread local cluster manager.
+    void setComplete();
+
+    /**
+     * @return the worker owning the connections to the host, or nullptr if the calling worker owns
+     *         them itself or some of the workers are not known (yet or anymore).
+     */
+    SharedHttpConnPoolOwnerSharedPtr owner(const Host& host,
+                                           const SharedHttpConnPoolOwner& caller) const;
+
+  private:
+    mutable absl::Mutex mutex_;
+    std::vector<SharedHttpConnPoolOwnerSharedPtr> workers_ ABSL_GUARDED_BY(mutex_);
+    bool complete_ ABSL_GUARDED_BY(mutex_){};
+    // Set if a worker shut down after all of them were known.
+    bool shutting_down_ ABSL_GUARDED_BY(mutex_){};
+  };
+
   struct ClusterData : public ClusterManagerCluster {
     ClusterData(const envoy::config::cluster::v3::Cluster& cluster_config,
                 const uint64_t cluster_config_hash, const std::string& version_info,
@@ -833,6 +908,8 @@ private:
   };
 
   using ClusterCreationsMap = absl::flat_hash_map<std::string, ClusterCreation>;
+  using ThreadLocalUpdates =
+      std::vector<ThreadLocal::TypedSlot<ThreadLocalClusterManagerImpl>::UpdateCb>;
 
   void applyUpdates(ClusterManagerCluster& cluster, uint32_t priority, PendingUpdates& updates);
   bool scheduleUpdate(ClusterManagerCluster& cluster, uint32_t priority, bool mergeable,
@@ -849,6 +926,14 @@ private:
                              bool added_via_api, bool required_for_ads, ClusterMap& cluster_map);
   void onClusterInit(ClusterManagerCluster& cluster);
   void postThreadLocalHealthFailure(const HostSharedPtr& host);
+
+  /**
+   * Runs an update of the thread local cluster manager on all threads. With batched worker updates
+   * enabled, the main thread is updated right away while the workers receive all updates made
+   * during the current event loop iteration in order, with a single post per worker.
+   */
+  void runOnAllThreadLocals(ThreadLocal::TypedSlot<ThreadLocalClusterManagerImpl>::UpdateCb update);
+  void flushWorkerUpdates();
   void updateClusterCounts();
   void clusterWarmingToActive(const std::string& cluster_name);
   static void maybePreconnect(ThreadLocalClusterManagerImpl::ClusterEntry& cluster_entry,
@@ -889,6 +974,9 @@ private:
   Random::RandomGenerator& random_;
   ClusterMap warming_clusters_;
   const bool deferred_cluster_creation_;
+  // Set if worker updates are batched, see runOnAllThreadLocals().
+  Event::SchedulableCallbackPtr worker_updates_flush_;
+  ThreadLocalUpdates pending_worker_updates_;
   absl::optional<envoy::config::core::v3::BindConfig> bind_config_;
   Outlier::EventLoggerSharedPtr outlier_event_logger_;
   const LocalInfo::LocalInfo& local_info_;
@@ -927,6 +1015,12 @@ private:
   std::unique_ptr<Config::XdsResourcesDelegate> xds_resources_delegate_;
   std::unique_ptr<Config::XdsConfigTracker> xds_config_tracker_;
 
+  const std::shared_ptr<SharedHttpConnPoolOwners> shared_http_conn_pool_owners_{
+      std::make_shared<SharedHttpConnPoolOwners>()};
+  // Registers the shared DNS resolution cache for the DNS-based clusters and DNS caches, if
+  // enabled.
+  Network::SharedCachingDnsResolversSharedPtr shared_dns_resolvers_;
+
   bool initialized_{};
   bool ads_mux_initialized_{};
   std::atomic<bool> shutdown_{};
@@ -1,12 +1,15 @@
 #pragma once
 #include <cstdint>
 #include <iostream>
+#include <limits>
 #include <queue>
 
 #include "envoy/upstream/scheduler.h"
 
 #include "source/common/common/assert.h"
 
+#include "absl/container/flat_hash_map.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -32,7 +35,7 @@ public:
     std::shared_ptr<C> ret = popEntry();
     if (ret) {
       prepick_list_.push_back(ret);
-      add(calculate_weight(*ret), ret);
+      push(calculate_weight(*ret), ret);
     }
     return ret;
   }
@@ -48,12 +51,72 @@ public:
     }
     std::shared_ptr<C> ret = popEntry();
     if (ret) {
-      add(calculate_weight(*ret), ret);
+      push(calculate_weight(*ret), ret);
     }
     return ret;
   }
 
   void add(double weight, std::shared_ptr<C> entry) override {
+    auto stale_it = stale_entries_.find(entry.get());
+    if (stale_it != stale_entries_.end()) {
+      if (stale_it->second.entry_.expired()) {
+        // A removed entry that has since been destroyed. Its queue entries expire on their own.
+        stale_entries_.erase(stale_it);
+      } else {
+        // Added back before its old queue entries were popped. Those stay stale.
+        supersede(stale_it->second, order_offset_);
+      }
+    }
+    push(weight, std::move(entry));
+  }
+
+  bool empty() const override { return queue_.empty(); }
+
+  /**
+   * Remove an entry that was previously added. Its queue entry is skipped and dropped when it
+   * reaches the front of the queue, so removal is O(1) plus the size of the peek ahead list.
+   * @param entry supplies the entry to remove.
+   */
+  void remove(const std::shared_ptr<C>& entry) {
+    StaleEntry& stale_entry = staleEntry(entry);
+    if (stale_entry.live_from_ == AllStale) {
+      return;
+    }
+    supersede(stale_entry, AllStale);
+    prepick_list_.remove_if([&entry](const std::weak_ptr<C>& prepicked) {
+      return !prepicked.owner_before(entry) && !entry.owner_before(prepicked);
+    });
+  }
+
+  /**
+   * Reschedule an entry that was previously added with a new weight, as if it had just been
+   * picked. Its old queue entry is dropped lazily, so this is O(log n).
+   * @param weight supplies the new weight.
+   * @param entry supplies the entry to reschedule.
+   */
+  void updateWeight(double weight, const std::shared_ptr<C>& entry) {
+    StaleEntry& stale_entry = staleEntry(entry);
+    if (stale_entry.live_from_ == AllStale) {
+      // Removed entries stay removed.
+      return;
+    }
+    supersede(stale_entry, order_offset_);
+    push(weight, entry);
+  }
+
+private:
+  static constexpr uint64_t AllStale = std::numeric_limits<uint64_t>::max();
+  struct StaleEntry {
+    // Used to tell a re-added entry from a new one that happens to reuse the address of a removed
+    // and since destroyed entry.
+    std::weak_ptr<C> entry_;
+    // Queue entries with a lower order offset are stale. AllStale if the entry was removed.
+    uint64_t live_from_{0};
+    // Number of stale queue entries still in the queue.
+    uint32_t count_{};
+  };
+
+  void push(double weight, std::shared_ptr<C> entry) {
     ASSERT(weight > 0);
     const double deadline = current_time_ + 1.0 / weight;
     EDF_TRACE("Insertion {} in queue with deadline {} and weight {}.",
@@ -62,9 +125,49 @@ public:
     ASSERT(queue_.top().deadline_ >= current_time_);
   }
 
-  bool empty() const override { return queue_.empty(); }
+  StaleEntry& staleEntry(const std::shared_ptr<C>& entry) {
+    if (stale_entries_.size() > 2 * queue_.size()) {
+      // Entries destroyed after they were removed are not seen again by popEntry(), so their
+      // records are swept here once there are more records than could be stale.
+      absl::erase_if(stale_entries_, [](const auto& stale_entry) {
+        return stale_entry.second.entry_.expired();
+      });
+    }
+    auto [stale_it, inserted] = stale_entries_.try_emplace(entry.get(), StaleEntry{entry});
+    if (!inserted && stale_it->second.entry_.expired()) {
+      // The address of a removed and since destroyed entry has been reused.
+      stale_it->second = StaleEntry{entry};
+    }
+    return stale_it->second;
+  }
+
+  // Marks the currently live queue entry, if any, as stale. Queue entries pushed at or after
+  // live_from are live.
+  static void supersede(StaleEntry& stale_entry, uint64_t live_from) {
+    if (stale_entry.live_from_ != AllStale) {
+      stale_entry.count_++;
+    }
+    stale_entry.live_from_ = live_from;
+  }
+
+  /**
+   * @return true if the queue entry was removed or superseded by updateWeight(). Stale queue
+   * entries are no longer tracked once this returns true for them.
+   */
+  bool consumeIfStale(const C* entry, uint64_t order_offset) {
+    if (stale_entries_.empty()) {
+      return false;
+    }
+    auto stale_it = stale_entries_.find(entry);
+    if (stale_it == stale_entries_.end() || order_offset >= stale_it->second.live_from_) {
+      return false;
+    }
+    if (--stale_it->second.count_ == 0) {
+      stale_entries_.erase(stale_it);
+    }
+    return true;
+  }
 
-private:
   /**
    * Clears expired entries and pops the next unexpired entry in the queue.
    */
@@ -83,6 +186,11 @@ private:
         queue_.pop();
         continue;
       }
+      if (consumeIfStale(ret.get(), edf_entry.order_offset_)) {
+        EDF_TRACE("Entry has been removed or rescheduled, repick.");
+        queue_.pop();
+        continue;
+      }
       ASSERT(edf_entry.deadline_ >= current_time_);
       current_time_ = edf_entry.deadline_;
       EDF_TRACE("Picked {}, current_time_={}.", static_cast<const void*>(ret.get()), current_time_);
@@ -95,8 +203,8 @@ private:
     double deadline_;
     // Tie breaker for entries with the same deadline. This is used to provide FIFO behavior.
     uint64_t order_offset_;
-    // We only hold a weak pointer, since we don't support a remove operator. This allows entries to
-    // be lazily unloaded from the queue.
+    // We only hold a weak pointer, so that entries destroyed without a call to remove() are lazily
+    // unloaded from the queue.
     std::weak_ptr<C> entry_;
 
     // Flip < direction to make this a min queue.
@@ -116,6 +224,8 @@ private:
   // Min priority queue for EDF.
   std::priority_queue<EdfEntry> queue_;
   std::list<std::weak_ptr<C>> prepick_list_;
+  // Entries passed to remove() or updateWeight() that still have queue entries to be skipped.
+  absl::flat_hash_map<const C*, StaleEntry> stale_entries_;
 };
 
 #undef EDF_DEBUG
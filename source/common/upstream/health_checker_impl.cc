@@ -79,6 +79,11 @@ HealthCheckerFactory::create(const envoy::config::core::v3::HealthCheck& health_
   }
   }
 
+  if (health_check_config.offload_threads() > 0 && health_check_config.share_across_clusters()) {
+    return absl::InvalidArgumentError(
+        "health check offload_threads can not be combined with share_across_clusters");
+  }
+
   std::unique_ptr<Server::Configuration::HealthCheckerFactoryContext> context(
       new HealthCheckerFactoryContextImpl(cluster, server_context));
 
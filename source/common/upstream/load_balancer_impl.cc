@@ -6,6 +6,8 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <numeric>
+#include <queue>
 #include <string>
 #include <vector>
 
@@ -20,6 +22,7 @@
 #include "source/common/runtime/runtime_features.h"
 
 #include "absl/container/fixed_array.h"
+#include "absl/numeric/int128.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -1001,11 +1004,120 @@ const HostVector& ZoneAwareLoadBalancerBase::hostSourceToHosts(HostsSource hosts
   PANIC_DUE_TO_CORRUPT_ENUM;
 }
 
+std::shared_ptr<const EdfLoadBalancerBase::PrecomputedSchedule>
+EdfLoadBalancerBase::PrecomputedSchedule::create(HostVectorConstSharedPtr hosts) {
+  std::shared_ptr<PrecomputedSchedule> schedule(new PrecomputedSchedule(std::move(hosts)));
+  const HostVector& hosts_to_schedule = *schedule->hosts_;
+  if (hostWeightsAreEqual(hosts_to_schedule)) {
+    return schedule;
+  }
+
+  // One cycle picks every host as many times as its weight, so dividing out the common factor of
+  // the weights gives the shortest cycle.
+  uint64_t divisor = 0;
+  for (const auto& host : hosts_to_schedule) {
+    divisor = std::gcd(divisor, uint64_t(host->weight()));
+  }
+  uint64_t cycle_length = 0;
+  for (const auto& host : hosts_to_schedule) {
+    cycle_length += host->weight() / divisor;
+  }
+  if (cycle_length > std::max(MaxPicksPerHost * hosts_to_schedule.size(), MinMaxPicks)) {
+    return nullptr;
+  }
+
+  // The k-th pick of a host with weight w is due at k / w. Deadlines are compared exactly by
+  // cross-multiplying, with ties going to the earlier host as in EdfScheduler.
+  struct Deadline {
+    uint64_t picks_;
+    uint64_t weight_;
+    uint32_t index_;
+  };
+  const auto later = [](const Deadline& a, const Deadline& b) {
+    const absl::uint128 a_due = absl::uint128(a.picks_) * b.weight_;
+    const absl::uint128 b_due = absl::uint128(b.picks_) * a.weight_;
+    return a_due == b_due ? a.index_ > b.index_ : a_due > b_due;
+  };
+  std::vector<Deadline> deadlines;
+  deadlines.reserve(hosts_to_schedule.size());
+  for (uint32_t i = 0; i < hosts_to_schedule.size(); ++i) {
+    deadlines.push_back({1, hosts_to_schedule[i]->weight() / divisor, i});
+  }
+  std::priority_queue<Deadline, std::vector<Deadline>, decltype(later)> queue(
+      later, std::move(deadlines));
+  schedule->picks_.reserve(cycle_length);
+  while (schedule->picks_.size() < cycle_length) {
+    Deadline next = queue.top();
+    queue.pop();
+    schedule->picks_.push_back(next.index_);
+    ++next.picks_;
+    queue.push(next);
+  }
+  return schedule;
+}
+
+void EdfLoadBalancerBase::SharedSchedules::update(const HostSet& host_set) {
+  const uint32_t priority = host_set.priority();
+  absl::flat_hash_map<HostsSource, std::shared_ptr<const PrecomputedSchedule>, HostsSourceHash>
+      schedules;
+  const auto add_hosts_source = [&schedules](HostsSource source, HostVectorConstSharedPtr hosts) {
+    auto schedule = PrecomputedSchedule::create(std::move(hosts));
+    if (schedule != nullptr) {
+      schedules.emplace(source, std::move(schedule));
+    }
+  };
+
+  // Each schedule keeps the host vector it was built from alive, and refers to the very vector
+  // the workers are handed for the same update. That is how workers tell whether a schedule
+  // matches the hosts they currently see.
+  add_hosts_source(HostsSource(priority, HostsSource::SourceType::AllHosts), host_set.hostsPtr());
+  const HealthyHostVectorConstSharedPtr healthy_hosts = host_set.healthyHostsPtr();
+  add_hosts_source(HostsSource(priority, HostsSource::SourceType::HealthyHosts),
+                   HostVectorConstSharedPtr(healthy_hosts, &healthy_hosts->get()));
+  const DegradedHostVectorConstSharedPtr degraded_hosts = host_set.degradedHostsPtr();
+  add_hosts_source(HostsSource(priority, HostsSource::SourceType::DegradedHosts),
+                   HostVectorConstSharedPtr(degraded_hosts, &degraded_hosts->get()));
+  const HostsPerLocalityConstSharedPtr healthy_per_locality = host_set.healthyHostsPerLocalityPtr();
+  for (uint32_t locality_index = 0; locality_index < healthy_per_locality->get().size();
+       ++locality_index) {
+    add_hosts_source(
+        HostsSource(priority, HostsSource::SourceType::LocalityHealthyHosts, locality_index),
+        HostVectorConstSharedPtr(healthy_per_locality,
+                                 &healthy_per_locality->get()[locality_index]));
+  }
+  const HostsPerLocalityConstSharedPtr degraded_per_locality =
+      host_set.degradedHostsPerLocalityPtr();
+  for (uint32_t locality_index = 0; locality_index < degraded_per_locality->get().size();
+       ++locality_index) {
+    add_hosts_source(
+        HostsSource(priority, HostsSource::SourceType::LocalityDegradedHosts, locality_index),
+        HostVectorConstSharedPtr(degraded_per_locality,
+                                 &degraded_per_locality->get()[locality_index]));
+  }
+
+  absl::MutexLock lock(&mutex_);
+  absl::erase_if(schedules_,
+                 [priority](const auto& entry) { return entry.first.priority_ == priority; });
+  schedules_.merge(schedules);
+}
+
+std::shared_ptr<const EdfLoadBalancerBase::PrecomputedSchedule>
+EdfLoadBalancerBase::SharedSchedules::find(const HostsSource& source,
+                                           const HostVector& hosts) const {
+  absl::MutexLock lock(&mutex_);
+  auto it = schedules_.find(source);
+  if (it == schedules_.end() || &it->second->hosts() != &hosts) {
+    return nullptr;
+  }
+  return it->second;
+}
+
 EdfLoadBalancerBase::EdfLoadBalancerBase(
     const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterLbStats& stats,
     Runtime::Loader& runtime, Random::RandomGenerator& random, uint32_t healthy_panic_threshold,
     const absl::optional<LocalityLbConfig> locality_config,
-    const absl::optional<SlowStartConfig> slow_start_config, TimeSource& time_source)
+    const absl::optional<SlowStartConfig> slow_start_config, TimeSource& time_source,
+    SharedSchedulesConstSharedPtr shared_schedules)
     : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
                                 healthy_panic_threshold, locality_config),
       seed_(random_.random()),
@@ -1022,12 +1134,17 @@ EdfLoadBalancerBase::EdfLoadBalancerBase(
                                          ? PROTOBUF_PERCENT_TO_DOUBLE_OR_DEFAULT(
                                                slow_start_config.value(), min_weight_percent, 10) /
                                                100.0
-                                         : 0.1) {
-  // We fully recompute the schedulers for a given host set here on membership change, which is
-  // consistent with what other LB implementations do (e.g. thread aware).
-  // The downside of a full recompute is that time complexity is O(n * log n),
-  // so we will need to do better at delta tracking to scale (see
-  // https://github.com/envoyproxy/envoy/issues/2874).
+                                         : 0.1),
+      incremental_refresh_(Runtime::runtimeFeatureEnabled(
+          "envoy.reloadable_features.edf_lb_incremental_refresh")),
+      shared_schedules_(std::move(shared_schedules)) {
+  // Shared schedules are built from the configured weights only, which slow start changes.
+  ASSERT(shared_schedules_ == nullptr || !isSlowStartEnabled());
+  // By default we fully recompute the schedulers for a given host set here on membership change,
+  // which is consistent with what other LB implementations do (e.g. thread aware). The downside
+  // of a full recompute is that time complexity is O(n * log n) on every worker. With
+  // incremental refresh enabled, only the hosts that were added, removed or re-weighted are
+  // applied to the existing schedulers (see https://github.com/envoyproxy/envoy/issues/2874).
   priority_update_cb_ = priority_set.addPriorityUpdateCb(
       [this](uint32_t priority, const HostVector&, const HostVector&) { refresh(priority); });
   member_update_cb_ = priority_set.addMemberUpdateCb(
@@ -1070,6 +1187,33 @@ void EdfLoadBalancerBase::recalculateHostsInSlowStart(const HostVector& hosts) {
 
 void EdfLoadBalancerBase::refresh(uint32_t priority) {
   const auto add_hosts_source = [this](HostsSource source, const HostVector& hosts) {
+    // Use the schedule built on the main thread if there is one for exactly these hosts. Otherwise,
+    // e.g. if the main thread has already moved on to a newer update, build our own below.
+    if (shared_schedules_ != nullptr) {
+      std::shared_ptr<const PrecomputedSchedule> schedule = shared_schedules_->find(source, hosts);
+      if (schedule != nullptr) {
+        auto& scheduler = scheduler_[source] = Scheduler{};
+        refreshHostSource(source);
+        if (schedule->weighted()) {
+          // Start each worker at a different point of the cycle, as is done below for EDF.
+          scheduler.position_ = seed_ % schedule->size();
+          scheduler.shared_schedule_ = std::move(schedule);
+        }
+        return;
+      }
+    }
+
+    // Slow start weights change over time and are only recomputed here, so with slow start the
+    // schedulers are always rebuilt.
+    if (incremental_refresh_ && !isSlowStartEnabled()) {
+      auto scheduler_it = scheduler_.find(source);
+      if (scheduler_it != scheduler_.end() && scheduler_it->second.edf_ != nullptr) {
+        refreshHostSource(source);
+        updateEdfScheduler(scheduler_it->second, hosts);
+        return;
+      }
+    }
+
     // Nuke existing scheduler if it exists.
     auto& scheduler = scheduler_[source] = Scheduler{};
     refreshHostSource(source);
@@ -1098,6 +1242,9 @@ void EdfLoadBalancerBase::refresh(uint32_t priority) {
       // at which point it is reinserted into the EdfScheduler with its new
       // weight in chooseHost().
       scheduler.edf_->add(hostWeight(*host), host);
+      if (incremental_refresh_) {
+        scheduler.hosts_.try_emplace(host.get(), Scheduler::ScheduledHost{host, host->weight()});
+      }
     }
 
     // Cycle through hosts to achieve the intended offset behavior.
@@ -1131,6 +1278,39 @@ void EdfLoadBalancerBase::refresh(uint32_t priority) {
   }
 }
 
+void EdfLoadBalancerBase::updateEdfScheduler(Scheduler& scheduler, const HostVector& hosts) {
+  // Finding the changed hosts is a linear scan of hash lookups, since the derived host sources
+  // (healthy, degraded, per locality) do not come with deltas. Only the changed hosts touch the
+  // EDF queue, at O(log n) each.
+  const uint64_t generation = ++scheduler.generation_;
+  for (const auto& host : hosts) {
+    auto [host_it, inserted] = scheduler.hosts_.try_emplace(host.get());
+    Scheduler::ScheduledHost& scheduled_host = host_it->second;
+    if (inserted || scheduled_host.host_.expired()) {
+      // Either a new host, or a new host at the address of one that has been destroyed.
+      scheduled_host = {host, host->weight(), generation};
+      scheduler.edf_->add(hostWeight(*host), host);
+      continue;
+    }
+    scheduled_host.generation_ = generation;
+    if (scheduled_host.weight_ != host->weight()) {
+      scheduled_host.weight_ = host->weight();
+      scheduler.edf_->updateWeight(hostWeight(*host), host);
+    }
+  }
+
+  absl::erase_if(scheduler.hosts_, [&scheduler, generation](const auto& entry) {
+    if (entry.second.generation_ == generation) {
+      return false;
+    }
+    // The host has left this host source. Destroyed hosts expire from the queue on their own.
+    if (HostConstSharedPtr host = entry.second.host_.lock(); host != nullptr) {
+      scheduler.edf_->remove(host);
+    }
+    return true;
+  });
+}
+
 bool EdfLoadBalancerBase::isSlowStartEnabled() const {
   return slow_start_window_ > std::chrono::milliseconds(0);
 }
@@ -1167,7 +1347,9 @@ HostConstSharedPtr EdfLoadBalancerBase::peekAnotherHost(LoadBalancerContext* con
   // BaseDynamicClusterImpl::updateDynamicHostList, we must do a runtime pivot here to determine
   // whether to use EDF or do unweighted (fast) selection. EDF is non-null iff the original
   // weights of 2 or more hosts differ.
-  if (scheduler.edf_ != nullptr) {
+  if (scheduler.shared_schedule_ != nullptr) {
+    return scheduler.shared_schedule_->pick(scheduler.position_ + scheduler.peekahead_++);
+  } else if (scheduler.edf_ != nullptr) {
     return scheduler.edf_->peekAgain([this](const Host& host) { return hostWeight(host); });
   } else {
     const HostVector& hosts_to_use = hostSourceToHosts(*hosts_source);
@@ -1193,7 +1375,13 @@ HostConstSharedPtr EdfLoadBalancerBase::chooseHostOnce(LoadBalancerContext* cont
   // BaseDynamicClusterImpl::updateDynamicHostList, we must do a runtime pivot here to determine
   // whether to use EDF or do unweighted (fast) selection. EDF is non-null iff the original
   // weights of 2 or more hosts differ.
-  if (scheduler.edf_ != nullptr) {
+  if (scheduler.shared_schedule_ != nullptr) {
+    // Hosts handed out by peekAnotherHost() are picked first, in the same order.
+    if (scheduler.peekahead_ > 0) {
+      --scheduler.peekahead_;
+    }
+    return scheduler.shared_schedule_->pick(scheduler.position_++);
+  } else if (scheduler.edf_ != nullptr) {
     auto host = scheduler.edf_->pickAndAdd([this](const Host& host) { return hostWeight(host); });
     return host;
   } else {
@@ -24,6 +24,8 @@
 #include "source/common/upstream/edf_scheduler.h"
 #include "source/common/upstream/subset_lb_config.h"
 
+#include "absl/synchronization/mutex.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -240,6 +242,8 @@ public:
   }
 
   absl::optional<OverrideHost> overrideHostToSelect() const override { return {}; }
+
+  void setResponseTimeObserver(ResponseTimeObserverSharedPtr) override {}
 };
 
 /**
@@ -509,12 +513,88 @@ class EdfLoadBalancerBase : public ZoneAwareLoadBalancerBase {
 public:
   using SlowStartConfig = envoy::extensions::load_balancing_policies::common::v3::SlowStartConfig;
 
+  /**
+   * An immutable weighted round robin schedule for a host source. It lists the picks of one full
+   * cycle of the host weights, in the order an EDF scheduler would make them, so that walking it
+   * picks every host exactly in proportion to its weight.
+   */
+  class PrecomputedSchedule {
+  public:
+    // Cycles longer than this many picks per host, or MinMaxPicks, are not precomputed.
+    static constexpr uint64_t MaxPicksPerHost = 128;
+    static constexpr uint64_t MinMaxPicks = 1 << 16;
+
+    /**
+     * @param hosts supplies the hosts of the host source.
+     * @return the schedule, or nullptr if the weight cycle is too long to precompute.
+     */
+    static std::shared_ptr<const PrecomputedSchedule> create(HostVectorConstSharedPtr hosts);
+
+    /**
+     * @return the host source the schedule was built for.
+     */
+    const HostVector& hosts() const { return *hosts_; }
+
+    /**
+     * @return false if all hosts have the same weight, in which case there are no picks and plain
+     *         round robin over hosts() is used instead.
+     */
+    bool weighted() const { return !picks_.empty(); }
+
+    /**
+     * @return the number of picks in one cycle.
+     */
+    uint64_t size() const { return picks_.size(); }
+
+    /**
+     * @param position supplies the position in the schedule, which wraps around.
+     * @return the host picked at the position. Only valid for weighted schedules.
+     */
+    const HostSharedPtr& pick(uint64_t position) const {
+      return (*hosts_)[picks_[position % picks_.size()]];
+    }
+
+  private:
+    explicit PrecomputedSchedule(HostVectorConstSharedPtr hosts) : hosts_(std::move(hosts)) {}
+
+    const HostVectorConstSharedPtr hosts_;
+    // Indexes into hosts_.
+    std::vector<uint32_t> picks_;
+  };
+
+  /**
+   * Precomputed schedules for every host source of a priority set. They are built once on the main
+   * thread and shared read-only by the load balancers of all workers, which then only need to keep
+   * their own position in each schedule instead of building their own EDF schedulers.
+   */
+  class SharedSchedules {
+  public:
+    /**
+     * Rebuild the schedules of a host set. Called on the main thread after each update.
+     */
+    void update(const HostSet& host_set);
+
+    /**
+     * @return the schedule for the host source if it was built from exactly this host vector, or
+     *         nullptr if there is none, e.g. because the worker has not seen the same update yet.
+     */
+    std::shared_ptr<const PrecomputedSchedule> find(const HostsSource& source,
+                                                    const HostVector& hosts) const;
+
+  private:
+    mutable absl::Mutex mutex_;
+    absl::flat_hash_map<HostsSource, std::shared_ptr<const PrecomputedSchedule>, HostsSourceHash>
+        schedules_ ABSL_GUARDED_BY(mutex_);
+  };
+  using SharedSchedulesConstSharedPtr = std::shared_ptr<const SharedSchedules>;
+
   EdfLoadBalancerBase(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
                       ClusterLbStats& stats, Runtime::Loader& runtime,
                       Random::RandomGenerator& random, uint32_t healthy_panic_threshold,
                       const absl::optional<LocalityLbConfig> locality_config,
                       const absl::optional<SlowStartConfig> slow_start_config,
-                      TimeSource& time_source);
+                      TimeSource& time_source,
+                      SharedSchedulesConstSharedPtr shared_schedules = nullptr);
 
   // Upstream::ZoneAwareLoadBalancerBase
   HostConstSharedPtr peekAnotherHost(LoadBalancerContext* context) override;
@@ -526,6 +606,24 @@ protected:
     // host weights of 2 or more hosts differ. When not present, the
     // implementation of chooseHostOnce falls back to unweightedHostPick.
     std::unique_ptr<EdfScheduler<const Host>> edf_;
+
+    // Hosts added to edf_ and the weight they were scheduled with. Only tracked when edf_ is
+    // refreshed incrementally, so that membership and weight changes can be applied to it
+    // without a rebuild.
+    struct ScheduledHost {
+      std::weak_ptr<const Host> host_;
+      uint32_t weight_{};
+      uint64_t generation_{};
+    };
+    absl::flat_hash_map<const Host*, ScheduledHost> hosts_;
+    // Bumped on each incremental refresh to find the hosts that have left the host source.
+    uint64_t generation_{};
+
+    // Weighted schedule shared with the other workers. When set, picks walk it from this load
+    // balancer's own position and edf_ is not built.
+    std::shared_ptr<const PrecomputedSchedule> shared_schedule_;
+    uint64_t position_{};
+    uint64_t peekahead_{};
   };
 
   void initialize();
@@ -549,6 +647,7 @@ protected:
 private:
   friend class EdfLoadBalancerBasePeer;
   virtual void refreshHostSource(const HostsSource& source) PURE;
+  void updateEdfScheduler(Scheduler& scheduler, const HostVector& hosts);
   virtual double hostWeight(const Host& host) const PURE;
   virtual HostConstSharedPtr unweightedHostPeek(const HostVector& hosts_to_use,
                                                 const HostsSource& source) PURE;
@@ -567,6 +666,9 @@ protected:
   TimeSource& time_source_;
   MonotonicTime latest_host_added_time_;
   const double slow_start_min_weight_percent_;
+  // Whether EDF schedulers are updated in place on host changes instead of being rebuilt.
+  const bool incremental_refresh_;
+  const SharedSchedulesConstSharedPtr shared_schedules_;
 };
 
 /**
@@ -598,11 +700,12 @@ public:
       Runtime::Loader& runtime, Random::RandomGenerator& random, uint32_t healthy_panic_threshold,
       const envoy::extensions::load_balancing_policies::round_robin::v3::RoundRobin&
           round_robin_config,
-      TimeSource& time_source)
+      TimeSource& time_source, SharedSchedulesConstSharedPtr shared_schedules = nullptr)
       : EdfLoadBalancerBase(
             priority_set, local_priority_set, stats, runtime, random, healthy_panic_threshold,
             LoadBalancerConfigHelper::localityLbConfigFromProto(round_robin_config),
-            LoadBalancerConfigHelper::slowStartConfigFromProto(round_robin_config), time_source) {
+            LoadBalancerConfigHelper::slowStartConfigFromProto(round_robin_config), time_source,
+            std::move(shared_schedules)) {
     initialize();
   }
 
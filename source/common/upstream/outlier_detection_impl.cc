@@ -40,8 +40,10 @@ DetectorHostMonitorImpl::DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> d
                                                  HostSharedPtr host)
     : detector_(detector), host_(host),
       // add Success Rate monitors
-      external_origin_sr_monitor_(envoy::data::cluster::v3::SUCCESS_RATE),
-      local_origin_sr_monitor_(envoy::data::cluster::v3::SUCCESS_RATE_LOCAL_ORIGIN) {
+      external_origin_sr_monitor_(envoy::data::cluster::v3::SUCCESS_RATE,
+                                  detector->config().accumulateSuccessRatePerWorker()),
+      local_origin_sr_monitor_(envoy::data::cluster::v3::SUCCESS_RATE_LOCAL_ORIGIN,
+                               detector->config().accumulateSuccessRatePerWorker()) {
   // Setup method to call when putResult is invoked. Depending on the config's
   // split_external_local_origin_errors_ boolean value different method is called.
   put_result_func_ = detector->config().splitExternalLocalOriginErrors()
@@ -89,8 +91,8 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
     }
   } else {
     external_origin_sr_monitor_.incSuccessReqCounter();
-    consecutive_5xx_ = 0;
-    consecutive_gateway_failure_ = 0;
+    resetConsecutive5xx();
+    resetConsecutiveGatewayFailure();
   }
 }
 
@@ -259,7 +261,8 @@ DetectorConfig::DetectorConfig(const envoy::config::cluster::v3::OutlierDetectio
       max_ejection_time_jitter_ms_(static_cast<uint64_t>(PROTOBUF_GET_MS_OR_DEFAULT(
           config, max_ejection_time_jitter, DEFAULT_MAX_EJECTION_TIME_JITTER_MS))),
       successful_active_health_check_uneject_host_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
-          config, successful_active_health_check_uneject_host, true)) {}
+          config, successful_active_health_check_uneject_host, true)),
+      accumulate_success_rate_per_worker_(config.accumulate_success_rate_per_worker()) {}
 
 DetectorImpl::DetectorImpl(const Cluster& cluster,
                            const envoy::config::cluster::v3::OutlierDetection& config,
@@ -860,25 +863,35 @@ void EventLoggerImpl::setCommonEventParams(envoy::data::cluster::v3::OutlierDete
   TimestampUtil::systemClockToTimestamp(time_source_.systemTime(), *event.mutable_timestamp());
 }
 
-SuccessRateAccumulatorBucket* SuccessRateAccumulator::updateCurrentWriter() {
+void SuccessRateAccumulator::updateCurrentWriter() {
   // Right now current is being written to and backup is not. Flush the backup and swap.
-  backup_success_rate_bucket_->success_request_counter_ = 0;
-  backup_success_rate_bucket_->total_request_counter_ = 0;
-
-  current_success_rate_bucket_.swap(backup_success_rate_bucket_);
-
-  return current_success_rate_bucket_.get();
-}
-
-absl::optional<std::pair<double, uint64_t>> SuccessRateAccumulator::getSuccessRateAndVolume() {
-  if (!backup_success_rate_bucket_->total_request_counter_) {
+  const uint32_t backup_bucket = 1 - currentBucket();
+  for (uint32_t i = 0; i < num_shards_; i++) {
+    shards_[i].success_request_counter_[backup_bucket].store(0, std::memory_order_relaxed);
+    shards_[i].total_request_counter_[backup_bucket].store(0, std::memory_order_relaxed);
+  }
+  current_bucket_.store(backup_bucket);
+}
+
+absl::optional<std::pair<double, uint64_t>>
+SuccessRateAccumulator::getSuccessRateAndVolume() const {
+  // Merge the counts the workers accumulated during the last interval.
+  const uint32_t backup_bucket = 1 - currentBucket();
+  uint64_t success_request_counter = 0;
+  uint64_t total_request_counter = 0;
+  for (uint32_t i = 0; i < num_shards_; i++) {
+    success_request_counter +=
+        shards_[i].success_request_counter_[backup_bucket].load(std::memory_order_relaxed);
+    total_request_counter +=
+        shards_[i].total_request_counter_[backup_bucket].load(std::memory_order_relaxed);
+  }
+  if (!total_request_counter) {
     return absl::nullopt;
   }
 
-  double success_rate = backup_success_rate_bucket_->success_request_counter_ * 100.0 /
-                        backup_success_rate_bucket_->total_request_counter_;
+  double success_rate = success_request_counter * 100.0 / total_request_counter;
 
-  return {{success_rate, backup_success_rate_bucket_->total_request_counter_}};
+  return {{success_rate, total_request_counter}};
 }
 
 } // namespace Outlier
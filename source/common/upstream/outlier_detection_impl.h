@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -21,6 +22,7 @@
 #include "envoy/stats/stats.h"
 #include "envoy/upstream/outlier_detection.h"
 
+#include "source/common/common/sharded_counter.h"
 #include "source/common/upstream/upstream_impl.h"
 
 #include "absl/container/node_hash_map.h"
@@ -50,66 +52,80 @@ struct HostSuccessRatePair {
   double success_rate_;
 };
 
-struct SuccessRateAccumulatorBucket {
-  std::atomic<uint64_t> success_request_counter_;
-  std::atomic<uint64_t> total_request_counter_;
-};
-
 /**
- * The SuccessRateAccumulator uses the SuccessRateAccumulatorBucket to get per host success rate
- * stats. This implementation has a fixed window size of time, and thus only needs a
+ * The SuccessRateAccumulator counts the requests and successful requests of a host to compute its
+ * success rate. This implementation has a fixed window size of time, and thus only needs a
  * bucket to write to, and a bucket to accumulate/run stats over.
+ *
+ * The counters are either shared by all threads, or split into cache-line-aligned shards which
+ * are written by different worker threads and summed when the success rate is computed on the
+ * main thread. Sharding avoids having every worker write the same cache line for each request to
+ * a busy host.
  */
 class SuccessRateAccumulator {
 public:
-  SuccessRateAccumulator()
-      : current_success_rate_bucket_(new SuccessRateAccumulatorBucket()),
-        backup_success_rate_bucket_(new SuccessRateAccumulatorBucket()) {}
+  /**
+   * @param per_worker supplies whether each worker thread accumulates into its own shard.
+   */
+  explicit SuccessRateAccumulator(bool per_worker)
+      : num_shards_(per_worker ? ShardedCounter::NumShards : 1),
+        shards_(std::make_unique<Shard[]>(num_shards_)) {}
+
+  void incTotalReqCounter() {
+    writerShard().total_request_counter_[currentBucket()].fetch_add(1, std::memory_order_relaxed);
+  }
+  void incSuccessReqCounter() {
+    writerShard().success_request_counter_[currentBucket()].fetch_add(1,
+                                                                      std::memory_order_relaxed);
+  }
 
   /**
-   * This function updates the bucket to write data to.
-   * @return a pointer to the SuccessRateAccumulatorBucket.
+   * This function switches the bucket to write data to. The bucket that was written to so far is
+   * the one used by getSuccessRateAndVolume() until the next switch.
    */
-  SuccessRateAccumulatorBucket* updateCurrentWriter();
+  void updateCurrentWriter();
   /**
    * This function returns the success rate of a host over a window of time if the request volume is
    * high enough. The underlying window of time could be dynamically adjusted. In the current
    * implementation it is a fixed time window.
-   * @param success_rate_request_volume the threshold of requests an accumulator has to have in
-   *                                    order to be able to return a significant success rate value.
    * @return a valid absl::optional<double> with the success rate. If there were not enough
    * requests, an invalid absl::optional<double> is returned.
    */
-  absl::optional<std::pair<double, uint64_t>> getSuccessRateAndVolume();
+  absl::optional<std::pair<double, uint64_t>> getSuccessRateAndVolume() const;
 
 private:
-  std::unique_ptr<SuccessRateAccumulatorBucket> current_success_rate_bucket_;
-  std::unique_ptr<SuccessRateAccumulatorBucket> backup_success_rate_bucket_;
+  // Counters indexed by bucket. One bucket is written to while the other holds the counts of the
+  // last interval.
+  struct ABSL_CACHELINE_ALIGNED Shard {
+    std::array<std::atomic<uint64_t>, 2> success_request_counter_{};
+    std::array<std::atomic<uint64_t>, 2> total_request_counter_{};
+  };
+
+  uint32_t currentBucket() const { return current_bucket_.load(std::memory_order_relaxed); }
+  Shard& writerShard() {
+    return num_shards_ == 1 ? shards_[0] : shards_[ShardedCounter::shardIndex()];
+  }
+
+  const uint32_t num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<uint32_t> current_bucket_{0};
 };
 
 class SuccessRateMonitor {
 public:
-  SuccessRateMonitor(envoy::data::cluster::v3::OutlierEjectionType ejection_type)
-      : ejection_type_(ejection_type) {
-    // Point the success_rate_accumulator_bucket_ pointer to a bucket.
-    updateCurrentSuccessRateBucket();
-  }
+  SuccessRateMonitor(envoy::data::cluster::v3::OutlierEjectionType ejection_type, bool per_worker)
+      : success_rate_accumulator_(per_worker), ejection_type_(ejection_type) {}
   double getSuccessRate() const { return success_rate_; }
   SuccessRateAccumulator& successRateAccumulator() { return success_rate_accumulator_; }
   void setSuccessRate(double new_success_rate) { success_rate_ = new_success_rate; }
-  void updateCurrentSuccessRateBucket() {
-    success_rate_accumulator_bucket_.store(success_rate_accumulator_.updateCurrentWriter());
-  }
-  void incTotalReqCounter() { success_rate_accumulator_bucket_.load()->total_request_counter_++; }
-  void incSuccessReqCounter() {
-    success_rate_accumulator_bucket_.load()->success_request_counter_++;
-  }
+  void updateCurrentSuccessRateBucket() { success_rate_accumulator_.updateCurrentWriter(); }
+  void incTotalReqCounter() { success_rate_accumulator_.incTotalReqCounter(); }
+  void incSuccessReqCounter() { success_rate_accumulator_.incSuccessReqCounter(); }
 
   envoy::data::cluster::v3::OutlierEjectionType getEjectionType() const { return ejection_type_; }
 
 private:
   SuccessRateAccumulator success_rate_accumulator_;
-  std::atomic<SuccessRateAccumulatorBucket*> success_rate_accumulator_bucket_;
   envoy::data::cluster::v3::OutlierEjectionType ejection_type_;
   double success_rate_{-1};
 };
@@ -128,9 +144,11 @@ public:
 
   uint32_t& ejectTimeBackoff() { return eject_time_backoff_; }
 
-  void resetConsecutive5xx() { consecutive_5xx_ = 0; }
-  void resetConsecutiveGatewayFailure() { consecutive_gateway_failure_ = 0; }
-  void resetConsecutiveLocalOriginFailure() { consecutive_local_origin_failure_ = 0; }
+  // Most results are successes, which reset these counters. The counters are only written when
+  // they are not already zero, so that workers do not keep stealing the cache line from each other.
+  void resetConsecutive5xx() { resetConsecutive(consecutive_5xx_); }
+  void resetConsecutiveGatewayFailure() { resetConsecutive(consecutive_gateway_failure_); }
+  void resetConsecutiveLocalOriginFailure() { resetConsecutive(consecutive_local_origin_failure_); }
   static absl::optional<Http::Code> resultToHttpCode(Result result);
 
   // Upstream::Outlier::DetectorHostMonitor
@@ -173,6 +191,12 @@ public:
   std::chrono::milliseconds getJitter() const { return jitter_; }
 
 private:
+  static void resetConsecutive(std::atomic<uint32_t>& counter) {
+    if (counter.load(std::memory_order_relaxed) != 0) {
+      counter = 0;
+    }
+  }
+
   std::weak_ptr<DetectorImpl> detector_;
   std::weak_ptr<Host> host_;
   absl::optional<MonotonicTime> last_ejection_time_;
@@ -316,6 +340,7 @@ public:
   bool successfulActiveHealthCheckUnejectHost() const {
     return successful_active_health_check_uneject_host_;
   }
+  bool accumulateSuccessRatePerWorker() const { return accumulate_success_rate_per_worker_; }
 
 private:
   const uint64_t interval_ms_;
@@ -341,6 +366,7 @@ private:
   const uint64_t max_ejection_time_ms_;
   const uint64_t max_ejection_time_jitter_ms_;
   const bool successful_active_health_check_uneject_host_;
+  const bool accumulate_success_rate_per_worker_;
 
   static constexpr uint64_t DEFAULT_INTERVAL_MS = 10000;
   static constexpr uint64_t DEFAULT_BASE_EJECTION_TIME_MS = 30000;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <memory>
@@ -12,28 +13,52 @@
 
 #include "source/common/common/assert.h"
 #include "source/common/common/basic_resource_impl.h"
+#include "source/common/common/sharded_counter.h"
 
 namespace Envoy {
 namespace Upstream {
 
 struct ManagedResourceImpl : public BasicResourceLimitImpl {
+  // The largest flush threshold used for sharded counts, which bounds how far the count can lag
+  // behind for resources with a very high or unlimited maximum.
+  static constexpr uint64_t MaxShardedFlushThreshold = 64;
+
+  /**
+   * @param sharded supplies whether updates are accumulated in per-worker shards and only added to
+   *        the count in batches. The batch size is chosen so that the count lags the exact value by
+   *        less than 1/16th of max. If max is too small for batches of at least two, the count is
+   *        kept exactly.
+   */
   ManagedResourceImpl(uint64_t max, Runtime::Loader& runtime, const std::string& runtime_key,
-                      Stats::Gauge& open_gauge, Stats::Gauge& remaining)
+                      Stats::Gauge& open_gauge, Stats::Gauge& remaining, bool sharded = false)
       : BasicResourceLimitImpl(max, runtime, runtime_key), open_gauge_(open_gauge),
-        remaining_(remaining) {
+        remaining_(remaining), shards_(sharded ? createShards(max) : nullptr) {
     remaining_.set(max);
   }
 
   // BasicResourceLimitImpl
+  bool canCreate() override { return count() < max(); }
   void inc() override {
+    if (shards_ != nullptr) {
+      addFlushed(shards_->add(1));
+      return;
+    }
     BasicResourceLimitImpl::inc();
-    updateRemaining();
-    open_gauge_.set(BasicResourceLimitImpl::canCreate() ? 0 : 1);
+    updateGauges();
   }
   void decBy(uint64_t amount) override {
+    if (shards_ != nullptr) {
+      addFlushed(shards_->add(-static_cast<int64_t>(amount)));
+      return;
+    }
     BasicResourceLimitImpl::decBy(amount);
-    updateRemaining();
-    open_gauge_.set(BasicResourceLimitImpl::canCreate() ? 0 : 1);
+    updateGauges();
+  }
+  uint64_t count() const override {
+    // With sharded counts, one worker may flush a release before the worker that acquired the
+    // resource flushes the acquisition, so the count can briefly wrap below zero.
+    const uint64_t current = current_.load();
+    return static_cast<int64_t>(current) > 0 ? current : 0;
   }
 
   /**
@@ -46,10 +71,33 @@ struct ManagedResourceImpl : public BasicResourceLimitImpl {
      * We cannot use std::max here because max() and current_ are
      * unsigned and subtracting them may overflow.
      */
-    const uint64_t current_copy = current_;
+    const uint64_t current_copy = count();
     remaining_.set(max() > current_copy ? max() - current_copy : 0);
   }
 
+  void updateGauges() {
+    updateRemaining();
+    open_gauge_.set(canCreate() ? 0 : 1);
+  }
+
+  void addFlushed(int64_t delta) {
+    if (delta == 0) {
+      return;
+    }
+    // Negative deltas wrap around, which subtracts them.
+    current_ += static_cast<uint64_t>(delta);
+    updateGauges();
+  }
+
+  static std::unique_ptr<ShardedCounter> createShards(uint64_t max) {
+    const uint64_t flush_threshold = std::min<uint64_t>(
+        max / (ShardedCounter::NumShards * 16), MaxShardedFlushThreshold);
+    if (flush_threshold < 2) {
+      return nullptr;
+    }
+    return std::make_unique<ShardedCounter>(flush_threshold);
+  }
+
   /**
    * A gauge to notify the live circuit breaker state. The gauge is set to 0
    * to notify that the circuit breaker is not yet triggered.
@@ -60,6 +108,11 @@ struct ManagedResourceImpl : public BasicResourceLimitImpl {
    * The number of resources remaining before the circuit breaker opens.
    */
   Stats::Gauge& remaining_;
+
+  /**
+   * Per-worker shards of the count, if sharded counts are enabled for this resource.
+   */
+  const std::unique_ptr<ShardedCounter> shards_;
 };
 
 /**
@@ -70,6 +123,8 @@ struct ManagedResourceImpl : public BasicResourceLimitImpl {
  *    occur during high contention.
  * 2) Though atomics are used, it is possible for resources to temporarily go above the supplied
  *    maximums. This should not effect overall behavior.
+ * 3) If sharded counts are enabled, the counts are only updated in batches and lag the exact values
+ *    by a bounded amount. @see ManagedResourceImpl.
  */
 class ResourceManagerImpl : public ResourceManager {
 public:
@@ -78,20 +133,20 @@ public:
                       uint64_t max_requests, uint64_t max_retries, uint64_t max_connection_pools,
                       uint64_t max_connections_per_host, ClusterCircuitBreakersStats cb_stats,
                       absl::optional<double> budget_percent,
-                      absl::optional<uint32_t> min_retry_concurrency)
+                      absl::optional<uint32_t> min_retry_concurrency, bool sharded_counts = false)
       : connections_(max_connections, runtime, runtime_key + "max_connections", cb_stats.cx_open_,
-                     cb_stats.remaining_cx_),
+                     cb_stats.remaining_cx_, sharded_counts),
         pending_requests_(max_pending_requests, runtime, runtime_key + "max_pending_requests",
-                          cb_stats.rq_pending_open_, cb_stats.remaining_pending_),
+                          cb_stats.rq_pending_open_, cb_stats.remaining_pending_, sharded_counts),
         requests_(max_requests, runtime, runtime_key + "max_requests", cb_stats.rq_open_,
-                  cb_stats.remaining_rq_),
+                  cb_stats.remaining_rq_, sharded_counts),
         connection_pools_(max_connection_pools, runtime, runtime_key + "max_connection_pools",
-                          cb_stats.cx_pool_open_, cb_stats.remaining_cx_pools_),
+                          cb_stats.cx_pool_open_, cb_stats.remaining_cx_pools_, sharded_counts),
         max_connections_per_host_(max_connections_per_host),
         retries_(budget_percent, min_retry_concurrency, max_retries, runtime,
                  runtime_key + "retry_budget.", runtime_key + "max_retries",
                  cb_stats.rq_retry_open_, cb_stats.remaining_retries_, requests_,
-                 pending_requests_) {}
+                 pending_requests_, sharded_counts) {}
 
   // Upstream::ResourceManager
   ResourceLimit& connections() override { return connections_; }
@@ -109,9 +164,9 @@ private:
                     Runtime::Loader& runtime, const std::string& retry_budget_runtime_key,
                     const std::string& max_retries_runtime_key, Stats::Gauge& open_gauge,
                     Stats::Gauge& remaining, const ResourceLimit& requests,
-                    const ResourceLimit& pending_requests)
-        : runtime_(runtime),
-          max_retry_resource_(max_retries, runtime, max_retries_runtime_key, open_gauge, remaining),
+                    const ResourceLimit& pending_requests, bool sharded_counts)
+        : runtime_(runtime), max_retry_resource_(max_retries, runtime, max_retries_runtime_key,
+                                                 open_gauge, remaining, sharded_counts),
           budget_percent_(budget_percent), min_retry_concurrency_(min_retry_concurrency),
           budget_percent_key_(retry_budget_runtime_key + "budget_percent"),
           min_retry_concurrency_key_(retry_budget_runtime_key + "min_retry_concurrency"),
@@ -7,6 +7,8 @@
 #include "envoy/extensions/load_balancing_policies/subset/v3/subset.pb.validate.h"
 #include "envoy/upstream/load_balancer.h"
 
+#include "source/common/protobuf/utility.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -58,11 +60,17 @@ public:
   using SubsetFallbackPolicy = envoy::config::cluster::v3::Cluster::LbSubsetConfig::
       LbSubsetSelector::LbSubsetSelectorFallbackPolicy;
 
+  static constexpr uint32_t DefaultMaxLazySubsets = 1024;
+
   LoadBalancerSubsetInfoImpl(const SubsetLoadbalancingPolicyProto& subset_config)
       : default_subset_(subset_config.default_subset()),
         fallback_policy_(static_cast<FallbackPolicy>(subset_config.fallback_policy())),
         metadata_fallback_policy_(
             static_cast<MetadataFallbackPolicy>(subset_config.metadata_fallback_policy())),
+        max_lazy_subsets_(subset_config.has_lazy_subsets()
+                              ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(subset_config.lazy_subsets(),
+                                                                max_subsets, DefaultMaxLazySubsets)
+                              : 0),
         enabled_(!subset_config.subset_selectors().empty()),
         locality_weight_aware_(subset_config.locality_weight_aware()),
         scale_locality_weight_(subset_config.scale_locality_weight()),
@@ -121,6 +129,7 @@ public:
   bool panicModeAny() const override { return panic_mode_any_; }
   bool listAsAny() const override { return list_as_any_; }
   bool allowRedundantKeys() const override { return allow_redundant_keys_; }
+  uint32_t maxLazySubsets() const override { return max_lazy_subsets_; }
 
 private:
   const ProtobufWkt::Struct default_subset_;
@@ -128,6 +137,7 @@ private:
   // Keep small members (bools and enums) at the end of class, to reduce alignment overhead.
   const FallbackPolicy fallback_policy_;
   const MetadataFallbackPolicy metadata_fallback_policy_;
+  const uint32_t max_lazy_subsets_{};
   const bool enabled_ : 1;
   const bool locality_weight_aware_ : 1;
   const bool scale_locality_weight_ : 1;
@@ -57,12 +57,60 @@
 #include "source/extensions/filters/network/http_connection_manager/config.h"
 #include "source/server/transport_socket_config_impl.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/node_hash_set.h"
 #include "absl/strings/str_cat.h"
 
 namespace Envoy {
 namespace Upstream {
 namespace {
+// The number of requests a worker may start or finish on a host before they are added to the
+// host's rq_active stat, when sharded endpoint request counts are enabled.
+constexpr uint32_t ShardedRequestCountFlushThreshold = 4;
+
+// Interns the localities of hosts, so that all the hosts in a locality share its proto and zone
+// stat name. Hosts may be created on workers (e.g. by the original destination cluster), so unlike
+// the per-cluster metadata pool, this pool is locked. The lock is only taken when a host is created
+// or the last host of a locality is destroyed. Dynamic stat names are encoded without the symbol
+// table, so a locality can be shared by hosts of stores with different symbol tables.
+class HostLocalityPool {
+public:
+  static HostLocalityPool& get() { MUTABLE_CONSTRUCT_ON_FIRST_USE(HostLocalityPool); }
+
+  HostLocalityConstSharedPtr intern(const envoy::config::core::v3::Locality& locality,
+                                    Stats::SymbolTable& symbol_table) {
+    absl::MutexLock lock(&mutex_);
+    std::weak_ptr<const HostLocality>& entry = localities_[locality];
+    HostLocalityConstSharedPtr host_locality = entry.lock();
+    if (host_locality == nullptr) {
+      host_locality = HostLocalityConstSharedPtr(
+          new HostLocality(locality, symbol_table),
+          [this](const HostLocality* host_locality) { release(host_locality); });
+      entry = host_locality;
+    }
+    return host_locality;
+  }
+
+private:
+  void release(const HostLocality* host_locality) {
+    {
+      absl::MutexLock lock(&mutex_);
+      auto it = localities_.find(host_locality->locality_);
+      // The locality may have been interned again after its last reference was dropped, but
+      // before this took the lock, in which case the entry refers to the new instance.
+      if (it != localities_.end() && it->second.expired()) {
+        localities_.erase(it);
+      }
+    }
+    delete host_locality;
+  }
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<envoy::config::core::v3::Locality, std::weak_ptr<const HostLocality>,
+                      LocalityHash, LocalityEqualTo>
+      localities_ ABSL_GUARDED_BY(mutex_);
+};
+
 std::string addressToString(Network::Address::InstanceConstSharedPtr address) {
   if (!address) {
     return "";
@@ -401,13 +449,17 @@ HostDescriptionImpl::HostDescriptionImpl(
     const envoy::config::endpoint::v3::Endpoint::HealthCheckConfig& health_check_config,
     uint32_t priority, TimeSource& time_source)
     : cluster_(cluster), hostname_(hostname),
-      health_checks_hostname_(health_check_config.hostname()), address_(dest_address),
+      health_checks_hostname_(health_check_config.hostname().empty()
+                                  ? nullptr
+                                  : std::make_unique<const std::string>(
+                                        health_check_config.hostname())),
+      address_(dest_address),
       canary_(Config::Metadata::metadataValue(metadata.get(),
                                               Config::MetadataFilters::get().ENVOY_LB,
                                               Config::MetadataEnvoyLbKeys::get().CANARY)
                   .bool_value()),
-      metadata_(metadata), locality_(locality),
-      locality_zone_stat_name_(locality.zone(), cluster->statsScope().symbolTable()),
+      metadata_(metadata),
+      locality_(HostLocalityPool::get().intern(locality, cluster->statsScope().symbolTable())),
       priority_(priority),
       socket_factory_(resolveTransportSocketFactory(dest_address, metadata_.get())),
       creation_time_(time_source.monotonicTime()) {
@@ -420,6 +472,32 @@ HostDescriptionImpl::HostDescriptionImpl(
   health_check_address_ = resolveHealthCheckAddress(health_check_config, dest_address);
 }
 
+HostDescriptionImpl::~HostDescriptionImpl() { delete stats_.load(std::memory_order_acquire); }
+
+HostStats& HostDescriptionImpl::createStats() const {
+  auto stats = std::make_unique<HostStats>();
+  if (cluster_->shardedEndpointRequestCountsEnabled()) {
+    stats->rq_active_shards_ = std::make_unique<ShardedCounter>(ShardedRequestCountFlushThreshold);
+  }
+  // Workers may race to allocate the stats. The first one wins and the others use its stats.
+  HostStats* expected = nullptr;
+  if (stats_.compare_exchange_strong(expected, stats.get(), std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+    return *stats.release();
+  }
+  return *expected;
+}
+
+HostStats& HostDescriptionImpl::allocatedStatsOrEmpty() const {
+  HostStats* stats = stats_.load(std::memory_order_acquire);
+  if (stats != nullptr) {
+    return *stats;
+  }
+  // Nothing ever adds to these, so latching them from any thread is harmless.
+  static HostStats* empty_stats = new HostStats();
+  return *empty_stats;
+}
+
 Network::UpstreamTransportSocketFactory& HostDescriptionImpl::resolveTransportSocketFactory(
     const Network::Address::InstanceConstSharedPtr& dest_address,
     const envoy::config::core::v3::Metadata* metadata) const {
@@ -1080,13 +1158,17 @@ ClusterInfoImpl::ClusterInfoImpl(
       drain_connections_on_host_removal_(config.ignore_health_on_host_removal()),
       connection_pool_per_downstream_connection_(
           config.connection_pool_per_downstream_connection()),
+      shared_http_connection_pool_(config.shared_http_connection_pool()),
       warm_hosts_(!config.health_checks().empty() &&
                   common_lb_config_->ignore_new_hosts_until_first_hc()),
       set_local_interface_name_on_upstream_connections_(
           config.upstream_connection_options().set_local_interface_name_on_upstream_connections()),
       added_via_api_(added_via_api), has_configured_http_filters_(false),
       per_endpoint_stats_(config.has_track_cluster_stats() &&
-                          config.track_cluster_stats().per_endpoint_stats()) {
+                          config.track_cluster_stats().per_endpoint_stats()),
+      sharded_endpoint_request_counts_(
+          config.has_track_cluster_stats() &&
+          config.track_cluster_stats().sharded_endpoint_request_counts()) {
 #ifdef WIN32
   if (set_local_interface_name_on_upstream_connections_) {
     throwEnvoyExceptionOrPanic(
@@ -1852,6 +1934,7 @@ ClusterInfoImpl::ResourceManagers::load(const envoy::config::cluster::v3::Cluste
   uint64_t max_connections_per_host = std::numeric_limits<uint64_t>::max();
 
   bool track_remaining = false;
+  bool sharded_counts = false;
 
   Stats::StatName priority_stat_name;
   std::string priority_name;
@@ -1892,6 +1975,7 @@ ClusterInfoImpl::ResourceManagers::load(const envoy::config::cluster::v3::Cluste
     max_requests = PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_requests, max_requests);
     max_retries = PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_retries, max_retries);
     track_remaining = it->track_remaining();
+    sharded_counts = it->sharded_counts();
     max_connection_pools =
         PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_connection_pools, max_connection_pools);
     std::tie(budget_percent, min_retry_concurrency) = ClusterInfoImpl::getRetryBudgetParams(*it);
@@ -1911,7 +1995,7 @@ ClusterInfoImpl::ResourceManagers::load(const envoy::config::cluster::v3::Cluste
       max_connection_pools, max_connections_per_host,
       ClusterInfoImpl::generateCircuitBreakersStats(stats_scope, priority_stat_name,
                                                     track_remaining, circuit_breakers_stat_names_),
-      budget_percent, min_retry_concurrency);
+      budget_percent, min_retry_concurrency, sharded_counts);
 }
 
 PriorityStateManager::PriorityStateManager(ClusterImplBase& cluster,
@@ -182,8 +182,27 @@ private:
   const absl::optional<MonotonicTime> time_{};
 };
 
+/**
+ * A locality and the stat name of its zone. Hosts in the same locality share a single instance,
+ * @see HostDescriptionImpl.
+ */
+struct HostLocality {
+  HostLocality(const envoy::config::core::v3::Locality& locality, Stats::SymbolTable& symbol_table)
+      : locality_(locality), zone_stat_name_(locality.zone(), symbol_table) {}
+
+  const envoy::config::core::v3::Locality locality_;
+  const Stats::StatNameDynamicStorage zone_stat_name_;
+};
+
+using HostLocalityConstSharedPtr = std::shared_ptr<const HostLocality>;
+
 /**
  * Implementation of Upstream::HostDescription.
+ *
+ * Clusters may have a very large number of hosts, most of which may never be picked by a worker,
+ * so the host representation is kept compact: the per-host stats are only allocated the first
+ * time they are accessed through stats(), the locality is interned so that all the hosts in a
+ * locality share it, and the health check hostname is only allocated if it is configured.
  */
 class HostDescriptionImpl : virtual public HostDescription,
                             protected Logger::Loggable<Logger::Id::upstream> {
@@ -194,6 +213,7 @@ public:
       const envoy::config::core::v3::Locality& locality,
       const envoy::config::endpoint::v3::Endpoint::HealthCheckConfig& health_check_config,
       uint32_t priority, TimeSource& time_source);
+  ~HostDescriptionImpl() override;
 
   Network::UpstreamTransportSocketFactory& transportSocketFactory() const override {
     absl::ReaderMutexLock lock(&metadata_mutex_);
@@ -249,9 +269,14 @@ public:
     static DetectorHostMonitorNullImpl* null_outlier_detector = new DetectorHostMonitorNullImpl();
     return *null_outlier_detector;
   }
-  HostStats& stats() const override { return stats_; }
+  HostStats& stats() const override {
+    HostStats* stats = stats_.load(std::memory_order_acquire);
+    return stats != nullptr ? *stats : createStats();
+  }
   LoadMetricStats& loadMetricStats() const override { return load_metric_stats_; }
-  const std::string& hostnameForHealthChecks() const override { return health_checks_hostname_; }
+  const std::string& hostnameForHealthChecks() const override {
+    return health_checks_hostname_ != nullptr ? *health_checks_hostname_ : EMPTY_STRING;
+  }
   const std::string& hostname() const override { return hostname_; }
   Network::Address::InstanceConstSharedPtr address() const override { return address_; }
   const std::vector<Network::Address::InstanceConstSharedPtr>& addressList() const override {
@@ -260,9 +285,11 @@ public:
   Network::Address::InstanceConstSharedPtr healthCheckAddress() const override {
     return health_check_address_;
   }
-  const envoy::config::core::v3::Locality& locality() const override { return locality_; }
+  const envoy::config::core::v3::Locality& locality() const override {
+    return locality_->locality_;
+  }
   Stats::StatName localityZoneStatName() const override {
-    return locality_zone_stat_name_.statName();
+    return locality_->zone_stat_name_.statName();
   }
   uint32_t priority() const override { return priority_; }
   void priority(uint32_t priority) override { priority_ = priority; }
@@ -295,10 +322,19 @@ protected:
     last_hc_pass_time_.emplace(std::move(last_hc_pass_time));
   }
 
+  /**
+   * @return the stats of this host if they have been allocated, or stats which are all zero
+   *         otherwise. This is meant for readers of the stats of every host, which should not
+   *         allocate the stats of hosts which have never been used.
+   */
+  HostStats& allocatedStatsOrEmpty() const;
+
 private:
+  HostStats& createStats() const;
+
   ClusterInfoConstSharedPtr cluster_;
   const std::string hostname_;
-  const std::string health_checks_hostname_;
+  const std::unique_ptr<const std::string> health_checks_hostname_;
   Network::Address::InstanceConstSharedPtr address_;
   // The first entry in the address_list_ should match the value in address_.
   std::vector<Network::Address::InstanceConstSharedPtr> address_list_;
@@ -306,9 +342,9 @@ private:
   std::atomic<bool> canary_;
   mutable absl::Mutex metadata_mutex_;
   MetadataConstSharedPtr metadata_ ABSL_GUARDED_BY(metadata_mutex_);
-  const envoy::config::core::v3::Locality locality_;
-  Stats::StatNameDynamicStorage locality_zone_stat_name_;
-  mutable HostStats stats_;
+  const HostLocalityConstSharedPtr locality_;
+  // Allocated on first use by stats(), and owned by this host.
+  mutable std::atomic<HostStats*> stats_{};
   mutable LoadMetricStatsImpl load_metric_stats_;
   Outlier::DetectorHostMonitorPtr outlier_detector_;
   HealthCheckHostMonitorPtr health_checker_;
@@ -349,7 +385,7 @@ public:
   // Upstream::Host
   std::vector<std::pair<absl::string_view, Stats::PrimitiveCounterReference>>
   counters() const override {
-    return stats().counters();
+    return allocatedStatsOrEmpty().counters();
   }
   CreateConnectionData createConnection(
       Event::Dispatcher& dispatcher, const Network::ConnectionSocket::OptionsSharedPtr& options,
@@ -361,7 +397,7 @@ public:
 
   std::vector<std::pair<absl::string_view, Stats::PrimitiveGaugeReference>>
   gauges() const override {
-    return stats().gauges();
+    return allocatedStatsOrEmpty().gauges();
   }
   void healthFlagClear(HealthFlag flag) override { health_flags_ &= ~enumToInt(flag); }
   bool healthFlagGet(HealthFlag flag) const override { return health_flags_ & enumToInt(flag); }
@@ -981,6 +1017,9 @@ public:
   }
 
   bool perEndpointStatsEnabled() const override { return per_endpoint_stats_; }
+  bool shardedEndpointRequestCountsEnabled() const override {
+    return sharded_endpoint_request_counts_;
+  }
 
   UpstreamLocalAddressSelectorConstSharedPtr getUpstreamLocalAddressSelector() const override {
     return upstream_local_address_selector_;
@@ -1010,6 +1049,7 @@ public:
   bool connectionPoolPerDownstreamConnection() const override {
     return connection_pool_per_downstream_connection_;
   }
+  bool sharedHttpConnectionPool() const override { return shared_http_connection_pool_; }
   bool warmHosts() const override { return warm_hosts_; }
   bool setLocalInterfaceNameOnUpstreamConnections() const override {
     return set_local_interface_name_on_upstream_connections_;
@@ -1149,12 +1189,14 @@ private:
   const envoy::config::cluster::v3::Cluster::DiscoveryType type_;
   const bool drain_connections_on_host_removal_ : 1;
   const bool connection_pool_per_downstream_connection_ : 1;
+  const bool shared_http_connection_pool_ : 1;
   const bool warm_hosts_ : 1;
   const bool set_local_interface_name_on_upstream_connections_ : 1;
   const bool added_via_api_ : 1;
   // true iff the cluster proto specified upstream http filters.
   bool has_configured_http_filters_ : 1;
   const bool per_endpoint_stats_ : 1;
+  const bool sharded_endpoint_request_counts_ : 1;
 };
 
 /**
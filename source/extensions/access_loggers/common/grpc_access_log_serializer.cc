@@ -0,0 +1,58 @@
+#include "source/extensions/access_loggers/common/grpc_access_log_serializer.h"
+
+#include "source/common/common/lock_guard.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Common {
+
+GrpcAccessLogSerializer::GrpcAccessLogSerializer(Thread::ThreadFactory& thread_factory)
+    : thread_factory_(thread_factory) {}
+
+GrpcAccessLogSerializer::~GrpcAccessLogSerializer() {
+  Thread::ThreadPtr thread;
+  {
+    Thread::LockGuard guard(lock_);
+    exit_ = true;
+    queue_.clear();
+    thread = std::move(thread_);
+    work_available_.notifyOne();
+  }
+  if (thread != nullptr) {
+    thread->join();
+  }
+}
+
+void GrpcAccessLogSerializer::post(absl::AnyInvocable<void()> work) {
+  Thread::LockGuard guard(lock_);
+  queue_.push_back(std::move(work));
+  if (thread_ == nullptr) {
+    thread_ = thread_factory_.createThread([this]() -> void { threadRoutine(); },
+                                           Thread::Options{"AccessLogSerial"});
+  }
+  work_available_.notifyOne();
+}
+
+void GrpcAccessLogSerializer::threadRoutine() {
+  while (true) {
+    absl::AnyInvocable<void()> work;
+    {
+      Thread::LockGuard guard(lock_);
+      while (queue_.empty() && !exit_) {
+        work_available_.wait(lock_);
+      }
+      if (exit_) {
+        return;
+      }
+      work = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    work();
+  }
+}
+
+} // namespace Common
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
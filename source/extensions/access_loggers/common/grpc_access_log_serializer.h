@@ -0,0 +1,52 @@
+#pragma once
+
+#include <list>
+#include <memory>
+
+#include "envoy/thread/thread.h"
+
+#include "source/common/common/thread.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Common {
+
+/**
+ * Runs gRPC access log batch serialization on a dedicated thread, so that encoding a batch to the
+ * wire format and freeing it afterwards does not happen on the worker that produced it. The
+ * thread is only started on first use, so loggers that do not enable async serialization do not
+ * pay for it.
+ */
+class GrpcAccessLogSerializer {
+public:
+  explicit GrpcAccessLogSerializer(Thread::ThreadFactory& thread_factory);
+  ~GrpcAccessLogSerializer();
+
+  /**
+   * Queue work to run on the serialization thread. Work runs one item at a time, in the order it
+   * was posted. Work still queued when the serializer is destroyed is discarded without running.
+   * @param work supplies the closure to run.
+   */
+  void post(absl::AnyInvocable<void()> work);
+
+private:
+  void threadRoutine();
+
+  Thread::ThreadFactory& thread_factory_;
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar work_available_;
+  std::list<absl::AnyInvocable<void()>> queue_ ABSL_GUARDED_BY(lock_);
+  bool exit_ ABSL_GUARDED_BY(lock_){false};
+  Thread::ThreadPtr thread_ ABSL_GUARDED_BY(lock_);
+};
+
+using GrpcAccessLogSerializerSharedPtr = std::shared_ptr<GrpcAccessLogSerializer>;
+
+} // namespace Common
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -10,10 +10,14 @@
 #include "envoy/thread_local/thread_local.h"
 
 #include "source/common/common/assert.h"
+#include "source/common/common/lock_guard.h"
+#include "source/common/common/thread.h"
+#include "source/common/grpc/common.h"
 #include "source/common/grpc/typed_async_client.h"
 #include "source/common/http/utility.h"
 #include "source/common/protobuf/utility.h"
 #include "source/common/tracing/null_span_impl.h"
+#include "source/extensions/access_loggers/common/grpc_access_log_serializer.h"
 #include "source/extensions/access_loggers/common/grpc_access_logger_utils.h"
 
 #include "absl/container/flat_hash_map.h"
@@ -80,6 +84,8 @@ public:
   virtual ~GrpcAccessLogClient() = default;
   virtual bool isConnected() PURE;
   virtual bool log(const LogRequest& request) PURE;
+  // Same as log(), with a request that has already been serialized.
+  virtual bool logRaw(Buffer::InstancePtr&& request) PURE;
 
 protected:
   GrpcAccessLogClient(const Grpc::RawAsyncClientSharedPtr& client,
@@ -126,6 +132,14 @@ public:
     return true;
   }
 
+  bool logRaw(Buffer::InstancePtr&& request) override {
+    GrpcAccessLogClient<LogRequest, LogResponse>::client_->sendRaw(
+        GrpcAccessLogClient<LogRequest, LogResponse>::service_method_, std::move(request),
+        request_cb_, Tracing::NullSpan::instance(),
+        GrpcAccessLogClient<LogRequest, LogResponse>::opts_);
+    return true;
+  }
+
   struct RequestCallbacks : public Grpc::AsyncRequestCallbacks<LogResponse> {
     // Grpc::AsyncRequestCallbacks
     void onSuccess(Grpc::ResponsePtr<LogResponse>&&, Tracing::Span&) override {}
@@ -170,6 +184,32 @@ public:
   bool isConnected() override { return stream_ != nullptr && stream_->stream_ != nullptr; }
 
   bool log(const LogRequest& request) override {
+    Grpc::AsyncStream<LogRequest>* stream = activeStream();
+    if (stream != nullptr) {
+      if (stream->isAboveWriteBufferHighWatermark()) {
+        return false;
+      }
+      stream->sendMessage(request, false);
+    }
+    return true;
+  }
+
+  bool logRaw(Buffer::InstancePtr&& request) override {
+    Grpc::AsyncStream<LogRequest>* stream = activeStream();
+    if (stream != nullptr) {
+      if (stream->isAboveWriteBufferHighWatermark()) {
+        return false;
+      }
+      stream->sendMessageRaw(std::move(request), false);
+    }
+    return true;
+  }
+
+  std::unique_ptr<LocalStream> stream_;
+
+private:
+  // Returns the stream to send on, starting one if needed, or nullptr if it could not be started.
+  Grpc::AsyncStream<LogRequest>* activeStream() {
     if (!stream_) {
       stream_ = std::make_unique<LocalStream>(*this);
     }
@@ -180,19 +220,13 @@ public:
           GrpcAccessLogClient<LogRequest, LogResponse>::opts_);
     }
 
-    if (stream_->stream_ != nullptr) {
-      if (stream_->stream_->isAboveWriteBufferHighWatermark()) {
-        return false;
-      }
-      stream_->stream_->sendMessage(request, false);
-    } else {
+    if (stream_->stream_ == nullptr) {
       // Clear out the stream data due to stream creation failure.
       stream_.reset();
+      return nullptr;
     }
-    return true;
+    return &stream_->stream_;
   }
-
-  std::unique_ptr<LocalStream> stream_;
 };
 
 } // namespace Detail
@@ -200,15 +234,18 @@ public:
 /**
  * All stats for the grpc access logger. @see stats_macros.h
  */
-#define ALL_GRPC_ACCESS_LOGGER_STATS(COUNTER)                                                      \
+#define ALL_GRPC_ACCESS_LOGGER_STATS(COUNTER, GAUGE, HISTOGRAM)                                    \
   COUNTER(logs_written)                                                                            \
-  COUNTER(logs_dropped)
+  COUNTER(logs_dropped)                                                                            \
+  GAUGE(pending_serialization_batches, Accumulate)                                                 \
+  HISTOGRAM(batch_entries, Unspecified)
 
 /**
  * Wrapper struct for the access log stats. @see stats_macros.h
  */
 struct GrpcAccessLoggerStats {
-  ALL_GRPC_ACCESS_LOGGER_STATS(GENERATE_COUNTER_STRUCT)
+  ALL_GRPC_ACCESS_LOGGER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT,
+                               GENERATE_HISTOGRAM_STRUCT)
 };
 
 /**
@@ -225,15 +262,24 @@ public:
       const Grpc::RawAsyncClientSharedPtr& client,
       const envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig& config,
       Event::Dispatcher& dispatcher, Stats::Scope& scope, std::string access_log_prefix,
-      const Protobuf::MethodDescriptor& service_method, bool stream = true)
-      : buffer_flush_interval_msec_(
+      const Protobuf::MethodDescriptor& service_method, bool stream = true,
+      GrpcAccessLogSerializerSharedPtr serializer = nullptr)
+      : dispatcher_(dispatcher), buffer_flush_interval_msec_(
             PROTOBUF_GET_MS_OR_DEFAULT(config, buffer_flush_interval, 1000)),
         flush_timer_(dispatcher.createTimer([this]() {
           flush();
           flush_timer_->enableTimer(buffer_flush_interval_msec_);
         })),
         max_buffer_size_bytes_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, buffer_size_bytes, 16384)),
-        stats_({ALL_GRPC_ACCESS_LOGGER_STATS(POOL_COUNTER_PREFIX(scope, access_log_prefix))}) {
+        max_pending_batches_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.async_serialization(),
+                                                             max_pending_batches, 16)),
+        stats_({ALL_GRPC_ACCESS_LOGGER_STATS(POOL_COUNTER_PREFIX(scope, access_log_prefix),
+                                             POOL_GAUGE_PREFIX(scope, access_log_prefix),
+                                             POOL_HISTOGRAM_PREFIX(scope, access_log_prefix))}) {
+    if (config.has_async_serialization() && serializer != nullptr) {
+      serializer_ = std::move(serializer);
+      async_state_ = std::make_shared<AsyncSerializationState>(this);
+    }
     if (stream) {
       client_ = std::make_unique<Detail::StreamingGrpcAccessLogClient<LogRequest, LogResponse>>(
           client, service_method, GrpcCommon::optionalRetryPolicy(config));
@@ -244,11 +290,21 @@ public:
     flush_timer_->enableTimer(buffer_flush_interval_msec_);
   }
 
+  ~GrpcAccessLogger() override {
+    if (async_state_ != nullptr) {
+      // Batches still on the serialization thread are discarded once they complete.
+      Thread::LockGuard guard(async_state_->lock_);
+      async_state_->logger_ = nullptr;
+      stats_.pending_serialization_batches_.sub(pending_batches_);
+    }
+  }
+
   void log(HttpLogProto&& entry) override {
     if (!canLogMore()) {
       return;
     }
     approximate_message_size_bytes_ += entry.ByteSizeLong();
+    ++batch_entries_;
     addEntry(std::move(entry));
     if (approximate_message_size_bytes_ >= max_buffer_size_bytes_) {
       flush();
@@ -257,6 +313,7 @@ public:
 
   void log(TcpLogProto&& entry) override {
     approximate_message_size_bytes_ += entry.ByteSizeLong();
+    ++batch_entries_;
     addEntry(std::move(entry));
     if (approximate_message_size_bytes_ >= max_buffer_size_bytes_) {
       flush();
@@ -273,6 +330,24 @@ private:
   virtual void addEntry(HttpLogProto&& entry) PURE;
   virtual void addEntry(TcpLogProto&& entry) PURE;
   virtual void clearMessage() { message_.Clear(); }
+  // Moves the pending entries into a new message, leaving message_ ready for the next batch.
+  virtual std::unique_ptr<LogRequest> takeMessage() {
+    auto message = std::make_unique<LogRequest>();
+    message->Swap(&message_);
+    return message;
+  }
+
+  /**
+   * State shared with batches that are in flight on the serialization thread. The logger detaches
+   * itself on destruction so that late completions are discarded instead of touching it.
+   */
+  struct AsyncSerializationState {
+    AsyncSerializationState(GrpcAccessLogger* logger) : logger_(logger) {}
+
+    Thread::MutexBasicLockable lock_;
+    GrpcAccessLogger* logger_ ABSL_GUARDED_BY(lock_);
+  };
+  using AsyncSerializationStateSharedPtr = std::shared_ptr<AsyncSerializationState>;
 
   void flush() {
     if (isEmpty()) {
@@ -280,14 +355,74 @@ private:
       return;
     }
 
+    if (serializer_ != nullptr) {
+      flushAsync();
+      return;
+    }
+
     if (!client_->isConnected()) {
       initMessage();
     }
 
     if (client_->log(message_)) {
       // Clear the message regardless of the success.
+      stats_.batch_entries_.recordValue(batch_entries_);
       approximate_message_size_bytes_ = 0;
+      batch_entries_ = 0;
+      clearMessage();
+    }
+  }
+
+  // Hands the pending batch to the serialization thread. The encoded bytes are posted back to
+  // this logger's dispatcher and sent from there, as the gRPC client is not thread safe.
+  void flushAsync() {
+    const uint64_t entries = batch_entries_;
+    approximate_message_size_bytes_ = 0;
+    batch_entries_ = 0;
+    if (pending_batches_ >= max_pending_batches_) {
+      stats_.logs_dropped_.add(entries);
       clearMessage();
+      return;
+    }
+
+    // A batch may end up on a different stream than the previous one, so each carries the
+    // identifier.
+    initMessage();
+    stats_.batch_entries_.recordValue(entries);
+    ++pending_batches_;
+    stats_.pending_serialization_batches_.inc();
+    serializer_->post([state = async_state_, message = takeMessage(), entries]() mutable {
+      Buffer::InstancePtr request = Grpc::Common::serializeMessage(*message);
+      // Free the batch here rather than on the worker.
+      message.reset();
+      Thread::LockGuard guard(state->lock_);
+      if (state->logger_ == nullptr) {
+        return;
+      }
+      // The logger is destroyed on its own dispatcher's thread, so the dispatcher is alive while
+      // the logger is still attached.
+      state->logger_->dispatcher_.post(
+          [state, request = std::move(request), entries]() mutable {
+            GrpcAccessLogger* logger;
+            {
+              Thread::LockGuard state_guard(state->lock_);
+              logger = state->logger_;
+            }
+            if (logger != nullptr) {
+              logger->onBatchSerialized(std::move(request), entries);
+            }
+          });
+    });
+  }
+
+  void onBatchSerialized(Buffer::InstancePtr&& request, uint64_t entries) {
+    ASSERT(pending_batches_ > 0);
+    --pending_batches_;
+    stats_.pending_serialization_batches_.dec();
+    if (!client_->logRaw(std::move(request))) {
+      // The batch cannot be retried later like a buffered message, as it has already been moved
+      // out of message_.
+      stats_.logs_dropped_.add(entries);
     }
   }
 
@@ -305,11 +440,17 @@ private:
     return false;
   }
 
+  Event::Dispatcher& dispatcher_;
   const std::chrono::milliseconds buffer_flush_interval_msec_;
   const Event::TimerPtr flush_timer_;
   const uint64_t max_buffer_size_bytes_;
+  const uint32_t max_pending_batches_;
   uint64_t approximate_message_size_bytes_ = 0;
+  uint64_t batch_entries_ = 0;
+  uint32_t pending_batches_ = 0;
   GrpcAccessLoggerStats stats_;
+  GrpcAccessLogSerializerSharedPtr serializer_;
+  AsyncSerializationStateSharedPtr async_state_;
 };
 
 /**
@@ -323,8 +464,10 @@ public:
   using Interface = Detail::GrpcAccessLoggerCache<GrpcAccessLogger, ConfigProto>;
 
   GrpcAccessLoggerCache(Grpc::AsyncClientManager& async_client_manager, Stats::Scope& scope,
-                        ThreadLocal::SlotAllocator& tls)
-      : scope_(scope), async_client_manager_(async_client_manager), tls_slot_(tls.allocateSlot()) {
+                        ThreadLocal::SlotAllocator& tls, Thread::ThreadFactory& thread_factory)
+      : scope_(scope), async_client_manager_(async_client_manager),
+        serializer_(std::make_shared<GrpcAccessLogSerializer>(thread_factory)),
+        tls_slot_(tls.allocateSlot()) {
     tls_slot_->set([](Event::Dispatcher& dispatcher) {
       return std::make_shared<ThreadLocalCache>(dispatcher);
     });
@@ -348,6 +491,8 @@ public:
 protected:
   Stats::Scope& scope_;
   Grpc::AsyncClientManager& async_client_manager_;
+  // Shared by all loggers created by this cache that enable async serialization.
+  const GrpcAccessLogSerializerSharedPtr serializer_;
 
 private:
   /**
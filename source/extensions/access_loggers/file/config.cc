@@ -13,6 +13,7 @@
 #include "source/common/formatter/substitution_formatter.h"
 #include "source/common/protobuf/protobuf.h"
 #include "source/extensions/access_loggers/common/file_access_log_impl.h"
+#include "source/extensions/access_loggers/file/protobuf_file_access_log_impl.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -60,6 +61,13 @@ AccessLog::InstanceSharedPtr FileAccessLogFactory::createAccessLogInstance(
     formatter =
         Formatter::SubstitutionFormatStringUtils::fromProtoConfig(fal_config.log_format(), context);
     break;
+  case envoy::extensions::access_loggers::file::v3::FileAccessLog::AccessLogFormatCase::
+      kProtobufFormat:
+    // Binary records bypass the substitution formatter entirely.
+    return std::make_shared<ProtobufFileAccessLog>(
+        Filesystem::FilePathAndType{Filesystem::DestinationType::File, fal_config.path()},
+        std::move(filter), fal_config.protobuf_format(), context.threadLocal(),
+        context.accessLogManager());
   case envoy::extensions::access_loggers::file::v3::FileAccessLog::AccessLogFormatCase::
       ACCESS_LOG_FORMAT_NOT_SET:
     formatter = Formatter::HttpSubstitutionFormatUtils::defaultSubstitutionFormatter();
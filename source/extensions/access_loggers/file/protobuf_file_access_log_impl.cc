@@ -0,0 +1,74 @@
+#include "source/extensions/access_loggers/file/protobuf_file_access_log_impl.h"
+
+#include "source/common/common/fmt.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace File {
+
+void DelimitedProtobufUtil::serialize(const Protobuf::Message& message, std::string& output) {
+  const uint64_t size = message.ByteSizeLong();
+  const uint64_t prefix_size = Protobuf::io::CodedOutputStream::VarintSize64(size);
+  output.resize(prefix_size + size);
+  uint8_t* target = reinterpret_cast<uint8_t*>(output.data());
+  target = Protobuf::io::CodedOutputStream::WriteVarint64ToArray(size, target);
+  message.SerializeWithCachedSizesToArray(target);
+}
+
+absl::Status DelimitedProtobufUtil::parseNext(absl::string_view& data,
+                                              Protobuf::Message& message) {
+  Protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data.data()),
+                                       static_cast<int>(data.size()));
+  uint64_t size;
+  if (!input.ReadVarint64(&size)) {
+    return absl::InvalidArgumentError("truncated record length");
+  }
+  const uint64_t prefix_size = input.CurrentPosition();
+  if (size > data.size() - prefix_size) {
+    return absl::InvalidArgumentError(fmt::format(
+        "truncated record: expected {} bytes, {} available", size, data.size() - prefix_size));
+  }
+  if (!message.ParseFromArray(data.data() + prefix_size, static_cast<int>(size))) {
+    return absl::InvalidArgumentError("malformed record");
+  }
+  data.remove_prefix(prefix_size + size);
+  return absl::OkStatus();
+}
+
+ProtobufFileAccessLog::ProtobufFileAccessLog(
+    const Filesystem::FilePathAndType& access_log_file_info, AccessLog::FilterPtr&& filter,
+    const envoy::extensions::access_loggers::file::v3::FileAccessLog::ProtobufFormat& config,
+    ThreadLocal::SlotAllocator& tls, AccessLog::AccessLogManager& log_manager)
+    : ImplBase(std::move(filter)),
+      entry_builder_(commonConfig(config), config.additional_request_headers_to_log(),
+                     config.additional_response_headers_to_log(),
+                     config.additional_response_trailers_to_log()),
+      tls_slot_(tls) {
+  log_file_ = log_manager.createAccessLog(access_log_file_info);
+  tls_slot_.set([](Event::Dispatcher&) { return std::make_shared<ThreadLocalScratch>(); });
+}
+
+envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig
+ProtobufFileAccessLog::commonConfig(
+    const envoy::extensions::access_loggers::file::v3::FileAccessLog::ProtobufFormat& config) {
+  envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig common_config;
+  *common_config.mutable_filter_state_objects_to_log() = config.filter_state_objects_to_log();
+  *common_config.mutable_custom_tags() = config.custom_tags();
+  return common_config;
+}
+
+void ProtobufFileAccessLog::emitLog(const Formatter::HttpFormatterContext& context,
+                                    const StreamInfo::StreamInfo& stream_info) {
+  ThreadLocalScratch& scratch = *tls_slot_;
+  // Clear() keeps the memory of nested messages and strings around for the next entry.
+  scratch.entry_.Clear();
+  entry_builder_.build(context, stream_info, scratch.entry_);
+  DelimitedProtobufUtil::serialize(scratch.entry_, scratch.buffer_);
+  log_file_->write(scratch.buffer_);
+}
+
+} // namespace File
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/data/accesslog/v3/accesslog.pb.h"
+#include "envoy/extensions/access_loggers/file/v3/file.pb.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "source/common/protobuf/protobuf.h"
+#include "source/extensions/access_loggers/common/access_log_base.h"
+#include "source/extensions/access_loggers/grpc/http_log_entry_builder.h"
+
+#include "absl/status/status.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace File {
+
+/**
+ * Framing used by the protobuf file access log: every record is a varint encoded length followed
+ * by that many bytes of serialized message.
+ */
+class DelimitedProtobufUtil {
+public:
+  /**
+   * Serialize message with its length prefix into output, replacing its previous contents. The
+   * capacity of output is kept so that a reused string does not allocate in the steady state.
+   */
+  static void serialize(const Protobuf::Message& message, std::string& output);
+
+  /**
+   * Parse the next record from data, advancing data past it.
+   * @return absl::OkStatus() on success, or an error if data does not start with a complete,
+   *         well-formed record.
+   */
+  static absl::Status parseNext(absl::string_view& data, Protobuf::Message& message);
+};
+
+/**
+ * Access log Instance that writes HTTPAccessLogEntry records to a file in the binary
+ * length-delimited format, using the same entry population as the HTTP gRPC access log.
+ */
+class ProtobufFileAccessLog : public Common::ImplBase {
+public:
+  ProtobufFileAccessLog(
+      const Filesystem::FilePathAndType& access_log_file_info, AccessLog::FilterPtr&& filter,
+      const envoy::extensions::access_loggers::file::v3::FileAccessLog::ProtobufFormat& config,
+      ThreadLocal::SlotAllocator& tls, AccessLog::AccessLogManager& log_manager);
+
+private:
+  /**
+   * Per-worker scratch space reused across log calls so that steady state logging does not
+   * allocate for the entry or the serialized record.
+   */
+  struct ThreadLocalScratch : public ThreadLocal::ThreadLocalObject {
+    envoy::data::accesslog::v3::HTTPAccessLogEntry entry_;
+    std::string buffer_;
+  };
+
+  // Common::ImplBase
+  void emitLog(const Formatter::HttpFormatterContext& context,
+               const StreamInfo::StreamInfo& stream_info) override;
+
+  static envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig
+  commonConfig(const envoy::extensions::access_loggers::file::v3::FileAccessLog::ProtobufFormat&
+                   config);
+
+  AccessLog::AccessLogFileSharedPtr log_file_;
+  const HttpGrpc::HttpLogEntryBuilder entry_builder_;
+  ThreadLocal::TypedSlot<ThreadLocalScratch> tls_slot_;
+};
+
+} // namespace File
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -18,10 +18,12 @@ namespace GrpcCommon {
 GrpcAccessLoggerImpl::GrpcAccessLoggerImpl(
     const Grpc::RawAsyncClientSharedPtr& client,
     const envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig& config,
-    Event::Dispatcher& dispatcher, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope)
+    Event::Dispatcher& dispatcher, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
+    Common::GrpcAccessLogSerializerSharedPtr serializer)
     : GrpcAccessLogger(std::move(client), config, dispatcher, scope, GRPC_LOG_STATS_PREFIX,
                        *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
-                           "envoy.service.accesslog.v3.AccessLogService.StreamAccessLogs")),
+                           "envoy.service.accesslog.v3.AccessLogService.StreamAccessLogs"),
+                       true, std::move(serializer)),
       log_name_(config.log_name()), local_info_(local_info) {}
 
 void GrpcAccessLoggerImpl::addEntry(envoy::data::accesslog::v3::HTTPAccessLogEntry&& entry) {
@@ -45,8 +47,10 @@ void GrpcAccessLoggerImpl::initMessage() {
 GrpcAccessLoggerCacheImpl::GrpcAccessLoggerCacheImpl(Grpc::AsyncClientManager& async_client_manager,
                                                      Stats::Scope& scope,
                                                      ThreadLocal::SlotAllocator& tls,
+                                                     Thread::ThreadFactory& thread_factory,
                                                      const LocalInfo::LocalInfo& local_info)
-    : GrpcAccessLoggerCache(async_client_manager, scope, tls), local_info_(local_info) {}
+    : GrpcAccessLoggerCache(async_client_manager, scope, tls, thread_factory),
+      local_info_(local_info) {}
 
 GrpcAccessLoggerImpl::SharedPtr GrpcAccessLoggerCacheImpl::createLogger(
     const envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig& config,
@@ -58,7 +62,7 @@ GrpcAccessLoggerImpl::SharedPtr GrpcAccessLoggerCacheImpl::createLogger(
   auto client = async_client_manager_.factoryForGrpcService(config.grpc_service(), scope_, true)
                     ->createUncachedRawAsyncClient();
   return std::make_shared<GrpcAccessLoggerImpl>(std::move(client), config, dispatcher, local_info_,
-                                                scope_);
+                                                scope_, serializer_);
 }
 
 } // namespace GrpcCommon
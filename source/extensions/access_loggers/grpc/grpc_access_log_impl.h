@@ -26,7 +26,8 @@ public:
   GrpcAccessLoggerImpl(
       const Grpc::RawAsyncClientSharedPtr& client,
       const envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig& config,
-      Event::Dispatcher& dispatcher, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope);
+      Event::Dispatcher& dispatcher, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
+      Common::GrpcAccessLogSerializerSharedPtr serializer = nullptr);
 
 private:
   // Extensions::AccessLoggers::GrpcCommon::GrpcAccessLogger
@@ -45,7 +46,7 @@ class GrpcAccessLoggerCacheImpl
           envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig> {
 public:
   GrpcAccessLoggerCacheImpl(Grpc::AsyncClientManager& async_client_manager, Stats::Scope& scope,
-                            ThreadLocal::SlotAllocator& tls,
+                            ThreadLocal::SlotAllocator& tls, Thread::ThreadFactory& thread_factory,
                             const LocalInfo::LocalInfo& local_info);
 
 private:
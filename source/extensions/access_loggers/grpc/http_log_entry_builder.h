@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "envoy/data/accesslog/v3/accesslog.pb.h"
+#include "envoy/extensions/access_loggers/grpc/v3/als.pb.h"
+#include "envoy/formatter/http_formatter_context.h"
+#include "envoy/http/header_map.h"
+#include "envoy/stream_info/stream_info.h"
+
+#include "source/common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace HttpGrpc {
+
+/**
+ * Populates HTTPAccessLogEntry messages from a finished request. Shared by the HTTP gRPC access
+ * log and by other loggers that emit the same entry format.
+ */
+class HttpLogEntryBuilder {
+public:
+  HttpLogEntryBuilder(
+      const envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig& common_config,
+      const Protobuf::RepeatedPtrField<std::string>& request_headers_to_log,
+      const Protobuf::RepeatedPtrField<std::string>& response_headers_to_log,
+      const Protobuf::RepeatedPtrField<std::string>& response_trailers_to_log);
+
+  /**
+   * Fill in log_entry for the request described by context and stream_info. Fields that are
+   * already set on log_entry are overwritten but not cleared, so a reused entry must be cleared
+   * first.
+   */
+  void build(const Formatter::HttpFormatterContext& context,
+             const StreamInfo::StreamInfo& stream_info,
+             envoy::data::accesslog::v3::HTTPAccessLogEntry& log_entry) const;
+
+private:
+  const envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig common_config_;
+  std::vector<Http::LowerCaseString> request_headers_to_log_;
+  std::vector<Http::LowerCaseString> response_headers_to_log_;
+  std::vector<Http::LowerCaseString> response_trailers_to_log_;
+};
+
+} // namespace HttpGrpc
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
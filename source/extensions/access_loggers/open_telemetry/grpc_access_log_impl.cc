@@ -24,11 +24,12 @@ GrpcAccessLoggerImpl::GrpcAccessLoggerImpl(
     const Grpc::RawAsyncClientSharedPtr& client,
     const envoy::extensions::access_loggers::open_telemetry::v3::OpenTelemetryAccessLogConfig&
         config,
-    Event::Dispatcher& dispatcher, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope)
+    Event::Dispatcher& dispatcher, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
+    Common::GrpcAccessLogSerializerSharedPtr serializer)
     : GrpcAccessLogger(client, config.common_config(), dispatcher, scope, GRPC_LOG_STATS_PREFIX,
                        *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
                            "opentelemetry.proto.collector.logs.v1.LogsService.Export"),
-                       false) {
+                       false, std::move(serializer)) {
   initMessageRoot(config, local_info);
 }
 
@@ -75,11 +76,27 @@ void GrpcAccessLoggerImpl::initMessage() {}
 
 void GrpcAccessLoggerImpl::clearMessage() { root_->clear_log_records(); }
 
+// The resource and scope stay in message_ for the next batch, so only the log records are moved
+// and the rest of the message is copied.
+std::unique_ptr<opentelemetry::proto::collector::logs::v1::ExportLogsServiceRequest>
+GrpcAccessLoggerImpl::takeMessage() {
+  Protobuf::RepeatedPtrField<opentelemetry::proto::logs::v1::LogRecord> log_records;
+  log_records.Swap(root_->mutable_log_records());
+  auto message =
+      std::make_unique<opentelemetry::proto::collector::logs::v1::ExportLogsServiceRequest>(
+          message_);
+  message->mutable_resource_logs(0)->mutable_scope_logs(0)->mutable_log_records()->Swap(
+      &log_records);
+  return message;
+}
+
 GrpcAccessLoggerCacheImpl::GrpcAccessLoggerCacheImpl(Grpc::AsyncClientManager& async_client_manager,
                                                      Stats::Scope& scope,
                                                      ThreadLocal::SlotAllocator& tls,
+                                                     Thread::ThreadFactory& thread_factory,
                                                      const LocalInfo::LocalInfo& local_info)
-    : GrpcAccessLoggerCache(async_client_manager, scope, tls), local_info_(local_info) {}
+    : GrpcAccessLoggerCache(async_client_manager, scope, tls, thread_factory),
+      local_info_(local_info) {}
 
 GrpcAccessLoggerImpl::SharedPtr GrpcAccessLoggerCacheImpl::createLogger(
     const envoy::extensions::access_loggers::open_telemetry::v3::OpenTelemetryAccessLogConfig&
@@ -93,7 +110,7 @@ GrpcAccessLoggerImpl::SharedPtr GrpcAccessLoggerCacheImpl::createLogger(
                     .factoryForGrpcService(config.common_config().grpc_service(), scope_, true)
                     ->createUncachedRawAsyncClient();
   return std::make_shared<GrpcAccessLoggerImpl>(std::move(client), config, dispatcher, local_info_,
-                                                scope_);
+                                                scope_, serializer_);
 }
 
 } // namespace OpenTelemetry
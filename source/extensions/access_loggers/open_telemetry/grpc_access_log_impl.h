@@ -40,7 +40,8 @@ public:
       const Grpc::RawAsyncClientSharedPtr& client,
       const envoy::extensions::access_loggers::open_telemetry::v3::OpenTelemetryAccessLogConfig&
           config,
-      Event::Dispatcher& dispatcher, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope);
+      Event::Dispatcher& dispatcher, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
+      Common::GrpcAccessLogSerializerSharedPtr serializer = nullptr);
 
 private:
   void initMessageRoot(
@@ -54,6 +55,8 @@ private:
   bool isEmpty() override;
   void initMessage() override;
   void clearMessage() override;
+  std::unique_ptr<opentelemetry::proto::collector::logs::v1::ExportLogsServiceRequest>
+  takeMessage() override;
 
   opentelemetry::proto::logs::v1::ScopeLogs* root_;
 };
@@ -64,7 +67,7 @@ class GrpcAccessLoggerCacheImpl
           envoy::extensions::access_loggers::open_telemetry::v3::OpenTelemetryAccessLogConfig> {
 public:
   GrpcAccessLoggerCacheImpl(Grpc::AsyncClientManager& async_client_manager, Stats::Scope& scope,
-                            ThreadLocal::SlotAllocator& tls,
+                            ThreadLocal::SlotAllocator& tls, Thread::ThreadFactory& thread_factory,
                             const LocalInfo::LocalInfo& local_info);
 
 private:
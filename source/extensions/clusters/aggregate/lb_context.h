@@ -65,6 +65,9 @@ public:
   Network::TransportSocketOptionsConstSharedPtr upstreamTransportSocketOptions() const override {
     return context_->upstreamTransportSocketOptions();
   }
+  void setResponseTimeObserver(Upstream::ResponseTimeObserverSharedPtr observer) override {
+    context_->setResponseTimeObserver(std::move(observer));
+  }
 
 private:
   Upstream::HealthyAndDegradedLoad priority_load_;
@@ -10,6 +10,7 @@
 
 #include "source/common/http/utility.h"
 #include "source/common/network/transport_socket_options_impl.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/common/router/string_accessor_impl.h"
 #include "source/common/stream_info/uint32_accessor_impl.h"
 #include "source/extensions/common/dynamic_forward_proxy/dns_cache_manager_impl.h"
@@ -64,6 +65,8 @@ Cluster::Cluster(
       main_thread_dispatcher_(context.serverFactoryContext().mainThreadDispatcher()),
       orig_cluster_config_(cluster),
       allow_coalesced_connections_(config.allow_coalesced_connections()),
+      worker_local_hosts_(
+          Runtime::runtimeFeatureEnabled("envoy.reloadable_features.dfp_worker_local_hosts")),
       cm_(context.clusterManager()), max_sub_clusters_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
                                          config.sub_clusters_config(), max_sub_clusters, 1024)),
       sub_cluster_ttl_(
@@ -250,7 +253,18 @@ void Cluster::addOrUpdateHost(
     // connection/request circuit breakers is sufficient. We may have to revisit this in the
     // future.
     const auto host_map_it = host_map_.find(host);
-    if (host_map_it != host_map_.end()) {
+    if (host_map_it != host_map_.end() && !host_map_it->second.in_priority_set_) {
+      // The host was created by a worker, it only needs to be added to the priority set.
+      ENVOY_LOG(debug, "adding worker created dfproxy cluster host '{}'", host);
+      HostInfo& existing = host_map_it->second;
+      if (host_info->address() != nullptr &&
+          *host_info->address() != *existing.logical_host_->address()) {
+        existing.logical_host_->setNewAddresses(host_info->address(), host_info->addressList(),
+                                                dummy_lb_endpoint_);
+      }
+      existing.in_priority_set_ = true;
+      emplaced_host = existing.logical_host_;
+    } else if (host_map_it != host_map_.end()) {
       // If we only have an address change, we can do that swap inline without any other updates.
       // The appropriate R/W locking is in place to allow this. The details of this locking are:
       //  - Hosts are not thread local, they are global.
@@ -274,17 +288,18 @@ void Cluster::addOrUpdateHost(
       host_map_it->second.logical_host_->setNewAddresses(
           host_info->address(), host_info->addressList(), dummy_lb_endpoint_);
       return;
+    } else {
+      ENVOY_LOG(debug, "adding new dfproxy cluster host '{}'", host);
+
+      emplaced_host = host_map_
+                          .try_emplace(host, host_info,
+                                       std::make_shared<Upstream::LogicalHost>(
+                                           info(), std::string{host}, host_info->address(),
+                                           host_info->addressList(), dummy_locality_lb_endpoint_,
+                                           dummy_lb_endpoint_, nullptr, time_source_),
+                                       true)
+                          .first->second.logical_host_;
     }
-
-    ENVOY_LOG(debug, "adding new dfproxy cluster host '{}'", host);
-
-    emplaced_host = host_map_
-                        .try_emplace(host, host_info,
-                                     std::make_shared<Upstream::LogicalHost>(
-                                         info(), std::string{host}, host_info->address(),
-                                         host_info->addressList(), dummy_locality_lb_endpoint_,
-                                         dummy_lb_endpoint_, nullptr, time_source_))
-                        .first->second.logical_host_;
   }
 
   ASSERT(emplaced_host);
@@ -299,6 +314,28 @@ void Cluster::onDnsHostAddOrUpdate(
     const Extensions::Common::DynamicForwardProxy::DnsHostInfoSharedPtr& host_info) {
   ENVOY_LOG(debug, "Adding host info for {}", host);
 
+  if (worker_local_hosts_) {
+    const bool in_priority_set = [&]() {
+      absl::ReaderMutexLock lock{&host_map_lock_};
+      const auto host_map_it = host_map_.find(host);
+      return host_map_it != host_map_.end() && host_map_it->second.in_priority_set_;
+    }();
+    if (!in_priority_set) {
+      // The workers get the host from the DNS cache until it is added, so new hosts are added to
+      // the priority set in a batch rather than one update per host.
+      const bool first_pending_host = pending_hosts_.empty();
+      pending_hosts_.insert_or_assign(host, host_info);
+      if (first_pending_host) {
+        main_thread_dispatcher_.post([this, still_alive = std::weak_ptr<bool>(still_alive_)]() {
+          if (!still_alive.expired()) {
+            addPendingHosts();
+          }
+        });
+      }
+      return;
+    }
+  }
+
   std::unique_ptr<Upstream::HostVector> hosts_added;
   addOrUpdateHost(host, host_info, hosts_added);
   if (hosts_added != nullptr) {
@@ -307,6 +344,51 @@ void Cluster::onDnsHostAddOrUpdate(
   }
 }
 
+void Cluster::addPendingHosts() {
+  ASSERT(main_thread_dispatcher_.isThreadSafe());
+  std::unique_ptr<Upstream::HostVector> hosts_added;
+  for (const auto& [host, host_info] : pending_hosts_) {
+    addOrUpdateHost(host, host_info, hosts_added);
+  }
+  pending_hosts_.clear();
+  if (hosts_added != nullptr) {
+    ENVOY_LOG(debug, "adding {} new dfproxy cluster hosts", hosts_added->size());
+    updatePriorityState(*hosts_added, {});
+  }
+}
+
+Upstream::HostConstSharedPtr Cluster::addWorkerLocalHost(const std::string& host) {
+  while (true) {
+    const uint64_t host_removals = [&]() {
+      absl::ReaderMutexLock lock{&host_map_lock_};
+      return host_removals_;
+    }();
+    const auto host_info = dns_cache_->getHost(host);
+    if (!host_info.has_value()) {
+      return nullptr;
+    }
+
+    auto logical_host = std::make_shared<Upstream::LogicalHost>(
+        info(), host, host_info.value()->address(), host_info.value()->addressList(),
+        dummy_locality_lb_endpoint_, dummy_lb_endpoint_, nullptr, time_source_);
+    absl::WriterMutexLock lock{&host_map_lock_};
+    if (host_removals_ != host_removals) {
+      // The main thread removed a host since the DNS cache was read, and it may be this one. As the
+      // DNS cache erases a host before the cluster removes it, reading the DNS cache again tells
+      // whether it still knows the host. Otherwise the host would stay in the host map forever.
+      continue;
+    }
+    // Another worker or the main thread may have added the host in the meantime.
+    const auto [host_map_it, inserted] =
+        host_map_.try_emplace(host, host_info.value(), logical_host, false);
+    if (inserted) {
+      ENVOY_LOG(debug, "adding worker local dfproxy cluster host '{}'", host);
+    }
+    host_map_it->second.shared_host_info_->touch();
+    return host_map_it->second.logical_host_;
+  }
+}
+
 void Cluster::updatePriorityState(const Upstream::HostVector& hosts_added,
                                   const Upstream::HostVector& hosts_removed) {
   Upstream::PriorityStateManager priority_state_manager(*this, local_info_, nullptr);
@@ -324,16 +406,26 @@ void Cluster::updatePriorityState(const Upstream::HostVector& hosts_added,
 }
 
 void Cluster::onDnsHostRemove(const std::string& host) {
+  pending_hosts_.erase(host);
   Upstream::HostVector hosts_removed;
   {
     absl::WriterMutexLock lock{&host_map_lock_};
+    host_removals_++;
     const auto host_map_it = host_map_.find(host);
-    ASSERT(host_map_it != host_map_.end());
-    hosts_removed.emplace_back(host_map_it->second.logical_host_);
-    host_map_.erase(host);
+    if (host_map_it == host_map_.end()) {
+      // The host was still waiting to be added, and no worker needed it.
+      ASSERT(worker_local_hosts_);
+      return;
+    }
+    if (host_map_it->second.in_priority_set_) {
+      hosts_removed.emplace_back(host_map_it->second.logical_host_);
+    }
+    host_map_.erase(host_map_it);
     ENVOY_LOG(debug, "removing dfproxy cluster host '{}'", host);
   }
-  updatePriorityState({}, hosts_removed);
+  if (!hosts_removed.empty()) {
+    updatePriorityState({}, hosts_removed);
+  }
 }
 
 Upstream::HostConstSharedPtr
@@ -392,10 +484,7 @@ Cluster::LoadBalancer::chooseHost(Upstream::LoadBalancerContext* context) {
   {
     absl::ReaderMutexLock lock{&cluster_.host_map_lock_};
     const auto host_it = cluster_.host_map_.find(host);
-    if (host_it == cluster_.host_map_.end()) {
-      ENVOY_LOG(debug, "host {} not found", host);
-      return nullptr;
-    } else {
+    if (host_it != cluster_.host_map_.end()) {
       if (host_it->second.logical_host_->coarseHealth() == Upstream::Host::Health::Unhealthy) {
         ENVOY_LOG(debug, "host {} is unhealthy", host);
         return nullptr;
@@ -404,6 +493,15 @@ Cluster::LoadBalancer::chooseHost(Upstream::LoadBalancerContext* context) {
       return host_it->second.logical_host_;
     }
   }
+
+  // The DNS cache may have resolved the host before the main thread added it to the cluster, so
+  // use it right away rather than waiting for the update.
+  Upstream::HostConstSharedPtr worker_local_host =
+      cluster_.worker_local_hosts_ ? cluster_.addWorkerLocalHost(host) : nullptr;
+  if (worker_local_host == nullptr) {
+    ENVOY_LOG(debug, "host {} not found", host);
+  }
+  return worker_local_host;
 }
 
 absl::optional<Upstream::SelectedPoolAndConnection>
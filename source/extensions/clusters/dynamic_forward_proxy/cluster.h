@@ -74,11 +74,15 @@ private:
 
   struct HostInfo {
     HostInfo(const Extensions::Common::DynamicForwardProxy::DnsHostInfoSharedPtr& shared_host_info,
-             const Upstream::LogicalHostSharedPtr& logical_host)
-        : shared_host_info_(shared_host_info), logical_host_(logical_host) {}
+             const Upstream::LogicalHostSharedPtr& logical_host, bool in_priority_set)
+        : shared_host_info_(shared_host_info), logical_host_(logical_host),
+          in_priority_set_(in_priority_set) {}
 
     const Extensions::Common::DynamicForwardProxy::DnsHostInfoSharedPtr shared_host_info_;
     const Upstream::LogicalHostSharedPtr logical_host_;
+    // False for a host created by a worker which needed it before the main thread added it to the
+    // priority set.
+    bool in_priority_set_;
   };
 
   using HostInfoMap = absl::flat_hash_map<std::string, HostInfo>;
@@ -86,7 +90,7 @@ private:
   class LoadBalancer : public Upstream::LoadBalancer,
                        public Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks {
   public:
-    LoadBalancer(const Cluster& cluster) : cluster_(cluster) {}
+    LoadBalancer(Cluster& cluster) : cluster_(cluster) {}
 
     // Upstream::LoadBalancer
     Upstream::HostConstSharedPtr chooseHost(Upstream::LoadBalancerContext* context) override;
@@ -128,7 +132,7 @@ private:
 
     absl::flat_hash_map<LookupKey, std::vector<ConnectionInfo>, LookupKeyHash> connection_info_map_;
 
-    const Cluster& cluster_;
+    Cluster& cluster_;
   };
 
   class LoadBalancerFactory : public Upstream::LoadBalancerFactory {
@@ -168,6 +172,14 @@ private:
                            const Upstream::HostVector& hosts_removed)
       ABSL_LOCKS_EXCLUDED(host_map_lock_);
 
+  // Creates the host for a worker which needs a host that is resolved by the DNS cache but not yet
+  // added by the main thread. The main thread adds it to the priority set once it processes the
+  // update of the DNS cache. The host is not created if the DNS cache removed it in the meantime.
+  Upstream::HostConstSharedPtr addWorkerLocalHost(const std::string& host)
+      ABSL_LOCKS_EXCLUDED(host_map_lock_);
+
+  void addPendingHosts();
+
   const Extensions::Common::DynamicForwardProxy::DnsCacheManagerSharedPtr dns_cache_manager_;
   const Extensions::Common::DynamicForwardProxy::DnsCacheSharedPtr dns_cache_;
   const Extensions::Common::DynamicForwardProxy::DnsCache::AddUpdateCallbacksHandlePtr
@@ -185,6 +197,18 @@ private:
 
   mutable absl::Mutex host_map_lock_;
   HostInfoMap host_map_ ABSL_GUARDED_BY(host_map_lock_);
+  // Incremented for every host removed by the DNS cache, so that a worker does not add a host
+  // back to the host map after its removal was processed.
+  uint64_t host_removals_ ABSL_GUARDED_BY(host_map_lock_){};
+
+  // When true, the new hosts of the DNS cache are added to the priority set in batches, and the
+  // workers create the hosts they need in the meantime.
+  const bool worker_local_hosts_;
+  // The new hosts of the DNS cache waiting to be added to the priority set. Only used on the main
+  // thread.
+  absl::flat_hash_map<std::string, Extensions::Common::DynamicForwardProxy::DnsHostInfoSharedPtr>
+      pending_hosts_;
+  const std::shared_ptr<bool> still_alive_{std::make_shared<bool>(true)};
 
   mutable absl::Mutex cluster_map_lock_;
   ClusterInfoMap cluster_map_ ABSL_GUARDED_BY(cluster_map_lock_);
@@ -6,13 +6,59 @@
 #include "envoy/service/discovery/v3/discovery.pb.h"
 
 #include "source/common/common/assert.h"
+#include "source/common/common/hash.h"
 #include "source/common/common/utility.h"
 #include "source/common/config/api_version.h"
 #include "source/common/config/decoded_resource_impl.h"
+#include "source/common/runtime/runtime_features.h"
 
 namespace Envoy {
 namespace Upstream {
 
+namespace {
+
+// Appends the deterministic serialization of a message to a string, prefixed by its size so that
+// consecutive messages can not be confused with each other.
+void appendSerialized(const Protobuf::Message& message, std::string& output) {
+  Protobuf::io::StringOutputStream stream(&output);
+  Protobuf::io::CodedOutputStream coded_stream(&stream);
+  coded_stream.SetSerializationDeterministic(true);
+  coded_stream.WriteVarint64(message.ByteSizeLong());
+  message.SerializeWithCachedSizes(&coded_stream);
+}
+
+std::string endpointKey(const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint) {
+  std::string key;
+  appendSerialized(lb_endpoint.endpoint().address(), key);
+  return key;
+}
+
+uint64_t endpointConfigHash(const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint) {
+  std::string config;
+  appendSerialized(lb_endpoint.endpoint(), config);
+  appendSerialized(lb_endpoint.metadata(), config);
+  return HashUtil::xxHash64(config, lb_endpoint.load_balancing_weight().value());
+}
+
+// Describes everything in an assignment that applies to more than one endpoint. An assignment can
+// only be applied as a delta to the previous one if both have the same shape.
+std::string
+assignmentShape(const envoy::config::endpoint::v3::ClusterLoadAssignment& cluster_load_assignment) {
+  std::string shape = absl::StrCat(
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(cluster_load_assignment.policy(), overprovisioning_factor,
+                                      kDefaultOverProvisioningFactor),
+      ",", cluster_load_assignment.policy().weighted_priority_health() ? 1 : 0);
+  for (const auto& locality_lb_endpoint : cluster_load_assignment.endpoints()) {
+    absl::StrAppend(&shape, ";", locality_lb_endpoint.priority(), ",",
+                    locality_lb_endpoint.has_load_balancing_weight() ? 1 : 0, ",",
+                    locality_lb_endpoint.load_balancing_weight().value(), ",");
+    appendSerialized(locality_lb_endpoint.locality(), shape);
+  }
+  return shape;
+}
+
+} // namespace
+
 EdsClusterImpl::EdsClusterImpl(const envoy::config::cluster::v3::Cluster& cluster,
                                ClusterFactoryContext& cluster_context)
     : BaseDynamicClusterImpl(cluster, cluster_context),
@@ -49,9 +95,22 @@ EdsClusterImpl::~EdsClusterImpl() {
 void EdsClusterImpl::startPreInit() { subscription_->start({edsServiceName()}); }
 
 void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& host_update_cb) {
+  if (applyDelta(host_update_cb)) {
+    parent_.onPreInitComplete();
+    return;
+  }
+  parent_.endpoint_index_.clear();
+  parent_.endpoint_index_shape_.clear();
+
+  // The registered endpoints are only tracked when they can be indexed for the next update.
+  bool index_endpoints = parent_.canIndexEndpoints();
+  std::vector<RegisteredEndpoint> registered_endpoints;
+
   absl::flat_hash_set<std::string> all_new_hosts;
   PriorityStateManager priority_state_manager(parent_, parent_.local_info_, &host_update_cb);
-  for (const auto& locality_lb_endpoint : cluster_load_assignment_.endpoints()) {
+  for (int locality_index = 0; locality_index < cluster_load_assignment_.endpoints_size();
+       ++locality_index) {
+    const auto& locality_lb_endpoint = cluster_load_assignment_.endpoints(locality_index);
     parent_.validateEndpointsForZoneAwareRouting(locality_lb_endpoint);
 
     priority_state_manager.initializePriorityFor(locality_lb_endpoint);
@@ -72,8 +131,19 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
       }
     } else {
       for (const auto& lb_endpoint : locality_lb_endpoint.lb_endpoints()) {
-        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, priority_state_manager,
-                                all_new_hosts);
+        std::string address = updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint,
+                                                      priority_state_manager, all_new_hosts);
+        if (!index_endpoints) {
+          continue;
+        }
+        // Duplicate endpoints would make the index ambiguous.
+        if (address.empty()) {
+          index_endpoints = false;
+          registered_endpoints.clear();
+          continue;
+        }
+        registered_endpoints.push_back(
+            {&lb_endpoint, static_cast<uint32_t>(locality_index), std::move(address)});
       }
     }
   }
@@ -130,12 +200,208 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
     parent_.info_->configUpdateStats().update_no_rebuild_.inc();
   }
 
+  if (index_endpoints) {
+    indexEndpoints(registered_endpoints);
+  }
+
   // If we didn't setup to initialize when our first round of health checking is complete, just
   // do it now.
   parent_.onPreInitComplete();
 }
 
-void EdsClusterImpl::BatchUpdateHelper::updateLocalityEndpoints(
+bool EdsClusterImpl::BatchUpdateHelper::applyDelta(PrioritySet::HostUpdateCb& host_update_cb) {
+  EndpointIndex& endpoint_index = parent_.endpoint_index_;
+  if (parent_.endpoint_index_shape_.empty() || !parent_.canIndexEndpoints() ||
+      assignmentShape(cluster_load_assignment_) != parent_.endpoint_index_shape_) {
+    return false;
+  }
+
+  // Match the endpoints of the update with the indexed ones. Nothing is changed until it is known
+  // that the update can be applied as a delta.
+  struct UpdateEndpoint {
+    uint32_t priority_;
+    uint32_t locality_index_;
+    const envoy::config::endpoint::v3::LbEndpoint* lb_endpoint_;
+    // The matching indexed endpoint, or nullptr if the endpoint was added.
+    IndexedEndpoint* indexed_;
+  };
+  std::vector<UpdateEndpoint> update_endpoints;
+  std::vector<std::pair<IndexedEndpoint*, envoy::config::core::v3::HealthStatus>> health_updates;
+  absl::flat_hash_set<std::string> added_keys;
+  const uint64_t generation = ++parent_.endpoint_index_generation_;
+  size_t matched = 0;
+  for (int locality_index = 0; locality_index < cluster_load_assignment_.endpoints_size();
+       ++locality_index) {
+    const auto& locality_lb_endpoint = cluster_load_assignment_.endpoints(locality_index);
+    for (const auto& lb_endpoint : locality_lb_endpoint.lb_endpoints()) {
+      std::string key = endpointKey(lb_endpoint);
+      auto it = endpoint_index.find(key);
+      if (it == endpoint_index.end()) {
+        if (!added_keys.insert(std::move(key)).second) {
+          return false;
+        }
+        update_endpoints.push_back({locality_lb_endpoint.priority(),
+                                    static_cast<uint32_t>(locality_index), &lb_endpoint, nullptr});
+        continue;
+      }
+      IndexedEndpoint& endpoint = it->second;
+      // Duplicate endpoints, endpoints which moved to another locality and endpoints with changes
+      // other than to their health status are left to the full update.
+      if (endpoint.generation_ == generation ||
+          endpoint.locality_index_ != static_cast<uint32_t>(locality_index) ||
+          endpoint.config_hash_ != endpointConfigHash(lb_endpoint)) {
+        return false;
+      }
+      endpoint.generation_ = generation;
+      matched++;
+      if (endpoint.health_status_ != lb_endpoint.health_status()) {
+        health_updates.emplace_back(&endpoint, lb_endpoint.health_status());
+      }
+      update_endpoints.push_back({locality_lb_endpoint.priority(),
+                                  static_cast<uint32_t>(locality_index), &lb_endpoint, &endpoint});
+    }
+  }
+
+  // Create the hosts of the added endpoints. Their addresses must not be in use by any other host,
+  // as the full update would then reuse that host.
+  PriorityStateManager priority_state_manager(parent_, parent_.local_info_, &host_update_cb);
+  for (const auto& locality_lb_endpoint : cluster_load_assignment_.endpoints()) {
+    parent_.validateEndpointsForZoneAwareRouting(locality_lb_endpoint);
+    priority_state_manager.initializePriorityFor(locality_lb_endpoint);
+  }
+  auto& priority_state = priority_state_manager.priorityState();
+  HostMapConstSharedPtr all_hosts = parent_.prioritySet().crossPriorityHostMap();
+  absl::flat_hash_set<std::string> added_addresses;
+  std::vector<RegisteredEndpoint> added_endpoints;
+  HostVector added_hosts;
+  for (const UpdateEndpoint& update_endpoint : update_endpoints) {
+    if (update_endpoint.indexed_ != nullptr) {
+      continue;
+    }
+    const auto& lb_endpoint = *update_endpoint.lb_endpoint_;
+    const auto address = parent_.resolveProtoAddress(lb_endpoint.endpoint().address());
+    std::string address_as_string = address->asString();
+    if (all_hosts->contains(address_as_string) ||
+        !added_addresses.insert(address_as_string).second) {
+      return false;
+    }
+    std::vector<Network::Address::InstanceConstSharedPtr> address_list;
+    if (!lb_endpoint.endpoint().additional_addresses().empty()) {
+      address_list.push_back(address);
+      for (const auto& additional_address : lb_endpoint.endpoint().additional_addresses()) {
+        address_list.emplace_back(parent_.resolveProtoAddress(additional_address.address()));
+      }
+    }
+    priority_state_manager.registerHostForPriority(
+        lb_endpoint.endpoint().hostname(), address, address_list,
+        cluster_load_assignment_.endpoints(update_endpoint.locality_index_), lb_endpoint,
+        parent_.time_source_);
+    added_hosts.push_back(priority_state[update_endpoint.priority_].first->back());
+    added_endpoints.push_back(
+        {&lb_endpoint, update_endpoint.locality_index_, std::move(address_as_string)});
+  }
+
+  // The update is applied as a delta from here on. A priority is only updated if hosts were added
+  // to or removed from it, or if the health of one of its hosts changed.
+  const auto& host_sets = parent_.prioritySet().hostSetsPerPriority();
+  // As the shape of the update did not change, neither did the set of priorities.
+  ASSERT(priority_state.size() <= host_sets.size());
+  std::vector<HostVector> hosts_removed(host_sets.size());
+  std::vector<bool> priority_changed(host_sets.size());
+  for (size_t priority = 0; priority < priority_state.size(); ++priority) {
+    priority_changed[priority] =
+        priority_state[priority].first != nullptr && !priority_state[priority].first->empty();
+  }
+  if (matched != endpoint_index.size()) {
+    for (auto it = endpoint_index.begin(); it != endpoint_index.end();) {
+      if (it->second.generation_ != generation) {
+        const uint32_t priority = it->second.host_->priority();
+        hosts_removed[priority].push_back(std::move(it->second.host_));
+        priority_changed[priority] = true;
+        endpoint_index.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (auto& [endpoint, health_status] : health_updates) {
+    const auto previous_health = endpoint->host_->coarseHealth();
+    endpoint->host_->setEdsHealthStatus(health_status);
+    endpoint->health_status_ = health_status;
+    if (previous_health != endpoint->host_->coarseHealth()) {
+      priority_changed[endpoint->host_->priority()] = true;
+    }
+  }
+
+  // Rebuild the host vectors of the changed priorities in the order of the update, which is the
+  // order the full update would have put them in.
+  std::vector<HostVectorSharedPtr> priority_hosts(host_sets.size());
+  for (size_t priority = 0; priority < host_sets.size(); ++priority) {
+    if (priority_changed[priority]) {
+      priority_hosts[priority] = std::make_shared<HostVector>();
+    }
+  }
+  uint32_t max_host_weight = 1;
+  auto added_host = added_hosts.begin();
+  for (const UpdateEndpoint& update_endpoint : update_endpoints) {
+    const HostSharedPtr& host =
+        update_endpoint.indexed_ != nullptr ? update_endpoint.indexed_->host_ : *added_host++;
+    max_host_weight = std::max(max_host_weight, host->weight());
+    if (priority_hosts[update_endpoint.priority_] != nullptr) {
+      priority_hosts[update_endpoint.priority_]->push_back(host);
+    }
+  }
+
+  const uint32_t overprovisioning_factor = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+      cluster_load_assignment_.policy(), overprovisioning_factor, kDefaultOverProvisioningFactor);
+  const bool weighted_priority_health =
+      cluster_load_assignment_.policy().weighted_priority_health();
+  bool cluster_rebuilt = false;
+  for (size_t priority = 0; priority < host_sets.size(); ++priority) {
+    if (priority_hosts[priority] == nullptr) {
+      continue;
+    }
+    HostVector hosts_added;
+    if (priority < priority_state.size() && priority_state[priority].first != nullptr) {
+      hosts_added = std::move(*priority_state[priority].first);
+    }
+    ENVOY_LOG(debug, "EDS delta update for cluster: {} priority {}: {} hosts added, {} removed",
+              parent_.info_->name(), priority, hosts_added.size(), hosts_removed[priority].size());
+    priority_state_manager.updateClusterPrioritySet(
+        priority, std::move(priority_hosts[priority]), hosts_added, hosts_removed[priority],
+        absl::nullopt, weighted_priority_health, overprovisioning_factor);
+    cluster_rebuilt = true;
+  }
+
+  indexEndpoints(added_endpoints);
+  parent_.info_->configUpdateStats().update_delta_.inc();
+  if (cluster_rebuilt) {
+    parent_.info_->endpointStats().max_host_weight_.set(max_host_weight);
+  } else {
+    parent_.info_->configUpdateStats().update_no_rebuild_.inc();
+  }
+  return true;
+}
+
+void EdsClusterImpl::BatchUpdateHelper::indexEndpoints(
+    const std::vector<RegisteredEndpoint>& registered_endpoints) {
+  EndpointIndex& endpoint_index = parent_.endpoint_index_;
+  // The registered hosts may have been replaced by existing hosts with the same address.
+  HostMapConstSharedPtr all_hosts = parent_.prioritySet().crossPriorityHostMap();
+  endpoint_index.reserve(endpoint_index.size() + registered_endpoints.size());
+  for (const RegisteredEndpoint& registered : registered_endpoints) {
+    auto host = all_hosts->find(registered.address_);
+    ASSERT(host != all_hosts->end());
+    endpoint_index.insert_or_assign(
+        endpointKey(*registered.lb_endpoint_),
+        IndexedEndpoint{host->second, endpointConfigHash(*registered.lb_endpoint_),
+                        registered.lb_endpoint_->health_status(), registered.locality_index_,
+                        parent_.endpoint_index_generation_});
+  }
+  parent_.endpoint_index_shape_ = assignmentShape(cluster_load_assignment_);
+}
+
+std::string EdsClusterImpl::BatchUpdateHelper::updateLocalityEndpoints(
     const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint,
     const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
     PriorityStateManager& priority_state_manager, absl::flat_hash_set<std::string>& all_new_hosts) {
@@ -149,15 +415,16 @@ void EdsClusterImpl::BatchUpdateHelper::updateLocalityEndpoints(
   }
 
   // When the configuration contains duplicate hosts, only the first one will be retained.
-  const auto address_as_string = address->asString();
+  auto address_as_string = address->asString();
   if (all_new_hosts.contains(address_as_string)) {
-    return;
+    return "";
   }
 
   priority_state_manager.registerHostForPriority(lb_endpoint.endpoint().hostname(), address,
                                                  address_list, locality_lb_endpoint, lb_endpoint,
                                                  parent_.time_source_);
   all_new_hosts.emplace(address_as_string);
+  return address_as_string;
 }
 
 absl::Status
@@ -451,6 +718,11 @@ EdsClusterFactory::createClusterImpl(const envoy::config::cluster::v3::Cluster&
   return std::make_pair(std::make_unique<EdsClusterImpl>(cluster, context), nullptr);
 }
 
+bool EdsClusterImpl::canIndexEndpoints() const {
+  return leds_localities_.empty() && health_checker_ == nullptr &&
+         Runtime::runtimeFeatureEnabled("envoy.reloadable_features.eds_delta_host_update");
+}
+
 bool EdsClusterImpl::validateAllLedsUpdated() const {
   // Iterate through all LEDS based localities, and if they are all updated return true.
   for (const auto& [_, leds_subscription] : leds_localities_) {
@@ -78,6 +78,26 @@ private:
   // Returns true iff all the LEDS based localities were updated.
   bool validateAllLedsUpdated() const;
 
+  // Returns true if the endpoints of an update may be indexed, so that the next update can be
+  // applied as a delta. Endpoints are not indexed when LEDS is used, or when active health checking
+  // may keep endpoints which are no longer in the update around.
+  bool canIndexEndpoints() const;
+
+  // An endpoint of the last applied ClusterLoadAssignment.
+  struct IndexedEndpoint {
+    HostSharedPtr host_;
+    // Hash of everything that makes up the endpoint but its health status.
+    uint64_t config_hash_;
+    envoy::config::core::v3::HealthStatus health_status_;
+    // Index of the LocalityLbEndpoints the endpoint is part of.
+    uint32_t locality_index_;
+    // The last update which included the endpoint.
+    uint64_t generation_;
+  };
+  // Endpoints keyed by the serialized address proto, so that they can be matched with the
+  // endpoints of an update without resolving their addresses.
+  using EndpointIndex = absl::flat_hash_map<std::string, IndexedEndpoint>;
+
   class BatchUpdateHelper : public PrioritySet::BatchUpdateCb {
   public:
     BatchUpdateHelper(
@@ -89,7 +109,22 @@ private:
     void batchUpdate(PrioritySet::HostUpdateCb& host_update_cb) override;
 
   private:
-    void updateLocalityEndpoints(
+    struct RegisteredEndpoint {
+      const envoy::config::endpoint::v3::LbEndpoint* lb_endpoint_;
+      uint32_t locality_index_;
+      std::string address_;
+    };
+
+    // Applies the update as a delta to the endpoints of the previous one. Only the hosts of the
+    // endpoints which were added, removed or had their health status changed are touched.
+    // @return false if the update can not be applied as a delta, in which case nothing was changed
+    //         and it must be applied in full.
+    bool applyDelta(PrioritySet::HostUpdateCb& host_update_cb);
+    // Rebuilds the endpoint index of the parent after the update was applied in full.
+    void indexEndpoints(const std::vector<RegisteredEndpoint>& registered_endpoints);
+    // @return the address of the registered host, or an empty string if the endpoint was ignored
+    //         because another one has the same address.
+    std::string updateLocalityEndpoints(
         const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint,
         const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
         PriorityStateManager& priority_state_manager,
@@ -122,6 +157,12 @@ private:
 
   // Tracks whether a cached resource is used as the current EDS resource.
   bool using_cached_resource_{false};
+
+  // The endpoints of the last applied update and the shape of its localities, see
+  // canIndexEndpoints(). The shape is empty when the endpoints were not indexed.
+  EndpointIndex endpoint_index_;
+  std::string endpoint_index_shape_;
+  uint64_t endpoint_index_generation_{};
 };
 
 using EdsClusterImplSharedPtr = std::shared_ptr<EdsClusterImpl>;
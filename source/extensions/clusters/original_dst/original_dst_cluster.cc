@@ -59,11 +59,11 @@ HostConstSharedPtr OriginalDstCluster::LoadBalancer::chooseHost(LoadBalancerCont
     if (dst_host) {
       const Network::Address::Instance& dst_addr = *dst_host.get();
       // Check if a host with the destination address is already in the host set.
-      auto it = host_map_->find(dst_addr.asString());
-      if (it != host_map_->end()) {
-        HostConstSharedPtr host = it->second->host_;
+      const HostsForAddressSharedPtr* hosts = host_map_.find(dst_addr.asString());
+      if (hosts != nullptr) {
+        HostConstSharedPtr host = (*hosts)->host_;
         ENVOY_LOG(trace, "Using existing host {} {}.", *host, host->address()->asString());
-        it->second->used_ = true;
+        (*hosts)->used_ = true;
         return host;
       }
       // Add a new host
@@ -194,8 +194,7 @@ OriginalDstCluster::OriginalDstCluster(const envoy::config::cluster::v3::Cluster
       dispatcher_(context.serverFactoryContext().mainThreadDispatcher()),
       cleanup_interval_ms_(
           std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(config, cleanup_interval, 5000))),
-      cleanup_timer_(dispatcher_.createTimer([this]() -> void { cleanup(); })),
-      host_map_(std::make_shared<HostMultiMap>()) {
+      cleanup_timer_(dispatcher_.createTimer([this]() -> void { cleanup(); })) {
   if (const auto& config_opt = info_->lbOriginalDstConfig(); config_opt.has_value()) {
     if (config_opt->use_http_header()) {
       http_header_name_ = config_opt->http_header_name().empty()
@@ -214,22 +213,21 @@ OriginalDstCluster::OriginalDstCluster(const envoy::config::cluster::v3::Cluster
 
 void OriginalDstCluster::addHost(HostSharedPtr& host) {
   std::string address = host->address()->asString();
-  HostMultiMapSharedPtr new_host_map = std::make_shared<HostMultiMap>(*getCurrentHostMap());
-  auto it = new_host_map->find(address);
-  if (it != new_host_map->end()) {
+  HostMultiMap host_map = getCurrentHostMap();
+  const HostsForAddressSharedPtr* hosts = host_map.find(address);
+  if (hosts != nullptr) {
     // If the entry already exists, that means the worker that posted this host
     // had a stale host map. Because the host is potentially in that worker's
     // connection pools, we save the host in the host map hosts_ list and the
     // cluster priority set. Subsequently, the entire hosts_ list and the
     // primary host are removed collectively, once no longer in use.
-    it->second->hosts_.push_back(host);
+    (*hosts)->hosts_.push_back(host);
   } else {
     // The first worker that creates a host for the address defines the primary
     // host structure.
-    new_host_map->emplace(address, std::make_shared<HostsForAddress>(host));
+    setHostMap(host_map.insert(address, std::make_shared<HostsForAddress>(host)));
   }
   ENVOY_LOG(debug, "addHost() adding {} {}.", *host, address);
-  setHostMap(new_host_map);
 
   // Given the current config, only EDS clusters support multiple priorities.
   ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
@@ -244,11 +242,11 @@ void OriginalDstCluster::addHost(HostSharedPtr& host) {
 void OriginalDstCluster::cleanup() {
   HostVectorSharedPtr keeping_hosts(new HostVector);
   HostVector to_be_removed;
-  absl::flat_hash_set<absl::string_view> removed_addresses;
-  auto host_map = getCurrentHostMap();
-  if (!host_map->empty()) {
+  std::vector<std::string> removed_addresses;
+  HostMultiMap host_map = getCurrentHostMap();
+  if (!host_map.empty()) {
     ENVOY_LOG(trace, "Cleaning up stale original dst hosts.");
-    for (const auto& [addr, hosts] : *host_map) {
+    host_map.forEach([&](const std::string& addr, const HostsForAddressSharedPtr& hosts) {
       // Address is kept in the cluster if either of the two things happen:
       // 1) a host has been recently selected for the address; 2) none of the
       // hosts are currently in any of the connection pools.
@@ -293,20 +291,20 @@ void OriginalDstCluster::cleanup() {
         }
       } else {
         ENVOY_LOG(trace, "Removing stale address {}.", addr);
-        removed_addresses.insert(addr);
+        removed_addresses.push_back(addr);
         to_be_removed.emplace_back(hosts->host_);
         if (!hosts->hosts_.empty()) {
           to_be_removed.insert(to_be_removed.end(), hosts->hosts_.begin(), hosts->hosts_.end());
         }
       }
-    }
+    });
   }
   if (!to_be_removed.empty()) {
-    HostMultiMapSharedPtr new_host_map = std::make_shared<HostMultiMap>(*host_map);
+    HostMultiMap new_host_map = host_map;
     for (const auto& addr : removed_addresses) {
-      new_host_map->erase(addr);
+      new_host_map = new_host_map.erase(addr);
     }
-    setHostMap(new_host_map);
+    setHostMap(std::move(new_host_map));
     priority_set_.updateHosts(
         0, HostSetImpl::partitionHosts(keeping_hosts, HostsPerLocalityImpl::empty()), {}, {},
         to_be_removed, false, absl::nullopt);
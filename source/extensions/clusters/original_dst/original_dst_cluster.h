@@ -12,6 +12,7 @@
 
 #include "source/common/common/empty_string.h"
 #include "source/common/common/logger.h"
+#include "source/common/common/persistent_hash_map.h"
 #include "source/common/config/metadata.h"
 #include "source/common/upstream/cluster_factory_impl.h"
 #include "source/common/upstream/upstream_impl.h"
@@ -38,9 +39,9 @@ struct HostsForAddress {
 };
 
 using HostsForAddressSharedPtr = std::shared_ptr<HostsForAddress>;
-using HostMultiMap = absl::flat_hash_map<std::string, HostsForAddressSharedPtr>;
-using HostMultiMapSharedPtr = std::shared_ptr<HostMultiMap>;
-using HostMultiMapConstSharedPtr = std::shared_ptr<const HostMultiMap>;
+// The map is persistent so that adding or removing a host only copies O(log n) of it, rather than
+// the whole map, before the result is published to the workers.
+using HostMultiMap = PersistentHashMap<std::string, HostsForAddressSharedPtr>;
 
 class OriginalDstCluster;
 
@@ -120,7 +121,7 @@ public:
     const absl::optional<Http::LowerCaseString>& http_header_name_;
     const absl::optional<Config::MetadataKey>& metadata_key_;
     const absl::optional<uint32_t> port_override_;
-    HostMultiMapConstSharedPtr host_map_;
+    const HostMultiMap host_map_;
   };
 
   const absl::optional<Http::LowerCaseString>& httpHeaderName() { return http_header_name_; }
@@ -156,14 +157,14 @@ private:
     const OriginalDstClusterHandleSharedPtr cluster_;
   };
 
-  HostMultiMapConstSharedPtr getCurrentHostMap() {
+  HostMultiMap getCurrentHostMap() {
     absl::ReaderMutexLock lock(&host_map_lock_);
     return host_map_;
   }
 
-  void setHostMap(const HostMultiMapConstSharedPtr& new_host_map) {
+  void setHostMap(HostMultiMap new_host_map) {
     absl::WriterMutexLock lock(&host_map_lock_);
-    host_map_ = new_host_map;
+    host_map_ = std::move(new_host_map);
   }
 
   void addHost(HostSharedPtr&);
@@ -177,7 +178,7 @@ private:
   Event::TimerPtr cleanup_timer_;
 
   absl::Mutex host_map_lock_;
-  HostMultiMapConstSharedPtr host_map_ ABSL_GUARDED_BY(host_map_lock_);
+  HostMultiMap host_map_ ABSL_GUARDED_BY(host_map_lock_);
   absl::optional<Http::LowerCaseString> http_header_name_;
   absl::optional<Config::MetadataKey> metadata_key_;
   absl::optional<uint32_t> port_override_;
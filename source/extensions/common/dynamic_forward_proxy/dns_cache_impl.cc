@@ -6,6 +6,7 @@
 #include "source/common/common/stl_helpers.h"
 #include "source/common/config/utility.h"
 #include "source/common/http/utility.h"
+#include "source/common/network/dns_resolver/caching_dns_resolver.h"
 #include "source/common/network/dns_resolver/dns_factory_util.h"
 #include "source/common/network/resolver_impl.h"
 #include "source/common/network/utility.h"
@@ -88,8 +89,19 @@ Network::DnsResolverSharedPtr DnsCacheImpl::selectDnsResolver(
   envoy::config::core::v3::TypedExtensionConfig typed_dns_resolver_config;
   Network::DnsResolverFactory& dns_resolver_factory =
       Network::createDnsResolverFactoryFromProto(config, typed_dns_resolver_config);
-  return dns_resolver_factory.createDnsResolver(main_thread_dispatcher, context.api(),
-                                                typed_dns_resolver_config);
+  auto create_resolver = [&]() {
+    return dns_resolver_factory.createDnsResolver(main_thread_dispatcher, context.api(),
+                                                  typed_dns_resolver_config);
+  };
+  Network::SharedCachingDnsResolversSharedPtr shared_resolvers =
+      Network::SharedCachingDnsResolvers::find(context.singletonManager());
+  if (shared_resolvers == nullptr) {
+    return create_resolver();
+  }
+  // Share the resolutions with the DNS-based clusters and the other DNS caches using the same
+  // resolver configuration.
+  return shared_resolvers->get(main_thread_dispatcher, context.serverScope(),
+                               &typed_dns_resolver_config, create_resolver);
 }
 
 DnsCacheStats DnsCacheImpl::generateDnsCacheStats(Stats::Scope& scope) {
@@ -260,12 +272,8 @@ void DnsCacheImpl::onReResolve(const std::string& host) {
             last_used_time.count(), host_ttl_.count());
   if ((now_duration - last_used_time) > host_ttl_) {
     ENVOY_LOG(debug, "host='{}' TTL expired, removing", host);
-    // If the host has no address then that means that the DnsCacheImpl has never
-    // runAddUpdateCallbacks for this host, and thus the callback targets are not aware of it.
-    // Therefore, runRemoveCallbacks should only be ran if the host's address != nullptr.
-    if (primary_host.host_info_->address()) {
-      runRemoveCallbacks(host);
-    }
+    // The host is erased before the remove callbacks run, so that a callback target does not get
+    // it back from getHost() on another thread once it has processed the removal.
     {
       removeCacheEntry(host);
       absl::WriterMutexLock writer_lock{&primary_hosts_lock_};
@@ -274,6 +282,12 @@ void DnsCacheImpl::onReResolve(const std::string& host) {
       host_to_erase = std::move(host_it->second);
       primary_hosts_.erase(host_it);
     }
+    // If the host has no address then that means that the DnsCacheImpl has never
+    // runAddUpdateCallbacks for this host, and thus the callback targets are not aware of it.
+    // Therefore, runRemoveCallbacks should only be ran if the host's address != nullptr.
+    if (primary_host.host_info_->address()) {
+      runRemoveCallbacks(host);
+    }
     notifyThreads(host, primary_host.host_info_);
   } else {
     startResolve(host, primary_host);
@@ -0,0 +1,237 @@
+#include "source/extensions/filters/listener/tls_inspector/client_hello_parser.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Envoy {
+namespace Extensions {
+namespace ListenerFilters {
+namespace TlsInspector {
+namespace {
+
+// The versions of TLS, in the order of preference of BoringSSL.
+constexpr std::array<uint16_t, 4> TlsVersions = {TLS1_3_VERSION, TLS1_2_VERSION, TLS1_1_VERSION,
+                                                  TLS1_VERSION};
+
+// The message type of a V2ClientHello, which comes after its two bytes of length.
+constexpr uint8_t SSL2ClientHello = 1;
+
+// The type of the encrypted_client_hello extension of a ClientHelloOuter.
+constexpr uint8_t EchClientOuter = 0;
+
+// The number of extensions which can be checked for duplicates without allocating. Clients send
+// about twenty of them.
+constexpr size_t MaxExtensions = 64;
+
+// Checks that the extensions are well-formed and that no extension is repeated.
+bool checkExtensions(CBS extensions) {
+  std::array<uint16_t, MaxExtensions> types;
+  size_t num_types = 0;
+  while (CBS_len(&extensions) > 0) {
+    uint16_t type;
+    CBS contents;
+    if (!CBS_get_u16(&extensions, &type) || !CBS_get_u16_length_prefixed(&extensions, &contents) ||
+        num_types == types.size()) {
+      return false;
+    }
+    // Keep the types sorted so that a repeated type is found by a binary search.
+    const auto end = types.begin() + num_types;
+    const auto it = std::lower_bound(types.begin(), end, type);
+    if (it != end && *it == type) {
+      return false;
+    }
+    std::copy_backward(it, end, end + 1);
+    *it = type;
+    ++num_types;
+  }
+  return true;
+}
+
+bool getExtension(const SSL_CLIENT_HELLO& client_hello, uint16_t type, CBS& contents) {
+  const uint8_t* data;
+  size_t len;
+  if (!SSL_early_callback_ctx_extension_get(&client_hello, type, &data, &len)) {
+    return false;
+  }
+  CBS_init(&contents, data, len);
+  return true;
+}
+
+// Checks the encrypted_client_hello extension as BoringSSL does when it has no ECH keys. Only a
+// ClientHelloOuter is expected here, as GREASE or as a real attempt at ECH.
+bool checkEncryptedClientHello(const SSL_CLIENT_HELLO& client_hello) {
+  CBS ech;
+  if (!getExtension(client_hello, TLSEXT_TYPE_encrypted_client_hello, ech)) {
+    return true;
+  }
+  uint8_t type;
+  uint16_t kdf_id;
+  uint16_t aead_id;
+  uint8_t config_id;
+  CBS enc;
+  CBS payload;
+  return CBS_get_u8(&ech, &type) && type == EchClientOuter && CBS_get_u16(&ech, &kdf_id) &&
+         CBS_get_u16(&ech, &aead_id) && CBS_get_u8(&ech, &config_id) &&
+         CBS_get_u16_length_prefixed(&ech, &enc) && CBS_get_u16_length_prefixed(&ech, &payload) &&
+         CBS_len(&ech) == 0;
+}
+
+// Extracts the host name of the server_name extension, which must hold exactly one name.
+bool getServerName(const SSL_CLIENT_HELLO& client_hello, absl::string_view& server_name) {
+  server_name = {};
+  CBS sni;
+  if (!getExtension(client_hello, TLSEXT_TYPE_server_name, sni)) {
+    return true;
+  }
+  CBS server_name_list;
+  uint8_t name_type;
+  CBS host_name;
+  if (!CBS_get_u16_length_prefixed(&sni, &server_name_list) || CBS_len(&sni) != 0 ||
+      !CBS_get_u8(&server_name_list, &name_type) ||
+      !CBS_get_u16_length_prefixed(&server_name_list, &host_name) ||
+      CBS_len(&server_name_list) != 0 || name_type != TLSEXT_NAMETYPE_host_name ||
+      CBS_len(&host_name) == 0 || CBS_len(&host_name) > TLSEXT_MAXLEN_host_name ||
+      CBS_contains_zero_byte(&host_name)) {
+    return false;
+  }
+  server_name = absl::string_view(reinterpret_cast<const char*>(CBS_data(&host_name)),
+                                  CBS_len(&host_name));
+  return true;
+}
+
+} // namespace
+
+ClientHelloParser::Result ClientHelloParser::parse(const uint8_t* data, size_t len,
+                                                   ParsedClientHello& client_hello,
+                                                   size_t& bytes_processed) const {
+  // The record header is enough to tell most data which isn't TLS apart, as its version can't be
+  // anything but SSL 3.0 or a later version.
+  CBS record;
+  CBS_init(&record, data, len);
+  uint8_t record_type;
+  uint16_t record_version;
+  uint16_t record_length;
+  if (!CBS_get_u8(&record, &record_type) || !CBS_get_u16(&record, &record_version) ||
+      !CBS_get_u16(&record, &record_length)) {
+    return Result::NeedMoreData;
+  }
+  if ((record_type & 0x80) != 0 && data[2] == SSL2ClientHello && data[3] == SSL3_VERSION_MAJOR) {
+    return Result::Unsupported;
+  }
+  if ((record_version >> 8) != SSL3_VERSION_MAJOR) {
+    bytes_processed = SSL3_RT_HEADER_LENGTH;
+    return Result::NotTls;
+  }
+  if (record_type != SSL3_RT_HANDSHAKE || record_length > SSL3_RT_MAX_PLAIN_LENGTH) {
+    return Result::Unsupported;
+  }
+
+  CBS fragment;
+  if (!CBS_get_bytes(&record, &fragment, record_length)) {
+    return Result::NeedMoreData;
+  }
+  // BoringSSL rejects any handshake data which follows the ClientHello, so the ClientHello fills
+  // the record when it isn't fragmented.
+  uint8_t message_type;
+  CBS body;
+  if (!CBS_get_u8(&fragment, &message_type) || message_type != SSL3_MT_CLIENT_HELLO ||
+      !CBS_get_u24_length_prefixed(&fragment, &body) || CBS_len(&fragment) != 0 ||
+      !parseClientHello(body, client_hello)) {
+    return Result::Unsupported;
+  }
+  bytes_processed = SSL3_RT_HEADER_LENGTH + record_length;
+  return Result::ClientHello;
+}
+
+bool ClientHelloParser::parseClientHello(CBS body, ParsedClientHello& parsed) const {
+  SSL_CLIENT_HELLO& client_hello = parsed.client_hello;
+  client_hello = {};
+  CBS random;
+  CBS session_id;
+  CBS cipher_suites;
+  CBS compression_methods;
+  if (!CBS_get_u16(&body, &client_hello.version) ||
+      !CBS_get_bytes(&body, &random, SSL3_RANDOM_SIZE) ||
+      !CBS_get_u8_length_prefixed(&body, &session_id) ||
+      CBS_len(&session_id) > SSL_MAX_SSL_SESSION_ID_LENGTH ||
+      !CBS_get_u16_length_prefixed(&body, &cipher_suites) || CBS_len(&cipher_suites) < 2 ||
+      CBS_len(&cipher_suites) % 2 != 0 ||
+      !CBS_get_u8_length_prefixed(&body, &compression_methods) ||
+      CBS_len(&compression_methods) < 1) {
+    return false;
+  }
+  CBS extensions;
+  CBS_init(&extensions, nullptr, 0);
+  if (CBS_len(&body) != 0 && (!CBS_get_u16_length_prefixed(&body, &extensions) ||
+                              CBS_len(&body) != 0 || !checkExtensions(extensions))) {
+    return false;
+  }
+  client_hello.random = CBS_data(&random);
+  client_hello.random_len = CBS_len(&random);
+  client_hello.session_id = CBS_data(&session_id);
+  client_hello.session_id_len = CBS_len(&session_id);
+  client_hello.cipher_suites = CBS_data(&cipher_suites);
+  client_hello.cipher_suites_len = CBS_len(&cipher_suites);
+  client_hello.compression_methods = CBS_data(&compression_methods);
+  client_hello.compression_methods_len = CBS_len(&compression_methods);
+  client_hello.extensions = CBS_data(&extensions);
+  client_hello.extensions_len = CBS_len(&extensions);
+
+  if (!checkEncryptedClientHello(client_hello) ||
+      !getServerName(client_hello, parsed.server_name)) {
+    return false;
+  }
+  parsed.version = negotiateVersion(client_hello);
+  if (parsed.version == 0) {
+    return false;
+  }
+  // Only the null compression method is supported, and TLS 1.3 clients may not offer any other.
+  return std::memchr(client_hello.compression_methods, 0, client_hello.compression_methods_len) !=
+             nullptr &&
+         (parsed.version < TLS1_3_VERSION || client_hello.compression_methods_len == 1);
+}
+
+uint16_t ClientHelloParser::negotiateVersion(const SSL_CLIENT_HELLO& client_hello) const {
+  CBS versions;
+  CBS supported_versions;
+  if (getExtension(client_hello, TLSEXT_TYPE_supported_versions, supported_versions)) {
+    if (!CBS_get_u8_length_prefixed(&supported_versions, &versions) ||
+        CBS_len(&supported_versions) != 0 || CBS_len(&versions) == 0 ||
+        CBS_len(&versions) % 2 != 0) {
+      return 0;
+    }
+  } else {
+    // Without the extension, the client supports every version up to the one it sent, which are
+    // the last ones of LegacyVersions.
+    static constexpr uint8_t LegacyVersions[] = {0x03, 0x03, 0x03, 0x02, 0x03, 0x01};
+    size_t versions_len = 0;
+    if (client_hello.version >= TLS1_2_VERSION) {
+      versions_len = 6;
+    } else if (client_hello.version >= TLS1_1_VERSION) {
+      versions_len = 4;
+    } else if (client_hello.version >= TLS1_VERSION) {
+      versions_len = 2;
+    }
+    CBS_init(&versions, LegacyVersions + sizeof(LegacyVersions) - versions_len, versions_len);
+  }
+
+  for (const uint16_t version : TlsVersions) {
+    if (version < min_version_ || version > max_version_) {
+      continue;
+    }
+    CBS peer_versions = versions;
+    uint16_t peer_version;
+    while (CBS_get_u16(&peer_versions, &peer_version)) {
+      if (peer_version == version) {
+        return version;
+      }
+    }
+  }
+  return 0;
+}
+
+} // namespace TlsInspector
+} // namespace ListenerFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+#include "openssl/bytestring.h"
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ListenerFilters {
+namespace TlsInspector {
+
+/**
+ * A ClientHello read by ClientHelloParser. It points into the parsed buffer, so it is only valid
+ * as long as the buffer is.
+ */
+struct ParsedClientHello {
+  // The fields of the ClientHello, as BoringSSL passes them to the select certificate callback.
+  // The ssl field is null.
+  SSL_CLIENT_HELLO client_hello;
+  // The host name of the server_name extension, empty if the extension isn't present.
+  absl::string_view server_name;
+  // The version of TLS a server supporting the configured versions would negotiate.
+  uint16_t version;
+};
+
+/**
+ * Parses the ClientHello at the start of a connection from the bytes peeked from the socket,
+ * without allocating and without a BoringSSL SSL object.
+ *
+ * The parser only decides what it can decide exactly as BoringSSL would, with the exception of
+ * the contents of the extensions, of which only server_name, supported_versions and
+ * encrypted_client_hello are validated. This covers a ClientHello sent in a single record and
+ * data that isn't TLS at all, which is what nearly every connection starts with. Anything else,
+ * such as a ClientHello fragmented over several records or a malformed one, is left to BoringSSL.
+ */
+class ClientHelloParser {
+public:
+  enum class Result {
+    // The data received so far is the start of a ClientHello.
+    NeedMoreData,
+    // The data isn't TLS.
+    NotTls,
+    // The data starts with a valid ClientHello.
+    ClientHello,
+    // The data has to be handed to BoringSSL to tell what it is.
+    Unsupported,
+  };
+
+  /**
+   * @param min_version the lowest version of TLS the server supports.
+   * @param max_version the highest version of TLS the server supports.
+   */
+  ClientHelloParser(uint16_t min_version, uint16_t max_version)
+      : min_version_(min_version), max_version_(max_version) {}
+
+  /**
+   * Parses the data received at the start of a connection.
+   * @param data the data received so far.
+   * @param len the length of data.
+   * @param client_hello receives the ClientHello when the result is ClientHello.
+   * @param bytes_processed receives the number of bytes the result was determined from when the
+   *        result is NotTls or ClientHello.
+   * @return what the data is.
+   */
+  Result parse(const uint8_t* data, size_t len, ParsedClientHello& client_hello,
+               size_t& bytes_processed) const;
+
+private:
+  bool parseClientHello(CBS body, ParsedClientHello& client_hello) const;
+  uint16_t negotiateVersion(const SSL_CLIENT_HELLO& client_hello) const;
+
+  const uint16_t min_version_;
+  const uint16_t max_version_;
+};
+
+} // namespace TlsInspector
+} // namespace ListenerFilters
+} // namespace Extensions
+} // namespace Envoy
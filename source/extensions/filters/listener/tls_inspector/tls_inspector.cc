@@ -16,6 +16,7 @@
 #include "source/common/common/assert.h"
 #include "source/common/common/hex.h"
 #include "source/common/protobuf/utility.h"
+#include "source/common/runtime/runtime_features.h"
 
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -52,6 +53,7 @@ Config::Config(
     : stats_{ALL_TLS_INSPECTOR_STATS(POOL_COUNTER_PREFIX(scope, "tls_inspector."),
                                      POOL_HISTOGRAM_PREFIX(scope, "tls_inspector."))},
       ssl_ctx_(SSL_CTX_new(TLS_with_buffers_method())),
+      client_hello_parser_(TLS_MIN_SUPPORTED_VERSION, TLS_MAX_SUPPORTED_VERSION),
       enable_ja3_fingerprinting_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, enable_ja3_fingerprinting, false)),
       max_client_hello_size_(max_client_hello_size),
@@ -71,14 +73,7 @@ Config::Config(
   SSL_CTX_set_select_certificate_cb(
       ssl_ctx_.get(), [](const SSL_CLIENT_HELLO* client_hello) -> ssl_select_cert_result_t {
         Filter* filter = static_cast<Filter*>(SSL_get_app_data(client_hello->ssl));
-        filter->createJA3Hash(client_hello);
-
-        const uint8_t* data;
-        size_t len;
-        if (SSL_early_callback_ctx_extension_get(
-                client_hello, TLSEXT_TYPE_application_layer_protocol_negotiation, &data, &len)) {
-          filter->onALPN(data, len);
-        }
+        filter->onClientHello(client_hello);
         return ssl_select_cert_success;
       });
   SSL_CTX_set_tlsext_servername_callback(
@@ -96,8 +91,15 @@ Config::Config(
 bssl::UniquePtr<SSL> Config::newSsl() { return bssl::UniquePtr<SSL>{SSL_new(ssl_ctx_.get())}; }
 
 Filter::Filter(const ConfigSharedPtr& config)
-    : config_(config), ssl_(config_->newSsl()),
-      requested_read_bytes_(config->initialReadBufferSize()) {
+    : config_(config), requested_read_bytes_(config->initialReadBufferSize()) {
+  if (!Runtime::runtimeFeatureEnabled(
+          "envoy.reloadable_features.tls_inspector_client_hello_parser")) {
+    initSsl();
+  }
+}
+
+void Filter::initSsl() {
+  ssl_ = config_->newSsl();
   SSL_set_app_data(ssl_.get(), this);
   SSL_set_accept_state(ssl_.get());
 }
@@ -109,6 +111,17 @@ Network::FilterStatus Filter::onAccept(Network::ListenerFilterCallbacks& cb) {
   return Network::FilterStatus::StopIteration;
 }
 
+void Filter::onClientHello(const SSL_CLIENT_HELLO* client_hello) {
+  createJA3Hash(client_hello);
+
+  const uint8_t* data;
+  size_t len;
+  if (SSL_early_callback_ctx_extension_get(
+          client_hello, TLSEXT_TYPE_application_layer_protocol_negotiation, &data, &len)) {
+    onALPN(data, len);
+  }
+}
+
 void Filter::onALPN(const unsigned char* data, unsigned int len) {
   CBS wire, list;
   CBS_init(&wire, reinterpret_cast<const uint8_t*>(data), static_cast<size_t>(len));
@@ -145,14 +158,9 @@ Network::FilterStatus Filter::onData(Network::ListenerFilterBuffer& buffer) {
   auto raw_slice = buffer.rawSlice();
   ENVOY_LOG(trace, "tls inspector: recv: {}", raw_slice.len_);
 
-  // Because we're doing a MSG_PEEK, data we've seen before gets returned every time, so
-  // skip over what we've already processed.
   if (static_cast<uint64_t>(raw_slice.len_) > read_) {
-    const uint8_t* data = static_cast<const uint8_t*>(raw_slice.mem_) + read_;
-    const size_t len = raw_slice.len_ - read_;
-    const uint64_t bytes_already_processed = read_;
     read_ = raw_slice.len_;
-    ParseState parse_state = parseClientHello(data, len, bytes_already_processed);
+    ParseState parse_state = parseClientHello(static_cast<const uint8_t*>(raw_slice.mem_), read_);
     switch (parse_state) {
     case ParseState::Error:
       cb_->socket().ioHandle().close();
@@ -169,8 +177,74 @@ Network::FilterStatus Filter::onData(Network::ListenerFilterBuffer& buffer) {
   return Network::FilterStatus::StopIteration;
 }
 
-ParseState Filter::parseClientHello(const void* data, size_t len,
-                                    uint64_t bytes_already_processed) {
+ParseState Filter::parseClientHello(const uint8_t* data, size_t len) {
+  if (ssl_ == nullptr) {
+    ParsedClientHello client_hello;
+    size_t bytes_processed = 0;
+    switch (config_->clientHelloParser().parse(data, len, client_hello, bytes_processed)) {
+    case ClientHelloParser::Result::NeedMoreData: {
+      const ParseState state = onMoreDataNeeded();
+      if (state != ParseState::Continue) {
+        config_->stats().bytes_processed_.recordValue(len);
+      }
+      return state;
+    }
+    case ClientHelloParser::Result::NotTls:
+      onParseDone();
+      config_->stats().bytes_processed_.recordValue(bytes_processed);
+      return ParseState::Done;
+    case ClientHelloParser::Result::ClientHello:
+      // Same callbacks, in the same order, as BoringSSL makes.
+      onClientHello(&client_hello.client_hello);
+      onServername(client_hello.server_name);
+      onParseDone();
+      config_->stats().bytes_processed_.recordValue(bytes_processed);
+      return ParseState::Done;
+    case ClientHelloParser::Result::Unsupported:
+      ENVOY_LOG(trace, "tls inspector: parsing the ClientHello with BoringSSL");
+      initSsl();
+      break;
+    }
+  }
+
+  // Because we're doing a MSG_PEEK, data we've seen before gets returned every time, so
+  // skip over what BoringSSL has already processed.
+  const uint64_t bytes_already_processed = ssl_read_;
+  ssl_read_ = len;
+  return parseClientHelloWithSsl(data + bytes_already_processed, len - bytes_already_processed,
+                                 bytes_already_processed);
+}
+
+ParseState Filter::onMoreDataNeeded() {
+  if (read_ == maxConfigReadBytes()) {
+    // We've hit the specified size limit. This is an unreasonably large ClientHello;
+    // indicate failure.
+    config_->stats().client_hello_too_large_.inc();
+    return ParseState::Error;
+  }
+  if (read_ == requested_read_bytes_) {
+    // Double requested bytes up to the maximum configured.
+    requested_read_bytes_ = std::min<uint32_t>(2 * requested_read_bytes_, maxConfigReadBytes());
+  }
+  return ParseState::Continue;
+}
+
+void Filter::onParseDone() {
+  if (clienthello_success_) {
+    config_->stats().tls_found_.inc();
+    if (alpn_found_) {
+      config_->stats().alpn_found_.inc();
+    } else {
+      config_->stats().alpn_not_found_.inc();
+    }
+    cb_->socket().setDetectedTransportProtocol("tls");
+  } else {
+    config_->stats().tls_not_found_.inc();
+  }
+}
+
+ParseState Filter::parseClientHelloWithSsl(const void* data, size_t len,
+                                           uint64_t bytes_already_processed) {
   // Ownership remains here though we pass a reference to it in `SSL_set0_rbio()`.
   bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(data, len));
 
@@ -188,29 +262,9 @@ ParseState Filter::parseClientHello(const void* data, size_t len,
   ParseState state = [this, ret]() {
     switch (SSL_get_error(ssl_.get(), ret)) {
     case SSL_ERROR_WANT_READ:
-      if (read_ == maxConfigReadBytes()) {
-        // We've hit the specified size limit. This is an unreasonably large ClientHello;
-        // indicate failure.
-        config_->stats().client_hello_too_large_.inc();
-        return ParseState::Error;
-      }
-      if (read_ == requested_read_bytes_) {
-        // Double requested bytes up to the maximum configured.
-        requested_read_bytes_ = std::min<uint32_t>(2 * requested_read_bytes_, maxConfigReadBytes());
-      }
-      return ParseState::Continue;
+      return onMoreDataNeeded();
     case SSL_ERROR_SSL:
-      if (clienthello_success_) {
-        config_->stats().tls_found_.inc();
-        if (alpn_found_) {
-          config_->stats().alpn_found_.inc();
-        } else {
-          config_->stats().alpn_not_found_.inc();
-        }
-        cb_->socket().setDetectedTransportProtocol("tls");
-      } else {
-        config_->stats().tls_not_found_.inc();
-      }
+      onParseDone();
       return ParseState::Done;
     default:
       return ParseState::Error;
@@ -9,6 +9,7 @@
 #include "envoy/stats/stats_macros.h"
 
 #include "source/common/common/logger.h"
+#include "source/extensions/filters/listener/tls_inspector/client_hello_parser.h"
 
 #include "openssl/ssl.h"
 
@@ -56,6 +57,7 @@ public:
 
   const TlsInspectorStats& stats() const { return stats_; }
   bssl::UniquePtr<SSL> newSsl();
+  const ClientHelloParser& clientHelloParser() const { return client_hello_parser_; }
   bool enableJA3Fingerprinting() const { return enable_ja3_fingerprinting_; }
   uint32_t maxClientHelloSize() const { return max_client_hello_size_; }
   uint32_t initialReadBufferSize() const { return initial_read_buffer_size_; }
@@ -67,6 +69,7 @@ public:
 private:
   TlsInspectorStats stats_;
   bssl::UniquePtr<SSL_CTX> ssl_ctx_;
+  const ClientHelloParser client_hello_parser_;
   const bool enable_ja3_fingerprinting_;
   const uint32_t max_client_hello_size_;
   const uint32_t initial_read_buffer_size_;
@@ -87,8 +90,14 @@ public:
   size_t maxReadBytes() const override { return requested_read_bytes_; }
 
 private:
-  ParseState parseClientHello(const void* data, size_t len, uint64_t bytes_already_processed);
+  ParseState parseClientHello(const uint8_t* data, size_t len);
+  ParseState parseClientHelloWithSsl(const void* data, size_t len,
+                                     uint64_t bytes_already_processed);
   ParseState onRead();
+  ParseState onMoreDataNeeded();
+  void onParseDone();
+  void initSsl();
+  void onClientHello(const SSL_CLIENT_HELLO* client_hello);
   void onALPN(const unsigned char* data, unsigned int len);
   void onServername(absl::string_view name);
   void createJA3Hash(const SSL_CLIENT_HELLO* ssl_client_hello);
@@ -97,8 +106,11 @@ private:
   ConfigSharedPtr config_;
   Network::ListenerFilterCallbacks* cb_{};
 
+  // Only created when the ClientHello can't be parsed without BoringSSL.
   bssl::UniquePtr<SSL> ssl_;
   uint64_t read_{0};
+  // The number of bytes handed to ssl_.
+  uint64_t ssl_read_{0};
   bool alpn_found_{false};
   bool clienthello_success_{false};
   // We dynamically adjust the number of bytes requested by the filter up to the
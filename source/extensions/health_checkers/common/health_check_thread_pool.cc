@@ -0,0 +1,49 @@
+#include "source/extensions/health_checkers/common/health_check_thread_pool.h"
+
+#include "source/common/common/assert.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Upstream {
+
+// Singleton registration via macro defined in envoy/singleton/manager.h
+SINGLETON_MANAGER_REGISTRATION(health_check_thread_pool);
+
+HealthCheckThreadPoolSharedPtr HealthCheckThreadPool::get(Singleton::Manager& singleton_manager,
+                                                          Api::Api& api) {
+  return singleton_manager.getTyped<HealthCheckThreadPool>(
+      SINGLETON_MANAGER_REGISTERED_NAME(health_check_thread_pool),
+      [&api] { return std::make_shared<HealthCheckThreadPool>(api); });
+}
+
+HealthCheckThreadPool::~HealthCheckThreadPool() {
+  for (HealthCheckThread& thread : threads_) {
+    thread.dispatcher_->exit();
+  }
+  for (HealthCheckThread& thread : threads_) {
+    thread.thread_->join();
+  }
+}
+
+Event::Dispatcher& HealthCheckThreadPool::pickDispatcher(uint32_t min_threads) {
+  ASSERT(min_threads > 0);
+  while (threads_.size() < min_threads) {
+    Event::DispatcherPtr dispatcher =
+        api_.allocateDispatcher(absl::StrCat("health_check_", threads_.size()));
+    Event::Dispatcher& thread_dispatcher = *dispatcher;
+    Thread::ThreadPtr thread = api_.threadFactory().createThread(
+        [&thread_dispatcher]() {
+          thread_dispatcher.run(Event::Dispatcher::RunType::RunUntilExit);
+        },
+        Thread::Options{"HealthCheck"});
+    threads_.push_back({std::move(dispatcher), std::move(thread)});
+  }
+
+  Event::Dispatcher& dispatcher = *threads_[next_thread_].dispatcher_;
+  next_thread_ = (next_thread_ + 1) % threads_.size();
+  return dispatcher;
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "envoy/api/api.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/singleton/manager.h"
+#include "envoy/thread/thread.h"
+
+namespace Envoy {
+namespace Upstream {
+
+class HealthCheckThreadPool;
+using HealthCheckThreadPoolSharedPtr = std::shared_ptr<HealthCheckThreadPool>;
+
+/**
+ * Dedicated threads which health checkers can run their sessions on instead of the main thread.
+ * Each thread runs its own dispatcher until the pool is destroyed. The pool is shared by all
+ * health checkers of the server and is only used on the main thread.
+ */
+class HealthCheckThreadPool : public Singleton::Instance {
+public:
+  explicit HealthCheckThreadPool(Api::Api& api) : api_(api) {}
+  ~HealthCheckThreadPool() override;
+
+  /**
+   * @return the thread pool of the server, which is created on first use.
+   */
+  static HealthCheckThreadPoolSharedPtr get(Singleton::Manager& singleton_manager, Api::Api& api);
+
+  /**
+   * Picks the thread for a health checker to run on. Threads are picked round robin.
+   * @param min_threads supplies the number of threads to grow the pool to first, if it is smaller.
+   * @return the dispatcher of the picked thread.
+   */
+  Event::Dispatcher& pickDispatcher(uint32_t min_threads);
+
+  /**
+   * @return the number of threads in the pool.
+   */
+  size_t size() const { return threads_.size(); }
+
+private:
+  struct HealthCheckThread {
+    Event::DispatcherPtr dispatcher_;
+    Thread::ThreadPtr thread_;
+  };
+
+  Api::Api& api_;
+  std::vector<HealthCheckThread> threads_;
+  size_t next_thread_{};
+};
+
+} // namespace Upstream
+} // namespace Envoy
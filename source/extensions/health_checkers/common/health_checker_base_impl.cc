@@ -8,6 +8,9 @@
 #include "source/common/network/utility.h"
 #include "source/common/router/router.h"
 
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/notification.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -39,6 +42,8 @@ HealthCheckerImplBase::HealthCheckerImplBase(const Cluster& cluster,
           PROTOBUF_GET_MS_OR_DEFAULT(config, healthy_edge_interval, interval_.count())),
       transport_socket_options_(initTransportSocketOptions(config)),
       transport_socket_match_metadata_(initTransportSocketMatchMetadata(config)),
+      shared_config_key_(config.share_across_clusters() ? SharedSessionRegistry::configKey(config)
+                                                        : ""),
       member_update_cb_{cluster_.prioritySet().addMemberUpdateCb(
           [this](const HostVector& hosts_added, const HostVector& hosts_removed) -> void {
             onClusterMemberUpdate(hosts_added, hosts_removed);
@@ -97,15 +102,20 @@ void HealthCheckerImplBase::incHealthy() { stats_.healthy_.add(1); }
 
 void HealthCheckerImplBase::incDegraded() { stats_.degraded_.add(1); }
 
+bool HealthCheckerImplBase::hasTraffic() const {
+  return cluster_.info()->trafficStats()->upstream_cx_total_.used();
+}
+
 std::chrono::milliseconds HealthCheckerImplBase::interval(HealthState state,
-                                                          HealthTransition changed_state) const {
+                                                          HealthTransition changed_state,
+                                                          bool has_traffic) const {
   // See if the cluster has ever made a connection. If not, we use a much slower interval to keep
   // the host info relatively up to date in case we suddenly start sending traffic to this cluster.
   // In general host updates are rare and this should greatly smooth out needless health checking.
   // If a connection has been established, we choose an interval based on the host's health. Please
   // refer to the HealthCheck API documentation for more details.
   uint64_t base_time_ms;
-  if (cluster_.info()->trafficStats()->upstream_cx_total_.used()) {
+  if (has_traffic) {
     // When healthy/unhealthy threshold is configured the health transition of a host will be
     // delayed. In this situation Envoy should use the edge interval settings between health checks.
     //
@@ -148,9 +158,10 @@ HealthCheckerImplBase::intervalWithJitter(uint64_t base_time_ms,
     base_time_ms += (random_.random() % interval_jitter.count());
   }
 
-  const uint64_t min_interval = runtime_.snapshot().getInteger("health_check.min_interval", 0);
-  const uint64_t max_interval = runtime_.snapshot().getInteger(
-      "health_check.max_interval", std::numeric_limits<uint64_t>::max());
+  const Runtime::SnapshotConstSharedPtr snapshot = runtimeSnapshot();
+  const uint64_t min_interval = snapshot->getInteger("health_check.min_interval", 0);
+  const uint64_t max_interval =
+      snapshot->getInteger("health_check.max_interval", std::numeric_limits<uint64_t>::max());
 
   uint64_t final_ms = std::min(base_time_ms, max_interval);
   // We force a non-zero final MS, to prevent live lock.
@@ -158,40 +169,139 @@ HealthCheckerImplBase::intervalWithJitter(uint64_t base_time_ms,
   return std::chrono::milliseconds(final_ms);
 }
 
+Runtime::SnapshotConstSharedPtr HealthCheckerImplBase::runtimeSnapshot() const {
+  if (thread_pool_ != nullptr) {
+    return runtime_.threadsafeSnapshot();
+  }
+  // The snapshot of the main thread is owned by the runtime loader.
+  return {Runtime::SnapshotConstSharedPtr(), &runtime_.snapshot()};
+}
+
 void HealthCheckerImplBase::addHosts(const HostVector& hosts) {
+  HostVector thread_hosts;
   for (const HostSharedPtr& host : hosts) {
     if (host->disableActiveHealthCheck()) {
       continue;
     }
-    active_sessions_[host] = makeSession(host);
+    // Workers read the monitor of the host, so it is set here on the main thread even if the
+    // session runs on a health check thread.
     host->setHealthChecker(
         HealthCheckHostMonitorPtr{new HealthCheckHostMonitorImpl(shared_from_this(), host)});
-    active_sessions_[host]->start();
+    if (thread_pool_ == nullptr) {
+      addSession(host);
+    } else {
+      thread_hosts.push_back(host);
+    }
   }
+
+  if (!thread_hosts.empty()) {
+    postToSessionThread([this, thread_hosts = std::move(thread_hosts)]() {
+      for (const HostSharedPtr& host : thread_hosts) {
+        addSession(host);
+      }
+    });
+  }
+}
+
+void HealthCheckerImplBase::addSession(const HostSharedPtr& host) {
+  ActiveHealthCheckSessionPtr& session = active_sessions_[host];
+  session = makeSession(host);
+  session->start();
 }
 
 void HealthCheckerImplBase::onClusterMemberUpdate(const HostVector& hosts_added,
                                                   const HostVector& hosts_removed) {
   addHosts(hosts_added);
+  HostVector thread_hosts;
   for (const HostSharedPtr& host : hosts_removed) {
     if (host->disableActiveHealthCheck()) {
       continue;
     }
-    auto session_iter = active_sessions_.find(host);
-    ASSERT(active_sessions_.end() != session_iter);
-    // This deletion can happen inline in response to a host failure, so we deferred delete.
-    session_iter->second->onDeferredDeleteBase();
-    dispatcher_.deferredDelete(std::move(session_iter->second));
-    active_sessions_.erase(session_iter);
+    if (thread_pool_ == nullptr) {
+      removeSession(host);
+    } else {
+      thread_hosts.push_back(host);
+    }
   }
+
+  if (!thread_hosts.empty()) {
+    postToSessionThread([this, thread_hosts = std::move(thread_hosts)]() {
+      for (const HostSharedPtr& host : thread_hosts) {
+        removeSession(host);
+      }
+    });
+  }
+}
+
+void HealthCheckerImplBase::removeSession(const HostSharedPtr& host) {
+  auto session_iter = active_sessions_.find(host);
+  ASSERT(active_sessions_.end() != session_iter);
+  // This deletion can happen inline in response to a host failure, so we deferred delete.
+  session_iter->second->onDeferredDeleteBase();
+  dispatcher_.deferredDelete(std::move(session_iter->second));
+  active_sessions_.erase(session_iter);
+}
+
+void HealthCheckerImplBase::postToSessionThread(std::function<void()> cb) {
+  // Callbacks posted to the session thread may capture this without a reference: they are posted
+  // while the health checker is referenced, and stopThreadSessions() runs after them on the same
+  // thread before the health checker is destroyed.
+  dispatcher_.post(std::move(cb));
+}
+
+void HealthCheckerImplBase::stopThreadSessions() {
+  ASSERT(thread_pool_ != nullptr);
+  absl::Notification stopped;
+  dispatcher_.post([this, &stopped]() {
+    for (auto& session : active_sessions_) {
+      session.second->onDeferredDeleteBase();
+    }
+    active_sessions_.clear();
+    stopped.Notify();
+  });
+  stopped.WaitForNotification();
 }
 
 void HealthCheckerImplBase::runCallbacks(HostSharedPtr host, HealthTransition changed_state) {
+  if (thread_pool_ != nullptr) {
+    // Hand the transition to the main thread, along with any others which are produced before it
+    // gets to run them.
+    bool post;
+    {
+      Thread::LockGuard guard(pending_callbacks_lock_);
+      post = pending_callbacks_.empty();
+      pending_callbacks_.emplace_back(std::move(host), changed_state);
+    }
+    if (post) {
+      std::weak_ptr<HealthCheckerImplBase> weak_this = weak_from_this();
+      main_dispatcher_->post([weak_this]() {
+        std::shared_ptr<HealthCheckerImplBase> shared_this = weak_this.lock();
+        if (shared_this != nullptr) {
+          shared_this->runPendingCallbacks();
+        }
+      });
+    }
+    return;
+  }
+
   for (const HostStatusCb& cb : callbacks_) {
     cb(host, changed_state);
   }
 }
 
+void HealthCheckerImplBase::runPendingCallbacks() {
+  std::vector<std::pair<HostSharedPtr, HealthTransition>> pending_callbacks;
+  {
+    Thread::LockGuard guard(pending_callbacks_lock_);
+    pending_callbacks.swap(pending_callbacks_);
+  }
+  for (const auto& [host, changed_state] : pending_callbacks) {
+    for (const HostStatusCb& cb : callbacks_) {
+      cb(host, changed_state);
+    }
+  }
+}
+
 void HealthCheckerImplBase::HealthCheckHostMonitorImpl::setUnhealthy(UnhealthyType type) {
   // This is called cross thread. The cluster/health checker might already be gone.
   std::shared_ptr<HealthCheckerImplBase> health_checker = health_checker_.lock();
@@ -206,6 +316,12 @@ void HealthCheckerImplBase::setUnhealthyCrossThread(const HostSharedPtr& host,
     host->healthFlagSet(Host::HealthFlag::EXCLUDED_VIA_IMMEDIATE_HC_FAIL);
   }
 
+  if (thread_pool_ != nullptr) {
+    // The caller holds a reference to this health checker, see postToSessionThread().
+    postToSessionThread([this, host]() { setSessionUnhealthy(host); });
+    return;
+  }
+
   // The threading here is complex. The cluster owns the only strong reference to the health
   // checker. It might go away when we post to the main thread from a worker thread. To deal with
   // this we use the following sequence of events:
@@ -219,14 +335,17 @@ void HealthCheckerImplBase::setUnhealthyCrossThread(const HostSharedPtr& host,
     if (shared_this == nullptr) {
       return;
     }
+    shared_this->setSessionUnhealthy(host);
+  });
+}
 
-    const auto session = shared_this->active_sessions_.find(host);
-    if (session == shared_this->active_sessions_.end()) {
-      return;
-    }
+void HealthCheckerImplBase::setSessionUnhealthy(const HostSharedPtr& host) {
+  const auto session = active_sessions_.find(host);
+  if (session == active_sessions_.end()) {
+    return;
+  }
 
-    session->second->setUnhealthy(envoy::data::core::v3::PASSIVE, /*retriable=*/false);
-  });
+  session->second->setUnhealthy(envoy::data::core::v3::PASSIVE, /*retriable=*/false);
 }
 
 void HealthCheckerImplBase::start() {
@@ -241,6 +360,11 @@ HealthCheckerImplBase::ActiveHealthCheckSession::ActiveHealthCheckSession(
       interval_timer_(parent.dispatcher_.createTimer([this]() -> void { onIntervalBase(); })),
       timeout_timer_(parent.dispatcher_.createTimer([this]() -> void { onTimeoutBase(); })),
       time_source_(parent.dispatcher_.timeSource()) {
+  if (parent.session_registry_ != nullptr) {
+    shared_key_ = absl::StrCat(parent.shared_config_key_, "/",
+                               host->healthCheckAddress()->asString(), "/",
+                               host->hostnameForHealthChecks());
+  }
 
   if (!host->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
     parent.incHealthy();
@@ -257,7 +381,27 @@ HealthCheckerImplBase::ActiveHealthCheckSession::~ActiveHealthCheckSession() {
   ASSERT(interval_timer_ == nullptr && timeout_timer_ == nullptr);
 }
 
+void HealthCheckerImplBase::ActiveHealthCheckSession::start() {
+  if (!shared_key_.empty() && !parent_.session_registry_->add(shared_key_, *this)) {
+    // The session of another cluster probes the endpoint and hands over its results. The last of
+    // them, if any, is applied from the timer so that the host is not left pending until the next
+    // probe.
+    interval_timer_->enableTimer(std::chrono::milliseconds(0));
+    return;
+  }
+  onInitialInterval();
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::onStartProbing() {
+  // The previous probing session may be going away inline, possibly along with its health checker,
+  // so the first probe is sent from the timer rather than from here.
+  interval_timer_->enableTimer(parent_.intervalWithJitter(0, parent_.initial_jitter_));
+}
+
 void HealthCheckerImplBase::ActiveHealthCheckSession::onDeferredDeleteBase() {
+  if (!shared_key_.empty()) {
+    parent_.session_registry_->remove(shared_key_, *this);
+  }
   // The session is about to be deferred deleted. Make sure all timers are gone and any
   // implementation specific state is destroyed.
   interval_timer_.reset();
@@ -277,6 +421,16 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::onDeferredDeleteBase() {
 }
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess(bool degraded) {
+  HealthTransition changed_state = applySuccess(degraded);
+  if (!shared_key_.empty()) {
+    parent_.session_registry_->onSuccess(shared_key_, *this, degraded);
+  }
+
+  timeout_timer_->disableTimer();
+  interval_timer_->enableTimer(interval(HealthState::Healthy, changed_state));
+}
+
+HealthTransition HealthCheckerImplBase::ActiveHealthCheckSession::applySuccess(bool degraded) {
   // If we are healthy, reset the # of unhealthy to zero.
   num_unhealthy_ = 0;
 
@@ -332,9 +486,7 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess(bool degrade
   parent_.stats_.success_.inc();
   first_check_ = false;
   parent_.runCallbacks(host_, changed_state);
-
-  timeout_timer_->disableTimer();
-  interval_timer_->enableTimer(parent_.interval(HealthState::Healthy, changed_state));
+  return changed_state;
 }
 
 namespace {
@@ -396,13 +548,16 @@ HealthTransition HealthCheckerImplBase::ActiveHealthCheckSession::setUnhealthy(
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleFailure(
     envoy::data::core::v3::HealthCheckFailureType type, bool retriable) {
   HealthTransition changed_state = setUnhealthy(type, retriable);
+  if (!shared_key_.empty()) {
+    parent_.session_registry_->onFailure(shared_key_, *this, type, retriable);
+  }
   // It's possible that the previous call caused this session to be deferred deleted.
   if (timeout_timer_ != nullptr) {
     timeout_timer_->disableTimer();
   }
 
   if (interval_timer_ != nullptr) {
-    interval_timer_->enableTimer(parent_.interval(HealthState::Unhealthy, changed_state));
+    interval_timer_->enableTimer(interval(HealthState::Unhealthy, changed_state));
   }
 }
 
@@ -419,6 +574,14 @@ HealthCheckerImplBase::ActiveHealthCheckSession::clearPendingFlag(HealthTransiti
 }
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::onIntervalBase() {
+  if (!shared_key_.empty() && !parent_.session_registry_->isProbing(shared_key_, *this)) {
+    // A result handed over since the session joined has already been applied, and is newer than
+    // the last one at the time it joined.
+    if (first_check_) {
+      parent_.session_registry_->replayLastResult(shared_key_, *this);
+    }
+    return;
+  }
   onInterval();
   timeout_timer_->enableTimer(parent_.timeout_);
   parent_.stats_.attempt_.inc();
@@ -429,6 +592,15 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::onTimeoutBase() {
   handleFailure(envoy::data::core::v3::NETWORK_TIMEOUT);
 }
 
+std::chrono::milliseconds
+HealthCheckerImplBase::ActiveHealthCheckSession::interval(HealthState state,
+                                                          HealthTransition changed_state) const {
+  const bool has_traffic = shared_key_.empty()
+                               ? parent_.hasTraffic()
+                               : parent_.session_registry_->hasTraffic(shared_key_);
+  return parent_.interval(state, changed_state, has_traffic);
+}
+
 void HealthCheckerImplBase::ActiveHealthCheckSession::onInitialInterval() {
   if (parent_.initial_jitter_.count() == 0) {
     onIntervalBase();
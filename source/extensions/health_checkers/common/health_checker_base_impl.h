@@ -1,5 +1,8 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+
 #include "envoy/access_log/access_log.h"
 #include "envoy/common/callback.h"
 #include "envoy/common/random_generator.h"
@@ -7,13 +10,18 @@
 #include "envoy/data/core/v3/health_check_event.pb.h"
 #include "envoy/event/timer.h"
 #include "envoy/runtime/runtime.h"
+#include "envoy/server/health_checker_config.h"
 #include "envoy/stats/scope.h"
 #include "envoy/type/matcher/string.pb.h"
 #include "envoy/upstream/health_checker.h"
 
+#include "source/common/common/assert.h"
 #include "source/common/common/logger.h"
 #include "source/common/common/matchers.h"
+#include "source/common/common/thread.h"
 #include "source/common/network/transport_socket_options_impl.h"
+#include "source/extensions/health_checkers/common/health_check_thread_pool.h"
+#include "source/extensions/health_checkers/common/shared_session_registry.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -55,14 +63,62 @@ public:
     return transport_socket_match_metadata_;
   }
 
+  /**
+   * Shares the sessions of this health checker with the sessions of other clusters which check
+   * the same endpoints with the same config. Must be called before start().
+   * @param registry supplies the registry of shared sessions, or nullptr to not share sessions.
+   */
+  void setSharedSessionRegistry(SharedSessionRegistrySharedPtr registry) {
+    session_registry_ = std::move(registry);
+  }
+
+  /**
+   * Creates a health checker with the settings of its config which involve state shared by the
+   * whole server: running on the health check thread pool and sharing sessions across clusters.
+   * @param config supplies the health check config.
+   * @param context supplies the context the health checker is created in.
+   * @param create_health_checker supplies a function which creates the health checker with the
+   *        dispatcher it runs its sessions on.
+   */
+  template <class T>
+  static std::shared_ptr<T>
+  create(const envoy::config::core::v3::HealthCheck& config,
+         Server::Configuration::HealthCheckerFactoryContext& context,
+         const std::function<std::unique_ptr<T>(Event::Dispatcher&)>& create_health_checker) {
+    if (config.offload_threads() == 0) {
+      std::shared_ptr<T> health_checker = create_health_checker(context.mainThreadDispatcher());
+      if (config.share_across_clusters()) {
+        health_checker->setSharedSessionRegistry(
+            SharedSessionRegistry::get(context.serverFactoryContext().singletonManager()));
+      }
+      return health_checker;
+    }
+    // Rejected by HealthCheckerFactory::create().
+    ASSERT(!config.share_across_clusters());
+
+    HealthCheckThreadPoolSharedPtr thread_pool = HealthCheckThreadPool::get(
+        context.serverFactoryContext().singletonManager(), context.api());
+    Event::Dispatcher& dispatcher = thread_pool->pickDispatcher(config.offload_threads());
+    // The sessions must be stopped on their thread while the health checker is still whole.
+    std::shared_ptr<T> health_checker(create_health_checker(dispatcher).release(),
+                                      [](T* health_checker) {
+                                        health_checker->stopThreadSessions();
+                                        delete health_checker;
+                                      });
+    health_checker->thread_pool_ = std::move(thread_pool);
+    health_checker->main_dispatcher_ = &context.mainThreadDispatcher();
+    return health_checker;
+  }
+
 protected:
-  class ActiveHealthCheckSession : public Event::DeferredDeletable {
+  class ActiveHealthCheckSession : public Event::DeferredDeletable,
+                                   public SharedSessionRegistry::Session {
   public:
     ~ActiveHealthCheckSession() override;
     HealthTransition setUnhealthy(envoy::data::core::v3::HealthCheckFailureType type,
                                   bool retriable);
     void onDeferredDeleteBase();
-    void start() { onInitialInterval(); }
+    void start();
 
   protected:
     ActiveHealthCheckSession(HealthCheckerImplBase& parent, HostSharedPtr host);
@@ -73,6 +129,18 @@ protected:
     HostSharedPtr host_;
 
   private:
+    // Upstream::SharedSessionRegistry::Session
+    void onStartProbing() override;
+    void onSharedSuccess(bool degraded) override { applySuccess(degraded); }
+    void onSharedFailure(envoy::data::core::v3::HealthCheckFailureType type,
+                         bool retriable) override {
+      setUnhealthy(type, retriable);
+    }
+    bool hasTraffic() const override { return parent_.hasTraffic(); }
+
+    // Updates the host and stats for a successful check.
+    // Returns the changed state of the host.
+    HealthTransition applySuccess(bool degraded);
     // Clears the pending flag if it is set. By clearing this flag we're marking the host as having
     // been health checked.
     // Returns the changed state to use following the flag update.
@@ -83,6 +151,9 @@ protected:
     void onTimeoutBase();
     virtual void onDeferredDelete() PURE;
     void onInitialInterval();
+    // Returns the interval until the next probe. When probes are shared, the endpoint counts as
+    // having traffic if the cluster of any session sharing them has traffic.
+    std::chrono::milliseconds interval(HealthState state, HealthTransition changed_state) const;
 
     HealthCheckerImplBase& parent_;
     Event::TimerPtr interval_timer_;
@@ -91,6 +162,9 @@ protected:
     uint32_t num_healthy_{};
     bool first_check_{true};
     TimeSource& time_source_;
+    // Identifies the endpoint and health check config when probes are shared with other clusters,
+    // empty otherwise.
+    std::string shared_key_;
   };
 
   using ActiveHealthCheckSessionPtr = std::unique_ptr<ActiveHealthCheckSession>;
@@ -103,6 +177,13 @@ protected:
   virtual ActiveHealthCheckSessionPtr makeSession(HostSharedPtr host) PURE;
   virtual envoy::data::core::v3::HealthCheckerType healthCheckerType() const PURE;
 
+  /**
+   * @return a runtime snapshot which may be read on the thread the sessions run on. Must be used
+   *         by sessions instead of runtime_.snapshot(), which is only available on threads that
+   *         are registered with thread local storage.
+   */
+  Runtime::SnapshotConstSharedPtr runtimeSnapshot() const;
+
   const bool always_log_health_check_failures_;
   const Cluster& cluster_;
   Event::Dispatcher& dispatcher_;
@@ -129,18 +210,26 @@ private:
   };
 
   void addHosts(const HostVector& hosts);
+  void addSession(const HostSharedPtr& host);
   void decHealthy();
   void decDegraded();
   HealthCheckerStats generateStats(Stats::Scope& scope);
   void incHealthy();
   void incDegraded();
-  std::chrono::milliseconds interval(HealthState state, HealthTransition changed_state) const;
+  bool hasTraffic() const;
+  std::chrono::milliseconds interval(HealthState state, HealthTransition changed_state,
+                                     bool has_traffic) const;
   std::chrono::milliseconds intervalWithJitter(uint64_t base_time_ms,
                                                std::chrono::milliseconds interval_jitter) const;
   void onClusterMemberUpdate(const HostVector& hosts_added, const HostVector& hosts_removed);
+  void postToSessionThread(std::function<void()> cb);
+  void removeSession(const HostSharedPtr& host);
   void runCallbacks(HostSharedPtr host, HealthTransition changed_state);
+  void runPendingCallbacks();
+  void setSessionUnhealthy(const HostSharedPtr& host);
   void setUnhealthyCrossThread(const HostSharedPtr& host,
                                HealthCheckHostMonitor::UnhealthyType type);
+  void stopThreadSessions();
   static std::shared_ptr<const Network::TransportSocketOptionsImpl>
   initTransportSocketOptions(const envoy::config::core::v3::HealthCheck& config);
   static MetadataConstSharedPtr
@@ -159,6 +248,16 @@ private:
   absl::node_hash_map<HostSharedPtr, ActiveHealthCheckSessionPtr> active_sessions_;
   const std::shared_ptr<const Network::TransportSocketOptionsImpl> transport_socket_options_;
   const MetadataConstSharedPtr transport_socket_match_metadata_;
+  const std::string shared_config_key_;
+  SharedSessionRegistrySharedPtr session_registry_;
+  // Set if the sessions run on a thread of the health check thread pool rather than on the main
+  // thread, in which case dispatcher_ is the dispatcher of that thread.
+  HealthCheckThreadPoolSharedPtr thread_pool_;
+  Event::Dispatcher* main_dispatcher_{};
+  // Health transitions of the sessions which are waiting to be handed to the main thread.
+  Thread::MutexBasicLockable pending_callbacks_lock_;
+  std::vector<std::pair<HostSharedPtr, HealthTransition>>
+      pending_callbacks_ ABSL_GUARDED_BY(pending_callbacks_lock_);
   const Common::CallbackHandlePtr member_update_cb_;
 };
 
@@ -0,0 +1,129 @@
+#include "source/extensions/health_checkers/common/shared_session_registry.h"
+
+#include <algorithm>
+
+#include "source/common/common/assert.h"
+#include "source/common/protobuf/utility.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Upstream {
+
+// Singleton registration via macro defined in envoy/singleton/manager.h
+SINGLETON_MANAGER_REGISTRATION(shared_health_check_session_registry);
+
+SharedSessionRegistrySharedPtr SharedSessionRegistry::get(Singleton::Manager& singleton_manager) {
+  return singleton_manager.getTyped<SharedSessionRegistry>(
+      SINGLETON_MANAGER_REGISTERED_NAME(shared_health_check_session_registry),
+      [] { return std::make_shared<SharedSessionRegistry>(); });
+}
+
+std::string SharedSessionRegistry::configKey(const envoy::config::core::v3::HealthCheck& config) {
+  envoy::config::core::v3::HealthCheck probe_config(config);
+  probe_config.clear_unhealthy_threshold();
+  probe_config.clear_healthy_threshold();
+  probe_config.clear_event_log_path();
+  probe_config.clear_event_logger();
+  probe_config.clear_event_service();
+  probe_config.clear_always_log_health_check_failures();
+  return absl::StrCat(MessageUtil::hash(probe_config));
+}
+
+bool SharedSessionRegistry::add(const std::string& key, Session& session) {
+  std::vector<Session*>& sessions = endpoints_[key].sessions;
+  sessions.push_back(&session);
+  return sessions.size() == 1;
+}
+
+void SharedSessionRegistry::remove(const std::string& key, Session& session) {
+  auto it = endpoints_.find(key);
+  ASSERT(it != endpoints_.end());
+  std::vector<Session*>& sessions = it->second.sessions;
+  auto session_it = std::find(sessions.begin(), sessions.end(), &session);
+  ASSERT(session_it != sessions.end());
+  const bool was_probing = session_it == sessions.begin();
+  sessions.erase(session_it);
+  if (sessions.empty()) {
+    endpoints_.erase(it);
+  } else if (was_probing) {
+    sessions.front()->onStartProbing();
+  }
+}
+
+bool SharedSessionRegistry::isProbing(const std::string& key, const Session& session) const {
+  auto it = endpoints_.find(key);
+  return it != endpoints_.end() && it->second.sessions.front() == &session;
+}
+
+bool SharedSessionRegistry::hasTraffic(const std::string& key) const {
+  auto it = endpoints_.find(key);
+  if (it == endpoints_.end()) {
+    return false;
+  }
+  return std::any_of(it->second.sessions.begin(), it->second.sessions.end(),
+                     [](const Session* session) { return session->hasTraffic(); });
+}
+
+void SharedSessionRegistry::replayLastResult(const std::string& key, Session& session) {
+  auto it = endpoints_.find(key);
+  if (it == endpoints_.end() || !it->second.last_result.has_value()) {
+    return;
+  }
+  // Copied, as applying the result may remove sessions inline.
+  const Result result = it->second.last_result.value();
+  if (result.success) {
+    session.onSharedSuccess(result.degraded);
+  } else {
+    session.onSharedFailure(result.failure_type, result.retriable);
+  }
+}
+
+template <class Callback>
+void SharedSessionRegistry::forEachFollower(const std::string& key, const Session& prober,
+                                            Callback callback) {
+  auto it = endpoints_.find(key);
+  if (it == endpoints_.end()) {
+    return;
+  }
+  // Applying a result runs the callbacks of the cluster, which may remove sessions inline. Only
+  // sessions which are still registered are called.
+  const std::vector<Session*> followers = it->second.sessions;
+  for (Session* session : followers) {
+    if (session == &prober) {
+      continue;
+    }
+    it = endpoints_.find(key);
+    if (it == endpoints_.end()) {
+      return;
+    }
+    const std::vector<Session*>& sessions = it->second.sessions;
+    if (std::find(sessions.begin(), sessions.end(), session) != sessions.end()) {
+      callback(*session);
+    }
+  }
+}
+
+void SharedSessionRegistry::onSuccess(const std::string& key, const Session& prober,
+                                      bool degraded) {
+  auto it = endpoints_.find(key);
+  if (it != endpoints_.end()) {
+    it->second.last_result = Result{true, degraded, {}, false};
+  }
+  forEachFollower(key, prober, [degraded](Session& session) { session.onSharedSuccess(degraded); });
+}
+
+void SharedSessionRegistry::onFailure(const std::string& key, const Session& prober,
+                                      envoy::data::core::v3::HealthCheckFailureType type,
+                                      bool retriable) {
+  auto it = endpoints_.find(key);
+  if (it != endpoints_.end()) {
+    it->second.last_result = Result{false, false, type, retriable};
+  }
+  forEachFollower(key, prober, [type, retriable](Session& session) {
+    session.onSharedFailure(type, retriable);
+  });
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/pure.h"
+#include "envoy/config/core/v3/health_check.pb.h"
+#include "envoy/data/core/v3/health_check_event.pb.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/singleton/manager.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Upstream {
+
+class SharedSessionRegistry;
+using SharedSessionRegistrySharedPtr = std::shared_ptr<SharedSessionRegistry>;
+
+/**
+ * Tracks the health check sessions of all clusters which check the same endpoint with the same
+ * health check config, so that only the first of them sends probes. The results of its probes are
+ * handed to the other sessions, which apply them to their own host. A session which joins after a
+ * probe completed is handed the last result. If the probing session goes away, the next session
+ * for the endpoint takes over. Only used on the main thread.
+ */
+class SharedSessionRegistry : public Singleton::Instance {
+public:
+  /**
+   * A health check session which may share probes with the sessions of other clusters.
+   */
+  class Session {
+  public:
+    virtual ~Session() = default;
+
+    /**
+     * Called when the session becomes the one sending probes for its endpoint.
+     */
+    virtual void onStartProbing() PURE;
+
+    /**
+     * Called with a successful result of a probe sent by another session.
+     * @param degraded supplies whether the endpoint reported itself as degraded.
+     */
+    virtual void onSharedSuccess(bool degraded) PURE;
+
+    /**
+     * Called with a failed result of a probe sent by another session.
+     * @param type supplies the type of the failure.
+     * @param retriable supplies whether the failure counts towards the unhealthy threshold.
+     */
+    virtual void onSharedFailure(envoy::data::core::v3::HealthCheckFailureType type,
+                                 bool retriable) PURE;
+
+    /**
+     * @return whether the cluster of the session has ever made a connection.
+     */
+    virtual bool hasTraffic() const PURE;
+  };
+
+  /**
+   * @return the registry of the process.
+   */
+  static SharedSessionRegistrySharedPtr get(Singleton::Manager& singleton_manager);
+
+  /**
+   * @return the part of the session key which identifies the health check config. Fields which
+   *         every cluster is allowed to set differently are ignored.
+   */
+  static std::string configKey(const envoy::config::core::v3::HealthCheck& config);
+
+  /**
+   * Adds a session.
+   * @param key supplies the key of the endpoint and health check config of the session.
+   * @param session supplies the session.
+   * @return true if the session is the first one for the key and must send probes itself.
+   */
+  bool add(const std::string& key, Session& session);
+
+  /**
+   * Removes a session. If it was sending probes, the next session for the key takes over.
+   */
+  void remove(const std::string& key, Session& session);
+
+  /**
+   * @return whether the session is the one sending probes for the key.
+   */
+  bool isProbing(const std::string& key, const Session& session) const;
+
+  /**
+   * @return whether the cluster of any session for the key has ever made a connection.
+   */
+  bool hasTraffic(const std::string& key) const;
+
+  /**
+   * Hands the last result of a probe for the key to the session, if there was a probe yet.
+   */
+  void replayLastResult(const std::string& key, Session& session);
+
+  /**
+   * Hands a successful result to the sessions for the key other than the probing one.
+   */
+  void onSuccess(const std::string& key, const Session& prober, bool degraded);
+
+  /**
+   * Hands a failed result to the sessions for the key other than the probing one.
+   */
+  void onFailure(const std::string& key, const Session& prober,
+                 envoy::data::core::v3::HealthCheckFailureType type, bool retriable);
+
+  /**
+   * @return the number of endpoints which have sessions.
+   */
+  size_t size() const { return endpoints_.size(); }
+
+private:
+  struct Result {
+    bool success{};
+    bool degraded{};
+    envoy::data::core::v3::HealthCheckFailureType failure_type{};
+    bool retriable{};
+  };
+
+  struct Endpoint {
+    // The first session is the one sending probes.
+    std::vector<Session*> sessions;
+    absl::optional<Result> last_result;
+  };
+
+  template <class Callback>
+  void forEachFollower(const std::string& key, const Session& prober, Callback callback);
+
+  absl::flat_hash_map<std::string, Endpoint> endpoints_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
@@ -45,9 +45,12 @@ const std::string& getHostname(const HostSharedPtr& host,
 Upstream::HealthCheckerSharedPtr GrpcHealthCheckerFactory::createCustomHealthChecker(
     const envoy::config::core::v3::HealthCheck& config,
     Server::Configuration::HealthCheckerFactoryContext& context) {
-  return std::make_shared<ProdGrpcHealthCheckerImpl>(
-      context.cluster(), config, context.mainThreadDispatcher(), context.runtime(),
-      context.api().randomGenerator(), context.eventLogger());
+  return HealthCheckerImplBase::create<ProdGrpcHealthCheckerImpl>(
+      config, context, [&config, &context](Event::Dispatcher& dispatcher) {
+        return std::make_unique<ProdGrpcHealthCheckerImpl>(
+            context.cluster(), config, dispatcher, context.runtime(),
+            context.api().randomGenerator(), context.eventLogger());
+      });
 }
 
 REGISTER_FACTORY(GrpcHealthCheckerFactory, Server::Configuration::CustomHealthCheckerFactory);
@@ -48,9 +48,12 @@ getMethod(const envoy::config::core::v3::RequestMethod config_method) {
 Upstream::HealthCheckerSharedPtr HttpHealthCheckerFactory::createCustomHealthChecker(
     const envoy::config::core::v3::HealthCheck& config,
     Server::Configuration::HealthCheckerFactoryContext& context) {
-  return std::make_shared<ProdHttpHealthCheckerImpl>(
-      context.cluster(), config, context.mainThreadDispatcher(), context.runtime(),
-      context.api().randomGenerator(), context.eventLogger());
+  return HealthCheckerImplBase::create<ProdHttpHealthCheckerImpl>(
+      config, context, [&config, &context](Event::Dispatcher& dispatcher) {
+        return std::make_unique<ProdHttpHealthCheckerImpl>(
+            context.cluster(), config, dispatcher, context.runtime(),
+            context.api().randomGenerator(), context.eventLogger());
+      });
 }
 
 REGISTER_FACTORY(HttpHealthCheckerFactory, Server::Configuration::CustomHealthCheckerFactory);
@@ -357,7 +360,7 @@ HttpHealthCheckerImpl::HttpActiveHealthCheckSession::healthCheckResult() {
   const auto degraded = response_headers_->EnvoyDegraded() != nullptr;
 
   if (parent_.service_name_matcher_.has_value() &&
-      parent_.runtime_.snapshot().featureEnabled("health_check.verify_cluster", 100UL)) {
+      parent_.runtimeSnapshot()->featureEnabled("health_check.verify_cluster", 100UL)) {
     parent_.stats_.verify_cluster_.inc();
     std::string service_cluster_healthchecked =
         response_headers_->EnvoyUpstreamHealthCheckedCluster()
@@ -16,11 +16,14 @@ namespace RedisHealthChecker {
 Upstream::HealthCheckerSharedPtr RedisHealthCheckerFactory::createCustomHealthChecker(
     const envoy::config::core::v3::HealthCheck& config,
     Server::Configuration::HealthCheckerFactoryContext& context) {
-  return std::make_shared<RedisHealthChecker>(
-      context.cluster(), config,
-      getRedisHealthCheckConfig(config, context.messageValidationVisitor()),
-      context.mainThreadDispatcher(), context.runtime(), context.eventLogger(), context.api(),
-      NetworkFilters::Common::Redis::Client::ClientFactoryImpl::instance_);
+  return Upstream::HealthCheckerImplBase::create<RedisHealthChecker>(
+      config, context, [&config, &context](Event::Dispatcher& dispatcher) {
+        return std::make_unique<RedisHealthChecker>(
+            context.cluster(), config,
+            getRedisHealthCheckConfig(config, context.messageValidationVisitor()), dispatcher,
+            context.runtime(), context.eventLogger(), context.api(),
+            NetworkFilters::Common::Redis::Client::ClientFactoryImpl::instance_);
+      });
 };
 
 /**
@@ -35,9 +35,12 @@ namespace Upstream {
 Upstream::HealthCheckerSharedPtr TcpHealthCheckerFactory::createCustomHealthChecker(
     const envoy::config::core::v3::HealthCheck& config,
     Server::Configuration::HealthCheckerFactoryContext& context) {
-  return std::make_shared<TcpHealthCheckerImpl>(
-      context.cluster(), config, context.mainThreadDispatcher(), context.runtime(),
-      context.api().randomGenerator(), context.eventLogger());
+  return HealthCheckerImplBase::create<TcpHealthCheckerImpl>(
+      config, context, [&config, &context](Event::Dispatcher& dispatcher) {
+        return std::make_unique<TcpHealthCheckerImpl>(
+            context.cluster(), config, dispatcher, context.runtime(),
+            context.api().randomGenerator(), context.eventLogger());
+      });
 }
 
 REGISTER_FACTORY(TcpHealthCheckerFactory, Server::Configuration::CustomHealthCheckerFactory);
@@ -15,11 +15,13 @@ namespace ThriftHealthChecker {
 Upstream::HealthCheckerSharedPtr ThriftHealthCheckerFactory::createCustomHealthChecker(
     const envoy::config::core::v3::HealthCheck& config,
     Server::Configuration::HealthCheckerFactoryContext& context) {
-  return std::make_shared<ThriftHealthChecker>(
-      context.cluster(), config,
-      getThriftHealthCheckConfig(config, context.messageValidationVisitor()),
-      context.mainThreadDispatcher(), context.runtime(), context.eventLogger(), context.api(),
-      ClientFactoryImpl::instance_);
+  return Upstream::HealthCheckerImplBase::create<ThriftHealthChecker>(
+      config, context, [&config, &context](Event::Dispatcher& dispatcher) {
+        return std::make_unique<ThriftHealthChecker>(
+            context.cluster(), config,
+            getThriftHealthCheckConfig(config, context.messageValidationVisitor()), dispatcher,
+            context.runtime(), context.eventLogger(), context.api(), ClientFactoryImpl::instance_);
+      });
 };
 
 /**
@@ -0,0 +1,173 @@
+#include "source/extensions/load_balancing_policies/peak_ewma/peak_ewma_lb.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "source/common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolices {
+namespace PeakEwma {
+
+namespace {
+constexpr uint64_t DefaultDecayTimeMs = 10000;
+constexpr uint64_t DefaultResponseTimeMs = 10;
+constexpr uint64_t DefaultFailurePenaltyMs = 1000;
+} // namespace
+
+ResponseTimeTracker::ResponseTimeTracker(std::chrono::nanoseconds decay_time,
+                                         std::chrono::nanoseconds default_response_time,
+                                         std::chrono::nanoseconds failure_penalty,
+                                         TimeSource& time_source)
+    : decay_time_ns_(decay_time.count()), default_response_time_ns_(default_response_time.count()),
+      failure_penalty_ns_(failure_penalty.count()), time_source_(time_source) {
+  ASSERT(decay_time.count() > 0);
+}
+
+void ResponseTimeTracker::onResponseTime(const Upstream::HostDescription& host,
+                                         std::chrono::microseconds response_time) {
+  addSample(host, std::chrono::duration_cast<std::chrono::nanoseconds>(response_time).count());
+}
+
+void ResponseTimeTracker::onRequestFailure(const Upstream::HostDescription& host,
+                                           std::chrono::microseconds elapsed) {
+  // A host that times out or resets requests must look slower than one that responds, however
+  // quickly it failed.
+  addSample(host,
+            std::max<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                             failure_penalty_ns_));
+}
+
+void ResponseTimeTracker::addSample(const Upstream::HostDescription& host,
+                                    double response_time_ns) {
+  auto it = hosts_.find(&host);
+  if (it == hosts_.end()) {
+    // The host has been removed since the request was sent.
+    return;
+  }
+
+  HostState& state = it->second;
+  const MonotonicTime now = time_source_.monotonicTime();
+  if (response_time_ns > state.average_) {
+    // Move up to peaks right away, so that a host that slows down is avoided quickly.
+    state.average_ = response_time_ns;
+  } else {
+    const double decay = decayFactor(state, now);
+    state.average_ = state.average_ * decay + response_time_ns * (1 - decay);
+  }
+  state.last_update_ = now;
+}
+
+void ResponseTimeTracker::addHosts(const Upstream::HostVector& hosts) {
+  for (const auto& host : hosts) {
+    hosts_.try_emplace(host.get());
+  }
+}
+
+void ResponseTimeTracker::removeHosts(const Upstream::HostVector& hosts) {
+  for (const auto& host : hosts) {
+    hosts_.erase(host.get());
+  }
+}
+
+double ResponseTimeTracker::responseTime(const Upstream::HostDescription& host,
+                                         MonotonicTime now) const {
+  auto it = hosts_.find(&host);
+  if (it == hosts_.end() || it->second.average_ < 0) {
+    return default_response_time_ns_;
+  }
+  if (host.stats().rq_active_.value() > 0) {
+    // No response is not evidence of a fast host while requests are still waiting for one.
+    return it->second.average_;
+  }
+  return it->second.average_ * decayFactor(it->second, now);
+}
+
+double ResponseTimeTracker::decayFactor(const HostState& state, MonotonicTime now) const {
+  const double elapsed_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - state.last_update_).count();
+  return elapsed_ns > 0 ? std::exp(-elapsed_ns / decay_time_ns_) : 1;
+}
+
+PeakEwmaLoadBalancer::PeakEwmaLoadBalancer(
+    const Upstream::PrioritySet& priority_set, const Upstream::PrioritySet* local_priority_set,
+    Upstream::ClusterLbStats& stats, Runtime::Loader& runtime, Random::RandomGenerator& random,
+    uint32_t healthy_panic_threshold, const PeakEwmaLbProto& config, TimeSource& time_source)
+    : ZoneAwareLoadBalancerBase(
+          priority_set, local_priority_set, stats, runtime, random, healthy_panic_threshold,
+          Upstream::LoadBalancerConfigHelper::localityLbConfigFromProto(config)),
+      choice_count_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, choice_count, 2)),
+      time_source_(time_source),
+      tracker_(std::make_shared<ResponseTimeTracker>(
+          std::chrono::milliseconds(
+              PROTOBUF_GET_MS_OR_DEFAULT(config, decay_time, DefaultDecayTimeMs)),
+          std::chrono::milliseconds(
+              PROTOBUF_GET_MS_OR_DEFAULT(config, default_response_time, DefaultResponseTimeMs)),
+          std::chrono::milliseconds(
+              PROTOBUF_GET_MS_OR_DEFAULT(config, failure_penalty, DefaultFailurePenaltyMs)),
+          time_source)) {
+  for (const auto& host_set : priority_set.hostSetsPerPriority()) {
+    tracker_->addHosts(host_set->hosts());
+  }
+  member_update_cb_ = priority_set.addMemberUpdateCb(
+      [this](const Upstream::HostVector& hosts_added, const Upstream::HostVector& hosts_removed) {
+        tracker_->addHosts(hosts_added);
+        tracker_->removeHosts(hosts_removed);
+      });
+}
+
+Upstream::HostConstSharedPtr
+PeakEwmaLoadBalancer::chooseHostOnce(Upstream::LoadBalancerContext* context) {
+  return peekOrChoose(context, false);
+}
+
+Upstream::HostConstSharedPtr
+PeakEwmaLoadBalancer::peekAnotherHost(Upstream::LoadBalancerContext* context) {
+  if (tooManyPreconnects(stashed_random_.size(), total_healthy_hosts_)) {
+    return nullptr;
+  }
+  return peekOrChoose(context, true);
+}
+
+Upstream::HostConstSharedPtr
+PeakEwmaLoadBalancer::peekOrChoose(Upstream::LoadBalancerContext* context, bool peek) {
+  const uint64_t random_hash = random(peek);
+  const absl::optional<HostsSource> hosts_source = hostSourceToUse(context, random_hash);
+  if (!hosts_source) {
+    return nullptr;
+  }
+
+  const Upstream::HostVector& hosts_to_use = hostSourceToHosts(*hosts_source);
+  if (hosts_to_use.empty()) {
+    return nullptr;
+  }
+
+  const MonotonicTime now = time_source_.monotonicTime();
+  const Upstream::HostSharedPtr* candidate_host = &hosts_to_use[random_hash % hosts_to_use.size()];
+  double candidate_cost = cost(**candidate_host, now);
+  for (uint32_t choice_idx = 1; choice_idx < choice_count_ && hosts_to_use.size() > 1;
+       ++choice_idx) {
+    const Upstream::HostSharedPtr& sampled_host =
+        hosts_to_use[random_.random() % hosts_to_use.size()];
+    const double sampled_cost = cost(*sampled_host, now);
+    if (sampled_cost < candidate_cost) {
+      candidate_host = &sampled_host;
+      candidate_cost = sampled_cost;
+    }
+  }
+
+  if (!peek && context != nullptr) {
+    context->setResponseTimeObserver(tracker_);
+  }
+  return *candidate_host;
+}
+
+double PeakEwmaLoadBalancer::cost(const Upstream::Host& host, MonotonicTime now) const {
+  return tracker_->responseTime(host, now) * (host.stats().rq_active_.value() + 1);
+}
+
+} // namespace PeakEwma
+} // namespace LoadBalancingPolices
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "envoy/common/time.h"
+#include "envoy/extensions/load_balancing_policies/peak_ewma/v3/peak_ewma.pb.h"
+#include "envoy/upstream/load_balancer.h"
+
+#include "source/common/upstream/load_balancer_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolices {
+namespace PeakEwma {
+
+using PeakEwmaLbProto = envoy::extensions::load_balancing_policies::peak_ewma::v3::PeakEwma;
+
+/**
+ * Moving averages of the response times of a set of hosts. An average jumps to any response time
+ * above it, and decays exponentially towards lower response times as well as towards zero while
+ * no responses are observed and the host has no active requests. Timed out and reset requests
+ * count as responses taking at least the failure penalty. Only used on the worker that owns it.
+ */
+class ResponseTimeTracker : public Upstream::ResponseTimeObserver {
+public:
+  ResponseTimeTracker(std::chrono::nanoseconds decay_time,
+                      std::chrono::nanoseconds default_response_time,
+                      std::chrono::nanoseconds failure_penalty, TimeSource& time_source);
+
+  // Upstream::ResponseTimeObserver
+  void onResponseTime(const Upstream::HostDescription& host,
+                      std::chrono::microseconds response_time) override;
+  void onRequestFailure(const Upstream::HostDescription& host,
+                        std::chrono::microseconds elapsed) override;
+
+  /**
+   * Start or stop recording the response times of hosts. Responses from other hosts are ignored.
+   */
+  void addHosts(const Upstream::HostVector& hosts);
+  void removeHosts(const Upstream::HostVector& hosts);
+
+  /**
+   * @return the average response time of a host in nanoseconds, decayed up to now unless the host
+   *         has active requests. Hosts without observed responses have the default response time.
+   */
+  double responseTime(const Upstream::HostDescription& host, MonotonicTime now) const;
+
+  size_t size() const { return hosts_.size(); }
+
+private:
+  struct HostState {
+    // Nanoseconds, or negative if no response has been observed yet.
+    double average_{-1};
+    MonotonicTime last_update_;
+  };
+
+  void addSample(const Upstream::HostDescription& host, double response_time_ns);
+  double decayFactor(const HostState& state, MonotonicTime now) const;
+
+  const double decay_time_ns_;
+  const double default_response_time_ns_;
+  const double failure_penalty_ns_;
+  TimeSource& time_source_;
+  absl::flat_hash_map<const Upstream::HostDescription*, HostState> hosts_;
+};
+
+using ResponseTimeTrackerSharedPtr = std::shared_ptr<ResponseTimeTracker>;
+
+/**
+ * Peak EWMA load balancer. Samples a number of random hosts and picks the one with the lowest
+ * cost, which is the average response time observed by this worker multiplied by the number of
+ * active requests plus one. @see PeakEwmaLbProto.
+ */
+class PeakEwmaLoadBalancer : public Upstream::ZoneAwareLoadBalancerBase {
+public:
+  PeakEwmaLoadBalancer(const Upstream::PrioritySet& priority_set,
+                       const Upstream::PrioritySet* local_priority_set,
+                       Upstream::ClusterLbStats& stats, Runtime::Loader& runtime,
+                       Random::RandomGenerator& random, uint32_t healthy_panic_threshold,
+                       const PeakEwmaLbProto& config, TimeSource& time_source);
+
+  // Upstream::ZoneAwareLoadBalancerBase
+  Upstream::HostConstSharedPtr chooseHostOnce(Upstream::LoadBalancerContext* context) override;
+  Upstream::HostConstSharedPtr peekAnotherHost(Upstream::LoadBalancerContext* context) override;
+
+  ResponseTimeTracker& tracker() { return *tracker_; }
+
+private:
+  Upstream::HostConstSharedPtr peekOrChoose(Upstream::LoadBalancerContext* context, bool peek);
+  double cost(const Upstream::Host& host, MonotonicTime now) const;
+
+  const uint32_t choice_count_;
+  TimeSource& time_source_;
+  // Shared with the requests in flight, which may complete after this is destroyed.
+  const ResponseTimeTrackerSharedPtr tracker_;
+  Common::CallbackHandlePtr member_update_cb_;
+};
+
+} // namespace PeakEwma
+} // namespace LoadBalancingPolices
+} // namespace Extensions
+} // namespace Envoy
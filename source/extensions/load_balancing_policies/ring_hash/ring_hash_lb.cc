@@ -11,6 +11,7 @@
 #include "source/common/upstream/load_balancer_impl.h"
 
 #include "absl/container/inlined_vector.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 
 namespace Envoy {
@@ -91,7 +92,7 @@ RingHashLoadBalancerStats RingHashLoadBalancer::generateStats(Stats::Scope& scop
 }
 
 HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h, uint32_t attempt) const {
-  if (ring_.empty()) {
+  if (hashes_.empty()) {
     return nullptr;
   }
 
@@ -100,18 +101,18 @@ HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h, uint32_t a
   // NOTE: The algorithm depends on using signed integers for lowp, midp, and highp. Do not
   //       change them!
   int64_t lowp = 0;
-  int64_t highp = ring_.size();
+  int64_t highp = hashes_.size();
   int64_t midp = 0;
   while (true) {
     midp = (lowp + highp) / 2;
 
-    if (midp == static_cast<int64_t>(ring_.size())) {
+    if (midp == static_cast<int64_t>(hashes_.size())) {
       midp = 0;
       break;
     }
 
-    uint64_t midval = ring_[midp].hash_;
-    uint64_t midval1 = midp == 0 ? 0 : ring_[midp - 1].hash_;
+    uint64_t midval = hashes_[midp];
+    uint64_t midval1 = midp == 0 ? 0 : hashes_[midp - 1];
 
     if (h <= midval && h > midval1) {
       break;
@@ -130,13 +131,13 @@ HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h, uint32_t a
   }
 
   // If a retry host predicate is being applied, behave as if this host was not in the ring.
-  // Note that this does not guarantee a different host: e.g., attempt == ring_.size() or
+  // Note that this does not guarantee a different host: e.g., attempt == hashes_.size() or
   // when the offset causes us to select the same host at another location in the ring.
   if (attempt > 0) {
-    midp = (midp + attempt) % ring_.size();
+    midp = (midp + attempt) % hashes_.size();
   }
 
-  return ring_[midp].host_;
+  return hosts_[host_indexes_[midp]];
 }
 
 using HashFunction = envoy::config::cluster::v3::Cluster::RingHashLbConfig::HashFunction;
@@ -161,9 +162,12 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
       std::min(std::ceil(min_normalized_weight * min_ring_size) / min_normalized_weight,
                static_cast<double>(max_ring_size));
 
-  // Reserve memory for the entire ring up front.
+  // Reserve memory for the entire ring up front. Entries are collected as (hash, host index)
+  // pairs, which are sorted and then split into the packed ring.
   const uint64_t ring_size = std::ceil(scale);
-  ring_.reserve(ring_size);
+  std::vector<std::pair<uint64_t, uint32_t>> ring_entries;
+  ring_entries.reserve(ring_size);
+  hosts_.reserve(normalized_host_weights.size());
 
   // Populate the hash ring by walking through the (host, weight) pairs in
   // normalized_host_weights, and generating (scale * weight) hashes for each host. Since these
@@ -195,15 +199,18 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
 
     hash_key_buffer.assign(key_to_hash.begin(), key_to_hash.end());
     hash_key_buffer.emplace_back('_');
-    auto offset_start = hash_key_buffer.end();
+    const size_t offset_start = hash_key_buffer.size();
+    const uint32_t host_index = hosts_.size();
+    hosts_.push_back(host);
 
     // As noted above: maintain current_hashes and target_hashes as running sums across the entire
     // host set. `i` is needed only to construct the hash key, and tally min/max hashes per host.
     target_hashes += scale * entry.second;
     uint64_t i = 0;
     while (current_hashes < target_hashes) {
-      const std::string i_str = absl::StrCat("", i);
-      hash_key_buffer.insert(offset_start, i_str.begin(), i_str.end());
+      // Formats into a buffer of its own, so no string is allocated per ring entry.
+      const absl::AlphaNum i_str(i);
+      hash_key_buffer.insert(hash_key_buffer.end(), i_str.data(), i_str.data() + i_str.size());
 
       absl::string_view hash_key(static_cast<char*>(hash_key_buffer.data()),
                                  hash_key_buffer.size());
@@ -214,22 +221,28 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
               : HashUtil::xxHash64(hash_key);
 
       ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key, hash);
-      ring_.push_back({hash, host});
+      ring_entries.emplace_back(hash, host_index);
       ++i;
       ++current_hashes;
-      hash_key_buffer.erase(offset_start, hash_key_buffer.end());
+      hash_key_buffer.resize(offset_start);
     }
     min_hashes_per_host = std::min(i, min_hashes_per_host);
     max_hashes_per_host = std::max(i, max_hashes_per_host);
   }
 
-  std::sort(ring_.begin(), ring_.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
-    return lhs.hash_ < rhs.hash_;
-  });
+  // Sorting by host index as well keeps the order of colliding hashes deterministic.
+  std::sort(ring_entries.begin(), ring_entries.end());
+  hashes_.reserve(ring_entries.size());
+  host_indexes_.reserve(ring_entries.size());
+  for (const auto& [hash, host_index] : ring_entries) {
+    hashes_.push_back(hash);
+    host_indexes_.push_back(host_index);
+  }
   if (ENVOY_LOG_CHECK_LEVEL(trace)) {
-    for (const auto& entry : ring_) {
-      const absl::string_view key_to_hash = hashKey(entry.host_, use_hostname_for_hashing);
-      ENVOY_LOG(trace, "ring hash: host={} hash={}", key_to_hash, entry.hash_);
+    for (size_t i = 0; i < hashes_.size(); ++i) {
+      const absl::string_view key_to_hash =
+          hashKey(hosts_[host_indexes_[i]], use_hostname_for_hashing);
+      ENVOY_LOG(trace, "ring hash: host={} hash={}", key_to_hash, hashes_[i]);
     }
   }
 
@@ -45,6 +45,49 @@ Upstream::LoadBalancerPtr RoundRobinCreator::operator()(
   }
 }
 
+SharedScheduleThreadAwareLb::SharedScheduleThreadAwareLb(
+    const TypedRoundRobinLbConfig& lb_config, const Upstream::ClusterInfo& cluster_info,
+    const Upstream::PrioritySet& priority_set, Runtime::Loader& runtime,
+    Random::RandomGenerator& random, TimeSource& time_source)
+    : priority_set_(priority_set), schedules_(std::make_shared<SharedSchedules>()),
+      factory_(std::make_shared<LbFactory>(lb_config, cluster_info, runtime, random, time_source,
+                                           schedules_)) {}
+
+void SharedScheduleThreadAwareLb::initialize() {
+  // The main thread sees each update before the workers do, so the schedules are usually ready by
+  // the time the worker load balancers refresh.
+  priority_update_cb_ = priority_set_.addPriorityUpdateCb(
+      [this](uint32_t priority, const Upstream::HostVector&, const Upstream::HostVector&) {
+        schedules_->update(*priority_set_.hostSetsPerPriority()[priority]);
+      });
+  for (const auto& host_set : priority_set_.hostSetsPerPriority()) {
+    schedules_->update(*host_set);
+  }
+}
+
+Upstream::LoadBalancerPtr
+SharedScheduleThreadAwareLb::LbFactory::create(Upstream::LoadBalancerParams params) {
+  return std::make_unique<Upstream::RoundRobinLoadBalancer>(
+      params.priority_set, params.local_priority_set, cluster_info_.lbStats(), runtime_, random_,
+      PROTOBUF_PERCENT_TO_ROUNDED_INTEGER_OR_DEFAULT(cluster_info_.lbConfig(),
+                                                     healthy_panic_threshold, 100, 50),
+      lb_config_.lb_config_, time_source_, schedules_);
+}
+
+Upstream::ThreadAwareLoadBalancerPtr
+Factory::create(OptRef<const Upstream::LoadBalancerConfig> lb_config,
+                const Upstream::ClusterInfo& cluster_info,
+                const Upstream::PrioritySet& priority_set, Runtime::Loader& runtime,
+                Random::RandomGenerator& random, TimeSource& time_source) {
+  const auto* typed_config = dynamic_cast<const TypedRoundRobinLbConfig*>(lb_config.ptr());
+  if (typed_config != nullptr && typed_config->lb_config_.share_schedules_across_workers() &&
+      !typed_config->lb_config_.has_slow_start_config()) {
+    return std::make_unique<SharedScheduleThreadAwareLb>(*typed_config, cluster_info, priority_set,
+                                                         runtime, random, time_source);
+  }
+  return FactoryBase::create(lb_config, cluster_info, priority_set, runtime, random, time_source);
+}
+
 /**
  * Static registration for the Factory. @see RegisterFactory.
  */
@@ -54,10 +54,64 @@ struct RoundRobinCreator : public Logger::Loggable<Logger::Id::upstream> {
                                        TimeSource& time_source);
 };
 
+/**
+ * Thread aware load balancer for share_schedules_across_workers. It builds the weighted round robin
+ * schedules on the main thread whenever the hosts change, and hands them to the round robin load
+ * balancers of all workers.
+ */
+class SharedScheduleThreadAwareLb : public Upstream::ThreadAwareLoadBalancer {
+public:
+  SharedScheduleThreadAwareLb(const TypedRoundRobinLbConfig& lb_config,
+                              const Upstream::ClusterInfo& cluster_info,
+                              const Upstream::PrioritySet& priority_set, Runtime::Loader& runtime,
+                              Random::RandomGenerator& random, TimeSource& time_source);
+
+  // Upstream::ThreadAwareLoadBalancer
+  Upstream::LoadBalancerFactorySharedPtr factory() override { return factory_; }
+  void initialize() override;
+
+private:
+  using SharedSchedules = Upstream::EdfLoadBalancerBase::SharedSchedules;
+
+  class LbFactory : public Upstream::LoadBalancerFactory {
+  public:
+    LbFactory(const TypedRoundRobinLbConfig& lb_config, const Upstream::ClusterInfo& cluster_info,
+              Runtime::Loader& runtime, Random::RandomGenerator& random, TimeSource& time_source,
+              std::shared_ptr<const SharedSchedules> schedules)
+        : lb_config_(lb_config), cluster_info_(cluster_info), runtime_(runtime), random_(random),
+          time_source_(time_source), schedules_(std::move(schedules)) {}
+
+    // Upstream::LoadBalancerFactory
+    Upstream::LoadBalancerPtr create(Upstream::LoadBalancerParams params) override;
+    // The schedules follow the host changes, so the load balancers can be kept.
+    bool recreateOnHostChange() const override { return false; }
+
+  private:
+    const TypedRoundRobinLbConfig& lb_config_;
+    const Upstream::ClusterInfo& cluster_info_;
+    Runtime::Loader& runtime_;
+    Random::RandomGenerator& random_;
+    TimeSource& time_source_;
+    const std::shared_ptr<const SharedSchedules> schedules_;
+  };
+
+  const Upstream::PrioritySet& priority_set_;
+  const std::shared_ptr<SharedSchedules> schedules_;
+  Upstream::LoadBalancerFactorySharedPtr factory_;
+  Common::CallbackHandlePtr priority_update_cb_;
+};
+
 class Factory : public Common::FactoryBase<RoundRobinLbProto, RoundRobinCreator> {
 public:
   Factory() : FactoryBase("envoy.load_balancing_policies.round_robin") {}
 
+  Upstream::ThreadAwareLoadBalancerPtr create(OptRef<const Upstream::LoadBalancerConfig> lb_config,
+                                              const Upstream::ClusterInfo& cluster_info,
+                                              const Upstream::PrioritySet& priority_set,
+                                              Runtime::Loader& runtime,
+                                              Random::RandomGenerator& random,
+                                              TimeSource& time_source) override;
+
   Upstream::LoadBalancerConfigPtr loadConfig(const Protobuf::Message& config,
                                              ProtobufMessage::ValidationVisitor&) override {
 
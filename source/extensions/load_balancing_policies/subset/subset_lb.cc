@@ -171,6 +171,7 @@ SubsetLoadBalancer::SubsetLoadBalancer(const LoadBalancerSubsetInfo& subsets,
                                subsets.defaultSubset().fields().end()),
       subset_selectors_(subsets.subsetSelectors()), original_priority_set_(priority_set),
       original_local_priority_set_(local_priority_set), child_lb_creator_(std::move(child_lb)),
+      max_lazy_subsets_(subsets.maxLazySubsets()),
       locality_weight_aware_(subsets.localityWeightAware()),
       scale_locality_weight_(subsets.scaleLocalityWeight()), list_as_any_(subsets.listAsAny()),
       allow_redundant_keys_(subsets.allowRedundantKeys()) {
@@ -196,6 +197,16 @@ SubsetLoadBalancer::SubsetLoadBalancer(const LoadBalancerSubsetInfo& subsets,
 
   initSubsetSelectorMap();
 
+  if (max_lazy_subsets_ > 0) {
+    ENVOY_LOG(debug, "subset lb: building at most {} subsets on demand", max_lazy_subsets_);
+    lazy_stats_ = std::make_unique<LazySubsetLbStats>(LazySubsetLbStats{
+        ALL_LAZY_SUBSET_LB_STATS(POOL_COUNTER(scope_), POOL_HISTOGRAM(scope_))});
+    for (const auto& subset_selector : subset_selectors_) {
+      const auto& keys = subset_selector->selectorKeys();
+      lazy_index_keys_.insert(keys.begin(), keys.end());
+    }
+  }
+
   // Create filtered default subset (if necessary) and other subsets based on current hosts.
   refreshSubsets();
 
@@ -208,9 +219,9 @@ SubsetLoadBalancer::SubsetLoadBalancer(const LoadBalancerSubsetInfo& subsets,
 }
 
 SubsetLoadBalancer::~SubsetLoadBalancer() {
-  // Ensure gauges reflect correct values.
+  // Ensure gauges reflect correct values. Subsets built on demand may be initialized while empty.
   forEachSubset(subsets_, [&](LbSubsetEntryPtr entry) {
-    if (entry->active()) {
+    if (entry->initialized()) {
       stats_.lb_subsets_removed_.inc();
       stats_.lb_subsets_active_.dec();
     }
@@ -481,6 +492,14 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
 
   // Route has metadata match criteria defined, see if we have a matching subset.
   LbSubsetEntryPtr entry = findSubset(match_criteria->metadataMatchCriteria());
+  if (max_lazy_subsets_ > 0) {
+    // Entries without a lazy position are only on the way to other subsets.
+    if (entry == nullptr || !entry->lazy_position_.has_value()) {
+      entry = buildLazySubset(match_criteria->metadataMatchCriteria());
+    } else if (entry->initialized()) {
+      touchLazySubset(*entry);
+    }
+  }
   if (entry == nullptr || !entry->active()) {
     // No matching subset or subset not active: use fallback policy.
     return nullptr;
@@ -585,16 +604,34 @@ void SubsetLoadBalancer::processSubsets(uint32_t priority, const HostVector& all
   absl::flat_hash_set<const LbSubsetEntry*> single_host_entries;
   uint64_t collision_count_of_single_host_entries{};
 
+  const bool lazy = max_lazy_subsets_ > 0;
+  if (lazy) {
+    // Metadata that matched no host may match the updated hosts.
+    clearLazyEmptySubsets();
+    indexLazySubsetHosts(priority, all_hosts);
+  }
   for (const auto& host : all_hosts) {
+    // When subsets are built on demand, only the subsets that have been built are kept up to date.
+    if (lazy && lazy_subsets_.empty()) {
+      break;
+    }
     for (const auto& subset_selector : subset_selectors_) {
       const auto& keys = subset_selector->selectorKeys();
       // For each host, for each subset key, attempt to extract the metadata corresponding to the
       // key from the host.
       std::vector<SubsetMetadata> all_kvs = extractSubsetMetadata(keys, *host);
       for (const auto& kvs : all_kvs) {
-        // The host has metadata for each key, find or create its subset.
-        auto entry = findOrCreateLbSubsetEntry(subsets_, kvs, 0);
-        initLbSubsetEntryOnce(entry, subset_selector->singleHostPerSubset());
+        LbSubsetEntryPtr entry;
+        if (lazy) {
+          entry = findLbSubsetEntry(kvs);
+          if (entry == nullptr || !entry->initialized()) {
+            continue;
+          }
+        } else {
+          // The host has metadata for each key, find or create its subset.
+          entry = findOrCreateLbSubsetEntry(subsets_, kvs, 0);
+          initLbSubsetEntryOnce(entry, subset_selector->singleHostPerSubset());
+        }
 
         if (entry->single_host_subset_) {
           if (single_host_entries.contains(entry.get())) {
@@ -622,6 +659,12 @@ void SubsetLoadBalancer::processSubsets(uint32_t priority, const HostVector& all
   single_duplicate_stat_->set(collision_count_of_single_host_entries);
 
   // Finalize updates after all the hosts are evaluated.
+  if (lazy) {
+    for (LbSubsetEntry* entry : lazy_subsets_) {
+      entry->lb_subset_->finalize(priority);
+    }
+    return;
+  }
   forEachSubset(subsets_, [priority](LbSubsetEntryPtr entry) {
     if (entry->initialized()) {
       entry->lb_subset_->finalize(priority);
@@ -629,6 +672,213 @@ void SubsetLoadBalancer::processSubsets(uint32_t priority, const HostVector& all
   });
 }
 
+SubsetLoadBalancer::LbSubsetEntryPtr SubsetLoadBalancer::buildLazySubset(
+    const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& match_criteria) {
+  // Only the subsets of the selectors are built, as they would have been on host updates. Both the
+  // criteria and the selector keys are sorted by key.
+  const auto selector_it = std::find_if(
+      subset_selectors_.begin(), subset_selectors_.end(), [&](const SubsetSelectorPtr& selector) {
+        const std::set<std::string>& keys = selector->selectorKeys();
+        return keys.size() == match_criteria.size() &&
+               std::equal(keys.begin(), keys.end(), match_criteria.begin(),
+                          [](const std::string& key,
+                             const Router::MetadataMatchCriterionConstSharedPtr& criterion) {
+                            return key == criterion->name();
+                          });
+      });
+  if (selector_it == subset_selectors_.end()) {
+    return nullptr;
+  }
+
+  const MonotonicTime start_time = time_source_.monotonicTime();
+  SubsetMetadata kvs;
+  kvs.reserve(match_criteria.size());
+  for (const auto& criterion : match_criteria) {
+    kvs.emplace_back(criterion->name(), criterion->value().value());
+  }
+  const bool single_host_subset = (*selector_it)->singleHostPerSubset();
+
+  // The candidates of each priority are the indexed hosts of the criterion matching the fewest
+  // hosts. They still have to match the other criteria.
+  std::vector<HostVector> hosts_per_priority(lazy_host_index_.size());
+  bool has_hosts = false;
+  for (uint32_t priority = 0; priority < lazy_host_index_.size(); priority++) {
+    const LazyHostIndex& index = lazy_host_index_[priority];
+    const HostVector* candidates = nullptr;
+    for (const auto& criterion : match_criteria) {
+      const auto key_it = index.find(criterion->name());
+      if (key_it == index.end()) {
+        candidates = nullptr;
+        break;
+      }
+      const auto value_it = key_it->second.find(criterion->value());
+      if (value_it == key_it->second.end()) {
+        candidates = nullptr;
+        break;
+      }
+      if (candidates == nullptr || value_it->second.size() < candidates->size()) {
+        candidates = &value_it->second;
+      }
+    }
+    if (candidates == nullptr) {
+      continue;
+    }
+    for (const auto& host : *candidates) {
+      if (hostMatches(kvs, *host)) {
+        hosts_per_priority[priority].push_back(host);
+        has_hosts = true;
+        if (single_host_subset) {
+          break;
+        }
+      }
+    }
+  }
+
+  LbSubsetEntryPtr entry;
+  if (has_hosts) {
+    if (lazy_subsets_.size() >= max_lazy_subsets_) {
+      evictLazySubset();
+    }
+    entry = findOrCreateLbSubsetEntry(subsets_, kvs, 0);
+    initLbSubsetEntryOnce(entry, single_host_subset);
+    ENVOY_LOG(debug, "subset lb: building subset for {}", describeMetadata(kvs));
+    for (const auto& host_set : original_priority_set_.hostSetsPerPriority()) {
+      const uint32_t priority = host_set->priority();
+      if (priority < hosts_per_priority.size()) {
+        for (const auto& host : hosts_per_priority[priority]) {
+          entry->lb_subset_->pushHost(priority, host);
+        }
+      }
+      entry->lb_subset_->finalize(priority);
+    }
+    lazy_subsets_.push_front(entry.get());
+    entry->lazy_position_ = lazy_subsets_.begin();
+  } else {
+    // Subsets without hosts are neither built nor counted. The entry is remembered so that
+    // further requests for it go to the fallback policy without looking up hosts again.
+    if (lazy_empty_subsets_.size() >= max_lazy_subsets_) {
+      dropLazyEmptySubset(*lazy_empty_subsets_.back());
+    }
+    entry = findOrCreateLbSubsetEntry(subsets_, kvs, 0);
+    ENVOY_LOG(debug, "subset lb: no hosts for subset {}", describeMetadata(kvs));
+    lazy_empty_subsets_.push_front(entry.get());
+    entry->lazy_position_ = lazy_empty_subsets_.begin();
+  }
+  entry->lazy_metadata_ = std::move(kvs);
+  lazy_stats_->lb_subsets_build_time_us_.recordValue(
+      std::chrono::duration_cast<std::chrono::microseconds>(time_source_.monotonicTime() -
+                                                            start_time)
+          .count());
+  return entry;
+}
+
+void SubsetLoadBalancer::evictLazySubset() {
+  ASSERT(!lazy_subsets_.empty());
+  LbSubsetEntry& entry = *lazy_subsets_.back();
+  ENVOY_LOG(debug, "subset lb: evicting subset for {}", describeMetadata(entry.lazy_metadata_));
+  lazy_subsets_.pop_back();
+  entry.lazy_position_.reset();
+  entry.lb_subset_.reset();
+  stats_.lb_subsets_active_.dec();
+  stats_.lb_subsets_removed_.inc();
+  lazy_stats_->lb_subsets_evicted_.inc();
+
+  // Moved out first as pruning may destroy the entry.
+  const SubsetMetadata kvs = std::move(entry.lazy_metadata_);
+  pruneLbSubsetEntry(subsets_, kvs, 0);
+}
+
+void SubsetLoadBalancer::touchLazySubset(LbSubsetEntry& entry) {
+  ASSERT(entry.lazy_position_.has_value());
+  lazy_subsets_.splice(lazy_subsets_.begin(), lazy_subsets_, entry.lazy_position_.value());
+}
+
+void SubsetLoadBalancer::dropLazyEmptySubset(LbSubsetEntry& entry) {
+  ASSERT(!entry.initialized() && entry.lazy_position_.has_value());
+  lazy_empty_subsets_.erase(entry.lazy_position_.value());
+  entry.lazy_position_.reset();
+
+  // Moved out first as pruning may destroy the entry.
+  const SubsetMetadata kvs = std::move(entry.lazy_metadata_);
+  pruneLbSubsetEntry(subsets_, kvs, 0);
+}
+
+void SubsetLoadBalancer::clearLazyEmptySubsets() {
+  while (!lazy_empty_subsets_.empty()) {
+    dropLazyEmptySubset(*lazy_empty_subsets_.front());
+  }
+}
+
+// Indexes the hosts of the given priority by the values of the selector keys. With list_as_any_,
+// hosts are indexed by each value of a list, as they would match any of them.
+void SubsetLoadBalancer::indexLazySubsetHosts(uint32_t priority, const HostVector& all_hosts) {
+  if (lazy_host_index_.size() <= priority) {
+    lazy_host_index_.resize(priority + 1);
+  }
+  LazyHostIndex& index = lazy_host_index_[priority];
+  index.clear();
+
+  const auto add_host = [&index](const std::string& key, const ProtobufWkt::Value& value,
+                                 const HostSharedPtr& host) {
+    HostVector& hosts = index[key].try_emplace(HashedValue(value)).first->second;
+    // A list may hold the same value more than once.
+    if (hosts.empty() || hosts.back() != host) {
+      hosts.push_back(host);
+    }
+  };
+  for (const auto& host : all_hosts) {
+    if (!host->metadata()) {
+      continue;
+    }
+    const auto& filter_metadata = host->metadata()->filter_metadata();
+    const auto filter_it = filter_metadata.find(Config::MetadataFilters::get().ENVOY_LB);
+    if (filter_it == filter_metadata.end()) {
+      continue;
+    }
+    const auto& fields = filter_it->second.fields();
+    for (const auto& key : lazy_index_keys_) {
+      const auto it = fields.find(key);
+      if (it == fields.end()) {
+        continue;
+      }
+      if (list_as_any_ && it->second.kind_case() == ProtobufWkt::Value::kListValue) {
+        for (const auto& value : it->second.list_value().values()) {
+          add_host(key, value, host);
+        }
+      } else {
+        add_host(key, it->second, host);
+      }
+    }
+  }
+}
+
+// Removes the entry for kvs[idx..] from subsets, and the entries leading to it, as far as they
+// neither hold a subset nor lead to other entries.
+void SubsetLoadBalancer::pruneLbSubsetEntry(LbSubsetMap& subsets, const SubsetMetadata& kvs,
+                                            uint32_t idx) {
+  const auto kv_it = subsets.find(kvs[idx].first);
+  if (kv_it == subsets.end()) {
+    return;
+  }
+  ValueSubsetMap& value_subset_map = kv_it->second;
+  const auto vs_it = value_subset_map.find(HashedValue(kvs[idx].second));
+  if (vs_it == value_subset_map.end()) {
+    return;
+  }
+
+  LbSubsetEntry& entry = *vs_it->second;
+  if (idx + 1 < kvs.size()) {
+    pruneLbSubsetEntry(entry.children_, kvs, idx + 1);
+  }
+  if (entry.initialized() || entry.hasChildren() || entry.lazy_position_.has_value()) {
+    return;
+  }
+  value_subset_map.erase(vs_it);
+  if (value_subset_map.empty()) {
+    subsets.erase(kv_it);
+  }
+}
+
 // Given the latest all hosts, update all subsets for this priority level, creating new subsets as
 // necessary.
 void SubsetLoadBalancer::update(uint32_t priority, const HostVector& all_hosts) {
@@ -768,6 +1018,28 @@ SubsetLoadBalancer::findOrCreateLbSubsetEntry(LbSubsetMap& subsets, const Subset
   return findOrCreateLbSubsetEntry(entry->children_, kvs, idx);
 }
 
+// Given a vector of key-values (from extractSubsetMetadata), finds the matching LbSubsetEntryPtr
+// without creating it. Returns nullptr if there is none.
+SubsetLoadBalancer::LbSubsetEntryPtr
+SubsetLoadBalancer::findLbSubsetEntry(const SubsetMetadata& kvs) {
+  LbSubsetMap* subsets = &subsets_;
+  for (uint32_t i = 0; i < kvs.size(); i++) {
+    const auto kv_it = subsets->find(kvs[i].first);
+    if (kv_it == subsets->end()) {
+      return nullptr;
+    }
+    const auto vs_it = kv_it->second.find(HashedValue(kvs[i].second));
+    if (vs_it == kv_it->second.end()) {
+      return nullptr;
+    }
+    if (i + 1 == kvs.size()) {
+      return vs_it->second;
+    }
+    subsets = &vs_it->second->children_;
+  }
+  return nullptr;
+}
+
 // Invokes cb for each LbSubsetEntryPtr in subsets.
 void SubsetLoadBalancer::forEachSubset(LbSubsetMap& subsets,
                                        std::function<void(LbSubsetEntryPtr&)> cb) {
@@ -797,6 +1069,10 @@ void SubsetLoadBalancer::purgeEmptySubsets(LbSubsetMap& subsets) {
         stats_.lb_subsets_active_.dec();
         stats_.lb_subsets_removed_.inc();
       }
+      if (entry->lazy_position_.has_value()) {
+        (entry->initialized() ? lazy_subsets_ : lazy_empty_subsets_)
+            .erase(entry->lazy_position_.value());
+      }
 
       auto next_it = std::next(it);
       subset_it->second.erase(it);
@@ -4,9 +4,12 @@
 #include <bitset>
 #include <cstdint>
 #include <functional>
+#include <list>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "envoy/common/optref.h"
 #include "envoy/config/cluster/v3/cluster.pb.h"
@@ -14,6 +17,7 @@
 #include "envoy/extensions/load_balancing_policies/subset/v3/subset.pb.validate.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
 #include "envoy/stream_info/stream_info.h"
 #include "envoy/upstream/load_balancer.h"
 
@@ -23,12 +27,28 @@
 #include "source/common/upstream/load_balancer_impl.h"
 #include "source/common/upstream/upstream_impl.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Upstream {
 
+/**
+ * Stats of a subset load balancer that builds subsets on demand. @see stats_macros.h
+ */
+#define ALL_LAZY_SUBSET_LB_STATS(COUNTER, HISTOGRAM)                                              \
+  COUNTER(lb_subsets_evicted)                                                                      \
+  HISTOGRAM(lb_subsets_build_time_us, Microseconds)
+
+/**
+ * Struct definition for the stats of a subset load balancer that builds subsets on demand.
+ * @see stats_macros.h
+ */
+struct LazySubsetLbStats {
+  ALL_LAZY_SUBSET_LB_STATS(GENERATE_COUNTER_STRUCT, GENERATE_HISTOGRAM_STRUCT)
+};
+
 class ChildLoadBalancerCreator {
 public:
   virtual ~ChildLoadBalancerCreator() = default;
@@ -241,6 +261,11 @@ private:
   struct SubsetSelectorMap;
 
   using LbSubsetEntryPtr = std::shared_ptr<LbSubsetEntry>;
+  // Subsets built on demand, most recently used first.
+  using LazySubsetList = std::list<LbSubsetEntry*>;
+  // Hosts of a priority by subset key and value, in host order. Used to build subsets on demand.
+  using LazyHostIndex =
+      absl::node_hash_map<std::string, absl::flat_hash_map<HashedValue, HostVector>>;
   using SubsetSelectorMapPtr = std::shared_ptr<SubsetSelectorMap>;
   using ValueSubsetMap = absl::node_hash_map<HashedValue, LbSubsetEntryPtr>;
   using LbSubsetMap = absl::node_hash_map<std::string, ValueSubsetMap>;
@@ -296,6 +321,10 @@ public:
       return wrapped_->overrideHostToSelect();
     }
 
+    void setResponseTimeObserver(ResponseTimeObserverSharedPtr observer) override {
+      wrapped_->setResponseTimeObserver(std::move(observer));
+    }
+
   private:
     LoadBalancerContext* wrapped_;
     Router::MetadataMatchCriteriaConstPtr metadata_match_;
@@ -423,12 +452,30 @@ private:
     // Only initialized if a match exists at this level.
     LbSubsetPtr lb_subset_;
 
+    // Only set for subsets built on demand: the metadata of the subset, used to remove the entry
+    // when the subset is evicted, and the position of the subset in lazy_subsets_, or in
+    // lazy_empty_subsets_ if no host matched it.
+    SubsetMetadata lazy_metadata_;
+    absl::optional<LazySubsetList::iterator> lazy_position_;
+
     // Used to quick check if entry is single host subset entry or not.
     bool single_host_subset_{};
   };
 
   void initLbSubsetEntryOnce(LbSubsetEntryPtr& entry, bool single_host_subset);
 
+  // Builds the subset matching the given metadata match criteria on demand. Returns nullptr if no
+  // subset selector has exactly the keys of the criteria, and an entry without a subset if no
+  // host matches them.
+  LbSubsetEntryPtr
+  buildLazySubset(const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& match_criteria);
+  void evictLazySubset();
+  void touchLazySubset(LbSubsetEntry& entry);
+  void dropLazyEmptySubset(LbSubsetEntry& entry);
+  void clearLazyEmptySubsets();
+  void indexLazySubsetHosts(uint32_t priority, const HostVector& all_hosts);
+  void pruneLbSubsetEntry(LbSubsetMap& subsets, const SubsetMetadata& kvs, uint32_t idx);
+
   // Create filtered default subset (if necessary) and other subsets based on current hosts.
   void refreshSubsets();
   void refreshSubsets(uint32_t priority);
@@ -451,6 +498,7 @@ private:
 
   LbSubsetEntryPtr findOrCreateLbSubsetEntry(LbSubsetMap& subsets, const SubsetMetadata& kvs,
                                              uint32_t idx);
+  LbSubsetEntryPtr findLbSubsetEntry(const SubsetMetadata& kvs);
   void forEachSubset(LbSubsetMap& subsets, std::function<void(LbSubsetEntryPtr&)> cb);
   void purgeEmptySubsets(LbSubsetMap& subsets);
 
@@ -496,6 +544,16 @@ private:
 
   Stats::Gauge* single_duplicate_stat_{};
 
+  // Only used if subsets are built on demand, i.e. max_lazy_subsets_ is not 0.
+  const uint32_t max_lazy_subsets_;
+  LazySubsetList lazy_subsets_;
+  // Metadata no host matched when its subset was requested. The entries are not initialized, so
+  // requests for them use the fallback policy until the next host update without another lookup.
+  LazySubsetList lazy_empty_subsets_;
+  std::set<std::string> lazy_index_keys_;
+  std::vector<LazyHostIndex> lazy_host_index_;
+  std::unique_ptr<LazySubsetLbStats> lazy_stats_;
+
   // Keep small members (bools and enums) at the end of class, to reduce alignment overhead.
   const bool locality_weight_aware_ : 1;
   const bool scale_locality_weight_ : 1;
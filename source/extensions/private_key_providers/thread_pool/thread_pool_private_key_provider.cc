@@ -0,0 +1,336 @@
+#include "source/extensions/private_key_providers/thread_pool/thread_pool_private_key_provider.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "source/common/common/assert.h"
+#include "source/common/common/macros.h"
+#include "source/common/config/datasource.h"
+#include "source/common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace PrivateKeyMethodProvider {
+namespace ThreadPool {
+
+namespace {
+
+bssl::UniquePtr<EVP_PKEY> readPrivateKey(const envoy::config::core::v3::DataSource& source,
+                                         Api::Api& api) {
+  const std::string private_key = Config::DataSource::read(source, false, api);
+  bssl::UniquePtr<BIO> bio(
+      BIO_new_mem_buf(const_cast<char*>(private_key.data()), private_key.size()));
+  bssl::UniquePtr<EVP_PKEY> pkey(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+  if (pkey == nullptr) {
+    throw EnvoyException("Failed to read private key.");
+  }
+  const int key_type = EVP_PKEY_id(pkey.get());
+  if (key_type != EVP_PKEY_RSA && key_type != EVP_PKEY_EC) {
+    throw EnvoyException("Not supported key type, only EC and RSA are supported.");
+  }
+  return pkey;
+}
+
+ThreadPoolPrivateKeyConnection* connection(SSL* ssl) {
+  return ssl == nullptr ? nullptr
+                        : static_cast<ThreadPoolPrivateKeyConnection*>(SSL_get_ex_data(
+                              ssl, ThreadPoolPrivateKeyMethodProvider::connectionIndex()));
+}
+
+ssl_private_key_result_t privateKeySign(SSL* ssl, uint8_t*, size_t*, size_t,
+                                        uint16_t signature_algorithm, const uint8_t* in,
+                                        size_t in_len) {
+  ThreadPoolPrivateKeyConnection* ops = connection(ssl);
+  return ops == nullptr ? ssl_private_key_failure
+                        : ops->start(PrivateKeyOperation::Type::Sign, signature_algorithm, in,
+                                     in_len);
+}
+
+ssl_private_key_result_t privateKeyDecrypt(SSL* ssl, uint8_t*, size_t*, size_t, const uint8_t* in,
+                                           size_t in_len) {
+  ThreadPoolPrivateKeyConnection* ops = connection(ssl);
+  return ops == nullptr ? ssl_private_key_failure
+                        : ops->start(PrivateKeyOperation::Type::Decrypt, 0, in, in_len);
+}
+
+ssl_private_key_result_t privateKeyComplete(SSL* ssl, uint8_t* out, size_t* out_len,
+                                            size_t max_out) {
+  ThreadPoolPrivateKeyConnection* ops = connection(ssl);
+  return ops == nullptr ? ssl_private_key_failure : ops->complete(out, out_len, max_out);
+}
+
+bool sign(EVP_PKEY* pkey, uint16_t signature_algorithm, const std::vector<uint8_t>& in,
+          std::vector<uint8_t>& out) {
+  if (EVP_PKEY_id(pkey) != SSL_get_signature_algorithm_key_type(signature_algorithm)) {
+    return false;
+  }
+  const EVP_MD* md = SSL_get_signature_algorithm_digest(signature_algorithm);
+  if (md == nullptr) {
+    return false;
+  }
+
+  bssl::ScopedEVP_MD_CTX ctx;
+  EVP_PKEY_CTX* pctx;
+  if (!EVP_DigestSignInit(ctx.get(), &pctx, md, nullptr, pkey)) {
+    return false;
+  }
+  if (SSL_is_signature_algorithm_rsa_pss(signature_algorithm) &&
+      (!EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING) ||
+       !EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1 /* salt length is the digest length */))) {
+    return false;
+  }
+  size_t out_len = EVP_PKEY_size(pkey);
+  out.resize(out_len);
+  if (!EVP_DigestSign(ctx.get(), out.data(), &out_len, in.data(), in.size())) {
+    return false;
+  }
+  out.resize(out_len);
+  return true;
+}
+
+bool decrypt(EVP_PKEY* pkey, const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+  RSA* rsa = EVP_PKEY_get0_RSA(pkey);
+  if (rsa == nullptr) {
+    return false;
+  }
+  size_t out_len = RSA_size(rsa);
+  out.resize(out_len);
+  // The TLS stack removes the padding itself.
+  if (!RSA_decrypt(rsa, &out_len, out.data(), out.size(), in.data(), in.size(), RSA_NO_PADDING)) {
+    return false;
+  }
+  out.resize(out_len);
+  return true;
+}
+
+} // namespace
+
+void PrivateKeyOperation::run() {
+  success_ = type_ == Type::Sign ? sign(pkey_.get(), signature_algorithm_, input_, output_)
+                                 : decrypt(pkey_.get(), input_, output_);
+}
+
+void CompletionPoster::post(Event::PostCb callback) {
+  absl::MutexLock lock(&mutex_);
+  if (dispatcher_ != nullptr) {
+    dispatcher_->post(std::move(callback));
+  }
+}
+
+void CompletionPoster::shutdown() {
+  absl::MutexLock lock(&mutex_);
+  dispatcher_ = nullptr;
+}
+
+PrivateKeyThreadPool::PrivateKeyThreadPool(Thread::ThreadFactory& thread_factory,
+                                           TimeSource& time_source, uint32_t thread_count)
+    : time_source_(time_source) {
+  ASSERT(thread_count > 0);
+  threads_.reserve(thread_count);
+  for (uint32_t i = 0; i < thread_count; i++) {
+    threads_.push_back(thread_factory.createThread([this]() { threadRoutine(); },
+                                                   Thread::Options{"PrivateKey"}));
+  }
+}
+
+PrivateKeyThreadPool::~PrivateKeyThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    terminate_ = true;
+  }
+  for (Thread::ThreadPtr& thread : threads_) {
+    thread->join();
+  }
+}
+
+void PrivateKeyThreadPool::enqueue(PrivateKeyOperationSharedPtr operation,
+                                   CompletionPosterSharedPtr poster) {
+  absl::MutexLock lock(&mutex_);
+  jobs_.push({std::move(operation), std::move(poster)});
+}
+
+void PrivateKeyThreadPool::threadRoutine() {
+  while (true) {
+    Job job;
+    {
+      const auto has_work = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+        return !jobs_.empty() || terminate_;
+      };
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(&has_work));
+      if (terminate_) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop();
+    }
+
+    PrivateKeyOperation& operation = *job.operation_;
+    operation.started_ = time_source_.monotonicTime();
+    operation.run();
+    operation.finished_ = time_source_.monotonicTime();
+    job.poster_->post([operation = std::move(job.operation_)]() {
+      if (operation->connection_ != nullptr) {
+        operation->connection_->onOperationComplete();
+      }
+    });
+  }
+}
+
+// Singleton registration via macro defined in envoy/singleton/manager.h
+SINGLETON_MANAGER_REGISTRATION(thread_pool_private_key_provider_pools);
+
+PrivateKeyThreadPoolManagerSharedPtr
+PrivateKeyThreadPoolManager::get(Singleton::Manager& singleton_manager, Api::Api& api) {
+  return singleton_manager.getTyped<PrivateKeyThreadPoolManager>(
+      SINGLETON_MANAGER_REGISTERED_NAME(thread_pool_private_key_provider_pools), [&api] {
+        return std::make_shared<PrivateKeyThreadPoolManager>(api.threadFactory(),
+                                                             api.timeSource());
+      });
+}
+
+PrivateKeyThreadPoolSharedPtr PrivateKeyThreadPoolManager::getPool(uint32_t thread_count) {
+  absl::MutexLock lock(&mutex_);
+  std::weak_ptr<PrivateKeyThreadPool>& weak_pool = pools_[thread_count];
+  PrivateKeyThreadPoolSharedPtr pool = weak_pool.lock();
+  if (pool == nullptr) {
+    pool = std::make_shared<PrivateKeyThreadPool>(thread_factory_, time_source_, thread_count);
+    weak_pool = pool;
+  }
+  return pool;
+}
+
+ThreadPoolPrivateKeyConnection::~ThreadPoolPrivateKeyConnection() {
+  if (operation_ != nullptr) {
+    // The completion of the operation may still be posted.
+    operation_->connection_ = nullptr;
+  }
+}
+
+ssl_private_key_result_t ThreadPoolPrivateKeyConnection::start(PrivateKeyOperation::Type type,
+                                                               uint16_t signature_algorithm,
+                                                               const uint8_t* in, size_t in_len) {
+  if (operation_ != nullptr) {
+    ENVOY_LOG(debug, "thread pool private key provider: operation already in progress");
+    return ssl_private_key_failure;
+  }
+  operation_ = std::make_shared<PrivateKeyOperation>(
+      type, signature_algorithm, in, in_len, bssl::UpRef(provider_.privateKey()),
+      provider_.timeSource().monotonicTime(), *this);
+  completed_ = false;
+  provider_.threadPool().enqueue(operation_, poster_);
+  return ssl_private_key_retry;
+}
+
+ssl_private_key_result_t ThreadPoolPrivateKeyConnection::complete(uint8_t* out, size_t* out_len,
+                                                                  size_t max_out) {
+  if (operation_ == nullptr) {
+    return ssl_private_key_failure;
+  }
+  if (!completed_) {
+    // The handshake was resumed before the operation completed.
+    return ssl_private_key_retry;
+  }
+
+  const PrivateKeyOperationSharedPtr operation = std::move(operation_);
+  operation->connection_ = nullptr;
+  if (!operation->success_ || operation->output_.size() > max_out) {
+    ENVOY_LOG(debug, "thread pool private key provider: private key operation failed");
+    return ssl_private_key_failure;
+  }
+  *out_len = operation->output_.size();
+  memcpy(out, operation->output_.data(), *out_len); // NOLINT(safe-memcpy)
+  return ssl_private_key_success;
+}
+
+void ThreadPoolPrivateKeyConnection::onOperationComplete() {
+  ASSERT(operation_ != nullptr && !completed_);
+  completed_ = true;
+  ThreadPoolPrivateKeyStats& stats = provider_.stats();
+  stats.queue_time_us_.recordValue(std::chrono::duration_cast<std::chrono::microseconds>(
+                                       operation_->started_ - operation_->enqueued_)
+                                       .count());
+  stats.operation_time_us_.recordValue(std::chrono::duration_cast<std::chrono::microseconds>(
+                                           operation_->finished_ - operation_->started_)
+                                           .count());
+  if (!operation_->success_) {
+    stats.operation_failed_.inc();
+  }
+  cb_.onPrivateKeyMethodComplete();
+}
+
+ThreadPoolPrivateKeyMethodProvider::ThreadPoolPrivateKeyMethodProvider(
+    const envoy::extensions::private_key_providers::thread_pool::v3::
+        ThreadPoolPrivateKeyMethodConfig& config,
+    Server::Configuration::TransportSocketFactoryContext& factory_context)
+    : pkey_(readPrivateKey(config.private_key(), factory_context.serverFactoryContext().api())),
+      time_source_(factory_context.serverFactoryContext().api().timeSource()),
+      stats_{ALL_THREAD_POOL_PRIVATE_KEY_STATS(
+          POOL_COUNTER_PREFIX(factory_context.statsScope(), "thread_pool_private_key."),
+          POOL_HISTOGRAM_PREFIX(factory_context.statsScope(), "thread_pool_private_key."))},
+      method_(std::make_shared<SSL_PRIVATE_KEY_METHOD>()),
+      tls_(ThreadLocal::TypedSlot<ThreadLocalPoster>::makeUnique(
+          factory_context.serverFactoryContext().threadLocal())),
+      thread_pool_manager_(PrivateKeyThreadPoolManager::get(
+          factory_context.serverFactoryContext().singletonManager(),
+          factory_context.serverFactoryContext().api())),
+      thread_pool_(thread_pool_manager_->getPool(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, thread_count, std::max(1U, std::thread::hardware_concurrency())))) {
+  method_->sign = privateKeySign;
+  method_->decrypt = privateKeyDecrypt;
+  method_->complete = privateKeyComplete;
+
+  tls_->set([](Event::Dispatcher& dispatcher) {
+    return std::make_shared<ThreadLocalPoster>(dispatcher);
+  });
+  ENVOY_LOG(debug, "thread pool private key provider: running with {} threads",
+            thread_pool_->size());
+}
+
+void ThreadPoolPrivateKeyMethodProvider::registerPrivateKeyMethod(
+    SSL* ssl, Ssl::PrivateKeyConnectionCallbacks& cb, Event::Dispatcher&) {
+  if (SSL_get_ex_data(ssl, connectionIndex()) != nullptr) {
+    throw EnvoyException("Not registering the thread pool provider twice for same context");
+  }
+  ASSERT(tls_->currentThreadRegistered(), "Current thread needs to be registered.");
+  SSL_set_ex_data(ssl, connectionIndex(),
+                  new ThreadPoolPrivateKeyConnection(*this, cb, tls_->get()->poster_));
+}
+
+void ThreadPoolPrivateKeyMethodProvider::unregisterPrivateKeyMethod(SSL* ssl) {
+  auto* ops = static_cast<ThreadPoolPrivateKeyConnection*>(SSL_get_ex_data(ssl, connectionIndex()));
+  SSL_set_ex_data(ssl, connectionIndex(), nullptr);
+  delete ops;
+}
+
+bool ThreadPoolPrivateKeyMethodProvider::checkFips() {
+  // The operations are run with BoringSSL, so the key only needs to pass the same checks as the
+  // keys of the TLS contexts.
+  switch (EVP_PKEY_id(pkey_.get())) {
+  case EVP_PKEY_EC:
+    return EC_KEY_check_fips(EVP_PKEY_get0_EC_KEY(pkey_.get()));
+  case EVP_PKEY_RSA:
+    return RSA_check_fips(EVP_PKEY_get0_RSA(pkey_.get()));
+  default:
+    return false;
+  }
+}
+
+namespace {
+int createIndex() {
+  int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  RELEASE_ASSERT(index >= 0, "Failed to get SSL user data index.");
+  return index;
+}
+} // namespace
+
+int ThreadPoolPrivateKeyMethodProvider::connectionIndex() {
+  CONSTRUCT_ON_FIRST_USE(int, createIndex());
+}
+
+} // namespace ThreadPool
+} // namespace PrivateKeyMethodProvider
+} // namespace Extensions
+} // namespace Envoy
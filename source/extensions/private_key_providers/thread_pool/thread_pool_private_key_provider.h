@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "envoy/api/api.h"
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/extensions/private_key_providers/thread_pool/v3/thread_pool.pb.h"
+#include "envoy/server/transport_socket_config.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/singleton/manager.h"
+#include "envoy/ssl/private_key/private_key.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread/thread.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/common/thread.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace PrivateKeyMethodProvider {
+namespace ThreadPool {
+
+/**
+ * All thread pool private key provider stats. @see stats_macros.h
+ */
+#define ALL_THREAD_POOL_PRIVATE_KEY_STATS(COUNTER, HISTOGRAM)                                      \
+  COUNTER(operation_failed)                                                                        \
+  HISTOGRAM(operation_time_us, Microseconds)                                                       \
+  HISTOGRAM(queue_time_us, Microseconds)
+
+/**
+ * Struct definition for all thread pool private key provider stats. @see stats_macros.h
+ */
+struct ThreadPoolPrivateKeyStats {
+  ALL_THREAD_POOL_PRIVATE_KEY_STATS(GENERATE_COUNTER_STRUCT, GENERATE_HISTOGRAM_STRUCT)
+};
+
+class ThreadPoolPrivateKeyConnection;
+
+/**
+ * A sign or decrypt operation of a connection. It is created on the thread of the connection, run
+ * by a thread of the pool and its result is consumed back on the thread of the connection.
+ */
+struct PrivateKeyOperation {
+  enum class Type { Sign, Decrypt };
+
+  PrivateKeyOperation(Type type, uint16_t signature_algorithm, const uint8_t* in, size_t in_len,
+                      bssl::UniquePtr<EVP_PKEY> pkey, MonotonicTime enqueued,
+                      ThreadPoolPrivateKeyConnection& connection)
+      : type_(type), signature_algorithm_(signature_algorithm), input_(in, in + in_len),
+        pkey_(std::move(pkey)), enqueued_(enqueued), connection_(&connection) {}
+
+  /**
+   * Runs the operation. Called on a thread of the pool.
+   */
+  void run();
+
+  const Type type_;
+  const uint16_t signature_algorithm_;
+  const std::vector<uint8_t> input_;
+  const bssl::UniquePtr<EVP_PKEY> pkey_;
+  const MonotonicTime enqueued_;
+
+  // Set by the thread of the pool before the completion is posted to the thread of the
+  // connection.
+  MonotonicTime started_;
+  MonotonicTime finished_;
+  bool success_{};
+  std::vector<uint8_t> output_;
+
+  // Only accessed on the thread of the connection. Reset if the connection goes away before the
+  // operation completes.
+  ThreadPoolPrivateKeyConnection* connection_;
+};
+
+using PrivateKeyOperationSharedPtr = std::shared_ptr<PrivateKeyOperation>;
+
+/**
+ * Posts the completions of the operations from the threads of the pool to the dispatcher of a
+ * worker thread, for as long as the dispatcher exists.
+ */
+class CompletionPoster {
+public:
+  explicit CompletionPoster(Event::Dispatcher& dispatcher) : dispatcher_(&dispatcher) {}
+
+  /**
+   * Posts the callback to the dispatcher, unless the worker thread has shut down.
+   */
+  void post(Event::PostCb callback);
+
+  /**
+   * Stops posting to the dispatcher. Called on the worker thread before its dispatcher goes away.
+   */
+  void shutdown();
+
+private:
+  absl::Mutex mutex_;
+  Event::Dispatcher* dispatcher_ ABSL_GUARDED_BY(mutex_);
+};
+
+using CompletionPosterSharedPtr = std::shared_ptr<CompletionPoster>;
+
+/**
+ * The threads running the private key operations of the providers with the same number of threads.
+ * Operations are run in the order they are queued in, by whichever thread is free first.
+ */
+class PrivateKeyThreadPool : protected Logger::Loggable<Logger::Id::connection> {
+public:
+  PrivateKeyThreadPool(Thread::ThreadFactory& thread_factory, TimeSource& time_source,
+                       uint32_t thread_count);
+  ~PrivateKeyThreadPool();
+
+  /**
+   * Queues an operation. Once it has run, poster is used to call back the connection of the
+   * operation on its thread. Operations which are still queued when the pool is destroyed are
+   * dropped.
+   */
+  void enqueue(PrivateKeyOperationSharedPtr operation, CompletionPosterSharedPtr poster);
+
+  /**
+   * @return the number of threads in the pool.
+   */
+  size_t size() const { return threads_.size(); }
+
+private:
+  struct Job {
+    PrivateKeyOperationSharedPtr operation_;
+    CompletionPosterSharedPtr poster_;
+  };
+
+  void threadRoutine();
+
+  TimeSource& time_source_;
+  absl::Mutex mutex_;
+  std::queue<Job> jobs_ ABSL_GUARDED_BY(mutex_);
+  bool terminate_ ABSL_GUARDED_BY(mutex_){};
+  std::vector<Thread::ThreadPtr> threads_;
+};
+
+using PrivateKeyThreadPoolSharedPtr = std::shared_ptr<PrivateKeyThreadPool>;
+
+class PrivateKeyThreadPoolManager;
+using PrivateKeyThreadPoolManagerSharedPtr = std::shared_ptr<PrivateKeyThreadPoolManager>;
+
+/**
+ * Hands out the thread pools of the providers, so that the providers of all certificates, and
+ * the providers created again when a certificate is updated, share one pool per number of
+ * threads. A pool is destroyed along with the last provider using it.
+ */
+class PrivateKeyThreadPoolManager : public Singleton::Instance {
+public:
+  PrivateKeyThreadPoolManager(Thread::ThreadFactory& thread_factory, TimeSource& time_source)
+      : thread_factory_(thread_factory), time_source_(time_source) {}
+
+  /**
+   * @return the manager of the server.
+   */
+  static PrivateKeyThreadPoolManagerSharedPtr get(Singleton::Manager& singleton_manager,
+                                                  Api::Api& api);
+
+  /**
+   * @return the pool with the given number of threads, starting it if no provider uses it yet.
+   */
+  PrivateKeyThreadPoolSharedPtr getPool(uint32_t thread_count);
+
+private:
+  Thread::ThreadFactory& thread_factory_;
+  TimeSource& time_source_;
+  absl::Mutex mutex_;
+  absl::flat_hash_map<uint32_t, std::weak_ptr<PrivateKeyThreadPool>>
+      pools_ ABSL_GUARDED_BY(mutex_);
+};
+
+class ThreadPoolPrivateKeyMethodProvider;
+
+/**
+ * The private key operations state of an SSL connection. Only used on the thread of the connection.
+ */
+class ThreadPoolPrivateKeyConnection : protected Logger::Loggable<Logger::Id::connection> {
+public:
+  ThreadPoolPrivateKeyConnection(ThreadPoolPrivateKeyMethodProvider& provider,
+                                 Ssl::PrivateKeyConnectionCallbacks& cb,
+                                 CompletionPosterSharedPtr poster)
+      : provider_(provider), cb_(cb), poster_(std::move(poster)) {}
+  ~ThreadPoolPrivateKeyConnection();
+
+  /**
+   * Starts a private key operation on the thread pool.
+   * @return ssl_private_key_retry, or ssl_private_key_failure if the operation can't be started.
+   */
+  ssl_private_key_result_t start(PrivateKeyOperation::Type type, uint16_t signature_algorithm,
+                                 const uint8_t* in, size_t in_len);
+
+  /**
+   * Copies the result of the operation once it has completed.
+   * @return ssl_private_key_retry if the operation is still running.
+   */
+  ssl_private_key_result_t complete(uint8_t* out, size_t* out_len, size_t max_out);
+
+  /**
+   * Called on the thread of the connection once the operation has run.
+   */
+  void onOperationComplete();
+
+private:
+  ThreadPoolPrivateKeyMethodProvider& provider_;
+  Ssl::PrivateKeyConnectionCallbacks& cb_;
+  const CompletionPosterSharedPtr poster_;
+  PrivateKeyOperationSharedPtr operation_;
+  bool completed_{};
+};
+
+/**
+ * A private key method provider which runs the private key operations of the handshakes with
+ * BoringSSL on a dedicated pool of threads, so that they don't block the worker threads.
+ */
+class ThreadPoolPrivateKeyMethodProvider : public virtual Ssl::PrivateKeyMethodProvider,
+                                           protected Logger::Loggable<Logger::Id::connection> {
+public:
+  ThreadPoolPrivateKeyMethodProvider(
+      const envoy::extensions::private_key_providers::thread_pool::v3::
+          ThreadPoolPrivateKeyMethodConfig& config,
+      Server::Configuration::TransportSocketFactoryContext& factory_context);
+
+  // Ssl::PrivateKeyMethodProvider
+  void registerPrivateKeyMethod(SSL* ssl, Ssl::PrivateKeyConnectionCallbacks& cb,
+                                Event::Dispatcher& dispatcher) override;
+  void unregisterPrivateKeyMethod(SSL* ssl) override;
+  bool checkFips() override;
+  bool isAvailable() override { return true; }
+  Ssl::BoringSslPrivateKeyMethodSharedPtr getBoringSslPrivateKeyMethod() override {
+    return method_;
+  }
+
+  static int connectionIndex();
+
+  EVP_PKEY* privateKey() const { return pkey_.get(); }
+  TimeSource& timeSource() { return time_source_; }
+  PrivateKeyThreadPool& threadPool() { return *thread_pool_; }
+  ThreadPoolPrivateKeyStats& stats() { return stats_; }
+
+private:
+  // Posts the completions to a worker thread.
+  struct ThreadLocalPoster : public ThreadLocal::ThreadLocalObject {
+    explicit ThreadLocalPoster(Event::Dispatcher& dispatcher)
+        : poster_(std::make_shared<CompletionPoster>(dispatcher)) {}
+    ~ThreadLocalPoster() override { poster_->shutdown(); }
+
+    const CompletionPosterSharedPtr poster_;
+  };
+
+  const bssl::UniquePtr<EVP_PKEY> pkey_;
+  TimeSource& time_source_;
+  ThreadPoolPrivateKeyStats stats_;
+  Ssl::BoringSslPrivateKeyMethodSharedPtr method_;
+  ThreadLocal::TypedSlotPtr<ThreadLocalPoster> tls_;
+  // Kept so that the providers created later get the pools of the existing ones.
+  const PrivateKeyThreadPoolManagerSharedPtr thread_pool_manager_;
+  const PrivateKeyThreadPoolSharedPtr thread_pool_;
+};
+
+} // namespace ThreadPool
+} // namespace PrivateKeyMethodProvider
+} // namespace Extensions
+} // namespace Envoy
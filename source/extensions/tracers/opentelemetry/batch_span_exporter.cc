@@ -0,0 +1,197 @@
+#include "source/extensions/tracers/opentelemetry/batch_span_exporter.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/protobuf/protobuf.h"
+#include "source/common/protobuf/utility.h"
+
+#include "opentelemetry/proto/collector/trace/v1/trace_service.pb.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Tracers {
+namespace OpenTelemetry {
+
+namespace {
+// Defaults match the OpenTelemetry SDK batch span processor.
+constexpr uint32_t DefaultMaxQueueSize = 2048;
+constexpr uint32_t DefaultMaxExportBatchSize = 512;
+constexpr uint64_t DefaultMaxExportDelayMs = 5000;
+} // namespace
+
+BatchSpanExporter::BatchSpanExporter(
+    const envoy::config::trace::v3::OpenTelemetryConfig::BatchExportConfig& config,
+    OpenTelemetryTraceExporterSharedPtr exporter, Event::Dispatcher& main_dispatcher,
+    Thread::ThreadFactory& thread_factory, OpenTelemetryTracerStats tracing_stats,
+    ResourceConstSharedPtr resource)
+    : max_export_batch_size_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_export_batch_size,
+                                                             DefaultMaxExportBatchSize)),
+      max_export_delay_(
+          PROTOBUF_GET_MS_OR_DEFAULT(config, max_export_delay, DefaultMaxExportDelayMs)),
+      drop_policy_(config.drop_policy()),
+      queue_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_queue_size, DefaultMaxQueueSize)),
+      exporter_(std::move(exporter)), main_dispatcher_(main_dispatcher),
+      tracing_stats_(tracing_stats), resource_(std::move(resource)) {
+  thread_ = thread_factory.createThread([this]() { threadRoutine(); },
+                                        Thread::Options{"OtelSpanExport"});
+}
+
+BatchSpanExporter::~BatchSpanExporter() {
+  shutdown();
+
+  // Spans of requests that finished while shutting down.
+  SpanProtoPtr span;
+  while (queue_.pop(span)) {
+    tracing_stats_.spans_dropped_.inc();
+  }
+}
+
+void BatchSpanExporter::shutdown() {
+  if (stopped_.exchange(true)) {
+    return;
+  }
+  {
+    Thread::LockGuard guard(lock_);
+    shutdown_ = true;
+    wakeup_.notifyOne();
+  }
+  thread_->join();
+
+  // Send what is still queued once, directly, as the exporter is released below.
+  std::vector<SpanProtoPtr> batch;
+  SpanProtoPtr span;
+  while (queue_.pop(span)) {
+    batch.push_back(std::move(span));
+    if (batch.size() == max_export_batch_size_) {
+      sendBatch(*exporter_, serializeBatch(batch), max_export_batch_size_);
+    }
+  }
+  if (!batch.empty()) {
+    const uint64_t num_spans = batch.size();
+    sendBatch(*exporter_, serializeBatch(batch), num_spans);
+  }
+  exporter_.reset();
+}
+
+void BatchSpanExporter::enqueue(SpanProtoPtr&& span) {
+  if (stopped_.load(std::memory_order_relaxed)) {
+    tracing_stats_.spans_dropped_.inc();
+    return;
+  }
+  if (queue_.push(span)) {
+    wakeIfBatchReady();
+    return;
+  }
+
+  if (drop_policy_ == envoy::config::trace::v3::OpenTelemetryConfig::BatchExportConfig::
+                          DROP_OLDEST) {
+    // Make room by dropping the oldest span. Another producer may take the freed slot first, in
+    // which case the new span is dropped as well.
+    SpanProtoPtr oldest;
+    if (queue_.pop(oldest)) {
+      tracing_stats_.spans_dropped_.inc();
+    }
+    if (queue_.push(span)) {
+      wakeIfBatchReady();
+      return;
+    }
+  }
+  tracing_stats_.spans_dropped_.inc();
+}
+
+void BatchSpanExporter::wakeIfBatchReady() {
+  if (queue_.size() < max_export_batch_size_ || batch_ready_.exchange(true)) {
+    return;
+  }
+  Thread::LockGuard guard(lock_);
+  wakeup_.notifyOne();
+}
+
+void BatchSpanExporter::threadRoutine() {
+  std::vector<SpanProtoPtr> batch;
+  batch.reserve(max_export_batch_size_);
+  while (true) {
+    {
+      Thread::LockGuard guard(lock_);
+      if (!shutdown_ && queue_.size() < max_export_batch_size_) {
+        wakeup_.waitFor(lock_, max_export_delay_);
+      }
+      if (shutdown_) {
+        return;
+      }
+    }
+
+    batch_ready_.store(false);
+    // Only export what is queued now, so that a steady stream of new spans can not keep this
+    // thread from checking for shutdown.
+    for (size_t remaining = queue_.size(); remaining > 0; remaining--) {
+      SpanProtoPtr span;
+      if (!queue_.pop(span)) {
+        break;
+      }
+      batch.push_back(std::move(span));
+      if (batch.size() == max_export_batch_size_) {
+        exportBatch(batch);
+      }
+    }
+    if (!batch.empty()) {
+      exportBatch(batch);
+    }
+  }
+}
+
+void BatchSpanExporter::exportBatch(std::vector<SpanProtoPtr>& batch) {
+  const uint64_t num_spans = batch.size();
+  Buffer::InstancePtr request = serializeBatch(batch);
+  std::weak_ptr<OpenTelemetryTraceExporter> weak_exporter = exporter_;
+  main_dispatcher_.post([this, weak_exporter, num_spans, request = std::move(request)]() mutable {
+    OpenTelemetryTraceExporterSharedPtr exporter = weak_exporter.lock();
+    if (exporter == nullptr) {
+      return;
+    }
+    sendBatch(*exporter, std::move(request), num_spans);
+  });
+}
+
+Buffer::InstancePtr BatchSpanExporter::serializeBatch(std::vector<SpanProtoPtr>& batch) {
+  // The request is built on an arena, so that it costs no heap allocations of its own. The spans
+  // are referenced by the request rather than copied into the arena, and stay owned by the batch:
+  // the arena never deletes the elements of its repeated fields.
+  Protobuf::Arena arena;
+  auto* request = Protobuf::Arena::CreateMessage<ExportTraceServiceRequest>(&arena);
+  ::opentelemetry::proto::trace::v1::ResourceSpans* resource_span = request->add_resource_spans();
+  resource_span->set_schema_url(resource_->schemaUrl_);
+  for (const auto& att : resource_->attributes_) {
+    auto* key_value = resource_span->mutable_resource()->add_attributes();
+    key_value->set_key(att.first);
+    key_value->mutable_value()->set_string_value(att.second);
+  }
+  auto* spans = resource_span->add_scope_spans()->mutable_spans();
+  spans->Reserve(batch.size());
+  for (SpanProtoPtr& span : batch) {
+    spans->UnsafeArenaAddAllocated(span.get());
+  }
+
+  auto serialized = std::make_unique<Buffer::OwnedImpl>();
+  const size_t size = request->ByteSizeLong();
+  auto reservation = serialized->reserveSingleSlice(size);
+  request->SerializeWithCachedSizesToArray(static_cast<uint8_t*>(reservation.slice().mem_));
+  reservation.commit(size);
+  batch.clear();
+  return serialized;
+}
+
+void BatchSpanExporter::sendBatch(OpenTelemetryTraceExporter& exporter,
+                                  Buffer::InstancePtr&& request, uint64_t num_spans) {
+  if (!exporter.logSerialized(std::move(request))) {
+    ENVOY_LOG(trace, "Unsuccessful log request to OpenTelemetry trace collector.");
+    tracing_stats_.export_batches_failed_.inc();
+    return;
+  }
+  tracing_stats_.spans_sent_.add(num_spans);
+  tracing_stats_.export_batches_.inc();
+}
+
+} // namespace OpenTelemetry
+} // namespace Tracers
+} // namespace Extensions
+} // namespace Envoy
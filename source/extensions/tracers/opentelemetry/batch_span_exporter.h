@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "envoy/config/trace/v3/opentelemetry.pb.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/thread/thread.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/common/thread.h"
+#include "source/extensions/tracers/opentelemetry/bounded_queue.h"
+#include "source/extensions/tracers/opentelemetry/resource_detectors/resource_detector.h"
+#include "source/extensions/tracers/opentelemetry/trace_exporter.h"
+#include "source/extensions/tracers/opentelemetry/tracer.h"
+
+#include "opentelemetry/proto/trace/v1/trace.pb.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Tracers {
+namespace OpenTelemetry {
+
+using SpanProtoPtr = std::unique_ptr<::opentelemetry::proto::trace::v1::Span>;
+
+/**
+ * Exports finished spans in batches without doing the work on the worker threads. Workers push
+ * finished spans into a bounded lock-free queue. A dedicated thread drains the queue whenever a
+ * full batch is waiting or the maximum export delay has passed, moves the spans into an export
+ * request and serializes it. The serialized requests are handed to the exporter on the main
+ * thread, which owns the connection to the collector. Spans still queued when the exporter is
+ * shut down are sent once by shutdown(), on the main thread.
+ *
+ * Workers hold shared ownership, as spans of requests still in flight may finish after the driver
+ * is gone. The driver shuts the exporter down first, so the last reference can go away on any
+ * thread.
+ */
+class BatchSpanExporter : Logger::Loggable<Logger::Id::tracing> {
+public:
+  using DropPolicy = envoy::config::trace::v3::OpenTelemetryConfig::BatchExportConfig::DropPolicy;
+
+  BatchSpanExporter(
+      const envoy::config::trace::v3::OpenTelemetryConfig::BatchExportConfig& config,
+      OpenTelemetryTraceExporterSharedPtr exporter, Event::Dispatcher& main_dispatcher,
+      Thread::ThreadFactory& thread_factory, OpenTelemetryTracerStats tracing_stats,
+      ResourceConstSharedPtr resource);
+  ~BatchSpanExporter();
+
+  /**
+   * Queue a finished span for export. Safe to call from any thread.
+   * @param span supplies the span. It is dropped if the queue is full and the drop policy does
+   *        not make room for it, or if the exporter has been shut down.
+   */
+  void enqueue(SpanProtoPtr&& span);
+
+  /**
+   * Stop the export thread, send the spans still queued and release the exporter. Must be called
+   * on the main thread. Called by the destructor if it has not been called before.
+   */
+  void shutdown();
+
+private:
+  void threadRoutine();
+  void wakeIfBatchReady();
+  // Serializes the batch on the export thread and posts it to the main thread to be sent.
+  void exportBatch(std::vector<SpanProtoPtr>& batch);
+  // Moves the spans of the batch into an export request and serializes it. Empties the batch.
+  Buffer::InstancePtr serializeBatch(std::vector<SpanProtoPtr>& batch);
+  // Only called on the main thread.
+  void sendBatch(OpenTelemetryTraceExporter& exporter, Buffer::InstancePtr&& request,
+                 uint64_t num_spans);
+
+  const uint32_t max_export_batch_size_;
+  const std::chrono::milliseconds max_export_delay_;
+  const DropPolicy drop_policy_;
+  BoundedQueue<SpanProtoPtr> queue_;
+  // Only used on the main thread. Sends posted by the export thread hold a weak reference, so
+  // they are skipped once this is shut down.
+  OpenTelemetryTraceExporterSharedPtr exporter_;
+  Event::Dispatcher& main_dispatcher_;
+  OpenTelemetryTracerStats tracing_stats_;
+  const ResourceConstSharedPtr resource_;
+
+  // Set by the first producer to see a full batch, so that only it takes the lock to wake the
+  // export thread. Cleared by the export thread before it drains the queue.
+  std::atomic<bool> batch_ready_{false};
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar wakeup_;
+  bool shutdown_ ABSL_GUARDED_BY(lock_){false};
+  // Set by shutdown(), after which spans are no longer queued.
+  std::atomic<bool> stopped_{false};
+  Thread::ThreadPtr thread_;
+};
+
+using BatchSpanExporterSharedPtr = std::shared_ptr<BatchSpanExporter>;
+
+} // namespace OpenTelemetry
+} // namespace Tracers
+} // namespace Extensions
+} // namespace Envoy
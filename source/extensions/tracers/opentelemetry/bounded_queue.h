@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/numeric/bits.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Tracers {
+namespace OpenTelemetry {
+
+/**
+ * A bounded multi-producer multi-consumer queue that does not take locks. Every slot carries a
+ * sequence number which tells producers and consumers whether it is free to be written or ready
+ * to be read for the current lap around the ring, so that claiming a slot is a single
+ * compare-and-swap on the shared position. See
+ * https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue.
+ */
+template <class T> class BoundedQueue {
+public:
+  /**
+   * @param capacity the maximum number of elements. Rounded up to the next power of two.
+   */
+  explicit BoundedQueue(size_t capacity)
+      : mask_(absl::bit_ceil(std::max<size_t>(capacity, 2)) - 1), slots_(new Slot[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; i++) {
+      slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Add an element to the back of the queue.
+   * @param value supplies the element. It is only moved from if it was added.
+   * @return true if the element was added, false if the queue was full.
+   */
+  bool push(T& value) {
+    size_t pos = push_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      slot = &slots_[pos & mask_];
+      const size_t sequence = slot->sequence_.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (push_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // The slot still holds the element from the previous lap.
+        return false;
+      } else {
+        pos = push_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->value_ = std::move(value);
+    slot->sequence_.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Remove the element at the front of the queue.
+   * @param value supplies where to move the element to.
+   * @return true if an element was removed, false if the queue was empty.
+   */
+  bool pop(T& value) {
+    size_t pos = pop_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      slot = &slots_[pos & mask_];
+      const size_t sequence = slot->sequence_.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (pop_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // The slot has not been written for this lap yet.
+        return false;
+      } else {
+        pos = pop_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(slot->value_);
+    slot->value_ = T();
+    slot->sequence_.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @return size_t the number of elements in the queue. This is only a snapshot when called
+   *         concurrently with push() or pop().
+   */
+  size_t size() const {
+    const size_t pop_pos = pop_pos_.load(std::memory_order_acquire);
+    const size_t push_pos = push_pos_.load(std::memory_order_acquire);
+    return push_pos > pop_pos ? push_pos - pop_pos : 0;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+private:
+  static constexpr size_t CacheLineSize = 64;
+
+  struct Slot {
+    std::atomic<size_t> sequence_;
+    T value_;
+  };
+
+  const size_t mask_;
+  const std::unique_ptr<Slot[]> slots_;
+  // Kept on separate cache lines so that producers and consumers do not false share.
+  alignas(CacheLineSize) std::atomic<size_t> push_pos_{0};
+  alignas(CacheLineSize) std::atomic<size_t> pop_pos_{0};
+};
+
+} // namespace OpenTelemetry
+} // namespace Tracers
+} // namespace Extensions
+} // namespace Envoy
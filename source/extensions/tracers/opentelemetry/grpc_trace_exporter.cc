@@ -16,6 +16,10 @@ bool OpenTelemetryGrpcTraceExporter::log(const ExportTraceServiceRequest& reques
   return client_.log(request);
 }
 
+bool OpenTelemetryGrpcTraceExporter::logSerialized(Buffer::InstancePtr&& request) {
+  return client_.logRaw(std::move(request));
+}
+
 } // namespace OpenTelemetry
 } // namespace Tracers
 } // namespace Extensions
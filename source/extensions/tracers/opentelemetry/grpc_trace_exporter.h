@@ -51,6 +51,38 @@ public:
   };
 
   bool log(const ExportTraceServiceRequest& request) {
+    Grpc::AsyncStream<ExportTraceServiceRequest>* stream = activeStream();
+    if (stream == nullptr) {
+      return true;
+    }
+    if (stream->isAboveWriteBufferHighWatermark()) {
+      return false;
+    }
+    stream->sendMessage(request, false);
+    return true;
+  }
+
+  /**
+   * Send a request that was already serialized to its binary protobuf encoding. The stream adds
+   * the gRPC frame header, as it does for a message it serializes itself.
+   */
+  bool logRaw(Buffer::InstancePtr&& request) {
+    Grpc::AsyncStream<ExportTraceServiceRequest>* stream = activeStream();
+    if (stream == nullptr) {
+      return true;
+    }
+    if (stream->isAboveWriteBufferHighWatermark()) {
+      return false;
+    }
+    stream->sendMessageRaw(std::move(request), false);
+    return true;
+  }
+
+  /**
+   * @return the stream to send requests on, starting it if needed, or nullptr if it could not be
+   *         started.
+   */
+  Grpc::AsyncStream<ExportTraceServiceRequest>* activeStream() {
     // If we don't have a stream already, we need to initialize it.
     if (!stream_) {
       stream_ = std::make_unique<LocalStream>(*this);
@@ -62,18 +94,13 @@ public:
           client_->start(service_method_, *stream_, Http::AsyncClient::StreamOptions());
     }
 
-    // If we do have a Grpc AsyncStream, we can first check if we are above the write buffer, and
-    // send message if it's ok; if we don't have a stream, we need to clear out the stream data
-    // after stream creation failed.
-    if (stream_->stream_ != nullptr) {
-      if (stream_->stream_->isAboveWriteBufferHighWatermark()) {
-        return false;
-      }
-      stream_->stream_->sendMessage(request, false);
-    } else {
+    // If we don't have a stream, we need to clear out the stream data after stream creation
+    // failed.
+    if (stream_->stream_ == nullptr) {
       stream_.reset();
+      return nullptr;
     }
-    return true;
+    return &stream_->stream_;
   }
 
   Grpc::AsyncClient<ExportTraceServiceRequest, ExportTraceServiceResponse> client_;
@@ -86,6 +113,7 @@ public:
   OpenTelemetryGrpcTraceExporter(const Grpc::RawAsyncClientSharedPtr& client);
 
   bool log(const ExportTraceServiceRequest& request) override;
+  bool logSerialized(Buffer::InstancePtr&& request) override;
 
 private:
   OpenTelemetryGrpcTraceExporterClient client_;
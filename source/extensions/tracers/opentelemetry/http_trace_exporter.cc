@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "source/common/buffer/buffer_impl.h"
 #include "source/common/common/enum_to_int.h"
 #include "source/common/common/logger.h"
 #include "source/common/protobuf/protobuf.h"
@@ -35,6 +36,10 @@ bool OpenTelemetryHttpTraceExporter::log(const ExportTraceServiceRequest& reques
     return false;
   }
 
+  return logSerialized(std::make_unique<Buffer::OwnedImpl>(request_body));
+}
+
+bool OpenTelemetryHttpTraceExporter::logSerialized(Buffer::InstancePtr&& request) {
   const auto thread_local_cluster =
       cluster_manager_.getThreadLocalCluster(http_service_.http_uri().cluster());
   if (thread_local_cluster == nullptr) {
@@ -54,7 +59,7 @@ bool OpenTelemetryHttpTraceExporter::log(const ExportTraceServiceRequest& reques
   for (const auto& header_pair : parsed_headers_to_add_) {
     message->headers().setReference(header_pair.first, header_pair.second);
   }
-  message->body().add(request_body);
+  message->body().move(*request);
 
   const auto options = Http::AsyncClient::RequestOptions().setTimeout(std::chrono::milliseconds(
       DurationUtil::durationToMilliseconds(http_service_.http_uri().timeout())));
@@ -28,6 +28,7 @@ public:
                                  const envoy::config::core::v3::HttpService& http_service);
 
   bool log(const ExportTraceServiceRequest& request) override;
+  bool logSerialized(Buffer::InstancePtr&& request) override;
 
   // Http::AsyncClient::Callbacks.
   void onSuccess(const Http::AsyncClient::Request&, Http::ResponseMessagePtr&&) override;
@@ -7,7 +7,9 @@
 #include "source/common/common/empty_string.h"
 #include "source/common/common/logger.h"
 #include "source/common/config/utility.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/common/tracing/http_tracer_impl.h"
+#include "source/extensions/tracers/opentelemetry/batch_span_exporter.h"
 #include "source/extensions/tracers/opentelemetry/grpc_trace_exporter.h"
 #include "source/extensions/tracers/opentelemetry/http_trace_exporter.h"
 #include "source/extensions/tracers/opentelemetry/resource_detectors/resource_detector.h"
@@ -43,6 +45,24 @@ tryCreateSamper(const envoy::config::trace::v3::OpenTelemetryConfig& opentelemet
   return sampler;
 }
 
+OpenTelemetryTraceExporterPtr
+createExporter(const envoy::config::trace::v3::OpenTelemetryConfig& opentelemetry_config,
+               Server::Configuration::ServerFactoryContext& factory_context) {
+  OpenTelemetryTraceExporterPtr exporter;
+  if (opentelemetry_config.has_grpc_service()) {
+    Grpc::AsyncClientFactoryPtr&& factory =
+        factory_context.clusterManager().grpcAsyncClientManager().factoryForGrpcService(
+            opentelemetry_config.grpc_service(), factory_context.scope(), true);
+    const Grpc::RawAsyncClientSharedPtr& async_client_shared_ptr =
+        factory->createUncachedRawAsyncClient();
+    exporter = std::make_unique<OpenTelemetryGrpcTraceExporter>(async_client_shared_ptr);
+  } else if (opentelemetry_config.has_http_service()) {
+    exporter = std::make_unique<OpenTelemetryHttpTraceExporter>(
+        factory_context.clusterManager(), opentelemetry_config.http_service());
+  }
+  return exporter;
+}
+
 } // namespace
 
 Driver::Driver(const envoy::config::trace::v3::OpenTelemetryConfig& opentelemetry_config,
@@ -69,28 +89,37 @@ Driver::Driver(const envoy::config::trace::v3::OpenTelemetryConfig& opentelemetr
   // Create the sampler if configured
   SamplerSharedPtr sampler = tryCreateSamper(opentelemetry_config, context);
 
+  // With batch export, a single exporter on the main thread sends the spans of all workers.
+  if (opentelemetry_config.has_batch_export()) {
+    batch_exporter_ = std::make_shared<BatchSpanExporter>(
+        opentelemetry_config.batch_export(), createExporter(opentelemetry_config, factory_context),
+        factory_context.mainThreadDispatcher(), factory_context.api().threadFactory(),
+        tracing_stats_, resource_ptr);
+  }
+
   // Create the tracer in Thread Local Storage.
-  tls_slot_ptr_->set([opentelemetry_config, &factory_context, this, resource_ptr,
-                      sampler](Event::Dispatcher& dispatcher) {
+  tls_slot_ptr_->set([opentelemetry_config, &factory_context, this, resource_ptr, sampler,
+                      batch_exporter = batch_exporter_](Event::Dispatcher& dispatcher) {
     OpenTelemetryTraceExporterPtr exporter;
-    if (opentelemetry_config.has_grpc_service()) {
-      Grpc::AsyncClientFactoryPtr&& factory =
-          factory_context.clusterManager().grpcAsyncClientManager().factoryForGrpcService(
-              opentelemetry_config.grpc_service(), factory_context.scope(), true);
-      const Grpc::RawAsyncClientSharedPtr& async_client_shared_ptr =
-          factory->createUncachedRawAsyncClient();
-      exporter = std::make_unique<OpenTelemetryGrpcTraceExporter>(async_client_shared_ptr);
-    } else if (opentelemetry_config.has_http_service()) {
-      exporter = std::make_unique<OpenTelemetryHttpTraceExporter>(
-          factory_context.clusterManager(), opentelemetry_config.http_service());
+    if (batch_exporter == nullptr) {
+      exporter = createExporter(opentelemetry_config, factory_context);
     }
     TracerPtr tracer = std::make_unique<Tracer>(
         std::move(exporter), factory_context.timeSource(), factory_context.api().randomGenerator(),
-        factory_context.runtime(), dispatcher, tracing_stats_, resource_ptr, sampler);
+        factory_context.runtime(), dispatcher, tracing_stats_, resource_ptr, sampler,
+        batch_exporter);
     return std::make_shared<TlsTracer>(std::move(tracer));
   });
 }
 
+Driver::~Driver() {
+  if (batch_exporter_ != nullptr) {
+    // The exporter talks to the collector from the main thread, so stop it here rather than
+    // wherever the last worker tracer releases it.
+    batch_exporter_->shutdown();
+  }
+}
+
 Tracing::SpanPtr Driver::startSpan(const Tracing::Config& config,
                                    Tracing::TraceContext& trace_context,
                                    const StreamInfo::StreamInfo& stream_info,
@@ -106,14 +135,23 @@ Tracing::SpanPtr Driver::startSpan(const Tracing::Config& config,
     return new_open_telemetry_span;
   } else {
     // Try to extract the span context. If we can't, just return a null span.
-    absl::StatusOr<SpanContext> span_context = extractor.extractSpanContext();
-    if (span_context.ok()) {
-      return tracer.startSpan(config, operation_name, stream_info.startTime(),
-                              span_context.value());
-    } else {
-      ENVOY_LOG(trace, "Unable to extract span context: ", span_context.status());
+    absl::StatusOr<TraceparentView> traceparent = extractor.extractTraceparent();
+    if (!traceparent.ok()) {
+      ENVOY_LOG(trace, "Unable to extract span context: ", traceparent.status());
       return std::make_unique<Tracing::NullSpan>();
     }
+    // An unsampled request is never exported unless a sampler overrides the decision, so skip
+    // building a span and just forward the inbound context.
+    if (!traceparent->sampled && !tracer.samplerConfigured() &&
+        Runtime::runtimeFeatureEnabled(
+            "envoy.reloadable_features.otel_forward_unsampled_context")) {
+      return std::make_unique<NonRecordingSpan>(traceparent.value(),
+                                                extractor.extractTracestate());
+    }
+    const SpanContext span_context(traceparent->version, traceparent->trace_id,
+                                   traceparent->parent_id, traceparent->sampled,
+                                   extractor.extractTracestate());
+    return tracer.startSpan(config, operation_name, stream_info.startTime(), span_context);
   }
 }
 
@@ -8,6 +8,7 @@
 #include "source/common/common/logger.h"
 #include "source/common/singleton/const_singleton.h"
 #include "source/extensions/tracers/common/factory_base.h"
+#include "source/extensions/tracers/opentelemetry/batch_span_exporter.h"
 #include "source/extensions/tracers/opentelemetry/grpc_trace_exporter.h"
 #include "source/extensions/tracers/opentelemetry/resource_detectors/resource_provider.h"
 #include "source/extensions/tracers/opentelemetry/tracer.h"
@@ -37,6 +38,8 @@ public:
          Server::Configuration::TracerFactoryContext& context,
          const ResourceProvider& resource_provider);
 
+  ~Driver() override;
+
   // Tracing::Driver
   Tracing::SpanPtr startSpan(const Tracing::Config& config, Tracing::TraceContext& trace_context,
                              const StreamInfo::StreamInfo& stream_info,
@@ -55,6 +58,8 @@ private:
   };
 
   const envoy::config::trace::v3::OpenTelemetryConfig opentelemetry_config_;
+  // Shared with the tracer of every worker, which may outlive the driver.
+  BatchSpanExporterSharedPtr batch_exporter_;
   ThreadLocal::SlotPtr tls_slot_ptr_;
   OpenTelemetryTracerStats tracing_stats_;
 };
@@ -1,10 +1,13 @@
 #include "source/extensions/tracers/opentelemetry/span_context_extractor.h"
 
+#include <array>
+
 #include "envoy/tracing/tracer.h"
 
 #include "source/common/http/header_map_impl.h"
 
-#include "absl/strings/escaping.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_split.h"
 #include "span_context.h"
 
 namespace Envoy {
@@ -22,7 +25,6 @@ const Http::LowerCaseString& openTelemetryTraceStateHeader() {
 }
 
 // See https://www.w3.org/TR/trace-context/#traceparent-header
-constexpr int kTraceparentHeaderSize = 55; // 2 + 1 + 32 + 1 + 16 + 1 + 2
 constexpr int kVersionHexSize = 2;
 constexpr int kTraceIdHexSize = 32;
 constexpr int kParentIdHexSize = 16;
@@ -37,6 +39,11 @@ bool isAllZeros(const absl::string_view& input) {
   return std::all_of(input.begin(), input.end(), [](const char& c) { return c == '0'; });
 }
 
+// The caller must have validated c with absl::ascii_isxdigit().
+uint8_t hexDigitValue(char c) {
+  return c <= '9' ? c - '0' : absl::ascii_tolower(c) - 'a' + 10;
+}
+
 } // namespace
 
 SpanContextExtractor::SpanContextExtractor(Tracing::TraceContext& trace_context)
@@ -49,7 +56,7 @@ bool SpanContextExtractor::propagationHeaderPresent() {
   return propagation_header.has_value();
 }
 
-absl::StatusOr<SpanContext> SpanContextExtractor::extractSpanContext() {
+absl::StatusOr<TraceparentView> SpanContextExtractor::extractTraceparent() {
   auto propagation_header = trace_context_.getByKey(openTelemetryPropagationHeader());
   if (!propagation_header.has_value()) {
     // We should have already caught this, but just in case.
@@ -60,10 +67,18 @@ absl::StatusOr<SpanContext> SpanContextExtractor::extractSpanContext() {
   if (header_value_string.size() != kTraceparentHeaderSize) {
     return absl::InvalidArgumentError("Invalid traceparent header length");
   }
-  // Try to split it into its component parts:
-  std::vector<absl::string_view> propagation_header_components =
-      absl::StrSplit(header_value_string, '-', absl::SkipEmpty());
-  if (propagation_header_components.size() != 4) {
+  // Try to split it into its component parts. The split is evaluated lazily so the components
+  // are only views into the header value.
+  std::array<absl::string_view, 4> propagation_header_components;
+  size_t num_components = 0;
+  for (absl::string_view component :
+       absl::StrSplit(header_value_string, '-', absl::SkipEmpty())) {
+    if (num_components == propagation_header_components.size()) {
+      return absl::InvalidArgumentError("Invalid traceparent hyphenation");
+    }
+    propagation_header_components[num_components++] = component;
+  }
+  if (num_components != propagation_header_components.size()) {
     return absl::InvalidArgumentError("Invalid traceparent hyphenation");
   }
   absl::string_view version = propagation_header_components[0];
@@ -87,30 +102,45 @@ absl::StatusOr<SpanContext> SpanContextExtractor::extractSpanContext() {
     return absl::InvalidArgumentError("Invalid parent id");
   }
 
-  // Set whether or not the span is sampled from the trace flags.
+  // Set whether or not the span is sampled from the trace flags. The sampled flag is the least
+  // significant bit, which lives in the second hex digit.
   // See https://w3c.github.io/trace-context/#trace-flags.
-  char decoded_trace_flags = absl::HexStringToBytes(trace_flags).front();
-  bool sampled = (decoded_trace_flags & 1);
+  const bool sampled = hexDigitValue(trace_flags[1]) & 1;
 
+  return TraceparentView{header_value_string, version, trace_id, parent_id, sampled};
+}
+
+std::string SpanContextExtractor::extractTracestate() {
   // If a tracestate header is received without an accompanying traceparent header,
-  // it is invalid and MUST be discarded. Because we're already checking for the
-  // traceparent header above, we don't need to check here.
+  // it is invalid and MUST be discarded. Callers are expected to have validated the traceparent
+  // header first.
   // See https://www.w3.org/TR/trace-context/#processing-model-for-working-with-trace-context
   absl::string_view tracestate_key = openTelemetryTraceStateHeader();
-  std::vector<std::string> tracestate_values;
+  std::string tracestate;
+  bool first = true;
   // Multiple tracestate header fields MUST be handled as specified by RFC7230 Section 3.2.2 Field
   // Order.
   trace_context_.forEach(
-      [&tracestate_key, &tracestate_values](absl::string_view key, absl::string_view value) {
+      [&tracestate_key, &tracestate, &first](absl::string_view key, absl::string_view value) {
         if (key == tracestate_key) {
-          tracestate_values.push_back(std::string{value});
+          if (!first) {
+            tracestate.push_back(',');
+          }
+          tracestate.append(value.data(), value.size());
+          first = false;
         }
         return true;
       });
-  std::string tracestate = absl::StrJoin(tracestate_values, ",");
+  return tracestate;
+}
 
-  SpanContext span_context(version, trace_id, parent_id, sampled, tracestate);
-  return span_context;
+absl::StatusOr<SpanContext> SpanContextExtractor::extractSpanContext() {
+  absl::StatusOr<TraceparentView> traceparent = extractTraceparent();
+  if (!traceparent.ok()) {
+    return traceparent.status();
+  }
+  return SpanContext(traceparent->version, traceparent->trace_id, traceparent->parent_id,
+                     traceparent->sampled, extractTracestate());
 }
 
 } // namespace OpenTelemetry
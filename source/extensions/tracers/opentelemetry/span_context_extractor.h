@@ -12,6 +12,22 @@ namespace Extensions {
 namespace Tracers {
 namespace OpenTelemetry {
 
+// See https://www.w3.org/TR/trace-context/#traceparent-header
+constexpr size_t kTraceparentHeaderSize = 55; // 2 + 1 + 32 + 1 + 16 + 1 + 2
+
+/**
+ * The fields of a validated traceparent header. The views reference the header value, so they are
+ * only valid until the header is modified or the headers are destroyed.
+ */
+struct TraceparentView {
+  // The complete header value, kTraceparentHeaderSize bytes long.
+  absl::string_view value;
+  absl::string_view version;
+  absl::string_view trace_id;
+  absl::string_view parent_id;
+  bool sampled{false};
+};
+
 /**
  * This class is used to SpanContext extracted from the HTTP traceparent header
  * See https://www.w3.org/TR/trace-context/#traceparent-header.
@@ -23,6 +39,19 @@ public:
   absl::StatusOr<SpanContext> extractSpanContext();
   bool propagationHeaderPresent();
 
+  /**
+   * Validate the traceparent header without copying it. This is enough to make the sampling
+   * decision for a request and does not allocate unless the header is invalid.
+   * @return the fields of the traceparent header or an error if it is missing or malformed.
+   */
+  absl::StatusOr<TraceparentView> extractTraceparent();
+
+  /**
+   * @return the value of all tracestate headers joined per RFC7230 Section 3.2.2, or an empty
+   *         string if there are none.
+   */
+  std::string extractTracestate();
+
 private:
   const Tracing::TraceContext& trace_context_;
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "envoy/buffer/buffer.h"
+
 #include "source/common/common/logger.h"
 
 #include "opentelemetry/proto/collector/trace/v1/trace_service.pb.h"
@@ -28,9 +30,20 @@ public:
    * @return false When sending the request failed.
    */
   virtual bool log(const ExportTraceServiceRequest& request) = 0;
+
+  /**
+   * @brief Exports a trace request that has already been serialized, so that the serialization
+   * does not need to happen on the exporting thread.
+   *
+   * @param request The binary protobuf encoding of an ExportTraceServiceRequest.
+   * @return true When the request was sent.
+   * @return false When sending the request failed.
+   */
+  virtual bool logSerialized(Buffer::InstancePtr&& request) = 0;
 };
 
 using OpenTelemetryTraceExporterPtr = std::unique_ptr<OpenTelemetryTraceExporter>;
+using OpenTelemetryTraceExporterSharedPtr = std::shared_ptr<OpenTelemetryTraceExporter>;
 
 } // namespace OpenTelemetry
 } // namespace Tracers
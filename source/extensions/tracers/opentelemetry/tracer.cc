@@ -1,5 +1,7 @@
 #include "source/extensions/tracers/opentelemetry/tracer.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <string>
 
@@ -7,6 +9,7 @@
 
 #include "source/common/common/empty_string.h"
 #include "source/common/common/hex.h"
+#include "source/extensions/tracers/opentelemetry/batch_span_exporter.h"
 
 #include "opentelemetry/proto/collector/trace/v1/trace_service.pb.h"
 #include "opentelemetry/proto/trace/v1/trace.pb.h"
@@ -19,11 +22,27 @@ namespace OpenTelemetry {
 constexpr absl::string_view kTraceParent = "traceparent";
 constexpr absl::string_view kTraceState = "tracestate";
 constexpr absl::string_view kDefaultVersion = "00";
+// Offsets and sizes of the fields of a traceparent header, in hex digits.
+constexpr size_t kTraceIdOffset = 3;
+constexpr size_t kTraceIdHexSize = 32;
+constexpr size_t kSpanIdHexSize = 16;
 
 using opentelemetry::proto::collector::trace::v1::ExportTraceServiceRequest;
 
 namespace {
 
+// Writes the lower case hex encoding of bytes to out, which must have room for twice as many
+// characters, and returns the position after the last character written.
+char* writeHex(absl::string_view bytes, char* out) {
+  static constexpr char kHexDigits[] = "0123456789abcdef";
+  for (const char c : bytes) {
+    const uint8_t byte = static_cast<uint8_t>(c);
+    *out++ = kHexDigits[byte >> 4];
+    *out++ = kHexDigits[byte & 0xf];
+  }
+  return out;
+}
+
 void callSampler(SamplerSharedPtr sampler, const absl::optional<SpanContext> span_context,
                  Span& new_span, const std::string& operation_name) {
   if (!sampler) {
@@ -48,8 +67,6 @@ void callSampler(SamplerSharedPtr sampler, const absl::optional<SpanContext> spa
 Span::Span(const Tracing::Config& config, const std::string& name, SystemTime start_time,
            Envoy::TimeSource& time_source, Tracer& parent_tracer, bool downstream_span)
     : parent_tracer_(parent_tracer), time_source_(time_source) {
-  span_ = ::opentelemetry::proto::trace::v1::Span();
-
   if (downstream_span) {
     // If this is downstream span that be created by 'startSpan' for downstream request, then
     // set the span type based on the spawnUpstreamSpan flag and traffic direction:
@@ -92,14 +109,23 @@ void Span::finishSpan() {
 
 void Span::injectContext(Tracing::TraceContext& trace_context,
                          const Upstream::HostDescriptionConstSharedPtr&) {
-  std::string trace_id_hex = absl::BytesToHexString(span_.trace_id());
-  std::string span_id_hex = absl::BytesToHexString(span_.span_id());
-  std::vector<uint8_t> trace_flags_vec{sampled()};
-  std::string trace_flags_hex = Hex::encode(trace_flags_vec);
-  std::string traceparent_header_value =
-      absl::StrCat(kDefaultVersion, "-", trace_id_hex, "-", span_id_hex, "-", trace_flags_hex);
+  // Format the traceparent on the stack as "00-<trace id>-<span id>-<flags>", rather than building
+  // each component as a temporary string.
+  ASSERT(span_.trace_id().size() * 2 == kTraceIdHexSize);
+  ASSERT(span_.span_id().size() * 2 == kSpanIdHexSize);
+  std::array<char, kTraceparentHeaderSize> traceparent;
+  char* out = traceparent.data();
+  out = std::copy(kDefaultVersion.begin(), kDefaultVersion.end(), out);
+  *out++ = '-';
+  out = writeHex(span_.trace_id(), out);
+  *out++ = '-';
+  out = writeHex(span_.span_id(), out);
+  *out++ = '-';
+  *out++ = '0';
+  *out++ = sampled() ? '1' : '0';
   // Set the traceparent in the trace_context.
-  trace_context.setByReferenceKey(kTraceParent, traceparent_header_value);
+  trace_context.setByReferenceKey(
+      kTraceParent, absl::string_view(traceparent.data(), out - traceparent.data()));
   // Also set the tracestate.
   trace_context.setByReferenceKey(kTraceState, span_.trace_state());
 }
@@ -131,9 +157,15 @@ void Span::setTag(absl::string_view name, absl::string_view value) {
 Tracer::Tracer(OpenTelemetryTraceExporterPtr exporter, Envoy::TimeSource& time_source,
                Random::RandomGenerator& random, Runtime::Loader& runtime,
                Event::Dispatcher& dispatcher, OpenTelemetryTracerStats tracing_stats,
-               const ResourceConstSharedPtr resource, SamplerSharedPtr sampler)
+               const ResourceConstSharedPtr resource, SamplerSharedPtr sampler,
+               std::shared_ptr<BatchSpanExporter> batch_exporter)
     : exporter_(std::move(exporter)), time_source_(time_source), random_(random), runtime_(runtime),
-      tracing_stats_(tracing_stats), resource_(resource), sampler_(sampler) {
+      tracing_stats_(tracing_stats), resource_(resource), sampler_(sampler),
+      batch_exporter_(std::move(batch_exporter)) {
+  if (batch_exporter_ != nullptr) {
+    // Finished spans are handed to the batch exporter, so there is nothing to flush here.
+    return;
+  }
   flush_timer_ = dispatcher.createTimer([this]() -> void {
     tracing_stats_.timer_flushed_.inc();
     flushSpans();
@@ -183,6 +215,12 @@ void Tracer::flushSpans() {
 }
 
 void Tracer::sendSpan(::opentelemetry::proto::trace::v1::Span& span) {
+  if (batch_exporter_ != nullptr) {
+    // The span is finished, so its contents can be moved rather than copied.
+    batch_exporter_->enqueue(
+        std::make_unique<::opentelemetry::proto::trace::v1::Span>(std::move(span)));
+    return;
+  }
   span_buffer_.push_back(span);
   const uint64_t min_flush_spans =
       runtime_.snapshot().getInteger("tracing.opentelemetry.min_flush_spans", 5U);
@@ -195,43 +233,68 @@ Tracing::SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::str
                                    SystemTime start_time, Tracing::Decision tracing_decision,
                                    bool downstream_span) {
   // Create an Tracers::OpenTelemetry::Span class that will contain the OTel span.
-  Span new_span(config, operation_name, start_time, time_source_, *this, downstream_span);
+  auto new_span = std::make_unique<Span>(config, operation_name, start_time, time_source_, *this,
+                                         downstream_span);
   uint64_t trace_id_high = random_.random();
   uint64_t trace_id = random_.random();
-  new_span.setTraceId(absl::StrCat(Hex::uint64ToHex(trace_id_high), Hex::uint64ToHex(trace_id)));
+  new_span->setTraceId(absl::StrCat(Hex::uint64ToHex(trace_id_high), Hex::uint64ToHex(trace_id)));
   uint64_t span_id = random_.random();
-  new_span.setId(Hex::uint64ToHex(span_id));
+  new_span->setId(Hex::uint64ToHex(span_id));
   if (sampler_) {
-    callSampler(sampler_, absl::nullopt, new_span, operation_name);
+    callSampler(sampler_, absl::nullopt, *new_span, operation_name);
   } else {
-    new_span.setSampled(tracing_decision.traced);
+    new_span->setSampled(tracing_decision.traced);
   }
-  return std::make_unique<Span>(new_span);
+  return new_span;
 }
 
 Tracing::SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& operation_name,
                                    SystemTime start_time, const SpanContext& previous_span_context,
                                    bool downstream_span) {
   // Create a new span and populate details from the span context.
-  Span new_span(config, operation_name, start_time, time_source_, *this, downstream_span);
-  new_span.setTraceId(previous_span_context.traceId());
+  auto new_span = std::make_unique<Span>(config, operation_name, start_time, time_source_, *this,
+                                         downstream_span);
+  new_span->setTraceId(previous_span_context.traceId());
   if (!previous_span_context.parentId().empty()) {
-    new_span.setParentId(previous_span_context.parentId());
+    new_span->setParentId(previous_span_context.parentId());
   }
   // Generate a new identifier for the span id.
   uint64_t span_id = random_.random();
-  new_span.setId(Hex::uint64ToHex(span_id));
+  new_span->setId(Hex::uint64ToHex(span_id));
   if (sampler_) {
     // Sampler should make a sampling decision and set tracestate
-    callSampler(sampler_, previous_span_context, new_span, operation_name);
+    callSampler(sampler_, previous_span_context, *new_span, operation_name);
   } else {
     // Respect the previous span's sampled flag.
-    new_span.setSampled(previous_span_context.sampled());
+    new_span->setSampled(previous_span_context.sampled());
     if (!previous_span_context.tracestate().empty()) {
-      new_span.setTracestate(std::string{previous_span_context.tracestate()});
+      new_span->setTracestate(previous_span_context.tracestate());
     }
   }
-  return std::make_unique<Span>(new_span);
+  return new_span;
+}
+
+NonRecordingSpan::NonRecordingSpan(const TraceparentView& traceparent, std::string&& tracestate)
+    : tracestate_(std::move(tracestate)) {
+  ASSERT(traceparent.value.size() == traceparent_.size());
+  std::copy(traceparent.value.begin(), traceparent.value.end(), traceparent_.begin());
+}
+
+void NonRecordingSpan::injectContext(Tracing::TraceContext& trace_context,
+                                     const Upstream::HostDescriptionConstSharedPtr&) {
+  // Forward the inbound context unchanged, so the next hop sees the same parent.
+  trace_context.setByReferenceKey(kTraceParent,
+                                  absl::string_view(traceparent_.data(), traceparent_.size()));
+  trace_context.setByReferenceKey(kTraceState, tracestate_);
+}
+
+Tracing::SpanPtr NonRecordingSpan::spawnChild(const Tracing::Config&, const std::string&,
+                                              SystemTime) {
+  return std::make_unique<NonRecordingSpan>(*this);
+}
+
+std::string NonRecordingSpan::getTraceIdAsHex() const {
+  return std::string(traceparent_.data() + kTraceIdOffset, kTraceIdHexSize);
 }
 
 } // namespace OpenTelemetry
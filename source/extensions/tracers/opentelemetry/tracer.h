@@ -1,6 +1,8 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <memory>
 
 #include "envoy/api/api.h"
 #include "envoy/config/trace/v3/opentelemetry.pb.h"
@@ -14,6 +16,7 @@
 #include "source/extensions/tracers/opentelemetry/resource_detectors/resource_detector.h"
 #include "source/extensions/tracers/opentelemetry/samplers/sampler.h"
 #include "source/extensions/tracers/opentelemetry/span_context.h"
+#include "source/extensions/tracers/opentelemetry/span_context_extractor.h"
 
 #include "absl/strings/escaping.h"
 
@@ -23,6 +26,9 @@ namespace Tracers {
 namespace OpenTelemetry {
 
 #define OPENTELEMETRY_TRACER_STATS(COUNTER)                                                        \
+  COUNTER(export_batches)                                                                          \
+  COUNTER(export_batches_failed)                                                                   \
+  COUNTER(spans_dropped)                                                                           \
   COUNTER(spans_sent)                                                                              \
   COUNTER(timer_flushed)
 
@@ -30,15 +36,19 @@ struct OpenTelemetryTracerStats {
   OPENTELEMETRY_TRACER_STATS(GENERATE_COUNTER_STRUCT)
 };
 
+class BatchSpanExporter;
+
 /**
- * OpenTelemetry Tracer. It is stored in TLS and contains the exporter.
+ * OpenTelemetry Tracer. It is stored in TLS and contains the exporter, unless finished spans are
+ * handed to a BatchSpanExporter shared by all workers.
  */
 class Tracer : Logger::Loggable<Logger::Id::tracing> {
 public:
   Tracer(OpenTelemetryTraceExporterPtr exporter, Envoy::TimeSource& time_source,
          Random::RandomGenerator& random, Runtime::Loader& runtime, Event::Dispatcher& dispatcher,
          OpenTelemetryTracerStats tracing_stats, const ResourceConstSharedPtr resource,
-         SamplerSharedPtr sampler);
+         SamplerSharedPtr sampler,
+         std::shared_ptr<BatchSpanExporter> batch_exporter = nullptr);
 
   void sendSpan(::opentelemetry::proto::trace::v1::Span& span);
 
@@ -50,6 +60,12 @@ public:
                              SystemTime start_time, const SpanContext& previous_span_context,
                              bool downstream_span = true);
 
+  /**
+   * @return whether a sampler makes the sampling decisions. When there is none, the decision for
+   *         a request with a traceparent header is taken from its sampled flag.
+   */
+  bool samplerConfigured() const { return sampler_ != nullptr; }
+
 private:
   /**
    * Enables the span-flushing timer.
@@ -69,6 +85,8 @@ private:
   OpenTelemetryTracerStats tracing_stats_;
   const ResourceConstSharedPtr resource_;
   SamplerSharedPtr sampler_;
+  // Shared with the driver. Spans may still finish on this worker after the driver is gone.
+  const std::shared_ptr<BatchSpanExporter> batch_exporter_;
 };
 
 /**
@@ -95,6 +113,9 @@ public:
    */
   void setSampled(bool sampled) override { sampled_ = sampled; };
 
+  // Only sampled spans are exported.
+  bool isRecording() const override { return sampled_; }
+
   /**
    * @return whether or not the sampled attribute is set
    */
@@ -154,6 +175,37 @@ private:
   bool sampled_;
 };
 
+/**
+ * Span for a request whose inbound traceparent header is not sampled and for which no sampler
+ * could override that decision. Nothing about such a request is exported, so rather than building
+ * an OpenTelemetry span this only copies the inbound trace context and forwards it unchanged.
+ * Children are non recording as well, and the sampling decision can not be changed later.
+ */
+class NonRecordingSpan : public Tracing::Span {
+public:
+  NonRecordingSpan(const TraceparentView& traceparent, std::string&& tracestate);
+
+  // Tracing::Span functions
+  void setOperation(absl::string_view) override {}
+  void setTag(absl::string_view, absl::string_view) override {}
+  void log(SystemTime, const std::string&) override {}
+  void finishSpan() override {}
+  void injectContext(Envoy::Tracing::TraceContext& trace_context,
+                     const Upstream::HostDescriptionConstSharedPtr&) override;
+  Tracing::SpanPtr spawnChild(const Tracing::Config&, const std::string&, SystemTime) override;
+  void setSampled(bool) override {}
+  bool isRecording() const override { return false; }
+  std::string getBaggage(absl::string_view) override { return EMPTY_STRING; }
+  void setBaggage(absl::string_view, absl::string_view) override {}
+  std::string getTraceIdAsHex() const override;
+
+private:
+  // A copy of the inbound header, since the header map it was read from may be modified while
+  // this span is alive.
+  std::array<char, kTraceparentHeaderSize> traceparent_;
+  const std::string tracestate_;
+};
+
 using TracerPtr = std::unique_ptr<Tracer>;
 
 } // namespace OpenTelemetry
@@ -78,6 +78,8 @@ public:
                               SystemTime start_time) override;
 
   void setSampled(bool sampled) override;
+  // Only sampled spans are reported to the collector.
+  bool isRecording() const override { return span_.sampled(); }
 
   // TODO(#11622): Implement baggage storage for zipkin spans
   void setBaggage(absl::string_view, absl::string_view) override;
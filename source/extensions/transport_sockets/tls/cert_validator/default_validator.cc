@@ -1,5 +1,6 @@
 #include "source/extensions/transport_sockets/tls/cert_validator/default_validator.h"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <deque>
@@ -40,6 +41,53 @@ namespace Extensions {
 namespace TransportSockets {
 namespace Tls {
 
+namespace {
+
+constexpr uint32_t DefaultVerificationCacheMaxEntries = 1024;
+constexpr uint64_t DefaultVerificationCacheTtlMs = 5 * 60 * 1000;
+
+} // namespace
+
+absl::optional<Envoy::Ssl::ClientValidationStatus>
+VerificationCache::lookup(const std::string& key) {
+  absl::MutexLock lock(&mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return absl::nullopt;
+  }
+  if (time_source_.systemTime() >= it->second->expiration_) {
+    entries_.erase(it->second);
+    index_.erase(it);
+    return absl::nullopt;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->status_;
+}
+
+void VerificationCache::insert(const std::string& key, Envoy::Ssl::ClientValidationStatus status,
+                               SystemTime not_after) {
+  const SystemTime expiration = std::min<SystemTime>(time_source_.systemTime() + ttl_, not_after);
+  absl::MutexLock lock(&mutex_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    it->second->status_ = status;
+    it->second->expiration_ = expiration;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  if (entries_.size() >= max_entries_) {
+    index_.erase(entries_.back().key_);
+    entries_.pop_back();
+  }
+  entries_.push_front({key, status, expiration});
+  index_.emplace(key, entries_.begin());
+}
+
+size_t VerificationCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
 DefaultCertValidator::DefaultCertValidator(
     const Envoy::Ssl::CertificateValidationContextConfig* config, SslStats& stats,
     TimeSource& time_source)
@@ -48,6 +96,15 @@ DefaultCertValidator::DefaultCertValidator(
     allow_untrusted_certificate_ = config_->trustChainVerification() ==
                                    envoy::extensions::transport_sockets::tls::v3::
                                        CertificateValidationContext::ACCEPT_UNTRUSTED;
+    if (config_->verificationCache().has_value()) {
+      const auto& cache_config = config_->verificationCache().value();
+      verification_cache_ = std::make_unique<VerificationCache>(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache_config, max_entries,
+                                          DefaultVerificationCacheMaxEntries),
+          std::chrono::milliseconds(
+              PROTOBUF_GET_MS_OR_DEFAULT(cache_config, ttl, DefaultVerificationCacheTtlMs)),
+          time_source_);
+    }
   }
 };
 
@@ -291,6 +348,28 @@ ValidationResults DefaultCertValidator::doVerifyCertChain(
     return {ValidationResults::ValidationStatus::Failed,
             Envoy::Ssl::ClientValidationStatus::NoClientCertificate, absl::nullopt, error};
   }
+  std::string cache_key;
+  if (verification_cache_ != nullptr) {
+    cache_key = verificationCacheKey(cert_chain, transport_socket_options.get());
+    const absl::optional<Envoy::Ssl::ClientValidationStatus> cached_status =
+        verification_cache_->lookup(cache_key);
+    if (cached_status.has_value()) {
+      stats_.verification_cache_hit_.inc();
+      return {ValidationResults::ValidationStatus::Successful, cached_status.value(),
+              absl::nullopt, absl::nullopt};
+    }
+    stats_.verification_cache_miss_.inc();
+  }
+  // The time past which the chain doesn't verify anymore, as far as caching it is concerned.
+  SystemTime not_after = SystemTime::max();
+  const auto update_not_after = [this, &not_after](STACK_OF(X509)* certs) {
+    if (verification_cache_ != nullptr && !config_->allowExpiredCertificate()) {
+      for (const X509* cert : certs) {
+        not_after = std::min(not_after, Utility::getExpirationTime(*cert));
+      }
+    }
+  };
+  update_not_after(&cert_chain);
   Envoy::Ssl::ClientValidationStatus detailed_status =
       Envoy::Ssl::ClientValidationStatus::NotValidated;
   X509* leaf_cert = sk_X509_value(&cert_chain, 0);
@@ -331,15 +410,53 @@ ValidationResults DefaultCertValidator::doVerifyCertChain(
               SSL_alert_from_verify_result(X509_STORE_CTX_get_error(ctx.get())), error};
     }
     detailed_status = Envoy::Ssl::ClientValidationStatus::Validated;
+    // The verified chain also holds the certificates taken from the trusted CAs.
+    update_not_after(X509_STORE_CTX_get0_chain(ctx.get()));
   }
   std::string error_details;
   uint8_t tls_alert = SSL_AD_CERTIFICATE_UNKNOWN;
   const bool succeeded = verifyCertAndUpdateStatus(leaf_cert, transport_socket_options.get(),
                                                    detailed_status, &error_details, &tls_alert);
-  return succeeded ? ValidationResults{ValidationResults::ValidationStatus::Successful,
-                                       detailed_status, absl::nullopt, absl::nullopt}
-                   : ValidationResults{ValidationResults::ValidationStatus::Failed, detailed_status,
-                                       tls_alert, error_details};
+  if (!succeeded) {
+    return {ValidationResults::ValidationStatus::Failed, detailed_status, tls_alert,
+            error_details};
+  }
+  // Chains which are only accepted because untrusted certificates are allowed aren't cached, so
+  // that their failures keep being reported.
+  if (verification_cache_ != nullptr &&
+      detailed_status != Envoy::Ssl::ClientValidationStatus::Failed) {
+    verification_cache_->insert(cache_key, detailed_status, not_after);
+  }
+  return {ValidationResults::ValidationStatus::Successful, detailed_status, absl::nullopt,
+          absl::nullopt};
+}
+
+std::string DefaultCertValidator::verificationCacheKey(
+    STACK_OF(X509)& cert_chain, const Network::TransportSocketOptions* transport_socket_options) {
+  bssl::ScopedEVP_MD_CTX md;
+  int rc = EVP_DigestInit(md.get(), EVP_sha256());
+  RELEASE_ASSERT(rc == 1, Utility::getLastCryptoError().value_or(""));
+  uint8_t hash_buffer[EVP_MAX_MD_SIZE];
+  unsigned hash_length;
+  for (const X509* cert : &cert_chain) {
+    rc = X509_digest(cert, EVP_sha256(), hash_buffer, &hash_length);
+    RELEASE_ASSERT(rc == 1, Utility::getLastCryptoError().value_or(""));
+    rc = EVP_DigestUpdate(md.get(), hash_buffer, hash_length);
+    RELEASE_ASSERT(rc == 1, Utility::getLastCryptoError().value_or(""));
+  }
+  if (transport_socket_options != nullptr) {
+    for (const std::string& san : transport_socket_options->verifySubjectAltNameListOverride()) {
+      // Hash the lengths too, so that different lists can't hash the same.
+      const size_t length = san.size();
+      rc = EVP_DigestUpdate(md.get(), &length, sizeof(length));
+      RELEASE_ASSERT(rc == 1, Utility::getLastCryptoError().value_or(""));
+      rc = EVP_DigestUpdate(md.get(), san.data(), san.size());
+      RELEASE_ASSERT(rc == 1, Utility::getLastCryptoError().value_or(""));
+    }
+  }
+  rc = EVP_DigestFinal(md.get(), hash_buffer, &hash_length);
+  RELEASE_ASSERT(rc == 1, Utility::getLastCryptoError().value_or(""));
+  return {reinterpret_cast<const char*>(hash_buffer), hash_length};
 }
 
 bool DefaultCertValidator::verifySubjectAltName(X509* cert,
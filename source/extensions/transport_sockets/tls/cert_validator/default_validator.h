@@ -4,11 +4,13 @@
 #include <cstdint>
 #include <deque>
 #include <functional>
+#include <list>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "envoy/common/pure.h"
+#include "envoy/common/time.h"
 #include "envoy/network/transport_socket.h"
 #include "envoy/registry/registry.h"
 #include "envoy/ssl/context.h"
@@ -23,6 +25,7 @@
 #include "source/extensions/transport_sockets/tls/cert_validator/san_matcher.h"
 #include "source/extensions/transport_sockets/tls/stats.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/synchronization/mutex.h"
 #include "openssl/ssl.h"
 #include "openssl/x509v3.h"
@@ -32,6 +35,51 @@ namespace Extensions {
 namespace TransportSockets {
 namespace Tls {
 
+/**
+ * The peer certificate chains which were successfully verified by a validator, so that they don't
+ * need to be verified again. Shared by all the threads using the validator.
+ */
+class VerificationCache {
+public:
+  VerificationCache(uint32_t max_entries, std::chrono::milliseconds ttl, TimeSource& time_source)
+      : max_entries_(max_entries), ttl_(ttl), time_source_(time_source) {}
+
+  /**
+   * @param key identifies the chain and the parameters of its verification.
+   * @return the status of the verification of the chain, unless it isn't cached or has expired.
+   */
+  absl::optional<Envoy::Ssl::ClientValidationStatus> lookup(const std::string& key);
+
+  /**
+   * Caches a successful verification, evicting the least recently used one if the cache is full.
+   * @param key identifies the chain and the parameters of its verification.
+   * @param status the status of the verification.
+   * @param not_after the time past which the chain doesn't verify anymore.
+   */
+  void insert(const std::string& key, Envoy::Ssl::ClientValidationStatus status,
+              SystemTime not_after);
+
+  /**
+   * @return the number of cached verifications, including the expired ones not evicted yet.
+   */
+  size_t size() const;
+
+private:
+  struct Entry {
+    std::string key_;
+    Envoy::Ssl::ClientValidationStatus status_;
+    SystemTime expiration_;
+  };
+
+  const uint32_t max_entries_;
+  const std::chrono::milliseconds ttl_;
+  TimeSource& time_source_;
+  mutable absl::Mutex mutex_;
+  // The most recently used entries first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, std::list<Entry>::iterator> index_ ABSL_GUARDED_BY(mutex_);
+};
+
 class DefaultCertValidator : public CertValidator, Logger::Loggable<Logger::Id::connection> {
 public:
   DefaultCertValidator(const Envoy::Ssl::CertificateValidationContextConfig* config,
@@ -102,7 +150,18 @@ public:
   static bool matchSubjectAltName(X509* cert,
                                   const std::vector<SanMatcherPtr>& subject_alt_name_matchers);
 
+  /**
+   * @return the cache of successful verifications, if enabled.
+   */
+  const VerificationCache* verificationCache() const { return verification_cache_.get(); }
+
 private:
+  // The key of a chain in the verification cache. It covers the inputs of the verification which
+  // aren't fixed by the configuration of the validator.
+  static std::string
+  verificationCacheKey(STACK_OF(X509)& cert_chain,
+                       const Network::TransportSocketOptions* transport_socket_options);
+
   bool verifyCertAndUpdateStatus(X509* leaf_cert,
                                  const Network::TransportSocketOptions* transport_socket_options,
                                  Envoy::Ssl::ClientValidationStatus& detailed_status,
@@ -119,6 +178,7 @@ private:
   std::vector<std::vector<uint8_t>> verify_certificate_hash_list_;
   std::vector<std::vector<uint8_t>> verify_certificate_spki_list_;
   bool verify_trusted_ca_{false};
+  std::unique_ptr<VerificationCache> verification_cache_;
 };
 
 DECLARE_FACTORY(DefaultCertValidatorFactory);
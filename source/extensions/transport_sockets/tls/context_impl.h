@@ -76,6 +76,12 @@ public:
 
   SslStats& stats() { return stats_; }
 
+  /**
+   * @return whether the record layer of connections should be offloaded to the kernel once their
+   *         handshake completes.
+   */
+  bool kernelTlsEnabled() const { return kernel_tls_; }
+
   /**
    * The global SSL-library index used for storing a pointer to the SslExtendedSocketInfo
    * class in the SSL instance, for retrieval in callbacks.
@@ -154,6 +160,7 @@ protected:
   const Network::Address::IpList tls_keylog_local_;
   const Network::Address::IpList tls_keylog_remote_;
   AccessLog::AccessLogFileSharedPtr tls_keylog_file_;
+  const bool kernel_tls_;
 };
 
 using ContextImplSharedPtr = std::shared_ptr<ContextImpl>;
@@ -0,0 +1,300 @@
+#include "source/extensions/transport_sockets/tls/ktls.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/common/macros.h"
+#include "source/common/common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "openssl/digest.h"
+#include "openssl/hkdf.h"
+#include "openssl/mem.h"
+
+#if defined(__linux__)
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace KernelTls {
+
+namespace {
+
+// Set once the kernel refused to offload a connection. A kernel which doesn't support a cipher or
+// a direction for one connection doesn't support it for the next ones either.
+std::atomic<bool>& disabled() { MUTABLE_CONSTRUCT_ON_FIRST_USE(std::atomic<bool>, false); }
+
+} // namespace
+
+void resetForTest() { disabled() = false; }
+
+#if defined(__linux__)
+
+namespace {
+
+// The AES-GCM nonce is made of a 4 byte salt, which is fixed for the connection, and 8 more bytes.
+constexpr size_t SaltLength = 4;
+constexpr size_t NonceLength = 12;
+
+// The key material of one direction of a connection.
+struct TrafficKeys {
+  std::vector<uint8_t> key_;
+  // The salt, followed by the rest of the initial nonce.
+  std::array<uint8_t, NonceLength> nonce_{};
+  uint64_t sequence_{};
+};
+
+void storeBigEndian(uint64_t value, uint8_t* out) {
+  for (int i = 7; i >= 0; i--) {
+    out[i] = value & 0xff;
+    value >>= 8;
+  }
+}
+
+// HKDF-Expand-Label of RFC 8446, section 7.1, with an empty context.
+bool hkdfExpandLabel(absl::Span<uint8_t> out, const EVP_MD* digest,
+                     absl::Span<const uint8_t> secret, absl::string_view label) {
+  const std::string full_label = absl::StrCat("tls13 ", label);
+  std::vector<uint8_t> info;
+  info.push_back(out.size() >> 8);
+  info.push_back(out.size() & 0xff);
+  info.push_back(full_label.size());
+  info.insert(info.end(), full_label.begin(), full_label.end());
+  info.push_back(0);
+  return HKDF_expand(out.data(), out.size(), digest, secret.data(), secret.size(), info.data(),
+                     info.size());
+}
+
+bool tls13TrafficKeys(const EVP_MD* digest, absl::Span<const uint8_t> secret, TrafficKeys& keys) {
+  return hkdfExpandLabel(absl::MakeSpan(keys.key_), digest, secret, "key") &&
+         hkdfExpandLabel(absl::MakeSpan(keys.nonce_), digest, secret, "iv");
+}
+
+// Derives the keys of both directions of a TLS 1.3 connection from its traffic secrets.
+bool tls13Keys(SSL* ssl, TrafficKeys& read_keys, TrafficKeys& write_keys) {
+  bssl::Span<const uint8_t> read_secret;
+  bssl::Span<const uint8_t> write_secret;
+  if (!bssl::SSL_get_traffic_secrets(ssl, &read_secret, &write_secret)) {
+    return false;
+  }
+  const EVP_MD* digest = EVP_get_digestbynid(SSL_CIPHER_get_prf_nid(SSL_get_current_cipher(ssl)));
+  return digest != nullptr &&
+         tls13TrafficKeys(digest, {read_secret.data(), read_secret.size()}, read_keys) &&
+         tls13TrafficKeys(digest, {write_secret.data(), write_secret.size()}, write_keys);
+}
+
+// Splits the key block of a TLS 1.2 connection into the keys of both directions. For AES-GCM, the
+// key block holds the client and server keys followed by their salts. BoringSSL uses the sequence
+// number as the explicit part of the nonces.
+bool tls12Keys(SSL* ssl, TrafficKeys& read_keys, TrafficKeys& write_keys) {
+  const size_t key_length = read_keys.key_.size();
+  std::vector<uint8_t> key_block(SSL_get_key_block_len(ssl));
+  if (key_block.size() != 2 * (key_length + SaltLength) ||
+      !SSL_generate_key_block(ssl, key_block.data(), key_block.size())) {
+    return false;
+  }
+  const uint8_t* client_key = key_block.data();
+  const uint8_t* server_key = client_key + key_length;
+  const uint8_t* client_salt = server_key + key_length;
+  const uint8_t* server_salt = client_salt + SaltLength;
+  const bool is_server = SSL_is_server(ssl);
+  TrafficKeys& client_keys = is_server ? read_keys : write_keys;
+  TrafficKeys& server_keys = is_server ? write_keys : read_keys;
+  memcpy(client_keys.key_.data(), client_key, key_length);    // NOLINT(safe-memcpy)
+  memcpy(server_keys.key_.data(), server_key, key_length);    // NOLINT(safe-memcpy)
+  memcpy(client_keys.nonce_.data(), client_salt, SaltLength); // NOLINT(safe-memcpy)
+  memcpy(server_keys.nonce_.data(), server_salt, SaltLength); // NOLINT(safe-memcpy)
+  storeBigEndian(read_keys.sequence_, read_keys.nonce_.data() + SaltLength);
+  storeBigEndian(write_keys.sequence_, write_keys.nonce_.data() + SaltLength);
+  return true;
+}
+
+template <class CryptoInfo>
+Api::SysCallIntResult installKeys(Network::IoHandle& io_handle, int direction, uint16_t version,
+                                  uint16_t cipher_type, const TrafficKeys& keys) {
+  CryptoInfo info{};
+  info.info.version = version == TLS1_3_VERSION ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+  info.info.cipher_type = cipher_type;
+  static_assert(sizeof(info.salt) == SaltLength);
+  static_assert(sizeof(info.salt) + sizeof(info.iv) == NonceLength);
+  ASSERT(keys.key_.size() == sizeof(info.key));
+  memcpy(info.key, keys.key_.data(), sizeof(info.key));                     // NOLINT(safe-memcpy)
+  memcpy(info.salt, keys.nonce_.data(), sizeof(info.salt));                 // NOLINT(safe-memcpy)
+  memcpy(info.iv, keys.nonce_.data() + sizeof(info.salt), sizeof(info.iv)); // NOLINT(safe-memcpy)
+  storeBigEndian(keys.sequence_, info.rec_seq);
+  const Api::SysCallIntResult result =
+      io_handle.setOption(SOL_TLS, direction, &info, static_cast<socklen_t>(sizeof(info)));
+  OPENSSL_cleanse(&info, sizeof(info));
+  return result;
+}
+
+} // namespace
+
+OffloadResult offload(SSL* ssl, Network::IoHandle& io_handle, std::string& details) {
+  if (disabled()) {
+    details = "the kernel refused to offload an earlier connection";
+    return OffloadResult::Unsupported;
+  }
+  const uint16_t version = SSL_version(ssl);
+  if (version != TLS1_2_VERSION && version != TLS1_3_VERSION) {
+    details = "unsupported TLS version";
+    return OffloadResult::Unsupported;
+  }
+  if (version == TLS1_3_VERSION && !SSL_is_server(ssl)) {
+    details = "TLS 1.3 clients receive session tickets after the handshake";
+    return OffloadResult::Unsupported;
+  }
+  if (SSL_in_init(ssl) || SSL_has_pending(ssl)) {
+    // BoringSSL already holds part of the records after the handshake.
+    details = "pending data";
+    return OffloadResult::Unsupported;
+  }
+
+  size_t key_length;
+  uint16_t cipher_type;
+  switch (SSL_CIPHER_get_cipher_nid(SSL_get_current_cipher(ssl))) {
+  case NID_aes_128_gcm:
+    key_length = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+    cipher_type = TLS_CIPHER_AES_GCM_128;
+    break;
+  case NID_aes_256_gcm:
+    key_length = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+    cipher_type = TLS_CIPHER_AES_GCM_256;
+    break;
+  default:
+    details = "unsupported cipher";
+    return OffloadResult::Unsupported;
+  }
+
+  TrafficKeys read_keys;
+  TrafficKeys write_keys;
+  read_keys.key_.resize(key_length);
+  write_keys.key_.resize(key_length);
+  read_keys.sequence_ = SSL_get_read_sequence(ssl);
+  write_keys.sequence_ = SSL_get_write_sequence(ssl);
+  const bool derived = version == TLS1_3_VERSION ? tls13Keys(ssl, read_keys, write_keys)
+                                                 : tls12Keys(ssl, read_keys, write_keys);
+  const auto cleanse = [&read_keys, &write_keys]() {
+    OPENSSL_cleanse(read_keys.key_.data(), read_keys.key_.size());
+    OPENSSL_cleanse(write_keys.key_.data(), write_keys.key_.size());
+  };
+  if (!derived) {
+    cleanse();
+    details = "failed to derive the traffic keys";
+    return OffloadResult::Unsupported;
+  }
+
+  // Until keys are installed, a socket with the TLS upper layer protocol still behaves as a plain
+  // TCP socket, so failing to install the protocol or the first key leaves the connection usable.
+  static constexpr char TlsUlp[] = "tls";
+  Api::SysCallIntResult result = io_handle.setOption(IPPROTO_TCP, TCP_ULP, TlsUlp, sizeof(TlsUlp));
+  if (result.return_value_ != 0) {
+    cleanse();
+    disabled() = true;
+    details = absl::StrCat("the kernel doesn't support TLS: ", errorDetails(result.errno_));
+    return OffloadResult::Unsupported;
+  }
+
+  const auto install = [&](int direction, const TrafficKeys& keys) {
+    return key_length == TLS_CIPHER_AES_GCM_128_KEY_SIZE
+               ? installKeys<tls12_crypto_info_aes_gcm_128>(io_handle, direction, version,
+                                                            cipher_type, keys)
+               : installKeys<tls12_crypto_info_aes_gcm_256>(io_handle, direction, version,
+                                                            cipher_type, keys);
+  };
+  // Kernels gained support for decryption after encryption, so the read keys go first. A kernel
+  // which accepts them also accepts the write keys, and the connection is only given up if it
+  // doesn't.
+  result = install(TLS_RX, read_keys);
+  if (result.return_value_ != 0) {
+    cleanse();
+    disabled() = true;
+    details = absl::StrCat("the kernel doesn't support the cipher: ", errorDetails(result.errno_));
+    return OffloadResult::Unsupported;
+  }
+  result = install(TLS_TX, write_keys);
+  cleanse();
+  if (result.return_value_ != 0) {
+    disabled() = true;
+    details = absl::StrCat("failed to install the write keys: ", errorDetails(result.errno_));
+    return OffloadResult::Failed;
+  }
+  return OffloadResult::Offloaded;
+}
+
+Api::SysCallSizeResult readRecord(Network::IoHandle& io_handle, uint8_t& record_type,
+                                  uint8_t* buffer, size_t length) {
+  iovec iov{buffer, length};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint8_t))];
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  const Api::SysCallSizeResult result =
+      Api::OsSysCallsSingleton::get().recvmsg(io_handle.fdDoNotUse(), &message, 0);
+  record_type = RecordTypeApplicationData;
+  const cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  if (result.return_value_ >= 0 && cmsg != nullptr && cmsg->cmsg_level == SOL_TLS &&
+      cmsg->cmsg_type == TLS_GET_RECORD_TYPE) {
+    record_type = *CMSG_DATA(cmsg);
+  }
+  return result;
+}
+
+Api::SysCallSizeResult sendCloseNotify(Network::IoHandle& io_handle) {
+  // A warning level close_notify alert.
+  uint8_t alert[] = {1, 0};
+  iovec iov{alert, sizeof(alert)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint8_t))] = {};
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = RecordTypeAlert;
+  return Api::OsSysCallsSingleton::get().sendmsg(io_handle.fdDoNotUse(), &message, 0);
+}
+
+#else
+
+OffloadResult offload(SSL*, Network::IoHandle&, std::string& details) {
+  details = "kernel TLS is only supported on Linux";
+  return OffloadResult::Unsupported;
+}
+
+Api::SysCallSizeResult readRecord(Network::IoHandle&, uint8_t&, uint8_t*, size_t) {
+  PANIC("not reached");
+}
+
+Api::SysCallSizeResult sendCloseNotify(Network::IoHandle&) { PANIC("not reached"); }
+
+#endif
+
+} // namespace KernelTls
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "envoy/api/os_sys_calls_common.h"
+#include "envoy/network/io_handle.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+/**
+ * Offloading of the TLS record layer to the kernel (kTLS). Once offloaded, the kernel encrypts
+ * what is written to the socket and decrypts what is read from it, so the connection reads and
+ * writes plaintext to the socket instead of going through BoringSSL.
+ */
+namespace KernelTls {
+
+// The TLS record content types.
+constexpr uint8_t RecordTypeAlert = 21;
+constexpr uint8_t RecordTypeHandshake = 22;
+constexpr uint8_t RecordTypeApplicationData = 23;
+
+enum class OffloadResult {
+  // The kernel encrypts and decrypts the records of the connection. The SSL object must not be
+  // used to read or write anymore.
+  Offloaded,
+  // The connection can't be offloaded and is left untouched, so it keeps using BoringSSL.
+  Unsupported,
+  // The kernel only took over part of the connection, which can't be used anymore.
+  Failed,
+};
+
+/**
+ * Moves the record layer of a connection to the kernel. This is only possible right after the
+ * handshake completes, before BoringSSL reads or writes any record of the connection, and only
+ * for AES-GCM ciphers over TLS 1.2 or TLS 1.3. TLS 1.3 is limited to servers, as clients receive
+ * session tickets after the handshake, which the kernel doesn't handle. Once the kernel refuses to
+ * offload a connection, offloading is disabled for the rest of the process, so that the following
+ * connections keep using BoringSSL without trying again.
+ * @param ssl the connection, whose handshake has completed.
+ * @param io_handle the socket of the connection.
+ * @param details receives the reason the connection wasn't offloaded.
+ * @return the outcome of the offload.
+ */
+OffloadResult offload(SSL* ssl, Network::IoHandle& io_handle, std::string& details);
+
+/**
+ * Reads a single record of an offloaded connection, along with its content type. A plain read
+ * of the socket fails with EIO when the next record isn't application data.
+ * @param io_handle the socket of the connection.
+ * @param record_type receives the content type of the record.
+ * @param buffer receives the content of the record.
+ * @param length the size of buffer.
+ * @return the length of the content of the record, or the error of the read.
+ */
+Api::SysCallSizeResult readRecord(Network::IoHandle& io_handle, uint8_t& record_type,
+                                  uint8_t* buffer, size_t length);
+
+/**
+ * Sends a close_notify alert on an offloaded connection.
+ * @param io_handle the socket of the connection.
+ * @return the result of the write.
+ */
+Api::SysCallSizeResult sendCloseNotify(Network::IoHandle& io_handle);
+
+/**
+ * Enables offloading again after the kernel refused it.
+ */
+void resetForTest();
+
+} // namespace KernelTls
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -5,9 +5,11 @@
 #include "source/common/common/assert.h"
 #include "source/common/common/empty_string.h"
 #include "source/common/common/hex.h"
+#include "source/common/common/utility.h"
 #include "source/common/http/headers.h"
 #include "source/common/runtime/runtime_features.h"
 #include "source/extensions/transport_sockets/tls/io_handle_bio.h"
+#include "source/extensions/transport_sockets/tls/ktls.h"
 #include "source/extensions/transport_sockets/tls/ssl_handshaker.h"
 #include "source/extensions/transport_sockets/tls/utility.h"
 
@@ -110,6 +112,10 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
     }
   }
 
+  if (kernel_tls_) {
+    return kernelTlsRead(read_buffer);
+  }
+
   bool keep_reading = true;
   bool end_stream = false;
   PostIoAction action = PostIoAction::KeepOpen;
@@ -165,6 +171,75 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
   return {action, bytes_read, end_stream};
 }
 
+Network::IoResult SslSocket::kernelTlsRead(Buffer::Instance& read_buffer) {
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_read = 0;
+  bool end_stream = false;
+  while (true) {
+    Api::IoCallUint64Result result = callbacks_->ioHandle().read(read_buffer, absl::nullopt);
+    if (result.ok()) {
+      if (result.return_value_ == 0) {
+        // Non-graceful shutdown by closing the underlying socket.
+        end_stream = true;
+        break;
+      }
+      bytes_read += result.return_value_;
+      if (callbacks_->shouldDrainReadBuffer()) {
+        callbacks_->setTransportSocketIsReadable();
+        break;
+      }
+      continue;
+    }
+    if (result.err_->getErrorCode() == Api::IoError::IoErrorCode::Again) {
+      break;
+    }
+    if (result.err_->getSystemErrorCode() != EIO) {
+      ENVOY_CONN_LOG(debug, "kernel TLS read error: {}", callbacks_->connection(),
+                     result.err_->getErrorDetails());
+      action = PostIoAction::Close;
+      break;
+    }
+
+    // The next record isn't application data, so it has to be read along with its type.
+    Buffer::ReservationSingleSlice reservation = read_buffer.reserveSingleSlice(16384);
+    const uint8_t* content = static_cast<const uint8_t*>(reservation.slice().mem_);
+    uint8_t record_type;
+    const Api::SysCallSizeResult record =
+        KernelTls::readRecord(callbacks_->ioHandle(), record_type,
+                              static_cast<uint8_t*>(reservation.slice().mem_),
+                              reservation.slice().len_);
+    if (record.return_value_ < 0) {
+      ENVOY_CONN_LOG(debug, "kernel TLS read error: {}", callbacks_->connection(),
+                     errorDetails(record.errno_));
+      action = PostIoAction::Close;
+      break;
+    }
+    if (record_type == KernelTls::RecordTypeApplicationData) {
+      reservation.commit(record.return_value_);
+      bytes_read += record.return_value_;
+      continue;
+    }
+    if (record_type == KernelTls::RecordTypeAlert && record.return_value_ == 2 &&
+        content[1] == SSL_AD_CLOSE_NOTIFY) {
+      // Graceful shutdown using close_notify TLS alert.
+      end_stream = true;
+      break;
+    }
+    // BoringSSL can't process the other records anymore, as it doesn't have the state of the
+    // connection.
+    failure_reason_ =
+        record_type == KernelTls::RecordTypeAlert && record.return_value_ == 2
+            ? absl::StrCat("kernel TLS: received alert ", SSL_alert_desc_string_long(content[1]))
+            : absl::StrCat("kernel TLS: unsupported record of type ", record_type);
+    ENVOY_CONN_LOG(debug, "{}", callbacks_->connection(), failure_reason_);
+    action = PostIoAction::Close;
+    break;
+  }
+
+  ENVOY_CONN_LOG(trace, "kernel TLS read {} bytes", callbacks_->connection(), bytes_read);
+  return {action, bytes_read, end_stream};
+}
+
 void SslSocket::onPrivateKeyMethodComplete() { resumeHandshake(); }
 
 void SslSocket::resumeHandshake() {
@@ -184,6 +259,12 @@ Network::Connection& SslSocket::connection() const { return callbacks_->connecti
 
 void SslSocket::onSuccess(SSL* ssl) {
   ctx_->logHandshake(ssl);
+  if (ctx_->kernelTlsEnabled()) {
+    offloadToKernel(ssl);
+    if (callbacks_->connection().state() != Network::Connection::State::Open) {
+      return;
+    }
+  }
   if (callbacks_->connection().streamInfo().upstreamInfo()) {
     callbacks_->connection()
         .streamInfo()
@@ -197,6 +278,30 @@ void SslSocket::onSuccess(SSL* ssl) {
   callbacks_->raiseEvent(Network::ConnectionEvent::Connected);
 }
 
+void SslSocket::offloadToKernel(SSL* ssl) {
+  std::string details;
+  switch (KernelTls::offload(ssl, callbacks_->ioHandle(), details)) {
+  case KernelTls::OffloadResult::Offloaded:
+    ENVOY_CONN_LOG(debug, "kernel TLS enabled", callbacks_->connection());
+    ctx_->stats().kernel_tls_offloaded_.inc();
+    kernel_tls_ = true;
+    return;
+  case KernelTls::OffloadResult::Unsupported:
+    ENVOY_CONN_LOG(debug, "kernel TLS not enabled: {}", callbacks_->connection(), details);
+    ctx_->stats().kernel_tls_unsupported_.inc();
+    return;
+  case KernelTls::OffloadResult::Failed:
+    failure_reason_ = absl::StrCat("kernel TLS: ", details);
+    ENVOY_CONN_LOG(debug, "{}", callbacks_->connection(), failure_reason_);
+    ctx_->stats().connection_error_.inc();
+    // Neither BoringSSL nor the kernel can send records on the connection anymore, so it can't
+    // even be shut down cleanly.
+    info_->setState(Ssl::SocketState::ShutdownSent);
+    callbacks_->connection().close(Network::ConnectionCloseType::NoFlush, "kernel_tls_failed");
+    return;
+  }
+}
+
 void SslSocket::onFailure() { drainErrorQueue(); }
 
 PostIoAction SslSocket::doHandshake() { return info_->doHandshake(); }
@@ -256,6 +361,10 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer, bool end_st
     }
   }
 
+  if (kernel_tls_) {
+    return kernelTlsWrite(write_buffer, end_stream);
+  }
+
   uint64_t bytes_to_write;
   if (bytes_to_retry_) {
     bytes_to_write = bytes_to_retry_;
@@ -306,6 +415,28 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer, bool end_st
   return {PostIoAction::KeepOpen, total_bytes_written, false};
 }
 
+Network::IoResult SslSocket::kernelTlsWrite(Buffer::Instance& write_buffer, bool end_stream) {
+  uint64_t bytes_written = 0;
+  while (write_buffer.length() > 0) {
+    Api::IoCallUint64Result result = callbacks_->ioHandle().write(write_buffer);
+    if (!result.ok()) {
+      if (result.err_->getErrorCode() == Api::IoError::IoErrorCode::Again) {
+        return {PostIoAction::KeepOpen, bytes_written, false};
+      }
+      ENVOY_CONN_LOG(debug, "kernel TLS write error: {}", callbacks_->connection(),
+                     result.err_->getErrorDetails());
+      return {PostIoAction::Close, bytes_written, false};
+    }
+    bytes_written += result.return_value_;
+  }
+  ENVOY_CONN_LOG(trace, "kernel TLS write {} bytes", callbacks_->connection(), bytes_written);
+
+  if (end_stream) {
+    shutdownSsl();
+  }
+  return {PostIoAction::KeepOpen, bytes_written, false};
+}
+
 void SslSocket::onConnected() { ASSERT(info_->state() == Ssl::SocketState::PreHandshake); }
 
 Ssl::ConnectionInfoConstSharedPtr SslSocket::ssl() const { return info_; }
@@ -313,7 +444,15 @@ Ssl::ConnectionInfoConstSharedPtr SslSocket::ssl() const { return info_; }
 void SslSocket::shutdownSsl() {
   ASSERT(info_->state() != Ssl::SocketState::PreHandshake);
   if (info_->state() != Ssl::SocketState::ShutdownSent &&
-      callbacks_->connection().state() != Network::Connection::State::Closed) {
+      callbacks_->connection().state() != Network::Connection::State::Closed && kernel_tls_) {
+    // The kernel holds the state of the connection, so it has to send the alert. As with
+    // SSL_shutdown(), this is best effort.
+    const Api::SysCallSizeResult result = KernelTls::sendCloseNotify(callbacks_->ioHandle());
+    ENVOY_CONN_LOG(debug, "kernel TLS shutdown: rc={}", callbacks_->connection(),
+                   result.return_value_);
+    info_->setState(Ssl::SocketState::ShutdownSent);
+  } else if (info_->state() != Ssl::SocketState::ShutdownSent &&
+             callbacks_->connection().state() != Network::Connection::State::Closed) {
     int rc = SSL_shutdown(rawSsl());
     if constexpr (Event::PlatformDefaultTriggerType == Event::FileTriggerType::EmulatedEdge) {
       // Windows operate under `EmulatedEdge`. These are level events that are artificially
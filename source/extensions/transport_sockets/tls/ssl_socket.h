@@ -84,6 +84,9 @@ private:
     absl::optional<int> error_;
   };
   ReadResult sslReadIntoSlice(Buffer::RawSlice& slice);
+  void offloadToKernel(SSL* ssl);
+  Network::IoResult kernelTlsRead(Buffer::Instance& read_buffer);
+  Network::IoResult kernelTlsWrite(Buffer::Instance& write_buffer, bool end_stream);
 
   Network::PostIoAction doHandshake();
   void drainErrorQueue();
@@ -96,6 +99,8 @@ private:
   ContextImplSharedPtr ctx_;
   uint64_t bytes_to_retry_{};
   std::string failure_reason_;
+  // Whether the kernel encrypts and decrypts the records since the handshake completed.
+  bool kernel_tls_{};
 
   SslHandshakerImplSharedPtr info_;
 };
@@ -21,7 +21,11 @@ namespace Tls {
   COUNTER(ocsp_staple_omitted)                                                                     \
   COUNTER(ocsp_staple_responses)                                                                   \
   COUNTER(ocsp_staple_requests)                                                                    \
-  COUNTER(was_key_usage_invalid)
+  COUNTER(was_key_usage_invalid)                                                                   \
+  COUNTER(kernel_tls_offloaded)                                                                    \
+  COUNTER(kernel_tls_unsupported)                                                                  \
+  COUNTER(verification_cache_hit)                                                                  \
+  COUNTER(verification_cache_miss)
 
 /**
  * Wrapper struct for SSL stats. @see stats_macros.h
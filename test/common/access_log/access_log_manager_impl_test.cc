@@ -11,6 +11,7 @@
 #include "test/test_common/test_time.h"
 #include "test/test_common/utility.h"
 
+#include "absl/synchronization/notification.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -501,6 +502,148 @@ TEST_F(AccessLogManagerImplTest, ReopenAllFiles) {
       .WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
 }
 
+class RingBufferAccessLogManagerImplTest : public AccessLogManagerImplTest {
+protected:
+  RingBufferAccessLogManagerImplTest()
+      : ring_access_log_manager_(timeout_40ms_, api_, dispatcher_, lock_, store_, 16) {}
+
+  AccessLogFileSharedPtr createRingAccessLog() {
+    EXPECT_CALL(*file_, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+    return ring_access_log_manager_.createAccessLog(
+        Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"});
+  }
+
+  AccessLogManagerImpl ring_access_log_manager_;
+};
+
+TEST_F(RingBufferAccessLogManagerImplTest, NoPerFileTimer) {
+  EXPECT_CALL(dispatcher_, createTimer_(_)).Times(0);
+  AccessLogFileSharedPtr log_file = createRingAccessLog();
+  EXPECT_NE(nullptr, log_file);
+  EXPECT_EQ(log_file, ring_access_log_manager_.createAccessLog(
+                          Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"}));
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
+TEST_F(RingBufferAccessLogManagerImplTest, FlushOnDemand) {
+  AccessLogFileSharedPtr log_file = createRingAccessLog();
+
+  std::string written;
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&](absl::string_view data) -> Api::IoCallSizeResult {
+        written.append(data.data(), data.size());
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  log_file->write("test");
+  log_file->write("test2");
+  log_file->flush();
+
+  EXPECT_EQ("testtest2", written);
+  EXPECT_EQ(2UL, store_.counter("filesystem.write_buffered").value());
+  EXPECT_EQ(0UL, store_.counter("filesystem.write_dropped").value());
+  EXPECT_EQ(0UL, store_.gauge("filesystem.write_total_buffered",
+                              Stats::Gauge::ImportMode::Accumulate)
+                     .value());
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
+TEST_F(RingBufferAccessLogManagerImplTest, FullRingDropsAndCounts) {
+  AccessLogFileSharedPtr log_file = createRingAccessLog();
+
+  // The first write to the file parks the flush thread with the ring already drained, so nothing
+  // drains the ring while it fills up.
+  absl::Notification flusher_blocked;
+  absl::Notification unblock_flusher;
+  bool first_write = true;
+  std::string written;
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&](absl::string_view data) -> Api::IoCallSizeResult {
+        if (first_write) {
+          first_write = false;
+          flusher_blocked.Notify();
+          unblock_flusher.WaitForNotification();
+        }
+        written.append(data.data(), data.size());
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  // Crosses the wake threshold of the 16 byte ring.
+  log_file->write("0123456789");
+  flusher_blocked.WaitForNotification();
+
+  log_file->write("abcdefghij");
+  log_file->write("klmnopqrst");
+  log_file->write("uvwxyz");
+  unblock_flusher.Notify();
+  log_file->flush();
+
+  EXPECT_EQ("0123456789abcdefghijuvwxyz", written);
+  EXPECT_EQ(3UL, store_.counter("filesystem.write_buffered").value());
+  EXPECT_EQ(1UL, store_.counter("filesystem.write_dropped").value());
+  EXPECT_EQ(0UL, store_.gauge("filesystem.write_total_buffered",
+                              Stats::Gauge::ImportMode::Accumulate)
+                     .value());
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
+TEST_F(RingBufferAccessLogManagerImplTest, WritesFromManyThreads) {
+  AccessLogFileSharedPtr log_file = createRingAccessLog();
+
+  absl::Mutex mutex;
+  std::string written;
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&](absl::string_view data) -> Api::IoCallSizeResult {
+        absl::MutexLock lock(&mutex);
+        written.append(data.data(), data.size());
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t i = 0; i < 4; ++i) {
+    threads.push_back(thread_factory_.createThread([&log_file]() { log_file->write("x\n"); }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  log_file->flush();
+
+  EXPECT_EQ(4UL, store_.counter("filesystem.write_buffered").value());
+  absl::MutexLock lock(&mutex);
+  EXPECT_EQ("x\nx\nx\nx\n", written);
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
+TEST_F(RingBufferAccessLogManagerImplTest, ReopenOnFlush) {
+  AccessLogFileSharedPtr log_file = createRingAccessLog();
+
+  Sequence sq;
+  EXPECT_CALL(*file_, close_())
+      .InSequence(sq)
+      .WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  EXPECT_CALL(*file_, open_(_))
+      .InSequence(sq)
+      .WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  EXPECT_CALL(*file_, write_(_))
+      .InSequence(sq)
+      .WillOnce(Invoke([](absl::string_view data) -> Api::IoCallSizeResult {
+        EXPECT_EQ(0, data.compare("after reopen"));
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  ring_access_log_manager_.reopen();
+  log_file->write("after reopen");
+  log_file->flush();
+
+  EXPECT_TRUE(file_->waitForEventCount(file_->num_opens_, 2));
+  EXPECT_CALL(*file_, close_())
+      .InSequence(sq)
+      .WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
 } // namespace
 } // namespace AccessLog
 } // namespace Envoy
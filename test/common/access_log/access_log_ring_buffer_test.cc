@@ -0,0 +1,112 @@
+#include <string>
+#include <vector>
+
+#include "source/common/access_log/access_log_ring_buffer.h"
+#include "source/common/buffer/buffer_impl.h"
+
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace AccessLog {
+namespace {
+
+TEST(AccessLogRingBufferTest, CapacityRoundedToPowerOfTwo) {
+  EXPECT_EQ(16, AccessLogRingBuffer(10).capacity());
+  EXPECT_EQ(16, AccessLogRingBuffer(16).capacity());
+  EXPECT_EQ(1, AccessLogRingBuffer(0).capacity());
+}
+
+TEST(AccessLogRingBufferTest, AppendAndDrain) {
+  AccessLogRingBuffer ring(16);
+  Buffer::OwnedImpl output;
+
+  EXPECT_EQ(0, ring.drain(output));
+  EXPECT_TRUE(ring.append("hello "));
+  EXPECT_TRUE(ring.append("world"));
+  EXPECT_EQ(11, ring.length());
+  EXPECT_EQ(11, ring.drain(output));
+  EXPECT_EQ("hello world", output.toString());
+  EXPECT_EQ(0, ring.length());
+  EXPECT_EQ(2, ring.recordsAppended());
+  EXPECT_EQ(0, ring.recordsDropped());
+}
+
+TEST(AccessLogRingBufferTest, WrapAround) {
+  AccessLogRingBuffer ring(16);
+  Buffer::OwnedImpl output;
+
+  EXPECT_TRUE(ring.append("0123456789"));
+  EXPECT_EQ(10, ring.drain(output));
+  output.drain(output.length());
+
+  // This record straddles the end of the ring.
+  EXPECT_TRUE(ring.append("abcdefghijkl"));
+  EXPECT_EQ(12, ring.drain(output));
+  EXPECT_EQ("abcdefghijkl", output.toString());
+}
+
+TEST(AccessLogRingBufferTest, FullRingDropsWholeRecord) {
+  AccessLogRingBuffer ring(8);
+  Buffer::OwnedImpl output;
+
+  EXPECT_TRUE(ring.append("12345"));
+  EXPECT_FALSE(ring.append("6789"));
+  EXPECT_TRUE(ring.append("678"));
+  EXPECT_FALSE(ring.append("9"));
+  EXPECT_EQ(2, ring.recordsAppended());
+  EXPECT_EQ(2, ring.recordsDropped());
+
+  EXPECT_EQ(8, ring.drain(output));
+  EXPECT_EQ("12345678", output.toString());
+  EXPECT_TRUE(ring.append("9"));
+}
+
+TEST(AccessLogRingBufferTest, MarkFullUntilDrained) {
+  AccessLogRingBuffer ring(8);
+  Buffer::OwnedImpl output;
+
+  EXPECT_TRUE(ring.append("12345678"));
+  EXPECT_FALSE(ring.append("9"));
+  EXPECT_TRUE(ring.markFull());
+  EXPECT_FALSE(ring.append("9"));
+  EXPECT_FALSE(ring.markFull());
+
+  EXPECT_EQ(8, ring.drain(output));
+  EXPECT_TRUE(ring.markFull());
+}
+
+TEST(AccessLogRingBufferTest, ConcurrentProducerAndConsumer) {
+  AccessLogRingBuffer ring(64);
+  constexpr uint32_t num_records = 100000;
+  std::atomic<bool> producer_done{false};
+
+  Thread::ThreadPtr producer = Thread::threadFactoryForTest().createThread([&]() {
+    for (uint32_t i = 0; i < num_records; ++i) {
+      const std::string record = absl::StrCat(i, "\n");
+      while (!ring.append(record)) {
+      }
+    }
+    producer_done = true;
+  });
+
+  Buffer::OwnedImpl output;
+  while (!producer_done || ring.length() > 0) {
+    ring.drain(output);
+  }
+  producer->join();
+
+  const std::string contents = output.toString();
+  std::vector<absl::string_view> lines = absl::StrSplit(contents, '\n', absl::SkipEmpty());
+  ASSERT_EQ(num_records, lines.size());
+  for (uint32_t i = 0; i < num_records; ++i) {
+    EXPECT_EQ(absl::StrCat(i), lines[i]);
+  }
+}
+
+} // namespace
+} // namespace AccessLog
+} // namespace Envoy
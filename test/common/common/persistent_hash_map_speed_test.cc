@@ -0,0 +1,124 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/common/common/persistent_hash_map.h"
+
+#include "test/benchmark/main.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace {
+
+// Builds a snapshotted map the way the original destination cluster did before it used
+// PersistentHashMap: each addition copies the whole map.
+using CopyOnWriteMap = absl::flat_hash_map<std::string, std::shared_ptr<int>>;
+using PersistentMap = PersistentHashMap<std::string, std::shared_ptr<int>>;
+
+std::vector<std::string> addresses(size_t count) {
+  std::vector<std::string> addresses;
+  addresses.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    addresses.push_back(absl::StrCat("10.", (i >> 16) & 0xff, ".", (i >> 8) & 0xff, ".", i & 0xff,
+                                     ":", 1024 + (i >> 24)));
+  }
+  return addresses;
+}
+
+size_t mapSize(const ::benchmark::State& state) {
+  return benchmark::skipExpensiveBenchmarks() ? std::min<size_t>(state.range(0), 1024)
+                                              : state.range(0);
+}
+
+// Adds one address to a map of the given size and publishes the result as a new snapshot, which is
+// what each new destination costs the main thread.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_CopyOnWriteAdd(::benchmark::State& state) {
+  const auto keys = addresses(mapSize(state) + 1);
+  auto map = std::make_shared<CopyOnWriteMap>();
+  for (size_t i = 0; i + 1 < keys.size(); i++) {
+    map->emplace(keys[i], std::make_shared<int>(i));
+  }
+  auto value = std::make_shared<int>(0);
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    auto new_map = std::make_shared<CopyOnWriteMap>(*map);
+    new_map->emplace(keys.back(), value);
+    std::shared_ptr<const CopyOnWriteMap> snapshot = std::move(new_map);
+    ::benchmark::DoNotOptimize(snapshot);
+  }
+}
+BENCHMARK(BM_CopyOnWriteAdd)->RangeMultiplier(8)->Range(8, 1 << 17);
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_PersistentAdd(::benchmark::State& state) {
+  const auto keys = addresses(mapSize(state) + 1);
+  PersistentMap map;
+  for (size_t i = 0; i + 1 < keys.size(); i++) {
+    map = map.insert(keys[i], std::make_shared<int>(i));
+  }
+  auto value = std::make_shared<int>(0);
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    PersistentMap snapshot = map.insert(keys.back(), value);
+    ::benchmark::DoNotOptimize(snapshot);
+  }
+}
+BENCHMARK(BM_PersistentAdd)->RangeMultiplier(8)->Range(8, 1 << 17);
+
+// Builds a map of the given size from scratch, one snapshot per addition.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_PersistentBuild(::benchmark::State& state) {
+  const auto keys = addresses(mapSize(state));
+  auto value = std::make_shared<int>(0);
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    PersistentMap map;
+    for (const auto& key : keys) {
+      map = map.insert(key, value);
+    }
+    ::benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_PersistentBuild)
+    ->RangeMultiplier(8)
+    ->Range(8, 1 << 17)
+    ->Unit(::benchmark::kMillisecond);
+
+// Looks up the addresses of a map of the given size, as the load balancers of the workers do for
+// each new connection.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_FlatHashMapFind(::benchmark::State& state) {
+  const auto keys = addresses(mapSize(state));
+  CopyOnWriteMap map;
+  for (const auto& key : keys) {
+    map.emplace(key, nullptr);
+  }
+  size_t i = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    ::benchmark::DoNotOptimize(map.find(keys[i++ % keys.size()]));
+  }
+}
+BENCHMARK(BM_FlatHashMapFind)->RangeMultiplier(8)->Range(8, 1 << 17);
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_PersistentFind(::benchmark::State& state) {
+  const auto keys = addresses(mapSize(state));
+  PersistentMap map;
+  for (const auto& key : keys) {
+    map = map.insert(key, nullptr);
+  }
+  size_t i = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    ::benchmark::DoNotOptimize(map.find(keys[i++ % keys.size()]));
+  }
+}
+BENCHMARK(BM_PersistentFind)->RangeMultiplier(8)->Range(8, 1 << 17);
+
+} // namespace
+} // namespace Envoy
@@ -0,0 +1,145 @@
+#include <string>
+#include <vector>
+
+#include "source/common/common/persistent_hash_map.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+using StringMap = PersistentHashMap<std::string, int>;
+
+absl::flat_hash_map<std::string, int> entries(const StringMap& map) {
+  absl::flat_hash_map<std::string, int> entries;
+  map.forEach([&entries](const std::string& key, int value) {
+    EXPECT_TRUE(entries.emplace(key, value).second);
+  });
+  return entries;
+}
+
+TEST(PersistentHashMapTest, Empty) {
+  StringMap map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0, map.size());
+  EXPECT_EQ(nullptr, map.find("key"));
+  EXPECT_TRUE(map.erase("key").empty());
+  EXPECT_TRUE(entries(map).empty());
+}
+
+TEST(PersistentHashMapTest, InsertFindErase) {
+  StringMap map;
+  for (int i = 0; i < 1000; i++) {
+    map = map.insert(absl::StrCat("key_", i), i);
+  }
+  EXPECT_EQ(1000, map.size());
+  for (int i = 0; i < 1000; i++) {
+    const int* value = map.find(absl::StrCat("key_", i));
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_EQ(nullptr, map.find("key_1000"));
+  EXPECT_EQ(1000, entries(map).size());
+
+  // Erasing a key which is not in the map leaves the map as is.
+  EXPECT_EQ(1000, map.erase("key_1000").size());
+
+  for (int i = 0; i < 1000; i += 2) {
+    map = map.erase(absl::StrCat("key_", i));
+  }
+  EXPECT_EQ(500, map.size());
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(i % 2 == 1, map.find(absl::StrCat("key_", i)) != nullptr);
+  }
+  for (int i = 1; i < 1000; i += 2) {
+    map = map.erase(absl::StrCat("key_", i));
+  }
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(entries(map).empty());
+}
+
+TEST(PersistentHashMapTest, InsertReplaces) {
+  StringMap map = StringMap().insert("key", 1).insert("key", 2);
+  EXPECT_EQ(1, map.size());
+  EXPECT_EQ(2, *map.find("key"));
+}
+
+// The maps derived from a map do not change it.
+TEST(PersistentHashMapTest, Snapshots) {
+  std::vector<StringMap> snapshots{StringMap()};
+  for (int i = 0; i < 300; i++) {
+    snapshots.push_back(snapshots.back().insert(absl::StrCat("key_", i), i));
+  }
+  const StringMap replaced = snapshots.back().insert("key_0", -1);
+  const StringMap erased = snapshots.back().erase("key_1");
+
+  for (size_t i = 0; i < snapshots.size(); i++) {
+    EXPECT_EQ(i, snapshots[i].size());
+    for (size_t j = 0; j < 300; j++) {
+      const int* value = snapshots[i].find(absl::StrCat("key_", j));
+      if (j < i) {
+        ASSERT_NE(nullptr, value);
+        EXPECT_EQ(j, *value);
+      } else {
+        EXPECT_EQ(nullptr, value);
+      }
+    }
+  }
+  EXPECT_EQ(-1, *replaced.find("key_0"));
+  EXPECT_EQ(0, *erased.find("key_0"));
+  EXPECT_EQ(nullptr, erased.find("key_1"));
+  EXPECT_EQ(1, *replaced.find("key_1"));
+}
+
+// Maps all the keys to few hashes, so that keys share trie levels and leaves.
+struct CollidingHash {
+  size_t operator()(const std::string& key) const { return absl::Hash<std::string>()(key) % 3; }
+};
+
+// Maps all the keys to hashes which only differ in their last trie level.
+struct DeepHash {
+  size_t operator()(const std::string& key) const {
+    return (absl::Hash<std::string>()(key) % 4) << (std::numeric_limits<size_t>::digits - 2);
+  }
+};
+
+template <class Hash> void testAgainstFlatHashMap() {
+  PersistentHashMap<std::string, int, Hash> map;
+  absl::flat_hash_map<std::string, int> expected;
+  for (int i = 0; i < 2000; i++) {
+    const std::string key = absl::StrCat("key_", (i * 7919) % 97);
+    if (i % 3 == 0) {
+      map = map.erase(key);
+      expected.erase(key);
+    } else {
+      map = map.insert(key, i);
+      expected[key] = i;
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+  absl::flat_hash_map<std::string, int> actual;
+  map.forEach([&actual](const std::string& key, int value) { actual[key] = value; });
+  EXPECT_EQ(expected, actual);
+  for (int i = 0; i < 97; i++) {
+    const std::string key = absl::StrCat("key_", i);
+    const int* value = map.find(key);
+    auto it = expected.find(key);
+    if (it == expected.end()) {
+      EXPECT_EQ(nullptr, value);
+    } else {
+      ASSERT_NE(nullptr, value);
+      EXPECT_EQ(it->second, *value);
+    }
+  }
+}
+
+TEST(PersistentHashMapTest, RandomOperations) { testAgainstFlatHashMap<absl::Hash<std::string>>(); }
+
+TEST(PersistentHashMapTest, HashCollisions) { testAgainstFlatHashMap<CollidingHash>(); }
+
+TEST(PersistentHashMapTest, DeepTrie) { testAgainstFlatHashMap<DeepHash>(); }
+
+} // namespace
+} // namespace Envoy
@@ -0,0 +1,78 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "source/common/common/sharded_counter.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace {
+
+// Each thread starts and finishes a request, as workers do with the active request count of a
+// host or cluster.
+static std::atomic<uint64_t> atomic_count;
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_AtomicCounter(benchmark::State& state) {
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    atomic_count.fetch_add(1);
+    atomic_count.fetch_sub(1);
+  }
+}
+BENCHMARK(BM_AtomicCounter)->ThreadRange(1, 64)->UseRealTime();
+
+static ShardedCounter sharded_count(ShardedCounter::NumShards);
+static std::atomic<int64_t> sharded_aggregate;
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_ShardedCounter(benchmark::State& state) {
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    int64_t flushed = sharded_count.add(1);
+    if (flushed != 0) {
+      sharded_aggregate.fetch_add(flushed);
+    }
+    flushed = sharded_count.add(-1);
+    if (flushed != 0) {
+      sharded_aggregate.fetch_add(flushed);
+    }
+  }
+}
+BENCHMARK(BM_ShardedCounter)->ThreadRange(1, 64)->UseRealTime();
+
+// Threads which hold several requests at a time cross the flush threshold regularly.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_ShardedCounterWithFlushes(benchmark::State& state) {
+  constexpr int64_t Burst = 2 * ShardedCounter::NumShards;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    for (int64_t i = 0; i < Burst; i++) {
+      sharded_aggregate.fetch_add(sharded_count.add(1));
+    }
+    for (int64_t i = 0; i < Burst; i++) {
+      sharded_aggregate.fetch_add(sharded_count.add(-1));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * Burst * 2);
+}
+BENCHMARK(BM_ShardedCounterWithFlushes)->ThreadRange(1, 64)->UseRealTime();
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_AtomicCounterBurst(benchmark::State& state) {
+  constexpr int64_t Burst = 2 * ShardedCounter::NumShards;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    for (int64_t i = 0; i < Burst; i++) {
+      atomic_count.fetch_add(1);
+    }
+    for (int64_t i = 0; i < Burst; i++) {
+      atomic_count.fetch_sub(1);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * Burst * 2);
+}
+BENCHMARK(BM_AtomicCounterBurst)->ThreadRange(1, 64)->UseRealTime();
+
+} // namespace
+} // namespace Envoy
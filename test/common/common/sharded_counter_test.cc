@@ -0,0 +1,74 @@
+#include <atomic>
+#include <vector>
+
+#include "source/common/common/sharded_counter.h"
+
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+TEST(ShardedCounterTest, FlushesAtThreshold) {
+  ShardedCounter counter(4);
+  EXPECT_EQ(4U, counter.flushThreshold());
+  EXPECT_EQ(ShardedCounter::NumShards * 3, counter.maxError());
+
+  EXPECT_EQ(0, counter.add(1));
+  EXPECT_EQ(0, counter.add(2));
+  EXPECT_EQ(3, counter.pending());
+  EXPECT_EQ(4, counter.add(1));
+  EXPECT_EQ(0, counter.pending());
+
+  EXPECT_EQ(0, counter.add(-3));
+  EXPECT_EQ(-3, counter.pending());
+  EXPECT_EQ(-5, counter.add(-2));
+  EXPECT_EQ(0, counter.pending());
+
+  // A single delta at or above the threshold is flushed right away.
+  EXPECT_EQ(10, counter.add(10));
+}
+
+TEST(ShardedCounterTest, ThresholdOfOneFlushesEveryUpdate) {
+  ShardedCounter counter(0);
+  EXPECT_EQ(1U, counter.flushThreshold());
+  EXPECT_EQ(0U, counter.maxError());
+  EXPECT_EQ(1, counter.add(1));
+  EXPECT_EQ(-1, counter.add(-1));
+  EXPECT_EQ(0, counter.add(0));
+}
+
+// The flushed deltas plus the pending deltas always add up to the exact value, and the aggregate
+// never goes negative when each thread only removes what it added.
+TEST(ShardedCounterTest, ConcurrentUpdates) {
+  constexpr int NumThreads = 2 * ShardedCounter::NumShards;
+  constexpr int Iterations = 10000;
+  ShardedCounter counter(8);
+  std::atomic<int64_t> aggregate{0};
+  std::atomic<bool> went_negative{false};
+
+  std::vector<Thread::ThreadPtr> threads;
+  for (int i = 0; i < NumThreads; i++) {
+    threads.push_back(Thread::threadFactoryForTest().createThread([&]() {
+      for (int j = 0; j < Iterations; j++) {
+        aggregate += counter.add(1);
+        aggregate += counter.add(1);
+        if (aggregate.load() < 0) {
+          went_negative = true;
+        }
+        aggregate += counter.add(-1);
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+
+  EXPECT_FALSE(went_negative);
+  EXPECT_EQ(NumThreads * Iterations, aggregate.load() + counter.pending());
+  EXPECT_LE(static_cast<uint64_t>(NumThreads * Iterations - aggregate.load()), counter.maxError());
+}
+
+} // namespace
+} // namespace Envoy
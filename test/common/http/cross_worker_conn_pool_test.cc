@@ -0,0 +1,286 @@
+#include <memory>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/http/cross_worker_conn_pool.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/conn_pool.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/http/stream_decoder.h"
+#include "test/mocks/http/stream_encoder.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/mocks/upstream/host.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+// Runs both workers of a handed off stream on the test thread: the client worker which creates the
+// stream and the owner worker which owns the connections.
+class CrossWorkerConnPoolTest : public testing::Test {
+public:
+  CrossWorkerConnPoolTest()
+      : api_(Api::createApiForTest()), client_dispatcher_(api_->allocateDispatcher("client")),
+        owner_dispatcher_(api_->allocateDispatcher("owner")),
+        pool_(std::make_unique<CrossWorkerConnPool>(*client_dispatcher_, *owner_dispatcher_, host_,
+                                                    [this]() -> ConnectionPool::Instance* {
+                                                      return owner_pool_available_ ? &owner_pool_
+                                                                                   : nullptr;
+                                                    })) {}
+
+  ~CrossWorkerConnPoolTest() override {
+    // Lets the owner release the streams still active at the end of a test.
+    pool_.reset();
+    runOwner();
+    runClient();
+  }
+
+  void runOwner() { owner_dispatcher_->run(Event::Dispatcher::RunType::NonBlock); }
+  void runClient() { client_dispatcher_->run(Event::Dispatcher::RunType::NonBlock); }
+
+  // Creates a stream and makes it pending in the pool of the owner.
+  ConnectionPool::Cancellable* newPendingStream() {
+    EXPECT_CALL(owner_pool_, newStream(_, _, _))
+        .WillOnce(Invoke([this](ResponseDecoder& decoder, ConnectionPool::Callbacks& callbacks,
+                                const ConnectionPool::Instance::StreamOptions&) {
+          owner_decoder_ = &decoder;
+          owner_callbacks_ = &callbacks;
+          return &owner_cancellable_;
+        }));
+    ConnectionPool::Cancellable* handle =
+        pool_->newStream(client_decoder_, client_callbacks_, {false, true});
+    EXPECT_NE(nullptr, handle);
+    EXPECT_FALSE(pool_->isIdle());
+    runOwner();
+    return handle;
+  }
+
+  // Creates a stream and makes it ready on both workers.
+  void newReadyStream() {
+    newPendingStream();
+    owner_callbacks_->onPoolReady(owner_encoder_, host_, owner_info_, Protocol::Http2);
+    EXPECT_CALL(client_callbacks_, onPoolReady(_, _, _, _))
+        .WillOnce(Invoke([this](RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr,
+                                StreamInfo::StreamInfo&, absl::optional<Protocol> protocol) {
+          client_encoder_ = &encoder;
+          EXPECT_EQ(Protocol::Http2, protocol);
+        }));
+    runClient();
+    ASSERT_NE(nullptr, client_encoder_);
+  }
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr client_dispatcher_;
+  Event::DispatcherPtr owner_dispatcher_;
+  std::shared_ptr<NiceMock<Upstream::MockHost>> host_{
+      std::make_shared<NiceMock<Upstream::MockHost>>()};
+  NiceMock<ConnectionPool::MockInstance> owner_pool_;
+  bool owner_pool_available_{true};
+  std::unique_ptr<CrossWorkerConnPool> pool_;
+
+  NiceMock<MockResponseDecoder> client_decoder_;
+  ConnectionPool::MockCallbacks client_callbacks_;
+  RequestEncoder* client_encoder_{};
+
+  NiceMock<Envoy::ConnectionPool::MockCancellable> owner_cancellable_;
+  NiceMock<MockRequestEncoder> owner_encoder_;
+  NiceMock<StreamInfo::MockStreamInfo> owner_info_;
+  ResponseDecoder* owner_decoder_{};
+  ConnectionPool::Callbacks* owner_callbacks_{};
+};
+
+TEST_F(CrossWorkerConnPoolTest, RequestAndResponse) {
+  newReadyStream();
+
+  TestRequestHeaderMapImpl request_headers{
+      {":method", "POST"}, {":path", "/"}, {":authority", "host"}, {":scheme", "http"}};
+  EXPECT_TRUE(client_encoder_->encodeHeaders(request_headers, false).ok());
+  Buffer::OwnedImpl request_body("request");
+  client_encoder_->encodeData(request_body, true);
+  EXPECT_EQ(0, request_body.length());
+
+  EXPECT_CALL(owner_encoder_, encodeHeaders(HeaderMapEqualRef(&request_headers), false));
+  EXPECT_CALL(owner_encoder_, encodeData(BufferStringEqual("request"), true));
+  runOwner();
+
+  owner_decoder_->decodeHeaders(ResponseHeaderMapPtr{new TestResponseHeaderMapImpl{
+                                    {":status", "200"}}},
+                                false);
+  Buffer::OwnedImpl response_body("response");
+  owner_decoder_->decodeData(response_body, true);
+  // The owner is done with the stream of its pool.
+  EXPECT_EQ(nullptr, owner_encoder_.stream_.callbacks_[0]);
+
+  EXPECT_CALL(client_decoder_, decodeHeaders_(_, false));
+  EXPECT_CALL(client_decoder_, decodeData(BufferStringEqual("response"), true));
+  runClient();
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(CrossWorkerConnPoolTest, ResponseBeforeRequestEnds) {
+  newReadyStream();
+
+  TestRequestHeaderMapImpl request_headers{
+      {":method", "POST"}, {":path", "/"}, {":authority", "host"}, {":scheme", "http"}};
+  EXPECT_TRUE(client_encoder_->encodeHeaders(request_headers, false).ok());
+  runOwner();
+
+  owner_decoder_->decodeHeaders(ResponseHeaderMapPtr{new TestResponseHeaderMapImpl{
+                                    {":status", "200"}}},
+                                true);
+  EXPECT_CALL(client_decoder_, decodeHeaders_(_, true));
+  runClient();
+  // The request has not ended yet.
+  EXPECT_FALSE(pool_->isIdle());
+
+  Buffer::OwnedImpl request_body("request");
+  client_encoder_->encodeData(request_body, true);
+  EXPECT_TRUE(pool_->isIdle());
+  EXPECT_CALL(owner_encoder_, encodeData(BufferStringEqual("request"), true));
+  runOwner();
+}
+
+TEST_F(CrossWorkerConnPoolTest, InvalidRequestHeaders) {
+  newReadyStream();
+
+  // No :method.
+  TestRequestHeaderMapImpl request_headers{{":path", "/"}, {":authority", "host"}};
+  EXPECT_FALSE(client_encoder_->encodeHeaders(request_headers, true).ok());
+  EXPECT_CALL(owner_encoder_, encodeHeaders(_, _)).Times(0);
+  runOwner();
+}
+
+TEST_F(CrossWorkerConnPoolTest, PoolFailure) {
+  newPendingStream();
+
+  owner_callbacks_->onPoolFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure,
+                                  "connection refused", host_);
+  EXPECT_CALL(client_callbacks_,
+              onPoolFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure,
+                            "connection refused", _));
+  runClient();
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(CrossWorkerConnPoolTest, NoPoolOnOwner) {
+  owner_pool_available_ = false;
+  EXPECT_NE(nullptr, pool_->newStream(client_decoder_, client_callbacks_, {false, true}));
+  runOwner();
+
+  EXPECT_CALL(client_callbacks_,
+              onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure, _, _));
+  runClient();
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(CrossWorkerConnPoolTest, CancelPending) {
+  ConnectionPool::Cancellable* handle = newPendingStream();
+
+  handle->cancel(Envoy::ConnectionPool::CancelPolicy::CloseExcess);
+  EXPECT_TRUE(pool_->isIdle());
+  EXPECT_CALL(owner_cancellable_, cancel(Envoy::ConnectionPool::CancelPolicy::CloseExcess));
+  runOwner();
+}
+
+TEST_F(CrossWorkerConnPoolTest, CancelBeforeStartOnOwner) {
+  ConnectionPool::Cancellable* handle =
+      pool_->newStream(client_decoder_, client_callbacks_, {false, true});
+  EXPECT_CALL(owner_pool_, newStream(_, _, _)).WillOnce(Return(&owner_cancellable_));
+  handle->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+  EXPECT_CALL(owner_cancellable_, cancel(Envoy::ConnectionPool::CancelPolicy::Default));
+  runOwner();
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(CrossWorkerConnPoolTest, CancelAfterReadyOnOwner) {
+  ConnectionPool::Cancellable* handle = newPendingStream();
+
+  // The owner's pool becomes ready while the cancellation is in flight.
+  owner_callbacks_->onPoolReady(owner_encoder_, host_, owner_info_, Protocol::Http2);
+  handle->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+  EXPECT_TRUE(pool_->isIdle());
+
+  EXPECT_CALL(owner_cancellable_, cancel(_)).Times(0);
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runOwner();
+  // Nothing is delivered to the client after canceling.
+  EXPECT_CALL(client_callbacks_, onPoolReady(_, _, _, _)).Times(0);
+  runClient();
+}
+
+TEST_F(CrossWorkerConnPoolTest, ClientReset) {
+  newReadyStream();
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  client_encoder_->getStream().addCallbacks(stream_callbacks);
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::LocalReset, _));
+  client_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  EXPECT_TRUE(pool_->isIdle());
+
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runOwner();
+}
+
+TEST_F(CrossWorkerConnPoolTest, OwnerReset) {
+  newReadyStream();
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  client_encoder_->getStream().addCallbacks(stream_callbacks);
+  owner_encoder_.stream_.resetStream(StreamResetReason::RemoteReset);
+
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::RemoteReset, _));
+  runClient();
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(CrossWorkerConnPoolTest, Watermarks) {
+  newReadyStream();
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  client_encoder_->getStream().addCallbacks(stream_callbacks);
+  owner_encoder_.stream_.runHighWatermarkCallbacks();
+  owner_encoder_.stream_.runLowWatermarkCallbacks();
+
+  testing::InSequence s;
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark());
+  runClient();
+
+  client_encoder_->getStream().readDisable(true);
+  EXPECT_CALL(owner_encoder_.stream_, readDisable(true));
+  runOwner();
+}
+
+TEST_F(CrossWorkerConnPoolTest, IdleOnceDrainedStreamsComplete) {
+  newReadyStream();
+
+  ReadyWatcher idle;
+  pool_->addIdleCallback([&]() { idle.ready(); });
+  pool_->drainConnections(Envoy::ConnectionPool::DrainBehavior::DrainExistingConnections);
+  pool_->drainConnections(Envoy::ConnectionPool::DrainBehavior::DrainAndDelete);
+
+  EXPECT_CALL(idle, ready());
+  client_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  runOwner();
+}
+
+TEST_F(CrossWorkerConnPoolTest, DestroyedWithActiveStream) {
+  newReadyStream();
+
+  pool_.reset();
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runOwner();
+}
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
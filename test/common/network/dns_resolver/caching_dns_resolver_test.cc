@@ -0,0 +1,302 @@
+#include <chrono>
+#include <list>
+#include <memory>
+
+#include "envoy/config/core/v3/extension.pb.h"
+
+#include "source/common/api/api_impl.h"
+#include "source/common/network/address_impl.h"
+#include "source/common/network/dns_resolver/caching_dns_resolver.h"
+#include "source/common/singleton/manager_impl.h"
+#include "source/common/stats/isolated_store_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/thread_factory_for_test.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::Return;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+class CachingDnsResolverTest : public testing::Test {
+public:
+  CachingDnsResolverTest()
+      : api_(Api::createApiForTest(stats_store_, time_system_)),
+        dispatcher_(api_->allocateDispatcher("test_thread")),
+        wrapped_(std::make_shared<MockDnsResolver>()),
+        resolver_(std::make_unique<CachingDnsResolver>(wrapped_, *dispatcher_,
+                                                       *stats_store_.rootScope(), "test")) {}
+
+  std::list<DnsResponse> responses(std::chrono::seconds ttl) {
+    std::list<DnsResponse> responses;
+    responses.emplace_back(std::make_shared<Address::Ipv4Instance>("10.0.0.1"), ttl);
+    responses.emplace_back(std::make_shared<Address::Ipv4Instance>("10.0.0.2"), ttl + ttl);
+    return responses;
+  }
+
+  // Expects a resolution of the wrapped resolver and saves its callback to resolve_cb_.
+  void expectResolve(const std::string& name = "foo.com",
+                     DnsLookupFamily family = DnsLookupFamily::V4Only) {
+    EXPECT_CALL(*wrapped_, resolve(name, family, _))
+        .WillOnce(DoAll(SaveArg<2>(&resolve_cb_), Return(&wrapped_->active_query_)));
+  }
+
+  uint64_t counter(const std::string& name) {
+    return TestUtility::findCounter(stats_store_, "dns_resolution_cache.test." + name)->value();
+  }
+
+  uint64_t cachedNames() {
+    return TestUtility::findGauge(stats_store_, "dns_resolution_cache.test.cached_names")->value();
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  Stats::IsolatedStoreImpl stats_store_;
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  std::shared_ptr<MockDnsResolver> wrapped_;
+  std::unique_ptr<CachingDnsResolver> resolver_;
+  DnsResolver::ResolveCb resolve_cb_;
+};
+
+// Successful resolutions are served from the cache until the smallest TTL expires, with the TTL
+// of the responses set to the time left.
+TEST_F(CachingDnsResolverTest, CachesUntilTtlExpiry) {
+  expectResolve();
+  std::list<DnsResponse> first;
+  EXPECT_NE(nullptr, resolver_->resolve("foo.com", DnsLookupFamily::V4Only,
+                                        [&](DnsResolver::ResolutionStatus status,
+                                            std::list<DnsResponse>&& response) {
+                                          EXPECT_EQ(DnsResolver::ResolutionStatus::Success,
+                                                    status);
+                                          first = std::move(response);
+                                        }));
+  resolve_cb_(DnsResolver::ResolutionStatus::Success, responses(std::chrono::seconds(30)));
+  ASSERT_EQ(2, first.size());
+  EXPECT_EQ(std::chrono::seconds(30), first.front().addrInfo().ttl_);
+  EXPECT_EQ(1, counter("miss"));
+  EXPECT_EQ(1, cachedNames());
+
+  time_system_.advanceTimeWait(std::chrono::seconds(10));
+  std::list<DnsResponse> second;
+  EXPECT_EQ(nullptr, resolver_->resolve("foo.com", DnsLookupFamily::V4Only,
+                                        [&](DnsResolver::ResolutionStatus status,
+                                            std::list<DnsResponse>&& response) {
+                                          EXPECT_EQ(DnsResolver::ResolutionStatus::Success,
+                                                    status);
+                                          second = std::move(response);
+                                        }));
+  ASSERT_EQ(2, second.size());
+  EXPECT_EQ("10.0.0.1:0", second.front().addrInfo().address_->asString());
+  EXPECT_EQ(std::chrono::seconds(20), second.front().addrInfo().ttl_);
+  EXPECT_EQ(std::chrono::seconds(20), second.back().addrInfo().ttl_);
+  EXPECT_EQ(1, counter("hit"));
+
+  // A different lookup family is a different entry.
+  expectResolve("foo.com", DnsLookupFamily::V6Only);
+  resolver_->resolve("foo.com", DnsLookupFamily::V6Only,
+                     [](DnsResolver::ResolutionStatus, std::list<DnsResponse>&&) {});
+  EXPECT_EQ(2, counter("miss"));
+  resolve_cb_(DnsResolver::ResolutionStatus::Success, {});
+
+  time_system_.advanceTimeWait(std::chrono::seconds(20));
+  expectResolve();
+  EXPECT_NE(nullptr, resolver_->resolve("foo.com", DnsLookupFamily::V4Only,
+                                        [](DnsResolver::ResolutionStatus,
+                                           std::list<DnsResponse>&&) {}));
+  EXPECT_EQ(3, counter("miss"));
+  EXPECT_EQ(1, counter("hit"));
+}
+
+// Concurrent resolutions of the same name share a single query of the wrapped resolver.
+TEST_F(CachingDnsResolverTest, CoalescesConcurrentResolutions) {
+  expectResolve();
+  uint32_t completed = 0;
+  auto callback = [&](DnsResolver::ResolutionStatus status, std::list<DnsResponse>&& response) {
+    EXPECT_EQ(DnsResolver::ResolutionStatus::Success, status);
+    EXPECT_EQ(2, response.size());
+    completed++;
+  };
+  EXPECT_NE(nullptr, resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback));
+  EXPECT_NE(nullptr, resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback));
+  EXPECT_NE(nullptr, resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback));
+  EXPECT_EQ(1, counter("miss"));
+  EXPECT_EQ(2, counter("coalesced"));
+
+  resolve_cb_(DnsResolver::ResolutionStatus::Success, responses(std::chrono::seconds(30)));
+  EXPECT_EQ(3, completed);
+}
+
+// Failures and responses without TTL are not cached.
+TEST_F(CachingDnsResolverTest, DoesNotCacheFailuresOrZeroTtl) {
+  expectResolve();
+  DnsResolver::ResolutionStatus result = DnsResolver::ResolutionStatus::Success;
+  auto callback = [&](DnsResolver::ResolutionStatus status, std::list<DnsResponse>&&) {
+    result = status;
+  };
+  resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback);
+  resolve_cb_(DnsResolver::ResolutionStatus::Failure, {});
+  EXPECT_EQ(DnsResolver::ResolutionStatus::Failure, result);
+  EXPECT_EQ(0, cachedNames());
+
+  expectResolve();
+  resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback);
+  resolve_cb_(DnsResolver::ResolutionStatus::Success, responses(std::chrono::seconds(0)));
+  EXPECT_EQ(DnsResolver::ResolutionStatus::Success, result);
+  EXPECT_EQ(0, cachedNames());
+
+  expectResolve();
+  resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback);
+  EXPECT_EQ(3, counter("miss"));
+  EXPECT_EQ(0, counter("hit"));
+  EXPECT_CALL(wrapped_->active_query_, cancel(ActiveDnsQuery::CancelReason::QueryAbandoned));
+  resolver_.reset();
+}
+
+// The query of the wrapped resolver is only cancelled once all the callers cancelled.
+TEST_F(CachingDnsResolverTest, Cancel) {
+  expectResolve();
+  uint32_t completed = 0;
+  auto callback = [&](DnsResolver::ResolutionStatus, std::list<DnsResponse>&&) { completed++; };
+  ActiveDnsQuery* first = resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback);
+  ActiveDnsQuery* second = resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback);
+
+  EXPECT_CALL(wrapped_->active_query_, cancel(_)).Times(0);
+  first->cancel(ActiveDnsQuery::CancelReason::Timeout);
+  testing::Mock::VerifyAndClearExpectations(&wrapped_->active_query_);
+
+  EXPECT_CALL(wrapped_->active_query_, cancel(ActiveDnsQuery::CancelReason::Timeout));
+  second->cancel(ActiveDnsQuery::CancelReason::Timeout);
+  EXPECT_EQ(0, completed);
+
+  // The next resolution starts a new query.
+  expectResolve();
+  ActiveDnsQuery* third = resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback);
+  EXPECT_NE(nullptr, third);
+  resolve_cb_(DnsResolver::ResolutionStatus::Success, responses(std::chrono::seconds(30)));
+  EXPECT_EQ(1, completed);
+}
+
+// A caller may cancel the resolution of another caller from its callback.
+TEST_F(CachingDnsResolverTest, CancelFromCallback) {
+  expectResolve();
+  ActiveDnsQuery* second = nullptr;
+  bool second_completed = false;
+  resolver_->resolve("foo.com", DnsLookupFamily::V4Only,
+                     [&](DnsResolver::ResolutionStatus, std::list<DnsResponse>&&) {
+                       second->cancel(ActiveDnsQuery::CancelReason::QueryAbandoned);
+                     });
+  second = resolver_->resolve(
+      "foo.com", DnsLookupFamily::V4Only,
+      [&](DnsResolver::ResolutionStatus, std::list<DnsResponse>&&) { second_completed = true; });
+
+  EXPECT_CALL(wrapped_->active_query_, cancel(_)).Times(0);
+  resolve_cb_(DnsResolver::ResolutionStatus::Success, responses(std::chrono::seconds(30)));
+  EXPECT_FALSE(second_completed);
+}
+
+// Resolutions completed inline by the wrapped resolver complete inline.
+TEST_F(CachingDnsResolverTest, InlineCompletion) {
+  EXPECT_CALL(*wrapped_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(Invoke([this](const std::string&, DnsLookupFamily,
+                              DnsResolver::ResolveCb callback) -> ActiveDnsQuery* {
+        callback(DnsResolver::ResolutionStatus::Success, responses(std::chrono::seconds(30)));
+        return nullptr;
+      }));
+  uint32_t completed = 0;
+  auto callback = [&](DnsResolver::ResolutionStatus status, std::list<DnsResponse>&& response) {
+    EXPECT_EQ(DnsResolver::ResolutionStatus::Success, status);
+    EXPECT_EQ(2, response.size());
+    completed++;
+  };
+  EXPECT_EQ(nullptr, resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback));
+  EXPECT_EQ(nullptr, resolver_->resolve("foo.com", DnsLookupFamily::V4Only, callback));
+  EXPECT_EQ(2, completed);
+  EXPECT_EQ(1, counter("hit"));
+}
+
+// Resetting the networking drops the cached responses.
+TEST_F(CachingDnsResolverTest, ResetNetworking) {
+  expectResolve();
+  resolver_->resolve("foo.com", DnsLookupFamily::V4Only,
+                     [](DnsResolver::ResolutionStatus, std::list<DnsResponse>&&) {});
+  resolve_cb_(DnsResolver::ResolutionStatus::Success, responses(std::chrono::seconds(30)));
+  EXPECT_EQ(1, cachedNames());
+
+  EXPECT_CALL(*wrapped_, resetNetworking());
+  resolver_->resetNetworking();
+  EXPECT_EQ(0, cachedNames());
+
+  expectResolve();
+  EXPECT_NE(nullptr, resolver_->resolve("foo.com", DnsLookupFamily::V4Only,
+                                        [](DnsResolver::ResolutionStatus,
+                                           std::list<DnsResponse>&&) {}));
+  EXPECT_EQ(2, counter("miss"));
+}
+
+// Expired entries are periodically removed from the cache.
+TEST_F(CachingDnsResolverTest, PurgeExpired) {
+  expectResolve();
+  resolver_->resolve("foo.com", DnsLookupFamily::V4Only,
+                     [](DnsResolver::ResolutionStatus, std::list<DnsResponse>&&) {});
+  resolve_cb_(DnsResolver::ResolutionStatus::Success, responses(std::chrono::seconds(30)));
+  EXPECT_EQ(1, cachedNames());
+
+  time_system_.advanceTimeAndRun(CachingDnsResolver::PurgeInterval, *dispatcher_,
+                                 Event::Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(0, cachedNames());
+}
+
+// The caching resolvers are shared per resolver configuration for as long as they are used.
+TEST_F(CachingDnsResolverTest, SharedPerResolverConfig) {
+  Singleton::ManagerImpl singleton_manager{Thread::threadFactoryForTest()};
+  EXPECT_EQ(nullptr, SharedCachingDnsResolvers::find(singleton_manager));
+  SharedCachingDnsResolversSharedPtr shared = SharedCachingDnsResolvers::create(singleton_manager);
+  EXPECT_EQ(shared, SharedCachingDnsResolvers::find(singleton_manager));
+
+  uint32_t created = 0;
+  auto create_resolver = [&]() -> DnsResolverSharedPtr {
+    created++;
+    return std::make_shared<MockDnsResolver>();
+  };
+  envoy::config::core::v3::TypedExtensionConfig config;
+  config.set_name("envoy.network.dns_resolver.cares");
+
+  DnsResolverSharedPtr default_resolver =
+      shared->get(*dispatcher_, *stats_store_.rootScope(), nullptr, create_resolver);
+  EXPECT_EQ(default_resolver,
+            shared->get(*dispatcher_, *stats_store_.rootScope(), nullptr, create_resolver));
+  DnsResolverSharedPtr custom_resolver =
+      shared->get(*dispatcher_, *stats_store_.rootScope(), &config, create_resolver);
+  EXPECT_NE(default_resolver, custom_resolver);
+  EXPECT_EQ(custom_resolver,
+            shared->get(*dispatcher_, *stats_store_.rootScope(), &config, create_resolver));
+  EXPECT_EQ(2, created);
+
+  // Each resolver has its own stats, so that the caches of different resolvers do not merge.
+  EXPECT_NE(nullptr,
+            TestUtility::findGauge(stats_store_, "dns_resolution_cache.default.cached_names"));
+  const std::string custom_name = absl::StrCat(MessageUtil::hash(config));
+  EXPECT_NE(nullptr, TestUtility::findGauge(
+                         stats_store_, "dns_resolution_cache." + custom_name + ".cached_names"));
+  EXPECT_EQ(nullptr, TestUtility::findGauge(stats_store_, "dns_resolution_cache.cached_names"));
+
+  default_resolver.reset();
+  default_resolver = shared->get(*dispatcher_, *stats_store_.rootScope(), nullptr, create_resolver);
+  EXPECT_EQ(3, created);
+
+  shared.reset();
+  EXPECT_EQ(nullptr, SharedCachingDnsResolvers::find(singleton_manager));
+}
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
@@ -5011,6 +5011,109 @@ TEST_F(RouterTest, UpstreamTimingSingleRequest) {
             std::chrono::milliseconds(32));
 }
 
+class TestResponseTimeObserver : public Upstream::ResponseTimeObserver {
+public:
+  void onResponseTime(const Upstream::HostDescription& host,
+                      std::chrono::microseconds response_time) override {
+    host_ = &host;
+    response_times_.push_back(response_time);
+  }
+  void onRequestFailure(const Upstream::HostDescription& host,
+                        std::chrono::microseconds elapsed) override {
+    host_ = &host;
+    failures_.push_back(elapsed);
+  }
+
+  const Upstream::HostDescription* host_{};
+  std::vector<std::chrono::microseconds> response_times_;
+  std::vector<std::chrono::microseconds> failures_;
+};
+
+// Verify that the response time observer installed by the load balancer is told how long the
+// upstream took to respond.
+TEST_F(RouterTest, ResponseTimeObserver) {
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder, &response_decoder, Http::Protocol::Http10);
+  expectResponseTimerCreate();
+
+  auto observer = std::make_shared<TestResponseTimeObserver>();
+  router_->setResponseTimeObserver(observer);
+
+  Http::TestRequestHeaderMapImpl headers{};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_->decodeHeaders(headers, false);
+  test_time_.advanceTimeWait(std::chrono::milliseconds(32));
+  Buffer::OwnedImpl data;
+  router_->decodeData(data, true);
+
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  // NOLINTNEXTLINE(clang-analyzer-core.CallAndMessage)
+  response_decoder->decodeHeaders(std::move(response_headers), false);
+  test_time_.advanceTimeWait(std::chrono::milliseconds(43));
+  EXPECT_TRUE(observer->response_times_.empty());
+
+  response_decoder->decodeData(data, true);
+  ASSERT_EQ(1, observer->response_times_.size());
+  EXPECT_EQ(std::chrono::milliseconds(75), observer->response_times_[0]);
+  EXPECT_TRUE(observer->failures_.empty());
+  EXPECT_EQ(cm_.thread_local_cluster_.conn_pool_.host_.get(), observer->host_);
+}
+
+// Verify that the response time observer is told about a request that timed out, with the time
+// until the timeout.
+TEST_F(RouterTest, ResponseTimeObserverTimeout) {
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder, &response_decoder, Http::Protocol::Http10);
+  expectResponseTimerCreate();
+
+  auto observer = std::make_shared<TestResponseTimeObserver>();
+  router_->setResponseTimeObserver(observer);
+
+  Http::TestRequestHeaderMapImpl headers{};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_->decodeHeaders(headers, false);
+  Buffer::OwnedImpl data;
+  router_->decodeData(data, true);
+  test_time_.advanceTimeWait(std::chrono::milliseconds(40));
+
+  EXPECT_CALL(encoder.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(callbacks_, encodeData(_, true));
+  response_timeout_->invokeCallback();
+
+  EXPECT_TRUE(observer->response_times_.empty());
+  ASSERT_EQ(1, observer->failures_.size());
+  EXPECT_EQ(std::chrono::milliseconds(40), observer->failures_[0]);
+  EXPECT_EQ(cm_.thread_local_cluster_.conn_pool_.host_.get(), observer->host_);
+}
+
+// Verify that the response time observer is told about a request reset by the upstream.
+TEST_F(RouterTest, ResponseTimeObserverReset) {
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder, &response_decoder, Http::Protocol::Http10);
+  expectResponseTimerCreate();
+
+  auto observer = std::make_shared<TestResponseTimeObserver>();
+  router_->setResponseTimeObserver(observer);
+
+  Http::TestRequestHeaderMapImpl headers{};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_->decodeHeaders(headers, true);
+  test_time_.advanceTimeWait(std::chrono::milliseconds(5));
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(callbacks_, encodeData(_, true));
+  encoder.stream_.resetStream(Http::StreamResetReason::RemoteReset);
+
+  EXPECT_TRUE(observer->response_times_.empty());
+  ASSERT_EQ(1, observer->failures_.size());
+  EXPECT_EQ(std::chrono::milliseconds(5), observer->failures_[0]);
+}
+
 // Verify that upstream timing information is set into the StreamInfo when a
 // retry occurs (and not before).
 TEST_F(RouterTest, UpstreamTimingRetry) {
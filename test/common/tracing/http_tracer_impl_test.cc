@@ -141,6 +141,22 @@ TEST_F(HttpConnManFinalizerImplTest, NoGeneratedId) {
                                             &response_trailers, stream_info, config);
 }
 
+TEST_F(HttpConnManFinalizerImplTest, NonRecordingSpan) {
+  Http::TestRequestHeaderMapImpl request_headers{
+      {"x-request-id", "id"}, {":path", "/"}, {":method", "GET"}, {":scheme", "http"}};
+  Http::TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  Http::TestResponseTrailerMapImpl response_trailers;
+
+  ON_CALL(span, isRecording()).WillByDefault(Return(false));
+  EXPECT_CALL(span, setTag(_, _)).Times(0);
+  EXPECT_CALL(span, log(_, _)).Times(0);
+  EXPECT_CALL(span, finishSpan()).Times(2);
+
+  HttpTracerUtility::finalizeDownstreamSpan(span, &request_headers, &response_headers,
+                                            &response_trailers, stream_info, config);
+  HttpTracerUtility::finalizeUpstreamSpan(span, stream_info, config);
+}
+
 TEST_F(HttpConnManFinalizerImplTest, Connect) {
   const std::string path(300, 'a');
   const std::string path_prefix = "http://";
@@ -319,6 +319,18 @@ TEST_F(TracerImplTest, BasicFunctionalityNodeSet) {
   tracer_->startSpan(config_, request_headers_, stream_info_, {Reason::Sampling, true});
 }
 
+TEST_F(TracerImplTest, NonRecordingSpanNodeNotSet) {
+  EXPECT_CALL(config_, operationName()).Times(2).WillRepeatedly(Return(OperationName::Egress));
+
+  NiceMock<MockSpan>* span = new NiceMock<MockSpan>();
+  ON_CALL(*span, isRecording()).WillByDefault(Return(false));
+  const std::string operation_name = "egress test";
+  EXPECT_CALL(*driver_, startSpan_(_, _, _, operation_name, _)).WillOnce(Return(span));
+  EXPECT_CALL(*span, setTag(_, _)).Times(0);
+
+  tracer_->startSpan(config_, request_headers_, stream_info_, {Reason::Sampling, false});
+}
+
 TEST_F(TracerImplTest, ChildGrpcUpstreamSpanTest) {
   EXPECT_CALL(local_info_, nodeName());
   EXPECT_CALL(config_, operationName()).Times(2).WillRepeatedly(Return(OperationName::Egress));
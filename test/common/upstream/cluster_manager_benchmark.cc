@@ -0,0 +1,328 @@
+// Measures how long it takes for a CDS update of many clusters to reach every worker, with and
+// without batched worker updates, and the cost of handing off streams to the worker owning the
+// connections of a cluster with shared HTTP connection pools.
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+#include "envoy/config/cluster/v3/cluster.pb.h"
+
+#include "source/common/http/header_map_impl.h"
+#include "source/common/network/socket_impl.h"
+#include "source/common/router/context_impl.h"
+#include "source/common/stream_info/stream_info_impl.h"
+#include "source/common/thread_local/thread_local_impl.h"
+
+#include "test/benchmark/main.h"
+#include "test/common/upstream/test_cluster_manager.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+constexpr uint32_t NumWorkers = 4;
+
+class ClusterManagerBenchmark {
+public:
+  explicit ClusterManagerBenchmark(const envoy::config::bootstrap::v3::Bootstrap& bootstrap)
+      : main_dispatcher_(factory_.api_->allocateDispatcher("main_thread")),
+        http_context_(factory_.stats_.symbolTable()), grpc_context_(factory_.stats_.symbolTable()),
+        router_context_(factory_.stats_.symbolTable()) {
+    tls_.registerThread(*main_dispatcher_, true);
+    for (uint32_t i = 0; i < NumWorkers; i++) {
+      worker_dispatchers_.push_back(factory_.api_->allocateDispatcher(absl::StrCat("worker_", i)));
+      tls_.registerThread(*worker_dispatchers_.back(), false);
+    }
+
+    cluster_manager_ = TestClusterManagerImpl::createAndInit(
+        bootstrap, factory_, factory_.stats_, tls_, factory_.runtime_, factory_.local_info_,
+        log_manager_, *main_dispatcher_, admin_, validation_context_, *factory_.api_,
+        http_context_, grpc_context_, router_context_, server_);
+
+    for (Event::DispatcherPtr& dispatcher : worker_dispatchers_) {
+      worker_threads_.push_back(factory_.api_->threadFactory().createThread([this, &dispatcher]() {
+        dispatcher->run(Event::Dispatcher::RunType::RunUntilExit);
+        tls_.shutdownThread();
+      }));
+    }
+    waitForWorkers();
+  }
+
+  ~ClusterManagerBenchmark() {
+    cluster_manager_->shutdown();
+    tls_.shutdownGlobalThreading();
+    for (Event::DispatcherPtr& dispatcher : worker_dispatchers_) {
+      dispatcher->exit();
+    }
+    for (Thread::ThreadPtr& thread : worker_threads_) {
+      thread->join();
+    }
+    cluster_manager_.reset();
+    tls_.shutdownThread();
+  }
+
+  // Runs the main thread until every worker has processed what has been posted to it so far.
+  void waitForWorkers() {
+    tls_.runOnAllThreads([]() {}, [this]() { main_dispatcher_->exit(); });
+    main_dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+  }
+
+  NiceMock<TestClusterManagerFactory> factory_;
+  Event::DispatcherPtr main_dispatcher_;
+  std::vector<Event::DispatcherPtr> worker_dispatchers_;
+  std::vector<Thread::ThreadPtr> worker_threads_;
+  ThreadLocal::InstanceImpl tls_;
+  NiceMock<ProtobufMessage::MockValidationContext> validation_context_;
+  NiceMock<AccessLog::MockAccessLogManager> log_manager_;
+  NiceMock<Server::MockAdmin> admin_;
+  Http::ContextImpl http_context_;
+  Grpc::ContextImpl grpc_context_;
+  Router::ContextImpl router_context_;
+  NiceMock<Server::MockInstance> server_;
+  std::unique_ptr<TestClusterManagerImpl> cluster_manager_;
+};
+
+// Each iteration updates every cluster as a single CDS response would, and waits for the change to
+// converge on all workers.
+void bmCdsUpdate(benchmark::State& state) {
+  const uint32_t num_clusters = state.range(0);
+  const bool batched_worker_updates = state.range(1) != 0;
+
+  if (benchmark::skipExpensiveBenchmarks() && num_clusters > 1000) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  envoy::config::bootstrap::v3::Bootstrap bootstrap;
+  bootstrap.mutable_cluster_manager()->set_enable_batched_worker_updates(batched_worker_updates);
+  ClusterManagerBenchmark test(bootstrap);
+  std::vector<envoy::config::cluster::v3::Cluster> clusters;
+  for (uint32_t i = 0; i < num_clusters; i++) {
+    clusters.push_back(defaultStaticCluster(absl::StrCat("cluster_", i)));
+  }
+
+  uint32_t version = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    version++;
+    for (envoy::config::cluster::v3::Cluster& cluster : clusters) {
+      // A different hash makes this an update of the cluster.
+      cluster.mutable_per_connection_buffer_limit_bytes()->set_value(version);
+      test.cluster_manager_->addOrUpdateCluster(cluster, absl::StrCat(version));
+    }
+    // Lets the batched updates be posted before waiting for the workers.
+    test.main_dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    test.waitForWorkers();
+  }
+  state.counters["clusters_per_second"] =
+      benchmark::Counter(num_clusters * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(bmCdsUpdate)
+    ->ArgsProduct({{100, 1000, 20000}, {0, 1}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// A connection pool which is ready right away and responds to the request headers right away, so
+// that the benchmark measures the stream handling of the cluster manager and not the codecs.
+class FakeConnPool : public Http::ConnectionPool::Instance {
+public:
+  FakeConnPool(HostConstSharedPtr host, TimeSource& time_source)
+      : host_(std::move(host)),
+        info_(Http::Protocol::Http2, time_source,
+              std::make_shared<Network::ConnectionInfoSetterImpl>(nullptr, nullptr)) {}
+
+  // Envoy::ConnectionPool::Instance
+  void addIdleCallback(IdleCb) override {}
+  bool isIdle() const override { return streams_.empty(); }
+  void drainConnections(Envoy::ConnectionPool::DrainBehavior) override {}
+  HostDescriptionConstSharedPtr host() const override { return host_; }
+  bool maybePreconnect(float) override { return false; }
+
+  // Http::ConnectionPool::Instance
+  bool hasActiveConnections() const override { return !streams_.empty(); }
+  Http::ConnectionPool::Cancellable* newStream(Http::ResponseDecoder& response_decoder,
+                                               Http::ConnectionPool::Callbacks& callbacks,
+                                               const StreamOptions&) override {
+    streams_.push_front(std::make_unique<FakeStream>(*this, response_decoder));
+    streams_.front()->iter_ = streams_.begin();
+    callbacks.onPoolReady(*streams_.front(), host_, info_, Http::Protocol::Http2);
+    return nullptr;
+  }
+  absl::string_view protocolDescription() const override { return "fake"; }
+
+private:
+  class FakeStream : public Http::RequestEncoder, public Http::Stream {
+  public:
+    FakeStream(FakeConnPool& parent, Http::ResponseDecoder& response_decoder)
+        : parent_(parent), response_decoder_(response_decoder) {}
+
+    // Http::RequestEncoder
+    Status encodeHeaders(const Http::RequestHeaderMap&, bool) override {
+      auto headers = Http::ResponseHeaderMapImpl::create();
+      headers->setStatus(200);
+      // This may remove the stream, which must not be touched afterwards.
+      response_decoder_.decodeHeaders(std::move(headers), true);
+      return okStatus();
+    }
+    void encodeTrailers(const Http::RequestTrailerMap&) override {}
+    void enableTcpTunneling() override {}
+    void encodeData(Buffer::Instance&, bool) override {}
+    Http::Stream& getStream() override { return *this; }
+    void encodeMetadata(const Http::MetadataMapVector&) override {}
+    Http::Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override {
+      return absl::nullopt;
+    }
+
+    // Http::Stream
+    void addCallbacks(Http::StreamCallbacks&) override {}
+    // Called last by the user of the stream, once it is done with it.
+    void removeCallbacks(Http::StreamCallbacks&) override { parent_.streams_.erase(iter_); }
+    Http::CodecEventCallbacks* registerCodecEventCallbacks(Http::CodecEventCallbacks*) override {
+      return nullptr;
+    }
+    void resetStream(Http::StreamResetReason) override {}
+    void readDisable(bool) override {}
+    uint32_t bufferLimit() const override { return 0; }
+    const Network::ConnectionInfoProvider& connectionInfoProvider() override {
+      return parent_.info_.downstreamAddressProvider();
+    }
+    void setFlushTimeout(std::chrono::milliseconds) override {}
+    Buffer::BufferMemoryAccountSharedPtr account() const override { return nullptr; }
+    void setAccount(Buffer::BufferMemoryAccountSharedPtr) override {}
+    const StreamInfo::BytesMeterSharedPtr& bytesMeter() override { return bytes_meter_; }
+
+    FakeConnPool& parent_;
+    Http::ResponseDecoder& response_decoder_;
+    std::list<std::unique_ptr<FakeStream>>::iterator iter_;
+    const StreamInfo::BytesMeterSharedPtr bytes_meter_{std::make_shared<StreamInfo::BytesMeter>()};
+  };
+
+  const HostConstSharedPtr host_;
+  StreamInfo::StreamInfoImpl info_;
+  std::list<std::unique_ptr<FakeStream>> streams_;
+};
+
+// A request without a body, sent by the router of a worker once its connection pool is ready.
+class BenchmarkStream : public Http::ResponseDecoder,
+                        public Http::ConnectionPool::Callbacks,
+                        public Http::StreamCallbacks {
+public:
+  BenchmarkStream(const Http::RequestHeaderMap& request_headers, std::function<void()> done)
+      : request_headers_(request_headers), done_(std::move(done)) {}
+
+  // Http::ConnectionPool::Callbacks
+  void onPoolFailure(Http::ConnectionPool::PoolFailureReason, absl::string_view,
+                     HostDescriptionConstSharedPtr) override {
+    PANIC("unexpected pool failure");
+  }
+  void onPoolReady(Http::RequestEncoder& encoder, HostDescriptionConstSharedPtr,
+                   StreamInfo::StreamInfo&, absl::optional<Http::Protocol>) override {
+    encoder_ = &encoder;
+    encoder.getStream().addCallbacks(*this);
+    RELEASE_ASSERT(encoder.encodeHeaders(request_headers_, true).ok(), "");
+  }
+
+  // Http::ResponseDecoder
+  void decodeHeaders(Http::ResponseHeaderMapPtr&&, bool end_stream) override {
+    RELEASE_ASSERT(end_stream, "");
+    encoder_->getStream().removeCallbacks(*this);
+    done_();
+  }
+  void decode1xxHeaders(Http::ResponseHeaderMapPtr&&) override {}
+  void decodeData(Buffer::Instance&, bool) override {}
+  void decodeTrailers(Http::ResponseTrailerMapPtr&&) override {}
+  void decodeMetadata(Http::MetadataMapPtr&&) override {}
+  void dumpState(std::ostream&, int) const override {}
+
+  // Http::StreamCallbacks
+  void onResetStream(Http::StreamResetReason, absl::string_view) override {
+    PANIC("unexpected reset");
+  }
+  void onAboveWriteBufferHighWatermark() override {}
+  void onBelowWriteBufferLowWatermark() override {}
+
+private:
+  const Http::RequestHeaderMap& request_headers_;
+  std::function<void()> done_;
+  Http::RequestEncoder* encoder_{};
+};
+
+// Each iteration sends a batch of requests from every worker to the single host of an HTTP/2
+// cluster. With shared connection pools, the streams of all workers are multiplexed on the pool of
+// the worker owning the host, so that the upstream_pools counter (the number of pools, each of
+// which would hold at least one connection) goes from one per worker down to one.
+void bmSharedHttpConnPool(benchmark::State& state) {
+  const bool shared = state.range(0) != 0;
+  const uint32_t streams_per_worker = state.range(1);
+
+  if (benchmark::skipExpensiveBenchmarks() && streams_per_worker > 100) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  envoy::config::bootstrap::v3::Bootstrap bootstrap;
+  envoy::config::cluster::v3::Cluster* cluster =
+      bootstrap.mutable_static_resources()->add_clusters();
+  *cluster = defaultStaticCluster("cluster");
+  cluster->mutable_http2_protocol_options();
+  cluster->set_shared_http_connection_pool(shared);
+  ClusterManagerBenchmark test(bootstrap);
+
+  std::atomic<uint32_t> upstream_pools{0};
+  ON_CALL(test.factory_, allocateConnPool_(_, _, _, _, _))
+      .WillByDefault(testing::WithArg<0>(
+          Invoke([&](HostConstSharedPtr host) -> Http::ConnectionPool::Instance* {
+            upstream_pools++;
+            return new FakeConnPool(host, test.factory_.api_->timeSource());
+          })));
+
+  auto request_headers = Http::RequestHeaderMapImpl::create();
+  request_headers->setMethod("GET");
+  request_headers->setPath("/");
+  request_headers->setHost("host");
+  request_headers->setScheme("http");
+
+  const uint32_t total_streams = NumWorkers * streams_per_worker;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    std::atomic<uint32_t> completed{0};
+    auto done = [&]() {
+      if (++completed == total_streams) {
+        test.main_dispatcher_->post([&test]() { test.main_dispatcher_->exit(); });
+      }
+    };
+    std::vector<std::unique_ptr<BenchmarkStream>> streams;
+    for (uint32_t i = 0; i < total_streams; i++) {
+      streams.push_back(std::make_unique<BenchmarkStream>(*request_headers, done));
+    }
+    for (uint32_t i = 0; i < NumWorkers; i++) {
+      test.worker_dispatchers_[i]->post([&test, &streams, i, streams_per_worker]() {
+        ThreadLocalCluster* cluster = test.cluster_manager_->getThreadLocalCluster("cluster");
+        for (uint32_t j = i * streams_per_worker; j < (i + 1) * streams_per_worker; j++) {
+          auto pool_data =
+              cluster->httpConnPool(ResourcePriority::Default, Http::Protocol::Http2, nullptr);
+          pool_data.value().newStream(*streams[j], *streams[j], {false, true});
+        }
+      });
+    }
+    test.main_dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+    // Lets the owner release the streams of its pool before they are destroyed.
+    test.waitForWorkers();
+  }
+  state.counters["upstream_pools"] = upstream_pools;
+  state.counters["streams_per_second"] =
+      benchmark::Counter(total_streams * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(bmSharedHttpConnPool)
+    ->ArgsProduct({{0, 1}, {100, 10000}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
@@ -602,6 +602,41 @@ TEST_F(ODCDTest, TestMainThreadDiscoveryInProgressDetection) {
       odcds_handle_->requestOnDemandClusterDiscovery("cluster_foo", std::move(cb2), timeout_);
 }
 
+// With batched worker updates, the callback for a cluster which is only known on the main thread
+// so far is posted to the worker after the pending updates, which add the cluster there.
+TEST_F(ClusterManagerImplTest, OdCdsCallbackAfterBatchedWorkerUpdates) {
+  auto* flush_worker_updates = new NiceMock<Event::MockSchedulableCallback>(&factory_.dispatcher_);
+  Bootstrap bootstrap = defaultConfig();
+  bootstrap.mutable_cluster_manager()->set_enable_batched_worker_updates(true);
+  create(bootstrap);
+  MockOdCdsApiSharedPtr odcds = MockOdCdsApi::create();
+  OdCdsApiHandlePtr odcds_handle = cluster_manager_->createOdCdsApiHandle(odcds);
+
+  cluster_manager_->addOrUpdateCluster(defaultStaticCluster("cluster_foo"), "version1");
+  EXPECT_TRUE(flush_worker_updates->enabled_);
+
+  EXPECT_CALL(*odcds, updateOnDemand(_)).Times(0);
+  ReadyWatcher callback_invoked;
+  {
+    InSequence s;
+    EXPECT_CALL(factory_.tls_, runOnAllThreads(_));
+    EXPECT_CALL(callback_invoked, ready());
+  }
+  auto handle = odcds_handle->requestOnDemandClusterDiscovery(
+      "cluster_foo",
+      std::make_unique<ClusterDiscoveryCallback>(
+          [&callback_invoked](ClusterDiscoveryStatus cluster_status) {
+            EXPECT_EQ(ClusterDiscoveryStatus::Available, cluster_status);
+            callback_invoked.ready();
+          }),
+      std::chrono::milliseconds(5000));
+  EXPECT_EQ(1UL, factory_.stats_.counter("cluster_manager.worker_update_batches").value());
+
+  handle.reset();
+  odcds_handle.reset();
+  factory_.tls_.shutdownThread();
+}
+
 class AlpnSocketFactory : public Network::RawBufferSocketFactory {
 public:
   bool supportsAlpn() const override { return true; }
@@ -2269,6 +2304,58 @@ TEST_P(ClusterManagerLifecycleTest, DynamicAddRemove) {
   EXPECT_TRUE(Mock::VerifyAndClearExpectations(callbacks.get()));
 }
 
+// With batched worker updates, the cluster changes made during one event loop iteration reach the
+// workers in order with a single post, while the main thread sees them right away.
+TEST_P(ClusterManagerLifecycleTest, BatchedWorkerUpdates) {
+  auto* flush_worker_updates = new NiceMock<Event::MockSchedulableCallback>(&factory_.dispatcher_);
+  Bootstrap bootstrap = defaultConfig();
+  bootstrap.mutable_cluster_manager()->set_enable_batched_worker_updates(true);
+  create(bootstrap);
+
+  std::unique_ptr<MockClusterUpdateCallbacks> callbacks(new NiceMock<MockClusterUpdateCallbacks>());
+  ClusterUpdateCallbacksHandlePtr cb =
+      cluster_manager_->addThreadLocalClusterUpdateCallbacks(*callbacks);
+
+  std::vector<std::shared_ptr<MockClusterMockPrioritySet>> clusters;
+  for (const std::string& name : {"cluster_1", "cluster_2"}) {
+    clusters.push_back(std::make_shared<NiceMock<MockClusterMockPrioritySet>>());
+    clusters.back()->info_->name_ = name;
+    EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _))
+        .WillOnce(Return(std::make_pair(clusters.back(), nullptr)));
+    EXPECT_CALL(*clusters.back(), initialize(_))
+        .WillOnce(Invoke([](std::function<void()> initialize_callback) { initialize_callback(); }));
+  }
+
+  // The thread local cluster manager of the main thread is updated inline.
+  EXPECT_CALL(factory_.tls_, runOnAllThreads(_)).Times(0);
+  EXPECT_CALL(*callbacks, onClusterAddOrUpdate(_, _)).Times(2);
+  EXPECT_CALL(*callbacks, onClusterRemoval("cluster_1"));
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("cluster_1"), ""));
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("cluster_2"), ""));
+  EXPECT_NE(nullptr, cluster_manager_->getThreadLocalCluster("cluster_1"));
+  EXPECT_TRUE(cluster_manager_->removeCluster("cluster_1"));
+  EXPECT_EQ(nullptr, cluster_manager_->getThreadLocalCluster("cluster_1"));
+  EXPECT_NE(nullptr, cluster_manager_->getThreadLocalCluster("cluster_2"));
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(&factory_.tls_));
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(callbacks.get()));
+
+  // All three changes are posted at once. The mock thread local instance only has the main
+  // thread, which does not apply them a second time.
+  EXPECT_CALL(factory_.tls_, runOnAllThreads(_));
+  EXPECT_CALL(*callbacks, onClusterAddOrUpdate(_, _)).Times(0);
+  EXPECT_CALL(*callbacks, onClusterRemoval(_)).Times(0);
+  flush_worker_updates->invokeCallback();
+  EXPECT_EQ(1UL, factory_.stats_.counter("cluster_manager.worker_update_batches").value());
+  EXPECT_NE(nullptr, cluster_manager_->getThreadLocalCluster("cluster_2"));
+
+  // A later change is flushed by a new batch.
+  EXPECT_FALSE(flush_worker_updates->enabled_);
+  EXPECT_TRUE(cluster_manager_->removeCluster("cluster_2"));
+  EXPECT_TRUE(flush_worker_updates->enabled_);
+  flush_worker_updates->invokeCallback();
+  EXPECT_EQ(2UL, factory_.stats_.counter("cluster_manager.worker_update_batches").value());
+}
+
 // Validates that a callback can remove itself from the callbacks list.
 TEST_P(ClusterManagerLifecycleTest, ClusterAddOrUpdateCallbackRemovalDuringIteration) {
   create(defaultConfig());
@@ -4628,6 +4715,95 @@ TEST_F(ClusterManagerImplTest, UpstreamSocketOptionsUsedInConnPoolHash) {
   EXPECT_EQ(cp2, should_be_cp2);
 }
 
+// Without workers to hand off to, a cluster sharing its connection pools uses pools of its own.
+TEST_F(ClusterManagerImplTest, SharedHttpConnectionPoolWithoutWorkers) {
+  const std::string yaml = R"EOF(
+  static_resources:
+    clusters:
+    - name: cluster_1
+      connect_timeout: 0.250s
+      type: STATIC
+      lb_policy: ROUND_ROBIN
+      http2_protocol_options: {}
+      shared_http_connection_pool: true
+      load_assignment:
+        cluster_name: cluster_1
+        endpoints:
+        - lb_endpoints:
+          - endpoint:
+              address:
+                socket_address:
+                  address: 127.0.0.1
+                  port_value: 11001
+  )EOF";
+  create(parseBootstrapFromV3Yaml(yaml));
+  EXPECT_TRUE(
+      cluster_manager_->getThreadLocalCluster("cluster_1")->info()->sharedHttpConnectionPool());
+
+  Http::ConnectionPool::MockInstance* to_create =
+      new NiceMock<Http::ConnectionPool::MockInstance>();
+  EXPECT_CALL(factory_, allocateConnPool_(_, _, _, _, _)).WillOnce(Return(to_create));
+  Http::ConnectionPool::Instance* cp = HttpPoolDataPeer::getPool(
+      cluster_manager_->getThreadLocalCluster("cluster_1")
+          ->httpConnPool(ResourcePriority::Default, Http::Protocol::Http2, nullptr));
+  EXPECT_EQ(to_create, cp);
+}
+
+// With the shared DNS cache enabled, the STRICT_DNS clusters resolving the same name share a
+// single resolution.
+TEST_F(ClusterManagerImplTest, SharedDnsCache) {
+  const std::string yaml = R"EOF(
+  enable_shared_dns_cache: true
+  static_resources:
+    clusters:
+    - name: cluster_1
+      connect_timeout: 0.250s
+      type: STRICT_DNS
+      lb_policy: ROUND_ROBIN
+      load_assignment:
+        cluster_name: cluster_1
+        endpoints:
+        - lb_endpoints:
+          - endpoint:
+              address:
+                socket_address:
+                  address: foo.com
+                  port_value: 11001
+    - name: cluster_2
+      connect_timeout: 0.250s
+      type: STRICT_DNS
+      lb_policy: ROUND_ROBIN
+      load_assignment:
+        cluster_name: cluster_2
+        endpoints:
+        - lb_endpoints:
+          - endpoint:
+              address:
+                socket_address:
+                  address: foo.com
+                  port_value: 11002
+  )EOF";
+
+  Network::DnsResolver::ResolveCb dns_callback;
+  EXPECT_CALL(*factory_.dns_resolver_, resolve("foo.com", _, _))
+      .WillOnce(DoAll(SaveArg<2>(&dns_callback), Return(&factory_.dns_resolver_->active_query_)));
+  create(parseBootstrapFromV3Yaml(yaml));
+
+  ReadyWatcher initialized;
+  cluster_manager_->setInitializedCb([&]() -> void { initialized.ready(); });
+  EXPECT_CALL(initialized, ready());
+  dns_callback(Network::DnsResolver::ResolutionStatus::Success,
+               TestUtility::makeDnsResponse({"127.0.0.1"}));
+
+  for (const std::string cluster : {"cluster_1", "cluster_2"}) {
+    EXPECT_EQ(1, cluster_manager_->getThreadLocalCluster(cluster)
+                     ->prioritySet()
+                     .hostSetsPerPriority()[0]
+                     ->hosts()
+                     .size());
+  }
+}
+
 TEST_F(ClusterManagerImplTest, UpstreamSocketOptionsNullIsOkay) {
   createWithBasicStaticCluster();
   NiceMock<MockLoadBalancerContext> context;
@@ -0,0 +1,352 @@
+// Tests the hand-off of streams between workers for clusters with shared HTTP connection pools,
+// with real worker threads.
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+#include "envoy/config/cluster/v3/cluster.pb.h"
+
+#include "source/common/network/socket_impl.h"
+#include "source/common/router/context_impl.h"
+#include "source/common/stream_info/stream_info_impl.h"
+#include "source/common/thread_local/thread_local_impl.h"
+
+#include "test/common/upstream/test_cluster_manager.h"
+#include "test/mocks/http/stream_encoder.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+using testing::_;
+using testing::Invoke;
+
+constexpr uint32_t NumWorkers = 3;
+
+// The connection pool of the worker owning a host. Its streams are ready right away, or wait until
+// the pool is destroyed if it is not ready, at which point they fail as with the pools of the
+// codecs. Only used on the owner worker.
+class TestConnPool : public Http::ConnectionPool::Instance {
+public:
+  TestConnPool(HostConstSharedPtr host, bool ready, TimeSource& time_source,
+               std::function<void()> on_new_stream)
+      : host_(std::move(host)), ready_(ready), on_new_stream_(std::move(on_new_stream)),
+        info_(Http::Protocol::Http2, time_source,
+              std::make_shared<Network::ConnectionInfoSetterImpl>(nullptr, nullptr)) {}
+
+  ~TestConnPool() override {
+    while (!pending_streams_.empty()) {
+      Http::ConnectionPool::Callbacks& callbacks = pending_streams_.front().callbacks_;
+      pending_streams_.pop_front();
+      callbacks.onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                              "pool destroyed", host_);
+    }
+  }
+
+  // Envoy::ConnectionPool::Instance
+  void addIdleCallback(IdleCb) override {}
+  bool isIdle() const override { return pending_streams_.empty() && encoders_.empty(); }
+  void drainConnections(Envoy::ConnectionPool::DrainBehavior) override {}
+  HostDescriptionConstSharedPtr host() const override { return host_; }
+  bool maybePreconnect(float) override { return false; }
+
+  // Http::ConnectionPool::Instance
+  bool hasActiveConnections() const override { return !isIdle(); }
+  Http::ConnectionPool::Cancellable* newStream(Http::ResponseDecoder&,
+                                               Http::ConnectionPool::Callbacks& callbacks,
+                                               const StreamOptions&) override {
+    streams_++;
+    on_new_stream_();
+    if (ready_) {
+      encoders_.push_back(std::make_unique<testing::NiceMock<Http::MockRequestEncoder>>());
+      callbacks.onPoolReady(*encoders_.back(), host_, info_, Http::Protocol::Http2);
+      return nullptr;
+    }
+    pending_streams_.emplace_front(*this, callbacks);
+    pending_streams_.front().iter_ = pending_streams_.begin();
+    return &pending_streams_.front();
+  }
+  absl::string_view protocolDescription() const override { return "test"; }
+
+  uint32_t streams() const { return streams_; }
+
+private:
+  struct PendingStream : public Http::ConnectionPool::Cancellable {
+    PendingStream(TestConnPool& parent, Http::ConnectionPool::Callbacks& callbacks)
+        : parent_(parent), callbacks_(callbacks) {}
+
+    // Envoy::ConnectionPool::Cancellable
+    void cancel(Envoy::ConnectionPool::CancelPolicy) override {
+      parent_.pending_streams_.erase(iter_);
+    }
+
+    TestConnPool& parent_;
+    Http::ConnectionPool::Callbacks& callbacks_;
+    std::list<PendingStream>::iterator iter_;
+  };
+
+  const HostConstSharedPtr host_;
+  const bool ready_;
+  std::function<void()> on_new_stream_;
+  StreamInfo::StreamInfoImpl info_;
+  std::list<std::unique_ptr<testing::NiceMock<Http::MockRequestEncoder>>> encoders_;
+  std::list<PendingStream> pending_streams_;
+  uint32_t streams_{};
+};
+
+// A stream created by the router of a worker, which checks that its callbacks run on that worker.
+class TestStream : public Http::ResponseDecoder, public Http::ConnectionPool::Callbacks {
+public:
+  TestStream(Event::Dispatcher& worker, absl::BlockingCounter& done)
+      : worker_(worker), done_(done) {}
+
+  // Http::ConnectionPool::Callbacks
+  void onPoolFailure(ConnectionPool::PoolFailureReason reason, absl::string_view,
+                     HostDescriptionConstSharedPtr) override {
+    EXPECT_TRUE(worker_.isThreadSafe());
+    failure_reason_ = reason;
+    done_.DecrementCount();
+  }
+  void onPoolReady(Http::RequestEncoder& encoder, HostDescriptionConstSharedPtr,
+                   StreamInfo::StreamInfo&, absl::optional<Http::Protocol>) override {
+    EXPECT_TRUE(worker_.isThreadSafe());
+    encoder_ = &encoder;
+    done_.DecrementCount();
+  }
+
+  // Http::ResponseDecoder
+  void decodeHeaders(Http::ResponseHeaderMapPtr&&, bool) override {}
+  void decode1xxHeaders(Http::ResponseHeaderMapPtr&&) override {}
+  void decodeData(Buffer::Instance&, bool) override {}
+  void decodeTrailers(Http::ResponseTrailerMapPtr&&) override {}
+  void decodeMetadata(Http::MetadataMapPtr&&) override {}
+  void dumpState(std::ostream&, int) const override {}
+
+  Event::Dispatcher& worker_;
+  absl::BlockingCounter& done_;
+  Http::RequestEncoder* encoder_{};
+  absl::optional<ConnectionPool::PoolFailureReason> failure_reason_;
+};
+
+class SharedHttpConnPoolTest : public testing::Test {
+public:
+  SharedHttpConnPoolTest()
+      : main_dispatcher_(factory_.api_->allocateDispatcher("main_thread")),
+        http_context_(factory_.stats_.symbolTable()), grpc_context_(factory_.stats_.symbolTable()),
+        router_context_(factory_.stats_.symbolTable()) {}
+
+  ~SharedHttpConnPoolTest() override {
+    if (cluster_manager_ == nullptr) {
+      return;
+    }
+    cluster_manager_->shutdown();
+    if (!tls_.isShutdown()) {
+      tls_.shutdownGlobalThreading();
+    }
+    for (uint32_t i = 0; i < NumWorkers; i++) {
+      stopWorker(i);
+    }
+    cluster_manager_.reset();
+    tls_.shutdownThread();
+  }
+
+  // Starts the workers with a single HTTP/2 cluster sharing its connection pools, with the given
+  // number of hosts.
+  void initialize(uint32_t num_hosts, bool pools_ready) {
+    ON_CALL(factory_, allocateConnPool_(_, _, _, _, _))
+        .WillByDefault(testing::WithArg<0>(
+            Invoke([this, pools_ready](HostConstSharedPtr host) -> Http::ConnectionPool::Instance* {
+              auto pool = new TestConnPool(host, pools_ready, factory_.api_->timeSource(),
+                                           [this]() { owner_streams_++; });
+              absl::MutexLock lock(&mutex_);
+              EXPECT_FALSE(pools_.contains(host->address()->asString()));
+              pools_[host->address()->asString()] = {currentWorker(), pool};
+              return pool;
+            })));
+
+    envoy::config::bootstrap::v3::Bootstrap bootstrap;
+    envoy::config::cluster::v3::Cluster* cluster =
+        bootstrap.mutable_static_resources()->add_clusters();
+    *cluster = defaultStaticCluster("cluster");
+    cluster->mutable_http2_protocol_options();
+    cluster->set_shared_http_connection_pool(true);
+    auto* locality_endpoints = cluster->mutable_load_assignment()->mutable_endpoints(0);
+    for (uint32_t i = 1; i < num_hosts; i++) {
+      auto* endpoint = locality_endpoints->add_lb_endpoints();
+      *endpoint = locality_endpoints->lb_endpoints(0);
+      endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address()->set_port_value(
+          11001 + i);
+    }
+
+    tls_.registerThread(*main_dispatcher_, true);
+    for (uint32_t i = 0; i < NumWorkers; i++) {
+      worker_dispatchers_.push_back(factory_.api_->allocateDispatcher(absl::StrCat("worker_", i)));
+      tls_.registerThread(*worker_dispatchers_.back(), false);
+    }
+    cluster_manager_ = TestClusterManagerImpl::createAndInit(
+        bootstrap, factory_, factory_.stats_, tls_, factory_.runtime_, factory_.local_info_,
+        log_manager_, *main_dispatcher_, admin_, validation_context_, *factory_.api_,
+        http_context_, grpc_context_, router_context_, server_);
+    for (Event::DispatcherPtr& dispatcher : worker_dispatchers_) {
+      worker_threads_.push_back(factory_.api_->threadFactory().createThread([this, &dispatcher]() {
+        dispatcher->run(Event::Dispatcher::RunType::RunUntilExit);
+        tls_.shutdownThread();
+      }));
+    }
+    waitForWorkers();
+  }
+
+  // Runs the main thread until every worker has processed what has been posted to it so far.
+  void waitForWorkers() {
+    tls_.runOnAllThreads([]() {}, [this]() { main_dispatcher_->exit(); });
+    main_dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+  }
+
+  // Stops a worker, which destroys its thread local cluster manager. Requires the global threading
+  // to be shut down.
+  void stopWorker(uint32_t worker) {
+    if (worker_threads_[worker] == nullptr) {
+      return;
+    }
+    worker_dispatchers_[worker]->exit();
+    worker_threads_[worker]->join();
+    worker_threads_[worker].reset();
+  }
+
+  // Creates one stream on each worker for every host of the cluster.
+  void newStreams(uint32_t num_hosts, absl::BlockingCounter& done) {
+    for (uint32_t i = 0; i < NumWorkers; i++) {
+      for (uint32_t j = 0; j < num_hosts; j++) {
+        streams_.push_back(std::make_unique<TestStream>(*worker_dispatchers_[i], done));
+      }
+    }
+    for (uint32_t i = 0; i < NumWorkers; i++) {
+      worker_dispatchers_[i]->post([this, i, num_hosts]() {
+        ThreadLocalCluster* cluster = cluster_manager_->getThreadLocalCluster("cluster");
+        for (uint32_t j = i * num_hosts; j < (i + 1) * num_hosts; j++) {
+          auto pool_data =
+              cluster->httpConnPool(ResourcePriority::Default, Http::Protocol::Http2, nullptr);
+          ASSERT_TRUE(pool_data.has_value());
+          pool_data.value().newStream(*streams_[j], *streams_[j], {false, true});
+        }
+      });
+    }
+  }
+
+  // The index of the worker running the calling thread.
+  uint32_t currentWorker() const {
+    for (uint32_t i = 0; i < NumWorkers; i++) {
+      if (worker_dispatchers_[i]->isThreadSafe()) {
+        return i;
+      }
+    }
+    ADD_FAILURE() << "not called on a worker";
+    return NumWorkers;
+  }
+
+  struct OwnedPool {
+    uint32_t owner_;
+    TestConnPool* pool_;
+  };
+
+  NiceMock<TestClusterManagerFactory> factory_;
+  Event::DispatcherPtr main_dispatcher_;
+  std::vector<Event::DispatcherPtr> worker_dispatchers_;
+  std::vector<Thread::ThreadPtr> worker_threads_;
+  ThreadLocal::InstanceImpl tls_;
+  NiceMock<ProtobufMessage::MockValidationContext> validation_context_;
+  NiceMock<AccessLog::MockAccessLogManager> log_manager_;
+  NiceMock<Server::MockAdmin> admin_;
+  Http::ContextImpl http_context_;
+  Grpc::ContextImpl grpc_context_;
+  Router::ContextImpl router_context_;
+  NiceMock<Server::MockInstance> server_;
+  std::unique_ptr<TestClusterManagerImpl> cluster_manager_;
+
+  absl::Mutex mutex_;
+  // The connection pools by host address.
+  absl::flat_hash_map<std::string, OwnedPool> pools_ ABSL_GUARDED_BY(mutex_);
+  std::atomic<uint32_t> owner_streams_{0};
+  std::vector<std::unique_ptr<TestStream>> streams_;
+};
+
+// Every worker hands off its streams to a host to the single worker owning the host, whose pool
+// multiplexes them. The events of the streams are delivered back on the worker which created them.
+TEST_F(SharedHttpConnPoolTest, HandsOffStreamsToOwner) {
+  constexpr uint32_t NumHosts = 4;
+  initialize(NumHosts, true);
+
+  absl::BlockingCounter ready(NumWorkers * NumHosts);
+  newStreams(NumHosts, ready);
+  ready.Wait();
+
+  {
+    absl::MutexLock lock(&mutex_);
+    // One pool per host, each on a worker, instead of one per host and worker.
+    ASSERT_EQ(NumHosts, pools_.size());
+    for (const auto& pool : pools_) {
+      EXPECT_LT(pool.second.owner_, NumWorkers);
+      // Only touched on the owner, which is done with the streams.
+      EXPECT_EQ(NumWorkers, pool.second.pool_->streams());
+    }
+  }
+  EXPECT_EQ(NumWorkers * NumHosts, owner_streams_);
+
+  // Lets the owners release the streams before they are destroyed.
+  for (uint32_t i = 0; i < NumWorkers; i++) {
+    worker_dispatchers_[i]->post([this, i]() {
+      for (uint32_t j = i * NumHosts; j < (i + 1) * NumHosts; j++) {
+        ASSERT_NE(nullptr, streams_[j]->encoder_);
+        streams_[j]->encoder_->getStream().resetStream(Http::StreamResetReason::LocalReset);
+      }
+    });
+  }
+  waitForWorkers();
+  waitForWorkers();
+}
+
+// The streams of all workers which are still pending in the pool of an owner worker fail when the
+// owner shuts down, while the other workers are still running.
+TEST_F(SharedHttpConnPoolTest, OwnerTeardownFailsPendingStreams) {
+  initialize(1, false);
+
+  absl::BlockingCounter failed(NumWorkers);
+  newStreams(1, failed);
+  // The streams have reached the owner once the workers ran what was posted to them, and then the
+  // owner ran what they posted to it.
+  waitForWorkers();
+  waitForWorkers();
+  ASSERT_EQ(NumWorkers, owner_streams_);
+
+  uint32_t owner;
+  {
+    absl::MutexLock lock(&mutex_);
+    ASSERT_EQ(1, pools_.size());
+    owner = pools_.begin()->second.owner_;
+  }
+
+  cluster_manager_->shutdown();
+  tls_.shutdownGlobalThreading();
+  stopWorker(owner);
+  failed.Wait();
+
+  for (const auto& stream : streams_) {
+    EXPECT_EQ(nullptr, stream->encoder_);
+    EXPECT_EQ(ConnectionPool::PoolFailureReason::LocalConnectionFailure, stream->failure_reason_);
+  }
+}
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
@@ -134,6 +134,108 @@ TEST(EdfSchedulerTest, ManyPeekahead) {
   }
 }
 
+// Validate that removed entries are no longer picked, and are picked again once added back.
+TEST(EdfSchedulerTest, Remove) {
+  EdfScheduler<uint32_t> sched;
+  constexpr uint32_t num_entries = 3;
+  std::shared_ptr<uint32_t> entries[num_entries];
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    entries[i] = std::make_shared<uint32_t>(i);
+    sched.add(1, entries[i]);
+  }
+
+  sched.remove(entries[1]);
+  // Removing twice is a no-op.
+  sched.remove(entries[1]);
+  // Removed entries can not be re-weighted back into the schedule.
+  sched.updateWeight(2, entries[1]);
+  for (uint32_t i = 0; i < 10; ++i) {
+    EXPECT_NE(1, *sched.pickAndAdd([](const double&) { return 1; }));
+  }
+
+  sched.add(1, entries[1]);
+  uint32_t pick_count[num_entries] = {};
+  for (uint32_t i = 0; i < 300; ++i) {
+    ++pick_count[*sched.pickAndAdd([](const double&) { return 1; })];
+  }
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    EXPECT_NEAR(100, pick_count[i], 1);
+  }
+}
+
+// Validate that an entry removed after it was peeked is not picked.
+TEST(EdfSchedulerTest, RemovePeeked) {
+  EdfScheduler<uint32_t> sched;
+  auto first_entry = std::make_shared<uint32_t>(37);
+  auto second_entry = std::make_shared<uint32_t>(42);
+  sched.add(2, first_entry);
+  sched.add(1, second_entry);
+
+  EXPECT_EQ(37, *sched.peekAgain([](const double&) { return 1; }));
+  sched.remove(first_entry);
+  for (uint32_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+  }
+}
+
+// Validate that removed entries which are then destroyed are cleaned up.
+TEST(EdfSchedulerTest, RemoveDestroyed) {
+  EdfScheduler<uint32_t> sched;
+  auto entry = std::make_shared<uint32_t>(42);
+  sched.add(1, entry);
+  {
+    auto removed_entry = std::make_shared<uint32_t>(37);
+    sched.add(1, removed_entry);
+    sched.remove(removed_entry);
+  }
+  for (uint32_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+  }
+
+  auto new_entry = std::make_shared<uint32_t>(37);
+  sched.add(1, new_entry);
+  uint32_t new_entry_picks = 0;
+  for (uint32_t i = 0; i < 10; ++i) {
+    if (*sched.pickAndAdd([](const double&) { return 1; }) == 37) {
+      ++new_entry_picks;
+    }
+  }
+  EXPECT_EQ(5, new_entry_picks);
+}
+
+// Validate that updateWeight() applies the new weight right away.
+TEST(EdfSchedulerTest, UpdateWeight) {
+  EdfScheduler<uint32_t> sched;
+  constexpr uint32_t num_entries = 2;
+  std::shared_ptr<uint32_t> entries[num_entries];
+  double weights[num_entries] = {1, 1};
+  const auto calculate_weight = [&weights](const uint32_t& entry) { return weights[entry]; };
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    entries[i] = std::make_shared<uint32_t>(i);
+    sched.add(weights[i], entries[i]);
+  }
+
+  weights[1] = 3;
+  sched.updateWeight(weights[1], entries[1]);
+  // The entry is rescheduled with its new weight, rather than on its old deadline.
+  EXPECT_EQ(1, *sched.pickAndAdd(calculate_weight));
+
+  uint32_t pick_count[num_entries] = {};
+  for (uint32_t i = 0; i < 400; ++i) {
+    ++pick_count[*sched.pickAndAdd(calculate_weight)];
+  }
+  EXPECT_NEAR(100, pick_count[0], 1);
+  EXPECT_NEAR(300, pick_count[1], 1);
+
+  // Repeated updates leave a single live queue entry.
+  sched.updateWeight(weights[1], entries[1]);
+  sched.updateWeight(weights[1], entries[1]);
+  sched.remove(entries[1]);
+  for (uint32_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(0, *sched.pickAndAdd(calculate_weight));
+  }
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
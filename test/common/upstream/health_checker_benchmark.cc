@@ -0,0 +1,124 @@
+// Measures the main thread CPU time spent on TCP connect health checks, with the health checker
+// running on the main thread and on the health checking thread pool. The CPU column of the output
+// is the CPU time of the main thread, which is what offloading saves.
+
+#include <memory>
+#include <string>
+
+#include "envoy/config/core/v3/health_check.pb.h"
+
+#include "source/common/network/listen_socket_impl.h"
+#include "source/common/upstream/health_checker_impl.h"
+
+#include "test/benchmark/main.h"
+#include "test/common/upstream/utility.h"
+#include "test/mocks/server/server_factory_context.h"
+#include "test/mocks/upstream/cluster_priority_set.h"
+#include "test/test_common/network_utility.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+using testing::NiceMock;
+using testing::ReturnRef;
+
+// Accepts and closes connections on a thread of its own, so that the health checked hosts never
+// run out of accept backlog.
+class AcceptingServer {
+public:
+  explicit AcceptingServer(Api::Api& api)
+      : dispatcher_(api.allocateDispatcher("server")),
+        socket_(Network::Test::getCanonicalLoopbackAddress(Network::Address::IpVersion::v4),
+                nullptr, true) {
+    RELEASE_ASSERT(socket_.ioHandle().listen(ENVOY_TCP_BACKLOG_SIZE).return_value_ == 0, "");
+    socket_.ioHandle().initializeFileEvent(
+        *dispatcher_,
+        [this](uint32_t) {
+          while (socket_.ioHandle().accept(nullptr, nullptr) != nullptr) {
+          }
+        },
+        Event::PlatformDefaultTriggerType, Event::FileReadyType::Read);
+    thread_ = api.threadFactory().createThread(
+        [this]() { dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit); });
+  }
+
+  ~AcceptingServer() {
+    dispatcher_->post([this]() {
+      socket_.ioHandle().resetFileEvents();
+      dispatcher_->exit();
+    });
+    thread_->join();
+  }
+
+  std::string url() const {
+    return "tcp://" + socket_.connectionInfoProvider().localAddress()->asString();
+  }
+
+private:
+  Event::DispatcherPtr dispatcher_;
+  Network::TcpListenSocket socket_;
+  Thread::ThreadPtr thread_;
+};
+
+// Each iteration checks every host once: the health checker is created, started and destroyed
+// once all hosts have reported back to the main thread.
+void bmTcpHealthCheck(benchmark::State& state) {
+  const uint32_t num_hosts = state.range(0);
+  const uint32_t offload_threads = state.range(1);
+
+  if (benchmark::skipExpensiveBenchmarks() && num_hosts > 100) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  Api::ApiPtr api = Api::createApiForTest();
+  Event::DispatcherPtr dispatcher = api->allocateDispatcher("main");
+  AcceptingServer server(*api);
+
+  NiceMock<Server::Configuration::MockServerFactoryContext> server_context;
+  ON_CALL(server_context, api()).WillByDefault(ReturnRef(*api));
+  ON_CALL(server_context, mainThreadDispatcher()).WillByDefault(ReturnRef(*dispatcher));
+
+  NiceMock<MockClusterMockPrioritySet> cluster;
+  HostVector& hosts = cluster.prioritySet().getMockHostSet(0)->hosts_;
+  for (uint32_t i = 0; i < num_hosts; i++) {
+    hosts.push_back(makeTestHost(cluster.info_, server.url(), api->timeSource()));
+  }
+
+  envoy::config::core::v3::HealthCheck config;
+  config.mutable_timeout()->set_seconds(30);
+  // Long enough for every host to be checked only once per iteration.
+  config.mutable_interval()->set_seconds(3600);
+  config.mutable_unhealthy_threshold()->set_value(1);
+  config.mutable_healthy_threshold()->set_value(1);
+  config.mutable_tcp_health_check();
+  config.set_offload_threads(offload_threads);
+
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    HealthCheckerSharedPtr health_checker =
+        HealthCheckerFactory::create(config, cluster, server_context).value();
+    uint32_t completed = 0;
+    health_checker->addHostCheckCompleteCb([&](const HostSharedPtr&, HealthTransition) {
+      if (++completed == num_hosts) {
+        dispatcher->exit();
+      }
+    });
+    health_checker->start();
+    dispatcher->run(Event::Dispatcher::RunType::RunUntilExit);
+
+    health_checker.reset();
+    // Deletes the sessions and connections deferred deleted by an inline health checker.
+    dispatcher->run(Event::Dispatcher::RunType::NonBlock);
+  }
+}
+BENCHMARK(bmTcpHealthCheck)
+    ->ArgsProduct({{100, 1000}, {0, 1, 4}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
@@ -21,6 +21,8 @@
 #include "source/common/protobuf/utility.h"
 #include "source/common/upstream/health_checker_impl.h"
 #include "source/common/upstream/upstream_impl.h"
+#include "source/extensions/health_checkers/common/health_check_thread_pool.h"
+#include "source/extensions/health_checkers/common/shared_session_registry.h"
 #include "source/extensions/health_checkers/grpc/health_checker_impl.h"
 #include "source/extensions/health_checkers/http/health_checker_impl.h"
 #include "source/extensions/health_checkers/tcp/health_checker_impl.h"
@@ -44,6 +46,7 @@
 #include "test/test_common/test_runtime.h"
 #include "test/test_common/utility.h"
 
+#include "absl/synchronization/notification.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -99,6 +102,69 @@ TEST(HealthCheckerFactoryTest, CreateGrpc) {
                     .get()));
 }
 
+// Sessions which run on a health check thread can not be shared with the sessions of other
+// clusters, which run on the main thread.
+TEST(HealthCheckerFactoryTest, OffloadWithSharedSessionsException) {
+  NiceMock<Upstream::MockClusterMockPrioritySet> cluster;
+  NiceMock<Server::Configuration::MockServerFactoryContext> server_context;
+
+  envoy::config::core::v3::HealthCheck health_check = createGrpcHealthCheckConfig();
+  health_check.mutable_tcp_health_check();
+  health_check.set_offload_threads(1);
+  health_check.set_share_across_clusters(true);
+  EXPECT_EQ(HealthCheckerFactory::create(health_check, cluster, server_context).status().message(),
+            "health check offload_threads can not be combined with share_across_clusters");
+}
+
+// Offloaded health checkers run on the thread pool shared by the server, which is grown to the
+// number of threads they ask for.
+TEST(HealthCheckerFactoryTest, CreateOffloaded) {
+  Api::ApiPtr api = Api::createApiForTest();
+  NiceMock<Upstream::MockClusterMockPrioritySet> cluster;
+  NiceMock<Server::Configuration::MockServerFactoryContext> server_context;
+  ON_CALL(server_context, api()).WillByDefault(ReturnRef(*api));
+
+  envoy::config::core::v3::HealthCheck health_check = createGrpcHealthCheckConfig();
+  health_check.mutable_tcp_health_check();
+  health_check.set_offload_threads(2);
+  HealthCheckerSharedPtr first =
+      HealthCheckerFactory::create(health_check, cluster, server_context).value();
+  HealthCheckerSharedPtr second =
+      HealthCheckerFactory::create(health_check, cluster, server_context).value();
+  EXPECT_NE(nullptr, dynamic_cast<TcpHealthCheckerImpl*>(first.get()));
+
+  HealthCheckThreadPoolSharedPtr thread_pool =
+      HealthCheckThreadPool::get(server_context.singletonManager(), *api);
+  EXPECT_EQ(2, thread_pool->size());
+
+  // The health checkers stop their sessions on their threads when they are destroyed.
+  first.reset();
+  second.reset();
+}
+
+TEST(HealthCheckThreadPoolTest, PickDispatcher) {
+  Api::ApiPtr api = Api::createApiForTest();
+  HealthCheckThreadPool thread_pool(*api);
+
+  Event::Dispatcher& first = thread_pool.pickDispatcher(2);
+  EXPECT_EQ(2, thread_pool.size());
+  Event::Dispatcher& second = thread_pool.pickDispatcher(1);
+  EXPECT_NE(&first, &second);
+  EXPECT_EQ(&first, &thread_pool.pickDispatcher(1));
+  // Threads are still picked round robin after the pool grows.
+  EXPECT_EQ(&second, &thread_pool.pickDispatcher(3));
+  EXPECT_EQ(3, thread_pool.size());
+
+  // Each dispatcher runs on a thread of its own.
+  absl::Notification ran;
+  first.post([&first, &ran]() {
+    EXPECT_TRUE(first.isThreadSafe());
+    ran.Notify();
+  });
+  ran.WaitForNotification();
+  EXPECT_FALSE(first.isThreadSafe());
+}
+
 class HealthCheckerTestBase {
 public:
   std::shared_ptr<MockClusterMockPrioritySet> cluster_{
@@ -4678,6 +4744,239 @@ TEST_F(TcpHealthCheckerImplTest, ConnectionLocalFailure) {
   EXPECT_EQ(0UL, cluster_->info_->stats_store_.counter("health_check.passive_failure").value());
 }
 
+// Health checkers of two clusters which share their sessions for a common endpoint.
+class TcpHealthCheckerSharedSessionTest : public testing::Test,
+                                          public Event::TestUsingSimulatedTime {
+public:
+  struct TestCluster {
+    std::shared_ptr<MockClusterMockPrioritySet> cluster_{
+        std::make_shared<NiceMock<MockClusterMockPrioritySet>>()};
+    std::shared_ptr<TcpHealthCheckerImpl> health_checker_;
+    Event::MockTimer* interval_timer_{};
+    Event::MockTimer* timeout_timer_{};
+  };
+
+  void allocHealthChecker(TestCluster& test_cluster, uint32_t unhealthy_threshold) {
+    const std::string yaml = fmt::format(R"EOF(
+    timeout: 1s
+    interval: 1s
+    unhealthy_threshold: {}
+    healthy_threshold: 2
+    share_across_clusters: true
+    tcp_health_check:
+      send:
+        text: "01"
+      receive:
+      - text: "02"
+    )EOF",
+                                         unhealthy_threshold);
+    test_cluster.health_checker_ = std::make_shared<TcpHealthCheckerImpl>(
+        *test_cluster.cluster_, parseHealthCheckFromV3Yaml(yaml), dispatcher_, runtime_, random_,
+        nullptr);
+    test_cluster.health_checker_->setSharedSessionRegistry(registry_);
+    test_cluster.cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+        makeTestHost(test_cluster.cluster_->info_, "tcp://127.0.0.1:80", simTime())};
+  }
+
+  void expectSessionCreate(TestCluster& test_cluster) {
+    test_cluster.interval_timer_ = new Event::MockTimer(&dispatcher_);
+    test_cluster.timeout_timer_ = new Event::MockTimer(&dispatcher_);
+  }
+
+  void expectClientCreate() {
+    connection_ = new NiceMock<Network::MockClientConnection>();
+    EXPECT_CALL(dispatcher_, createClientConnection_(_, _, _, _)).WillOnce(Return(connection_));
+    EXPECT_CALL(*connection_, addReadFilter(_)).WillOnce(SaveArg<0>(&read_filter_));
+  }
+
+  // Starts cluster a, which probes the endpoint, and then cluster b, which does not.
+  void startHealthCheckers() {
+    startProbingHealthChecker();
+    startFollowingHealthChecker();
+  }
+
+  void startProbingHealthChecker() {
+    expectSessionCreate(cluster_a_);
+    expectClientCreate();
+    EXPECT_CALL(*connection_, write(_, _));
+    EXPECT_CALL(*cluster_a_.timeout_timer_, enableTimer(_, _));
+    cluster_a_.health_checker_->start();
+  }
+
+  // The session of cluster b applies the last result of cluster a from its timer.
+  void startFollowingHealthChecker() {
+    expectSessionCreate(cluster_b_);
+    EXPECT_CALL(*cluster_b_.interval_timer_, enableTimer(std::chrono::milliseconds(0), _));
+    cluster_b_.health_checker_->start();
+    EXPECT_EQ(1, registry_->size());
+  }
+
+  void respond() {
+    Buffer::OwnedImpl response;
+    addUint8(response, 2);
+    read_filter_->onData(response, false);
+  }
+
+  uint64_t counter(TestCluster& test_cluster, const std::string& name) {
+    return test_cluster.cluster_->info_->stats_store_.counter("health_check." + name).value();
+  }
+
+  HostSharedPtr host(TestCluster& test_cluster) {
+    return test_cluster.cluster_->prioritySet().getMockHostSet(0)->hosts_[0];
+  }
+
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Random::MockRandomGenerator> random_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  SharedSessionRegistrySharedPtr registry_{std::make_shared<SharedSessionRegistry>()};
+  TestCluster cluster_a_;
+  TestCluster cluster_b_;
+  Network::MockClientConnection* connection_{};
+  Network::ReadFilterSharedPtr read_filter_;
+};
+
+// A single probe is sent for the common endpoint, and its results are applied with the thresholds
+// of each cluster.
+TEST_F(TcpHealthCheckerSharedSessionTest, ResultsSharedAcrossClusters) {
+  InSequence s;
+
+  allocHealthChecker(cluster_a_, 2);
+  allocHealthChecker(cluster_b_, 1);
+  startHealthCheckers();
+
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(*cluster_a_.timeout_timer_, disableTimer());
+  EXPECT_CALL(*cluster_a_.interval_timer_, enableTimer(_, _));
+  respond();
+
+  EXPECT_EQ(1UL, counter(cluster_a_, "attempt"));
+  EXPECT_EQ(1UL, counter(cluster_a_, "success"));
+  EXPECT_EQ(0UL, counter(cluster_b_, "attempt"));
+  EXPECT_EQ(1UL, counter(cluster_b_, "success"));
+
+  // The timeout only reaches the unhealthy threshold of cluster b.
+  EXPECT_CALL(*connection_, close(Network::ConnectionCloseType::Abort));
+  EXPECT_CALL(*cluster_a_.timeout_timer_, disableTimer());
+  EXPECT_CALL(*cluster_a_.interval_timer_, enableTimer(_, _));
+  cluster_a_.timeout_timer_->invokeCallback();
+
+  EXPECT_EQ(1UL, counter(cluster_a_, "network_failure"));
+  EXPECT_EQ(1UL, counter(cluster_b_, "network_failure"));
+  EXPECT_EQ(Host::Health::Healthy, host(cluster_a_)->coarseHealth());
+  EXPECT_EQ(Host::Health::Unhealthy, host(cluster_b_)->coarseHealth());
+  EXPECT_TRUE(host(cluster_b_)->healthFlagGet(Host::HealthFlag::ACTIVE_HC_TIMEOUT));
+}
+
+// When the host of the probing cluster is removed, the other cluster starts probing the endpoint.
+TEST_F(TcpHealthCheckerSharedSessionTest, TakeOverWhenProbingSessionRemoved) {
+  InSequence s;
+
+  allocHealthChecker(cluster_a_, 2);
+  allocHealthChecker(cluster_b_, 2);
+  startHealthCheckers();
+
+  EXPECT_CALL(*cluster_b_.interval_timer_, enableTimer(_, _));
+  EXPECT_CALL(*connection_, close(Network::ConnectionCloseType::Abort));
+  HostSharedPtr removed_host = host(cluster_a_);
+  cluster_a_.cluster_->prioritySet().getMockHostSet(0)->hosts_ = {};
+  cluster_a_.cluster_->prioritySet().getMockHostSet(0)->runCallbacks({}, {removed_host});
+  EXPECT_EQ(1, registry_->size());
+
+  expectClientCreate();
+  EXPECT_CALL(*connection_, write(_, _));
+  EXPECT_CALL(*cluster_b_.timeout_timer_, enableTimer(_, _));
+  cluster_b_.interval_timer_->invokeCallback();
+  EXPECT_EQ(1UL, counter(cluster_b_, "attempt"));
+
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(*cluster_b_.timeout_timer_, disableTimer());
+  EXPECT_CALL(*cluster_b_.interval_timer_, enableTimer(_, _));
+  respond();
+  EXPECT_EQ(1UL, counter(cluster_b_, "success"));
+  EXPECT_EQ(0UL, counter(cluster_a_, "success"));
+}
+
+// A cluster which starts sharing the endpoint after a probe completed applies that result instead
+// of waiting for the next probe, so that its host does not stay pending.
+TEST_F(TcpHealthCheckerSharedSessionTest, LastResultAppliedOnJoin) {
+  InSequence s;
+
+  allocHealthChecker(cluster_a_, 2);
+  allocHealthChecker(cluster_b_, 2);
+  startProbingHealthChecker();
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(*cluster_a_.timeout_timer_, disableTimer());
+  EXPECT_CALL(*cluster_a_.interval_timer_, enableTimer(_, _));
+  respond();
+
+  host(cluster_b_)->healthFlagSet(Host::HealthFlag::PENDING_ACTIVE_HC);
+  startFollowingHealthChecker();
+  EXPECT_EQ(0UL, counter(cluster_b_, "success"));
+  cluster_b_.interval_timer_->invokeCallback();
+
+  EXPECT_EQ(0UL, counter(cluster_b_, "attempt"));
+  EXPECT_EQ(1UL, counter(cluster_b_, "success"));
+  EXPECT_FALSE(host(cluster_b_)->healthFlagGet(Host::HealthFlag::PENDING_ACTIVE_HC));
+  EXPECT_EQ(Host::Health::Healthy, host(cluster_b_)->coarseHealth());
+}
+
+// A cluster which joins before the first probe completed gets that result once, when it completes.
+TEST_F(TcpHealthCheckerSharedSessionTest, JoinBeforeFirstResult) {
+  InSequence s;
+
+  allocHealthChecker(cluster_a_, 2);
+  allocHealthChecker(cluster_b_, 2);
+  startHealthCheckers();
+  cluster_b_.interval_timer_->invokeCallback();
+  EXPECT_EQ(0UL, counter(cluster_b_, "success"));
+
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(*cluster_a_.timeout_timer_, disableTimer());
+  EXPECT_CALL(*cluster_a_.interval_timer_, enableTimer(_, _));
+  respond();
+  EXPECT_EQ(1UL, counter(cluster_b_, "success"));
+}
+
+// The probing cluster uses the intervals for traffic when only another cluster sharing the
+// endpoint has made connections.
+TEST_F(TcpHealthCheckerSharedSessionTest, IntervalUsesTrafficOfAllClusters) {
+  InSequence s;
+
+  allocHealthChecker(cluster_a_, 2);
+  allocHealthChecker(cluster_b_, 2);
+  startHealthCheckers();
+  cluster_b_.cluster_->info_->trafficStats()->upstream_cx_total_.inc();
+
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(*cluster_a_.timeout_timer_, disableTimer());
+  EXPECT_CALL(*cluster_a_.interval_timer_, enableTimer(std::chrono::milliseconds(1000), _));
+  respond();
+}
+
+// Thresholds and event logging may differ between the clusters sharing sessions, other settings
+// may not.
+TEST(SharedSessionRegistryTest, ConfigKey) {
+  const std::string yaml = R"EOF(
+  timeout: 1s
+  interval: 1s
+  unhealthy_threshold: 2
+  healthy_threshold: 2
+  share_across_clusters: true
+  tcp_health_check: {}
+  )EOF";
+  const envoy::config::core::v3::HealthCheck config = parseHealthCheckFromV3Yaml(yaml);
+  const std::string key = SharedSessionRegistry::configKey(config);
+
+  envoy::config::core::v3::HealthCheck other_config = config;
+  other_config.mutable_unhealthy_threshold()->set_value(5);
+  other_config.mutable_healthy_threshold()->set_value(1);
+  other_config.set_always_log_health_check_failures(true);
+  EXPECT_EQ(key, SharedSessionRegistry::configKey(other_config));
+
+  other_config.mutable_interval()->set_seconds(5);
+  EXPECT_NE(key, SharedSessionRegistry::configKey(other_config));
+}
+
 class TestGrpcHealthCheckerImpl : public GrpcHealthCheckerImpl {
 public:
   using GrpcHealthCheckerImpl::GrpcHealthCheckerImpl;
@@ -30,6 +30,53 @@ TEST(HostStatsTest, GaugesSortedByName) {
   }
 }
 
+TEST(HostStatsTest, RqActive) {
+  HostStats host_stats;
+  host_stats.incRqActive();
+  host_stats.incRqActive();
+  EXPECT_EQ(2U, host_stats.rq_active_.value());
+  host_stats.decRqActive();
+  EXPECT_EQ(1U, host_stats.rq_active_.value());
+}
+
+// With shards, active requests are added to rq_active in batches.
+TEST(HostStatsTest, ShardedRqActive) {
+  HostStats host_stats;
+  host_stats.rq_active_shards_ = std::make_unique<ShardedCounter>(3);
+  host_stats.incRqActive();
+  host_stats.incRqActive();
+  EXPECT_EQ(0U, host_stats.rq_active_.value());
+  host_stats.incRqActive();
+  EXPECT_EQ(3U, host_stats.rq_active_.value());
+
+  host_stats.decRqActive();
+  host_stats.decRqActive();
+  EXPECT_EQ(3U, host_stats.rq_active_.value());
+  host_stats.decRqActive();
+  EXPECT_EQ(0U, host_stats.rq_active_.value());
+}
+
+// A batch of completions can be flushed before the batch of the requests they complete. The
+// gauge stays at zero until the requests are flushed, rather than wrapping.
+TEST(HostStatsTest, ShardedRqActiveNegativeFlushFirst) {
+  HostStats host_stats;
+  host_stats.rq_active_shards_ = std::make_unique<ShardedCounter>(3);
+  host_stats.decRqActive();
+  host_stats.decRqActive();
+  host_stats.decRqActive();
+  EXPECT_EQ(0U, host_stats.rq_active_.value());
+
+  host_stats.incRqActive();
+  host_stats.incRqActive();
+  host_stats.incRqActive();
+  EXPECT_EQ(0U, host_stats.rq_active_.value());
+
+  host_stats.incRqActive();
+  host_stats.incRqActive();
+  host_stats.incRqActive();
+  EXPECT_EQ(3U, host_stats.rq_active_.value());
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
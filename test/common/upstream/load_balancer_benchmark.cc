@@ -1,11 +1,13 @@
 // Usage: bazel run //test/common/upstream:load_balancer_benchmark
 
 #include <memory>
+#include <vector>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
 
 #include "source/common/common/random_generator.h"
 #include "source/common/memory/stats.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/common/upstream/upstream_impl.h"
 #include "source/extensions/load_balancing_policies/maglev/maglev_lb.h"
 #include "source/extensions/load_balancing_policies/ring_hash/ring_hash_lb.h"
@@ -154,6 +156,106 @@ BENCHMARK(benchmarkRoundRobinLoadBalancerBuild)
     ->Args({50000, 100, 50})
     ->Unit(::benchmark::kMillisecond);
 
+// Replaces state.range(1) weighted hosts of a state.range(0) host cluster on each iteration and
+// times the resulting load balancer refresh. state.range(2) enables incremental EDF refresh.
+void benchmarkRoundRobinLoadBalancerHostChurn(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t num_changed = state.range(1);
+  Runtime::maybeSetRuntimeGuard("envoy.reloadable_features.edf_lb_incremental_refresh",
+                                state.range(2) != 0);
+
+  if (benchmark::skipExpensiveBenchmarks() && num_hosts > 10000) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  // Weight half of the hosts, so that the EDF schedulers are used.
+  RoundRobinTester tester(num_hosts, 50, 50);
+  tester.initialize();
+  HostVector hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+  uint64_t next_changed = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    HostVector hosts_added;
+    HostVector hosts_removed;
+    for (uint64_t i = 0; i < num_changed; i++) {
+      const uint64_t index = (next_changed++) % (num_hosts / 2);
+      hosts_removed.push_back(hosts[index]);
+      hosts[index] =
+          makeTestHost(tester.info_, "tcp://" + hosts[index]->address()->asString(),
+                       tester.simTime(), hosts[index]->weight());
+      hosts_added.push_back(hosts[index]);
+    }
+    HostVectorConstSharedPtr updated_hosts = std::make_shared<HostVector>(hosts);
+    HostsPerLocalityConstSharedPtr hosts_per_locality = makeHostsPerLocality({hosts});
+    auto update_hosts_params = HostSetImpl::partitionHosts(updated_hosts, hosts_per_locality);
+    state.ResumeTiming();
+
+    tester.priority_set_.updateHosts(0, std::move(update_hosts_params), {}, hosts_added,
+                                     hosts_removed, absl::nullopt);
+  }
+  Runtime::maybeSetRuntimeGuard("envoy.reloadable_features.edf_lb_incremental_refresh", false);
+}
+BENCHMARK(benchmarkRoundRobinLoadBalancerHostChurn)
+    ->ArgsProduct({{2500, 10000, 50000}, {1, 100}, {0, 1}})
+    ->Unit(::benchmark::kMicrosecond);
+
+// Times a host update of a state.range(0) host cluster with half of the hosts weighted, as seen by
+// state.range(1) workers. With state.range(2), the round robin schedules are built once on the main
+// thread and shared by the workers.
+void benchmarkRoundRobinLoadBalancerWorkerRefresh(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t num_workers = state.range(1);
+  const bool share_schedules = state.range(2) != 0;
+
+  if (benchmark::skipExpensiveBenchmarks() && num_hosts * num_workers > 100000) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  BaseTester tester(num_hosts, 50, 50);
+  std::shared_ptr<EdfLoadBalancerBase::SharedSchedules> shared_schedules;
+  if (share_schedules) {
+    shared_schedules = std::make_shared<EdfLoadBalancerBase::SharedSchedules>();
+    shared_schedules->update(*tester.priority_set_.hostSetsPerPriority()[0]);
+  }
+  std::vector<std::unique_ptr<PrioritySetImpl>> worker_priority_sets;
+  std::vector<std::unique_ptr<RoundRobinLoadBalancer>> worker_lbs;
+  for (uint64_t i = 0; i < num_workers; i++) {
+    worker_priority_sets.push_back(std::make_unique<PrioritySetImpl>());
+    worker_priority_sets.back()->updateHosts(
+        0, HostSetImpl::updateHostsParams(*tester.priority_set_.hostSetsPerPriority()[0]), {}, {},
+        {}, absl::nullopt);
+    worker_lbs.push_back(std::make_unique<RoundRobinLoadBalancer>(
+        *worker_priority_sets.back(), nullptr, tester.stats_, tester.runtime_, tester.random_, 50,
+        envoy::extensions::load_balancing_policies::round_robin::v3::RoundRobin(),
+        tester.simTime(), shared_schedules));
+  }
+
+  HostVector hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    HostVectorConstSharedPtr updated_hosts = std::make_shared<HostVector>(hosts);
+    HostsPerLocalityConstSharedPtr hosts_per_locality = makeHostsPerLocality({hosts});
+    tester.priority_set_.updateHosts(
+        0, HostSetImpl::partitionHosts(updated_hosts, hosts_per_locality), {}, {}, {},
+        absl::nullopt);
+    state.ResumeTiming();
+
+    if (shared_schedules != nullptr) {
+      shared_schedules->update(*tester.priority_set_.hostSetsPerPriority()[0]);
+    }
+    for (auto& worker_priority_set : worker_priority_sets) {
+      worker_priority_set->updateHosts(
+          0, HostSetImpl::updateHostsParams(*tester.priority_set_.hostSetsPerPriority()[0]), {},
+          {}, {}, absl::nullopt);
+    }
+  }
+}
+BENCHMARK(benchmarkRoundRobinLoadBalancerWorkerRefresh)
+    ->ArgsProduct({{2500, 10000}, {1, 16, 64}, {0, 1}})
+    ->Unit(::benchmark::kMillisecond);
+
 class RingHashTester : public BaseTester {
 public:
   RingHashTester(uint64_t num_hosts, uint64_t min_ring_size) : BaseTester(num_hosts) {
@@ -245,6 +347,55 @@ BENCHMARK(benchmarkMaglevLoadBalancerBuildTable)
     ->Arg(500)
     ->Unit(::benchmark::kMillisecond);
 
+// Replaces one host of an initialized thread aware load balancer on each iteration and times the
+// resulting rebuild of its hashing structure.
+void rebuildOnHostChange(::benchmark::State& state, BaseTester& tester,
+                         ThreadAwareLoadBalancer& lb) {
+  lb.initialize();
+  HostVector hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+  uint64_t next_changed = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    const uint64_t index = (next_changed++) % hosts.size();
+    HostVector hosts_removed = {hosts[index]};
+    hosts[index] = makeTestHost(tester.info_, "tcp://" + hosts[index]->address()->asString(),
+                                tester.simTime());
+    HostVectorConstSharedPtr updated_hosts = std::make_shared<HostVector>(hosts);
+    HostsPerLocalityConstSharedPtr hosts_per_locality = makeHostsPerLocality({hosts});
+    auto update_hosts_params = HostSetImpl::partitionHosts(updated_hosts, hosts_per_locality);
+    state.ResumeTiming();
+
+    tester.priority_set_.updateHosts(0, std::move(update_hosts_params), {}, {hosts[index]},
+                                     hosts_removed, absl::nullopt);
+  }
+}
+
+void benchmarkRingHashLoadBalancerRebuild(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t min_ring_size = state.range(1);
+  if (benchmark::skipExpensiveBenchmarks() && min_ring_size > 1024 * 1024) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  RingHashTester tester(num_hosts, min_ring_size);
+  rebuildOnHostChange(state, tester, *tester.ring_hash_lb_);
+}
+BENCHMARK(benchmarkRingHashLoadBalancerRebuild)
+    ->ArgsProduct({{100, 1000, 5000}, {1024 * 1024, 8 * 1024 * 1024}})
+    ->Unit(::benchmark::kMillisecond);
+
+void benchmarkMaglevLoadBalancerRebuild(::benchmark::State& state) {
+  MaglevTester tester(state.range(0));
+  rebuildOnHostChange(state, tester, *tester.maglev_lb_);
+}
+BENCHMARK(benchmarkMaglevLoadBalancerRebuild)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(5000)
+    ->Arg(10000)
+    ->Unit(::benchmark::kMillisecond);
+
 class TestLoadBalancerContext : public LoadBalancerContextBase {
 public:
   // Upstream::LoadBalancerContext
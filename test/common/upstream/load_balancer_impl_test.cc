@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <bitset>
 #include <cstdint>
 #include <memory>
@@ -51,6 +52,12 @@ public:
   static double slowStartMinWeightPercent(const EdfLoadBalancerBase& edf_lb) {
     return edf_lb.slow_start_min_weight_percent_;
   }
+  // Returns the number of host sources that pick from a schedule shared across workers.
+  static size_t sharedSchedulesInUse(const EdfLoadBalancerBase& edf_lb) {
+    return std::count_if(edf_lb.scheduler_.begin(), edf_lb.scheduler_.end(), [](const auto& entry) {
+      return entry.second.shared_schedule_ != nullptr;
+    });
+  }
 };
 
 class TestZoneAwareLoadBalancer : public ZoneAwareLoadBalancerBase {
@@ -1156,6 +1163,193 @@ TEST_P(RoundRobinLoadBalancerTest, WeightedSeed) {
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
 }
 
+// Validate that host changes are applied to the existing EDF schedule with incremental refresh.
+TEST_P(RoundRobinLoadBalancerTest, WeightedIncrementalRefresh) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.edf_lb_incremental_refresh", "true"}});
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", simTime(), 1),
+                              makeTestHost(info_, "tcp://127.0.0.1:81", simTime(), 2)};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  init(false);
+
+  const auto pick_counts = [this](uint32_t picks) {
+    absl::flat_hash_map<HostConstSharedPtr, uint32_t> counts;
+    for (uint32_t i = 0; i < picks; ++i) {
+      ++counts[lb_->chooseHost(nullptr)];
+    }
+    return counts;
+  };
+  auto counts = pick_counts(30);
+  EXPECT_NEAR(10, counts[hostSet().hosts_[0]], 1);
+  EXPECT_NEAR(20, counts[hostSet().hosts_[1]], 1);
+
+  // Add a host.
+  hostSet().healthy_hosts_.push_back(makeTestHost(info_, "tcp://127.0.0.1:82", simTime(), 3));
+  hostSet().hosts_.push_back(hostSet().healthy_hosts_.back());
+  hostSet().runCallbacks({hostSet().healthy_hosts_.back()}, {});
+  counts = pick_counts(60);
+  EXPECT_NEAR(10, counts[hostSet().hosts_[0]], 1);
+  EXPECT_NEAR(20, counts[hostSet().hosts_[1]], 1);
+  EXPECT_NEAR(30, counts[hostSet().hosts_[2]], 1);
+
+  // The second host becomes unhealthy, so it leaves the healthy host source but stays alive.
+  hostSet().healthy_hosts_ = {hostSet().hosts_[0], hostSet().hosts_[2]};
+  hostSet().runCallbacks({}, {});
+  counts = pick_counts(40);
+  EXPECT_NEAR(10, counts[hostSet().hosts_[0]], 1);
+  EXPECT_EQ(0, counts[hostSet().hosts_[1]]);
+  EXPECT_NEAR(30, counts[hostSet().hosts_[2]], 1);
+
+  // A weight change is applied right away.
+  hostSet().hosts_[0]->weight(3);
+  hostSet().runCallbacks({}, {});
+  counts = pick_counts(40);
+  EXPECT_NEAR(20, counts[hostSet().hosts_[0]], 1);
+  EXPECT_NEAR(20, counts[hostSet().hosts_[2]], 1);
+
+  // Remove a host.
+  HostVector removed_hosts = {hostSet().hosts_[2]};
+  hostSet().hosts_.pop_back();
+  hostSet().healthy_hosts_.pop_back();
+  hostSet().runCallbacks({}, removed_hosts);
+  for (uint32_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(hostSet().hosts_[0], lb_->chooseHost(nullptr));
+  }
+}
+
+class PrecomputedScheduleTest : public Event::TestUsingSimulatedTime, public testing::Test {
+protected:
+  using PrecomputedSchedule = EdfLoadBalancerBase::PrecomputedSchedule;
+
+  PrecomputedScheduleTest()
+      : stat_names_(stats_store_.symbolTable()), stats_(stat_names_, *stats_store_.rootScope()) {}
+
+  HostVectorSharedPtr makeHosts(const std::vector<uint32_t>& weights) {
+    auto hosts = std::make_shared<HostVector>();
+    for (uint32_t weight : weights) {
+      hosts->push_back(makeTestHost(info_, "tcp://127.0.0.1:" + std::to_string(80 + hosts->size()),
+                                    simTime(), weight));
+    }
+    return hosts;
+  }
+
+  // Hands the hosts of the main thread priority set to a worker priority set, as the cluster
+  // manager does.
+  void updateWorker(PrioritySetImpl& worker_priority_set) {
+    worker_priority_set.updateHosts(
+        0, HostSetImpl::updateHostsParams(*main_priority_set_.hostSetsPerPriority()[0]), {}, {},
+        {}, absl::nullopt);
+  }
+
+  std::unique_ptr<RoundRobinLoadBalancer>
+  createWorkerLb(PrioritySetImpl& worker_priority_set,
+                 EdfLoadBalancerBase::SharedSchedulesConstSharedPtr shared_schedules) {
+    return std::make_unique<RoundRobinLoadBalancer>(
+        worker_priority_set, nullptr, stats_, runtime_, random_, 50,
+        envoy::extensions::load_balancing_policies::round_robin::v3::RoundRobin(), simTime(),
+        std::move(shared_schedules));
+  }
+
+  absl::flat_hash_map<HostConstSharedPtr, uint32_t> pickCounts(LoadBalancer& lb, uint32_t picks) {
+    absl::flat_hash_map<HostConstSharedPtr, uint32_t> counts;
+    for (uint32_t i = 0; i < picks; ++i) {
+      ++counts[lb.chooseHost(nullptr)];
+    }
+    return counts;
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  ClusterLbStatNames stat_names_;
+  ClusterLbStats stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Random::MockRandomGenerator> random_;
+  std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
+  PrioritySetImpl main_priority_set_;
+};
+
+TEST_F(PrecomputedScheduleTest, EqualWeightsAreUnweighted) {
+  auto schedule = PrecomputedSchedule::create(makeHosts({3, 3, 3}));
+  ASSERT_NE(nullptr, schedule);
+  EXPECT_FALSE(schedule->weighted());
+  EXPECT_EQ(3, schedule->hosts().size());
+}
+
+TEST_F(PrecomputedScheduleTest, PicksInEdfOrder) {
+  // The weights reduce to 1, 2 and 3, so a cycle has 6 picks.
+  HostVectorSharedPtr hosts = makeHosts({2, 4, 6});
+  auto schedule = PrecomputedSchedule::create(hosts);
+  ASSERT_NE(nullptr, schedule);
+  EXPECT_TRUE(schedule->weighted());
+  ASSERT_EQ(6, schedule->size());
+  const std::vector<uint32_t> expected = {2, 1, 2, 0, 1, 2};
+  for (uint64_t position = 0; position < 12; ++position) {
+    EXPECT_EQ((*hosts)[expected[position % 6]], schedule->pick(position));
+  }
+}
+
+TEST_F(PrecomputedScheduleTest, LongCycleNotPrecomputed) {
+  constexpr uint32_t MaxWeight = PrecomputedSchedule::MinMaxPicks - 1;
+  EXPECT_NE(nullptr, PrecomputedSchedule::create(makeHosts({1, MaxWeight})));
+  EXPECT_EQ(nullptr, PrecomputedSchedule::create(makeHosts({1, MaxWeight + 1})));
+}
+
+// Worker load balancers pick from the schedules built on the main thread as long as they see the
+// same hosts, and build their own otherwise.
+TEST_F(PrecomputedScheduleTest, SharedAcrossWorkers) {
+  HostVectorSharedPtr hosts = makeHosts({1, 2, 3});
+  main_priority_set_.updateHosts(
+      0, HostSetImpl::partitionHosts(hosts, HostsPerLocalityImpl::empty()), {}, *hosts, {},
+      absl::nullopt);
+  auto shared_schedules = std::make_shared<EdfLoadBalancerBase::SharedSchedules>();
+  shared_schedules->update(*main_priority_set_.hostSetsPerPriority()[0]);
+
+  PrioritySetImpl worker_priority_set_1;
+  PrioritySetImpl worker_priority_set_2;
+  updateWorker(worker_priority_set_1);
+  updateWorker(worker_priority_set_2);
+  auto lb_1 = createWorkerLb(worker_priority_set_1, shared_schedules);
+  auto lb_2 = createWorkerLb(worker_priority_set_2, shared_schedules);
+
+  // All hosts and healthy hosts are weighted; there are no degraded hosts.
+  EXPECT_EQ(2, EdfLoadBalancerBasePeer::sharedSchedulesInUse(*lb_1));
+  EXPECT_EQ(2, EdfLoadBalancerBasePeer::sharedSchedulesInUse(*lb_2));
+  for (auto* lb : {lb_1.get(), lb_2.get()}) {
+    auto counts = pickCounts(*lb, 60);
+    EXPECT_EQ(10, counts[(*hosts)[0]]);
+    EXPECT_EQ(20, counts[(*hosts)[1]]);
+    EXPECT_EQ(30, counts[(*hosts)[2]]);
+  }
+
+  // A peeked host is the next one picked.
+  HostConstSharedPtr peeked_1 = lb_1->peekAnotherHost(nullptr);
+  HostConstSharedPtr peeked_2 = lb_1->peekAnotherHost(nullptr);
+  EXPECT_EQ(peeked_1, lb_1->chooseHost(nullptr));
+  EXPECT_EQ(peeked_2, lb_1->chooseHost(nullptr));
+
+  // The second worker gets its hosts before the main thread has rebuilt the schedules, so it
+  // builds its own.
+  (*hosts)[0]->weight(4);
+  HostVectorSharedPtr new_hosts = std::make_shared<HostVector>(*hosts);
+  main_priority_set_.updateHosts(
+      0, HostSetImpl::partitionHosts(new_hosts, HostsPerLocalityImpl::empty()), {}, {}, {},
+      absl::nullopt);
+  updateWorker(worker_priority_set_2);
+  EXPECT_EQ(0, EdfLoadBalancerBasePeer::sharedSchedulesInUse(*lb_2));
+  auto counts = pickCounts(*lb_2, 90);
+  EXPECT_NEAR(40, counts[(*hosts)[0]], 1);
+  EXPECT_NEAR(20, counts[(*hosts)[1]], 1);
+  EXPECT_NEAR(30, counts[(*hosts)[2]], 1);
+
+  // The first worker catches up after the rebuild and keeps sharing.
+  shared_schedules->update(*main_priority_set_.hostSetsPerPriority()[0]);
+  updateWorker(worker_priority_set_1);
+  EXPECT_EQ(2, EdfLoadBalancerBasePeer::sharedSchedulesInUse(*lb_1));
+  counts = pickCounts(*lb_1, 90);
+  EXPECT_EQ(40, counts[(*hosts)[0]]);
+  EXPECT_EQ(20, counts[(*hosts)[1]]);
+  EXPECT_EQ(30, counts[(*hosts)[2]]);
+}
+
 TEST_P(RoundRobinLoadBalancerTest, MaxUnhealthyPanic) {
   hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", simTime()),
                               makeTestHost(info_, "tcp://127.0.0.1:81", simTime())};
@@ -3367,6 +3561,24 @@ TEST(LoadBalancerSubsetInfoImplTest, SubsetConfig) {
             envoy::config::cluster::v3::Cluster::LbSubsetConfig::LbSubsetSelector::ANY_ENDPOINT);
 }
 
+TEST(LoadBalancerSubsetInfoImplTest, LazySubsets) {
+  envoy::extensions::load_balancing_policies::subset::v3::Subset subset_config;
+  subset_config.add_subset_selectors()->add_keys("version");
+  EXPECT_EQ(0, LoadBalancerSubsetInfoImpl(subset_config).maxLazySubsets());
+
+  subset_config.mutable_lazy_subsets();
+  EXPECT_EQ(LoadBalancerSubsetInfoImpl::DefaultMaxLazySubsets,
+            LoadBalancerSubsetInfoImpl(subset_config).maxLazySubsets());
+
+  subset_config.mutable_lazy_subsets()->mutable_max_subsets()->set_value(16);
+  EXPECT_EQ(16, LoadBalancerSubsetInfoImpl(subset_config).maxLazySubsets());
+
+  // Subsets of the legacy cluster config are always built eagerly.
+  envoy::config::cluster::v3::Cluster::LbSubsetConfig legacy_subset_config;
+  legacy_subset_config.add_subset_selectors()->add_keys("version");
+  EXPECT_EQ(0, LoadBalancerSubsetInfoImpl(legacy_subset_config).maxLazySubsets());
+}
+
 TEST(LoadBalancerSubsetInfoImplTest, KeysSubsetFallbackValid) {
   auto subset_config = envoy::config::cluster::v3::Cluster::LbSubsetConfig::default_instance();
   auto selector1 = subset_config.mutable_subset_selectors()->Add();
@@ -1,5 +1,6 @@
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -23,6 +24,7 @@
 #include "test/mocks/upstream/host.h"
 #include "test/mocks/upstream/host_set.h"
 #include "test/test_common/simulated_time_system.h"
+#include "test/test_common/thread_factory_for_test.h"
 #include "test/test_common/utility.h"
 
 #include "absl/types/optional.h"
@@ -1243,6 +1245,61 @@ TEST_F(OutlierDetectorImplTest, BasicFlowSuccessRateExternalOrigin) {
                     DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
 }
 
+// Success rate ejection works the same when the request counts are accumulated per worker and
+// the results come from several threads.
+TEST_F(OutlierDetectorImplTest, SuccessRateAccumulatedPerWorker) {
+  ON_CALL(runtime_.snapshot_, getInteger(MaxEjectionPercentRuntime, _)).WillByDefault(Return(100));
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+
+  envoy::config::cluster::v3::OutlierDetection outlier_detection;
+  outlier_detection.set_accumulate_success_rate_per_worker(true);
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, outlier_detection, dispatcher_, runtime_, time_system_, event_logger_, random_));
+  EXPECT_TRUE(detector->config().accumulateSuccessRatePerWorker());
+  detector->addChangedStateCb([&](HostSharedPtr host) -> void { checker_.check(host); });
+
+  // Every worker alternates errors and successes on the last host, so that no run of consecutive
+  // errors is long enough to eject it.
+  EXPECT_CALL(dispatcher_, post(_)).Times(0);
+  std::vector<Thread::ThreadPtr> workers;
+  for (int i = 0; i < 4; i++) {
+    workers.push_back(Thread::threadFactoryForTest().createThread([this]() {
+      for (int rq = 0; rq < 25; rq++) {
+        loadRq(hosts_, 1, 200);
+        loadRq(hosts_[4], 1, 503);
+      }
+    }));
+  }
+  for (auto& worker : workers) {
+    worker->join();
+  }
+
+  time_system_.setMonotonicTime(std::chrono::milliseconds(10000));
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*event_logger_, logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]),
+                                       _, envoy::data::cluster::v3::SUCCESS_RATE, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  ON_CALL(runtime_.snapshot_, getInteger(SuccessRateStdevFactorRuntime, 1900))
+      .WillByDefault(Return(1900));
+  interval_timer_->invokeCallback();
+  EXPECT_EQ(50, hosts_[4]->outlierDetector().successRate(
+                    DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
+  EXPECT_EQ(90, detector->successRateAverage(
+                    DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
+  EXPECT_EQ(52, detector->successRateEjectionThreshold(
+                    DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
+  EXPECT_TRUE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, outlier_detection_ejections_active_.value());
+}
+
 // Test verifies that EXT_ORIGIN_REQUEST_FAILED and EXT_ORIGIN_REQUEST_SUCCESS cancel
 // each other in split mode.
 TEST_F(OutlierDetectorImplTest, ExternalOriginEventsWithSplit) {
@@ -2646,6 +2703,52 @@ TEST(OutlierDetectionEventLoggerImplTest, All) {
   Json::Factory::loadFromString(log6);
 }
 
+// The counts of an interval are only used once the writer is switched to the other bucket.
+TEST(SuccessRateAccumulatorTest, SwitchBuckets) {
+  SuccessRateAccumulator accumulator(false);
+  accumulator.incTotalReqCounter();
+  accumulator.incSuccessReqCounter();
+  accumulator.incTotalReqCounter();
+  EXPECT_FALSE(accumulator.getSuccessRateAndVolume().has_value());
+
+  accumulator.updateCurrentWriter();
+  EXPECT_EQ(std::make_pair(50.0, uint64_t(2)), accumulator.getSuccessRateAndVolume().value());
+
+  // The counts of the previous interval are discarded when the bucket is reused.
+  accumulator.incTotalReqCounter();
+  accumulator.updateCurrentWriter();
+  EXPECT_EQ(std::make_pair(0.0, uint64_t(1)), accumulator.getSuccessRateAndVolume().value());
+  accumulator.updateCurrentWriter();
+  EXPECT_FALSE(accumulator.getSuccessRateAndVolume().has_value());
+}
+
+// Counts accumulated by different threads are merged when the success rate is computed.
+TEST(SuccessRateAccumulatorTest, PerWorkerShardsMerged) {
+  SuccessRateAccumulator accumulator(true);
+  const auto load = [&accumulator](int num_rq, bool success) {
+    for (int i = 0; i < num_rq; i++) {
+      accumulator.incTotalReqCounter();
+      if (success) {
+        accumulator.incSuccessReqCounter();
+      }
+    }
+  };
+
+  std::vector<Thread::ThreadPtr> workers;
+  for (int i = 0; i < 8; i++) {
+    workers.push_back(Thread::threadFactoryForTest().createThread(
+        [&load, i]() { load(1000, i % 4 != 0); }));
+  }
+  load(1000, true);
+  for (auto& worker : workers) {
+    worker->join();
+  }
+
+  accumulator.updateCurrentWriter();
+  EXPECT_EQ(std::make_pair(700.0 / 9, uint64_t(9000)),
+            accumulator.getSuccessRateAndVolume().value());
+}
+
 TEST(OutlierUtility, SRThreshold) {
   std::vector<HostSuccessRatePair> data = {
       HostSuccessRatePair(nullptr, 50),  HostSuccessRatePair(nullptr, 100),
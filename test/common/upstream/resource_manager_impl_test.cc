@@ -166,6 +166,69 @@ TEST(ResourceManagerImplTest, RetryBudgetOverrideGauge) {
   EXPECT_EQ(100u, rm.maxConnectionsPerHost());
   rm.retries().dec();
 }
+
+// With sharded counts, updates are only added to the count and gauges once a shard has collected
+// a batch of them.
+TEST(ResourceManagerImplTest, ShardedCounts) {
+  NiceMock<Runtime::MockLoader> runtime;
+  Stats::IsolatedStoreImpl store;
+
+  auto stats = clusterCircuitBreakersStats(store);
+  // A maximum of 1024 results in batches of 4.
+  ResourceManagerImpl resource_manager(runtime,
+                                       "circuit_breakers.runtime_resource_manager_test.default.",
+                                       1024, 1024, 1024, 3, 1024, 100, stats, absl::nullopt,
+                                       absl::nullopt, true);
+
+  ResourceLimit& requests = resource_manager.requests();
+  for (int i = 0; i < 3; i++) {
+    requests.inc();
+  }
+  EXPECT_EQ(0U, requests.count());
+  EXPECT_EQ(1024U, stats.remaining_rq_.value());
+  requests.inc();
+  EXPECT_EQ(4U, requests.count());
+  EXPECT_EQ(1020U, stats.remaining_rq_.value());
+
+  requests.decBy(3);
+  EXPECT_EQ(4U, requests.count());
+  requests.dec();
+  EXPECT_EQ(0U, requests.count());
+  EXPECT_EQ(1024U, stats.remaining_rq_.value());
+
+  // Maximums that are too small for batches are counted exactly.
+  ResourceLimit& retries = resource_manager.retries();
+  retries.inc();
+  EXPECT_EQ(1U, retries.count());
+  EXPECT_EQ(2U, stats.remaining_retries_.value());
+  retries.dec();
+  EXPECT_EQ(0U, retries.count());
+}
+
+// The circuit breaker opens once the batched count reaches the maximum.
+TEST(ResourceManagerImplTest, ShardedCountsOpenCircuitBreaker) {
+  NiceMock<Runtime::MockLoader> runtime;
+  Stats::IsolatedStoreImpl store;
+
+  auto stats = clusterCircuitBreakersStats(store);
+  ResourceManagerImpl resource_manager(runtime,
+                                       "circuit_breakers.runtime_resource_manager_test.default.",
+                                       1024, 1024, 1024, 3, 1024, 100, stats, absl::nullopt,
+                                       absl::nullopt, true);
+
+  ResourceLimit& connections = resource_manager.connections();
+  while (connections.canCreate()) {
+    connections.inc();
+  }
+  EXPECT_EQ(1024U, connections.count());
+  EXPECT_EQ(1U, stats.cx_open_.value());
+  EXPECT_EQ(0U, stats.remaining_cx_.value());
+
+  connections.decBy(4);
+  EXPECT_TRUE(connections.canCreate());
+  EXPECT_EQ(0U, stats.cx_open_.value());
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
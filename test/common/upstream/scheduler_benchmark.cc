@@ -119,6 +119,58 @@ void uniqueWeightPickEdf(::benchmark::State& state) {
                             });
 }
 
+// Replaces state.range(1) of state.range(0) entries, either by rebuilding the schedule from scratch
+// or by applying the delta to the existing schedule.
+void uniqueWeightChurnEdf(::benchmark::State& state, bool incremental) {
+  const size_t num_objs = state.range(0);
+  const size_t num_changed = state.range(1);
+  std::vector<std::shared_ptr<SchedulerTester::ObjInfo>> info;
+  for (uint32_t i = 0; i < num_objs; ++i) {
+    auto oi = std::make_shared<SchedulerTester::ObjInfo>();
+    oi->weight = static_cast<double>(i + 1);
+    info.emplace_back(oi);
+  }
+  auto edf = std::make_unique<EdfScheduler<SchedulerTester::ObjInfo>>();
+  for (auto& oi : info) {
+    edf->add(oi->weight, oi);
+  }
+
+  size_t next_changed = 0;
+  // Replaced entries stay alive, like a host that only left one host source (e.g. became
+  // unhealthy) would.
+  std::vector<std::shared_ptr<SchedulerTester::ObjInfo>> removed;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    removed.clear();
+    for (size_t i = 0; i < num_changed; ++i) {
+      const size_t index = (next_changed++) % num_objs;
+      removed.push_back(info[index]);
+      info[index] = std::make_shared<SchedulerTester::ObjInfo>(*info[index]);
+    }
+    state.ResumeTiming();
+
+    if (incremental) {
+      for (size_t i = 0; i < num_changed; ++i) {
+        const size_t index = (next_changed - num_changed + i) % num_objs;
+        edf->remove(removed[i]);
+        edf->add(info[index]->weight, info[index]);
+      }
+    } else {
+      edf = std::make_unique<EdfScheduler<SchedulerTester::ObjInfo>>();
+      for (auto& oi : info) {
+        edf->add(oi->weight, oi);
+      }
+    }
+    edf->pickAndAdd([](const auto& i) { return i.weight; });
+  }
+}
+
+void uniqueWeightChurnRebuildEdf(::benchmark::State& state) { uniqueWeightChurnEdf(state, false); }
+
+void uniqueWeightChurnIncrementalEdf(::benchmark::State& state) {
+  uniqueWeightChurnEdf(state, true);
+}
+
 void splitWeightAddWRSQ(::benchmark::State& state) {
   Random::RandomGeneratorImpl random;
   WRSQScheduler<SchedulerTester::ObjInfo> wrsq(random);
@@ -178,6 +230,12 @@ BENCHMARK(uniqueWeightAddWRSQ)
     ->RangeMultiplier(8)
     ->Range(1 << 6, 1 << 14);
 BENCHMARK(uniqueWeightPickEdf)->RangeMultiplier(8)->Range(1 << 6, 1 << 14);
+BENCHMARK(uniqueWeightChurnRebuildEdf)
+    ->Unit(::benchmark::kMicrosecond)
+    ->ArgsProduct({{1 << 10, 1 << 14}, {1, 16, 256}});
+BENCHMARK(uniqueWeightChurnIncrementalEdf)
+    ->Unit(::benchmark::kMicrosecond)
+    ->ArgsProduct({{1 << 10, 1 << 14}, {1, 16, 256}});
 BENCHMARK(uniqueWeightPickWRSQ)->RangeMultiplier(8)->Range(1 << 6, 1 << 14);
 
 } // namespace
@@ -1359,6 +1359,111 @@ TEST_F(HostImplTest, Weight) {
   EXPECT_EQ(std::numeric_limits<uint32_t>::max(), host->weight());
 }
 
+TEST_F(HostImplTest, ShardedEndpointRequestCounts) {
+  MockClusterMockPrioritySet cluster;
+  HostSharedPtr host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime());
+  EXPECT_EQ(nullptr, host->stats().rq_active_shards_);
+
+  EXPECT_CALL(*cluster.info_, shardedEndpointRequestCountsEnabled()).WillOnce(Return(true));
+  host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime());
+  ASSERT_NE(nullptr, host->stats().rq_active_shards_);
+  host->stats().incRqActive();
+  EXPECT_EQ(0U, host->stats().rq_active_.value());
+  EXPECT_EQ(1, host->stats().rq_active_shards_->pending());
+  host->stats().decRqActive();
+}
+
+TEST_F(HostImplTest, StatsAllocatedOnFirstUse) {
+  MockClusterMockPrioritySet cluster;
+  HostSharedPtr host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime());
+
+  // Reading the stats of every host, as admin and stats flushing do, does not allocate them.
+  EXPECT_CALL(*cluster.info_, shardedEndpointRequestCountsEnabled()).Times(0);
+  for (const auto& [name, counter] : host->counters()) {
+    EXPECT_EQ(0, counter.get().latch()) << name;
+  }
+  for (const auto& [name, gauge] : host->gauges()) {
+    EXPECT_EQ(0, gauge.get().value()) << name;
+  }
+
+  EXPECT_CALL(*cluster.info_, shardedEndpointRequestCountsEnabled());
+  host->stats().rq_total_.inc();
+  host->stats().cx_active_.inc();
+  EXPECT_EQ(&host->stats(), &host->stats());
+  for (const auto& [name, counter] : host->counters()) {
+    EXPECT_EQ(name == "rq_total" ? 1 : 0, counter.get().value()) << name;
+  }
+  for (const auto& [name, gauge] : host->gauges()) {
+    EXPECT_EQ(name == "cx_active" ? 1 : 0, gauge.get().value()) << name;
+  }
+  host->stats().cx_active_.dec();
+}
+
+TEST_F(HostImplTest, LocalityShared) {
+  MockClusterMockPrioritySet cluster;
+  envoy::config::core::v3::Locality locality;
+  locality.set_region("oceania");
+  locality.set_zone("hello");
+  envoy::config::core::v3::Locality other_locality = locality;
+  other_locality.set_sub_zone("world");
+
+  HostSharedPtr host1 = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime(), locality);
+  HostSharedPtr host2 = makeTestHost(cluster.info_, "tcp://10.0.0.2:1234", simTime(), locality);
+  HostSharedPtr host3 =
+      makeTestHost(cluster.info_, "tcp://10.0.0.3:1234", simTime(), other_locality);
+  EXPECT_EQ(&host1->locality(), &host2->locality());
+  EXPECT_NE(&host1->locality(), &host3->locality());
+  EXPECT_EQ("world", host3->locality().sub_zone());
+  EXPECT_EQ(host1->localityZoneStatName(), host3->localityZoneStatName());
+  EXPECT_EQ("hello", cluster.info_->statsScope().symbolTable().toString(
+                         host1->localityZoneStatName()));
+
+  // The locality outlives any of its hosts, and is interned again once they are all gone.
+  host1.reset();
+  EXPECT_EQ("oceania", host2->locality().region());
+  host2.reset();
+  host1 = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime(), locality);
+  EXPECT_EQ("hello", host1->locality().zone());
+  EXPECT_EQ("", host1->locality().sub_zone());
+}
+
+// Reports the bytes per host of a cluster with many endpoints, before and after their stats are
+// first used. The hosts share their cluster and locality, and each has an address of its own, as
+// EDS hosts do. Hosts which are never used do not pay for their stats, which with sharded request
+// counts is most of the memory of a used host.
+TEST_F(HostImplTest, MemoryPerHost) {
+  constexpr uint32_t NumHosts = 1000;
+  MockClusterMockPrioritySet cluster;
+  ON_CALL(*cluster.info_, shardedEndpointRequestCountsEnabled()).WillByDefault(Return(true));
+  envoy::config::core::v3::Locality locality;
+  locality.set_region("us-east-1");
+  locality.set_zone("us-east-1a");
+  // Interns the locality up front, so that it is not accounted to the measured hosts.
+  HostSharedPtr first_host =
+      makeTestHost(cluster.info_, "tcp://10.1.0.1:80", simTime(), locality);
+  HostVector hosts;
+  hosts.reserve(NumHosts);
+
+  Stats::TestUtil::MemoryTest unused_memory_test;
+  for (uint32_t i = 0; i < NumHosts; i++) {
+    const std::string url = absl::StrCat("tcp://10.0.", i / 256, ".", i % 256, ":80");
+    hosts.push_back(makeTestHost(cluster.info_, url, simTime(), locality));
+  }
+  const size_t unused_bytes_per_host = unused_memory_test.consumedBytes() / NumHosts;
+
+  Stats::TestUtil::MemoryTest used_memory_test;
+  for (const HostSharedPtr& host : hosts) {
+    host->stats().rq_total_.inc();
+  }
+  const size_t used_bytes_per_host =
+      unused_bytes_per_host + used_memory_test.consumedBytes() / NumHosts;
+
+  ENVOY_LOG_MISC(info, "bytes per host: {} before first use, {} after", unused_bytes_per_host,
+                 used_bytes_per_host);
+  EXPECT_MEMORY_LE(unused_bytes_per_host, 600);
+  EXPECT_MEMORY_LE(used_bytes_per_host, 1800);
+}
+
 TEST_F(HostImplTest, HostnameCanaryAndLocality) {
   MockClusterMockPrioritySet cluster;
   envoy::config::core::v3::Metadata metadata;
@@ -3900,6 +4005,29 @@ TEST_F(ClusterInfoImplTest, TestTrackRequestResponseSizesNotSetInConfig) {
   EXPECT_FALSE(cluster->info()->requestResponseSizeStats().has_value());
 }
 
+TEST_F(ClusterInfoImplTest, ShardedEndpointRequestCounts) {
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: LEAST_REQUEST
+    track_cluster_stats: { sharded_endpoint_request_counts : true }
+  )EOF";
+
+  auto cluster = makeCluster(yaml);
+  EXPECT_TRUE(cluster->info()->shardedEndpointRequestCountsEnabled());
+
+  const std::string yaml_disabled = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: LEAST_REQUEST
+  )EOF";
+
+  cluster = makeCluster(yaml_disabled);
+  EXPECT_FALSE(cluster->info()->shardedEndpointRequestCountsEnabled());
+}
+
 TEST_F(ClusterInfoImplTest, TestTrackRequestResponseSizes) {
   const std::string yaml = R"EOF(
     name: name
@@ -3968,6 +4096,43 @@ TEST_F(ClusterInfoImplTest, TestTrackRemainingResourcesGauges) {
   EXPECT_EQ(4U, high_remaining_retries.value());
 }
 
+TEST_F(ClusterInfoImplTest, ShardedCircuitBreakerCounts) {
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+
+    circuit_breakers:
+      thresholds:
+      - priority: DEFAULT
+        max_requests: 1024
+      - priority: HIGH
+        max_requests: 1024
+        sharded_counts: true
+  )EOF";
+
+  auto cluster = makeCluster(yaml);
+
+  ResourceLimit& default_requests =
+      cluster->info()->resourceManager(ResourcePriority::Default).requests();
+  default_requests.inc();
+  EXPECT_EQ(1U, default_requests.count());
+  default_requests.dec();
+
+  // The high priority requests are counted in batches of 4.
+  ResourceLimit& high_requests =
+      cluster->info()->resourceManager(ResourcePriority::High).requests();
+  high_requests.inc();
+  EXPECT_EQ(0U, high_requests.count());
+  for (int i = 0; i < 3; i++) {
+    high_requests.inc();
+  }
+  EXPECT_EQ(4U, high_requests.count());
+  high_requests.decBy(4);
+  EXPECT_EQ(0U, high_requests.count());
+}
+
 TEST_F(ClusterInfoImplTest, DefaultConnectTimeout) {
   const std::string yaml = R"EOF(
   name: cluster1
@@ -16,6 +16,9 @@
 #include "test/mocks/ssl/mocks.h"
 #include "test/mocks/stream_info/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "absl/synchronization/notification.h"
 
 using testing::_;
 using testing::InSequence;
@@ -51,9 +54,10 @@ public:
       const Grpc::RawAsyncClientSharedPtr& client,
       const envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig& config,
       Event::Dispatcher& dispatcher, Stats::Scope& scope, std::string access_log_prefix,
-      const Protobuf::MethodDescriptor& service_method, bool stream)
+      const Protobuf::MethodDescriptor& service_method, bool stream,
+      Common::GrpcAccessLogSerializerSharedPtr serializer = nullptr)
       : GrpcAccessLogger(std::move(client), config, dispatcher, scope, access_log_prefix,
-                         service_method, stream) {}
+                         service_method, stream, std::move(serializer)) {}
 
   int numInits() const { return num_inits_; }
 
@@ -469,6 +473,149 @@ TEST_F(UnaryGrpcAccessLogTest, Flushing) {
   timer_->invokeCallback();
 }
 
+class AsyncSerializationGrpcAccessLogTest : public testing::Test {
+public:
+  using MockAccessLogStream = Grpc::MockAsyncStream;
+  using AccessLogCallbacks = Grpc::AsyncStreamCallbacks<ProtobufWkt::Struct>;
+
+  AsyncSerializationGrpcAccessLogTest()
+      : serializer_(
+            std::make_shared<Common::GrpcAccessLogSerializer>(Thread::threadFactoryForTest())) {}
+
+  void initLogger(uint32_t max_pending_batches) {
+    timer_ = new Event::MockTimer(&dispatcher_);
+    EXPECT_CALL(*timer_, enableTimer(_, _));
+    // Flush on every entry.
+    config_.mutable_buffer_size_bytes()->set_value(0);
+    config_.mutable_async_serialization()->mutable_max_pending_batches()->set_value(
+        max_pending_batches);
+
+    logger_ = std::make_unique<MockGrpcAccessLoggerImpl>(
+        Grpc::RawAsyncClientPtr{async_client_}, config_, dispatcher_, *stats_store_.rootScope(),
+        "mock_access_log_prefix.", mockMethodDescriptor(), true, serializer_);
+  }
+
+  // Waits for the serialization thread to hand a batch back to the worker dispatcher, and returns
+  // the callback that sends it.
+  Event::PostCb waitForSerializedBatch() {
+    absl::Notification posted;
+    Event::PostCb send_batch;
+    EXPECT_CALL(dispatcher_, post(_)).WillOnce(Invoke([&](Event::PostCb cb) {
+      send_batch = std::move(cb);
+      posted.Notify();
+    }));
+    logger_->log(mockHttpEntry());
+    posted.WaitForNotification();
+    return send_batch;
+  }
+
+  ProtobufWkt::Struct mockHttpEntry() {
+    ProtobufWkt::Struct entry;
+    entry.mutable_fields()->insert({"test-key", ProtobufWkt::Value()});
+    return entry;
+  }
+
+  uint64_t pendingBatches() {
+    return TestUtility::findGauge(stats_store_,
+                                  "mock_access_log_prefix.pending_serialization_batches")
+        ->value();
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  Event::MockTimer* timer_ = nullptr;
+  Event::MockDispatcher dispatcher_;
+  Grpc::MockAsyncClient* async_client_{new Grpc::MockAsyncClient};
+  Common::GrpcAccessLogSerializerSharedPtr serializer_;
+  std::unique_ptr<MockGrpcAccessLoggerImpl> logger_;
+  envoy::extensions::access_loggers::grpc::v3::CommonGrpcAccessLogConfig config_;
+};
+
+// Test that batches are serialized off the worker and then sent from the worker dispatcher.
+TEST_F(AsyncSerializationGrpcAccessLogTest, BasicFlow) {
+  initLogger(16);
+
+  Event::PostCb send_batch = waitForSerializedBatch();
+  // Every batch carries the identifier, and the batch is moved rather than cleared.
+  EXPECT_EQ(1, logger_->numInits());
+  EXPECT_EQ(0, logger_->numClears());
+  EXPECT_EQ(1, pendingBatches());
+
+  MockAccessLogStream stream;
+  AccessLogCallbacks* callbacks;
+  EXPECT_CALL(*async_client_, startRaw(_, _, _, _))
+      .WillOnce(Invoke([&stream, &callbacks](absl::string_view, absl::string_view,
+                                             Grpc::RawAsyncStreamCallbacks& cbs,
+                                             const Http::AsyncClient::StreamOptions&) {
+        callbacks = dynamic_cast<AccessLogCallbacks*>(&cbs);
+        return &stream;
+      }));
+  EXPECT_CALL(stream, isAboveWriteBufferHighWatermark()).WillOnce(Return(false));
+  EXPECT_CALL(stream, sendMessageRaw_(_, false))
+      .WillOnce(Invoke([](Buffer::InstancePtr& request, bool) {
+        ProtobufWkt::Struct message;
+        Buffer::ZeroCopyInputStreamImpl request_stream(std::move(request));
+        EXPECT_TRUE(message.ParseFromZeroCopyStream(&request_stream));
+        EXPECT_EQ(message.fields().at(MOCK_HTTP_LOG_FIELD_NAME).number_value(), 1);
+      }));
+  send_batch();
+  EXPECT_EQ(0, pendingBatches());
+
+  // The next batch starts from an empty message.
+  send_batch = waitForSerializedBatch();
+  EXPECT_EQ(2, logger_->numInits());
+  EXPECT_CALL(stream, isAboveWriteBufferHighWatermark()).WillOnce(Return(false));
+  EXPECT_CALL(stream, sendMessageRaw_(_, false))
+      .WillOnce(Invoke([](Buffer::InstancePtr& request, bool) {
+        ProtobufWkt::Struct message;
+        Buffer::ZeroCopyInputStreamImpl request_stream(std::move(request));
+        EXPECT_TRUE(message.ParseFromZeroCopyStream(&request_stream));
+        EXPECT_EQ(message.fields().at(MOCK_HTTP_LOG_FIELD_NAME).number_value(), 1);
+      }));
+  send_batch();
+  EXPECT_EQ(2,
+            TestUtility::findCounter(stats_store_, "mock_access_log_prefix.logs_written")->value());
+  EXPECT_EQ(0,
+            TestUtility::findCounter(stats_store_, "mock_access_log_prefix.logs_dropped")->value());
+}
+
+// Test that batches flushed while too many are outstanding are dropped, as are serialized batches
+// that cannot be sent because the stream is backed up.
+TEST_F(AsyncSerializationGrpcAccessLogTest, DropsWhenBackedUp) {
+  initLogger(1);
+
+  Event::PostCb send_batch = waitForSerializedBatch();
+  EXPECT_EQ(1, pendingBatches());
+
+  // The previous batch has not been sent yet, so this one is dropped without being serialized.
+  EXPECT_CALL(dispatcher_, post(_)).Times(0);
+  logger_->log(mockHttpEntry());
+  EXPECT_EQ(1,
+            TestUtility::findCounter(stats_store_, "mock_access_log_prefix.logs_dropped")->value());
+  EXPECT_EQ(1, logger_->numClears());
+
+  MockAccessLogStream stream;
+  EXPECT_CALL(*async_client_, startRaw(_, _, _, _)).WillOnce(Return(&stream));
+  EXPECT_CALL(stream, isAboveWriteBufferHighWatermark()).WillOnce(Return(true));
+  EXPECT_CALL(stream, sendMessageRaw_(_, _)).Times(0);
+  send_batch();
+  EXPECT_EQ(0, pendingBatches());
+  EXPECT_EQ(2,
+            TestUtility::findCounter(stats_store_, "mock_access_log_prefix.logs_dropped")->value());
+}
+
+// Test that a batch completing after its logger is gone is discarded.
+TEST_F(AsyncSerializationGrpcAccessLogTest, LoggerDestroyedWithBatchInFlight) {
+  initLogger(16);
+
+  Event::PostCb send_batch = waitForSerializedBatch();
+  EXPECT_EQ(1, pendingBatches());
+  logger_.reset();
+  EXPECT_EQ(0, pendingBatches());
+
+  EXPECT_CALL(*async_client_, startRaw(_, _, _, _)).Times(0);
+  send_batch();
+}
+
 class MockGrpcAccessLoggerCache
     : public Common::GrpcAccessLoggerCache<
           MockGrpcAccessLoggerImpl,
@@ -476,7 +623,7 @@ class MockGrpcAccessLoggerCache
 public:
   MockGrpcAccessLoggerCache(Grpc::AsyncClientManager& async_client_manager, Stats::Scope& scope,
                             ThreadLocal::SlotAllocator& tls)
-      : GrpcAccessLoggerCache(async_client_manager, scope, tls) {}
+      : GrpcAccessLoggerCache(async_client_manager, scope, tls, Thread::threadFactoryForTest()) {}
 
 private:
   // Common::GrpcAccessLoggerCache
@@ -6,6 +6,7 @@
 #include "source/common/protobuf/protobuf.h"
 #include "source/extensions/access_loggers/common/file_access_log_impl.h"
 #include "source/extensions/access_loggers/file/config.h"
+#include "source/extensions/access_loggers/file/protobuf_file_access_log_impl.h"
 
 #include "test/mocks/server/factory_context.h"
 #include "test/test_common/utility.h"
@@ -175,6 +176,46 @@ TEST_F(FileAccessLogTest, LogFormatJson) {
       true);
 }
 
+TEST_F(FileAccessLogTest, ProtobufFormat) {
+  const std::string yaml = R"(
+  path: "/foo"
+  protobuf_format:
+    additional_request_headers_to_log:
+    - "x-custom"
+)";
+  envoy::extensions::access_loggers::file::v3::FileAccessLog fal_config;
+  TestUtility::loadFromYaml(yaml, fal_config);
+
+  envoy::config::accesslog::v3::AccessLog config;
+  config.mutable_typed_config()->PackFrom(fal_config);
+
+  auto file = std::make_shared<AccessLog::MockAccessLogFile>();
+  Filesystem::FilePathAndType file_info{Filesystem::DestinationType::File, fal_config.path()};
+  EXPECT_CALL(context_.access_log_manager_, createAccessLog(file_info)).WillOnce(Return(file));
+
+  AccessLog::InstanceSharedPtr logger = AccessLog::AccessLogFactory::fromProto(config, context_);
+  stream_info_.setResponseCode(200);
+  request_headers_.addCopy("x-custom", "value");
+
+  std::string written;
+  EXPECT_CALL(*file, write(_)).Times(2).WillRepeatedly(Invoke([&written](absl::string_view got) {
+    written.append(got.data(), got.size());
+  }));
+  logger->log({&request_headers_, &response_headers_, &response_trailers_}, stream_info_);
+  logger->log({&request_headers_, &response_headers_, &response_trailers_}, stream_info_);
+
+  absl::string_view remaining = written;
+  for (int i = 0; i < 2; ++i) {
+    envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+    ASSERT_TRUE(DelimitedProtobufUtil::parseNext(remaining, entry).ok());
+    EXPECT_EQ("/bar/foo", entry.request().path());
+    EXPECT_EQ(envoy::config::core::v3::GET, entry.request().request_method());
+    EXPECT_EQ("value", entry.request().request_headers().at("x-custom"));
+    EXPECT_EQ(200, entry.response().response_code().value());
+  }
+  EXPECT_TRUE(remaining.empty());
+}
+
 } // namespace
 } // namespace File
 } // namespace AccessLoggers
@@ -0,0 +1,94 @@
+#include "envoy/data/accesslog/v3/accesslog.pb.h"
+
+#include "source/extensions/access_loggers/file/protobuf_file_access_log_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace File {
+namespace {
+
+envoy::data::accesslog::v3::HTTPAccessLogEntry makeEntry(const std::string& path) {
+  envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+  entry.mutable_request()->set_path(path);
+  entry.mutable_response()->mutable_response_code()->set_value(200);
+  return entry;
+}
+
+TEST(DelimitedProtobufUtilTest, RoundTrip) {
+  std::string data;
+  std::string record;
+  for (const std::string path : {"/a", "/b", std::string(300, 'c')}) {
+    DelimitedProtobufUtil::serialize(makeEntry(path), record);
+    data.append(record);
+  }
+
+  absl::string_view remaining = data;
+  envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+  for (const std::string path : {"/a", "/b", std::string(300, 'c')}) {
+    ASSERT_TRUE(DelimitedProtobufUtil::parseNext(remaining, entry).ok());
+    EXPECT_TRUE(TestUtility::protoEqual(makeEntry(path), entry));
+  }
+  EXPECT_TRUE(remaining.empty());
+}
+
+TEST(DelimitedProtobufUtilTest, EmptyMessage) {
+  std::string record;
+  DelimitedProtobufUtil::serialize(envoy::data::accesslog::v3::HTTPAccessLogEntry(), record);
+  EXPECT_EQ(std::string(1, '\0'), record);
+
+  absl::string_view remaining = record;
+  envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+  EXPECT_TRUE(DelimitedProtobufUtil::parseNext(remaining, entry).ok());
+  EXPECT_TRUE(remaining.empty());
+}
+
+TEST(DelimitedProtobufUtilTest, ReusedBufferShrinks) {
+  std::string record;
+  DelimitedProtobufUtil::serialize(makeEntry(std::string(300, 'c')), record);
+  const size_t long_size = record.size();
+  DelimitedProtobufUtil::serialize(makeEntry("/a"), record);
+  EXPECT_LT(record.size(), long_size);
+
+  absl::string_view remaining = record;
+  envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+  EXPECT_TRUE(DelimitedProtobufUtil::parseNext(remaining, entry).ok());
+  EXPECT_EQ("/a", entry.request().path());
+}
+
+TEST(DelimitedProtobufUtilTest, TruncatedRecord) {
+  std::string record;
+  DelimitedProtobufUtil::serialize(makeEntry("/foo"), record);
+
+  absl::string_view truncated(record.data(), record.size() - 1);
+  envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+  const absl::Status status = DelimitedProtobufUtil::parseNext(truncated, entry);
+  EXPECT_FALSE(status.ok());
+  EXPECT_THAT(std::string(status.message()), testing::HasSubstr("truncated record"));
+  // Nothing is consumed on failure.
+  EXPECT_EQ(record.size() - 1, truncated.size());
+}
+
+TEST(DelimitedProtobufUtilTest, TruncatedLength) {
+  // A varint with the continuation bit set and nothing after it.
+  absl::string_view data("\x80", 1);
+  envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+  EXPECT_EQ("truncated record length", DelimitedProtobufUtil::parseNext(data, entry).message());
+}
+
+TEST(DelimitedProtobufUtilTest, MalformedRecord) {
+  // Length 2 followed by a tag for field 0, which is invalid.
+  absl::string_view data("\x02\x00\x00", 3);
+  envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+  EXPECT_EQ("malformed record", DelimitedProtobufUtil::parseNext(data, entry).message());
+}
+
+} // namespace
+} // namespace File
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -13,6 +13,7 @@
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/stats/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/thread_factory_for_test.h"
 
 using testing::_;
 using testing::Invoke;
@@ -132,7 +133,8 @@ class GrpcAccessLoggerCacheImplTest : public testing::Test {
 public:
   GrpcAccessLoggerCacheImplTest()
       : async_client_(new Grpc::MockAsyncClient), factory_(new Grpc::MockAsyncClientFactory),
-        logger_cache_(async_client_manager_, scope_, tls_, local_info_),
+        logger_cache_(async_client_manager_, scope_, tls_, Thread::threadFactoryForTest(),
+                      local_info_),
         grpc_access_logger_impl_test_helper_(local_info_, async_client_) {
     EXPECT_CALL(async_client_manager_, factoryForGrpcService(_, _, true))
         .WillOnce(Invoke([this](const envoy::config::core::v3::GrpcService&, Stats::Scope&, bool) {
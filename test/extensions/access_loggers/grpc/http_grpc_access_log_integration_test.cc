@@ -56,6 +56,9 @@ public:
           common_config->set_transport_api_version(envoy::config::core::v3::ApiVersion::V3);
           setGrpcService(*common_config->mutable_grpc_service(), "accesslog",
                          fake_upstreams_.back()->localAddress());
+          if (async_serialization_) {
+            common_config->mutable_async_serialization();
+          }
           access_log->mutable_typed_config()->PackFrom(config);
         });
 
@@ -116,6 +119,7 @@ public:
 
   FakeHttpConnectionPtr fake_access_log_connection_;
   FakeStreamPtr access_log_request_;
+  bool async_serialization_{false};
 };
 
 INSTANTIATE_TEST_SUITE_P(IpVersionsCientType, AccessLogIntegrationTest,
@@ -245,6 +249,59 @@ http_logs:
   cleanup();
 }
 
+// Test that batches serialized off the worker reach the collector, each with the identifier.
+TEST_P(AccessLogIntegrationTest, AsyncSerializationFlow) {
+  async_serialization_ = true;
+  const std::string expected_request = R"EOF(
+identifier:
+  node:
+    id: node_name
+    cluster: cluster_name
+    locality:
+      zone: zone_name
+    user_agent_name: "envoy"
+  log_name: foo
+http_logs:
+  log_entry:
+    common_properties:
+      response_flags:
+        no_route_found: true
+      downstream_wire_bytes_sent: 178
+      downstream_wire_bytes_received: 38
+      access_log_type: DownstreamEnd
+    protocol_version: HTTP11
+    request:
+      scheme: http
+      authority: host
+      downstream_header_bytes_received: 11
+      path: /notfound
+      request_headers_bytes: 118
+      request_method: GET
+    response:
+      downstream_header_bytes_sent: 152
+      response_code:
+        value: 404
+      response_code_details: "route_not_found"
+      response_headers_bytes: 131
+)EOF";
+
+  testRouterNotFound();
+  ASSERT_TRUE(waitForAccessLogConnection());
+  ASSERT_TRUE(waitForAccessLogStream());
+  ASSERT_TRUE(waitForAccessLogRequest(expected_request));
+
+  BufferingStreamDecoderPtr response = IntegrationUtil::makeSingleRequest(
+      lookupPort("http"), "GET", "/notfound", "", downstream_protocol_, version_);
+  EXPECT_TRUE(response->complete());
+  EXPECT_EQ("404", response->headers().getStatusValue());
+  // Unlike the synchronous path, the identifier is repeated on the same stream.
+  ASSERT_TRUE(waitForAccessLogRequest(expected_request));
+
+  test_server_->waitForGaugeEq("access_logs.grpc_access_log.pending_serialization_batches", 0);
+  EXPECT_EQ(0, test_server_->counter("access_logs.grpc_access_log.logs_dropped")->value());
+  cleanup();
+}
+
 // Regression test to make sure that configuring upstream logs over gRPC will not crash Envoy.
 // TODO(asraa): Test output of the upstream logs.
 // See https://github.com/envoyproxy/envoy/issues/8828.
@@ -12,7 +12,9 @@
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/stats/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/thread_factory_for_test.h"
 
+#include "absl/synchronization/notification.h"
 #include "opentelemetry/proto/collector/logs/v1/logs_service.pb.h"
 #include "opentelemetry/proto/common/v1/common.pb.h"
 #include "opentelemetry/proto/logs/v1/logs.pb.h"
@@ -48,19 +50,20 @@ public:
     }
   }
 
-  void expectSentMessage(const std::string& expected_message_yaml) {
+  void expectSentMessage(const std::string& expected_message_yaml,
+                         Grpc::AsyncRequest* in_flight_request = nullptr) {
     opentelemetry::proto::collector::logs::v1::ExportLogsServiceRequest expected_message;
     TestUtility::loadFromYaml(expected_message_yaml, expected_message);
     EXPECT_CALL(*async_client_, sendRaw(_, _, _, _, _, _))
-        .WillOnce(Invoke([expected_message](absl::string_view, absl::string_view,
-                                            Buffer::InstancePtr&& request,
-                                            Grpc::RawAsyncRequestCallbacks&, Tracing::Span&,
-                                            const Http::AsyncClient::RequestOptions&) {
+        .WillOnce(Invoke([expected_message, in_flight_request](
+                             absl::string_view, absl::string_view, Buffer::InstancePtr&& request,
+                             Grpc::RawAsyncRequestCallbacks&, Tracing::Span&,
+                             const Http::AsyncClient::RequestOptions&) {
           opentelemetry::proto::collector::logs::v1::ExportLogsServiceRequest message;
           Buffer::ZeroCopyInputStreamImpl request_stream(std::move(request));
           EXPECT_TRUE(message.ParseFromZeroCopyStream(&request_stream));
           EXPECT_EQ(message.DebugString(), expected_message.DebugString());
-          return nullptr; // We don't care about the returned request.
+          return in_flight_request;
         }));
   }
 
@@ -121,11 +124,102 @@ TEST_F(GrpcAccessLoggerImplTest, Log) {
   logger_->log(ProtobufWkt::Empty());
 }
 
+class AsyncSerializationGrpcAccessLoggerImplTest : public testing::Test {
+public:
+  AsyncSerializationGrpcAccessLoggerImplTest()
+      : async_client_(new Grpc::MockAsyncClient), timer_(new Event::MockTimer(&dispatcher_)),
+        serializer_(
+            std::make_shared<Common::GrpcAccessLogSerializer>(Thread::threadFactoryForTest())),
+        grpc_access_logger_impl_test_helper_(local_info_, async_client_, true) {
+    EXPECT_CALL(*timer_, enableTimer(_, _));
+    *config_.mutable_common_config()->mutable_log_name() = "test_log_name";
+    config_.mutable_common_config()->mutable_buffer_size_bytes()->set_value(BUFFER_SIZE_BYTES);
+    config_.mutable_common_config()->mutable_async_serialization();
+    logger_ = std::make_unique<GrpcAccessLoggerImpl>(Grpc::RawAsyncClientPtr{async_client_},
+                                                     config_, dispatcher_, local_info_,
+                                                     *stats_store_.rootScope(), serializer_);
+  }
+
+  // Logs an entry, which flushes it as a batch of its own, and returns the callback that sends the
+  // batch once the serialization thread has posted it back to the worker.
+  Event::PostCb logAndWaitForSerializedBatch(const std::string& severity_text) {
+    absl::Notification posted;
+    Event::PostCb send_batch;
+    EXPECT_CALL(dispatcher_, post(_)).WillOnce(Invoke([&](Event::PostCb cb) {
+      send_batch = std::move(cb);
+      posted.Notify();
+    }));
+    opentelemetry::proto::logs::v1::LogRecord entry;
+    entry.set_severity_text(severity_text);
+    logger_->log(std::move(entry));
+    posted.WaitForNotification();
+    return send_batch;
+  }
+
+  std::string expectedMessage(const std::string& severity_text) {
+    return fmt::format(R"EOF(
+  resource_logs:
+    resource:
+      attributes:
+        - key: "log_name"
+          value:
+            string_value: "test_log_name"
+        - key: "zone_name"
+          value:
+            string_value: "zone_name"
+        - key: "cluster_name"
+          value:
+            string_value: "cluster_name"
+        - key: "node_name"
+          value:
+            string_value: "node_name"
+    scope_logs:
+      - log_records:
+          - severity_text: "{}"
+  )EOF",
+                       severity_text);
+  }
+
+  Grpc::MockAsyncClient* async_client_;
+  Stats::IsolatedStoreImpl stats_store_;
+  LocalInfo::MockLocalInfo local_info_;
+  Event::MockDispatcher dispatcher_;
+  Event::MockTimer* timer_;
+  Common::GrpcAccessLogSerializerSharedPtr serializer_;
+  std::unique_ptr<GrpcAccessLoggerImpl> logger_;
+  GrpcAccessLoggerImplTestHelper grpc_access_logger_impl_test_helper_;
+  envoy::extensions::access_loggers::open_telemetry::v3::OpenTelemetryAccessLogConfig config_;
+};
+
+// Test that a batch handed off while the previous one is still in flight only carries its own log
+// records, and that the resource kept in the logger for later batches is sent with both.
+TEST_F(AsyncSerializationGrpcAccessLoggerImplTest, BatchHandedOffWhileSendInFlight) {
+  Event::PostCb send_first = logAndWaitForSerializedBatch("first");
+  Grpc::MockAsyncRequest first_request;
+  grpc_access_logger_impl_test_helper_.expectSentMessage(expectedMessage("first"),
+                                                         &first_request);
+  send_first();
+
+  // The first request has not completed when the second batch is taken from the logger.
+  Event::PostCb send_second = logAndWaitForSerializedBatch("second");
+  grpc_access_logger_impl_test_helper_.expectSentMessage(expectedMessage("second"));
+  send_second();
+
+  EXPECT_EQ(2, TestUtility::findCounter(stats_store_,
+                                        "access_logs.open_telemetry_access_log.logs_written")
+                   ->value());
+  EXPECT_EQ(0, TestUtility::findGauge(
+                   stats_store_,
+                   "access_logs.open_telemetry_access_log.pending_serialization_batches")
+                   ->value());
+}
+
 class GrpcAccessLoggerCacheImplTest : public testing::Test {
 public:
   GrpcAccessLoggerCacheImplTest()
       : async_client_(new Grpc::MockAsyncClient), factory_(new Grpc::MockAsyncClientFactory),
-        logger_cache_(async_client_manager_, scope_, tls_, local_info_),
+        logger_cache_(async_client_manager_, scope_, tls_, Thread::threadFactoryForTest(),
+                      local_info_),
         grpc_access_logger_impl_test_helper_(local_info_, async_client_, true) {
     EXPECT_CALL(async_client_manager_, factoryForGrpcService(_, _, true))
         .WillOnce(Invoke([this](const envoy::config::core::v3::GrpcService&, Stats::Scope&, bool) {
@@ -247,7 +341,8 @@ class GrpcAccessLoggerDisableBuiltinImplTest : public testing::Test {
 public:
   GrpcAccessLoggerDisableBuiltinImplTest()
       : async_client_(new Grpc::MockAsyncClient), factory_(new Grpc::MockAsyncClientFactory),
-        logger_cache_(async_client_manager_, scope_, tls_, local_info_),
+        logger_cache_(async_client_manager_, scope_, tls_, Thread::threadFactoryForTest(),
+                      local_info_),
         grpc_access_logger_impl_test_helper_(local_info_, async_client_, false) {
     EXPECT_CALL(async_client_manager_, factoryForGrpcService(_, _, true))
         .WillOnce(Invoke([this](const envoy::config::core::v3::GrpcService&, Stats::Scope&, bool) {
@@ -270,6 +270,124 @@ TEST_F(ClusterTest, BasicFlow) {
   EXPECT_EQ(nullptr, lb_->chooseHost(setHostAndReturnContext("host1:0")));
 }
 
+// A worker uses a host resolved by the DNS cache before the main thread added it to the cluster.
+TEST_F(ClusterTest, WorkerLocalHost) {
+  initialize(default_yaml_config_, false);
+  makeTestHost("host1:0", "1.2.3.4");
+  InSequence s;
+
+  EXPECT_CALL(*dns_cache_manager_->dns_cache_, getHost(absl::string_view("host1:0")))
+      .WillOnce(Return(
+          absl::optional<const Common::DynamicForwardProxy::DnsHostInfoSharedPtr>(
+              host_map_["host1:0"])));
+  EXPECT_CALL(*host_map_["host1:0"], touch());
+  Upstream::HostConstSharedPtr host = lb_->chooseHost(setHostAndReturnContext("host1:0"));
+  ASSERT_NE(nullptr, host);
+  EXPECT_EQ("1.2.3.4:0", host->address()->asString());
+  EXPECT_EQ(0UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+
+  // The same host is used until and after the main thread adds it to the priority set.
+  EXPECT_CALL(*host_map_["host1:0"], touch());
+  EXPECT_EQ(host, lb_->chooseHost(setHostAndReturnContext("host1:0")));
+  EXPECT_CALL(*this, onMemberUpdateCb(SizeIs(1), SizeIs(0)));
+  update_callbacks_->onDnsHostAddOrUpdate("host1:0", host_map_["host1:0"]);
+  ASSERT_EQ(1UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+  EXPECT_EQ(host, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[0]);
+  EXPECT_CALL(*host_map_["host1:0"], touch());
+  EXPECT_EQ(host, lb_->chooseHost(setHostAndReturnContext("host1:0")));
+
+  // Hosts the DNS cache does not know about are not created.
+  EXPECT_CALL(*dns_cache_manager_->dns_cache_, getHost(absl::string_view("host2:0")))
+      .WillOnce(Return(absl::nullopt));
+  EXPECT_EQ(nullptr, lb_->chooseHost(setHostAndReturnContext("host2:0")));
+}
+
+// A worker created host which is removed before the main thread added it is not reported as
+// removed from the priority set.
+TEST_F(ClusterTest, WorkerLocalHostRemoved) {
+  initialize(default_yaml_config_, false);
+  makeTestHost("host1:0", "1.2.3.4");
+
+  EXPECT_CALL(*dns_cache_manager_->dns_cache_, getHost(absl::string_view("host1:0")))
+      .WillOnce(Return(
+          absl::optional<const Common::DynamicForwardProxy::DnsHostInfoSharedPtr>(
+              host_map_["host1:0"])));
+  EXPECT_CALL(*host_map_["host1:0"], touch());
+  EXPECT_NE(nullptr, lb_->chooseHost(setHostAndReturnContext("host1:0")));
+
+  EXPECT_CALL(*this, onMemberUpdateCb(_, _)).Times(0);
+  update_callbacks_->onDnsHostRemove("host1:0");
+  EXPECT_CALL(*dns_cache_manager_->dns_cache_, getHost(absl::string_view("host1:0")))
+      .WillOnce(Return(absl::nullopt));
+  EXPECT_EQ(nullptr, lb_->chooseHost(setHostAndReturnContext("host1:0")));
+}
+
+// A host which the DNS cache removes while a worker creates it is not added back to the host map.
+TEST_F(ClusterTest, WorkerLocalHostRemovedConcurrently) {
+  initialize(default_yaml_config_, false);
+  makeTestHost("host1:0", "1.2.3.4");
+  InSequence s;
+
+  EXPECT_CALL(*this, onMemberUpdateCb(_, _)).Times(0);
+  // The main thread processes the removal right after the worker read the DNS cache, which has
+  // erased the host by then.
+  EXPECT_CALL(*dns_cache_manager_->dns_cache_, getHost(absl::string_view("host1:0")))
+      .WillOnce(Invoke([&](absl::string_view) {
+        update_callbacks_->onDnsHostRemove("host1:0");
+        return absl::optional<const Common::DynamicForwardProxy::DnsHostInfoSharedPtr>(
+            host_map_["host1:0"]);
+      }))
+      .WillOnce(Return(absl::nullopt));
+  EXPECT_EQ(nullptr, lb_->chooseHost(setHostAndReturnContext("host1:0")));
+
+  // The next request still goes to the DNS cache rather than to a stale host.
+  EXPECT_CALL(*dns_cache_manager_->dns_cache_, getHost(absl::string_view("host1:0")))
+      .WillOnce(Return(absl::nullopt));
+  EXPECT_EQ(nullptr, lb_->chooseHost(setHostAndReturnContext("host1:0")));
+}
+
+// New hosts of the DNS cache are added to the priority set in a batch.
+TEST_F(ClusterTest, BatchedHostAdds) {
+  initialize(default_yaml_config_, false);
+  makeTestHost("host1:0", "1.2.3.4");
+  makeTestHost("host2:0", "1.2.3.5");
+  makeTestHost("host3:0", "1.2.3.6");
+
+  Event::PostCb add_hosts;
+  EXPECT_CALL(server_context_.dispatcher_, post(_)).WillOnce([&](Event::PostCb callback) {
+    add_hosts = std::move(callback);
+  });
+  EXPECT_CALL(*this, onMemberUpdateCb(_, _)).Times(0);
+  update_callbacks_->onDnsHostAddOrUpdate("host1:0", host_map_["host1:0"]);
+  update_callbacks_->onDnsHostAddOrUpdate("host2:0", host_map_["host2:0"]);
+  update_callbacks_->onDnsHostAddOrUpdate("host3:0", host_map_["host3:0"]);
+  // A host removed before the batch is added is dropped.
+  update_callbacks_->onDnsHostRemove("host3:0");
+  testing::Mock::VerifyAndClearExpectations(this);
+
+  EXPECT_CALL(*this, onMemberUpdateCb(SizeIs(2), SizeIs(0)));
+  add_hosts();
+  EXPECT_EQ(2UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+}
+
+// With the runtime guard disabled, new hosts are only available once added by the main thread.
+TEST_F(ClusterTest, WorkerLocalHostDisabled) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.dfp_worker_local_hosts", "false"}});
+  initialize(default_yaml_config_, false);
+  makeTestHost("host1:0", "1.2.3.4");
+
+  EXPECT_CALL(*dns_cache_manager_->dns_cache_, getHost(_)).Times(0);
+  EXPECT_EQ(nullptr, lb_->chooseHost(setHostAndReturnContext("host1:0")));
+
+  EXPECT_CALL(server_context_.dispatcher_, post(_)).Times(0);
+  EXPECT_CALL(*this, onMemberUpdateCb(SizeIs(1), SizeIs(0)));
+  update_callbacks_->onDnsHostAddOrUpdate("host1:0", host_map_["host1:0"]);
+  EXPECT_CALL(*host_map_["host1:0"], touch());
+  EXPECT_EQ("1.2.3.4:0",
+            lb_->chooseHost(setHostAndReturnContext("host1:0"))->address()->asString());
+}
+
 // Outlier detection
 TEST_F(ClusterTest, OutlierDetection) {
   initialize(default_yaml_config_, false);
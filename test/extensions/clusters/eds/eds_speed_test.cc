@@ -144,12 +144,68 @@ public:
     // this is what we're actually testing:
     validation_visitor_.setSkipValidation(ignore_unknown_dynamic_fields);
 
+    auto response = makeResponse(cluster_load_assignment);
+    state_.ResumeTiming();
+    receiveResponse(std::move(response));
+    ASSERT(cluster_->prioritySet().hostSetsPerPriority()[1]->hostsPerLocality().get()[0].size() ==
+           num_hosts);
+  }
+
+  // Loads a cluster of healthy hosts, and then repeatedly changes a single endpoint of it. Only
+  // the updates which change the endpoint are timed.
+  void singleEndpointChangeHelper(size_t num_hosts, bool remove) {
+    envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
+    cluster_load_assignment.set_cluster_name("fare");
+    auto* endpoints = cluster_load_assignment.add_endpoints();
+    endpoints->mutable_locality()->set_zone("zone");
+    for (size_t i = 0; i < num_hosts; ++i) {
+      auto* lb_endpoint = endpoints->add_lb_endpoints();
+      lb_endpoint->set_health_status(envoy::config::core::v3::HEALTHY);
+      auto* socket_address =
+          lb_endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address();
+      socket_address->set_address("10.0.1." + std::to_string(i / 60000));
+      socket_address->set_port_value(1000 + i % 60000);
+    }
+    validation_visitor_.setSkipValidation(true);
+    receiveResponse(makeResponse(cluster_load_assignment));
+
+    const envoy::config::endpoint::v3::LbEndpoint changed_endpoint = endpoints->lb_endpoints(0);
+    size_t updates = 0;
+    for (auto _ : state_) { // NOLINT: Silences warning about dead store
+      state_.PauseTiming();
+      // Alternate between changing the first endpoint and changing it back.
+      if (remove) {
+        if (updates % 2 == 0) {
+          endpoints->mutable_lb_endpoints()->DeleteSubrange(0, 1);
+        } else {
+          *endpoints->mutable_lb_endpoints()->Add() = changed_endpoint;
+          endpoints->mutable_lb_endpoints()->SwapElements(0, endpoints->lb_endpoints_size() - 1);
+        }
+      } else {
+        endpoints->mutable_lb_endpoints(0)->set_health_status(
+            updates % 2 == 0 ? envoy::config::core::v3::UNHEALTHY
+                             : envoy::config::core::v3::HEALTHY);
+      }
+      auto response = makeResponse(cluster_load_assignment);
+      state_.ResumeTiming();
+      receiveResponse(std::move(response));
+      updates++;
+    }
+    ASSERT(cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size() >= num_hosts - 1);
+  }
+
+  std::unique_ptr<envoy::service::discovery::v3::DiscoveryResponse> makeResponse(
+      const envoy::config::endpoint::v3::ClusterLoadAssignment& cluster_load_assignment) {
     auto response = std::make_unique<envoy::service::discovery::v3::DiscoveryResponse>();
     response->set_type_url(type_url_);
     response->set_version_info(fmt::format("version-{}", version_++));
     auto* resource = response->mutable_resources()->Add();
     resource->PackFrom(cluster_load_assignment);
-    state_.ResumeTiming();
+    return response;
+  }
+
+  void
+  receiveResponse(std::unique_ptr<envoy::service::discovery::v3::DiscoveryResponse>&& response) {
     if (use_unified_mux_) {
       dynamic_cast<Config::XdsMux::GrpcMuxSotw&>(*grpc_mux_)
           .grpcStreamForTest()
@@ -159,8 +215,6 @@ public:
           .grpcStreamForTest()
           .onReceiveMessage(std::move(response));
     }
-    ASSERT(cluster_->prioritySet().hostSetsPerPriority()[1]->hostsPerLocality().get()[0].size() ==
-           num_hosts);
   }
 
   NiceMock<Server::Configuration::MockServerFactoryContext> server_context_;
@@ -241,3 +295,22 @@ static void healthOnlyUpdate(State& state) {
 }
 
 BENCHMARK(healthOnlyUpdate)->Ranges({{1, 100000}, {false, true}})->Unit(benchmark::kMillisecond);
+
+// Measures updates of a single endpoint of a large cluster, with and without applying them as a
+// delta to the existing hosts.
+static void singleEndpointChange(State& state) {
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Context logging_state(spdlog::level::warn,
+                                       Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock, false);
+  Envoy::TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues(
+      {{"envoy.reloadable_features.eds_delta_host_update", state.range(2) ? "true" : "false"}});
+
+  Envoy::Upstream::EdsSpeedTest speed_test(state, false);
+  uint32_t endpoints = skipExpensiveBenchmarks() ? 1 : state.range(0);
+  speed_test.singleEndpointChangeHelper(endpoints, state.range(1));
+}
+
+BENCHMARK(singleEndpointChange)
+    ->Ranges({{1, 20000}, {false, true}, {false, true}})
+    ->Unit(benchmark::kMillisecond);
@@ -693,6 +693,214 @@ TEST_F(EdsTest, EndpointHealthStatus) {
             stats_.findCounterByString("cluster.name.update_no_rebuild").value().get().value());
 }
 
+// Validate that an update which only changes the health status of an endpoint is applied as a
+// delta to the existing hosts.
+TEST_F(EdsTest, DeltaUpdateHealthStatus) {
+  envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
+  cluster_load_assignment.set_cluster_name("fare");
+  auto* endpoints = cluster_load_assignment.add_endpoints();
+  for (uint32_t port = 80; port < 83; ++port) {
+    auto* socket_address = endpoints->add_lb_endpoints()
+                               ->mutable_endpoint()
+                               ->mutable_address()
+                               ->mutable_socket_address();
+    socket_address->set_address("1.2.3.4");
+    socket_address->set_port_value(port);
+  }
+
+  initialize();
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_TRUE(initialized_);
+  EXPECT_EQ(0UL, stats_.findCounterByString("cluster.name.update_delta").value().get().value());
+  const HostVector initial_hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  ASSERT_EQ(3, initial_hosts.size());
+  EXPECT_EQ(3, cluster_->prioritySet().hostSetsPerPriority()[0]->healthyHosts().size());
+
+  // The same hosts are updated in place, without any membership change.
+  auto member_update_cb =
+      cluster_->prioritySet().addMemberUpdateCb([&](const auto& added, const auto& removed) {
+        EXPECT_TRUE(added.empty());
+        EXPECT_TRUE(removed.empty());
+      });
+  endpoints->mutable_lb_endpoints(1)->set_health_status(envoy::config::core::v3::UNHEALTHY);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(1UL, stats_.findCounterByString("cluster.name.update_delta").value().get().value());
+  EXPECT_EQ(0UL,
+            stats_.findCounterByString("cluster.name.update_no_rebuild").value().get().value());
+  {
+    auto& hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+    EXPECT_EQ(initial_hosts, hosts);
+    EXPECT_EQ(envoy::config::core::v3::UNHEALTHY, hosts[1]->edsHealthStatus());
+    EXPECT_EQ(Host::Health::Unhealthy, hosts[1]->coarseHealth());
+    EXPECT_EQ(2, cluster_->prioritySet().hostSetsPerPriority()[0]->healthyHosts().size());
+  }
+
+  // A health status change which does not change the health of the host does not rebuild.
+  endpoints->mutable_lb_endpoints(1)->set_health_status(envoy::config::core::v3::DRAINING);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(2UL, stats_.findCounterByString("cluster.name.update_delta").value().get().value());
+  EXPECT_EQ(1UL,
+            stats_.findCounterByString("cluster.name.update_no_rebuild").value().get().value());
+  EXPECT_EQ(envoy::config::core::v3::DRAINING,
+            cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[1]->edsHealthStatus());
+
+  // So does an identical update.
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(3UL, stats_.findCounterByString("cluster.name.update_delta").value().get().value());
+  EXPECT_EQ(2UL,
+            stats_.findCounterByString("cluster.name.update_no_rebuild").value().get().value());
+}
+
+// Validate that added and removed endpoints are applied as a delta, keeping the hosts of the other
+// endpoints and the order of the update.
+TEST_F(EdsTest, DeltaUpdateAddAndRemoveEndpoints) {
+  envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
+  cluster_load_assignment.set_cluster_name("fare");
+  auto* endpoints = cluster_load_assignment.add_endpoints();
+  auto add_endpoint = [endpoints](uint32_t port, uint32_t weight) {
+    auto* lb_endpoint = endpoints->add_lb_endpoints();
+    auto* socket_address =
+        lb_endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address();
+    socket_address->set_address("1.2.3.4");
+    socket_address->set_port_value(port);
+    lb_endpoint->mutable_load_balancing_weight()->set_value(weight);
+  };
+  add_endpoint(80, 1);
+  add_endpoint(81, 1);
+  add_endpoint(82, 1);
+
+  initialize();
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  const HostVector initial_hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  ASSERT_EQ(3, initial_hosts.size());
+
+  HostVector hosts_added;
+  HostVector hosts_removed;
+  auto member_update_cb =
+      cluster_->prioritySet().addMemberUpdateCb([&](const auto& added, const auto& removed) {
+        hosts_added = added;
+        hosts_removed = removed;
+      });
+
+  // Remove the endpoint in the middle and add one at the front.
+  endpoints->mutable_lb_endpoints()->DeleteSubrange(1, 1);
+  add_endpoint(79, 5);
+  endpoints->mutable_lb_endpoints()->SwapElements(0, 2);
+  endpoints->mutable_lb_endpoints()->SwapElements(1, 2);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(1UL, stats_.findCounterByString("cluster.name.update_delta").value().get().value());
+  EXPECT_EQ(5UL, stats_.findGaugeByString("cluster.name.max_host_weight").value().get().value());
+
+  auto& hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  ASSERT_EQ(3, hosts.size());
+  EXPECT_EQ(79, hosts[0]->address()->ip()->port());
+  EXPECT_EQ(5, hosts[0]->weight());
+  EXPECT_EQ(initial_hosts[0], hosts[1]);
+  EXPECT_EQ(initial_hosts[2], hosts[2]);
+  ASSERT_EQ(1, hosts_added.size());
+  EXPECT_EQ(hosts[0], hosts_added[0]);
+  ASSERT_EQ(1, hosts_removed.size());
+  EXPECT_EQ(initial_hosts[1], hosts_removed[0]);
+  EXPECT_EQ(1, cluster_->prioritySet().crossPriorityHostMap()->count("1.2.3.4:79"));
+  EXPECT_EQ(0, cluster_->prioritySet().crossPriorityHostMap()->count("1.2.3.4:81"));
+
+  // The removed endpoint can be added back.
+  add_endpoint(81, 1);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(2UL, stats_.findCounterByString("cluster.name.update_delta").value().get().value());
+  ASSERT_EQ(4, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+  EXPECT_NE(initial_hosts[1], cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[3]);
+}
+
+// Validate that changes to anything but the health status and the set of endpoints are applied as
+// a full update.
+TEST_F(EdsTest, DeltaUpdateFallsBackToFullUpdate) {
+  envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
+  cluster_load_assignment.set_cluster_name("fare");
+  auto* endpoints = cluster_load_assignment.add_endpoints();
+  endpoints->mutable_locality()->set_zone("zone");
+  auto* lb_endpoint = endpoints->add_lb_endpoints();
+  auto* socket_address =
+      lb_endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address();
+  socket_address->set_address("1.2.3.4");
+  socket_address->set_port_value(80);
+
+  initialize();
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  auto delta_updates = [this]() {
+    return stats_.findCounterByString("cluster.name.update_delta").value().get().value();
+  };
+
+  // Endpoint weight.
+  lb_endpoint->mutable_load_balancing_weight()->set_value(2);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(0UL, delta_updates());
+  EXPECT_EQ(2, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[0]->weight());
+
+  // Endpoint metadata.
+  Config::Metadata::mutableMetadataValue(*lb_endpoint->mutable_metadata(),
+                                         Config::MetadataFilters::get().ENVOY_LB, "canary")
+      .set_bool_value(true);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(0UL, delta_updates());
+  EXPECT_TRUE(cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[0]->canary());
+
+  // Locality weight.
+  endpoints->mutable_load_balancing_weight()->set_value(3);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(0UL, delta_updates());
+
+  // Overprovisioning factor.
+  cluster_load_assignment.mutable_policy()->mutable_overprovisioning_factor()->set_value(200);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(0UL, delta_updates());
+  EXPECT_EQ(200, cluster_->prioritySet().hostSetsPerPriority()[0]->overprovisioningFactor());
+
+  // An endpoint moved to another priority.
+  endpoints->set_priority(1);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(0UL, delta_updates());
+  EXPECT_EQ(0, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+  EXPECT_EQ(1, cluster_->prioritySet().hostSetsPerPriority()[1]->hosts().size());
+
+  // A duplicate endpoint.
+  *endpoints->add_lb_endpoints() = *lb_endpoint;
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(0UL, delta_updates());
+  EXPECT_EQ(1, cluster_->prioritySet().hostSetsPerPriority()[1]->hosts().size());
+
+  // Nothing was indexed for an update with duplicate endpoints.
+  endpoints->mutable_lb_endpoints()->RemoveLast();
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(0UL, delta_updates());
+
+  // Finally, the same update is applied as a delta.
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(1UL, delta_updates());
+}
+
+// Validate that updates are never applied as a delta when the runtime guard is disabled.
+TEST_F(EdsTest, DeltaUpdateDisabledByRuntime) {
+  TestScopedRuntime runtime;
+  runtime.mergeValues({{"envoy.reloadable_features.eds_delta_host_update", "false"}});
+
+  envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
+  cluster_load_assignment.set_cluster_name("fare");
+  auto* lb_endpoint = cluster_load_assignment.add_endpoints()->add_lb_endpoints();
+  auto* socket_address =
+      lb_endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address();
+  socket_address->set_address("1.2.3.4");
+  socket_address->set_port_value(80);
+
+  initialize();
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  lb_endpoint->set_health_status(envoy::config::core::v3::UNHEALTHY);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(0UL, stats_.findCounterByString("cluster.name.update_delta").value().get().value());
+  EXPECT_EQ(Host::Health::Unhealthy,
+            cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[0]->coarseHealth());
+}
+
 // Validate that onConfigUpdate() updates the hostname.
 TEST_F(EdsTest, Hostname) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
@@ -594,6 +594,71 @@ TEST_F(OriginalDstClusterTest, Membership2) {
   EXPECT_EQ(0UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
 }
 
+// Load balancers keep using the host map they were created with while hosts are added and removed.
+TEST_F(OriginalDstClusterTest, ManyHosts) {
+  std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 1.250s
+    type: ORIGINAL_DST
+    lb_policy: CLUSTER_PROVIDED
+  )EOF";
+
+  EXPECT_CALL(initialized_, ready());
+  setupFromYaml(yaml);
+
+  constexpr size_t NumHosts = 100;
+  std::vector<std::unique_ptr<NiceMock<Network::MockConnection>>> connections;
+  std::vector<std::unique_ptr<TestLoadBalancerContext>> lb_contexts;
+  for (size_t i = 0; i < NumHosts; i++) {
+    connections.push_back(std::make_unique<NiceMock<Network::MockConnection>>());
+    connections.back()->stream_info_.downstream_connection_info_provider_->restoreLocalAddress(
+        std::make_shared<Network::Address::Ipv4Instance>(absl::StrCat("10.10.", i, ".11")));
+    lb_contexts.push_back(std::make_unique<TestLoadBalancerContext>(connections.back().get()));
+  }
+
+  // The hosts are added to the cluster inline by the mock dispatcher.
+  OriginalDstCluster::LoadBalancer empty_lb(handle_);
+  std::vector<HostConstSharedPtr> hosts;
+  EXPECT_CALL(membership_updated_, ready()).Times(NumHosts);
+  for (size_t i = 0; i < NumHosts; i++) {
+    hosts.push_back(OriginalDstCluster::LoadBalancer(handle_).chooseHost(lb_contexts[i].get()));
+    ASSERT_NE(nullptr, hosts.back());
+  }
+  EXPECT_EQ(NumHosts, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+
+  // A load balancer created after the additions finds all the hosts.
+  OriginalDstCluster::LoadBalancer full_lb(handle_);
+  for (size_t i = 0; i < NumHosts; i++) {
+    EXPECT_EQ(hosts[i], full_lb.chooseHost(lb_contexts[i].get()));
+  }
+
+  // The load balancer created before the additions creates new hosts.
+  EXPECT_CALL(membership_updated_, ready()).Times(0);
+  EXPECT_CALL(server_context_.dispatcher_, post(_));
+  HostConstSharedPtr new_host = empty_lb.chooseHost(lb_contexts[0].get());
+  ASSERT_NE(nullptr, new_host);
+  EXPECT_NE(hosts[0], new_host);
+
+  // Only the hosts which are used again survive the cleanup.
+  EXPECT_CALL(*cleanup_timer_, enableTimer(_, _)).Times(2);
+  cleanup_timer_->invokeCallback();
+  for (size_t i = 0; i < NumHosts; i += 2) {
+    EXPECT_EQ(hosts[i], full_lb.chooseHost(lb_contexts[i].get()));
+  }
+  EXPECT_CALL(membership_updated_, ready());
+  cleanup_timer_->invokeCallback();
+  EXPECT_EQ(NumHosts / 2, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+
+  // The removals do not affect the existing load balancers.
+  EXPECT_EQ(hosts[1], full_lb.chooseHost(lb_contexts[1].get()));
+  OriginalDstCluster::LoadBalancer lb(handle_);
+  for (size_t i = 0; i < NumHosts; i += 2) {
+    EXPECT_EQ(hosts[i], lb.chooseHost(lb_contexts[i].get()));
+  }
+  EXPECT_CALL(server_context_.dispatcher_, post(_));
+  EXPECT_NE(hosts[1], lb.chooseHost(lb_contexts[1].get()));
+}
+
 TEST_F(OriginalDstClusterTest, Connection) {
   std::string yaml = R"EOF(
     name: name
@@ -494,7 +494,11 @@ TEST_F(DnsCacheImplTest, TTL) {
   // Re-resolve with ~1m passed. This is not realistic as we would have re-resolved many times
   // during this period but it's good enough for the test.
   simTime().advanceTimeWait(std::chrono::seconds(60000));
-  EXPECT_CALL(update_callbacks_, onDnsHostRemove("foo.com:80"));
+  // The host is already erased when the remove callbacks run.
+  EXPECT_CALL(update_callbacks_, onDnsHostRemove("foo.com:80"))
+      .WillOnce(Invoke([this](const std::string& host) {
+        EXPECT_EQ(absl::nullopt, dns_cache_->getHost(host));
+      }));
   resolve_timer->invokeCallback();
   checkStats(2 /* attempt */, 2 /* success */, 0 /* failure */, 1 /* address changed */,
              1 /* added */, 1 /* removed */, 0 /* num hosts */);
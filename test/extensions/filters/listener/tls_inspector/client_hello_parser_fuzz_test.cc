@@ -0,0 +1,118 @@
+#include <string>
+
+#include "source/extensions/filters/listener/tls_inspector/client_hello_parser.h"
+
+#include "test/fuzz/fuzz_runner.h"
+#include "test/fuzz/utility.h"
+
+#include "absl/strings/string_view.h"
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ListenerFilters {
+namespace TlsInspector {
+namespace {
+
+// What BoringSSL makes of the start of a connection, as seen from the callbacks the TLS inspector
+// uses.
+struct BoringSslResult {
+  bool select_certificate_called{false};
+  uint16_t version{0};
+  // The negotiated version, if BoringSSL got as far as the server name callback.
+  uint16_t negotiated_version{0};
+  std::string cipher_suites;
+  std::string extensions;
+  std::string server_name;
+};
+
+BoringSslResult parseWithBoringSsl(const uint8_t* buf, size_t len, uint16_t min_version,
+                                   uint16_t max_version) {
+  bssl::UniquePtr<SSL_CTX> ctx(SSL_CTX_new(TLS_with_buffers_method()));
+  SSL_CTX_set_min_proto_version(ctx.get(), min_version);
+  SSL_CTX_set_max_proto_version(ctx.get(), max_version);
+  SSL_CTX_set_select_certificate_cb(
+      ctx.get(), [](const SSL_CLIENT_HELLO* client_hello) -> ssl_select_cert_result_t {
+        auto* result = static_cast<BoringSslResult*>(SSL_get_app_data(client_hello->ssl));
+        result->select_certificate_called = true;
+        result->version = client_hello->version;
+        result->cipher_suites.assign(reinterpret_cast<const char*>(client_hello->cipher_suites),
+                                     client_hello->cipher_suites_len);
+        result->extensions.assign(reinterpret_cast<const char*>(client_hello->extensions),
+                                  client_hello->extensions_len);
+        result->server_name = absl::NullSafeStringView(
+            SSL_get_servername(client_hello->ssl, TLSEXT_NAMETYPE_host_name));
+        return ssl_select_cert_success;
+      });
+  // Stop the handshake where the TLS inspector does, once the version is negotiated.
+  SSL_CTX_set_tlsext_servername_callback(ctx.get(), [](SSL* ssl, int* out_alert, void*) -> int {
+    static_cast<BoringSslResult*>(SSL_get_app_data(ssl))->negotiated_version = SSL_version(ssl);
+    *out_alert = SSL_AD_USER_CANCELLED;
+    return SSL_TLSEXT_ERR_ALERT_FATAL;
+  });
+
+  BoringSslResult result;
+  bssl::UniquePtr<SSL> ssl(SSL_new(ctx.get()));
+  SSL_set_app_data(ssl.get(), &result);
+  SSL_set_accept_state(ssl.get());
+  BIO* bio = BIO_new_mem_buf(buf, len);
+  BIO_set_mem_eof_return(bio, -1);
+  SSL_set0_rbio(ssl.get(), bio);
+  SSL_do_handshake(ssl.get());
+  return result;
+}
+
+absl::string_view toStringView(const uint8_t* data, size_t len) {
+  return {reinterpret_cast<const char*>(data), len};
+}
+
+// Checks the parser against BoringSSL: whatever the parser decides on its own has to be what
+// BoringSSL decides, up to the contents of the extensions the parser doesn't validate. Narrower
+// version ranges check the version negotiation of hellos which don't offer the latest versions.
+void checkAgainstBoringSsl(const uint8_t* buf, size_t len, uint16_t min_version,
+                           uint16_t max_version) {
+  const ClientHelloParser parser(min_version, max_version);
+  ParsedClientHello client_hello;
+  size_t bytes_processed = 0;
+  const ClientHelloParser::Result result = parser.parse(buf, len, client_hello, bytes_processed);
+  const BoringSslResult boringssl_result = parseWithBoringSsl(buf, len, min_version, max_version);
+
+  switch (result) {
+  case ClientHelloParser::Result::NeedMoreData:
+    FUZZ_ASSERT(!boringssl_result.select_certificate_called);
+    break;
+  case ClientHelloParser::Result::NotTls:
+    FUZZ_ASSERT(bytes_processed == SSL3_RT_HEADER_LENGTH);
+    FUZZ_ASSERT(!boringssl_result.select_certificate_called);
+    break;
+  case ClientHelloParser::Result::ClientHello:
+    FUZZ_ASSERT(bytes_processed <= len);
+    FUZZ_ASSERT(boringssl_result.select_certificate_called);
+    FUZZ_ASSERT(boringssl_result.version == client_hello.client_hello.version);
+    FUZZ_ASSERT(boringssl_result.cipher_suites ==
+                toStringView(client_hello.client_hello.cipher_suites,
+                             client_hello.client_hello.cipher_suites_len));
+    FUZZ_ASSERT(boringssl_result.extensions ==
+                toStringView(client_hello.client_hello.extensions,
+                             client_hello.client_hello.extensions_len));
+    FUZZ_ASSERT(boringssl_result.server_name == client_hello.server_name);
+    FUZZ_ASSERT(boringssl_result.negotiated_version == 0 ||
+                boringssl_result.negotiated_version == client_hello.version);
+    break;
+  case ClientHelloParser::Result::Unsupported:
+    break;
+  }
+}
+
+} // namespace
+
+DEFINE_FUZZER(const uint8_t* buf, size_t len) {
+  checkAgainstBoringSsl(buf, len, TLS1_VERSION, TLS1_3_VERSION);
+  checkAgainstBoringSsl(buf, len, TLS1_VERSION, TLS1_1_VERSION);
+  checkAgainstBoringSsl(buf, len, TLS1_2_VERSION, TLS1_2_VERSION);
+}
+
+} // namespace TlsInspector
+} // namespace ListenerFilters
+} // namespace Extensions
+} // namespace Envoy
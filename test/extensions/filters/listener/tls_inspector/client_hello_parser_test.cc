@@ -0,0 +1,453 @@
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "source/extensions/filters/listener/tls_inspector/client_hello_parser.h"
+
+#include "test/extensions/filters/listener/tls_inspector/tls_utility.h"
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+#include "openssl/bytestring.h"
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ListenerFilters {
+namespace TlsInspector {
+namespace {
+
+using Result = ClientHelloParser::Result;
+using Bytes = std::vector<uint8_t>;
+
+// The type of the encrypted_client_hello extension of a ClientHelloOuter and ClientHelloInner.
+constexpr uint8_t EchClientOuter = 0;
+constexpr uint8_t EchClientInner = 1;
+
+Bytes finish(CBB* cbb) {
+  EXPECT_TRUE(CBB_flush(cbb));
+  return Bytes(CBB_data(cbb), CBB_data(cbb) + CBB_len(cbb));
+}
+
+Bytes serverName(absl::string_view name, uint8_t name_type = TLSEXT_NAMETYPE_host_name) {
+  bssl::ScopedCBB cbb;
+  CBB server_name_list, host_name;
+  EXPECT_TRUE(CBB_init(cbb.get(), 0));
+  EXPECT_TRUE(CBB_add_u16_length_prefixed(cbb.get(), &server_name_list));
+  EXPECT_TRUE(CBB_add_u8(&server_name_list, name_type));
+  EXPECT_TRUE(CBB_add_u16_length_prefixed(&server_name_list, &host_name));
+  EXPECT_TRUE(
+      CBB_add_bytes(&host_name, reinterpret_cast<const uint8_t*>(name.data()), name.size()));
+  return finish(cbb.get());
+}
+
+Bytes supportedVersions(const std::vector<uint16_t>& versions) {
+  bssl::ScopedCBB cbb;
+  CBB list;
+  EXPECT_TRUE(CBB_init(cbb.get(), 0));
+  EXPECT_TRUE(CBB_add_u8_length_prefixed(cbb.get(), &list));
+  for (const uint16_t version : versions) {
+    EXPECT_TRUE(CBB_add_u16(&list, version));
+  }
+  return finish(cbb.get());
+}
+
+Bytes encryptedClientHello(uint8_t type, size_t payload_len) {
+  bssl::ScopedCBB cbb;
+  CBB enc, payload;
+  EXPECT_TRUE(CBB_init(cbb.get(), 0));
+  EXPECT_TRUE(CBB_add_u8(cbb.get(), type));
+  // HKDF-SHA256 and AES-128-GCM, then the config id.
+  EXPECT_TRUE(CBB_add_u16(cbb.get(), 0x0001));
+  EXPECT_TRUE(CBB_add_u16(cbb.get(), 0x0001));
+  EXPECT_TRUE(CBB_add_u8(cbb.get(), 42));
+  EXPECT_TRUE(CBB_add_u16_length_prefixed(cbb.get(), &enc));
+  EXPECT_TRUE(CBB_add_zeros(&enc, 32));
+  EXPECT_TRUE(CBB_add_u16_length_prefixed(cbb.get(), &payload));
+  EXPECT_TRUE(CBB_add_zeros(&payload, payload_len));
+  return finish(cbb.get());
+}
+
+// The fields of a ClientHello, which can be set to anything.
+struct TestClientHello {
+  // The ClientHello handshake message.
+  Bytes message() const {
+    bssl::ScopedCBB cbb;
+    CBB body, session_id_cbb, cipher_suites_cbb, compression_methods_cbb, extensions_cbb;
+    EXPECT_TRUE(CBB_init(cbb.get(), 0));
+    EXPECT_TRUE(CBB_add_u8(cbb.get(), SSL3_MT_CLIENT_HELLO));
+    EXPECT_TRUE(CBB_add_u24_length_prefixed(cbb.get(), &body));
+    EXPECT_TRUE(CBB_add_u16(&body, version));
+    EXPECT_TRUE(CBB_add_zeros(&body, SSL3_RANDOM_SIZE));
+    EXPECT_TRUE(CBB_add_u8_length_prefixed(&body, &session_id_cbb));
+    EXPECT_TRUE(CBB_add_zeros(&session_id_cbb, session_id_len));
+    EXPECT_TRUE(CBB_add_u16_length_prefixed(&body, &cipher_suites_cbb));
+    EXPECT_TRUE(CBB_add_bytes(&cipher_suites_cbb, cipher_suites.data(), cipher_suites.size()));
+    EXPECT_TRUE(CBB_add_u8_length_prefixed(&body, &compression_methods_cbb));
+    EXPECT_TRUE(CBB_add_bytes(&compression_methods_cbb, compression_methods.data(),
+                              compression_methods.size()));
+    if (has_extensions) {
+      EXPECT_TRUE(CBB_add_u16_length_prefixed(&body, &extensions_cbb));
+      for (const auto& [type, contents] : extensions) {
+        CBB extension;
+        EXPECT_TRUE(CBB_add_u16(&extensions_cbb, type));
+        EXPECT_TRUE(CBB_add_u16_length_prefixed(&extensions_cbb, &extension));
+        EXPECT_TRUE(CBB_add_bytes(&extension, contents.data(), contents.size()));
+      }
+    }
+    return finish(cbb.get());
+  }
+
+  // The ClientHello in a single record.
+  Bytes record() const { return records(message()); }
+
+  // Puts a handshake message into records of at most max_fragment_len bytes.
+  static Bytes records(const Bytes& message, size_t max_fragment_len = SSL3_RT_MAX_PLAIN_LENGTH) {
+    bssl::ScopedCBB cbb;
+    EXPECT_TRUE(CBB_init(cbb.get(), 0));
+    for (size_t offset = 0; offset < message.size(); offset += max_fragment_len) {
+      CBB fragment;
+      EXPECT_TRUE(CBB_add_u8(cbb.get(), SSL3_RT_HANDSHAKE));
+      EXPECT_TRUE(CBB_add_u16(cbb.get(), TLS1_VERSION));
+      EXPECT_TRUE(CBB_add_u16_length_prefixed(cbb.get(), &fragment));
+      EXPECT_TRUE(CBB_add_bytes(&fragment, message.data() + offset,
+                                std::min(max_fragment_len, message.size() - offset)));
+    }
+    return finish(cbb.get());
+  }
+
+  uint16_t version{TLS1_2_VERSION};
+  size_t session_id_len{32};
+  // TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256 and TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384.
+  Bytes cipher_suites{0xc0, 0x2f, 0xc0, 0x30};
+  Bytes compression_methods{0};
+  bool has_extensions{true};
+  std::vector<std::pair<uint16_t, Bytes>> extensions{
+      {TLSEXT_TYPE_server_name, serverName("example.com")}};
+};
+
+class ClientHelloParserTest : public testing::Test {
+protected:
+  Result parse(const Bytes& data) {
+    return parser_.parse(data.data(), data.size(), client_hello_, bytes_processed_);
+  }
+
+  ClientHelloParser parser_{TLS1_VERSION, TLS1_3_VERSION};
+  ParsedClientHello client_hello_;
+  size_t bytes_processed_{0};
+};
+
+// ClientHellos of BoringSSL, for every version it supports.
+TEST_F(ClientHelloParserTest, BoringSslClientHello) {
+  for (const uint16_t version : {TLS1_VERSION, TLS1_1_VERSION, TLS1_2_VERSION, TLS1_3_VERSION}) {
+    SCOPED_TRACE(version);
+    const Bytes data =
+        Tls::Test::generateClientHello(TLS1_VERSION, version, "example.com", "\x02h2");
+    ASSERT_EQ(Result::ClientHello, parse(data));
+    EXPECT_EQ(data.size(), bytes_processed_);
+    EXPECT_EQ("example.com", client_hello_.server_name);
+    EXPECT_EQ(version, client_hello_.version);
+    EXPECT_EQ(std::min<uint16_t>(version, TLS1_2_VERSION), client_hello_.client_hello.version);
+    EXPECT_EQ(nullptr, client_hello_.client_hello.ssl);
+
+    const uint8_t* alpn;
+    size_t alpn_len;
+    ASSERT_TRUE(SSL_early_callback_ctx_extension_get(
+        &client_hello_.client_hello, TLSEXT_TYPE_application_layer_protocol_negotiation, &alpn,
+        &alpn_len));
+    EXPECT_EQ(std::string("\x00\x03\x02h2", 5),
+              std::string(reinterpret_cast<const char*>(alpn), alpn_len));
+  }
+}
+
+// The fields of the ClientHello point into the parsed data.
+TEST_F(ClientHelloParserTest, Fields) {
+  TestClientHello test_client_hello;
+  test_client_hello.session_id_len = 16;
+  const Bytes data = test_client_hello.record();
+  ASSERT_EQ(Result::ClientHello, parse(data));
+  const SSL_CLIENT_HELLO& client_hello = client_hello_.client_hello;
+  EXPECT_EQ(TLS1_2_VERSION, client_hello.version);
+  EXPECT_EQ(data.data() + 11, client_hello.random);
+  EXPECT_EQ(SSL3_RANDOM_SIZE, client_hello.random_len);
+  EXPECT_EQ(data.data() + 44, client_hello.session_id);
+  EXPECT_EQ(16, client_hello.session_id_len);
+  EXPECT_EQ(data.data() + 62, client_hello.cipher_suites);
+  EXPECT_EQ(4, client_hello.cipher_suites_len);
+  EXPECT_EQ(data.data() + 67, client_hello.compression_methods);
+  EXPECT_EQ(1, client_hello.compression_methods_len);
+  EXPECT_EQ(data.data() + 70, client_hello.extensions);
+  EXPECT_EQ(data.data() + data.size(), client_hello.extensions + client_hello.extensions_len);
+}
+
+TEST_F(ClientHelloParserTest, NeedMoreData) {
+  const Bytes data = TestClientHello().record();
+  for (size_t len = 0; len < data.size(); ++len) {
+    EXPECT_EQ(Result::NeedMoreData, parse(Bytes(data.begin(), data.begin() + len))) << len;
+  }
+  EXPECT_EQ(Result::ClientHello, parse(data));
+}
+
+TEST_F(ClientHelloParserTest, NotTls) {
+  const std::string request = "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n";
+  EXPECT_EQ(Result::NeedMoreData, parse(Bytes(request.begin(), request.begin() + 4)));
+  EXPECT_EQ(Result::NotTls, parse(Bytes(request.begin(), request.end())));
+  EXPECT_EQ(SSL3_RT_HEADER_LENGTH, bytes_processed_);
+
+  EXPECT_EQ(Result::NotTls, parse(Bytes(100, 0)));
+  EXPECT_EQ(SSL3_RT_HEADER_LENGTH, bytes_processed_);
+}
+
+TEST_F(ClientHelloParserTest, V2ClientHello) {
+  EXPECT_EQ(Result::Unsupported, parse({0x80, 0x2e, 0x01, 0x03, 0x01, 0x00, 0x15}));
+}
+
+TEST_F(ClientHelloParserTest, NotHandshakeRecord) {
+  // A warning alert.
+  EXPECT_EQ(Result::Unsupported, parse({SSL3_RT_ALERT, 0x03, 0x01, 0x00, 0x02, 0x01, 0x00}));
+}
+
+TEST_F(ClientHelloParserTest, RecordTooLarge) {
+  EXPECT_EQ(Result::Unsupported, parse({SSL3_RT_HANDSHAKE, 0x03, 0x01, 0x40, 0x01}));
+}
+
+TEST_F(ClientHelloParserTest, EmptyRecord) {
+  EXPECT_EQ(Result::Unsupported, parse({SSL3_RT_HANDSHAKE, 0x03, 0x01, 0x00, 0x00}));
+}
+
+TEST_F(ClientHelloParserTest, FragmentedClientHello) {
+  const Bytes message = TestClientHello().message();
+  const Bytes data = TestClientHello::records(message, message.size() / 2 + 1);
+  EXPECT_EQ(Result::NeedMoreData, parse(Bytes(data.begin(), data.begin() + message.size() / 2)));
+  EXPECT_EQ(Result::Unsupported, parse(data));
+}
+
+TEST_F(ClientHelloParserTest, TrailingHandshakeData) {
+  Bytes message = TestClientHello().message();
+  message.insert(message.end(), {SSL3_MT_FINISHED, 0x00, 0x00, 0x00});
+  EXPECT_EQ(Result::Unsupported, parse(TestClientHello::records(message)));
+}
+
+TEST_F(ClientHelloParserTest, NotClientHello) {
+  Bytes message = TestClientHello().message();
+  message[0] = SSL3_MT_SERVER_HELLO;
+  EXPECT_EQ(Result::Unsupported, parse(TestClientHello::records(message)));
+}
+
+TEST_F(ClientHelloParserTest, TruncatedClientHello) {
+  Bytes message = TestClientHello().message();
+  message.pop_back();
+  message[3]--;
+  EXPECT_EQ(Result::Unsupported, parse(TestClientHello::records(message)));
+}
+
+TEST_F(ClientHelloParserTest, SessionIdTooLong) {
+  TestClientHello client_hello;
+  client_hello.session_id_len = SSL_MAX_SSL_SESSION_ID_LENGTH + 1;
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+}
+
+TEST_F(ClientHelloParserTest, InvalidCipherSuites) {
+  TestClientHello client_hello;
+  client_hello.cipher_suites = {};
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+  client_hello.cipher_suites = {0xc0, 0x2f, 0xc0};
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+}
+
+TEST_F(ClientHelloParserTest, CompressionMethods) {
+  TestClientHello client_hello;
+  client_hello.compression_methods = {};
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+  // DEFLATE alone isn't supported.
+  client_hello.compression_methods = {1};
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+  client_hello.compression_methods = {1, 0};
+  EXPECT_EQ(Result::ClientHello, parse(client_hello.record()));
+  // TLS 1.3 only allows the null compression method.
+  client_hello.extensions.emplace_back(TLSEXT_TYPE_supported_versions,
+                                       supportedVersions({TLS1_3_VERSION}));
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+  client_hello.compression_methods = {0};
+  EXPECT_EQ(Result::ClientHello, parse(client_hello.record()));
+}
+
+TEST_F(ClientHelloParserTest, NoExtensions) {
+  TestClientHello client_hello;
+  client_hello.has_extensions = false;
+  ASSERT_EQ(Result::ClientHello, parse(client_hello.record()));
+  EXPECT_EQ("", client_hello_.server_name);
+  EXPECT_EQ(0, client_hello_.client_hello.extensions_len);
+
+  // An empty list of extensions is the same.
+  client_hello.has_extensions = true;
+  client_hello.extensions.clear();
+  ASSERT_EQ(Result::ClientHello, parse(client_hello.record()));
+  EXPECT_EQ("", client_hello_.server_name);
+  EXPECT_EQ(0, client_hello_.client_hello.extensions_len);
+}
+
+TEST_F(ClientHelloParserTest, MalformedExtensions) {
+  TestClientHello client_hello;
+  Bytes message = client_hello.message();
+  // Make the contents of the last extension overflow the list of extensions.
+  message[message.size() - serverName("example.com").size() - 1]++;
+  EXPECT_EQ(Result::Unsupported, parse(TestClientHello::records(message)));
+}
+
+TEST_F(ClientHelloParserTest, DuplicateExtension) {
+  TestClientHello client_hello;
+  client_hello.extensions.emplace_back(TLSEXT_TYPE_session_ticket, Bytes());
+  client_hello.extensions.emplace_back(TLSEXT_TYPE_server_name, serverName("example.com"));
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+}
+
+TEST_F(ClientHelloParserTest, ManyExtensions) {
+  TestClientHello client_hello;
+  // Unassigned extension types, in descending order.
+  for (uint16_t type = 0xff00; client_hello.extensions.size() < 64; --type) {
+    client_hello.extensions.emplace_back(type, Bytes());
+  }
+  EXPECT_EQ(Result::ClientHello, parse(client_hello.record()));
+  // Too many to look for duplicates without allocating.
+  client_hello.extensions.emplace_back(0xfe00, Bytes());
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+}
+
+TEST_F(ClientHelloParserTest, ServerName) {
+  TestClientHello client_hello;
+  const std::string longest_name(TLSEXT_MAXLEN_host_name, 'a');
+  client_hello.extensions = {{TLSEXT_TYPE_server_name, serverName(longest_name)}};
+  ASSERT_EQ(Result::ClientHello, parse(client_hello.record()));
+  EXPECT_EQ(longest_name, client_hello_.server_name);
+}
+
+TEST_F(ClientHelloParserTest, InvalidServerName) {
+  TestClientHello client_hello;
+  for (const Bytes& server_name : {
+           serverName(""),
+           serverName(std::string(TLSEXT_MAXLEN_host_name + 1, 'a')),
+           serverName(absl::string_view("example\0com", 11)),
+           serverName("example.com", 1),
+           Bytes(),
+       }) {
+    client_hello.extensions = {{TLSEXT_TYPE_server_name, server_name}};
+    EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+  }
+
+  // Several names.
+  Bytes server_names = serverName("example.com");
+  const Bytes other_name = serverName("example.org");
+  server_names.insert(server_names.end(), other_name.begin() + 2, other_name.end());
+  server_names[1] += other_name.size() - 2;
+  client_hello.extensions = {{TLSEXT_TYPE_server_name, server_names}};
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+}
+
+TEST_F(ClientHelloParserTest, LegacyVersion) {
+  TestClientHello client_hello;
+  for (const auto& [legacy_version, version] : std::vector<std::pair<uint16_t, uint16_t>>{
+           {TLS1_VERSION, TLS1_VERSION},
+           {TLS1_1_VERSION, TLS1_1_VERSION},
+           {TLS1_2_VERSION, TLS1_2_VERSION},
+           // Without supported_versions, a higher version is a request for TLS 1.2.
+           {TLS1_3_VERSION, TLS1_2_VERSION},
+           {0x0305, TLS1_2_VERSION},
+       }) {
+    client_hello.version = legacy_version;
+    ASSERT_EQ(Result::ClientHello, parse(client_hello.record()));
+    EXPECT_EQ(version, client_hello_.version);
+  }
+
+  client_hello.version = SSL3_VERSION;
+  EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+}
+
+TEST_F(ClientHelloParserTest, SupportedVersions) {
+  TestClientHello client_hello;
+  for (const auto& [versions, version] : std::vector<std::pair<std::vector<uint16_t>, uint16_t>>{
+           {{TLS1_3_VERSION, TLS1_2_VERSION}, TLS1_3_VERSION},
+           // The order of the client doesn't matter.
+           {{TLS1_2_VERSION, TLS1_3_VERSION}, TLS1_3_VERSION},
+           // The extension is used even when the legacy version says otherwise.
+           {{TLS1_1_VERSION}, TLS1_1_VERSION},
+           // Unknown versions, such as GREASE, are skipped.
+           {{0x7a7a, TLS1_2_VERSION}, TLS1_2_VERSION},
+       }) {
+    client_hello.extensions = {{TLSEXT_TYPE_supported_versions, supportedVersions(versions)}};
+    ASSERT_EQ(Result::ClientHello, parse(client_hello.record()));
+    EXPECT_EQ(version, client_hello_.version);
+  }
+
+  for (const Bytes& supported_versions : {
+           supportedVersions({}),
+           supportedVersions({SSL3_VERSION, 0x7a7a}),
+           Bytes{0x03, 0x03, 0x04, 0x03},
+           Bytes{0x02, 0x03, 0x04, 0x00},
+       }) {
+    client_hello.extensions = {{TLSEXT_TYPE_supported_versions, supported_versions}};
+    EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+  }
+}
+
+// Only the versions the server supports are negotiated.
+TEST_F(ClientHelloParserTest, VersionRange) {
+  const ClientHelloParser parser(TLS1_2_VERSION, TLS1_2_VERSION);
+  TestClientHello client_hello;
+  client_hello.extensions = {
+      {TLSEXT_TYPE_supported_versions, supportedVersions({TLS1_3_VERSION, TLS1_2_VERSION})}};
+  Bytes data = client_hello.record();
+  ASSERT_EQ(Result::ClientHello,
+            parser.parse(data.data(), data.size(), client_hello_, bytes_processed_));
+  EXPECT_EQ(TLS1_2_VERSION, client_hello_.version);
+
+  client_hello.extensions = {
+      {TLSEXT_TYPE_supported_versions, supportedVersions({TLS1_3_VERSION, TLS1_1_VERSION})}};
+  data = client_hello.record();
+  EXPECT_EQ(Result::Unsupported,
+            parser.parse(data.data(), data.size(), client_hello_, bytes_processed_));
+
+  // Without the extension, a client supports the versions up to the one of its hello.
+  const ClientHelloParser legacy_parser(TLS1_VERSION, TLS1_1_VERSION);
+  client_hello.extensions = {};
+  client_hello.version = TLS1_VERSION;
+  data = client_hello.record();
+  ASSERT_EQ(Result::ClientHello,
+            legacy_parser.parse(data.data(), data.size(), client_hello_, bytes_processed_));
+  EXPECT_EQ(TLS1_VERSION, client_hello_.version);
+  EXPECT_EQ(Result::Unsupported,
+            parser.parse(data.data(), data.size(), client_hello_, bytes_processed_));
+
+  client_hello.version = TLS1_2_VERSION;
+  data = client_hello.record();
+  ASSERT_EQ(Result::ClientHello,
+            legacy_parser.parse(data.data(), data.size(), client_hello_, bytes_processed_));
+  EXPECT_EQ(TLS1_1_VERSION, client_hello_.version);
+}
+
+TEST_F(ClientHelloParserTest, EncryptedClientHello) {
+  TestClientHello client_hello;
+  client_hello.extensions.emplace_back(TLSEXT_TYPE_encrypted_client_hello,
+                                       encryptedClientHello(EchClientOuter, 144));
+  ASSERT_EQ(Result::ClientHello, parse(client_hello.record()));
+  EXPECT_EQ("example.com", client_hello_.server_name);
+}
+
+TEST_F(ClientHelloParserTest, InvalidEncryptedClientHello) {
+  TestClientHello client_hello;
+  Bytes truncated = encryptedClientHello(EchClientOuter, 144);
+  truncated.pop_back();
+  Bytes trailing_data = encryptedClientHello(EchClientOuter, 144);
+  trailing_data.push_back(0);
+  for (const Bytes& ech : {encryptedClientHello(EchClientInner, 0), truncated, trailing_data}) {
+    client_hello.extensions = {{TLSEXT_TYPE_encrypted_client_hello, ech}};
+    EXPECT_EQ(Result::Unsupported, parse(client_hello.record()));
+  }
+}
+
+} // namespace
+} // namespace TlsInspector
+} // namespace ListenerFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -5,6 +5,7 @@
 #include "source/common/network/io_socket_handle_impl.h"
 #include "source/common/network/listen_socket_impl.h"
 #include "source/common/network/listener_filter_buffer_impl.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/extensions/filters/listener/tls_inspector/tls_inspector.h"
 
 #include "test/extensions/filters/listener/tls_inspector/tls_utility.h"
@@ -65,7 +66,11 @@ public:
   const std::vector<uint8_t> client_hello_;
 };
 
+// Accepts and inspects a connection per iteration. The argument tells whether the ClientHello is
+// parsed by the ClientHello parser rather than by BoringSSL.
 static void bmTlsInspector(benchmark::State& state) {
+  Runtime::maybeSetRuntimeGuard("envoy.reloadable_features.tls_inspector_client_hello_parser",
+                                state.range(0) != 0);
   NiceMock<FastMockOsSysCalls> os_sys_calls(Tls::Test::generateClientHello(
       Config::TLS_MIN_SUPPORTED_VERSION, Config::TLS_MAX_SUPPORTED_VERSION, "example.com",
       "\x02h2\x08http/1.1"));
@@ -100,7 +105,7 @@ static void bmTlsInspector(benchmark::State& state) {
   }
 }
 
-BENCHMARK(bmTlsInspector)->Unit(benchmark::kMicrosecond);
+BENCHMARK(bmTlsInspector)->Arg(1)->Arg(0)->Unit(benchmark::kMicrosecond);
 
 } // namespace TlsInspector
 } // namespace ListenerFilters
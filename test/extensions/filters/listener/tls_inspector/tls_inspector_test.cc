@@ -9,6 +9,7 @@
 #include "test/mocks/api/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/stats/mocks.h"
+#include "test/test_common/test_runtime.h"
 #include "test/test_common/threadsafe_singleton_injector.h"
 
 #include "absl/strings/str_format.h"
@@ -481,6 +482,71 @@ TEST_P(TlsInspectorTest, RequestedMaxReadSizeDoesNotGoBeyondMaxSize) {
   EXPECT_FALSE(io_handle_->isOpen());
 }
 
+// Test that a ClientHello fragmented over two records, which the ClientHello parser leaves to
+// BoringSSL, is inspected all the same.
+TEST_P(TlsInspectorTest, FragmentedClientHello) {
+  init();
+  const std::string servername("example.com");
+  const std::vector<uint8_t> single_record = Tls::Test::generateClientHello(
+      std::get<0>(GetParam()), std::get<1>(GetParam()), servername, "\x02h2");
+  const size_t first_fragment_len = (single_record.size() - 5) / 2;
+  const size_t second_fragment_len = single_record.size() - 5 - first_fragment_len;
+  std::vector<uint8_t> client_hello(single_record.begin(), single_record.begin() + 3);
+  client_hello.push_back(first_fragment_len >> 8);
+  client_hello.push_back(first_fragment_len & 0xff);
+  client_hello.insert(client_hello.end(), single_record.begin() + 5,
+                      single_record.begin() + 5 + first_fragment_len);
+  client_hello.insert(client_hello.end(), single_record.begin(), single_record.begin() + 3);
+  client_hello.push_back(second_fragment_len >> 8);
+  client_hello.push_back(second_fragment_len & 0xff);
+  client_hello.insert(client_hello.end(), single_record.begin() + 5 + first_fragment_len,
+                      single_record.end());
+
+  mockSysCallForPeek(client_hello);
+  EXPECT_CALL(socket_, setRequestedServerName(Eq(servername)));
+  EXPECT_CALL(socket_, setRequestedApplicationProtocols(_));
+  EXPECT_CALL(socket_, setDetectedTransportProtocol(absl::string_view("tls")));
+  EXPECT_CALL(socket_, detectedTransportProtocol()).Times(::testing::AnyNumber());
+  // trigger the event to copy the client hello message into buffer
+  file_event_callback_(Event::FileReadyType::Read);
+  auto state = filter_->onData(*buffer_);
+  EXPECT_EQ(Network::FilterStatus::Continue, state);
+  EXPECT_EQ(1, cfg_->stats().tls_found_.value());
+  EXPECT_EQ(1, cfg_->stats().sni_found_.value());
+  EXPECT_EQ(1, cfg_->stats().alpn_found_.value());
+  const std::vector<uint64_t> bytes_processed =
+      store_.histogramValues("tls_inspector.bytes_processed", false);
+  ASSERT_EQ(1, bytes_processed.size());
+  EXPECT_EQ(client_hello.size(), bytes_processed[0]);
+}
+
+// Test that BoringSSL inspects every ClientHello when the ClientHello parser is disabled.
+TEST_P(TlsInspectorTest, ClientHelloParserDisabled) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues(
+      {{"envoy.reloadable_features.tls_inspector_client_hello_parser", "false"}});
+  init();
+  const std::string servername("example.com");
+  std::vector<uint8_t> client_hello = Tls::Test::generateClientHello(
+      std::get<0>(GetParam()), std::get<1>(GetParam()), servername, "");
+  mockSysCallForPeek(client_hello);
+  EXPECT_CALL(socket_, setRequestedServerName(Eq(servername)));
+  EXPECT_CALL(socket_, setRequestedApplicationProtocols(_)).Times(0);
+  EXPECT_CALL(socket_, setDetectedTransportProtocol(absl::string_view("tls")));
+  EXPECT_CALL(socket_, detectedTransportProtocol()).Times(::testing::AnyNumber());
+  // trigger the event to copy the client hello message into buffer
+  file_event_callback_(Event::FileReadyType::Read);
+  auto state = filter_->onData(*buffer_);
+  EXPECT_EQ(Network::FilterStatus::Continue, state);
+  EXPECT_EQ(1, cfg_->stats().tls_found_.value());
+  EXPECT_EQ(1, cfg_->stats().sni_found_.value());
+  EXPECT_EQ(1, cfg_->stats().alpn_not_found_.value());
+  const std::vector<uint64_t> bytes_processed =
+      store_.histogramValues("tls_inspector.bytes_processed", false);
+  ASSERT_EQ(1, bytes_processed.size());
+  EXPECT_EQ(client_hello.size(), bytes_processed[0]);
+}
+
 } // namespace
 } // namespace TlsInspector
 } // namespace ListenerFilters
@@ -0,0 +1,163 @@
+// Usage: bazel run //test/extensions/load_balancing_policies/peak_ewma:peak_ewma_lb_benchmark
+//
+// Simulates requests to a cluster in which one host is much slower than the others, and reports
+// the share of requests sent to the slow host and the resulting response times for the peak EWMA,
+// least request and random load balancers.
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "source/common/upstream/load_balancer_impl.h"
+#include "source/extensions/load_balancing_policies/peak_ewma/peak_ewma_lb.h"
+
+#include "test/benchmark/main.h"
+#include "test/extensions/load_balancing_policies/common/benchmark_base_tester.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolices {
+namespace PeakEwma {
+namespace {
+
+constexpr uint32_t NumHosts = 10;
+constexpr std::chrono::microseconds FastResponseTime{5000};
+constexpr std::chrono::microseconds SlowResponseTime{50000};
+constexpr std::chrono::microseconds ArrivalInterval{1000};
+constexpr uint32_t NumRequests = 100000;
+
+enum class Policy { PeakEwma, LeastRequest, Random };
+
+// Captures the response time observer of the load balancer which chose the host.
+class SimulationContext : public Upstream::LoadBalancerContextBase {
+public:
+  void setResponseTimeObserver(Upstream::ResponseTimeObserverSharedPtr observer) override {
+    observer_ = std::move(observer);
+  }
+
+  Upstream::ResponseTimeObserverSharedPtr observer_;
+};
+
+class SlowHostSimulation : public Common::BaseTester {
+public:
+  SlowHostSimulation(Policy policy)
+      : Common::BaseTester(NumHosts),
+        slow_host_(priority_set_.hostSetsPerPriority()[0]->hosts()[0].get()),
+        random_generator_(42) {
+    switch (policy) {
+    case Policy::PeakEwma:
+      lb_ = std::make_unique<PeakEwmaLoadBalancer>(priority_set_, nullptr, stats_, runtime_,
+                                                   random_, 50, PeakEwmaLbProto(), simTime());
+      break;
+    case Policy::LeastRequest:
+      lb_ = std::make_unique<Upstream::LeastRequestLoadBalancer>(
+          priority_set_, nullptr, stats_, runtime_, random_, 50,
+          envoy::extensions::load_balancing_policies::least_request::v3::LeastRequest(),
+          simTime());
+      break;
+    case Policy::Random:
+      lb_ = std::make_unique<Upstream::RandomLoadBalancer>(
+          priority_set_, nullptr, stats_, runtime_, random_, 50,
+          envoy::extensions::load_balancing_policies::random::v3::Random());
+      break;
+    }
+  }
+
+  // Sends requests at a fixed rate, each of which takes the response time of its host with
+  // exponentially distributed jitter.
+  void run(benchmark::State& state) {
+    std::vector<double> response_times_ms;
+    response_times_ms.reserve(NumRequests);
+    uint32_t slow_host_requests = 0;
+
+    for (uint32_t i = 0; i < NumRequests; i++) {
+      simTime().advanceTimeWait(ArrivalInterval);
+      completeRequests(response_times_ms);
+
+      SimulationContext context;
+      Upstream::HostConstSharedPtr host = lb_->chooseHost(&context);
+      if (host.get() == slow_host_) {
+        slow_host_requests++;
+      }
+      host->stats().rq_active_.inc();
+      const std::chrono::microseconds base =
+          host.get() == slow_host_ ? SlowResponseTime : FastResponseTime;
+      std::exponential_distribution<double> jitter(1.0 / (base.count() / 10.0));
+      const auto response_time =
+          base + std::chrono::microseconds(static_cast<int64_t>(jitter(random_generator_)));
+      in_flight_.push({simTime().monotonicTime() + response_time, response_time, std::move(host),
+                       std::move(context.observer_)});
+    }
+    simTime().advanceTimeWait(SlowResponseTime * 10);
+    completeRequests(response_times_ms);
+
+    std::sort(response_times_ms.begin(), response_times_ms.end());
+    double total_ms = 0;
+    for (double response_time_ms : response_times_ms) {
+      total_ms += response_time_ms;
+    }
+    state.counters["slow_host_percent"] = 100.0 * slow_host_requests / NumRequests;
+    state.counters["mean_ms"] = total_ms / response_times_ms.size();
+    state.counters["p99_ms"] = response_times_ms[response_times_ms.size() * 99 / 100];
+  }
+
+private:
+  struct InFlightRequest {
+    MonotonicTime completion_time_;
+    std::chrono::microseconds response_time_;
+    Upstream::HostConstSharedPtr host_;
+    Upstream::ResponseTimeObserverSharedPtr observer_;
+
+    bool operator>(const InFlightRequest& other) const {
+      return completion_time_ > other.completion_time_;
+    }
+  };
+
+  void completeRequests(std::vector<double>& response_times_ms) {
+    while (!in_flight_.empty() && in_flight_.top().completion_time_ <= simTime().monotonicTime()) {
+      const InFlightRequest& request = in_flight_.top();
+      request.host_->stats().rq_active_.dec();
+      if (request.observer_ != nullptr) {
+        request.observer_->onResponseTime(*request.host_, request.response_time_);
+      }
+      response_times_ms.push_back(request.response_time_.count() / 1000.0);
+      in_flight_.pop();
+    }
+  }
+
+  const Upstream::Host* slow_host_;
+  std::mt19937_64 random_generator_;
+  Upstream::LoadBalancerPtr lb_;
+  std::priority_queue<InFlightRequest, std::vector<InFlightRequest>, std::greater<>> in_flight_;
+};
+
+void benchmarkSlowHost(::benchmark::State& state) {
+  if (benchmark::skipExpensiveBenchmarks() && state.range(0) != 0) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    SlowHostSimulation simulation(static_cast<Policy>(state.range(0)));
+    state.ResumeTiming();
+    simulation.run(state);
+  }
+}
+BENCHMARK(benchmarkSlowHost)
+    ->ArgNames({"policy"})
+    ->Arg(static_cast<int64_t>(Policy::PeakEwma))
+    ->Arg(static_cast<int64_t>(Policy::LeastRequest))
+    ->Arg(static_cast<int64_t>(Policy::Random))
+    ->Unit(::benchmark::kMillisecond);
+
+} // namespace
+} // namespace PeakEwma
+} // namespace LoadBalancingPolices
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,264 @@
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+#include "source/extensions/load_balancing_policies/peak_ewma/peak_ewma_lb.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/common.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/cluster_info.h"
+#include "test/mocks/upstream/host_set.h"
+#include "test/mocks/upstream/load_balancer_context.h"
+#include "test/mocks/upstream/priority_set.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolices {
+namespace PeakEwma {
+namespace {
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+class PeakEwmaLoadBalancerTest : public Event::TestUsingSimulatedTime, public testing::Test {
+public:
+  PeakEwmaLoadBalancerTest()
+      : stat_names_(stats_store_.symbolTable()), stats_(stat_names_, *stats_store_.rootScope()) {}
+
+  void init(const std::string& yaml = "") {
+    PeakEwmaLbProto config;
+    if (!yaml.empty()) {
+      TestUtility::loadFromYaml(yaml, config);
+    }
+    lb_ = std::make_unique<PeakEwmaLoadBalancer>(priority_set_, nullptr, stats_, runtime_, random_,
+                                                 50, config, simTime());
+  }
+
+  void addHosts(uint32_t num_hosts) {
+    Upstream::HostVector hosts;
+    for (uint32_t i = 0; i < num_hosts; i++) {
+      hosts.push_back(
+          Upstream::makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 80 + i), simTime()));
+    }
+    host_set_.hosts_ = hosts;
+    host_set_.healthy_hosts_ = hosts;
+    host_set_.runCallbacks(hosts, {});
+  }
+
+  void observe(uint32_t host_index, std::chrono::milliseconds response_time) {
+    lb_->tracker().onResponseTime(*host_set_.hosts_[host_index], response_time);
+  }
+
+  double responseTimeMs(uint32_t host_index) {
+    return lb_->tracker().responseTime(*host_set_.hosts_[host_index], simTime().monotonicTime()) /
+           1e6;
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  Upstream::ClusterLbStatNames stat_names_;
+  Upstream::ClusterLbStats stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Random::MockRandomGenerator> random_;
+  NiceMock<Upstream::MockPrioritySet> priority_set_;
+  Upstream::MockHostSet& host_set_ = *priority_set_.getMockHostSet(0);
+  std::shared_ptr<Upstream::MockClusterInfo> info_{new NiceMock<Upstream::MockClusterInfo>()};
+  std::unique_ptr<PeakEwmaLoadBalancer> lb_;
+};
+
+TEST_F(PeakEwmaLoadBalancerTest, NoHosts) {
+  init();
+  EXPECT_EQ(nullptr, lb_->peekAnotherHost(nullptr));
+  EXPECT_EQ(nullptr, lb_->chooseHost(nullptr));
+}
+
+// Hosts without observed responses have the default response time.
+TEST_F(PeakEwmaLoadBalancerTest, DefaultResponseTime) {
+  init(R"EOF(
+  default_response_time: 0.025s
+  )EOF");
+  addHosts(2);
+  EXPECT_DOUBLE_EQ(25, responseTimeMs(0));
+  EXPECT_DOUBLE_EQ(25, responseTimeMs(1));
+}
+
+// The average moves up to higher response times right away, and decays towards lower ones and
+// over time.
+TEST_F(PeakEwmaLoadBalancerTest, PeakAndDecay) {
+  init(R"EOF(
+  decay_time: 1s
+  )EOF");
+  addHosts(1);
+
+  observe(0, std::chrono::milliseconds(10));
+  EXPECT_DOUBLE_EQ(10, responseTimeMs(0));
+  // A lower response time observed at the same time has no weight yet.
+  observe(0, std::chrono::milliseconds(1));
+  EXPECT_DOUBLE_EQ(10, responseTimeMs(0));
+
+  simTime().advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_NEAR(10 * std::exp(-1), responseTimeMs(0), 1e-6);
+  observe(0, std::chrono::milliseconds(1));
+  EXPECT_NEAR(10 * std::exp(-1) + 1 * (1 - std::exp(-1)), responseTimeMs(0), 1e-6);
+
+  observe(0, std::chrono::milliseconds(100));
+  EXPECT_DOUBLE_EQ(100, responseTimeMs(0));
+}
+
+// Failed requests are recorded as taking at least the failure penalty.
+TEST_F(PeakEwmaLoadBalancerTest, FailurePenalty) {
+  init(R"EOF(
+  failure_penalty: 0.5s
+  )EOF");
+  addHosts(1);
+
+  // A reset right after sending counts as the penalty.
+  lb_->tracker().onRequestFailure(*host_set_.hosts_[0], std::chrono::milliseconds(1));
+  EXPECT_DOUBLE_EQ(500, responseTimeMs(0));
+  // A timeout counts as the time until it fired.
+  lb_->tracker().onRequestFailure(*host_set_.hosts_[0], std::chrono::seconds(2));
+  EXPECT_DOUBLE_EQ(2000, responseTimeMs(0));
+}
+
+// The average does not decay while the host has active requests.
+TEST_F(PeakEwmaLoadBalancerTest, NoDecayWithActiveRequests) {
+  init(R"EOF(
+  decay_time: 1s
+  )EOF");
+  addHosts(1);
+  observe(0, std::chrono::milliseconds(10));
+
+  host_set_.hosts_[0]->stats().rq_active_.set(1);
+  simTime().advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_DOUBLE_EQ(10, responseTimeMs(0));
+
+  host_set_.hosts_[0]->stats().rq_active_.set(0);
+  EXPECT_NEAR(10 * std::exp(-1), responseTimeMs(0), 1e-6);
+}
+
+// A host whose requests only time out ends up costing more than a healthy host, instead of
+// decaying towards zero while its requests hang.
+TEST_F(PeakEwmaLoadBalancerTest, TimingOutHostCostsMoreThanHealthyHost) {
+  init(R"EOF(
+  decay_time: 1s
+  )EOF");
+  addHosts(2);
+  observe(0, std::chrono::milliseconds(10));
+  observe(1, std::chrono::milliseconds(10));
+
+  // Host 1 stops responding. Its requests hang until they time out after 5 seconds, while host 0
+  // keeps responding.
+  host_set_.hosts_[1]->stats().rq_active_.set(1);
+  for (uint32_t i = 0; i < 5; i++) {
+    simTime().advanceTimeWait(std::chrono::seconds(1));
+    observe(0, std::chrono::milliseconds(10));
+  }
+  EXPECT_DOUBLE_EQ(10, responseTimeMs(1));
+  lb_->tracker().onRequestFailure(*host_set_.hosts_[1], std::chrono::seconds(5));
+  host_set_.hosts_[1]->stats().rq_active_.set(0);
+
+  simTime().advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_GT(responseTimeMs(1), responseTimeMs(0));
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(nullptr));
+}
+
+// Of the sampled hosts, the one with the lower response time is chosen.
+TEST_F(PeakEwmaLoadBalancerTest, PrefersLowerResponseTime) {
+  init();
+  addHosts(2);
+  observe(0, std::chrono::milliseconds(100));
+  observe(1, std::chrono::milliseconds(1));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(nullptr));
+  // Sampling the same host twice leaves no choice.
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0));
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(nullptr));
+}
+
+// The response time is scaled by the number of active requests.
+TEST_F(PeakEwmaLoadBalancerTest, ActiveRequestsIncreaseCost) {
+  init();
+  addHosts(2);
+  observe(0, std::chrono::milliseconds(10));
+  observe(1, std::chrono::milliseconds(30));
+
+  host_set_.hosts_[0]->stats().rq_active_.set(3);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(nullptr));
+
+  host_set_.hosts_[0]->stats().rq_active_.set(1);
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(nullptr));
+}
+
+TEST_F(PeakEwmaLoadBalancerTest, ChoiceCount) {
+  init(R"EOF(
+  choice_count: 3
+  )EOF");
+  addHosts(3);
+  observe(0, std::chrono::milliseconds(30));
+  observe(1, std::chrono::milliseconds(20));
+  observe(2, std::chrono::milliseconds(10));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1)).WillOnce(Return(2));
+  EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(nullptr));
+}
+
+// The response time of a chosen host is reported back to the load balancer, but not for peeks.
+TEST_F(PeakEwmaLoadBalancerTest, RegistersResponseTimeObserver) {
+  init();
+  addHosts(2);
+
+  NiceMock<Upstream::MockLoadBalancerContext> context;
+  EXPECT_CALL(context, setResponseTimeObserver(_)).Times(0);
+  EXPECT_NE(nullptr, lb_->peekAnotherHost(&context));
+
+  Upstream::ResponseTimeObserverSharedPtr observer;
+  EXPECT_CALL(context, setResponseTimeObserver(_)).WillOnce(testing::SaveArg<0>(&observer));
+  Upstream::HostConstSharedPtr host = lb_->chooseHost(&context);
+  ASSERT_NE(nullptr, observer);
+
+  observer->onResponseTime(*host, std::chrono::milliseconds(42));
+  EXPECT_DOUBLE_EQ(42, lb_->tracker().responseTime(*host, simTime().monotonicTime()) / 1e6);
+}
+
+// Removed hosts are no longer tracked, and late responses from them are ignored.
+TEST_F(PeakEwmaLoadBalancerTest, RemovedHosts) {
+  init();
+  addHosts(2);
+  EXPECT_EQ(2, lb_->tracker().size());
+
+  Upstream::HostSharedPtr removed = host_set_.hosts_[0];
+  host_set_.hosts_ = {host_set_.hosts_[1]};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {removed});
+  EXPECT_EQ(1, lb_->tracker().size());
+
+  lb_->tracker().onResponseTime(*removed, std::chrono::milliseconds(10));
+  EXPECT_EQ(1, lb_->tracker().size());
+}
+
+// Hosts present when the load balancer is created are tracked.
+TEST_F(PeakEwmaLoadBalancerTest, ExistingHosts) {
+  addHosts(3);
+  init();
+  EXPECT_EQ(3, lb_->tracker().size());
+}
+
+} // namespace
+} // namespace PeakEwma
+} // namespace LoadBalancingPolices
+} // namespace Extensions
+} // namespace Envoy
@@ -1,7 +1,9 @@
 #include "envoy/config/core/v3/extension.pb.h"
 
+#include "source/common/upstream/upstream_impl.h"
 #include "source/extensions/load_balancing_policies/round_robin/config.h"
 
+#include "test/common/upstream/utility.h"
 #include "test/mocks/server/factory_context.h"
 #include "test/mocks/upstream/cluster_info.h"
 #include "test/mocks/upstream/priority_set.h"
@@ -45,6 +47,85 @@ TEST(RoundRobinConfigTest, ValidateFail) {
   EXPECT_NE(nullptr, thread_local_lb);
 }
 
+// With share_schedules_across_workers, the schedules built on the main thread follow its host
+// updates and are used by the worker load balancers.
+TEST(RoundRobinConfigTest, ShareSchedulesAcrossWorkers) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  NiceMock<Upstream::MockClusterInfo> cluster_info;
+  auto host_cluster_info = std::make_shared<NiceMock<Upstream::MockClusterInfo>>();
+  Upstream::PrioritySetImpl main_thread_priority_set;
+  Upstream::PrioritySetImpl thread_local_priority_set;
+  const auto update_hosts = [&](const std::vector<uint32_t>& weights) {
+    auto hosts = std::make_shared<Upstream::HostVector>();
+    for (uint32_t weight : weights) {
+      hosts->push_back(Upstream::makeTestHost(
+          host_cluster_info, "tcp://127.0.0.1:" + std::to_string(80 + hosts->size()),
+          context.time_system_, weight));
+    }
+    main_thread_priority_set.updateHosts(
+        0,
+        Upstream::HostSetImpl::partitionHosts(hosts, Upstream::HostsPerLocalityImpl::empty()), {},
+        *hosts, {}, absl::nullopt);
+    thread_local_priority_set.updateHosts(
+        0,
+        Upstream::HostSetImpl::updateHostsParams(
+            *main_thread_priority_set.hostSetsPerPriority()[0]),
+        {}, *hosts, {}, absl::nullopt);
+    return hosts;
+  };
+  Upstream::HostVectorSharedPtr hosts = update_hosts({1, 3});
+
+  envoy::config::core::v3::TypedExtensionConfig config;
+  config.set_name("envoy.load_balancing_policies.round_robin");
+  envoy::extensions::load_balancing_policies::round_robin::v3::RoundRobin config_msg;
+  config_msg.set_share_schedules_across_workers(true);
+  config.mutable_typed_config()->PackFrom(config_msg);
+
+  auto& factory = Config::Utility::getAndCheckFactory<Upstream::TypedLoadBalancerFactory>(config);
+  auto lb_config = factory.loadConfig(config_msg, context.messageValidationVisitor());
+  auto thread_aware_lb =
+      factory.create(*lb_config, cluster_info, main_thread_priority_set, context.runtime_loader_,
+                     context.api_.random_, context.time_system_);
+  ASSERT_NE(nullptr, dynamic_cast<SharedScheduleThreadAwareLb*>(thread_aware_lb.get()));
+  thread_aware_lb->initialize();
+
+  auto thread_local_lb_factory = thread_aware_lb->factory();
+  EXPECT_FALSE(thread_local_lb_factory->recreateOnHostChange());
+  auto thread_local_lb = thread_local_lb_factory->create({thread_local_priority_set, nullptr});
+  const auto expect_picks = [&](const std::vector<uint32_t>& expected_counts) {
+    absl::flat_hash_map<Upstream::HostConstSharedPtr, uint32_t> counts;
+    for (uint32_t i = 0; i < 40; ++i) {
+      ++counts[thread_local_lb->chooseHost(nullptr)];
+    }
+    for (size_t i = 0; i < hosts->size(); ++i) {
+      EXPECT_EQ(expected_counts[i], counts[(*hosts)[i]]);
+    }
+  };
+  expect_picks({10, 30});
+
+  hosts = update_hosts({2, 1, 1});
+  expect_picks({20, 10, 10});
+}
+
+// Slow start changes the weights over time, so it is not combined with shared schedules.
+TEST(RoundRobinConfigTest, ShareSchedulesIgnoredWithSlowStart) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  NiceMock<Upstream::MockClusterInfo> cluster_info;
+  NiceMock<Upstream::MockPrioritySet> main_thread_priority_set;
+
+  envoy::extensions::load_balancing_policies::round_robin::v3::RoundRobin config_msg;
+  config_msg.set_share_schedules_across_workers(true);
+  config_msg.mutable_slow_start_config()->mutable_slow_start_window()->set_seconds(10);
+
+  auto& factory = Config::Utility::getAndCheckFactoryByName<Upstream::TypedLoadBalancerFactory>(
+      "envoy.load_balancing_policies.round_robin");
+  auto lb_config = factory.loadConfig(config_msg, context.messageValidationVisitor());
+  auto thread_aware_lb =
+      factory.create(*lb_config, cluster_info, main_thread_priority_set, context.runtime_loader_,
+                     context.api_.random_, context.time_system_);
+  EXPECT_EQ(nullptr, dynamic_cast<SharedScheduleThreadAwareLb*>(thread_aware_lb.get()));
+}
+
 } // namespace
 } // namespace RoundRobin
 } // namespace LoadBalancingPolices
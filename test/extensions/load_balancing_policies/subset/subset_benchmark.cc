@@ -1,11 +1,14 @@
 // Usage: bazel run //test/common/upstream:load_balancer_benchmark
 
+#include <algorithm>
 #include <memory>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
+#include "envoy/extensions/load_balancing_policies/subset/v3/subset.pb.h"
 
 #include "source/common/common/random_generator.h"
 #include "source/common/memory/stats.h"
+#include "source/common/router/metadatamatchcriteria_impl.h"
 #include "source/common/upstream/upstream_impl.h"
 #include "source/extensions/load_balancing_policies/maglev/maglev_lb.h"
 #include "source/extensions/load_balancing_policies/ring_hash/ring_hash_lb.h"
@@ -26,16 +29,33 @@ namespace LoadBalancingPolices {
 namespace Subset {
 namespace {
 
+// Number of subsets requested when subsets are built on demand.
+constexpr uint64_t NumLazySubsetsUsed = 10;
+
+class MetadataMatchContext : public Upstream::LoadBalancerContextBase {
+public:
+  MetadataMatchContext(const ProtobufWkt::Struct& metadata_matches)
+      : criteria_(metadata_matches) {}
+
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() override { return &criteria_; }
+
+private:
+  const Router::MetadataMatchCriteriaImpl criteria_;
+};
+
 class SubsetLbTester : public LoadBalancingPolices::Common::BaseTester {
 public:
-  SubsetLbTester(uint64_t num_hosts, bool single_host_per_subset)
+  SubsetLbTester(uint64_t num_hosts, bool single_host_per_subset, bool lazy_subsets = false)
       : BaseTester(num_hosts, 0, 0, true /* attach metadata */) {
-    envoy::config::cluster::v3::Cluster::LbSubsetConfig subset_config;
+    envoy::extensions::load_balancing_policies::subset::v3::Subset subset_config;
     subset_config.set_fallback_policy(
-        envoy::config::cluster::v3::Cluster::LbSubsetConfig::ANY_ENDPOINT);
+        envoy::extensions::load_balancing_policies::subset::v3::Subset::ANY_ENDPOINT);
     auto* selector = subset_config.mutable_subset_selectors()->Add();
     selector->set_single_host_per_subset(single_host_per_subset);
     *selector->mutable_keys()->Add() = std::string(metadata_key);
+    if (lazy_subsets) {
+      subset_config.mutable_lazy_subsets();
+    }
 
     subset_info_ = std::make_unique<Upstream::LoadBalancerSubsetInfoImpl>(subset_config);
     auto child_lb_creator = std::make_unique<Upstream::LegacyChildLoadBalancerCreatorImpl>(
@@ -52,6 +72,16 @@ public:
     ASSERT(smaller_hosts_->size() + 1 == orig_hosts_->size());
     orig_locality_hosts_ = Upstream::makeHostsPerLocality({*orig_hosts_});
     smaller_locality_hosts_ = Upstream::makeHostsPerLocality({*smaller_hosts_});
+
+    if (lazy_subsets) {
+      // Each host has its own metadata value, so only a few of the possible subsets are built.
+      for (uint64_t i = 0; i < std::min(num_hosts, NumLazySubsetsUsed); i++) {
+        ProtobufWkt::Struct metadata_matches;
+        (*metadata_matches.mutable_fields())[std::string(metadata_key)].set_number_value(i);
+        MetadataMatchContext context(metadata_matches);
+        lb_->chooseHost(&context);
+      }
+    }
   }
 
   // Remove a host and add it back.
@@ -76,6 +106,7 @@ public:
 void benchmarkSubsetLoadBalancerCreate(::benchmark::State& state) {
   const bool single_host_per_subset = state.range(0);
   const uint64_t num_hosts = state.range(1);
+  const bool lazy_subsets = state.range(2);
 
   if (benchmark::skipExpensiveBenchmarks() && num_hosts > 100) {
     state.SkipWithError("Skipping expensive benchmark");
@@ -83,30 +114,31 @@ void benchmarkSubsetLoadBalancerCreate(::benchmark::State& state) {
   }
 
   for (auto _ : state) { // NOLINT: Silences warning about dead store
-    SubsetLbTester tester(num_hosts, single_host_per_subset);
+    SubsetLbTester tester(num_hosts, single_host_per_subset, lazy_subsets);
   }
 }
 
 BENCHMARK(benchmarkSubsetLoadBalancerCreate)
-    ->Ranges({{false, true}, {50, 2500}})
+    ->Ranges({{false, true}, {50, 2500}, {false, true}})
     ->Unit(::benchmark::kMillisecond);
 
 void benchmarkSubsetLoadBalancerUpdate(::benchmark::State& state) {
   const bool single_host_per_subset = state.range(0);
   const uint64_t num_hosts = state.range(1);
+  const bool lazy_subsets = state.range(2);
   if (benchmark::skipExpensiveBenchmarks() && num_hosts > 100) {
     state.SkipWithError("Skipping expensive benchmark");
     return;
   }
 
-  SubsetLbTester tester(num_hosts, single_host_per_subset);
+  SubsetLbTester tester(num_hosts, single_host_per_subset, lazy_subsets);
   for (auto _ : state) { // NOLINT: Silences warning about dead store
     tester.update();
   }
 }
 
 BENCHMARK(benchmarkSubsetLoadBalancerUpdate)
-    ->Ranges({{false, true}, {50, 2500}})
+    ->Ranges({{false, true}, {50, 2500}, {false, true}})
     ->Unit(::benchmark::kMillisecond);
 
 } // namespace
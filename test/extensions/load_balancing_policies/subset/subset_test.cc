@@ -2389,6 +2389,172 @@ TEST_P(SubsetLoadBalancerTest, GaugesUpdatedOnDestroy) {
   EXPECT_EQ(1U, stats_.lb_subsets_removed_.value());
 }
 
+TEST_P(SubsetLoadBalancerTest, LazySubsetsBuiltOnFirstRequest) {
+  EXPECT_CALL(subset_info_, fallbackPolicy())
+      .WillRepeatedly(Return(envoy::config::cluster::v3::Cluster::LbSubsetConfig::NO_FALLBACK));
+  EXPECT_CALL(subset_info_, maxLazySubsets()).WillRepeatedly(Return(10));
+
+  std::vector<SubsetSelectorPtr> subset_selectors = {makeSelector({"version"})};
+  EXPECT_CALL(subset_info_, subsetSelectors()).WillRepeatedly(ReturnRef(subset_selectors));
+
+  init({
+      {"tcp://127.0.0.1:80", {{"version", "1.0"}}},
+      {"tcp://127.0.0.1:81", {{"version", "1.0"}}},
+      {"tcp://127.0.0.1:82", {{"version", "1.1"}}},
+  });
+  EXPECT_EQ(0U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(0U, stats_.lb_subsets_created_.value());
+
+  TestLoadBalancerContext context_10({{"version", "1.0"}});
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_10));
+  EXPECT_EQ(1U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_created_.value());
+  EXPECT_EQ(2U, stats_.lb_subsets_selected_.value());
+
+  // Only the subset that has been built is updated.
+  modifyHosts({makeHost("tcp://127.0.0.1:83", {{"version", "1.0"}}),
+               makeHost("tcp://127.0.0.1:84", {{"version", "1.2"}})},
+              {host_set_.hosts_[0]});
+  EXPECT_EQ(1U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_created_.value());
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10));
+  EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(&context_10));
+
+  TestLoadBalancerContext context_12({{"version", "1.2"}});
+  EXPECT_EQ(host_set_.hosts_[3], lb_->chooseHost(&context_12));
+  EXPECT_EQ(2U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(2U, stats_.lb_subsets_created_.value());
+
+  // Criteria that do not match the keys of a selector never build a subset.
+  TestLoadBalancerContext context_stage({{"stage", "prod"}});
+  EXPECT_EQ(nullptr, lb_->chooseHost(&context_stage));
+  EXPECT_EQ(2U, stats_.lb_subsets_created_.value());
+
+  EXPECT_EQ(0U, TestUtility::findCounter(stats_store_, "testprefix.lb_subsets_evicted")->value());
+
+  lb_ = nullptr;
+  EXPECT_EQ(0U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(2U, stats_.lb_subsets_removed_.value());
+}
+
+TEST_P(SubsetLoadBalancerTest, LazySubsetsEmptyUntilHostsAdded) {
+  EXPECT_CALL(subset_info_, fallbackPolicy())
+      .WillRepeatedly(Return(envoy::config::cluster::v3::Cluster::LbSubsetConfig::NO_FALLBACK));
+  EXPECT_CALL(subset_info_, maxLazySubsets()).WillRepeatedly(Return(10));
+
+  std::vector<SubsetSelectorPtr> subset_selectors = {makeSelector({"version"})};
+  EXPECT_CALL(subset_info_, subsetSelectors()).WillRepeatedly(ReturnRef(subset_selectors));
+
+  init({{"tcp://127.0.0.1:80", {{"version", "1.0"}}}});
+
+  // Metadata without hosts neither builds nor counts a subset, and is remembered until the next
+  // update so that it is not looked up again for every request.
+  TestLoadBalancerContext context_11({{"version", "1.1"}});
+  EXPECT_EQ(nullptr, lb_->chooseHost(&context_11));
+  EXPECT_EQ(nullptr, lb_->chooseHost(&context_11));
+  EXPECT_EQ(0U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(0U, stats_.lb_subsets_created_.value());
+  EXPECT_EQ(0U, stats_.lb_subsets_selected_.value());
+
+  // The subset is built once hosts are added for it.
+  modifyHosts({makeHost("tcp://127.0.0.1:81", {{"version", "1.1"}})}, {});
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_11));
+  EXPECT_EQ(1U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_created_.value());
+
+  // Once its hosts are gone, the subset is purged like any other and not built again.
+  modifyHosts({}, {host_set_.hosts_[1]});
+  EXPECT_EQ(0U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_removed_.value());
+  EXPECT_EQ(nullptr, lb_->chooseHost(&context_11));
+  EXPECT_EQ(1U, stats_.lb_subsets_created_.value());
+
+  lb_ = nullptr;
+  EXPECT_EQ(0U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_removed_.value());
+}
+
+// Subsets built on demand only hold the hosts matching every criterion, including hosts matching
+// through a list value.
+TEST_P(SubsetLoadBalancerTest, LazySubsetsMatchEveryKey) {
+  EXPECT_CALL(subset_info_, fallbackPolicy())
+      .WillRepeatedly(Return(envoy::config::cluster::v3::Cluster::LbSubsetConfig::NO_FALLBACK));
+  EXPECT_CALL(subset_info_, maxLazySubsets()).WillRepeatedly(Return(10));
+  EXPECT_CALL(subset_info_, listAsAny()).WillRepeatedly(Return(true));
+
+  std::vector<SubsetSelectorPtr> subset_selectors = {makeSelector({"stage", "version"})};
+  EXPECT_CALL(subset_info_, subsetSelectors()).WillRepeatedly(ReturnRef(subset_selectors));
+
+  init({
+      {"tcp://127.0.0.1:80", {{"version", "1.0"}, {"stage", "prod"}}},
+      {"tcp://127.0.0.1:81", {{"version", "1.0"}, {"stage", "dev"}}},
+      {"tcp://127.0.0.1:82", {{"version", "1.1"}, {"stage", "prod"}}},
+  });
+  modifyHosts({makeHost("tcp://127.0.0.1:83",
+                        {{"version", std::vector<std::string>{"1.0", "1.1", "1.0"}},
+                         {"stage", std::vector<std::string>{"prod"}}})},
+              {});
+
+  TestLoadBalancerContext context_10_prod({{"stage", "prod"}, {"version", "1.0"}});
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10_prod));
+  EXPECT_EQ(host_set_.hosts_[3], lb_->chooseHost(&context_10_prod));
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10_prod));
+
+  TestLoadBalancerContext context_11_dev({{"stage", "dev"}, {"version", "1.1"}});
+  EXPECT_EQ(nullptr, lb_->chooseHost(&context_11_dev));
+  EXPECT_EQ(1U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_created_.value());
+}
+
+TEST_P(SubsetLoadBalancerTest, LazySubsetsLeastRecentlyUsedEvicted) {
+  EXPECT_CALL(subset_info_, fallbackPolicy())
+      .WillRepeatedly(Return(envoy::config::cluster::v3::Cluster::LbSubsetConfig::NO_FALLBACK));
+  EXPECT_CALL(subset_info_, maxLazySubsets()).WillRepeatedly(Return(2));
+
+  std::vector<SubsetSelectorPtr> subset_selectors = {makeSelector({"version"}),
+                                                     makeSelector({"version", "stage"})};
+  EXPECT_CALL(subset_info_, subsetSelectors()).WillRepeatedly(ReturnRef(subset_selectors));
+
+  init({
+      {"tcp://127.0.0.1:80", {{"version", "1.0"}, {"stage", "prod"}}},
+      {"tcp://127.0.0.1:81", {{"version", "1.1"}}},
+      {"tcp://127.0.0.1:82", {{"version", "1.2"}}},
+  });
+  Stats::CounterSharedPtr evicted =
+      TestUtility::findCounter(stats_store_, "testprefix.lb_subsets_evicted");
+
+  TestLoadBalancerContext context_10_prod({{"version", "1.0"}, {"stage", "prod"}});
+  TestLoadBalancerContext context_10({{"version", "1.0"}});
+  TestLoadBalancerContext context_11({{"version", "1.1"}});
+  TestLoadBalancerContext context_12({{"version", "1.2"}});
+
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10_prod));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_11));
+  // Using the first subset again makes the second one the least recently used.
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10_prod));
+  EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(&context_12));
+  EXPECT_EQ(2U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(3U, stats_.lb_subsets_created_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_removed_.value());
+  EXPECT_EQ(1U, evicted->value());
+
+  // Every further subset evicts the least recently used one.
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10));
+  EXPECT_EQ(2U, evicted->value());
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_11));
+  EXPECT_EQ(3U, evicted->value());
+  EXPECT_EQ(2U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(5U, stats_.lb_subsets_created_.value());
+  EXPECT_EQ(3U, stats_.lb_subsets_removed_.value());
+
+  // Evicted subsets are rebuilt with the current hosts.
+  modifyHosts({makeHost("tcp://127.0.0.1:83", {{"version", "1.0"}, {"stage", "prod"}})}, {});
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10_prod));
+  EXPECT_EQ(host_set_.hosts_[3], lb_->chooseHost(&context_10_prod));
+  EXPECT_EQ(4U, evicted->value());
+}
+
 TEST_P(SubsetLoadBalancerTest, SubsetSelectorNoFallbackPerSelector) {
   EXPECT_CALL(subset_info_, fallbackPolicy())
       .WillRepeatedly(Return(envoy::config::cluster::v3::Cluster::LbSubsetConfig::DEFAULT_SUBSET));
@@ -17,6 +17,7 @@
 #include "source/common/common/utility.h"
 #include "source/common/event/dispatcher_impl.h"
 #include "source/common/network/address_impl.h"
+#include "source/common/network/dns_resolver/caching_dns_resolver.h"
 #include "source/common/network/filter_impl.h"
 #include "source/common/network/listen_socket_impl.h"
 #include "source/common/network/tcp_listener_impl.h"
@@ -49,6 +50,7 @@
 
 using testing::_;
 using testing::Contains;
+using testing::ElementsAre;
 using testing::InSequence;
 using testing::IsSupersetOf;
 using testing::NiceMock;
@@ -72,10 +74,10 @@ public:
   TestDnsServerQuery(ConnectionPtr connection, const HostMap& hosts_a, const HostMap& hosts_aaaa,
                      const CNameMap& cnames, const std::chrono::seconds& record_ttl,
                      const std::chrono::seconds& cname_ttl_, bool refused, bool error_on_a,
-                     bool error_on_aaaa)
+                     bool error_on_aaaa, uint32_t& questions)
       : connection_(std::move(connection)), hosts_a_(hosts_a), hosts_aaaa_(hosts_aaaa),
         cnames_(cnames), record_ttl_(record_ttl), cname_ttl_(cname_ttl_), refused_(refused),
-        error_on_a_(error_on_a), error_on_aaaa_(error_on_aaaa) {
+        error_on_a_(error_on_a), error_on_aaaa_(error_on_aaaa), questions_(questions) {
     connection_->addReadFilter(Network::ReadFilterSharedPtr{new ReadFilter(*this)});
   }
 
@@ -144,6 +146,7 @@ private:
         ASSERT_EQ(ARES_SUCCESS, ares_expand_name(question, request, size_, &name, &name_len));
         // We only expect resources of type A or AAAA.
         const int q_type = DNS_QUESTION_TYPE(question + name_len);
+        parent_.questions_++;
 
         auto lookup_name = std::string(name);
 
@@ -335,6 +338,7 @@ private:
   const bool refused_;
   const bool error_on_a_;
   const bool error_on_aaaa_;
+  uint32_t& questions_;
 };
 
 class TestDnsServer : public TcpListenerCallbacks {
@@ -348,7 +352,8 @@ public:
         std::move(socket), Network::Test::createRawBufferSocket(), stream_info_);
     TestDnsServerQuery* query =
         new TestDnsServerQuery(std::move(new_connection), hosts_a_, hosts_aaaa_, cnames_,
-                               record_ttl_, cname_ttl_, refused_, error_on_a_, error_on_aaaa_);
+                               record_ttl_, cname_ttl_, refused_, error_on_a_, error_on_aaaa_,
+                               questions_);
     queries_.emplace_back(query);
   }
 
@@ -372,6 +377,8 @@ public:
   void setRefused(bool refused) { refused_ = refused; }
   void setErrorOnQtypeA(bool error) { error_on_a_ = error; }
   void setErrorOnQtypeAAAA(bool error) { error_on_aaaa_ = error; }
+  // The number of questions received over all connections.
+  uint32_t questions() const { return questions_; }
 
 private:
   Event::Dispatcher& dispatcher_;
@@ -384,6 +391,7 @@ private:
   bool refused_{};
   bool error_on_a_{};
   bool error_on_aaaa_{};
+  uint32_t questions_{};
   // All queries are tracked so we can do resource reclamation when the test is
   // over.
   std::vector<std::unique_ptr<TestDnsServerQuery>> queries_;
@@ -1198,6 +1206,37 @@ TEST_P(DnsImplTest, RemoteAsyncLookup) {
              0 /*get_addr_failure*/, 0 /*timeouts*/);
 }
 
+// Validate that the shared DNS resolution cache coalesces concurrent lookups of the same name into
+// a single query to the server, and answers the following lookups from its cache.
+TEST_P(DnsImplTest, CachingResolverLookup) {
+  server_->addHosts("some.good.domain", {"201.134.56.7"}, RecordType::A);
+  server_->setRecordTtl(std::chrono::seconds(300));
+  CachingDnsResolver caching_resolver(resolver_, *dispatcher_, *stats_store_.rootScope());
+
+  uint32_t completed = 0;
+  auto callback = [&](DnsResolver::ResolutionStatus status, std::list<DnsResponse>&& results) {
+    EXPECT_EQ(DnsResolver::ResolutionStatus::Success, status);
+    EXPECT_THAT(getAddressAsStringList(results), ElementsAre("201.134.56.7"));
+    if (++completed == 2) {
+      dispatcher_->exit();
+    }
+  };
+  EXPECT_NE(nullptr,
+            caching_resolver.resolve("some.good.domain", DnsLookupFamily::V4Only, callback));
+  EXPECT_NE(nullptr,
+            caching_resolver.resolve("some.good.domain", DnsLookupFamily::V4Only, callback));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ(2, completed);
+  EXPECT_EQ(1, server_->questions());
+
+  EXPECT_EQ(nullptr,
+            caching_resolver.resolve("some.good.domain", DnsLookupFamily::V4Only, callback));
+  EXPECT_EQ(3, completed);
+  EXPECT_EQ(1, server_->questions());
+  checkStats(1 /*resolve_total*/, 0 /*pending_resolutions*/, 0 /*not_found*/,
+             0 /*get_addr_failure*/, 0 /*timeouts*/);
+}
+
 // Validate that multiple A records are correctly passed to the callback.
 TEST_P(DnsImplTest, MultiARecordLookup) {
   server_->addHosts("some.good.domain", {"201.134.56.7", "123.4.5.6", "6.5.4.3"}, RecordType::A);
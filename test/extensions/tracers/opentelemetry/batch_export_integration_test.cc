@@ -0,0 +1,164 @@
+#include <string>
+
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+#include "envoy/config/trace/v3/opentelemetry.pb.h"
+#include "envoy/extensions/filters/network/http_connection_manager/v3/http_connection_manager.pb.h"
+
+#include "test/common/grpc/grpc_client_integration.h"
+#include "test/integration/http_integration.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/escaping.h"
+#include "gtest/gtest.h"
+#include "opentelemetry/proto/collector/trace/v1/trace_service.pb.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Tracers {
+namespace OpenTelemetry {
+namespace {
+
+constexpr absl::string_view TraceId = "0af7651916cd43dd8448eb211c80319c";
+constexpr absl::string_view Traceparent =
+    "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01";
+
+// Sends spans through the batch exporter to a fake OTLP collector.
+class BatchExportIntegrationTest : public Grpc::GrpcClientIntegrationParamTest,
+                                   public HttpIntegrationTest {
+public:
+  BatchExportIntegrationTest() : HttpIntegrationTest(Http::CodecType::HTTP1, ipVersion()) {}
+
+  void createUpstreams() override {
+    HttpIntegrationTest::createUpstreams();
+    addFakeUpstream(Http::CodecType::HTTP2);
+  }
+
+  void initializeWithBatchExport(const std::string& batch_export_yaml) {
+    config_helper_.addConfigModifier([](envoy::config::bootstrap::v3::Bootstrap& bootstrap) {
+      auto* collector_cluster = bootstrap.mutable_static_resources()->add_clusters();
+      collector_cluster->MergeFrom(bootstrap.static_resources().clusters()[0]);
+      collector_cluster->set_name("opentelemetry_collector");
+      ConfigHelper::setHttp2(*collector_cluster);
+    });
+
+    config_helper_.addConfigModifier(
+        [this, batch_export_yaml](
+            envoy::extensions::filters::network::http_connection_manager::v3::HttpConnectionManager&
+                hcm) {
+          envoy::config::trace::v3::OpenTelemetryConfig config;
+          setGrpcService(*config.mutable_grpc_service(), "opentelemetry_collector",
+                         fake_upstreams_.back()->localAddress());
+          config.set_service_name("batch_service");
+          TestUtility::loadFromYaml(batch_export_yaml, *config.mutable_batch_export());
+
+          auto* provider = hcm.mutable_tracing()->mutable_provider();
+          provider->set_name("envoy.tracers.opentelemetry");
+          provider->mutable_typed_config()->PackFrom(config);
+        });
+
+    autonomous_upstream_ = true;
+    HttpIntegrationTest::initialize();
+  }
+
+  void sendTracedRequest() {
+    Http::TestRequestHeaderMapImpl request_headers = default_request_headers_;
+    request_headers.addCopy("traceparent", std::string(Traceparent));
+    auto response = codec_client_->makeHeaderOnlyRequest(request_headers);
+    ASSERT_TRUE(response->waitForEndStream());
+    EXPECT_EQ("200", response->headers().getStatusValue());
+  }
+
+  ABSL_MUST_USE_RESULT
+  AssertionResult
+  waitForExportRequest(opentelemetry::proto::collector::trace::v1::ExportTraceServiceRequest&
+                           request) {
+    if (fake_collector_connection_ == nullptr) {
+      VERIFY_ASSERTION(
+          fake_upstreams_[1]->waitForHttpConnection(*dispatcher_, fake_collector_connection_));
+      VERIFY_ASSERTION(fake_collector_connection_->waitForNewStream(*dispatcher_, export_stream_));
+    }
+    VERIFY_ASSERTION(export_stream_->waitForGrpcMessage(*dispatcher_, request));
+    EXPECT_EQ("/opentelemetry.proto.collector.trace.v1.TraceService/Export",
+              export_stream_->headers().getPathValue());
+    EXPECT_EQ("application/grpc", export_stream_->headers().getContentTypeValue());
+    return AssertionSuccess();
+  }
+
+  void cleanup() {
+    codec_client_->close();
+    if (fake_collector_connection_ != nullptr) {
+      AssertionResult result = fake_collector_connection_->close();
+      RELEASE_ASSERT(result, result.message());
+      result = fake_collector_connection_->waitForDisconnect();
+      RELEASE_ASSERT(result, result.message());
+    }
+  }
+
+  FakeHttpConnectionPtr fake_collector_connection_;
+  FakeStreamPtr export_stream_;
+};
+
+INSTANTIATE_TEST_SUITE_P(IpVersionsClientType, BatchExportIntegrationTest,
+                         GRPC_CLIENT_INTEGRATION_PARAMS,
+                         Grpc::GrpcClientIntegrationParamTest::protocolTestParamsToString);
+
+// A full batch is exported as one request.
+TEST_P(BatchExportIntegrationTest, ExportsFullBatch) {
+  initializeWithBatchExport(R"EOF(
+  max_export_batch_size: 2
+  max_export_delay: 3600s
+  )EOF");
+  codec_client_ = makeHttpConnection(lookupPort("http"));
+  sendTracedRequest();
+  sendTracedRequest();
+
+  opentelemetry::proto::collector::trace::v1::ExportTraceServiceRequest request;
+  ASSERT_TRUE(waitForExportRequest(request));
+  ASSERT_EQ(1, request.resource_spans_size());
+  bool found_service_name = false;
+  for (const auto& attribute : request.resource_spans(0).resource().attributes()) {
+    if (attribute.key() == "service.name") {
+      EXPECT_EQ("batch_service", attribute.value().string_value());
+      found_service_name = true;
+    }
+  }
+  EXPECT_TRUE(found_service_name);
+  ASSERT_EQ(1, request.resource_spans(0).scope_spans_size());
+  const auto& spans = request.resource_spans(0).scope_spans(0).spans();
+  ASSERT_EQ(2, spans.size());
+  for (const auto& span : spans) {
+    EXPECT_EQ(TraceId, absl::BytesToHexString(span.trace_id()));
+  }
+
+  test_server_->waitForCounterEq("tracing.opentelemetry.export_batches", 1);
+  test_server_->waitForCounterEq("tracing.opentelemetry.spans_sent", 2);
+  EXPECT_EQ(0, test_server_->counter("tracing.opentelemetry.spans_dropped")->value());
+  cleanup();
+}
+
+// Spans that do not fill a batch are exported after the maximum delay.
+TEST_P(BatchExportIntegrationTest, ExportsAfterMaxDelay) {
+  initializeWithBatchExport(R"EOF(
+  max_export_batch_size: 100
+  max_export_delay: 0.1s
+  )EOF");
+  codec_client_ = makeHttpConnection(lookupPort("http"));
+  sendTracedRequest();
+
+  opentelemetry::proto::collector::trace::v1::ExportTraceServiceRequest request;
+  ASSERT_TRUE(waitForExportRequest(request));
+  EXPECT_EQ(1, request.resource_spans(0).scope_spans(0).spans_size());
+
+  // Later spans are sent on the same stream.
+  sendTracedRequest();
+  ASSERT_TRUE(waitForExportRequest(request));
+  EXPECT_EQ(1, request.resource_spans(0).scope_spans(0).spans_size());
+  test_server_->waitForCounterEq("tracing.opentelemetry.spans_sent", 2);
+  cleanup();
+}
+
+} // namespace
+} // namespace OpenTelemetry
+} // namespace Tracers
+} // namespace Extensions
+} // namespace Envoy
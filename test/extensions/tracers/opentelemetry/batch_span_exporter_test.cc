@@ -0,0 +1,249 @@
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/common/buffer/zero_copy_input_stream_impl.h"
+#include "source/common/stats/isolated_store_impl.h"
+#include "source/extensions/tracers/opentelemetry/batch_span_exporter.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/test_common/thread_factory_for_test.h"
+#include "test/test_common/utility.h"
+
+#include "absl/synchronization/notification.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Tracers {
+namespace OpenTelemetry {
+namespace {
+
+using testing::_;
+using testing::Invoke;
+
+// Records the requests it is asked to export.
+class FakeTraceExporter : public OpenTelemetryTraceExporter {
+public:
+  bool log(const ExportTraceServiceRequest& request) override {
+    requests_.push_back(request);
+    return true;
+  }
+  bool logSerialized(Buffer::InstancePtr&& request) override {
+    ExportTraceServiceRequest message;
+    Buffer::ZeroCopyInputStreamImpl request_stream(std::move(request));
+    EXPECT_TRUE(message.ParseFromZeroCopyStream(&request_stream));
+    requests_.push_back(message);
+    return accept_;
+  }
+
+  std::vector<ExportTraceServiceRequest> requests_;
+  // Whether serialized requests are accepted for sending.
+  bool accept_{true};
+};
+
+class BatchSpanExporterTest : public testing::Test {
+public:
+  void initialize(const std::string& config_yaml) {
+    envoy::config::trace::v3::OpenTelemetryConfig::BatchExportConfig config;
+    TestUtility::loadFromYaml(config_yaml, config);
+    auto exporter = std::make_shared<FakeTraceExporter>();
+    exporter_ = exporter.get();
+    auto resource = std::make_shared<Resource>();
+    resource->attributes_.insert({"service.name", "test"});
+    batch_exporter_ = std::make_unique<BatchSpanExporter>(
+        config, exporter, dispatcher_, Thread::threadFactoryForTest(), stats_, resource);
+  }
+
+  void enqueueSpan(const std::string& name) {
+    auto span = std::make_unique<::opentelemetry::proto::trace::v1::Span>();
+    span->set_name(name);
+    batch_exporter_->enqueue(std::move(span));
+  }
+
+  // Waits for the export thread to hand a batch to the main dispatcher. The batch is exported
+  // when the returned callback runs.
+  Event::PostCb waitForBatch(std::function<void()> enqueue_spans) {
+    absl::Notification posted;
+    Event::PostCb export_batch;
+    EXPECT_CALL(dispatcher_, post(_)).WillOnce(Invoke([&](Event::PostCb cb) {
+      export_batch = std::move(cb);
+      posted.Notify();
+    }));
+    enqueue_spans();
+    posted.WaitForNotification();
+    return export_batch;
+  }
+
+  std::vector<std::string> exportedSpanNames(size_t request) {
+    std::vector<std::string> names;
+    for (const auto& span :
+         exporter_->requests_.at(request).resource_spans(0).scope_spans(0).spans()) {
+      names.push_back(span.name());
+    }
+    return names;
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  OpenTelemetryTracerStats stats_{
+      OPENTELEMETRY_TRACER_STATS(POOL_COUNTER_PREFIX(*stats_store_.rootScope(), "tracing."))};
+  Event::MockDispatcher dispatcher_;
+  FakeTraceExporter* exporter_;
+  std::unique_ptr<BatchSpanExporter> batch_exporter_;
+};
+
+// A batch is exported as soon as it is full, with the resource attributes and spans in order.
+TEST_F(BatchSpanExporterTest, ExportsFullBatch) {
+  initialize(R"EOF(
+  max_export_batch_size: 2
+  max_export_delay: 3600s
+  )EOF");
+
+  Event::PostCb export_batch = waitForBatch([this]() {
+    enqueueSpan("first");
+    enqueueSpan("second");
+  });
+  // Nothing is counted until the batch is handed to the exporter on the main thread.
+  EXPECT_EQ(0U, stats_.export_batches_.value());
+  export_batch();
+
+  ASSERT_EQ(1, exporter_->requests_.size());
+  const auto& resource_span = exporter_->requests_[0].resource_spans(0);
+  ASSERT_EQ(1, resource_span.resource().attributes_size());
+  EXPECT_EQ("service.name", resource_span.resource().attributes(0).key());
+  EXPECT_EQ("test", resource_span.resource().attributes(0).value().string_value());
+  EXPECT_EQ((std::vector<std::string>{"first", "second"}), exportedSpanNames(0));
+  EXPECT_EQ(2U, stats_.spans_sent_.value());
+  EXPECT_EQ(1U, stats_.export_batches_.value());
+}
+
+// Spans that do not fill a batch are exported once the maximum delay passes.
+TEST_F(BatchSpanExporterTest, ExportsAfterMaxDelay) {
+  initialize(R"EOF(
+  max_export_batch_size: 100
+  max_export_delay: 0.01s
+  )EOF");
+
+  Event::PostCb export_batch = waitForBatch([this]() { enqueueSpan("only"); });
+  export_batch();
+
+  ASSERT_EQ(1, exporter_->requests_.size());
+  EXPECT_EQ((std::vector<std::string>{"only"}), exportedSpanNames(0));
+  EXPECT_EQ(1U, stats_.spans_sent_.value());
+}
+
+// With the default drop policy, spans finished while the queue is full are dropped.
+TEST_F(BatchSpanExporterTest, DropNewest) {
+  initialize(R"EOF(
+  max_queue_size: 2
+  max_export_batch_size: 100
+  max_export_delay: 1s
+  )EOF");
+
+  Event::PostCb export_batch = waitForBatch([this]() {
+    enqueueSpan("first");
+    enqueueSpan("second");
+    enqueueSpan("third");
+    EXPECT_EQ(1U, stats_.spans_dropped_.value());
+  });
+  export_batch();
+
+  EXPECT_EQ((std::vector<std::string>{"first", "second"}), exportedSpanNames(0));
+}
+
+// With DROP_OLDEST, the oldest waiting span makes room for a span finished while the queue is full.
+TEST_F(BatchSpanExporterTest, DropOldest) {
+  initialize(R"EOF(
+  max_queue_size: 2
+  max_export_batch_size: 100
+  max_export_delay: 1s
+  drop_policy: DROP_OLDEST
+  )EOF");
+
+  Event::PostCb export_batch = waitForBatch([this]() {
+    enqueueSpan("first");
+    enqueueSpan("second");
+    enqueueSpan("third");
+    EXPECT_EQ(1U, stats_.spans_dropped_.value());
+  });
+  export_batch();
+
+  EXPECT_EQ((std::vector<std::string>{"second", "third"}), exportedSpanNames(0));
+}
+
+// A batch that is still waiting for the main thread when the exporter is destroyed is not sent.
+TEST_F(BatchSpanExporterTest, DestroyedWithBatchInFlight) {
+  initialize(R"EOF(
+  max_export_batch_size: 1
+  max_export_delay: 3600s
+  )EOF");
+
+  Event::PostCb export_batch = waitForBatch([this]() { enqueueSpan("first"); });
+  batch_exporter_.reset();
+  export_batch();
+
+  EXPECT_EQ(0U, stats_.spans_sent_.value());
+  EXPECT_EQ(0U, stats_.export_batches_.value());
+}
+
+// A request the exporter can not send is counted as a failed batch, and its spans as not sent.
+TEST_F(BatchSpanExporterTest, ExportFailure) {
+  initialize(R"EOF(
+  max_export_batch_size: 1
+  max_export_delay: 3600s
+  )EOF");
+
+  Event::PostCb export_batch = waitForBatch([this]() { enqueueSpan("first"); });
+  exporter_->accept_ = false;
+  export_batch();
+
+  ASSERT_EQ(1, exporter_->requests_.size());
+  EXPECT_EQ(1U, stats_.export_batches_failed_.value());
+  EXPECT_EQ(0U, stats_.export_batches_.value());
+  EXPECT_EQ(0U, stats_.spans_sent_.value());
+}
+
+// Spans still queued when the exporter is destroyed are sent once, without going through the
+// main dispatcher.
+TEST_F(BatchSpanExporterTest, SendsQueuedSpansOnDestruction) {
+  initialize(R"EOF(
+  max_export_batch_size: 100
+  max_export_delay: 3600s
+  )EOF");
+
+  EXPECT_CALL(dispatcher_, post(_)).Times(0);
+  enqueueSpan("first");
+  enqueueSpan("second");
+  batch_exporter_.reset();
+
+  EXPECT_EQ(2U, stats_.spans_sent_.value());
+  EXPECT_EQ(1U, stats_.export_batches_.value());
+}
+
+// Spans finished after shutdown, e.g. by requests still in flight on workers once the driver is
+// gone, are dropped while the exporter is kept alive by the workers' tracers.
+TEST_F(BatchSpanExporterTest, DropsSpansAfterShutdown) {
+  initialize(R"EOF(
+  max_export_batch_size: 100
+  max_export_delay: 3600s
+  )EOF");
+
+  EXPECT_CALL(dispatcher_, post(_)).Times(0);
+  enqueueSpan("first");
+  batch_exporter_->shutdown();
+  EXPECT_EQ(1U, stats_.spans_sent_.value());
+
+  enqueueSpan("second");
+  EXPECT_EQ(1U, stats_.spans_dropped_.value());
+  batch_exporter_.reset();
+  EXPECT_EQ(1U, stats_.spans_sent_.value());
+  EXPECT_EQ(1U, stats_.export_batches_.value());
+}
+
+} // namespace
+} // namespace OpenTelemetry
+} // namespace Tracers
+} // namespace Extensions
+} // namespace Envoy
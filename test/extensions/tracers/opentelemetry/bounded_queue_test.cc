@@ -0,0 +1,113 @@
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "source/extensions/tracers/opentelemetry/bounded_queue.h"
+
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Tracers {
+namespace OpenTelemetry {
+namespace {
+
+TEST(BoundedQueueTest, CapacityRoundedUp) {
+  EXPECT_EQ(2, BoundedQueue<int>(0).capacity());
+  EXPECT_EQ(2, BoundedQueue<int>(1).capacity());
+  EXPECT_EQ(4, BoundedQueue<int>(3).capacity());
+  EXPECT_EQ(4, BoundedQueue<int>(4).capacity());
+}
+
+TEST(BoundedQueueTest, FirstInFirstOut) {
+  BoundedQueue<int> queue(4);
+  int value = 0;
+  EXPECT_FALSE(queue.pop(value));
+
+  // Go around the ring a few times.
+  for (int lap = 0; lap < 3; lap++) {
+    for (int i = 0; i < 4; i++) {
+      int pushed = lap * 4 + i;
+      EXPECT_TRUE(queue.push(pushed));
+    }
+    EXPECT_EQ(4, queue.size());
+    for (int i = 0; i < 4; i++) {
+      EXPECT_TRUE(queue.pop(value));
+      EXPECT_EQ(lap * 4 + i, value);
+    }
+    EXPECT_EQ(0, queue.size());
+    EXPECT_FALSE(queue.pop(value));
+  }
+}
+
+TEST(BoundedQueueTest, FullQueueRejectsPush) {
+  BoundedQueue<std::unique_ptr<int>> queue(2);
+  auto first = std::make_unique<int>(1);
+  auto second = std::make_unique<int>(2);
+  auto third = std::make_unique<int>(3);
+  EXPECT_TRUE(queue.push(first));
+  EXPECT_TRUE(queue.push(second));
+  EXPECT_EQ(nullptr, first);
+
+  // A rejected element is left with the caller.
+  EXPECT_FALSE(queue.push(third));
+  ASSERT_NE(nullptr, third);
+  EXPECT_EQ(3, *third);
+
+  std::unique_ptr<int> value;
+  EXPECT_TRUE(queue.pop(value));
+  EXPECT_EQ(1, *value);
+  EXPECT_TRUE(queue.push(third));
+  EXPECT_TRUE(queue.pop(value));
+  EXPECT_EQ(2, *value);
+  EXPECT_TRUE(queue.pop(value));
+  EXPECT_EQ(3, *value);
+}
+
+// Every element pushed by concurrent producers is popped exactly once by concurrent consumers.
+TEST(BoundedQueueTest, ConcurrentProducersAndConsumers) {
+  constexpr int NumProducers = 4;
+  constexpr int NumConsumers = 2;
+  constexpr int ValuesPerProducer = 10000;
+  BoundedQueue<int> queue(64);
+  std::vector<std::atomic<int>> seen(NumProducers * ValuesPerProducer);
+  std::atomic<int> popped{0};
+
+  std::vector<Thread::ThreadPtr> threads;
+  for (int producer = 0; producer < NumProducers; producer++) {
+    threads.push_back(Thread::threadFactoryForTest().createThread([&queue, producer]() {
+      for (int i = 0; i < ValuesPerProducer; i++) {
+        int value = producer * ValuesPerProducer + i;
+        while (!queue.push(value)) {
+        }
+      }
+    }));
+  }
+  for (int consumer = 0; consumer < NumConsumers; consumer++) {
+    threads.push_back(Thread::threadFactoryForTest().createThread([&]() {
+      int value;
+      while (popped.load() < NumProducers * ValuesPerProducer) {
+        if (queue.pop(value)) {
+          seen[value]++;
+          popped++;
+        }
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+
+  for (const auto& count : seen) {
+    EXPECT_EQ(1, count.load());
+  }
+  EXPECT_EQ(0, queue.size());
+}
+
+} // namespace
+} // namespace OpenTelemetry
+} // namespace Tracers
+} // namespace Extensions
+} // namespace Envoy
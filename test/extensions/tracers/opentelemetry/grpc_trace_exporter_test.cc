@@ -1,6 +1,9 @@
 #include <sys/types.h>
 
+#include "source/common/buffer/buffer_impl.h"
 #include "source/common/buffer/zero_copy_input_stream_impl.h"
+#include "source/common/grpc/codec.h"
+#include "source/common/grpc/common.h"
 #include "source/extensions/tracers/opentelemetry/grpc_trace_exporter.h"
 
 #include "test/mocks/common.h"
@@ -109,6 +112,35 @@ TEST_F(OpenTelemetryGrpcTraceExporterTest, ExportWithRemoteClose) {
   EXPECT_TRUE(exporter.log(request));
 }
 
+// A serialized request is handed to the stream unframed, so that it goes out as a single gRPC
+// frame once the stream adds its header.
+TEST_F(OpenTelemetryGrpcTraceExporterTest, ExportSerializedAsSingleFrame) {
+  OpenTelemetryGrpcTraceExporter exporter(Grpc::RawAsyncClientPtr{async_client_});
+  opentelemetry::proto::collector::trace::v1::ExportTraceServiceRequest request;
+  opentelemetry::proto::trace::v1::Span span;
+  span.set_name("test");
+  *request.add_resource_spans()->add_scope_spans()->add_spans() = span;
+
+  Buffer::OwnedImpl sent;
+  EXPECT_CALL(stream_, isAboveWriteBufferHighWatermark()).WillOnce(Return(false));
+  EXPECT_CALL(stream_, sendMessageRaw_(_, false))
+      .WillOnce(Invoke([&sent](Buffer::InstancePtr& message, bool) { sent.move(*message); }));
+  auto serialized = std::make_unique<Buffer::OwnedImpl>(request.SerializeAsString());
+  EXPECT_TRUE(exporter.logSerialized(std::move(serialized)));
+
+  // Frame the message as Grpc::AsyncStreamImpl::sendMessageRaw() does before writing it.
+  Grpc::Common::prependGrpcFrameHeader(sent);
+  Grpc::Decoder decoder;
+  std::vector<Grpc::Frame> frames;
+  ASSERT_TRUE(decoder.decode(sent, frames));
+  ASSERT_EQ(1, frames.size());
+  EXPECT_EQ(request.ByteSizeLong(), frames[0].length_);
+
+  opentelemetry::proto::collector::trace::v1::ExportTraceServiceRequest received;
+  ASSERT_TRUE(received.ParseFromString(frames[0].data_->toString()));
+  EXPECT_TRUE(TestUtility::protoEqual(request, received));
+}
+
 TEST_F(OpenTelemetryGrpcTraceExporterTest, ExportWithNoopCallbacks) {
   OpenTelemetryGrpcTraceExporter exporter(Grpc::RawAsyncClientPtr{async_client_});
   expectStreamMessage(R"EOF(
@@ -10,6 +10,7 @@
 #include "test/mocks/stats/mocks.h"
 #include "test/mocks/stream_info/mocks.h"
 #include "test/mocks/tracing/mocks.h"
+#include "test/test_common/test_runtime.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
@@ -288,6 +289,62 @@ TEST_F(OpenTelemetryDriverTest, NullSpanWithPropagationHeaderError) {
   EXPECT_EQ(typeid(null_span).name(), typeid(Tracing::NullSpan).name());
 }
 
+// Verifies that an unsampled inbound context is forwarded unchanged without building a span.
+TEST_F(OpenTelemetryDriverTest, ForwardUnsampledContext) {
+  setupValidDriver();
+  Http::TestRequestHeaderMapImpl request_headers{
+      {":authority", "test.com"}, {":path", "/"}, {":method", "GET"}};
+  const std::string traceparent = "00-00000000000000000000000000000001-0000000000000002-00";
+  request_headers.addReferenceKey(OpenTelemetryConstants::get().TRACE_PARENT, traceparent);
+  request_headers.addReferenceKey(OpenTelemetryConstants::get().TRACE_STATE, "test=foo");
+
+  // No span ids are generated for a span that is never exported.
+  EXPECT_CALL(context_.server_factory_context_.api_.random_, random()).Times(0);
+  Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                             operation_name_, {Tracing::Reason::Sampling, true});
+  EXPECT_FALSE(span->isRecording());
+  EXPECT_EQ("00000000000000000000000000000001", span->getTraceIdAsHex());
+
+  // The inbound headers are overwritten in place, as they are when the request is forwarded.
+  span->injectContext(request_headers, nullptr);
+  EXPECT_EQ(traceparent, request_headers.get_(OpenTelemetryConstants::get().TRACE_PARENT));
+  EXPECT_EQ("test=foo", request_headers.get_(OpenTelemetryConstants::get().TRACE_STATE));
+
+  Tracing::SpanPtr child =
+      span->spawnChild(mock_tracing_config_, operation_name_, time_system_.systemTime());
+  EXPECT_FALSE(child->isRecording());
+  Http::TestRequestHeaderMapImpl child_headers;
+  child->injectContext(child_headers, nullptr);
+  EXPECT_EQ(traceparent, child_headers.get_(OpenTelemetryConstants::get().TRACE_PARENT));
+  EXPECT_EQ("test=foo", child_headers.get_(OpenTelemetryConstants::get().TRACE_STATE));
+
+  EXPECT_CALL(*mock_stream_ptr_, sendMessageRaw_(_, _)).Times(0);
+  child->finishSpan();
+  span->finishSpan();
+  EXPECT_EQ(0U, stats_.counter("tracing.opentelemetry.spans_sent").value());
+}
+
+// Verifies that an unsampled inbound context still builds a span when the runtime guard is off.
+TEST_F(OpenTelemetryDriverTest, UnsampledContextWithoutForwarding) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues(
+      {{"envoy.reloadable_features.otel_forward_unsampled_context", "false"}});
+  setupValidDriver();
+  Http::TestRequestHeaderMapImpl request_headers{
+      {":authority", "test.com"}, {":path", "/"}, {":method", "GET"}};
+  request_headers.addReferenceKey(OpenTelemetryConstants::get().TRACE_PARENT,
+                                  "00-00000000000000000000000000000001-0000000000000002-00");
+
+  ON_CALL(context_.server_factory_context_.api_.random_, random()).WillByDefault(Return(3));
+  Tracing::SpanPtr span = driver_->startSpan(mock_tracing_config_, request_headers, stream_info_,
+                                             operation_name_, {Tracing::Reason::Sampling, true});
+  EXPECT_FALSE(span->isRecording());
+
+  span->injectContext(request_headers, nullptr);
+  EXPECT_EQ("00-00000000000000000000000000000001-0000000000000003-00",
+            request_headers.get_(OpenTelemetryConstants::get().TRACE_PARENT));
+}
+
 // Verifies the export happens after one span is created
 TEST_F(OpenTelemetryDriverTest, ExportOTLPSpan) {
   // Set up driver
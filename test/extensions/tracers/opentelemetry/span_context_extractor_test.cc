@@ -186,6 +186,35 @@ TEST(SpanContextExtractorTest, ExtractSpanContextWithMultipleTracestateEntries)
   EXPECT_EQ(span_context->tracestate(), "sample-tracestate,sample-tracestate-2");
 }
 
+TEST(SpanContextExtractorTest, ExtractTraceparent) {
+  const std::string traceparent = fmt::format("{}-{}-{}-{}", version, trace_id, parent_id, "03");
+  Http::TestRequestHeaderMapImpl request_headers{{"traceparent", traceparent}};
+  SpanContextExtractor span_context_extractor(request_headers);
+  absl::StatusOr<TraceparentView> view = span_context_extractor.extractTraceparent();
+
+  EXPECT_OK(view);
+  EXPECT_EQ(view->value, traceparent);
+  EXPECT_EQ(view->version, version);
+  EXPECT_EQ(view->trace_id, trace_id);
+  EXPECT_EQ(view->parent_id, parent_id);
+  EXPECT_TRUE(view->sampled);
+  EXPECT_EQ(span_context_extractor.extractTracestate(), "");
+}
+
+// Only the least significant bit of the trace flags is the sampled flag.
+TEST(SpanContextExtractorTest, ExtractTraceparentSampledFlag) {
+  for (const auto& [flags, sampled] : std::vector<std::pair<std::string, bool>>{
+           {"00", false}, {"01", true}, {"02", false}, {"0B", true}, {"0a", false}, {"f1", true}}) {
+    Http::TestRequestHeaderMapImpl request_headers{
+        {"traceparent", fmt::format("{}-{}-{}-{}", version, trace_id, parent_id, flags)}};
+    SpanContextExtractor span_context_extractor(request_headers);
+    absl::StatusOr<TraceparentView> view = span_context_extractor.extractTraceparent();
+
+    EXPECT_OK(view);
+    EXPECT_EQ(view->sampled, sampled) << flags;
+  }
+}
+
 } // namespace
 } // namespace OpenTelemetry
 } // namespace Tracers
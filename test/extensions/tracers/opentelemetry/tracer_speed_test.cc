@@ -0,0 +1,99 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+//
+// Measures the tracing overhead of one proxied request: starting the downstream span, propagating
+// its context to the upstream and finalizing it. Run with
+// --runtime_feature=envoy.reloadable_features.otel_forward_unsampled_context:false to compare the
+// unsampled case against building a full span.
+
+#include "source/common/tracing/http_tracer_impl.h"
+#include "source/common/tracing/tracer_impl.h"
+#include "source/extensions/tracers/opentelemetry/opentelemetry_tracer_impl.h"
+
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/server/tracer_factory_context.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/mocks/tracing/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Tracers {
+namespace OpenTelemetry {
+namespace {
+
+using testing::NiceMock;
+
+constexpr absl::string_view SampledTraceparent =
+    "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01";
+constexpr absl::string_view UnsampledTraceparent =
+    "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-00";
+
+class TracerSpeedTest {
+public:
+  TracerSpeedTest() {
+    // No exporter is configured, so sampled spans are built and buffered but not sent anywhere.
+    envoy::config::trace::v3::OpenTelemetryConfig opentelemetry_config;
+    tracer_ = std::make_unique<Tracing::TracerImpl>(
+        std::make_shared<Driver>(opentelemetry_config, context_), local_info_);
+  }
+
+  void runRequests(Tracing::Tracer& tracer, absl::string_view traceparent, bool traced,
+                   benchmark::State& state) {
+    Http::TestRequestHeaderMapImpl request_headers{{":authority", "example.com"},
+                                                   {":path", "/path"},
+                                                   {":method", "GET"},
+                                                   {":scheme", "http"},
+                                                   {"x-request-id", "request-id"},
+                                                   {"user-agent", "benchmark"},
+                                                   {"traceparent", std::string(traceparent)},
+                                                   {"tracestate", "vendor=value"}};
+    Http::TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+
+    for (auto _ : state) { // NOLINT: Silences warning about dead store
+      UNREFERENCED_PARAMETER(_);
+      Tracing::SpanPtr span = tracer.startSpan(config_, request_headers, stream_info_,
+                                               {Tracing::Reason::Sampling, traced});
+      span->injectContext(request_headers, nullptr);
+      Tracing::HttpTracerUtility::finalizeDownstreamSpan(*span, &request_headers,
+                                                         &response_headers, nullptr,
+                                                         stream_info_, config_);
+    }
+  }
+
+  NiceMock<Server::Configuration::MockTracerFactoryContext> context_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<Tracing::MockConfig> config_;
+  NiceMock<StreamInfo::MockStreamInfo> stream_info_;
+  std::unique_ptr<Tracing::Tracer> tracer_;
+};
+
+// Tracing is disabled for the route, so a null tracer is used.
+void bmTracingDisabled(benchmark::State& state) {
+  TracerSpeedTest test;
+  Tracing::NullTracer null_tracer;
+  test.runRequests(null_tracer, SampledTraceparent, false, state);
+}
+BENCHMARK(bmTracingDisabled);
+
+// The inbound traceparent is not sampled, so the context only needs to be forwarded.
+void bmTracingUnsampled(benchmark::State& state) {
+  TracerSpeedTest test;
+  test.runRequests(*test.tracer_, UnsampledTraceparent, false, state);
+}
+BENCHMARK(bmTracingUnsampled);
+
+// The inbound traceparent is sampled, so a span is built, tagged and buffered for export.
+void bmTracingSampled(benchmark::State& state) {
+  TracerSpeedTest test;
+  test.runRequests(*test.tracer_, SampledTraceparent, true, state);
+}
+BENCHMARK(bmTracingSampled);
+
+} // namespace
+} // namespace OpenTelemetry
+} // namespace Tracers
+} // namespace Extensions
+} // namespace Envoy
@@ -1,12 +1,14 @@
 #include <string>
 #include <vector>
 
+#include "source/common/network/transport_socket_options_impl.h"
 #include "source/extensions/transport_sockets/tls/cert_validator/default_validator.h"
 #include "source/extensions/transport_sockets/tls/cert_validator/san_matcher.h"
 
 #include "test/extensions/transport_sockets/tls/cert_validator/test_common.h"
 #include "test/extensions/transport_sockets/tls/ssl_test_utility.h"
 #include "test/test_common/environment.h"
+#include "test/test_common/simulated_time_system.h"
 #include "test/test_common/test_runtime.h"
 #include "test/test_common/utility.h"
 
@@ -313,11 +315,19 @@ public:
   MOCK_METHOD(Api::Api&, api, (), (const override));
   bool onlyVerifyLeafCertificateCrl() const override { return false; }
   absl::optional<uint32_t> maxVerifyDepth() const override { return absl::nullopt; }
+  const absl::optional<envoy::extensions::transport_sockets::tls::v3::
+                           CertificateValidationContext::VerificationCache>&
+  verificationCache() const override {
+    return verification_cache_;
+  }
 
 private:
   std::string s_;
   std::vector<std::string> strs_;
   std::vector<envoy::extensions::transport_sockets::tls::v3::SubjectAltNameMatcher> matchers_;
+  absl::optional<envoy::extensions::transport_sockets::tls::v3::
+                     CertificateValidationContext::VerificationCache>
+      verification_cache_;
 };
 
 TEST(DefaultCertValidatorTest, TestUnexpectedSanMatcherType) {
@@ -352,6 +362,177 @@ TEST(DefaultCertValidatorTest, TestInitializeSslContextFailure) {
                           "Failed to load trusted CA certificates from.*");
 }
 
+class DefaultCertValidatorVerificationCacheTest : public testing::Test {
+protected:
+  DefaultCertValidatorVerificationCacheTest() : stats_(generateSslStats(*store_.rootScope())) {}
+
+  void initialize(uint32_t max_entries, std::chrono::seconds ttl) {
+    envoy::extensions::transport_sockets::tls::v3::CertificateValidationContext::VerificationCache
+        cache;
+    cache.mutable_max_entries()->set_value(max_entries);
+    cache.mutable_ttl()->set_seconds(ttl.count());
+    config_ = std::make_unique<TestCertificateValidationContextConfig>(
+        envoy::config::core::v3::TypedExtensionConfig(), false,
+        std::vector<envoy::extensions::transport_sockets::tls::v3::SubjectAltNameMatcher>{},
+        TestEnvironment::readFileToStringForTest(TestEnvironment::substitute(
+            "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/ca_cert.pem")),
+        absl::nullopt, cache);
+    validator_ = std::make_unique<DefaultCertValidator>(config_.get(), stats_, time_system_);
+    ssl_ctx_.reset(SSL_CTX_new(TLS_method()));
+    validator_->initializeSslContexts({ssl_ctx_.get()}, false);
+  }
+
+  static bssl::UniquePtr<X509> readCert(const std::string& name) {
+    return readCertFromFile(TestEnvironment::substitute(
+        "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/" + name));
+  }
+
+  // Sets the time seen by the validator and by BoringSSL, as the test certificates may have
+  // expired.
+  void setTime(SystemTime time) {
+    time_system_.setSystemTime(time);
+    X509_VERIFY_PARAM_set_time(SSL_CTX_get0_param(ssl_ctx_.get()),
+                               std::chrono::system_clock::to_time_t(time));
+  }
+
+  ValidationResults verify(const std::string& cert_name,
+                           std::vector<std::string>&& verify_san_list = {}) {
+    bssl::UniquePtr<STACK_OF(X509)> cert_chain(sk_X509_new_null());
+    EXPECT_TRUE(bssl::PushToStack(cert_chain.get(), readCert(cert_name)));
+    auto transport_socket_options = std::make_shared<Network::TransportSocketOptionsImpl>(
+        "", std::move(verify_san_list));
+    return validator_->doVerifyCertChain(*cert_chain, /*callback=*/nullptr,
+                                         transport_socket_options, *ssl_ctx_, {}, false, "");
+  }
+
+  uint64_t hits() { return store_.counter("ssl.verification_cache_hit").value(); }
+  uint64_t misses() { return store_.counter("ssl.verification_cache_miss").value(); }
+
+  Event::SimulatedTimeSystem time_system_;
+  Stats::TestUtil::TestStore store_;
+  SslStats stats_;
+  std::unique_ptr<TestCertificateValidationContextConfig> config_;
+  std::unique_ptr<DefaultCertValidator> validator_;
+  bssl::UniquePtr<SSL_CTX> ssl_ctx_;
+};
+
+TEST_F(DefaultCertValidatorVerificationCacheTest, Disabled) {
+  config_ = std::make_unique<TestCertificateValidationContextConfig>();
+  validator_ = std::make_unique<DefaultCertValidator>(config_.get(), stats_, time_system_);
+  EXPECT_EQ(nullptr, validator_->verificationCache());
+}
+
+TEST_F(DefaultCertValidatorVerificationCacheTest, Hit) {
+  initialize(10, std::chrono::seconds(60));
+  const SystemTime not_after = Utility::getExpirationTime(*readCert("san_dns_cert.pem"));
+  setTime(not_after - std::chrono::hours(24));
+
+  ValidationResults results = verify("san_dns_cert.pem");
+  EXPECT_EQ(ValidationResults::ValidationStatus::Successful, results.status);
+  EXPECT_EQ(Ssl::ClientValidationStatus::Validated, results.detailed_status);
+  EXPECT_EQ(0, hits());
+  EXPECT_EQ(1, misses());
+
+  results = verify("san_dns_cert.pem");
+  EXPECT_EQ(ValidationResults::ValidationStatus::Successful, results.status);
+  EXPECT_EQ(Ssl::ClientValidationStatus::Validated, results.detailed_status);
+  EXPECT_EQ(1, hits());
+  EXPECT_EQ(1, misses());
+  EXPECT_EQ(1, validator_->verificationCache()->size());
+}
+
+TEST_F(DefaultCertValidatorVerificationCacheTest, FailureNotCached) {
+  initialize(10, std::chrono::seconds(60));
+  // The certificates aren't valid yet.
+  setTime(Utility::getValidFrom(*readCert("san_dns_cert.pem")) - std::chrono::hours(24));
+
+  for (int i = 0; i < 2; i++) {
+    const ValidationResults results = verify("san_dns_cert.pem");
+    EXPECT_EQ(ValidationResults::ValidationStatus::Failed, results.status);
+    EXPECT_EQ(Ssl::ClientValidationStatus::Failed, results.detailed_status);
+  }
+  EXPECT_EQ(0, hits());
+  EXPECT_EQ(2, misses());
+  EXPECT_EQ(2, store_.counter("ssl.fail_verify_error").value());
+  EXPECT_EQ(0, validator_->verificationCache()->size());
+}
+
+TEST_F(DefaultCertValidatorVerificationCacheTest, Ttl) {
+  initialize(10, std::chrono::seconds(60));
+  const SystemTime not_after = Utility::getExpirationTime(*readCert("san_dns_cert.pem"));
+  setTime(not_after - std::chrono::hours(24));
+
+  verify("san_dns_cert.pem");
+  time_system_.advanceTimeWait(std::chrono::seconds(59));
+  verify("san_dns_cert.pem");
+  EXPECT_EQ(1, hits());
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  EXPECT_EQ(ValidationResults::ValidationStatus::Successful, verify("san_dns_cert.pem").status);
+  EXPECT_EQ(1, hits());
+  EXPECT_EQ(2, misses());
+}
+
+// Chains aren't cached past the expiration of their certificates, regardless of the TTL. This
+// includes the trusted CA, which expires before the certificate.
+TEST_F(DefaultCertValidatorVerificationCacheTest, CertificateExpiration) {
+  initialize(10, std::chrono::seconds(60));
+  const SystemTime not_after = Utility::getExpirationTime(*readCert("ca_cert.pem"));
+  ASSERT_LT(not_after, Utility::getExpirationTime(*readCert("san_dns_cert.pem")));
+  setTime(not_after - std::chrono::seconds(10));
+
+  verify("san_dns_cert.pem");
+  time_system_.advanceTimeWait(std::chrono::seconds(9));
+  verify("san_dns_cert.pem");
+  EXPECT_EQ(1, hits());
+  time_system_.advanceTimeWait(std::chrono::seconds(1));
+  verify("san_dns_cert.pem");
+  EXPECT_EQ(1, hits());
+  EXPECT_EQ(2, misses());
+}
+
+TEST_F(DefaultCertValidatorVerificationCacheTest, LeastRecentlyUsedEviction) {
+  initialize(2, std::chrono::seconds(60));
+  const SystemTime not_after = Utility::getExpirationTime(*readCert("san_dns_cert.pem"));
+  setTime(not_after - std::chrono::hours(24));
+
+  verify("san_dns_cert.pem");
+  verify("san_uri_cert.pem");
+  // Makes the URI certificate the least recently used.
+  verify("san_dns_cert.pem");
+  EXPECT_EQ(1, hits());
+  verify("san_dns2_cert.pem");
+  EXPECT_EQ(2, validator_->verificationCache()->size());
+  EXPECT_EQ(3, misses());
+
+  verify("san_dns_cert.pem");
+  EXPECT_EQ(2, hits());
+  verify("san_uri_cert.pem");
+  EXPECT_EQ(2, hits());
+  EXPECT_EQ(4, misses());
+}
+
+// The subject alt names which a connection verifies are part of the key of the cache.
+TEST_F(DefaultCertValidatorVerificationCacheTest, VerifySanListOverride) {
+  initialize(10, std::chrono::seconds(60));
+  const SystemTime not_after = Utility::getExpirationTime(*readCert("san_dns_cert.pem"));
+  setTime(not_after - std::chrono::hours(24));
+
+  EXPECT_EQ(ValidationResults::ValidationStatus::Successful,
+            verify("san_dns_cert.pem", {"server1.example.com"}).status);
+  EXPECT_EQ(ValidationResults::ValidationStatus::Successful,
+            verify("san_dns_cert.pem", {"server1.example.com"}).status);
+  EXPECT_EQ(1, hits());
+
+  for (int i = 0; i < 2; i++) {
+    const ValidationResults results = verify("san_dns_cert.pem", {"server2.example.net"});
+    EXPECT_EQ(ValidationResults::ValidationStatus::Failed, results.status);
+    EXPECT_EQ(Ssl::ClientValidationStatus::Failed, results.detailed_status);
+  }
+  EXPECT_EQ(1, hits());
+  EXPECT_EQ(3, misses());
+  EXPECT_EQ(2, store_.counter("ssl.fail_verify_san").value());
+}
+
 } // namespace Tls
 } // namespace TransportSockets
 } // namespace Extensions
@@ -7,6 +7,7 @@
 #include "envoy/config/core/v3/address.pb.h"
 #include "envoy/config/core/v3/base.pb.h"
 #include "envoy/extensions/filters/network/http_connection_manager/v3/http_connection_manager.pb.h"
+#include "envoy/extensions/transport_sockets/tls/v3/tls.pb.h"
 
 #include "source/common/event/dispatcher_impl.h"
 #include "source/common/network/connection_impl.h"
@@ -388,6 +389,32 @@ TEST_P(SslIntegrationTest, RouterRequestAndResponseWithBodyNoBufferHttp2VerifySA
   checkStats();
 }
 
+// Depending on the kernel, the downstream connection is either offloaded or keeps using BoringSSL.
+// Requests go through either way, with bodies spanning many records in both directions.
+TEST_P(SslIntegrationTest, RouterRequestAndResponseWithBodyKernelTls) {
+  config_helper_.addConfigModifier([](envoy::config::bootstrap::v3::Bootstrap& bootstrap) {
+    auto* transport_socket = bootstrap.mutable_static_resources()
+                                 ->mutable_listeners(0)
+                                 ->mutable_filter_chains(0)
+                                 ->mutable_transport_socket();
+    envoy::extensions::transport_sockets::tls::v3::DownstreamTlsContext tls_context;
+    transport_socket->typed_config().UnpackTo(&tls_context);
+    tls_context.mutable_common_tls_context()->set_enable_kernel_tls(true);
+    transport_socket->mutable_typed_config()->PackFrom(tls_context);
+  });
+  ConnectionCreationFunction creator = [&]() -> Network::ClientConnectionPtr {
+    return makeSslClientConnection({});
+  };
+  testRouterRequestAndResponseWithBody(1024 * 1024, 1024 * 1024, false, false, &creator);
+  checkStats();
+  const uint64_t offloaded =
+      test_server_->counter(listenerStatPrefix("ssl.kernel_tls_offloaded"))->value();
+  const uint64_t unsupported =
+      test_server_->counter(listenerStatPrefix("ssl.kernel_tls_unsupported"))->value();
+  EXPECT_EQ(1, offloaded + unsupported);
+  EXPECT_EQ(0, test_server_->counter(listenerStatPrefix("ssl.connection_error"))->value());
+}
+
 TEST_P(SslIntegrationTest, RouterHeaderOnlyRequestAndResponse) {
   ConnectionCreationFunction creator = [&]() -> Network::ClientConnectionPtr {
     return makeSslClientConnection({});
@@ -0,0 +1,345 @@
+#include <string>
+
+#include "source/common/network/io_socket_handle_impl.h"
+#include "source/extensions/transport_sockets/tls/ktls.h"
+
+#include "test/mocks/network/io_handle.h"
+#include "test/test_common/environment.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "openssl/ssl.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace KernelTls {
+namespace {
+
+#if defined(__linux__)
+
+using testing::_;
+using testing::Return;
+
+// A TLS connection over the loopback interface, between a server whose record layer may be
+// offloaded to the kernel and a client which always uses BoringSSL, so that the keys installed in
+// the kernel are checked against an independent implementation of the record layer.
+class KernelTlsTest : public testing::Test {
+protected:
+  void SetUp() override {
+    const os_fd_t listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listener, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof(address);
+    ASSERT_EQ(0, bind(listener, reinterpret_cast<sockaddr*>(&address), address_length));
+    ASSERT_EQ(0, listen(listener, 1));
+    ASSERT_EQ(0, getsockname(listener, reinterpret_cast<sockaddr*>(&address), &address_length));
+    client_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(0, connect(client_fd_, reinterpret_cast<sockaddr*>(&address), address_length));
+    server_handle_ =
+        std::make_unique<Network::IoSocketHandleImpl>(accept(listener, nullptr, nullptr));
+    close(listener);
+    ASSERT_TRUE(server_handle_->isOpen());
+  }
+
+  void TearDown() override {
+    if (client_fd_ >= 0) {
+      close(client_fd_);
+    }
+    resetForTest();
+  }
+
+  // Runs the handshake, with both ends limited to the given version and cipher.
+  void handshake(uint16_t version, const char* cipher) {
+    server_ctx_.reset(SSL_CTX_new(TLS_method()));
+    client_ctx_.reset(SSL_CTX_new(TLS_method()));
+    for (SSL_CTX* ctx : {server_ctx_.get(), client_ctx_.get()}) {
+      ASSERT_TRUE(SSL_CTX_set_min_proto_version(ctx, version));
+      ASSERT_TRUE(SSL_CTX_set_max_proto_version(ctx, version));
+      ASSERT_TRUE(SSL_CTX_set_strict_cipher_list(ctx, cipher));
+    }
+    ASSERT_TRUE(SSL_CTX_use_certificate_chain_file(
+        server_ctx_.get(),
+        TestEnvironment::substitute(
+            "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/unittest_cert.pem")
+            .c_str()));
+    ASSERT_TRUE(SSL_CTX_use_PrivateKey_file(
+        server_ctx_.get(),
+        TestEnvironment::substitute(
+            "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/unittest_key.pem")
+            .c_str(),
+        SSL_FILETYPE_PEM));
+
+    server_.reset(SSL_new(server_ctx_.get()));
+    client_.reset(SSL_new(client_ctx_.get()));
+    SSL_set_accept_state(server_.get());
+    SSL_set_connect_state(client_.get());
+    ASSERT_TRUE(SSL_set_fd(server_.get(), server_handle_->fdDoNotUse()));
+    ASSERT_TRUE(SSL_set_fd(client_.get(), client_fd_));
+    for (os_fd_t fd : {server_handle_->fdDoNotUse(), client_fd_}) {
+      ASSERT_EQ(0, fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK));
+    }
+
+    // Both ends are non-blocking, so they take turns until neither has anything left to do.
+    bool server_done = false;
+    bool client_done = false;
+    while (!server_done || !client_done) {
+      bool progress = false;
+      for (auto [ssl, done] : {std::make_pair(server_.get(), &server_done),
+                               std::make_pair(client_.get(), &client_done)}) {
+        if (*done) {
+          continue;
+        }
+        const int rc = SSL_do_handshake(ssl);
+        if (rc == 1) {
+          *done = progress = true;
+        } else {
+          ASSERT_EQ(SSL_ERROR_WANT_READ, SSL_get_error(ssl, rc));
+        }
+      }
+      if (!progress) {
+        // Give the other end a chance to receive what was just sent.
+        usleep(1000);
+      }
+    }
+  }
+
+  // Offloads the server.
+  // @return false if the kernel can't do it, in which case the test is skipped.
+  bool offloadServer() {
+    std::string details;
+    const OffloadResult result = offload(server_.get(), *server_handle_, details);
+    if (result == OffloadResult::Unsupported &&
+        details.find("the kernel doesn't support") != std::string::npos) {
+      skip_reason_ = details;
+      return false;
+    }
+    EXPECT_EQ(OffloadResult::Offloaded, result) << details;
+    return true;
+  }
+
+  // Reads exactly length bytes of application data on the client.
+  std::string clientRead(size_t length) {
+    std::string data(length, '\0');
+    size_t read = 0;
+    while (read < length) {
+      const int rc = SSL_read(client_.get(), data.data() + read, length - read);
+      if (rc > 0) {
+        read += rc;
+        continue;
+      }
+      EXPECT_EQ(SSL_ERROR_WANT_READ, SSL_get_error(client_.get(), rc));
+      usleep(1000);
+    }
+    return data;
+  }
+
+  // Reads exactly length bytes of plaintext from the server socket.
+  std::string serverRead(size_t length) {
+    std::string data(length, '\0');
+    size_t read = 0;
+    while (read < length) {
+      const ssize_t rc = ::read(server_handle_->fdDoNotUse(), data.data() + read, length - read);
+      if (rc > 0) {
+        read += rc;
+        continue;
+      }
+      EXPECT_EQ(EAGAIN, errno);
+      usleep(1000);
+    }
+    return data;
+  }
+
+  // Checks that application data goes through in both directions.
+  void exchangeData() {
+    const std::string request = "hello from the client";
+    ASSERT_EQ(static_cast<int>(request.size()),
+              SSL_write(client_.get(), request.data(), request.size()));
+    EXPECT_EQ(request, serverRead(request.size()));
+
+    const std::string response(20000, 'r');
+    ASSERT_EQ(static_cast<ssize_t>(response.size()),
+              ::write(server_handle_->fdDoNotUse(), response.data(), response.size()));
+    EXPECT_EQ(response, clientRead(response.size()));
+  }
+
+  os_fd_t client_fd_{-1};
+  std::string skip_reason_;
+  std::unique_ptr<Network::IoSocketHandleImpl> server_handle_;
+  bssl::UniquePtr<SSL_CTX> server_ctx_;
+  bssl::UniquePtr<SSL_CTX> client_ctx_;
+  bssl::UniquePtr<SSL> server_;
+  bssl::UniquePtr<SSL> client_;
+};
+
+TEST_F(KernelTlsTest, Tls12Aes128Gcm) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  if (!offloadServer()) {
+    GTEST_SKIP() << skip_reason_;
+  }
+  exchangeData();
+}
+
+TEST_F(KernelTlsTest, Tls12Aes256Gcm) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES256-GCM-SHA384");
+  if (!offloadServer()) {
+    GTEST_SKIP() << skip_reason_;
+  }
+  exchangeData();
+}
+
+// The server sends its session tickets during the handshake, so the kernel starts from a non-zero
+// write sequence number.
+TEST_F(KernelTlsTest, Tls13Server) {
+  handshake(TLS1_3_VERSION, "ALL");
+  if (!offloadServer()) {
+    GTEST_SKIP() << skip_reason_;
+  }
+  exchangeData();
+}
+
+TEST_F(KernelTlsTest, Tls13ClientUnsupported) {
+  handshake(TLS1_3_VERSION, "ALL");
+  std::string details;
+  Network::IoSocketHandleImpl client_handle(dup(client_fd_));
+  EXPECT_EQ(OffloadResult::Unsupported, offload(client_.get(), client_handle, details));
+  EXPECT_EQ("TLS 1.3 clients receive session tickets after the handshake", details);
+}
+
+TEST_F(KernelTlsTest, UnsupportedCipher) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-CHACHA20-POLY1305");
+  std::string details;
+  EXPECT_EQ(OffloadResult::Unsupported, offload(server_.get(), *server_handle_, details));
+  EXPECT_EQ("unsupported cipher", details);
+  // The connection keeps working in user space.
+  const std::string request = "still encrypted by BoringSSL";
+  ASSERT_EQ(static_cast<int>(request.size()),
+            SSL_write(client_.get(), request.data(), request.size()));
+  std::string data(request.size(), '\0');
+  int rc;
+  while ((rc = SSL_read(server_.get(), data.data(), data.size())) <= 0) {
+    ASSERT_EQ(SSL_ERROR_WANT_READ, SSL_get_error(server_.get(), rc));
+    usleep(1000);
+  }
+  EXPECT_EQ(request, data.substr(0, rc));
+}
+
+// A kernel which can't decrypt records is found out before it encrypts any, so the connection keeps
+// using BoringSSL, and so do the following connections without asking the kernel again.
+TEST_F(KernelTlsTest, ReadKeysUnsupported) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  Network::MockIoHandle io_handle;
+  EXPECT_CALL(io_handle, setOption(IPPROTO_TCP, TCP_ULP, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{0, 0}));
+  EXPECT_CALL(io_handle, setOption(SOL_TLS, TLS_RX, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{-1, ENOPROTOOPT}));
+  EXPECT_CALL(io_handle, setOption(SOL_TLS, TLS_TX, _, _)).Times(0);
+  std::string details;
+  EXPECT_EQ(OffloadResult::Unsupported, offload(server_.get(), io_handle, details));
+  EXPECT_THAT(details, testing::StartsWith("the kernel doesn't support the cipher: "));
+
+  testing::Mock::VerifyAndClearExpectations(&io_handle);
+  EXPECT_CALL(io_handle, setOption(_, _, _, _)).Times(0);
+  EXPECT_EQ(OffloadResult::Unsupported, offload(server_.get(), io_handle, details));
+  EXPECT_EQ("the kernel refused to offload an earlier connection", details);
+
+  // The connection keeps working in user space.
+  const std::string request = "still encrypted by BoringSSL";
+  ASSERT_EQ(static_cast<int>(request.size()),
+            SSL_write(client_.get(), request.data(), request.size()));
+  std::string data(request.size(), '\0');
+  int rc;
+  while ((rc = SSL_read(server_.get(), data.data(), data.size())) <= 0) {
+    ASSERT_EQ(SSL_ERROR_WANT_READ, SSL_get_error(server_.get(), rc));
+    usleep(1000);
+  }
+  EXPECT_EQ(request, data.substr(0, rc));
+}
+
+TEST_F(KernelTlsTest, PendingData) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  // BoringSSL buffers the records it reads, which the kernel would then never see.
+  const std::string request = "ab";
+  ASSERT_EQ(static_cast<int>(request.size()),
+            SSL_write(client_.get(), request.data(), request.size()));
+  usleep(1000);
+  char byte;
+  ASSERT_EQ(1, SSL_read(server_.get(), &byte, 1));
+  std::string details;
+  EXPECT_EQ(OffloadResult::Unsupported, offload(server_.get(), *server_handle_, details));
+  EXPECT_EQ("pending data", details);
+}
+
+TEST_F(KernelTlsTest, CloseNotifyFromServer) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  if (!offloadServer()) {
+    GTEST_SKIP() << skip_reason_;
+  }
+  ASSERT_EQ(2, sendCloseNotify(*server_handle_).return_value_);
+  char byte;
+  int rc;
+  while ((rc = SSL_read(client_.get(), &byte, 1)) < 0 &&
+         SSL_get_error(client_.get(), rc) == SSL_ERROR_WANT_READ) {
+    usleep(1000);
+  }
+  EXPECT_EQ(SSL_ERROR_ZERO_RETURN, SSL_get_error(client_.get(), rc));
+}
+
+TEST_F(KernelTlsTest, CloseNotifyFromClient) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  if (!offloadServer()) {
+    GTEST_SKIP() << skip_reason_;
+  }
+  ASSERT_EQ(0, SSL_shutdown(client_.get()));
+  usleep(1000);
+
+  // A plain read stops at the alert, which has to be read as a record of its own.
+  char buffer[16];
+  EXPECT_EQ(-1, ::read(server_handle_->fdDoNotUse(), buffer, sizeof(buffer)));
+  EXPECT_EQ(EIO, errno);
+  uint8_t record_type;
+  const Api::SysCallSizeResult result = readRecord(
+      *server_handle_, record_type, reinterpret_cast<uint8_t*>(buffer), sizeof(buffer));
+  ASSERT_EQ(2, result.return_value_);
+  EXPECT_EQ(RecordTypeAlert, record_type);
+  EXPECT_EQ(SSL3_AD_CLOSE_NOTIFY, buffer[1]);
+}
+
+#else
+
+TEST(KernelTlsTest, Unsupported) {
+  bssl::UniquePtr<SSL_CTX> ctx(SSL_CTX_new(TLS_method()));
+  bssl::UniquePtr<SSL> ssl(SSL_new(ctx.get()));
+  Network::IoSocketHandleImpl io_handle;
+  std::string details;
+  EXPECT_EQ(OffloadResult::Unsupported, offload(ssl.get(), io_handle, details));
+  EXPECT_EQ("kernel TLS is only supported on Linux", details);
+}
+
+#endif
+
+} // namespace
+} // namespace KernelTls
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -551,11 +551,12 @@ public:
 
   // Adds a TCP active health check specifier to the given cluster, and waits for the first health
   // check probe to be received.
-  void initTcpHealthCheck(uint32_t cluster_idx) {
+  void initTcpHealthCheck(uint32_t cluster_idx, uint32_t offload_threads = 0) {
     auto& cluster_data = clusters_[cluster_idx];
     auto health_check = addHealthCheck(cluster_data.cluster_);
     health_check->mutable_tcp_health_check()->mutable_send()->set_text("50696E67"); // "Ping"
     health_check->mutable_tcp_health_check()->add_receive()->set_text("506F6E67");  // "Pong"
+    health_check->set_offload_threads(offload_threads);
 
     // Introduce the cluster using compareDiscoveryRequest / sendDiscoveryResponse.
     EXPECT_TRUE(compareDiscoveryRequest(Config::TypeUrl::get().Cluster, "", {}, {}, {}, true));
@@ -621,6 +622,41 @@ TEST_P(TcpHealthCheckIntegrationTest, SingleEndpointTimeoutTcp) {
   EXPECT_EQ(1, test_server_->counter("cluster.cluster_1.health_check.failure")->value());
 }
 
+// Tests a health checker which runs on a health check thread. Its results reach the cluster on the
+// main thread, and it is stopped when the cluster is removed.
+TEST_P(TcpHealthCheckIntegrationTest, SingleEndpointHealthyTcpOffloaded) {
+  const uint32_t cluster_idx = 0;
+  initialize();
+  initTcpHealthCheck(cluster_idx, 2);
+
+  AssertionResult result = clusters_[cluster_idx].host_fake_raw_connection_->write("Pong");
+  RELEASE_ASSERT(result, result.message());
+
+  test_server_->waitForCounterGe("cluster.cluster_1.health_check.success", 1);
+  test_server_->waitForGaugeEq("cluster.cluster_1.membership_healthy", 1);
+  EXPECT_EQ(0, test_server_->counter("cluster.cluster_1.health_check.failure")->value());
+
+  EXPECT_TRUE(compareDiscoveryRequest(Config::TypeUrl::get().Cluster, "55", {}, {}, {}));
+  sendDiscoveryResponse<envoy::config::cluster::v3::Cluster>(Config::TypeUrl::get().Cluster, {},
+                                                             {}, {clusters_[cluster_idx].name_},
+                                                             "56");
+  test_server_->waitForCounterGe("cluster_manager.cluster_removed", 1);
+}
+
+// Tests that timers of a health checker which runs on a health check thread fire.
+TEST_P(TcpHealthCheckIntegrationTest, SingleEndpointTimeoutTcpOffloaded) {
+  const uint32_t cluster_idx = 0;
+  initialize();
+  initTcpHealthCheck(cluster_idx, 1);
+
+  // Increase time until timeout (30s).
+  timeSystem().advanceTimeWait(std::chrono::seconds(30));
+
+  test_server_->waitForCounterGe("cluster.cluster_1.health_check.failure", 1);
+  EXPECT_EQ(0, test_server_->counter("cluster.cluster_1.health_check.success")->value());
+  EXPECT_EQ(1, test_server_->counter("cluster.cluster_1.health_check.failure")->value());
+}
+
 class GrpcHealthCheckIntegrationTest : public Event::TestUsingSimulatedTime,
                                        public testing::TestWithParam<Network::Address::IpVersion>,
                                        public HealthCheckIntegrationTestBase {
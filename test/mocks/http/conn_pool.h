@@ -14,6 +14,7 @@ namespace Http {
 namespace ConnectionPool {
 
 class MockCallbacks : public Callbacks {
+public:
   MOCK_METHOD(void, onPoolFailure,
               (PoolFailureReason reason, absl::string_view transport_failure_reason,
                Upstream::HostDescriptionConstSharedPtr host));
@@ -26,6 +26,7 @@ public:
   MOCK_METHOD(Network::TransportSocketOptionsConstSharedPtr, upstreamTransportSocketOptions, (),
               (const));
   MOCK_METHOD(absl::optional<OverrideHost>, overrideHostToSelect, (), (const));
+  MOCK_METHOD(void, setResponseTimeObserver, (ResponseTimeObserverSharedPtr));
 
 private:
   HealthyAndDegradedLoad priority_load_;
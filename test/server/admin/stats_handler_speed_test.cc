@@ -47,6 +47,7 @@ public:
     ClusterInfo(FastMockCluster& parent) : parent_(parent) {}
 
     bool perEndpointStatsEnabled() const override { return parent_.cm_.per_endpoint_enabled_; }
+    bool shardedEndpointRequestCountsEnabled() const override { return false; }
     const std::string& observabilityName() const override { return parent_.name_; }
     Stats::Scope& statsScope() const override { return parent_.scope_; }
 
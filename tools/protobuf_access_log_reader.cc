@@ -0,0 +1,51 @@
+/**
+ * Utility to dump a file written by the file access log's protobuf_format as one JSON
+ * HTTPAccessLogEntry per line.
+ *
+ * Usage:
+ *
+ * protobuf_access_log_reader <access log path>
+ */
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "envoy/data/accesslog/v3/accesslog.pb.h"
+
+#include "source/common/protobuf/utility.h"
+#include "source/extensions/access_loggers/file/protobuf_file_access_log_impl.h"
+
+// NOLINT(namespace-envoy)
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <access log path>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ifstream input(argv[1], std::ios::binary);
+  if (!input) {
+    std::cerr << "Unable to open " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::stringstream contents;
+  contents << input.rdbuf();
+  const std::string data = contents.str();
+
+  absl::string_view remaining = data;
+  envoy::data::accesslog::v3::HTTPAccessLogEntry entry;
+  uint64_t records = 0;
+  while (!remaining.empty()) {
+    const absl::Status status =
+        Envoy::Extensions::AccessLoggers::File::DelimitedProtobufUtil::parseNext(remaining, entry);
+    if (!status.ok()) {
+      // A log that is still being written may end with a partial record.
+      std::cerr << "Stopped after " << records << " records at offset "
+                << data.size() - remaining.size() << ": " << status.message() << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << Envoy::MessageUtil::getJsonStringFromMessageOrError(entry) << std::endl;
+    ++records;
+  }
+  return EXIT_SUCCESS;
+}